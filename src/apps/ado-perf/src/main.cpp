@@ -17,6 +17,7 @@ struct options {
   std::string poolname;
   std::string blastkey;
   std::uint16_t port;
+  std::uint16_t compare_port;
   bool        async;
   bool        pause;
   std::string test;
@@ -27,8 +28,13 @@ struct options {
 
 
 
+struct throughput_result {
+  double put_ado_rate; /* invoke_put_ado per second */
+  double invoke_rate;  /* invoke_ado per second */
+};
+
 component::Itf_ref<component::IMCAS> init(const std::string& server_hostname, std::uint16_t port);
-void do_throughput_work(component::IMCAS* mcas);
+throughput_result do_throughput_work(component::IMCAS* mcas, const std::string& poolname);
 void do_blast_work(component::IMCAS* mcas, const std::string& blastkey, unsigned core = 0);
 
 
@@ -50,6 +56,7 @@ int main(int argc, char* argv[])
       ("threads", po::value<unsigned>()->default_value(0), "Threads")
       ("poolname", po::value<std::string>()->default_value("adoperf_pool_default"), "Pool name")
       ("port", po::value<std::uint16_t>()->default_value(0), "Server port. Default 0 (mapped to 11911 for verbs, 11921 for sockets)")
+      ("compare-port", po::value<std::uint16_t>()->default_value(0), "Port of a second shard, configured with ado_in_process, to compare against the shard at --port (single-threaded throughput test only)")
       ("debug", po::value<unsigned>()->default_value(0), "Debug level")
       ("async", "Use asynchronous invocation")
       ("pause", "Pause after data set up")
@@ -78,6 +85,7 @@ int main(int argc, char* argv[])
     g_options.server      = vm["server"].as<std::string>();
     g_options.device      = vm["device"].as<std::string>();
     g_options.port        = vm["port"].as<std::uint16_t>();
+    g_options.compare_port = vm["compare-port"].as<std::uint16_t>();
     g_options.debug_level = vm["debug"].as<unsigned>();
     g_options.async       = vm.count("async");
     g_options.pause       = vm.count("pause");
@@ -91,10 +99,25 @@ int main(int argc, char* argv[])
       PLOG("Using single-threaded process ..");
       auto mcasptr = init(g_options.server, g_options.port);
       
-      if(g_options.blastkey.empty())
-        do_throughput_work(&*mcasptr);
-      else
+      if(!g_options.blastkey.empty())
         do_blast_work(&*mcasptr, g_options.blastkey);
+      else if(g_options.compare_port == 0)
+        do_throughput_work(&*mcasptr, g_options.poolname);
+      else {
+        /* same work against an ADO process, then against in-process plugins */
+        PMAJOR("ADO process shard (port %u)", g_options.port);
+        auto process = do_throughput_work(&*mcasptr, g_options.poolname);
+
+        PMAJOR("In-process ADO shard (port %u)", g_options.compare_port);
+        auto mcas_inprocess = init(g_options.server, g_options.compare_port);
+        auto inprocess = do_throughput_work(&*mcas_inprocess, g_options.poolname + "-inprocess");
+
+        PINF("%-16s %14s %14s %8s", "", "process /sec", "in-proc /sec", "speedup");
+        PINF("%-16s %14.0f %14.0f %7.2fx", "invoke_put_ado", process.put_ado_rate, inprocess.put_ado_rate,
+             inprocess.put_ado_rate / process.put_ado_rate);
+        PINF("%-16s %14.0f %14.0f %7.2fx", "invoke_ado", process.invoke_rate, inprocess.invoke_rate,
+             inprocess.invoke_rate / process.invoke_rate);
+      }
     }
     else {
       PLOG("Using tasklet ..");
@@ -132,7 +155,7 @@ public:
     PMAJOR("Tasklet: starting work on core %u", core);
 
     if(g_options.blastkey.empty())
-      do_throughput_work(&*_mcas);
+      do_throughput_work(&*_mcas, g_options.poolname);
     else
       do_blast_work(&*_mcas, g_options.blastkey, core);
 
@@ -147,9 +170,8 @@ private:
   component::Itf_ref<component::IMCAS> _mcas;
 };
 
-component::Itf_ref<component::IMCAS> init(const std::string&, // server_hostname
-                                          std::uint16_t // port
-)
+component::Itf_ref<component::IMCAS> init(const std::string& server_hostname,
+                                          std::uint16_t port)
 {
   using namespace component;
 
@@ -159,7 +181,7 @@ component::Itf_ref<component::IMCAS> init(const std::string&, // server_hostname
   if (!fact) throw Logic_exception("unable to create MCAS factory");
 
   std::stringstream url;
-  url << g_options.server << ":" << g_options.port;
+  url << server_hostname << ":" << port;
 
   auto mcas = make_itf_ref(fact->mcas_create(g_options.debug_level, g_options.patience, "None", url.str(), g_options.device));
 
@@ -220,11 +242,11 @@ void do_blast_work(component::IMCAS* mcas, const std::string& blastkey, unsigned
   mcas->close_pool(pool);
 }
 
-void do_throughput_work(component::IMCAS* mcas)
+throughput_result do_throughput_work(component::IMCAS* mcas, const std::string& poolname)
 {
   using namespace component;
 
-  const std::string poolname = g_options.poolname;
+  throughput_result result{};
 
   PMAJOR("Creating pool (%s)...", poolname.c_str());
   auto pool = mcas->create_pool(poolname, GB(1), 0, /* flags */
@@ -277,6 +299,7 @@ void do_throughput_work(component::IMCAS* mcas)
   auto secs = std::chrono::duration<double>(clock::now() - start_time).count();
 
   double per_sec = double(iterations) / secs;
+  result.put_ado_rate = per_sec;
   PINF("Synchronous ADO invoke_put_ado RTT");
   PINF("Time: %.2f sec", secs);
   PINF("Rate: %.0f /sec", per_sec);
@@ -299,6 +322,7 @@ void do_throughput_work(component::IMCAS* mcas)
 
   secs = std::chrono::duration<double>(clock::now() - start_time).count();
   per_sec = double(iterations) / secs;
+  result.invoke_rate = per_sec;
 
   PINF("Synchronous ADO invoke_ado RTT");
   PINF("Time: %.2f sec", secs);
@@ -330,4 +354,5 @@ void do_throughput_work(component::IMCAS* mcas)
   }
 
   //mcas->delete_pool(pool);
+  return result;
 }
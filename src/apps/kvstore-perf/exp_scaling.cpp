@@ -0,0 +1,150 @@
+#include "exp_scaling.h"
+
+#include "data.h"
+#include "get_vector_from_string.h"
+#include "program_options.h"
+#include "task.h"
+
+#include <algorithm>
+#include <vector>
+
+unsigned ExperimentScaling::_thread_count;
+unsigned long ExperimentScaling::_iops;
+std::mutex ExperimentScaling::_iops_lock;
+
+ExperimentScaling::ExperimentScaling(const ProgramOptions &options)
+  : Experiment("scaling", options)
+  , _i(0)
+  , _ops(0)
+  , _op_limit(options.elements)
+  , _start_time()
+  , _rand_engine()
+  , _rand_pct(0, 99)
+  , _rd_pct(options.read_pct)
+{
+}
+
+std::string ExperimentScaling::local_pool_name(unsigned /* core_index */) const
+{
+  /* one pool for all workers */
+  return Experiment::local_pool_name(0);
+}
+
+/*
+ * Each worker writes its share of the keys before the round starts, so that
+ * every key is present when the timed operations begin.
+ */
+void ExperimentScaling::initialize_custom(unsigned core)
+{
+  const auto core_index = _get_core_index(core);
+  const auto element_count = pool_num_objects();
+  const auto first = element_count * core_index / _thread_count;
+  const auto last = element_count * (core_index + 1) / _thread_count;
+
+  for ( auto i = first; i != last; ++i )
+  {
+    const KV_pair &data = g_data->_data[i];
+    auto rc = store()->put(pool(), data.key, data.value, data.value_len);
+    if ( rc != S_OK )
+    {
+      auto e = "scaling: put of initial element " + std::to_string(i) + " returned " + std::to_string(rc);
+      PERR("[%u] %s.", core, e.c_str());
+      throw std::runtime_error(e);
+    }
+  }
+
+  /* start each worker at a different key */
+  _i = first;
+}
+
+/*
+ * A unit of work is a get (read_pct percent of the time) or a put of an
+ * existing key.
+ */
+bool ExperimentScaling::do_work(unsigned core)
+{
+  if ( _first_iter )
+  {
+    wait_for_delayed_start(core);
+    _start_time = std::chrono::high_resolution_clock::now();
+    if ( _duration_directed )
+    {
+      _end_time_directed = _start_time + *_duration_directed;
+    }
+    _first_iter = false;
+  }
+
+  const KV_pair &data = g_data->_data[_i];
+  if ( _rand_pct(_rand_engine) < _rd_pct )
+  {
+    void * pval = nullptr;
+    size_t pval_len;
+    if ( store()->get(pool(), data.key, pval, pval_len) == S_OK )
+    {
+      store()->free_memory(pval);
+    }
+  }
+  else
+  {
+    auto rc = store()->put(pool(), data.key, data.value, data.value_len);
+    if ( rc != S_OK )
+    {
+      auto e = "scaling: put returned " + std::to_string(rc);
+      PERR("[%u] %s.", core, e.c_str());
+      throw std::runtime_error(e);
+    }
+  }
+
+  ++_ops;
+  _i = (_i + 1) % pool_num_objects();
+
+  return
+    _end_time_directed
+    ? std::chrono::high_resolution_clock::now() < *_end_time_directed
+    : _ops != _op_limit
+    ;
+}
+
+void ExperimentScaling::cleanup_custom(unsigned core)
+{
+  const auto secs = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - _start_time).count();
+  const auto iops = static_cast<unsigned long>(double(_ops) / secs);
+  PLOG("[%u] scaling: %zu ops in %g secs, IOps %lu", core, _ops, secs, iops);
+
+  std::lock_guard<std::mutex> g(_iops_lock);
+  _iops += iops;
+}
+
+void ExperimentScaling::summarize()
+{
+  PMAJOR("scaling: threads %u total IOPS: %lu", _thread_count, _iops);
+}
+
+void ExperimentScaling::run(cpu_mask_t, const ProgramOptions &options)
+{
+  const auto cores = get_vector_from_string<unsigned>(options.cores);
+
+  std::vector<unsigned> counts;
+  for ( unsigned n = 1; n < cores.size(); n *= 2 )
+  {
+    counts.push_back(n);
+  }
+  counts.push_back(unsigned(cores.size()));
+
+  for ( auto n : counts )
+  {
+    cpu_mask_t cpus;
+    for ( unsigned i = 0; i != n; ++i )
+    {
+      cpus.add_core(cores[i]);
+    }
+
+    _thread_count = n;
+    _iops = 0;
+    {
+      common::Per_core_tasking<ExperimentScaling, ProgramOptions> exp(cpus, options, options.pin);
+      exp.wait_for_all();
+    }
+    summarize();
+  }
+}
@@ -0,0 +1,46 @@
+#ifndef __EXP_SCALING_H__
+#define __EXP_SCALING_H__
+
+#include "experiment.h"
+
+#include <common/cpu.h> /* cpu_mask_t */
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <random>
+#include <string>
+
+/*
+ * Thread scaling: all workers share one pool, and the experiment is repeated
+ * with 1, 2, 4, ... workers, up to the number of cores given, reporting the
+ * aggregate IOPS of each round. Meaningful for components which share a pool
+ * among the threads of a process (mapstore) or among clients (mcas).
+ */
+class ExperimentScaling : public Experiment
+{
+  std::size_t _i;
+  std::size_t _ops;
+  std::size_t _op_limit;
+  std::chrono::high_resolution_clock::time_point _start_time;
+  std::default_random_engine _rand_engine;
+  std::uniform_int_distribution<unsigned> _rand_pct;
+  unsigned _rd_pct;
+
+  static unsigned _thread_count;
+  static unsigned long _iops;
+  static std::mutex _iops_lock;
+
+public:
+  ExperimentScaling(const ProgramOptions &options);
+  std::string local_pool_name(unsigned core_index) const override;
+  void initialize_custom(unsigned core) override;
+  bool do_work(unsigned core) override;
+  void cleanup_custom(unsigned core) override;
+  static void summarize();
+
+  /* run the rounds, on increasing prefixes of cpus */
+  static void run(cpu_mask_t cpus, const ProgramOptions &options);
+};
+
+#endif // __EXP_SCALING_H__
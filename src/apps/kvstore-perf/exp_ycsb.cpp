@@ -0,0 +1,316 @@
+#include "exp_ycsb.h"
+
+#include "data.h"
+#include "program_options.h"
+
+#include <algorithm>
+#include <cstring> /* memcpy */
+#include <stdexcept>
+#include <thread>
+
+unsigned long ExperimentYcsb::_iops;
+std::mutex ExperimentYcsb::_iops_lock;
+
+namespace
+{
+  bool workload_inserts(const ExperimentYcsb::op_mix &m) { return m.insert != 0; }
+}
+
+ExperimentYcsb::ExperimentYcsb(const ProgramOptions &options)
+  : Experiment("ycsb", options)
+  , _workload(options.workload ? *options.workload : "")
+  , _mix(workload_mix(_workload, options.read_pct))
+  , _keys(
+      workload_distribution(options)
+      /* workloads which insert load half the records, leaving room for the inserts */
+      , std::max(std::size_t(1), workload_inserts(_mix) ? options.elements / 2 : options.elements)
+      , options.zipf_theta
+      , options.hotspot_set_fraction
+      , options.hotspot_op_fraction
+    )
+  , _rnd{}
+  , _rand_pct(0, 99)
+  , _rand_scan(1, options.scan_length)
+  , _record_count(_keys.item_count())
+  , _ops(0)
+  , _op_limit(options.elements)
+  , _scanned(0)
+  , _inserts_exhausted(false)
+  , _target_rate(options.target_rate)
+  , _start_time()
+  , _latencies()
+  , _latency_stats()
+  , _rmw_buffer()
+{
+}
+
+/* The YCSB core workloads. Without a named workload, reads are read_pct
+ * percent of operations and the remainder are updates.
+ */
+auto ExperimentYcsb::workload_mix(const std::string &workload, unsigned read_pct) -> op_mix
+{
+  /*                             read update insert scan rmw */
+  if ( workload.empty() ) { return { read_pct, 100 - read_pct, 0, 0, 0 }; }
+  if ( workload == "A" ) { return { 50, 50, 0, 0, 0 }; }
+  if ( workload == "B" ) { return { 95, 5, 0, 0, 0 }; }
+  if ( workload == "C" ) { return { 100, 0, 0, 0, 0 }; }
+  if ( workload == "D" ) { return { 95, 0, 5, 0, 0 }; }
+  if ( workload == "E" ) { return { 0, 0, 5, 95, 0 }; }
+  if ( workload == "F" ) { return { 50, 0, 0, 0, 50 }; }
+  auto e = "ycsb: unknown workload '" + workload + "' (expected A through F)";
+  PERR("%s.", e.c_str());
+  throw std::domain_error(e);
+}
+
+KeyDistribution::kind ExperimentYcsb::workload_distribution(const ProgramOptions &options)
+{
+  if ( options.key_distribution )
+  {
+    return KeyDistribution::parse(*options.key_distribution);
+  }
+  if ( ! options.workload )
+  {
+    return KeyDistribution::kind::uniform;
+  }
+  return *options.workload == "D" ? KeyDistribution::kind::latest : KeyDistribution::kind::zipfian;
+}
+
+void ExperimentYcsb::initialize_custom(unsigned core)
+{
+  _latency_stats = BinStatistics(bin_count(), bin_threshold_min(), bin_threshold_max());
+  _latencies.reserve(_op_limit);
+
+  /* load phase */
+  for ( std::size_t i = 0; i != _record_count; ++i )
+  {
+    const KV_pair &data = g_data->_data[i];
+    auto rc = store()->put(pool(), data.key, data.value, data.value_len);
+    if ( rc != S_OK )
+    {
+      auto e = "ycsb: load put of element " + std::to_string(i) + " returned " + std::to_string(rc);
+      PERR("[%u] %s.", core, e.c_str());
+      throw std::runtime_error(e);
+    }
+  }
+}
+
+void ExperimentYcsb::read(std::size_t i)
+{
+  void * pval = nullptr;
+  size_t pval_len;
+  auto rc = store()->get(pool(), g_data->key_as_string(i), pval, pval_len);
+  if ( rc != S_OK )
+  {
+    throw std::runtime_error("ycsb: get returned " + std::to_string(rc));
+  }
+  store()->free_memory(pval);
+}
+
+void ExperimentYcsb::update(std::size_t i)
+{
+  const KV_pair &data = g_data->_data[i];
+  auto rc = store()->put(pool(), data.key, data.value, data.value_len);
+  if ( rc != S_OK )
+  {
+    throw std::runtime_error("ycsb: put returned " + std::to_string(rc));
+  }
+}
+
+void ExperimentYcsb::insert(unsigned core)
+{
+  if ( _record_count == pool_num_objects() )
+  {
+    /* every element is present: an "insert" can only be an update */
+    if ( ! _inserts_exhausted )
+    {
+      _inserts_exhausted = true;
+      PWRN("[%u] ycsb: all %zu elements inserted; further inserts are updates", core, _record_count);
+    }
+    update(_keys.next(_rnd));
+    return;
+  }
+  update(_record_count);
+  ++_record_count;
+  _keys.set_item_count(_record_count);
+}
+
+/* kvstore has no ordered scan; a scan reads a run of consecutive records */
+void ExperimentYcsb::scan(std::size_t i)
+{
+  const auto len = _rand_scan(_rnd);
+  for ( unsigned j = 0; j != len; ++j )
+  {
+    read((i + j) % _record_count);
+  }
+  _scanned += len;
+}
+
+void ExperimentYcsb::read_modify_write(std::size_t i)
+{
+  const std::string &key = g_data->key_as_string(i);
+  void * pval = nullptr;
+  size_t pval_len;
+  auto rc = store()->get(pool(), key, pval, pval_len);
+  if ( rc != S_OK )
+  {
+    throw std::runtime_error("ycsb: get returned " + std::to_string(rc));
+  }
+  _rmw_buffer.resize(pval_len);
+  std::memcpy(_rmw_buffer.data(), pval, pval_len);
+  store()->free_memory(pval);
+  ++_rmw_buffer[0];
+  rc = store()->put(pool(), key, _rmw_buffer.data(), _rmw_buffer.size());
+  if ( rc != S_OK )
+  {
+    throw std::runtime_error("ycsb: put returned " + std::to_string(rc));
+  }
+}
+
+bool ExperimentYcsb::do_work(unsigned core)
+{
+  if ( _first_iter )
+  {
+    wait_for_delayed_start(core);
+    PLOG("[%u] Starting ycsb experiment (workload %s, read %u update %u insert %u scan %u rmw %u, %s keys, %s)..."
+      , core
+      , _workload.empty() ? "custom" : _workload.c_str()
+      , _mix.read, _mix.update, _mix.insert, _mix.scan, _mix.read_modify_write
+      , KeyDistribution::name(_keys.get_kind())
+      , _target_rate == 0.0 ? "closed loop" : ("open loop at " + std::to_string(_target_rate) + " op/s").c_str()
+    );
+    _start_time = hr_clock::now();
+    if ( _duration_directed )
+    {
+      _end_time_directed = _start_time + *_duration_directed;
+    }
+    _first_iter = false;
+  }
+
+  /* open loop: the request is due at a fixed offset from the start, however
+   * late the previous request completed
+   */
+  auto intended = hr_clock::now();
+  if ( _target_rate != 0.0 )
+  {
+    intended = _start_time + std::chrono::duration_cast<hr_clock::duration>(std::chrono::duration<double>(double(_ops) / _target_rate));
+    auto now = hr_clock::now();
+    if ( now < intended )
+    {
+      if ( std::chrono::microseconds(100) < intended - now )
+      {
+        std::this_thread::sleep_until(intended - std::chrono::microseconds(50));
+      }
+      while ( hr_clock::now() < intended ) {}
+    }
+  }
+
+  try
+  {
+    auto pct = _rand_pct(_rnd);
+    if ( pct < _mix.read )
+    {
+      read(_keys.next(_rnd));
+    }
+    else if ( pct < _mix.read + _mix.update )
+    {
+      update(_keys.next(_rnd));
+    }
+    else if ( pct < _mix.read + _mix.update + _mix.insert )
+    {
+      insert(core);
+    }
+    else if ( pct < _mix.read + _mix.update + _mix.insert + _mix.scan )
+    {
+      scan(_keys.next(_rnd));
+    }
+    else
+    {
+      read_modify_write(_keys.next(_rnd));
+    }
+  }
+  catch ( const std::exception &e )
+  {
+    PERR("[%u] %s. Ending experiment.", core, e.what());
+    throw;
+  }
+
+  const auto latency = std::chrono::duration<double>(hr_clock::now() - intended).count();
+  _latency_stats.update(latency);
+  _latencies.push_back(latency);
+  ++_ops;
+
+  return
+    _end_time_directed
+    ? hr_clock::now() < *_end_time_directed
+    : _ops != _op_limit
+    ;
+}
+
+double ExperimentYcsb::percentile(const std::vector<double> &sorted, double p)
+{
+  if ( sorted.empty() )
+  {
+    return 0.0;
+  }
+  auto i = std::size_t(p / 100.0 * double(sorted.size() - 1) + 0.5);
+  return sorted[std::min(i, sorted.size() - 1)];
+}
+
+void ExperimentYcsb::cleanup_custom(unsigned core)
+{
+  const auto secs = std::chrono::duration<double>(hr_clock::now() - _start_time).count();
+  const auto iops = double(_ops) / secs;
+  std::sort(_latencies.begin(), _latencies.end());
+  const auto p50 = percentile(_latencies, 50.0);
+  const auto p90 = percentile(_latencies, 90.0);
+  const auto p99 = percentile(_latencies, 99.0);
+  const auto p999 = percentile(_latencies, 99.9);
+  const auto max = _latencies.empty() ? 0.0 : _latencies.back();
+
+  PLOG("[%u] ycsb: %zu ops (%zu records scanned) in %g secs, IOps %g", core, _ops, _scanned, secs, iops);
+  PLOG("[%u] ycsb: latency (s) p50 %g p90 %g p99 %g p99.9 %g max %g", core, p50, p90, p99, p999, max);
+  if ( _target_rate != 0.0 && iops < _target_rate * 0.99 )
+  {
+    PWRN("[%u] ycsb: achieved %g op/s, below target rate %g; latencies include queueing", core, iops, _target_rate);
+  }
+  _update_aggregate_iops(iops);
+
+  {
+    std::lock_guard<std::mutex> g(_iops_lock);
+    _iops += static_cast<unsigned long>(iops);
+  }
+
+  if ( is_json_reporting() )
+  {
+    std::lock_guard<std::mutex> g(g_write_lock);
+
+    rapidjson::Document document = _get_report_document();
+
+    rapidjson::Value percentiles(rapidjson::kObjectType);
+    percentiles
+      .AddMember("p50", p50, document.GetAllocator())
+      .AddMember("p90", p90, document.GetAllocator())
+      .AddMember("p99", p99, document.GetAllocator())
+      .AddMember("p99.9", p999, document.GetAllocator())
+      .AddMember("max", max, document.GetAllocator())
+      ;
+
+    rapidjson::Value experiment_object(rapidjson::kObjectType);
+    experiment_object
+      .AddMember("workload", rapidjson::Value(_workload.empty() ? "custom" : _workload.c_str(), document.GetAllocator()), document.GetAllocator())
+      .AddMember("key_distribution", rapidjson::StringRef(KeyDistribution::name(_keys.get_kind())), document.GetAllocator())
+      .AddMember("target_rate", _target_rate, document.GetAllocator())
+      .AddMember("IOPS", iops, document.GetAllocator())
+      .AddMember("latency", _add_statistics_to_report(_latency_stats, document), document.GetAllocator())
+      .AddMember("latency_percentiles", percentiles, document.GetAllocator())
+      ;
+
+    _report_document_save(document, core, experiment_object);
+    _print_highest_count_bin(_latency_stats, core);
+  }
+}
+
+void ExperimentYcsb::summarize()
+{
+  PMAJOR("ycsb: total IOPS: %lu", _iops);
+}
@@ -0,0 +1,80 @@
+#ifndef __EXP_YCSB_H__
+#define __EXP_YCSB_H__
+
+#include "experiment.h"
+
+#include "key_distribution.h"
+#include "statistics.h"
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+/*
+ * YCSB-style workloads: a mix of reads, updates, inserts, scans and
+ * read-modify-writes over keys chosen from a skewed distribution.
+ *
+ * Closed loop (the default), each worker issues its next request when the
+ * previous one completes. Open loop (--target_rate), requests are scheduled
+ * at a fixed rate and the latency of each is measured from its intended send
+ * time rather than from when it was actually sent, so that a stall in the
+ * store is charged to every request which should have been sent during the
+ * stall (correction for "coordinated omission").
+ */
+class ExperimentYcsb : public Experiment
+{
+public:
+  struct op_mix
+  {
+    unsigned read;
+    unsigned update;
+    unsigned insert;
+    unsigned scan;
+    unsigned read_modify_write;
+  };
+
+private:
+  using hr_clock = std::chrono::high_resolution_clock;
+
+  std::string _workload;
+  op_mix _mix;
+  KeyDistribution _keys;
+  std::mt19937_64 _rnd;
+  std::uniform_int_distribution<unsigned> _rand_pct;
+  std::uniform_int_distribution<unsigned> _rand_scan;
+  std::size_t _record_count;
+  std::size_t _ops;
+  std::size_t _op_limit;
+  std::size_t _scanned;
+  bool _inserts_exhausted;
+  double _target_rate;
+  hr_clock::time_point _start_time;
+  std::vector<double> _latencies;
+  BinStatistics _latency_stats;
+  std::vector<char> _rmw_buffer;
+
+  static unsigned long _iops;
+  static std::mutex _iops_lock;
+
+  static op_mix workload_mix(const std::string &workload, unsigned read_pct);
+  static KeyDistribution::kind workload_distribution(const ProgramOptions &options);
+  static double percentile(const std::vector<double> &sorted, double p);
+
+  void read(std::size_t i);
+  void update(std::size_t i);
+  void insert(unsigned core);
+  void scan(std::size_t i);
+  void read_modify_write(std::size_t i);
+
+public:
+  ExperimentYcsb(const ProgramOptions &options);
+  void initialize_custom(unsigned core) override;
+  bool do_work(unsigned core) override;
+  void cleanup_custom(unsigned core) override;
+  static void summarize();
+};
+
+#endif // __EXP_YCSB_H__
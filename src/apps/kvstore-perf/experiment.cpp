@@ -413,7 +413,7 @@ try
 
   // initialize experiment
   auto core_index = _get_core_index(core);
-  std::string poolname = _pool_name + "." + std::to_string(core_index);
+  std::string poolname = local_pool_name(core_index);
   _pool_name_local = std::string(poolname);
   auto path = _pool_path + poolname;
 
@@ -533,6 +533,11 @@ catch ( ... )
   throw;
 }
 
+std::string Experiment::local_pool_name(unsigned core_index) const
+{
+  return _pool_name + "." + std::to_string(core_index);
+}
+
 // if experiment should be delayed, stop here and wait. Otherwise, start immediately
 void Experiment::wait_for_delayed_start(unsigned core)
 {
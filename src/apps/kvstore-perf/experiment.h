@@ -128,6 +128,9 @@ public:
 
   void initialize(unsigned core) override;
 
+  /* name of the pool for the worker with index core_index: by default, a pool per worker */
+  virtual std::string local_pool_name(unsigned core_index) const;
+
   // if experiment should be delayed, stop here and wait. Otherwise, start immediately
   void wait_for_delayed_start(unsigned core);
 
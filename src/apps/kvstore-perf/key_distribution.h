@@ -0,0 +1,166 @@
+#ifndef __KEY_DISTRIBUTION_H__
+#define __KEY_DISTRIBUTION_H__
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+/*
+ * Choice of record index in [0, item_count), after the YCSB request
+ * distributions:
+ *
+ *  uniform  - every record equally likely
+ *  zipfian  - record i chosen with probability proportional to 1/(i+1)^theta
+ *  latest   - zipfian, counted back from the most recently inserted record
+ *  hotspot  - hot_op_fraction of choices fall uniformly on the first
+ *             hot_set_fraction of the records, the rest uniformly on the others
+ *
+ * The zipfian generator is that of Gray et al., "Quickly generating
+ * billion-record synthetic databases" (SIGMOD 1994), as used by YCSB. Its
+ * constant zeta(n) is extended incrementally as the item count grows.
+ *
+ * Records in kvstore-perf have random keys, so record order carries no key
+ * locality and the popular records need not be scrambled.
+ */
+class KeyDistribution
+{
+public:
+  enum class kind { uniform, zipfian, latest, hotspot };
+
+  static kind parse(const std::string &name)
+  {
+    if ( name == "uniform" ) { return kind::uniform; }
+    if ( name == "zipfian" ) { return kind::zipfian; }
+    if ( name == "latest" ) { return kind::latest; }
+    if ( name == "hotspot" ) { return kind::hotspot; }
+    throw std::domain_error("unknown key distribution '" + name + "' (expected uniform, zipfian, latest or hotspot)");
+  }
+
+  static const char *name(kind k)
+  {
+    switch ( k )
+    {
+    case kind::uniform: return "uniform";
+    case kind::zipfian: return "zipfian";
+    case kind::latest: return "latest";
+    case kind::hotspot: return "hotspot";
+    }
+    return "?";
+  }
+
+  KeyDistribution(kind k, std::size_t item_count, double theta, double hot_set_fraction, double hot_op_fraction)
+    : _kind(k)
+    , _item_count(0)
+    , _theta(theta)
+    , _alpha(1.0 / (1.0 - theta))
+    , _zeta2(zeta(0, 2, theta, 0.0))
+    , _zetan(0.0)
+    , _eta(0.0)
+    , _hot_set_fraction(hot_set_fraction)
+    , _hot_op_fraction(hot_op_fraction)
+    , _u01(0.0, 1.0)
+  {
+    if ( ! ( 0.0 < theta && theta < 1.0 ) )
+    {
+      throw std::domain_error("zipfian theta " + std::to_string(theta) + " not in (0, 1)");
+    }
+    if ( ! ( 0.0 <= hot_set_fraction && hot_set_fraction <= 1.0 && 0.0 <= hot_op_fraction && hot_op_fraction <= 1.0 ) )
+    {
+      throw std::domain_error("hotspot fractions must be in [0, 1]");
+    }
+    set_item_count(item_count);
+  }
+
+  kind get_kind() const { return _kind; }
+  std::size_t item_count() const { return _item_count; }
+
+  /* Change the number of records, e.g. after inserts. Growth is cheap: only
+   * the new terms of zeta(n) are computed.
+   */
+  void set_item_count(std::size_t n)
+  {
+    if ( n == 0 )
+    {
+      throw std::domain_error("key distribution over no items");
+    }
+    if ( _kind == kind::zipfian || _kind == kind::latest )
+    {
+      _zetan =
+        _item_count < n
+        ? zeta(_item_count, n, _theta, _zetan)
+        : zeta(0, n, _theta, 0.0)
+        ;
+      _eta = (1.0 - std::pow(2.0 / double(n), 1.0 - _theta)) / (1.0 - _zeta2 / _zetan);
+    }
+    _item_count = n;
+  }
+
+  template <typename URBG>
+    std::size_t next(URBG &g)
+    {
+      switch ( _kind )
+      {
+      case kind::zipfian:
+        return next_zipfian(g);
+      case kind::latest:
+        return _item_count - 1 - next_zipfian(g);
+      case kind::hotspot:
+        {
+          const auto hot = std::max(std::size_t(1), std::size_t(double(_item_count) * _hot_set_fraction));
+          if ( hot == _item_count || _u01(g) < _hot_op_fraction )
+          {
+            return std::uniform_int_distribution<std::size_t>(0, hot - 1)(g);
+          }
+          return std::uniform_int_distribution<std::size_t>(hot, _item_count - 1)(g);
+        }
+      case kind::uniform:
+        break;
+      }
+      return std::uniform_int_distribution<std::size_t>(0, _item_count - 1)(g);
+    }
+
+private:
+  kind _kind;
+  std::size_t _item_count;
+  double _theta;
+  double _alpha;
+  double _zeta2;
+  double _zetan;
+  double _eta;
+  double _hot_set_fraction;
+  double _hot_op_fraction;
+  std::uniform_real_distribution<double> _u01;
+
+  /* sum of 1/i^theta for i in (from, to], added to initial */
+  static double zeta(std::size_t from, std::size_t to, double theta, double initial)
+  {
+    auto sum = initial;
+    for ( auto i = from; i != to; ++i )
+    {
+      sum += 1.0 / std::pow(double(i + 1), theta);
+    }
+    return sum;
+  }
+
+  template <typename URBG>
+    std::size_t next_zipfian(URBG &g)
+    {
+      const auto u = _u01(g);
+      const auto uz = u * _zetan;
+      if ( uz < 1.0 )
+      {
+        return 0;
+      }
+      if ( uz < 1.0 + std::pow(0.5, _theta) )
+      {
+        return std::min(std::size_t(1), _item_count - 1);
+      }
+      const auto i = std::size_t(double(_item_count) * std::pow(_eta * u - _eta + 1.0, _alpha));
+      return std::min(i, _item_count - 1);
+    }
+};
+
+#endif // __KEY_DISTRIBUTION_H__
@@ -6,8 +6,10 @@
 #include "exp_get_direct.h"
 #include "exp_put.h"
 #include "exp_put_direct.h"
+#include "exp_scaling.h"
 #include "exp_throughput.h"
 #include "exp_update.h"
+#include "exp_ycsb.h"
 #include "get_cpu_mask_from_string.h"
 #include "get_vector_from_string.h"
 #include "program_options.h"
@@ -56,6 +58,8 @@ static const std::vector<test_element> test_vector{
     {"throughput", run_exp<ExperimentThroughput>},
     {"erase", run_exp<ExperimentErase>},
     {"update", run_exp<ExperimentUpdate>},
+    {"scaling", ExperimentScaling::run},
+    {"ycsb", run_exp<ExperimentYcsb>},
 };
 }  // namespace
 
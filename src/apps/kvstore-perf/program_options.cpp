@@ -88,7 +88,14 @@ ProgramOptions::ProgramOptions(const boost::program_options::variables_map &vm_)
     , device_name(vm_.count("device_name") ? vm_["device_name"].as<std::string>() : boost::optional<std::string>())
     , src_addr(vm_.count("src_addr") ? vm_["src_addr"].as<std::string>() : boost::optional<std::string>())
     , pci_addr(vm_.count("pci_addr") ? vm_["pci_addr"].as<std::string>() : boost::optional<std::string>())
-    , random(vm_.count("random")) {
+    , random(vm_.count("random"))
+    , workload(optional_option<std::string>(vm_, "workload"))
+    , key_distribution(optional_option<std::string>(vm_, "key_distribution"))
+    , zipf_theta(vm_["zipf_theta"].as<double>())
+    , hotspot_set_fraction(vm_["hotspot_set_fraction"].as<double>())
+    , hotspot_op_fraction(vm_["hotspot_op_fraction"].as<double>())
+    , scan_length(std::max(1U, vm_["scan_length"].as<unsigned>()))
+    , target_rate(vm_["target_rate"].as<double>()) {
   if ((component_is("pmstore") || component_is("hstore")) && !path) {
     auto e = "component '" + component + "' requires --path argument for persistent memory store";
     throw std::runtime_error(e);
@@ -169,7 +176,7 @@ void ProgramOptions::add_program_options(boost::program_options::options_descrip
         "Insert/erase percentage in throughput test. Default: 0.")
       ("owner", po::value<std::string>()->default_value("owner"), "Owner name for component registration")
       ("server", po::value<std::string>()->default_value("127.0.0.1"), "MCAS server IP address. Default: 127.0.0.1")
-      ("provider", po::value<std::string>(), "Fabric provider (verbs or sockets). Default: first available")
+      ("provider", po::value<std::string>(), "Fabric provider (verbs, sockets, uring or shm). Default: first available")
       ("port", po::value<std::uint16_t>()->default_value(0), "MCAS server port. Default 0 (mapped to 11911 for verbs, 11921 for sockets)")
       ("port_increment", po::value<uint16_t>(), "Port increment every N instances.")
       ("src_addr", po::value<std::string>(), "The IP address of the source port")
@@ -187,5 +194,22 @@ void ProgramOptions::add_program_options(boost::program_options::options_descrip
       ("duration", po::value<unsigned>(), "Throughput test duration, in seconds")
       ("report_interval", po::value<unsigned>()->default_value(5),
         "Throughput test report interval, in seconds. Default: 5")
-      ("random", "Generate random size of value up from 8 bytes to --value_length");
+      ("random", "Generate random size of value up from 8 bytes to --value_length")
+      ("workload", po::value<std::string>(),
+        "YCSB core workload for the ycsb test: A (50% read, 50% update), B (95% read, 5% update), C (100% read), "
+        "D (95% read of latest, 5% insert), E (95% scan, 5% insert), F (50% read, 50% read-modify-write). "
+        "Default: none; reads are --read_pct percent of operations and the rest are updates.")
+      ("key_distribution", po::value<std::string>(),
+        "Key distribution for the ycsb test <uniform|zipfian|latest|hotspot>. "
+        "Default: that of the --workload, or uniform.")
+      ("zipf_theta", po::value<double>()->default_value(0.99), "Skew of the zipfian and latest distributions, in (0, 1). Default: 0.99.")
+      ("hotspot_set_fraction", po::value<double>()->default_value(0.2),
+        "Fraction of keys which are hot in the hotspot distribution. Default: 0.2.")
+      ("hotspot_op_fraction", po::value<double>()->default_value(0.8),
+        "Fraction of operations on hot keys in the hotspot distribution. Default: 0.8.")
+      ("scan_length", po::value<unsigned>()->default_value(100),
+        "Maximum records in a scan (workload E); each scan length is uniform in [1, scan_length]. Default: 100.")
+      ("target_rate", po::value<double>()->default_value(0.0),
+        "Open-loop request rate for the ycsb test, in operations per second per core. Latency is measured from each "
+        "request's intended send time, which corrects for coordinated omission. Default: 0 (closed loop).");
 }
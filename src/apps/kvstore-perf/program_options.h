@@ -52,6 +52,14 @@ class ProgramOptions {
   boost::optional<std::string> src_addr;
   boost::optional<std::string>                           pci_addr;
   bool                                                   random;
+  /* ycsb test */
+  boost::optional<std::string>                           workload;
+  boost::optional<std::string>                           key_distribution;
+  double                                                 zipf_theta;
+  double                                                 hotspot_set_fraction;
+  double                                                 hotspot_op_fraction;
+  unsigned                                               scan_length;
+  double                                                 target_rate;
 
   ProgramOptions(const boost::program_options::variables_map &);
 
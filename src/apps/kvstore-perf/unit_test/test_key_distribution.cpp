@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+
+#include "../key_distribution.h"
+
+#include <cstddef>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+  constexpr std::size_t items = 1000;
+  constexpr unsigned draws = 200000;
+
+  std::vector<unsigned> histogram(KeyDistribution &d)
+  {
+    std::mt19937_64 g{};
+    std::vector<unsigned> h(d.item_count());
+    for ( unsigned i = 0; i != draws; ++i )
+    {
+      auto k = d.next(g);
+      EXPECT_LT(k, d.item_count());
+      if ( k < h.size() )
+      {
+        ++h[k];
+      }
+    }
+    return h;
+  }
+}
+
+TEST(KeyDistributionTest, Parse)
+{
+  ASSERT_EQ(KeyDistribution::parse("uniform"), KeyDistribution::kind::uniform);
+  ASSERT_EQ(KeyDistribution::parse("zipfian"), KeyDistribution::kind::zipfian);
+  ASSERT_EQ(KeyDistribution::parse("latest"), KeyDistribution::kind::latest);
+  ASSERT_EQ(KeyDistribution::parse("hotspot"), KeyDistribution::kind::hotspot);
+  ASSERT_THROW(KeyDistribution::parse("normal"), std::domain_error);
+}
+
+TEST(KeyDistributionTest, BadParameters)
+{
+  ASSERT_THROW(KeyDistribution(KeyDistribution::kind::zipfian, items, 1.0, 0.2, 0.8), std::domain_error);
+  ASSERT_THROW(KeyDistribution(KeyDistribution::kind::hotspot, items, 0.99, 1.5, 0.8), std::domain_error);
+  ASSERT_THROW(KeyDistribution(KeyDistribution::kind::uniform, 0, 0.99, 0.2, 0.8), std::domain_error);
+}
+
+TEST(KeyDistributionTest, Uniform)
+{
+  KeyDistribution d(KeyDistribution::kind::uniform, items, 0.99, 0.2, 0.8);
+  auto h = histogram(d);
+  /* expect draws/items = 200 per item */
+  for ( auto c : h )
+  {
+    ASSERT_LT(100U, c);
+    ASSERT_GT(300U, c);
+  }
+}
+
+TEST(KeyDistributionTest, Zipfian)
+{
+  KeyDistribution d(KeyDistribution::kind::zipfian, items, 0.99, 0.2, 0.8);
+  auto h = histogram(d);
+  /* the most popular item is the first, and about twice as popular as the second */
+  ASSERT_GT(h[0], h[1]);
+  ASSERT_NEAR(double(h[0]) / double(h[1]), 2.0, 0.2);
+  /* the first 10% of items take well over half the draws */
+  unsigned head = 0;
+  for ( std::size_t i = 0; i != items / 10; ++i )
+  {
+    head += h[i];
+  }
+  ASSERT_LT(draws / 2, head);
+}
+
+TEST(KeyDistributionTest, Latest)
+{
+  KeyDistribution d(KeyDistribution::kind::latest, items, 0.99, 0.2, 0.8);
+  auto h = histogram(d);
+  ASSERT_GT(h[items - 1], h[items - 2]);
+  ASSERT_GT(h[items - 1], h[0]);
+
+  /* growth moves the popular item to the newest */
+  d.set_item_count(items + 1);
+  std::mt19937_64 g{};
+  unsigned newest = 0;
+  for ( unsigned i = 0; i != draws; ++i )
+  {
+    auto k = d.next(g);
+    ASSERT_LT(k, items + 1);
+    newest += k == items;
+  }
+  ASSERT_NEAR(double(newest) / draws, double(h[items - 1]) / draws, 0.01);
+}
+
+TEST(KeyDistributionTest, Hotspot)
+{
+  KeyDistribution d(KeyDistribution::kind::hotspot, items, 0.99, 0.2, 0.8);
+  auto h = histogram(d);
+  unsigned hot = 0;
+  for ( std::size_t i = 0; i != items / 5; ++i )
+  {
+    hot += h[i];
+  }
+  ASSERT_NEAR(double(hot) / draws, 0.8, 0.01);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
@@ -292,6 +292,22 @@ void ADO_proxy::free_callback_buffer(void *buffer)
   _ipc->free_ipc_buffer(buffer);
 }
 
+int ADO_proxy::wakeup_fd() const
+{
+  /* the ADO process rings the doorbell after a message it sends while armed */
+  return _ipc->doorbell_fd();
+}
+
+bool ADO_proxy::arm_wakeup()
+{
+  return _ipc->arm_doorbell();
+}
+
+void ADO_proxy::disarm_wakeup()
+{
+  _ipc->disarm_doorbell();
+}
+
 void ADO_proxy::child_exit(int, siginfo_t *, void *)
 {
   ADO_proxy::_exited = 1;
@@ -115,6 +115,12 @@ public:
 
   void free_callback_buffer(void * buffer) override;
 
+  int wakeup_fd() const override;
+
+  bool arm_wakeup() override;
+
+  void disarm_wakeup() override;
+
   bool check_table_ops(const void * buffer,
                        uint64_t &work_request_id,
                        component::ADO_op &op,
@@ -798,6 +798,32 @@ class IADO_proxy : public component::IBase {
    */
   virtual void free_callback_buffer(void* buffer) = 0;
 
+  /**
+   * File descriptor, for a caller which blocks in poll or select, which
+   * becomes readable, between arm_wakeup and disarm_wakeup, when the ADO
+   * posts a work completion or a callback.
+   *
+   * @return File descriptor, or -1 if the proxy cannot signal; the caller
+   * should then poll check_work_completions and recv_callback_buffer
+   * while work is outstanding
+   */
+  virtual int wakeup_fd() const { return -1; }
+
+  /**
+   * Ask the ADO to signal wakeup_fd when it next posts a message. The
+   * ADO does not signal otherwise, so that a caller which never blocks
+   * costs it nothing.
+   *
+   * @return False, and not armed, if a message may be waiting already;
+   * the caller should not block
+   */
+  virtual bool arm_wakeup() { return true; }
+
+  /**
+   * Stop signalling, after the caller wakes, and clear wakeup_fd
+   */
+  virtual void disarm_wakeup() {}
+
   /**
    * Check for table operations (e.g., create_key)
    *
@@ -31,6 +31,12 @@ DECLARE_STATIC_COMPONENT_UUID(any_component, 0xffffffff, 0xffff, 0xffff, 0xffff,
 DECLARE_STATIC_COMPONENT_UUID(net_fabric, 0x8b93a5ae, 0xcf34, 0x4aff, 0x8321, 0x19, 0x08, 0x21, 0xa9, 0x9f, 0xd3);
 DECLARE_STATIC_COMPONENT_UUID(net_fabric_factory, 0xfac3a5ae, 0xcf34, 0x4aff, 0x8321, 0x19, 0x08, 0x21, 0xa9, 0x9f, 0xd3);
 
+/*< uring, IFabric over TCP through io_uring */
+DECLARE_STATIC_COMPONENT_UUID(net_uring_factory, 0xfac7e1a4, 0x5b0d, 0x4c39, 0x9e51, 0x3a, 0x6d, 0x12, 0x88, 0xc4, 0x07);
+
+/*< shm, IFabric through shared memory, for clients on the server host */
+DECLARE_STATIC_COMPONENT_UUID(net_shm_factory, 0xfac5a11e, 0x2c4f, 0x4e7d, 0x8b13, 0x5e, 0x91, 0x0a, 0x4d, 0x37, 0xc2);
+
 /*< hstore, hash based persistent store */
 DECLARE_STATIC_COMPONENT_UUID(hstore, 0x1f1bf8cf, 0xc2eb, 0x4710, 0x9bf1, 0x63, 0xf5, 0xe8, 0x1a, 0xcf, 0xbd);
 DECLARE_STATIC_COMPONENT_UUID(hstore_factory, 0xfacbf8cf, 0xc2eb, 0x4710, 0x9bf1, 0x63, 0xf5, 0xe8, 0x1a, 0xcf, 0xbd);
@@ -43,10 +49,18 @@ DECLARE_STATIC_COMPONENT_UUID(mapstore_factory, 0xfac20985, 0x1253, 0x404d, 0x94
 DECLARE_STATIC_COMPONENT_UUID(rbtreeindex, 0x8a120985, 0x1253, 0x404d, 0x94d7, 0x77, 0x92, 0x75, 0x21, 0xa1, 0x29);
 DECLARE_STATIC_COMPONENT_UUID(rbtreeindex_factory, 0xfac20985, 0x1253, 0x404d, 0x94d7, 0x77, 0x92, 0x75, 0x21, 0xa1, 0x29);
 
+/*< rambtree index*/
+DECLARE_STATIC_COMPONENT_UUID(btreeindex, 0x8a120985, 0x1253, 0x404d, 0x94d7, 0x77, 0x92, 0x75, 0x21, 0xa1, 0x2a);
+DECLARE_STATIC_COMPONENT_UUID(btreeindex_factory, 0xfac20985, 0x1253, 0x404d, 0x94d7, 0x77, 0x92, 0x75, 0x21, 0xa1, 0x2a);
+
 /*< mcas client */
 DECLARE_STATIC_COMPONENT_UUID(mcas_client, 0x2f666078, 0xcb8a, 0x4724, 0xa454, 0xd1, 0xd8, 0x8d, 0xe2, 0xdb, 0x87);
 DECLARE_STATIC_COMPONENT_UUID(mcas_client_factory, 0xfac66078, 0xcb8a, 0x4724, 0xa454, 0xd1, 0xd8, 0x8d, 0xe2, 0xdb, 0x87);
 
+/*< mcas cluster client (consistent-hash sharding over several mcas clients) */
+DECLARE_STATIC_COMPONENT_UUID(mcas_cluster_client, 0x2f666079, 0xcb8a, 0x4724, 0xa454, 0xd1, 0xd8, 0x8d, 0xe2, 0xdb, 0x87);
+DECLARE_STATIC_COMPONENT_UUID(mcas_cluster_client_factory, 0xfac66079, 0xcb8a, 0x4724, 0xa454, 0xd1, 0xd8, 0x8d, 0xe2, 0xdb, 0x87);
+
 /*< ADO manager proxy */
 DECLARE_STATIC_COMPONENT_UUID(ado_manager_proxy, 0x8a120985, 0x1253, 0x404d, 0x94d7, 0x77, 0x92, 0x75, 0x21, 0xa1, 0x91);
 DECLARE_STATIC_COMPONENT_UUID(ado_manager_proxy_factory, 0xfac20985, 0x1253, 0x404d, 0x94d7, 0x77, 0x92, 0x75, 0x21, 0xa1, 0x91);
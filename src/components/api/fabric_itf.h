@@ -224,6 +224,26 @@ class IFabric_op_completer {
    */
   virtual void unblock_completions() = 0;
 
+  /**
+   * Prepare to block, perhaps with other completers, until a completion
+   * arrives: for a caller which waits on several connections at once
+   * with poll or select.
+   *
+   * @param fds Receives the file descriptors which become ready (for
+   * read, write or exception) when a completion may have arrived
+   *
+   * @return false if a completion may already be waiting, or if the
+   * completer cannot be waited on through file descriptors; the caller
+   * should then poll rather than block
+   *
+   * @throw IFabric_runtime_error - ::fi_control fail
+   */
+  virtual bool arm_wait(std::vector<int> &fds)
+  {
+    (void) fds;
+    return false;
+  }
+
   /* Additional TODO:
      - support for completion and event counters
      - support for statistics collection
@@ -333,6 +353,10 @@ class IFabric_connection {
 
   using memory_region_t = IFabric_memory_region *;
 
+  /* register_memory flag, never passed to libfabric: long-lived memory,
+   * such as a pool region, which a same-host provider may let its peer map */
+  static constexpr std::uint64_t MR_FLAG_SHAREABLE = std::uint64_t(1) << 63;
+
   /**
    * Register buffer for RDMA
    *
@@ -345,7 +369,7 @@ class IFabric_connection {
    *            expose these attributes, the only safe strategy is to assume
    * that the key must be unique among registered memory regsions.
    * @param flags Flags e.g., FI_REMOTE_READ|FI_REMOTE_WRITE. Flag definitions
-   * are in <rdma/fabric.h>
+   * are in <rdma/fabric.h>, except for MR_FLAG_SHAREABLE
    *
    * @return Memory region handle
    *
@@ -520,6 +544,22 @@ class IFabric_server_factory : public IFabric_passive_endpoint {
    */
   virtual IFabric_server *get_new_connection() = 0;
 
+  /**
+   * Prepare to block until a new connection may be waiting: for a caller
+   * which waits on several sources at once with poll or select.
+   *
+   * @param fds Receives the file descriptors which become readable when
+   * get_new_connection may return a connection
+   *
+   * @return false if the factory cannot be waited on through file
+   * descriptors; the caller should then poll get_new_connection
+   */
+  virtual bool arm_wait(std::vector<int> &fds)
+  {
+    (void) fds;
+    return false;
+  }
+
   /**
    * Close connection and release any associated resources
    *
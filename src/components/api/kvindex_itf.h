@@ -17,10 +17,12 @@
 #include <api/components.h>
 #include <assert.h>
 #include <common/exceptions.h>
+#include <common/key_matcher.h>
 #include <sys/uio.h> /* iovec */
 
 #include <cstdlib>
 #include <functional>
+#include <memory>
 #include <vector>
 
 namespace component
@@ -43,16 +45,40 @@ class IKVIndex : public component::IBase {
     FIND_TYPE_EXACT  = 0x2, /*< perform exact match comparison on key */
     FIND_TYPE_REGEX  = 0x3, /*< apply as regular expression */
     FIND_TYPE_PREFIX = 0x4, /*< match prefix only */
+    FIND_TYPE_SUBSTRING = 0x5, /*< match expression anywhere in key */
   } find_t;
 
   inline static find_t convert_find_type(int i)
   {
-    static const find_t array[] = {FIND_TYPE_NONE, FIND_TYPE_NEXT, FIND_TYPE_EXACT, FIND_TYPE_REGEX, FIND_TYPE_PREFIX};
+    static const find_t array[] = {FIND_TYPE_NONE, FIND_TYPE_NEXT, FIND_TYPE_EXACT, FIND_TYPE_REGEX, FIND_TYPE_PREFIX, FIND_TYPE_SUBSTRING};
     assert(i > 0);
-    if (i > 4) throw API_exception("out of enum bounds");
+    if (i > 5) throw API_exception("out of enum bounds");
     return array[i];
   }
 
+  /**
+   * Compile a find expression. Throws std::regex_error for a bad regular
+   * expression, API_exception for a bad find type.
+   */
+  static std::unique_ptr<common::Key_matcher> create_matcher(find_t find_type, const std::string& key_expression)
+  {
+    using matcher = common::Key_matcher;
+    switch (find_type) {
+      case FIND_TYPE_NEXT:
+        return std::unique_ptr<matcher>(new matcher(matcher::MATCH_ANY, key_expression));
+      case FIND_TYPE_EXACT:
+        return std::unique_ptr<matcher>(new matcher(matcher::MATCH_EXACT, key_expression));
+      case FIND_TYPE_REGEX:
+        return std::unique_ptr<matcher>(new matcher(matcher::MATCH_REGEX, key_expression));
+      case FIND_TYPE_PREFIX:
+        return std::unique_ptr<matcher>(new matcher(matcher::MATCH_PREFIX, key_expression));
+      case FIND_TYPE_SUBSTRING:
+        return std::unique_ptr<matcher>(new matcher(matcher::MATCH_SUBSTRING, key_expression));
+      default:
+        throw API_exception("bad find type");
+    }
+  }
+
   using offset_t = uint64_t;
 
   /**
@@ -110,6 +136,47 @@ class IKVIndex : public component::IBase {
                         offset_t&          out_matched_position,
                         std::string&       out_matched_key,
                         unsigned           max_comparisons = 0) = 0;
+
+  /**
+   * Perform a key search with a compiled expression. Repeated searches
+   * with one expression (e.g. a search resumed after max_comparisons)
+   * should compile it once, with create_matcher.
+   *
+   * @param matcher Compiled expression
+   * @param begin_position Position from which to start from. Counting from 0.
+   * @param out_matched_position [out] Position of the match, or of the last key compared
+   * @param out_matched_key Matching key result
+   * @param max_comparisons Maximum number of comparisons (0 for no limit)
+   *
+   * @return S_OK on match, E_MAX_REACHED if the comparison limit was reached, E_FAIL if there is no match
+   */
+  virtual status_t find(const common::Key_matcher& matcher,
+                        offset_t                   begin_position,
+                        offset_t&                  out_matched_position,
+                        std::string&               out_matched_key,
+                        unsigned                   max_comparisons = 0)
+  {
+    return E_NOT_IMPL;
+  }
+
+  /**
+   * Visit keys in key order. Unlike find, which is positional, scan
+   * resumes from a key, so a long listing costs one seek per call
+   * rather than one per key.
+   *
+   * @param from Key at which to start; empty to start at the first key
+   * @param inclusive If false, a key equal to from is not visited
+   * @param visit Called with each key in order; return false to stop the scan
+   *
+   * @return S_OK if the end of the index was reached, S_MORE if visit stopped
+   * the scan, E_NOT_IMPL if not supported by the index
+   */
+  virtual status_t scan(const std::string&                            from,
+                        bool                                          inclusive,
+                        const std::function<bool(const std::string&)>& visit)
+  {
+    return E_NOT_IMPL;
+  }
 };
 
 class IKVIndex_factory : public component::IBase {
@@ -25,6 +25,7 @@
 
 #include <cinttypes> /* PRIx64 */
 #include <cstdlib>
+#include <experimental/string_view>
 #include <functional>
 #include <map>
 #include <mutex>
@@ -62,6 +63,7 @@ class IKVStore : public component::IBase {
 
  public:
   using pool_t          = uint64_t;
+  using string_view     = std::experimental::string_view;
   using memory_handle_t = Opaque_memory_region*;
   using key_t           = Opaque_key*;
   using pool_lock_t     = Opaque_lock_handle*;
@@ -291,6 +293,24 @@ class IKVStore : public component::IBase {
     return E_NOT_SUPPORTED;
   }
 
+  /**
+   * Configure a pool. Settings understood by hstore and mapstore:
+   *   AddIndex::Time     maintain a (volatile) index of keys by write time,
+   *                      so that time-constrained map and iteration visit only
+   *                      the keys in the time window
+   *   RemoveIndex::Time  drop the index
+   *
+   * @param pool Pool handle
+   * @param setting Configuration request
+   *
+   * @return S_OK on success, E_POOL_NOT_FOUND, E_BAD_PARAM for an unknown setting.
+   * Components that do not support this return E_NOT_SUPPORTED.
+   */
+  virtual status_t configure_pool(const pool_t pool, const std::string& setting)
+  {
+    return E_NOT_SUPPORTED;
+  }
+
   /**
    * Write or overwrite an object value. If there already exists an
    * object with matching key, then it should be replaced
@@ -368,6 +388,30 @@ class IKVStore : public component::IBase {
                        void*&             out_value, /* release with free_memory() API */
                        size_t&            out_value_len) = 0;
 
+  /**
+   * Copy a (small) object value into client-provided memory, without
+   * locking the value and without persistent side effects. The copy is
+   * validated by a version check on the value, seqlock style: a value
+   * which is being written is reported as E_BUSY, not copied.
+   *
+   * @param pool Pool handle
+   * @param key Object key
+   * @param out_value Client provided buffer for value
+   * @param out_value_len [in] size of value memory in bytes [out] size of value
+   *
+   * @return S_OK, E_KEY_NOT_FOUND, E_INSUFFICIENT_BUFFER if the value
+   * is larger than the buffer (out_value_len is set to the value size),
+   * E_BUSY if the value is being written, E_POOL_NOT_FOUND, or
+   * E_NOT_SUPPORTED
+   */
+  virtual status_t get_optimistic(const pool_t pool,
+                                  string_view  key,
+                                  void*        out_value,
+                                  size_t&      out_value_len)
+  {
+    return E_NOT_SUPPORTED;
+  }
+
   /**
    * Read an object value directly into client-provided memory.
    *
@@ -590,8 +634,8 @@ class IKVStore : public component::IBase {
    * to given time constraints
    *
    * @param pool Pool handle
-   * @param function Functor to apply (not in time order). If
-   *                 functor returns < 0, then map aborts
+   * @param function Functor to apply (not in time order, unless the pool
+   *                 has a time index). If functor returns < 0, then map aborts
    * @param t_begin Time must be after or equal. If set to zero, no constraint.
    * @param t_end Time must be before or equal. If set to zero, no constraint.
    *
@@ -21,6 +21,9 @@
 
 #include <cstdint> /* uint16_t */
 #include <memory>
+#include <string>
+#include <utility> /* pair */
+#include <vector>
 
 #define DECLARE_OPAQUE_TYPE(NAME)               \
   struct Opaque_##NAME {                        \
@@ -105,6 +108,22 @@ public:
     uint64_t op_failed_request_count;
     uint64_t last_op_count_snapshot;
     uint16_t client_count;
+    /* Fields above are those of the original GET_STATS response, which older
+     * clients read; new fields are only ever appended below. A response from
+     * an older server is shorter, and its missing fields read as zero.
+     */
+    uint64_t busy_tick_count;            /* main loop iterations which handled at least one client message */
+    uint64_t tick_msg_count;             /* client messages handled by those iterations */
+    uint64_t tick_msg_max;               /* most client messages handled in one iteration */
+    uint64_t batch_budget_reached_count; /* times a handler's batch budget was exhausted with messages pending */
+    uint64_t op_offload_count;           /* requests executed by shard worker threads */
+    uint64_t mr_cache_hit_count;         /* direct IO registrations served by a registered pool region */
+    uint64_t mr_cache_miss_count;        /* direct IO registrations which registered memory per request */
+    uint64_t idle_block_count;           /* times the shard thread blocked after spinning idle for its budget */
+    uint64_t idle_block_usec;            /* time spent blocked */
+    uint64_t wake_latency_count;         /* blocks ended by a client message */
+    uint64_t wake_latency_ns_total;      /* from the end of those blocks to handling the message */
+    uint64_t wake_latency_ns_max;
 
   public:
     Shard_stats()
@@ -112,10 +131,24 @@ public:
       , op_put_count(0), op_get_count(0), op_put_direct_count(0), op_get_direct_count(0), op_get_twostage_count(0)
       , op_ado_count(0), op_erase_count(0), op_get_direct_offset_count(0)
       , op_failed_request_count(0), last_op_count_snapshot(0), client_count(0)
+      , busy_tick_count(0), tick_msg_count(0), tick_msg_max(0), batch_budget_reached_count(0)
+      , op_offload_count(0), mr_cache_hit_count(0), mr_cache_miss_count(0)
+      , idle_block_count(0), idle_block_usec(0), wake_latency_count(0), wake_latency_ns_total(0), wake_latency_ns_max(0)
     {
     }
   } __attribute__((packed));
 
+  /* server-side latency distribution of one class of operation in one phase of its handling */
+  struct Latency_histogram {
+    std::string op;    /* put, get, put_direct, get_direct, erase, io_other, ado, pool, info */
+    std::string phase; /* queue: receipt to start of handling; store: handling, less response posting; post: posting the response */
+    uint64_t    count;
+    uint64_t    sum_ns;
+    std::vector<std::pair<uint64_t, uint64_t>> buckets; /* (upper bound in ns, count) of non-empty buckets, ascending */
+
+    Latency_histogram() : op(), phase(), count(0), sum_ns(0), buckets() {}
+  };
+
   using ado_flags_t = uint32_t;
 
   static constexpr ado_flags_t ADO_FLAG_NONE = 0x0;
@@ -196,7 +229,7 @@ public:
   /**
    * Configure a pool
    *
-   * @param setting Configuration request (e.g., AddIndex::VolatileTree)
+   * @param setting Configuration request (e.g., AddIndex::VolatileTree, AddIndex::VolatileBTree)
 
    *
    * @return S_OK on success
@@ -331,6 +364,30 @@ public:
     return s;
   }
 
+  /**
+   * Read an object value asynchronously. Many gets may be in flight on
+   * one connection; responses are received into pre-registered memory,
+   * so no allocation or registration is made per call.
+   *
+   * @param pool Pool handle
+   * @param key Object key
+   * @param out_value [in] null, or a client buffer (need not be registered)
+   *                  [out] value; if null on input, points to memory owned by
+   *                  the component, to be released with free_memory() API
+   * @param out_value_len [in] size of client buffer [out] size of value
+   * @param out_handle Async work handle
+   *
+   * out_value and out_value_len must remain valid until the operation completes
+   *
+   * @return S_OK or error code. On completion, E_INSUFFICIENT_SPACE if the client
+   * buffer is smaller than the value
+   */
+  virtual status_t async_get(const IMCAS::pool_t pool,
+                             const std::string&  key,
+                             void*&              out_value,
+                             size_t&             out_value_len,
+                             async_handle_t&     out_handle) = 0;
+
   /**
    * Read an object value directly into client-provided memory.
    *
@@ -428,7 +485,7 @@ public:
    * Perform key search based on regex or prefix
    *
    * @param pool Pool handle
-   * @param key_expression Regular expression or prefix (e.g. "prefix:carKey")
+   * @param key_expression "next:", "exact:k", "prefix:p", "substring:s" or "regex:r" (e.g. "prefix:carKey")
    * @param offset Offset from which to search
    * @param out_matched_offset Out offset of match
    * @param out_keys Out vector of matching keys
@@ -461,6 +518,77 @@ public:
    * @return S_OK or error code
    */
   virtual status_t async_erase(const IMCAS::pool_t pool, const std::string& key, async_handle_t& out_handle) = 0;
+
+  /**
+   * Write or overwrite many small objects. Key/value pairs are packed
+   * into as few network messages as possible.
+   *
+   * @param pool Pool handle
+   * @param keys Object keys
+   * @param values Value data, one per key
+   * @param out_status Per-key status (S_OK, E_TOO_LARGE or store error code)
+   * @param flags Additional flags (applied to every key)
+   *
+   * @return S_OK if every message was exchanged (see out_status for per-key result) or error code
+   */
+  virtual status_t put_batch(const IMCAS::pool_t             pool,
+                             const std::vector<std::string>& keys,
+                             const std::vector<std::string>& values,
+                             std::vector<status_t>&          out_status,
+                             const unsigned int              flags = IMCAS::FLAGS_NONE) = 0;
+
+  /**
+   * Read many small objects. Values which are too large to be returned
+   * in a batch response are fetched individually.
+   *
+   * @param pool Pool handle
+   * @param keys Object keys
+   * @param out_values Value data, one per key (empty on per-key error)
+   * @param out_status Per-key status
+   *
+   * @return S_OK if every message was exchanged (see out_status for per-key result) or error code
+   */
+  virtual status_t get_batch(const IMCAS::pool_t             pool,
+                             const std::vector<std::string>& keys,
+                             std::vector<std::string>&       out_values,
+                             std::vector<status_t>&          out_status) = 0;
+
+  /**
+   * Erase many objects
+   *
+   * @param pool Pool handle
+   * @param keys Object keys
+   * @param out_status Per-key status
+   *
+   * @return S_OK if every message was exchanged (see out_status for per-key result) or error code
+   */
+  virtual status_t erase_batch(const IMCAS::pool_t             pool,
+                               const std::vector<std::string>& keys,
+                               std::vector<status_t>&          out_status) = 0;
+
+  /**
+   * List keys, and optionally values, matching an expression, many to a
+   * round trip. Requires an index (see configure "AddIndex::VolatileTree").
+   * Keys are returned in key order; a scan is continued by calling again
+   * with the cursor from the previous call.
+   *
+   * @param pool Pool handle
+   * @param key_expression "next:" (all keys), "prefix:p", "range:lo..hi" (hi exclusive,
+   * may be empty), "regex:r", "substring:s" or "exact:k"
+   * @param in_out_cursor Resume point: empty to start a scan, updated on S_MORE
+   * @param out_keys Matching keys (appended)
+   * @param out_values If not null, values of the matching keys (appended)
+   * @param max_keys Maximum number of keys to return (0 for as many as fit in a response)
+   *
+   * @return S_OK if the scan is complete, S_MORE if it may be continued, or error code
+   */
+  virtual status_t scan(const IMCAS::pool_t        pool,
+                        const std::string&         key_expression,
+                        std::string&               in_out_cursor,
+                        std::vector<std::string>&  out_keys,
+                        std::vector<std::string>*  out_values = nullptr,
+                        const size_t               max_keys   = 0) = 0;
+
   /**
    * Return number of objects in the pool
    *
@@ -494,6 +622,18 @@ public:
    */
   virtual status_t get_statistics(Shard_stats& out_stats) = 0;
 
+  /**
+   * Retrieve shard latency histograms, one for each operation class and
+   * phase which has been recorded. Buckets are about 12% wide.
+   *
+   * @param out_histograms Histograms
+   * @param reset Clear the shard's histograms after reading them
+   *
+   * @return S_OK on success, E_NOT_SUPPORTED if the server does not keep
+   * latency histograms
+   */
+  virtual status_t get_latency_statistics(std::vector<Latency_histogram>& out_histograms, bool reset = false) = 0;
+
   /**
    * Free API allocated memory
    *
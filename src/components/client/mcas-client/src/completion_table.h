@@ -0,0 +1,112 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __CLIENT_COMPLETION_TABLE_H__
+#define __CLIENT_COMPLETION_TABLE_H__
+
+#include <common/delete_copy.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+namespace mcas
+{
+namespace client
+{
+/**
+ * Completions which have been polled but not yet claimed. The key is a
+ * work request context (send, read, write) or, for a receive, the request
+ * id of the response. Completions are published by the one thread which
+ * currently polls, so publication needs no read-modify-write; a completion
+ * is claimed by the one thread which waits for its key.
+ */
+class Completion_table {
+ public:
+  struct entry_t {
+    void *      context; /* work request context */
+    std::size_t len;     /* bytes received */
+  };
+
+ private:
+  static constexpr unsigned    SLOT_BITS = 10;
+  static constexpr std::size_t SLOTS     = std::size_t(1) << SLOT_BITS;
+  static constexpr std::size_t WINDOW    = 32; /* slots probed from a key's home slot */
+
+  struct slot_t {
+    std::atomic<std::uint64_t> key{0}; /* 0 if free */
+    entry_t                    e{nullptr, 0};
+  };
+
+  static std::size_t home(std::uint64_t key) { return std::size_t((key * 0x9e3779b97f4a7c15ULL) >> (64 - SLOT_BITS)); }
+
+ public:
+  Completion_table() : _slots(), _overflow_lock(), _overflow(), _overflow_count(0) {}
+
+  DELETE_COPY(Completion_table);
+
+  /* called by the polling thread only */
+  void publish(std::uint64_t key, void *context, std::size_t len)
+  {
+    const auto h = home(key);
+    for (std::size_t i = 0; i != WINDOW; ++i) {
+      auto &s = _slots[(h + i) % SLOTS];
+      if (s.key.load(std::memory_order_acquire) == 0) {
+        s.e = entry_t{context, len};
+        s.key.store(key, std::memory_order_release);
+        return;
+      }
+    }
+    std::lock_guard<std::mutex> g(_overflow_lock);
+    _overflow.emplace(key, entry_t{context, len});
+    _overflow_count.store(_overflow.size(), std::memory_order_release);
+  }
+
+  bool claim(std::uint64_t key, entry_t &out)
+  {
+    const auto h = home(key);
+    /* a slot freed by a claim may be reused, so probe the whole window */
+    for (std::size_t i = 0; i != WINDOW; ++i) {
+      auto &s = _slots[(h + i) % SLOTS];
+      if (s.key.load(std::memory_order_acquire) == key) {
+        out = s.e;
+        s.key.store(0, std::memory_order_release);
+        return true;
+      }
+    }
+    if (_overflow_count.load(std::memory_order_acquire) != 0) {
+      std::lock_guard<std::mutex> g(_overflow_lock);
+      auto                        it = _overflow.find(key);
+      if (it != _overflow.end()) {
+        out = it->second;
+        _overflow.erase(it);
+        _overflow_count.store(_overflow.size(), std::memory_order_release);
+        return true;
+      }
+    }
+    return false;
+  }
+
+ private:
+  std::array<slot_t, SLOTS>                        _slots;
+  std::mutex                                       _overflow_lock;
+  std::unordered_multimap<std::uint64_t, entry_t> _overflow;
+  std::atomic<std::size_t>                         _overflow_count;
+};
+
+}  // namespace client
+}  // namespace mcas
+
+#endif
@@ -19,6 +19,7 @@
 #include <city.h>
 #include <common/cycles.h>
 #include <common/delete_copy.h>
+#include <common/log_histogram.h>
 #include <common/utils.h>
 #include <unistd.h>
 
@@ -41,6 +42,54 @@ private:
   int status() const { return _status; }
 };
 
+namespace
+{
+/* Reads the records of a batch or scan response, checking each against
+ * the end of the response data, which is itself checked to lie within
+ * the message as received.
+ */
+class response_records {
+  const char *_p;
+  const char *_end;
+  const char *_func;
+
+ public:
+  response_records(const mcas::protocol::Message_IO_response *msg_, std::size_t received_len_, const char *func_)
+      : _p(msg_->cdata()),
+        _end(msg_->cdata() + msg_->data_length()),
+        _func(func_)
+  {
+    if (received_len_ < msg_->msg_len() || msg_->msg_len() < msg_->base_message_size() + msg_->data_length())
+      throw Protocol_exception("%s: response data length %lu exceeds message length %lu", _func, msg_->data_length(),
+                               std::size_t(msg_->msg_len()));
+  }
+
+  /* data at the end of the response (a scan cursor), which is not records */
+  void exclude_tail(std::size_t len_)
+  {
+    if (std::size_t(_end - _p) < len_) throw Protocol_exception("%s: bad trailer length %lu in response", _func, len_);
+    _end -= len_;
+  }
+
+  mcas::protocol::batch_element element()
+  {
+    mcas::protocol::batch_element e;
+    _p = take(sizeof e);
+    std::memcpy(&e, _p - sizeof e, sizeof e);
+    return e;
+  }
+
+  /* the next len_ bytes */
+  const char *take(std::size_t len_)
+  {
+    if (std::size_t(_end - _p) < len_) throw Protocol_exception("%s: truncated record in response", _func);
+    auto p = _p;
+    _p += len_;
+    return p;
+  }
+};
+}  // namespace
+
 namespace mcas
 {
 namespace client
@@ -112,17 +161,20 @@ struct async_buffer_set_t : public component::IMCAS::Opaque_async_handle, protec
  protected:
   iob_ptr        iobs;
   iob_ptr        iobr;
+  std::uint64_t  request_id; /* of the response awaited */
 
-  async_buffer_set_t(unsigned debug_level_, iob_ptr &&iobs_, iob_ptr &&iobr_) noexcept
+  async_buffer_set_t(unsigned debug_level_, iob_ptr &&iobs_, iob_ptr &&iobr_, std::uint64_t request_id_) noexcept
       : component::IMCAS::Opaque_async_handle{},
         common::log_source(debug_level_),
         iobs(std::move(iobs_)),
-        iobr(std::move(iobr_))
+        iobr(std::move(iobr_)),
+        request_id(request_id_)
   {
-    CPLOG(2, "%s iobs %p iobr %p"
+    CPLOG(2, "%s iobs %p iobr %p request %" PRIx64
       , __func__
-      , static_cast<const void *>(&*iobs)
-      , static_cast<const void *>(&*iobr)
+      , static_cast<const void *>(iobs.get())
+      , static_cast<const void *>(iobr.get())
+      , request_id
     );
   }
 
@@ -136,8 +188,8 @@ struct async_buffer_set_t : public component::IMCAS::Opaque_async_handle, protec
 
 /* Nothing more than the two buffers. Used for async erase */
 struct async_buffer_set_simple : public async_buffer_set_t {
-  async_buffer_set_simple(unsigned debug_level_, iob_ptr &&iobs_, iob_ptr &&iobr_) noexcept
-      : async_buffer_set_t(debug_level_, std::move(iobs_), std::move(iobr_))
+  async_buffer_set_simple(unsigned debug_level_, iob_ptr &&iobs_, iob_ptr &&iobr_, std::uint64_t request_id_) noexcept
+      : async_buffer_set_t(debug_level_, std::move(iobs_), std::move(iobr_), request_id_)
   {
   }
   int move_along(Connection_handler *c) override
@@ -150,7 +202,7 @@ struct async_buffer_set_simple : public async_buffer_set_t {
     }
 
     if (iobr) { /* check recv, clear and free on completion */
-      if (c->test_completion(&*iobr) == false) {
+      if (c->test_response(iobr, request_id) == false) {
         return E_BUSY;
       }
 
@@ -166,6 +218,103 @@ struct async_buffer_set_simple : public async_buffer_set_t {
   }
 };
 
+/* Async (non-direct) get. The response lands in a receive slab if one
+ * was free, else in an IO buffer. If the caller supplied no buffer, a
+ * value in a slab is handed over in place and the slab goes back to the
+ * pool on free_memory. A two-stage value is awaited as a continuation.
+ */
+struct async_buffer_set_get : public async_buffer_set_t {
+ private:
+  void *&       _value;
+  std::size_t & _value_len;
+  bool          _continued; /* awaiting the value of a two-stage response */
+  std::size_t   _len;       /* of the two-stage value */
+
+ public:
+  async_buffer_set_get(unsigned      debug_level_,
+                       iob_ptr &&    iobs_,
+                       iob_ptr &&    iobr_,
+                       std::uint64_t request_id_,
+                       void *&       value_,
+                       std::size_t & value_len_) noexcept
+      : async_buffer_set_t(debug_level_, std::move(iobs_), std::move(iobr_), request_id_),
+        _value(value_),
+        _value_len(value_len_),
+        _continued(false),
+        _len(0)
+  {
+  }
+  DELETE_COPY(async_buffer_set_get);
+
+  int move_along(Connection_handler *c) override
+  {
+    if (iobs) { /* send, if it was not injected */
+      if (c->test_completion(&*iobs) == false) {
+        return E_BUSY;
+      }
+      iobs.reset(nullptr);
+    }
+
+    if (!iobr) {
+      throw API_exception("invalid async handle, task already completed?");
+    }
+    /* the response may have landed elsewhere: if so iobr takes over that buffer (or slab) */
+    if (c->test_response(iobr, request_id) == false) {
+      return E_BUSY;
+    }
+
+    const char *data;
+    std::size_t len;
+    if (_continued) {
+      data = static_cast<const char *>(iobr->base().get());
+      len  = _len;
+    }
+    else {
+      const auto response_msg = c->msg_recv<const mcas::protocol::Message_IO_response>(&*iobr, "ASYNC GET");
+      const int  status       = response_msg->get_status();
+      if (status != S_OK) {
+        iobr.reset(nullptr);
+        return status;
+      }
+      if (response_msg->is_set_twostage_bit()) {
+        /* the value follows as a message of its own; post a buffer in place of the one it takes */
+        _continued = true;
+        _len       = response_msg->data_length();
+        iobr       = c->make_iob_ptr_recv();
+        c->post_recv(&*iobr);
+        request_id = Connection_handler::continuation_key(request_id);
+        return E_BUSY;
+      }
+      data = response_msg->cdata();
+      len  = response_msg->data_length();
+    }
+
+    int status = S_OK;
+    if (_value) { /* caller buffer */
+      if (len > _value_len)
+        status = E_INSUFFICIENT_SPACE;
+      else
+        std::memcpy(_value, data, len);
+    }
+    else if (c->is_recv_slab(data)) { /* hand over the slab */
+      _value = const_cast<char *>(data);
+      iobr.release();
+    }
+    else {
+      _value = ::malloc(len + 1);
+      if (_value == nullptr) {
+        throw std::bad_alloc();
+      }
+      std::memcpy(_value, data, len);
+      static_cast<char *>(_value)[len] = '\0';
+    }
+    if (status == S_OK) _value_len = len;
+
+    iobr.reset(nullptr);
+    return status;
+  }
+};
+
 /* Is also an M, which is memory_registered_owned if the caller
  * has *not* registered memory, and is memory_registered_not_owned
  * if the caller *has* registered memory.
@@ -200,7 +349,7 @@ private:
                               std::uint64_t            addr_,
                               std::uint64_t            key_
     )
-      : async_buffer_set_t(debug_level_, std::move(iobs_), std::move(iobr_))
+      : async_buffer_set_t(debug_level_, std::move(iobs_), std::move(iobr_), 0)
       , M(rmd_,
           mcas::range<char *>(static_cast<char *>(value_), static_cast<char *>(value_) + value_len_)
               .round_inclusive(4096),
@@ -247,8 +396,10 @@ private:
       /* DMA is complete. Issue GET_RELEASE */
 
       /* send release message */
+
+      request_id = c->request_id();
       const auto msg = new (iobs->base())
-          protocol::Message_IO_request(_auth_id, c->request_id(), _pool, protocol::OP_TYPE::OP_GET_RELEASE, _addr);
+          protocol::Message_IO_request(_auth_id, request_id, _pool, protocol::OP_TYPE::OP_GET_RELEASE, _addr);
 
       c->post_recv(&*iobr);
       c->sync_inject_send(&*iobs, msg, __func__);
@@ -257,7 +408,7 @@ private:
 
     if ( iobr )
     {
-      if ( ! c->test_completion(&*iobr) )
+      if ( ! c->test_response(iobr, request_id) )
       {
         return E_BUSY;
       }
@@ -297,6 +448,7 @@ private:
                               Registrar_memory_direct *rmd_,
                               iob_ptr &&               iobs_,
                               iob_ptr &&               iobr_,
+                              std::uint64_t            request_id_,
                               iob_ptr &&               iobrd_,
                               iob_ptr &&               iobs2_,
                               iob_ptr &&               iobr2_,
@@ -305,7 +457,7 @@ private:
                               const void *             value_,
                               std::size_t              value_len_,
                               void *                   desc_)
-      : async_buffer_set_t(debug_level_, std::move(iobs_), std::move(iobr_)),
+      : async_buffer_set_t(debug_level_, std::move(iobs_), std::move(iobr_), request_id_),
         M(rmd_,
           mcas::range<char *>(static_cast<char *>(const_cast<void *>(value_)),
                               static_cast<char *>(const_cast<void *>(value_)) + value_len_)
@@ -343,7 +495,7 @@ private:
     }
 
     if (iobr) { /* check recv, clear and free on completion */
-      if (c->test_completion(&*iobr) == false) {
+      if (c->test_response(iobr, request_id) == false) {
         return E_BUSY;
       }
       /* What to do when first recv completes */
@@ -380,8 +532,10 @@ private:
       /* DMA is complete. Issue PUT_RELEASE */
 
       /* send release message */
+
+      request_id = c->request_id();
       const auto msg = new (_iobs2->base())
-          protocol::Message_IO_request(_auth_id, c->request_id(), _pool, protocol::OP_TYPE::OP_PUT_RELEASE, _addr);
+          protocol::Message_IO_request(_auth_id, request_id, _pool, protocol::OP_TYPE::OP_PUT_RELEASE, _addr);
 
       c->post_recv(&*_iobr2);
       c->sync_inject_send(&*_iobs2, msg, __func__);
@@ -389,7 +543,7 @@ private:
     }
 
     if (_iobr2) {
-      if (!c->test_completion(&*_iobr2)) {
+      if (!c->test_response(_iobr2, request_id)) {
         return E_BUSY;
       }
       /* What to do when second recv completes */
@@ -413,8 +567,9 @@ struct async_buffer_set_invoke : public async_buffer_set_t {
   async_buffer_set_invoke(unsigned                          debug_level_,
                           iob_ptr &&                        iobs_,
                           iob_ptr &&                        iobr_,
+                          std::uint64_t                     request_id_,
                           std::vector<IMCAS::ADO_response> *out_ado_response_)
-      : async_buffer_set_t(debug_level_, std::move(iobs_), std::move(iobr_)),
+      : async_buffer_set_t(debug_level_, std::move(iobs_), std::move(iobr_), request_id_),
         out_ado_response(out_ado_response_)
   {
   }
@@ -429,7 +584,7 @@ struct async_buffer_set_invoke : public async_buffer_set_t {
     }
 
     if (iobr) { /* check recv, clear and free on completion */
-      if (c->test_completion(&*iobr) == false) {
+      if (c->test_response(iobr, request_id) == false) {
         return E_BUSY;
       }
       const auto response_msg = c->msg_recv<const mcas::protocol::Message_ado_response>(&*iobr, __func__);
@@ -488,6 +643,7 @@ private:
                                      Registrar_memory_direct *rmd_,
                                      iob_ptr &&               iobs_,
                                      iob_ptr &&               iobr_,
+                                     std::uint64_t            request_id_,
                                      iob_ptr &&               iobrd_,
                                      iob_ptr &&               iobs2_,
                                      iob_ptr &&               iobr2_,
@@ -497,7 +653,7 @@ private:
                                      void *                   buffer_,
                                      std::size_t &            length_,
                                      void *                   desc_)
-      : async_buffer_set_t(debug_level_, std::move(iobs_), std::move(iobr_)),
+      : async_buffer_set_t(debug_level_, std::move(iobs_), std::move(iobr_), request_id_),
         M(rmd_,
           mcas::range<char *>(static_cast<char *>(buffer_), static_cast<char *>(buffer_) + length_)
               .round_inclusive(4096),
@@ -536,7 +692,7 @@ private:
     }
 
     if (iobr) { /* check recv, clear and free on completion */
-      if (c->test_completion(&*iobr) == false) {
+      if (c->test_response(iobr, request_id) == false) {
         return E_BUSY;
       }
       /* What to do when first recv completes */
@@ -622,8 +778,10 @@ private:
       /* DMA is complete. Issue OP_RELEASE */
 
       /* send release message */
+
+      request_id = c->request_id();
       const auto msg = new (_iobs2->base()) protocol::Message_IO_request(
-          _auth_id, c->request_id(), _pool, protocol::OP_TYPE::OP_RELEASE, _offset, _length);
+          _auth_id, request_id, _pool, protocol::OP_TYPE::OP_RELEASE, _offset, _length);
 
       c->post_recv(&*_iobr2);
       c->sync_inject_send(&*_iobs2, msg, __func__);
@@ -632,7 +790,7 @@ private:
 
     /* release in process, or not needed because length is 0 */
     if ( _iobr2 ) {
-      if ( _iobr2 && ! c->test_completion(&*_iobr2) ) {
+      if ( _iobr2 && ! c->test_response(_iobr2, request_id) ) {
         return E_BUSY;
       }
       /* What to do when second recv completes */
@@ -672,6 +830,7 @@ private:
                                      Registrar_memory_direct *rmd_,
                                      iob_ptr &&               iobs_,
                                      iob_ptr &&               iobr_,
+                                     std::uint64_t            request_id_,
                                      iob_ptr &&               iobrd_,
                                      iob_ptr &&               iobs2_,
                                      iob_ptr &&               iobr2_,
@@ -681,7 +840,7 @@ private:
                                      const void *             buffer_,
                                      std::size_t &            length_,
                                      void *                   desc_)
-      : async_buffer_set_t(debug_level_, std::move(iobs_), std::move(iobr_)),
+      : async_buffer_set_t(debug_level_, std::move(iobs_), std::move(iobr_), request_id_),
         M(rmd_,
           mcas::range<char *>(static_cast<char *>(const_cast<void *>(buffer_)),
                               static_cast<char *>(const_cast<void *>(buffer_)) + length_)
@@ -721,7 +880,7 @@ private:
     }
 
     if (iobr) { /* check recv, clear and free on completion */
-      if (c->test_completion(&*iobr) == false) {
+      if (c->test_response(iobr, request_id) == false) {
         return E_BUSY;
       }
       /* What to do when first recv completes */
@@ -812,8 +971,10 @@ private:
       /* DMA is complete. Issue OP_RELEASE */
 
       /* send release message */
+
+      request_id = c->request_id();
       const auto msg = new (_iobs2->base()) protocol::Message_IO_request(
-          _auth_id, c->request_id(), _pool, protocol::OP_TYPE::OP_RELEASE_WITH_FLUSH, _offset, _length);
+          _auth_id, request_id, _pool, protocol::OP_TYPE::OP_RELEASE_WITH_FLUSH, _offset, _length);
 
         c->post_recv(&*_iobr2);
         c->sync_inject_send(&*_iobs2, msg, __func__);
@@ -821,7 +982,7 @@ private:
     }
 
     if ( _iobr2 ) {
-      if ( ! c->test_completion(&*_iobr2) ) {
+      if ( ! c->test_response(_iobr2, request_id) ) {
         return E_BUSY;
       }
       /* What to do when second recv completes */
@@ -839,11 +1000,8 @@ Connection_handler::Connection_handler(unsigned                    debug_level_,
                                        Connection_base::Transport *connection,
                                        unsigned                    patience_)
     : Connection_base(debug_level_, connection, patience_),
-#ifdef THREAD_SAFE_CLIENT
-      _api_lock{},
-#endif
+      _control_lock{},
       _exit{false},
-      _request_id{0},
       _max_message_size{0},
       _max_inject_size(connection->max_inject_size()),
       _options()
@@ -856,6 +1014,31 @@ Connection_handler::Connection_handler(unsigned                    debug_level_,
 
 Connection_handler::~Connection_handler() { PLOG("%s: (%p)", __func__, static_cast<const void *>(this)); }
 
+void Connection_handler::adopt_response(iob_ptr &iobr, const response_t &r)
+{
+  if (r.context == iobr.get()) return;
+
+  /* our own buffer stays posted, to receive some other response. The
+   * response may be in a slab posted by an async get; if so it is used in
+   * place, and goes back to the slab pool when iobr is freed.
+   */
+  iobr.release();
+  iobr.reset(static_cast<buffer_t *>(r.context));
+}
+
+void Connection_handler::wait_for_response(iob_ptr &iobr, const std::uint64_t request_id_)
+{
+  adopt_response(iobr, Connection_base::wait_for_response(request_id_));
+}
+
+bool Connection_handler::test_response(iob_ptr &iobr, const std::uint64_t request_id_)
+{
+  response_t r;
+  if (!Connection_base::test_response(request_id_, r)) return false;
+  adopt_response(iobr, r);
+  return true;
+}
+
 void Connection_handler::send_complete(void *param, buffer_t *iob)
 {
   PLOG("%s param %p iob %p", __func__, param, static_cast<const void *>(iob));
@@ -877,7 +1060,7 @@ Connection_handler::pool_t Connection_handler::open_pool(const std::string name,
                                                          const unsigned int  // flags
 )
 {
-  API_LOCK();
+  CONTROL_LOCK();
 
   PMAJOR("open pool: %s", name.c_str());
 
@@ -890,7 +1073,7 @@ Connection_handler::pool_t Connection_handler::open_pool(const std::string name,
    *
    */
   const auto iobs = make_iob_ptr_send();
-  const auto iobr = make_iob_ptr_recv();
+  auto iobr = make_iob_ptr_recv();
   assert(iobs);
   assert(iobr);
 
@@ -912,7 +1095,7 @@ Connection_handler::pool_t Connection_handler::open_pool(const std::string name,
      * Here, &*iobr is equivalent to iobr->get(). The choice is a
      * matter of style. &* uses two fewer tokens.
      */
-    /* the sequence "post_recv, sync_inject_send, wait_for_completion"
+    /* the sequence "post_recv, sync_inject_send, wait_for_response"
      * is common enough that it probably deserves its own function.
      * But we may find that the entire single-exchange pattern as seen
      * in open_pool, create_pool and several others could be placed in
@@ -921,7 +1104,7 @@ Connection_handler::pool_t Connection_handler::open_pool(const std::string name,
 
     post_recv(&*iobr);
     sync_inject_send(&*iobs, msg, __func__);
-    wait_for_completion(&*iobr); /* await response */
+    wait_for_response(iobr, CONTROL_RESPONSE); /* await response */
 
     const auto response_msg = msg_recv<const mcas::protocol::Message_pool_response>(&*iobr, __func__);
 
@@ -943,11 +1126,11 @@ Connection_handler::pool_t Connection_handler::create_pool(const std::string  na
                                                            const unsigned int flags,
                                                            const uint64_t     expected_obj_count)
 {
-  API_LOCK();
+  CONTROL_LOCK();
 
   /* send pool request message */
   const auto iobs = make_iob_ptr_send();
-  const auto iobr = make_iob_ptr_recv();
+  auto iobr = make_iob_ptr_recv();
   assert(iobs);
   assert(iobr);
 
@@ -961,7 +1144,7 @@ Connection_handler::pool_t Connection_handler::create_pool(const std::string  na
 
     post_recv(&*iobr);
     sync_inject_send(&*iobs, msg, __func__);
-    wait_for_completion(&*iobr);
+    wait_for_response(iobr, CONTROL_RESPONSE);
 
     const auto response_msg = msg_recv<const mcas::protocol::Message_pool_response>(&*iobr, __func__);
 
@@ -983,17 +1166,17 @@ Connection_handler::pool_t Connection_handler::create_pool(const std::string  na
 
 status_t Connection_handler::close_pool(const pool_t pool)
 {
-  API_LOCK();
+  CONTROL_LOCK();
   /* send pool request message */
   const auto iobs = make_iob_ptr_send();
-  const auto iobr = make_iob_ptr_recv();
+  auto iobr = make_iob_ptr_recv();
   const auto msg  = new (iobs->base())
       mcas::protocol::Message_pool_request(iobs->length(), auth_id(), request_id(), mcas::protocol::OP_CLOSE, pool);
 
   post_recv(&*iobr);
   sync_inject_send(&*iobs, msg, __func__);
   try {
-    wait_for_completion(&*iobr);
+    wait_for_response(iobr, CONTROL_RESPONSE);
 
     const auto response_msg = msg_recv<const mcas::protocol::Message_pool_response>(&*iobr, __func__);
 
@@ -1015,10 +1198,10 @@ status_t Connection_handler::delete_pool(const std::string &name)
 {
   if (name.empty()) return E_INVAL;
 
-  API_LOCK();
+  CONTROL_LOCK();
 
   const auto iobs = make_iob_ptr_send();
-  const auto iobr = make_iob_ptr_recv();
+  auto iobr = make_iob_ptr_recv();
 
   const auto msg = new (iobs->base()) mcas::protocol::Message_pool_request(iobs->length(), auth_id(), request_id(),
                                                                            0,  // size
@@ -1030,7 +1213,7 @@ status_t Connection_handler::delete_pool(const std::string &name)
   post_recv(&*iobr);
   sync_inject_send(&*iobs, msg, __func__);
   try {
-    wait_for_completion(&*iobr);
+    wait_for_response(iobr, CONTROL_RESPONSE);
 
     const auto response_msg = msg_recv<const mcas::protocol::Message_pool_response>(&*iobr, __func__);
 
@@ -1050,10 +1233,10 @@ status_t Connection_handler::delete_pool(const IMCAS::pool_t pool)
 {
   if (!pool) return E_INVAL;
 
-  API_LOCK();
+  CONTROL_LOCK();
 
   const auto iobs = make_iob_ptr_send();
-  const auto iobr = make_iob_ptr_recv();
+  auto iobr = make_iob_ptr_recv();
 
   const auto msg = new (iobs->base())
       mcas::protocol::Message_pool_request(iobs->length(), auth_id(), request_id(), mcas::protocol::OP_DELETE, pool);
@@ -1061,7 +1244,7 @@ status_t Connection_handler::delete_pool(const IMCAS::pool_t pool)
   post_recv(&*iobr);
   sync_inject_send(&*iobs, msg, __func__);
   try {
-    wait_for_completion(&*iobr);
+    wait_for_response(iobr, CONTROL_RESPONSE);
 
     const auto response_msg = msg_recv<const mcas::protocol::Message_pool_response>(&*iobr, __func__);
 
@@ -1079,10 +1262,8 @@ status_t Connection_handler::delete_pool(const IMCAS::pool_t pool)
 
 status_t Connection_handler::configure_pool(const IMCAS::pool_t pool, const std::string &json)
 {
-  API_LOCK();
-
   const auto iobs = make_iob_ptr_send();
-  const auto iobr = make_iob_ptr_recv();
+  auto iobr = make_iob_ptr_recv();
 
   if (!mcas::protocol::Message_IO_request::would_fit(json.length(), iobs->original_length())) {
     return IKVStore::E_TOO_LARGE;
@@ -1095,7 +1276,7 @@ status_t Connection_handler::configure_pool(const IMCAS::pool_t pool, const std:
   post_recv(&*iobr);
   sync_inject_send(&*iobs, msg, __func__);
   try {
-    wait_for_completion(&*iobr);
+    wait_for_response(iobr, msg->request_id());
     const auto response_msg = msg_recv<const mcas::protocol::Message_IO_response>(&*iobr, __func__);
 
     return response_msg->get_status();
@@ -1131,10 +1312,8 @@ status_t Connection_handler::put(const pool_t       pool,
                                  const size_t       value_len,
                                  const unsigned int flags)
 {
-  API_LOCK();
-
   const auto iobs = make_iob_ptr_send();
-  const auto iobr = make_iob_ptr_recv();
+  auto iobr = make_iob_ptr_recv();
 
   if (debug_level() > 1)
     PINF("put: %.*s (key_len=%lu) (value_len=%lu)", int(key_len), static_cast<const char *>(key), key_len, value_len);
@@ -1159,7 +1338,7 @@ status_t Connection_handler::put(const pool_t       pool,
 
     post_recv(&*iobr);
     sync_send(&*iobs, msg, __func__); /* this will clean up iobs */
-    wait_for_completion(&*iobr);
+    wait_for_response(iobr, msg->request_id());
 
     const auto response_msg = msg_recv<const mcas::protocol::Message_IO_response>(&*iobr, __func__);
 
@@ -1180,17 +1359,17 @@ status_t Connection_handler::put(const pool_t       pool,
 auto Connection_handler::locate(const pool_t pool_, const std::size_t offset_, const std::size_t size_)
     -> std::tuple<uint64_t, std::vector<locate_element>>
 {
-  const auto iobr = make_iob_ptr_recv();
+  auto iobr = make_iob_ptr_recv();
   const auto iobs = make_iob_ptr_send();
 
   /* send advance leader message */
   const auto msg = new (iobs->base())
-      protocol::Message_IO_request(auth_id(), pool_, request_id(), protocol::OP_LOCATE, offset_, size_);
+      protocol::Message_IO_request(auth_id(), request_id(), pool_, protocol::OP_LOCATE, offset_, size_);
 
   post_recv(&*iobr);
   sync_inject_send(&*iobs, msg, __func__);
   /* wait for response from header before posting the value */
-  wait_for_completion(&*iobr);
+  wait_for_response(iobr, msg->request_id());
 
   const auto response = msg_recv<const mcas::protocol::Message_IO_response>(&*iobr, __func__);
 
@@ -1209,7 +1388,7 @@ std::tuple<uint64_t, uint64_t, std::size_t> Connection_handler::get_locate(const
                                                                            const size_t   key_len,
                                                                            const unsigned flags)
 {
-  const auto iobr = make_iob_ptr_recv();
+  auto iobr = make_iob_ptr_recv();
   const auto iobs = make_iob_ptr_send();
 
   /* send advance leader message */
@@ -1219,7 +1398,7 @@ std::tuple<uint64_t, uint64_t, std::size_t> Connection_handler::get_locate(const
   post_recv(&*iobr);
   sync_inject_send(&*iobs, msg, __func__);
   /* wait for response from header before posting the value */
-  wait_for_completion(&*iobr);
+  wait_for_response(iobr, msg->request_id());
 
   const auto response_msg = msg_recv<const mcas::protocol::Message_IO_response>(&*iobr, __func__);
 
@@ -1236,7 +1415,7 @@ std::tuple<uint64_t, uint64_t> Connection_handler::put_locate(const pool_t   poo
                                                               const size_t   value_len,
                                                               const unsigned flags)
 {
-  const auto iobr = make_iob_ptr_recv();
+  auto iobr = make_iob_ptr_recv();
   const auto iobs = make_iob_ptr_send();
 
   /* send advance leader message */
@@ -1246,7 +1425,7 @@ std::tuple<uint64_t, uint64_t> Connection_handler::put_locate(const pool_t   poo
   post_recv(&*iobr);
   sync_inject_send(&*iobs, msg, __func__);
   /* wait for response from header before posting the value */
-  wait_for_completion(&*iobr);
+  wait_for_response(iobr, msg->request_id());
 
   const auto response_msg = msg_recv<const mcas::protocol::Message_IO_response>(&*iobr, __func__);
 
@@ -1287,11 +1466,11 @@ IMCAS::async_handle_t Connection_handler::put_locate_async(const pool_t
    *   recv PUT_RELEASE response
    */
   return desc_ ? static_cast<IMCAS::async_handle_t>(new async_buffer_set_put_locate<memory_registered_not_owned>(
-                     debug_level(), rmd_, std::move(iobs), std::move(iobr), make_iob_ptr_write(), make_iob_ptr_send(),
-                     make_iob_ptr_recv(), pool, auth_id(), value, value_len, desc_))
+                     debug_level(), rmd_, std::move(iobs), std::move(iobr), msg->request_id(), make_iob_ptr_write(),
+                     make_iob_ptr_send(), make_iob_ptr_recv(), pool, auth_id(), value, value_len, desc_))
                : static_cast<IMCAS::async_handle_t>(new async_buffer_set_put_locate<memory_registered_owned>(
-                     debug_level(), rmd_, std::move(iobs), std::move(iobr), make_iob_ptr_write(), make_iob_ptr_send(),
-                     make_iob_ptr_recv(), pool, auth_id(), value, value_len, desc_));
+                     debug_level(), rmd_, std::move(iobs), std::move(iobr), msg->request_id(), make_iob_ptr_write(),
+                     make_iob_ptr_send(), make_iob_ptr_recv(), pool, auth_id(), value, value_len, desc_));
 }
 
 IMCAS::async_handle_t Connection_handler::get_direct_offset_async(const pool_t                        pool_,
@@ -1318,11 +1497,11 @@ IMCAS::async_handle_t Connection_handler::get_direct_offset_async(const pool_t
    * request recv RELEASE response
    */
   return desc_ ? static_cast<IMCAS::async_handle_t>(new async_buffer_set_get_direct_offset<memory_registered_not_owned>(
-                     debug_level(), rmd_, std::move(iobs), std::move(iobr), iob_ptr(nullptr, this), make_iob_ptr_send(),
-                     make_iob_ptr_recv(), pool_, auth_id(), offset_, buffer_, len_, desc_))
+                     debug_level(), rmd_, std::move(iobs), std::move(iobr), msg->request_id(), iob_ptr(nullptr, this),
+                     make_iob_ptr_send(), make_iob_ptr_recv(), pool_, auth_id(), offset_, buffer_, len_, desc_))
                : static_cast<IMCAS::async_handle_t>(new async_buffer_set_get_direct_offset<memory_registered_owned>(
-                     debug_level(), rmd_, std::move(iobs), std::move(iobr), iob_ptr(nullptr, this), make_iob_ptr_send(),
-                     make_iob_ptr_recv(), pool_, auth_id(), offset_, buffer_, len_, desc_));
+                     debug_level(), rmd_, std::move(iobs), std::move(iobr), msg->request_id(), iob_ptr(nullptr, this),
+                     make_iob_ptr_send(), make_iob_ptr_recv(), pool_, auth_id(), offset_, buffer_, len_, desc_));
 }
 
 IMCAS::async_handle_t Connection_handler::put_direct_offset_async(const pool_t                        pool_,
@@ -1349,11 +1528,11 @@ IMCAS::async_handle_t Connection_handler::put_direct_offset_async(const pool_t
    * request recv RELEASE response
    */
   return desc_ ? static_cast<IMCAS::async_handle_t>(new async_buffer_set_put_direct_offset<memory_registered_not_owned>(
-                     debug_level(), rmd_, std::move(iobs), std::move(iobr), iob_ptr(nullptr, this), make_iob_ptr_send(),
-                     make_iob_ptr_recv(), pool_, auth_id(), offset_, buffer_, length_, desc_))
+                     debug_level(), rmd_, std::move(iobs), std::move(iobr), msg->request_id(), iob_ptr(nullptr, this),
+                     make_iob_ptr_send(), make_iob_ptr_recv(), pool_, auth_id(), offset_, buffer_, length_, desc_))
                : static_cast<IMCAS::async_handle_t>(new async_buffer_set_put_direct_offset<memory_registered_owned>(
-                     debug_level(), rmd_, std::move(iobs), std::move(iobr), iob_ptr(nullptr, this), make_iob_ptr_send(),
-                     make_iob_ptr_recv(), pool_, auth_id(), offset_, buffer_, length_, desc_));
+                     debug_level(), rmd_, std::move(iobs), std::move(iobr), msg->request_id(), iob_ptr(nullptr, this),
+                     make_iob_ptr_send(), make_iob_ptr_recv(), pool_, auth_id(), offset_, buffer_, length_, desc_));
 }
 
 IMCAS::async_handle_t Connection_handler::get_locate_async( //
@@ -1374,6 +1553,7 @@ IMCAS::async_handle_t Connection_handler::get_locate_async( //
   const auto msg = new (iobs->base()) protocol::Message_IO_request(
       iobs->length(), auth_id(), request_id(), pool, protocol::OP_GET_LOCATE, key, key_len, value_len, flags);
   iobs->set_length(msg->msg_len());
+  const auto request_id_ = msg->request_id();
 
   post_recv(&*iobr);
   post_send(iobs->iov, iobs->iov + 1, iobs->desc, &*iobs, msg, __func__);
@@ -1381,7 +1561,7 @@ IMCAS::async_handle_t Connection_handler::get_locate_async( //
   wait_for_completion(&*iobs);
   iobs.reset(nullptr);
 
-  wait_for_completion(&*iobr);
+  wait_for_response(iobr, request_id_);
   const auto response_msg = msg_recv<const mcas::protocol::Message_IO_response>(&*iobr, "ASYNC GET_LOCATE");
   auto status = response_msg->get_status();
   if (status != S_OK) {
@@ -1438,8 +1618,6 @@ status_t Connection_handler::async_put(const IMCAS::pool_t    pool,
                                        IMCAS::async_handle_t &out_handle,
                                        const unsigned int     flags)
 {
-  API_LOCK();
-
   if (debug_level() > 1)
     PINF("%s: %.*s (key_len=%lu) (value_len=%lu)", __func__, int(key_len), static_cast<const char *>(key), key_len,
          value_len);
@@ -1465,7 +1643,7 @@ status_t Connection_handler::async_put(const IMCAS::pool_t    pool,
     post_recv(&*iobr);
     post_send(iobs->iov, iobs->iov + 1, iobs->desc, &*iobs, msg, __func__);
 
-    out_handle = new async_buffer_set_simple(debug_level(), std::move(iobs), std::move(iobr));
+    out_handle = new async_buffer_set_simple(debug_level(), std::move(iobs), std::move(iobr), msg->request_id());
 
     return S_OK;
   }
@@ -1491,8 +1669,6 @@ status_t Connection_handler::async_put_direct(const IMCAS::pool_t
                                               const component::IKVStore::memory_handle_t mem_handle_,
                                               const unsigned int                         flags_)
 {
-  API_LOCK();
-
   assert(_max_message_size);
 
   if (pool_ == 0) {
@@ -1539,7 +1715,8 @@ status_t Connection_handler::async_put_direct(const IMCAS::pool_t
       post_send(iobs->iov, iobs->iov + 1, iobs->desc, &*iobs, msg,
                 __func__); /* send two concatentated buffers in single DMA */
 
-      out_async_handle_ = new async_buffer_set_simple(debug_level(), std::move(iobs), std::move(iobr));
+      out_async_handle_ =
+          new async_buffer_set_simple(debug_level(), std::move(iobs), std::move(iobr), msg->request_id());
     }
     return S_OK;
   }
@@ -1567,8 +1744,6 @@ status_t Connection_handler::async_get_direct(const IMCAS::pool_t
                                               const component::IKVStore::memory_handle_t mem_handle_,
                                               const unsigned int                         flags_)
 {
-  API_LOCK();
-
   if (value_len_ && !value_) {
     PWRN("%s: bad parameter value=%p value_len=%zu", __func__, value_, value_len_);
     return E_BAD_PARAM;
@@ -1604,10 +1779,60 @@ status_t Connection_handler::async_get_direct(const IMCAS::pool_t
   }
 }
 
-status_t Connection_handler::check_async_completion(IMCAS::async_handle_t &handle)
+status_t Connection_handler::async_get(const IMCAS::pool_t    pool,
+                                       const std::string &    key,
+                                       void *&                value,
+                                       size_t &               value_len,
+                                       IMCAS::async_handle_t &out_handle)
 {
-  API_LOCK();
+  if (value && value_len == 0) {
+    PWRN("%s: bad parameter value=%p value_len=%zu", __func__, value, value_len);
+    return E_BAD_PARAM;
+  }
+
+  try {
+    auto iobs = make_iob_ptr_send();
+
+    /* land the response in a slab; if none is free, fall back to an IO buffer */
+    auto slab = recv_slabs()->allocate(recv_complete);
+    auto iobr = slab ? iob_ptr(slab, iob_free(this)) : make_iob_ptr_recv();
+
+    const auto msg =
+        new (iobs->base()) mcas::protocol::Message_IO_request(iobs->length(), auth_id(), request_id(), pool,
+                                                              mcas::protocol::OP_GET,  // op
+                                                              key.c_str(), key.length(), 0);
+    msg->set_availabe_val_len_from_iob_len(iobs->original_length());
+    const auto request_id_ = msg->request_id();
+
+    if (_options.short_circuit_backend) msg->add_scbe();
+
+    post_recv(&*iobr);
+
+    /* a small request is injected, leaving nothing to wait for on the send side */
+    if (msg->msg_len() <= _max_inject_size) {
+      sync_inject_send(&*iobs, msg, __func__);
+      iobs.reset(nullptr);
+    }
+    else {
+      iobs->set_length(msg->msg_len());
+      post_send(iobs->iov, iobs->iov + 1, iobs->desc, &*iobs, msg, __func__);
+    }
 
+    out_handle = new async_buffer_set_get(debug_level(), std::move(iobs), std::move(iobr), request_id_, value, value_len);
+    return S_OK;
+  }
+  catch (const Exception &e) {
+    PLOG("%s %s fail %s", __FILE__, __func__, e.cause());
+    throw Logic_exception("%s: network posting failed unexpectedly.", __func__);
+  }
+  catch (const std::exception &e) {
+    PLOG("%s %s fail %s", __FILE__, __func__, e.what());
+    throw Logic_exception("%s: network posting failed unexpectedly.", __func__);
+  }
+}
+
+status_t Connection_handler::check_async_completion(IMCAS::async_handle_t &handle)
+{
   auto bptrs = static_cast<async_buffer_set_t *>(handle);
   assert(bptrs);
 
@@ -1638,12 +1863,19 @@ status_t Connection_handler::check_async_completion(IMCAS::async_handle_t &handl
   return status;
 }
 
-status_t Connection_handler::get(const pool_t pool, const std::string &key, std::string &value)
+status_t Connection_handler::free_memory(void *p)
 {
-  API_LOCK();
+  if (is_recv_slab(p))
+    release_recv_slab(p);
+  else
+    ::free(p);
+  return S_OK;
+}
 
+status_t Connection_handler::get(const pool_t pool, const std::string &key, std::string &value)
+{
   const auto iobs = make_iob_ptr_send();
-  const auto iobr = make_iob_ptr_recv();
+  auto iobr = make_iob_ptr_recv();
   assert(iobs);
   assert(iobr);
 
@@ -1659,7 +1891,7 @@ status_t Connection_handler::get(const pool_t pool, const std::string &key, std:
 
     post_recv(&*iobr);
     sync_inject_send(&*iobs, msg, __func__);
-    wait_for_completion(&*iobr);
+    wait_for_response(iobr, msg->request_id());
 
     const auto response_msg = msg_recv<const mcas::protocol::Message_IO_response>(&*iobr, __func__);
 #if 0
@@ -1688,10 +1920,8 @@ status_t Connection_handler::get(const pool_t pool, const std::string &key, std:
 
 status_t Connection_handler::get(const pool_t pool, const std::string &key, void *&value, size_t &value_len)
 {
-  API_LOCK();
-
   const auto iobs = make_iob_ptr_send();
-  const auto iobr = make_iob_ptr_recv();
+  auto iobr = make_iob_ptr_recv();
   assert(iobs);
   assert(iobr);
 
@@ -1712,7 +1942,7 @@ status_t Connection_handler::get(const pool_t pool, const std::string &key, void
 
     post_recv(&*iobr);
     sync_inject_send(&*iobs, msg, __func__);
-    wait_for_completion(&*iobr); /* TODO; could we issue the recv and send together? */
+    wait_for_response(iobr, msg->request_id()); /* TODO; could we issue the recv and send together? */
 
     const auto response_msg = msg_recv<const mcas::protocol::Message_IO_response>(&*iobr, __func__);
 
@@ -1720,37 +1950,30 @@ status_t Connection_handler::get(const pool_t pool, const std::string &key, void
 
     CPLOG(1, "%s: message value (%.*s)", __func__, int(response_msg->data_length()), response_msg->data());
 
-    if (response_msg->is_set_twostage_bit()) {
-      /* two-stage get */
-      const auto data_len = response_msg->data_length() + 1;
-      value               = ::aligned_alloc(MiB(2), data_len);
-      if (value == nullptr) {
-        throw std::bad_alloc();
-      }
-      madvise(value, data_len, MADV_HUGEPAGE);
-
-      auto  region = make_memory_registered(value, data_len); /* we could have some pre-registered? */
-      void *desc[] = {region.get_memory_descriptor()};
+    status    = response_msg->get_status();
+    value_len = response_msg->data_length();
+    auto data = response_msg->cdata();
 
-      ::iovec iov[]{{value, data_len - 1}};
-      post_recv(std::begin(iov), std::end(iov), std::begin(desc), &iov[0]);
-
-      /* synchronously wait for receive to complete */
-      wait_for_completion(&iov);
+    auto iobv = iob_ptr(nullptr, iob_free(this));
+    if (response_msg->is_set_twostage_bit()) {
+      /* two-stage get: the value follows as a message of its own, routed
+       * as the continuation of this request. Post a buffer in place of the
+       * one it takes.
+       */
+      iobv = make_iob_ptr_recv();
+      post_recv(&*iobv);
+      wait_for_response(iobv, continuation_key(msg->request_id()));
       CPLOG(1, "%s Received value from two stage get", __func__);
-    }
-    else {
-      /* copy off value from IO buffer */
-      value = ::malloc(response_msg->data_length() + 1);
-      if (value == nullptr) {
-        throw std::bad_alloc();
-      }
-      value_len = response_msg->data_length();
-      std::memcpy(value, response_msg->data(), response_msg->data_length());
-      static_cast<char *>(value)[response_msg->data_length()] = '\0';
+      data = static_cast<const char *>(iobv->base().get());
     }
 
-    status = response_msg->get_status();
+    /* copy off value from IO buffer */
+    value = ::malloc(value_len + 1);
+    if (value == nullptr) {
+      throw std::bad_alloc();
+    }
+    std::memcpy(value, data, value_len);
+    static_cast<char *>(value)[value_len] = '\0';
   }
   catch (const Exception &e) {
     PLOG("%s %s fail %s", __FILE__, __func__, e.cause());
@@ -1830,8 +2053,6 @@ status_t Connection_handler::async_get_direct_offset(const pool_t
   if(length_ == 0)
     throw API_exception("%s: variant of get_direct_offset called with zero length", __func__);
 
-  API_LOCK();
-
   if (length_ && !buffer_) {
     PWRN("%s: bad parameter buffer=%p size=%zu", __func__, buffer_, length_);
     return E_BAD_PARAM;
@@ -1868,8 +2089,6 @@ status_t Connection_handler::async_put_direct_offset(const pool_t
   if(length_ == 0)
     throw API_exception("%s: variant of put_direct_offset called with zero length", __func__);
 
-  API_LOCK();
-
   if (length_ && !buffer_) {
     PWRN("%s: bad parameter buffer=%p size=%zu", __func__, buffer_, length_);
     return E_BAD_PARAM;
@@ -1894,10 +2113,8 @@ status_t Connection_handler::async_put_direct_offset(const pool_t
 
 status_t Connection_handler::erase(const pool_t pool, const std::string &key)
 {
-  API_LOCK();
-
   const auto iobs = make_iob_ptr_send();
-  const auto iobr = make_iob_ptr_recv();
+  auto iobr = make_iob_ptr_recv();
   assert(iobs);
   assert(iobr);
 
@@ -1909,7 +2126,7 @@ status_t Connection_handler::erase(const pool_t pool, const std::string &key)
 
     post_recv(&*iobr);
     sync_inject_send(&*iobs, msg, __func__);
-    wait_for_completion(&*iobr);
+    wait_for_response(iobr, msg->request_id());
 
     const auto response_msg = msg_recv<const mcas::protocol::Message_IO_response>(&*iobr, __func__);
 
@@ -1931,8 +2148,6 @@ status_t Connection_handler::async_erase(const IMCAS::pool_t    pool,
                                          const std::string &    key,
                                          IMCAS::async_handle_t &out_async_handle)
 {
-  API_LOCK();
-
   auto iobs = make_iob_ptr_send();
   auto iobr = make_iob_ptr_recv();
 
@@ -1949,7 +2164,7 @@ status_t Connection_handler::async_erase(const IMCAS::pool_t    pool,
     post_recv(&*iobr);
     post_send(iobs->iov, iobs->iov + 1, iobs->desc, &*iobs, msg, __func__);
 
-    out_async_handle = new async_buffer_set_simple(debug_level(), std::move(iobs), std::move(iobr));
+    out_async_handle = new async_buffer_set_simple(debug_level(), std::move(iobs), std::move(iobr), msg->request_id());
   }
   catch (const Exception &e) {
     PLOG("%s %s fail %s", __FILE__, __func__, e.cause());
@@ -1963,12 +2178,228 @@ status_t Connection_handler::async_erase(const IMCAS::pool_t    pool,
   return S_OK;
 }
 
+status_t Connection_handler::batch_exchange(const pool_t                    pool,
+                                          const protocol::OP_TYPE         op,
+                                          const std::vector<std::string> &keys,
+                                          const std::vector<std::string> *values,
+                                          std::vector<std::string> *      out_values,
+                                          std::vector<status_t> &         out_status,
+                                          const unsigned                  flags)
+{
+  out_status.assign(keys.size(), E_FAIL);
+  if (out_values) out_values->assign(keys.size(), std::string());
+
+  status_t status = S_OK;
+
+  try {
+    std::size_t next = 0;
+    while (next != keys.size()) {
+      const auto iobs = make_iob_ptr_send();
+      auto iobr = make_iob_ptr_recv();
+      assert(iobs);
+      assert(iobr);
+
+      const auto msg = new (iobs->base())
+          mcas::protocol::Message_IO_request(iobs->length(), auth_id(), request_id(), pool, op, flags);
+
+      /* pack as many records as will fit */
+      const auto first = next;
+      for (; next != keys.size(); ++next) {
+        const auto &k = keys[next];
+        const auto  v = values ? (*values)[next].data() : nullptr;
+        const auto  l = values ? (*values)[next].size() : 0;
+        if (!msg->append_batch_element(iobs->original_length(), k.data(), k.size(), v, l)) break;
+      }
+
+      if (first == next) {
+        /* a single record which can never fit */
+        PWRN("mcas_client::%s key/value length (%lu) too long.", __func__,
+             keys[next].size() + (values ? (*values)[next].size() : 0));
+        out_status[next++] = IKVStore::E_TOO_LARGE;
+        continue;
+      }
+
+      if (_options.short_circuit_backend) msg->add_scbe();
+
+      iobs->set_length(msg->msg_len());
+
+      post_recv(&*iobr);
+      sync_send(&*iobs, msg, __func__); /* this will clean up iobs */
+      wait_for_response(iobr, msg->request_id());
+
+      const auto response_msg = msg_recv<const mcas::protocol::Message_IO_response>(&*iobr, __func__);
+
+      if (response_msg->get_status() != S_OK) {
+        status = response_msg->get_status();
+        break;
+      }
+
+      /* unpack per-key results. The server may process fewer records
+         than were sent if its response filled; resend the remainder */
+      const auto count = response_msg->batch_count();
+      if (count == 0 || first + count > next)
+        throw Protocol_exception("%s: bad record count %lu in response", __func__, count);
+
+      response_records records(response_msg, iobr->original_length(), __func__);
+      for (std::size_t i = first; i != first + count; ++i) {
+        const auto e  = records.element();
+        const auto v  = records.take(e.val_len);
+        out_status[i] = e.status;
+        if (out_values) (*out_values)[i].assign(v, e.val_len);
+      }
+      next = first + count;
+    }
+  }
+  catch (const Exception &e) {
+    PLOG("%s %s fail %s", __FILE__, __func__, e.cause());
+    status = E_FAIL;
+  }
+  catch (const std::exception &e) {
+    PLOG("%s %s fail %s", __FILE__, __func__, e.what());
+    status = E_FAIL;
+  }
+
+  return status;
+}
+
+status_t Connection_handler::put_batch(const pool_t                    pool,
+                                     const std::vector<std::string> &keys,
+                                     const std::vector<std::string> &values,
+                                     std::vector<status_t> &         out_status,
+                                     const unsigned int              flags)
+{
+  if (keys.size() != values.size()) return E_INVAL;
+  return batch_exchange(pool, mcas::protocol::OP_MULTI_PUT, keys, &values, nullptr, out_status, flags);
+}
+
+status_t Connection_handler::get_batch(const pool_t                    pool,
+                                     const std::vector<std::string> &keys,
+                                     std::vector<std::string> &      out_values,
+                                     std::vector<status_t> &         out_status)
+{
+  auto status = batch_exchange(pool, mcas::protocol::OP_MULTI_GET, keys, nullptr, &out_values, out_status, 0);
+
+  /* values too large for a batch response are fetched individually */
+  if (status == S_OK) {
+    for (std::size_t i = 0; i != keys.size(); ++i) {
+      if (out_status[i] == IKVStore::E_TOO_LARGE) {
+        out_status[i] = get(pool, keys[i], out_values[i]);
+      }
+    }
+  }
+  return status;
+}
+
+status_t Connection_handler::erase_batch(const pool_t                    pool,
+                                       const std::vector<std::string> &keys,
+                                       std::vector<status_t> &         out_status)
+{
+  return batch_exchange(pool, mcas::protocol::OP_MULTI_ERASE, keys, nullptr, nullptr, out_status, 0);
+}
+
+status_t Connection_handler::scan_exchange(const pool_t               pool,
+                                         const std::string &        key_expression,
+                                         std::string &              in_out_cursor,
+                                         std::vector<std::string> & out_keys,
+                                         std::vector<std::string> * out_values,
+                                         std::vector<std::size_t> & out_deferred,
+                                         const size_t               max_keys)
+{
+  status_t status;
+
+  try {
+    const auto iobs = make_iob_ptr_send();
+    auto iobr = make_iob_ptr_recv();
+    assert(iobs);
+    assert(iobr);
+
+    const auto msg = new (iobs->base())
+        mcas::protocol::Message_IO_request(iobs->length(), auth_id(), request_id(), pool, mcas::protocol::OP_SCAN,
+                                           key_expression, in_out_cursor,
+                                           out_values ? uint32_t(mcas::protocol::SCAN_FLAG_VALUES) : 0U);
+    msg->set_scan_limit(max_keys);
+
+    iobs->set_length(msg->msg_len());
+
+    post_recv(&*iobr);
+    sync_send(&*iobs, msg, __func__); /* this will clean up iobs */
+    wait_for_response(iobr, msg->request_id());
+
+    const auto response_msg = msg_recv<const mcas::protocol::Message_IO_response>(&*iobr, __func__);
+
+    status = response_msg->get_status();
+    if (status != S_OK && status != S_MORE) return status;
+
+    response_records records(response_msg, iobr->original_length(), __func__);
+    if (status == S_MORE) records.exclude_tail(response_msg->addr);
+    for (std::size_t i = 0; i != response_msg->batch_count(); ++i) {
+      const auto e = records.element();
+      out_keys.emplace_back(records.take(e.key_len), std::size_t(e.key_len));
+      if (e.val_len == mcas::protocol::SCAN_VALUE_DEFERRED) {
+        if (out_values) {
+          out_deferred.push_back(out_values->size());
+          out_values->emplace_back();
+        }
+      }
+      else {
+        const auto v = records.take(e.val_len);
+        if (out_values) out_values->emplace_back(v, std::size_t(e.val_len));
+      }
+    }
+
+    if (status == S_MORE) in_out_cursor = response_msg->scan_cursor();
+  }
+  catch (const Exception &e) {
+    PLOG("%s %s fail %s", __FILE__, __func__, e.cause());
+    status = E_FAIL;
+  }
+  catch (const std::exception &e) {
+    PLOG("%s %s fail %s", __FILE__, __func__, e.what());
+    status = E_FAIL;
+  }
+
+  return status;
+}
+
+status_t Connection_handler::scan(const pool_t               pool,
+                                  const std::string &        key_expression,
+                                  std::string &              in_out_cursor,
+                                  std::vector<std::string> & out_keys,
+                                  std::vector<std::string> * out_values,
+                                  const size_t               max_keys)
+{
+  /* keep keys and values paired even if the caller's vectors differ in length */
+  if (out_values) out_values->resize(out_keys.size());
+
+  std::vector<std::size_t> deferred;
+  auto status = scan_exchange(pool, key_expression, in_out_cursor, out_keys, out_values, deferred, max_keys);
+  if (status != S_OK && status != S_MORE) return status;
+
+  /* values too large for the scan response, or locked at the time, are
+     fetched individually. Keys erased in the meantime are dropped */
+  if (!deferred.empty()) {
+    std::size_t erased = 0;
+    for (auto i : deferred) {
+      i -= erased;
+      auto rc = get(pool, out_keys[i], (*out_values)[i]);
+      if (rc == IKVStore::E_KEY_NOT_FOUND) {
+        out_keys.erase(out_keys.begin() + long(i));
+        out_values->erase(out_values->begin() + long(i));
+        ++erased;
+      }
+      else if (rc != S_OK)
+        return rc;
+    }
+  }
+  return status;
+}
+
 size_t Connection_handler::count(const pool_t pool)
 {
-  API_LOCK();
+  CONTROL_LOCK();
 
   const auto iobs = make_iob_ptr_send();
-  const auto iobr = make_iob_ptr_recv();
+  auto iobr = make_iob_ptr_recv();
   assert(iobs);
   assert(iobr);
 
@@ -1978,7 +2409,7 @@ size_t Connection_handler::count(const pool_t pool)
 
     post_recv(&*iobr);
     sync_inject_send(&*iobs, msg, msg->base_message_size(), __func__);
-    wait_for_completion(&*iobr);
+    wait_for_response(iobr, CONTROL_RESPONSE);
 
     const auto response_msg = msg_recv<const mcas::protocol::Message_INFO_response>(&*iobr, __func__);
 
@@ -1999,10 +2430,10 @@ status_t Connection_handler::get_attribute(const IKVStore::pool_t    pool,
                                            std::vector<uint64_t> &   out_attr,
                                            const std::string *       key)
 {
-  API_LOCK();
+  CONTROL_LOCK();
 
   const auto iobs = make_iob_ptr_send();
-  const auto iobr = make_iob_ptr_recv();
+  auto iobr = make_iob_ptr_recv();
   assert(iobs);
   assert(iobr);
 
@@ -2016,7 +2447,7 @@ status_t Connection_handler::get_attribute(const IKVStore::pool_t    pool,
     post_recv(&*iobr);
     sync_inject_send(&*iobs, msg, msg->message_size(), __func__);
 
-    wait_for_completion(&*iobr);
+    wait_for_response(iobr, CONTROL_RESPONSE);
     const auto response_msg = msg_recv<const mcas::protocol::Message_INFO_response>(&*iobr, __func__);
 
     out_attr.clear();
@@ -2036,10 +2467,10 @@ status_t Connection_handler::get_attribute(const IKVStore::pool_t    pool,
 
 status_t Connection_handler::get_statistics(IMCAS::Shard_stats &out_stats)
 {
-  API_LOCK();
+  CONTROL_LOCK();
 
   const auto iobs = make_iob_ptr_send();
-  const auto iobr = make_iob_ptr_recv();
+  auto iobr = make_iob_ptr_recv();
   assert(iobs);
   assert(iobr);
 
@@ -2052,16 +2483,91 @@ status_t Connection_handler::get_statistics(IMCAS::Shard_stats &out_stats)
     post_recv(&*iobr);
     sync_inject_send(&*iobs, msg, msg->message_size(), __func__);
 
-    wait_for_completion(&*iobr);
+    wait_for_response(iobr, CONTROL_RESPONSE);
     const auto response_msg = msg_recv<const mcas::protocol::Message_stats>(&*iobr, __func__);
 
     status = response_msg->get_status();
-#pragma GCC diagnostic push
-#if defined __clang__ || 9 <= __GNUC__
-#pragma GCC diagnostic ignored "-Waddress-of-packed-member"
-#endif
-    out_stats = response_msg->stats;
-#pragma GCC diagnostic pop
+
+    /* an older server sends fewer fields; those it does not send stay zero */
+    const auto stats_offset = sizeof *response_msg - sizeof response_msg->stats;
+    const auto stats_len = std::min(sizeof response_msg->stats,
+                                    response_msg->msg_len() < stats_offset ? 0 : response_msg->msg_len() - stats_offset);
+    out_stats = IMCAS::Shard_stats();
+    std::memcpy(&out_stats, static_cast<const char *>(static_cast<const void *>(response_msg)) + stats_offset, stats_len);
+  }
+  catch (const Exception &e) {
+    PLOG("%s %s fail %s", __FILE__, __func__, e.cause());
+    status = E_FAIL;
+  }
+  catch (const std::exception &e) {
+    PLOG("%s %s fail %s", __FILE__, __func__, e.what());
+    status = E_FAIL;
+  }
+
+  return status;
+}
+
+status_t Connection_handler::get_latency_statistics(std::vector<IMCAS::Latency_histogram> &out_histograms, bool reset)
+{
+  using namespace mcas::protocol;
+  using histogram_t = common::Log_histogram<>;
+
+  CONTROL_LOCK();
+
+  const auto iobs = make_iob_ptr_send();
+  auto iobr = make_iob_ptr_recv();
+  assert(iobs);
+  assert(iobr);
+
+  status_t status;
+  out_histograms.clear();
+
+  try {
+    const auto msg = new (iobs->base())
+        Message_INFO_request(auth_id(), INFO_TYPE_GET_STATS, 0, STATS_VERSION_LATENCY | (reset ? uint64_t(STATS_FLAG_RESET) : 0));
+
+    post_recv(&*iobr);
+    sync_inject_send(&*iobs, msg, msg->message_size(), __func__);
+
+    wait_for_response(iobr, CONTROL_RESPONSE);
+    const auto response_msg = msg_recv<const Message_stats>(&*iobr, __func__);
+
+    status = response_msg->get_status();
+    const auto hdr = response_msg->latency();
+    if (status == S_OK) {
+      /* an older server ignores the version and sends no histograms */
+      if (hdr == nullptr || hdr->version < STATS_VERSION_LATENCY) return E_NOT_SUPPORTED;
+      if (hdr->sub_bits != histogram_t::sub_bits || hdr->max_bits != histogram_t::max_bits || hdr->tsc_mhz <= 0.0) {
+        PWRN("%s: unexpected histogram shape (sub_bits %u max_bits %u)", __func__, hdr->sub_bits, hdr->max_bits);
+        return E_NOT_SUPPORTED;
+      }
+
+      const double ns_per_cycle = 1000.0 / hdr->tsc_mhz;
+      const auto   base         = static_cast<const char *>(static_cast<const void *>(response_msg));
+      std::size_t  pos          = sizeof *response_msg + sizeof *hdr;
+      auto         take         = [&](void *dst, std::size_t len) {
+        if (response_msg->msg_len() < pos + len) throw Logic_exception("truncated latency statistics");
+        std::memcpy(dst, base + pos, len);
+        pos += len;
+      };
+
+      for (unsigned r = 0; r != hdr->record_count; ++r) {
+        Message_stats::latency_record rec;
+        take(&rec, sizeof rec);
+        IMCAS::Latency_histogram h;
+        h.op     = stats_op_name(rec.op);
+        h.phase  = stats_phase_name(rec.phase);
+        h.count  = rec.count;
+        h.sum_ns = uint64_t(double(rec.sum_cycles) * ns_per_cycle);
+        for (unsigned b = 0; b != rec.bucket_count; ++b) {
+          Message_stats::latency_bucket bucket;
+          take(&bucket, sizeof bucket);
+          if (histogram_t::bucket_count <= bucket.index) throw Logic_exception("bad latency bucket index");
+          h.buckets.emplace_back(uint64_t(double(histogram_t::bucket_high(bucket.index)) * ns_per_cycle), uint64_t(bucket.count));
+        }
+        out_histograms.push_back(std::move(h));
+      }
+    }
   }
   catch (const Exception &e) {
     PLOG("%s %s fail %s", __FILE__, __func__, e.cause());
@@ -2081,10 +2587,10 @@ status_t Connection_handler::find(const IMCAS::pool_t pool,
                                   offset_t &          out_matched_offset,
                                   std::string &       out_matched_key)
 {
-  API_LOCK();
+  CONTROL_LOCK();
 
   const auto iobs = make_iob_ptr_send();
-  const auto iobr = make_iob_ptr_recv();
+  auto iobr = make_iob_ptr_recv();
   assert(iobs);
   assert(iobr);
 
@@ -2099,7 +2605,7 @@ status_t Connection_handler::find(const IMCAS::pool_t pool,
     post_recv(&*iobr);
     sync_inject_send(&*iobs, msg, msg->message_size(), __func__);
 
-    wait_for_completion(&*iobr);
+    wait_for_response(iobr, CONTROL_RESPONSE);
     const auto response_msg = msg_recv<const mcas::protocol::Message_INFO_response>(&*iobr, "FIND");
 
     status = response_msg->get_status();
@@ -2128,8 +2634,6 @@ status_t Connection_handler::invoke_ado(const IKVStore::pool_t            pool,
                                         std::vector<IMCAS::ADO_response> &out_response,
                                         const size_t                      value_size)
 {
-  API_LOCK();
-
   const auto iobs = make_iob_ptr_send();
   assert(iobs);
 
@@ -2138,18 +2642,24 @@ status_t Connection_handler::invoke_ado(const IKVStore::pool_t            pool,
         iobs->length(), auth_id(), request_id(), pool, key, request, request_len, flags, value_size);
     iobs->set_length(msg->message_size());
 
-    if (flags & IMCAS::ADO_FLAG_ASYNC) {
+    /* a request sent by reference occupies its buffer until the response,
+       which shows that the server has read it; so it cannot be async */
+    if (flags & IMCAS::ADO_FLAG_ASYNC && sent_by_reference(msg->message_size())) {
+      msg->flags &= ~uint32_t(IMCAS::ADO_FLAG_ASYNC);
+    }
+
+    if (msg->is_async()) {
       sync_send(&*iobs, msg, __func__);
       /* do not wait for response */
       return S_OK;
     }
 
-    const auto iobr = make_iob_ptr_recv();
+    auto iobr = make_iob_ptr_recv();
     assert(iobr);
 
     post_recv(&*iobr);
     sync_send(&*iobs, msg, __func__);
-    wait_for_completion(&*iobr); /* wait for response */
+    wait_for_response(iobr, msg->request_id()); /* wait for response */
 
     const auto response_msg = msg_recv<const mcas::protocol::Message_ado_response>(&*iobr, __func__);
 
@@ -2205,8 +2715,6 @@ status_t Connection_handler::invoke_ado_async(const component::IMCAS::pool_t
                                               component::IMCAS::async_handle_t &           out_async_handle,
                                               const size_t                                 value_size)
 {
-  API_LOCK();
-
   auto iobs = make_iob_ptr_send();
   auto iobr = make_iob_ptr_recv();
 
@@ -2221,7 +2729,8 @@ status_t Connection_handler::invoke_ado_async(const component::IMCAS::pool_t
     post_recv(&*iobr);
     post_send(&*iobs, msg, __func__);
 
-    out_async_handle = new async_buffer_set_invoke(debug_level(), std::move(iobs), std::move(iobr), &out_response);
+    out_async_handle =
+        new async_buffer_set_invoke(debug_level(), std::move(iobs), std::move(iobr), msg->request_id(), &out_response);
 
     return S_OK;
   }
@@ -2248,8 +2757,6 @@ status_t Connection_handler::invoke_put_ado(const IKVStore::pool_t            po
                                             const unsigned int                flags,
                                             std::vector<IMCAS::ADO_response> &out_response)
 {
-  API_LOCK();
-
   if (request_len == 0) return E_INVAL;
 
   const auto iobs = make_iob_ptr_send();
@@ -2265,18 +2772,24 @@ status_t Connection_handler::invoke_put_ado(const IKVStore::pool_t            po
 
     iobs->set_length(msg->message_size());
 
-    if (flags & IMCAS::ADO_FLAG_ASYNC) {
+    /* a request sent by reference occupies its buffer until the response,
+       which shows that the server has read it; so it cannot be async */
+    if (flags & IMCAS::ADO_FLAG_ASYNC && sent_by_reference(msg->message_size())) {
+      msg->flags &= ~uint32_t(IMCAS::ADO_FLAG_ASYNC);
+    }
+
+    if (msg->is_async()) {
       sync_send(&*iobs, msg, __func__);
       /* do not wait for response */
       return S_OK;
     }
 
-    const auto iobr = make_iob_ptr_recv();
+    auto iobr = make_iob_ptr_recv();
     assert(iobr);
 
     post_recv(&*iobr);
     sync_send(&*iobs, msg, __func__);
-    wait_for_completion(&*iobr); /* wait for response */
+    wait_for_response(iobr, msg->request_id()); /* wait for response */
 
     const auto response_msg = msg_recv<const mcas::protocol::Message_ado_response>(&*iobr, __func__);
 
@@ -2354,6 +2867,8 @@ int Connection_handler::tick()
       const auto iob = make_iob_ptr_send();
       auto       msg = new (iob->base()) mcas::protocol::Message_handshake(auth_id(), 1);
       msg->set_status(S_OK);
+      /* offer to send long messages by reference, which needs an inject send */
+      if (sizeof(mcas::protocol::Message_body_ref) <= _max_inject_size) msg->set_body_by_reference();
       iob->set_length(msg->msg_len());
       post_send(iob->iov, iob->iov + 1, iob->desc, &*iob, msg, __func__);
 
@@ -2373,13 +2888,13 @@ int Connection_handler::tick()
       break;
     }
     case HANDSHAKE_GET_RESPONSE: {
-      const auto iobr = make_iob_ptr_recv();
+      auto iobr = make_iob_ptr_recv();
       post_recv(iobr->iov, iobr->iov + 1, iobr->desc, &*iobr);
 
       try {
-        wait_for_completion(&*iobr);
+        wait_for_response(iobr, CONTROL_RESPONSE);
         const auto response_msg = msg_recv<const mcas::protocol::Message_handshake_reply>(&*iobr, "handshake");
-        (void)response_msg;
+        if (response_msg->is_body_by_reference()) set_inline_limit(response_msg->max_message_size);
       }
       catch (...) {
         PERR("%s %s handshake response failed", __FILE__, __func__);
@@ -31,17 +31,12 @@
 #include <set>
 #include <tuple>
 
-/* Enable this to introduce locks to prevent re-entry by multiple
-   threads.  The client is not re-entrant because of the state machine
-   and multi-packet operations
+/* Responses to pool, info and stats requests carry no request id, so
+   they are all routed as Fabric_transport::CONTROL_RESPONSE and only one
+   such request may be outstanding at a time. Other requests are routed
+   by request id and may be issued concurrently by any number of threads.
 */
-#define THREAD_SAFE_CLIENT
-
-#ifdef THREAD_SAFE_CLIENT
-#define API_LOCK() std::lock_guard<std::mutex> g(_api_lock);
-#else
-#define API_LOCK()
-#endif
+#define CONTROL_LOCK() std::lock_guard<std::mutex> g(_control_lock);
 
 namespace mcas
 {
@@ -60,10 +55,10 @@ using Connection_base = mcas::client::Fabric_transport;
  *
  */
 class Connection_handler : public Connection_base {
-  using iob_ptr        = std::unique_ptr<client::Fabric_transport::buffer_t, iob_free>;
   using locate_element = protocol::Message_IO_response::locate_element;
 
  public:
+  using iob_ptr         = std::unique_ptr<client::Fabric_transport::buffer_t, iob_free>;
   using memory_region_t = typename Transport::memory_region_t;
 
   /**
@@ -174,8 +169,16 @@ class Connection_handler : public Connection_base {
                             component::IKVStore::memory_handle_t handle = component::IMCAS::MEMORY_HANDLE_NONE,
                             unsigned int                         flags  = component::IMCAS::FLAGS_NONE);
 
+  status_t async_get(const pool_t                      pool,
+                     const std::string &               key,
+                     void *&                           value,
+                     size_t &                          value_len,
+                     component::IMCAS::async_handle_t &out_handle);
+
   status_t check_async_completion(component::IMCAS::async_handle_t &handle);
 
+  status_t free_memory(void *p);
+
   status_t get(const pool_t pool, const std::string &key, std::string &value);
 
   status_t get(const pool_t pool, const std::string &key, void *&value, size_t &value_len);
@@ -224,6 +227,26 @@ class Connection_handler : public Connection_base {
                        const std::string &               key,
                        component::IMCAS::async_handle_t &out_handle);
 
+  status_t put_batch(const pool_t                    pool,
+                     const std::vector<std::string> &keys,
+                     const std::vector<std::string> &values,
+                     std::vector<status_t> &         out_status,
+                     const unsigned int              flags);
+
+  status_t get_batch(const pool_t                    pool,
+                     const std::vector<std::string> &keys,
+                     std::vector<std::string> &      out_values,
+                     std::vector<status_t> &         out_status);
+
+  status_t erase_batch(const pool_t pool, const std::vector<std::string> &keys, std::vector<status_t> &out_status);
+
+  status_t scan(const pool_t               pool,
+                const std::string &        key_expression,
+                std::string &              in_out_cursor,
+                std::vector<std::string> & out_keys,
+                std::vector<std::string> * out_values,
+                const size_t               max_keys);
+
   uint64_t key_hash(const void *key, const size_t key_len);
 
   uint64_t auth_id() const
@@ -251,6 +274,8 @@ class Connection_handler : public Connection_base {
 
   status_t get_statistics(component::IMCAS::Shard_stats &out_stats);
 
+  status_t get_latency_statistics(std::vector<component::IMCAS::Latency_histogram> &out_histograms, bool reset);
+
   status_t find(const component::IKVStore::pool_t pool,
                 const std::string &               key_expression,
                 const offset_t                    offset,
@@ -347,14 +372,20 @@ class Connection_handler : public Connection_base {
 
   template <typename MT>
     MT *msg_recv(const buffer_t *iob, const char *desc)
+    {
+      return msg_recv<MT>(iob->base(), iob, desc);
+    }
+
+  template <typename MT>
+    MT *msg_recv(const void *base, const void *context, const char *desc)
     {
       /*
        * First, cast the response buffer to Message (checking version).
        * Second, cast the Message to a specific message type (checking message type).
        */
-      const auto *const msg = mcas::protocol::message_cast(iob->base());
+      const auto *const msg = mcas::protocol::message_cast(base);
       const auto *const response_msg = msg->ptr_cast<MT>();
-      msg_recv_log(response_msg, iob, desc);
+      msg_recv_log(response_msg, context, desc);
       return response_msg;
     }
 
@@ -443,11 +474,54 @@ class Connection_handler : public Connection_base {
                                                     void *                              desc,
                                                     unsigned                            flags);
 
+  /**
+   * Exchange OP_MULTI_xxx messages until every key has a status. Records
+   * are packed into as few IO buffers as possible.
+   *
+   * @param pool Pool identifier
+   * @param op OP_MULTI_GET, OP_MULTI_PUT or OP_MULTI_ERASE
+   * @param keys Keys
+   * @param values Values (OP_MULTI_PUT only, else nullptr)
+   * @param out_values Returned values (OP_MULTI_GET only, else nullptr)
+   * @param out_status Per-key status
+   * @param flags Flags passed to the store (OP_MULTI_PUT only)
+   *
+   * @return S_OK or error code
+   */
+  status_t batch_exchange(pool_t                          pool,
+                          protocol::OP_TYPE               op,
+                          const std::vector<std::string> &keys,
+                          const std::vector<std::string> *values,
+                          std::vector<std::string> *      out_values,
+                          std::vector<status_t> &         out_status,
+                          unsigned                        flags);
+
+  /**
+   * One OP_SCAN round trip
+   *
+   * @param pool Pool handle
+   * @param key_expression Scan expression
+   * @param in_out_cursor Resume point, updated on S_MORE
+   * @param out_keys Keys (appended)
+   * @param out_values Values (appended), or nullptr for keys only
+   * @param out_deferred Indices in out_values of values not returned inline
+   * @param max_keys Maximum number of keys, 0 for no limit
+   *
+   * @return S_OK (scan complete), S_MORE or error code
+   */
+  status_t scan_exchange(pool_t                     pool,
+                         const std::string &        key_expression,
+                         std::string &              in_out_cursor,
+                         std::vector<std::string> & out_keys,
+                         std::vector<std::string> * out_values,
+                         std::vector<std::size_t> & out_deferred,
+                         size_t                     max_keys);
+
   iob_ptr make_iob_ptr(buffer_t::completion_t);
-  iob_ptr make_iob_ptr_recv();
   iob_ptr make_iob_ptr_send();
 
  public:
+  iob_ptr make_iob_ptr_recv();
   iob_ptr make_iob_ptr_write();
   iob_ptr make_iob_ptr_read();
 
@@ -473,18 +547,35 @@ class Connection_handler : public Connection_base {
                                                            component::Registrar_memory_direct *rmd,
                                                            void *                              desc);
 
- private:
-#ifdef THREAD_SAFE_CLIENT
-  std::mutex _api_lock;
-#endif
+ public: /* for async "move_along" processing */
+  using Connection_base::test_response;
+  using Connection_base::wait_for_response;
 
-  bool     _exit;
-  uint64_t _request_id;
+  /**
+   * Wait for the response to a request, leaving it in iobr. If the
+   * response was received into another buffer, the buffer in iobr stays
+   * posted (and will receive some other response) and iobr takes over
+   * the buffer which holds this one. That may be a receive slab, which
+   * goes back to the slab pool when iobr frees it.
+   *
+   * @param iobr Receive buffer posted for the request
+   * @param request_id Request id, or CONTROL_RESPONSE
+   */
+  void wait_for_response(iob_ptr &iobr, std::uint64_t request_id);
 
- public: /* for async "move_along" processing */
-  uint64_t request_id() { return ++_request_id; }
+  /**
+   * Test for the response to a request, leaving it in iobr (see wait_for_response)
+   *
+   * @return True iff the response has arrived
+   */
+  bool test_response(iob_ptr &iobr, std::uint64_t request_id);
 
  private:
+  void adopt_response(iob_ptr &iobr, const response_t &response);
+
+  std::mutex _control_lock;
+  bool       _exit;
+
   size_t _max_message_size;
   size_t _max_inject_size;
 
@@ -13,12 +13,112 @@
 
 #include "fabric_transport.h"
 
+#include "protocol.h"
+
 #include <common/cycles.h>
+#include <common/utils.h> /* cpu_relax */
+
+#include <algorithm> /* remove_if */
+#include <limits>
+#include <utility>   /* pair */
+
+namespace
+{
+std::uint64_t next_transport_id()
+{
+  static std::atomic<std::uint64_t> id{0};
+  return ++id;
+}
+
+/* key under which a response is published: its request id, if it has one */
+std::uint64_t response_key(const void *base)
+{
+  const auto msg = mcas::protocol::message_cast(base);
+  switch (msg->type_id()) {
+  case mcas::protocol::MSG_TYPE_IO_RESPONSE:
+  case mcas::protocol::MSG_TYPE_ADO_RESPONSE:
+    return static_cast<const mcas::protocol::Message_numbered_response *>(msg)->request_id();
+  default:
+    return mcas::client::Fabric_transport::CONTROL_RESPONSE;
+  }
+}
+
+/* true if the server answers the request with a numbered response */
+bool is_numbered_request(const void *base)
+{
+  switch (mcas::protocol::message_cast(base)->type_id()) {
+  case mcas::protocol::MSG_TYPE_IO_REQUEST:
+  case mcas::protocol::MSG_TYPE_ADO_REQUEST:
+  case mcas::protocol::MSG_TYPE_PUT_ADO_REQUEST:
+    return true;
+  default:
+    return false;
+  }
+}
+
+/* a two-stage get response, whose value follows as the next message */
+bool is_twostage(const void *base)
+{
+  const auto msg = mcas::protocol::message_cast(base);
+  return msg->type_id() == mcas::protocol::MSG_TYPE_IO_RESPONSE &&
+         static_cast<const mcas::protocol::Message_IO_response *>(msg)->is_set_twostage_bit();
+}
+}  // namespace
 
 namespace mcas
 {
 namespace client
 {
+namespace
+{
+/* Transports which exist, by id. An exiting thread releases its contexts
+ * only to transports still listed, and a transport delists itself under
+ * the same lock, so it is not destroyed during a release.
+ */
+std::mutex &live_transports_lock()
+{
+  static std::mutex m;
+  return m;
+}
+
+std::map<std::uint64_t, Fabric_transport *> &live_transports()
+{
+  static std::map<std::uint64_t, Fabric_transport *> m;
+  return m;
+}
+}  // namespace
+
+struct Fabric_transport::thread_exit {
+  std::vector<std::pair<std::uint64_t, thread_context *>> held; /*< by transport id */
+
+  thread_exit() : held() {}
+  thread_exit(const thread_exit &) = delete;
+  thread_exit &operator=(const thread_exit &) = delete;
+
+  void add(std::uint64_t transport_id, thread_context *c)
+  {
+    std::lock_guard<std::mutex> g(live_transports_lock());
+    /* forget contexts of transports since destroyed */
+    const auto &live = live_transports();
+    held.erase(std::remove_if(held.begin(), held.end(),
+                              [&live](const std::pair<std::uint64_t, thread_context *> &h) {
+                                return live.find(h.first) == live.end();
+                              }),
+               held.end());
+    held.emplace_back(transport_id, c);
+  }
+
+  ~thread_exit()
+  {
+    std::lock_guard<std::mutex> g(live_transports_lock());
+    const auto &live = live_transports();
+    for (const auto &h : held) {
+      auto it = live.find(h.first);
+      if (it != live.end()) it->second->release_context(h.second);
+    }
+  }
+};
+
 Fabric_transport::Fabric_transport(unsigned                   debug_level_,
                                    component::IFabric_client *fabric_connection,
                                    unsigned                   patience_)
@@ -26,37 +126,112 @@ Fabric_transport::Fabric_transport(unsigned                   debug_level_,
       cycles_per_second(common::get_rdtsc_frequency_mhz() * 1000000.0),
       _transport(fabric_connection),
       _max_inject_size(_transport->max_inject_size()),
-      _bm(debug_level(), fabric_connection, NUM_BUFFERS),
-      _patience(patience_)
+      _patience(patience_),
+      _inline_limit(std::numeric_limits<std::size_t>::max()),
+      _id(next_transport_id()),
+      _contexts_lock(),
+      _contexts(),
+      _context_of(),
+      _idle_contexts(),
+      _spill_lock(),
+      _spill(),
+      _poll_lock(),
+      _completions(),
+      _continuation(0),
+      _recv_slabs_lock(),
+      _recv_slabs(nullptr),
+      _body_refs_lock(),
+      _body_refs()
+{
+  std::lock_guard<std::mutex> g(live_transports_lock());
+  live_transports().emplace(_id, this);
+}
+
+Fabric_transport::~Fabric_transport()
 {
+  {
+    std::lock_guard<std::mutex> g(live_transports_lock());
+    live_transports().erase(_id);
+  }
+  delete _recv_slabs.load();
 }
 
-component::IFabric_op_completer::cb_acceptance Fabric_transport::completion_callback(void *        context,
-                                                                                     status_t      st,
-                                                                                     std::uint64_t completion_flags,
-                                                                                     std::size_t,  // len
-                                                                                     void *,       // error_data
-                                                                                     void *param)
+void Fabric_transport::dispatch_completion(void *        context,
+                                           status_t      st,
+                                           std::uint64_t completion_flags,
+                                           std::size_t   len,
+                                           void *,  // error_data
+                                           void *param)
 {
+  auto t = static_cast<Fabric_transport *>(param);
   if (UNLIKELY(st != S_OK)) {
-    // throw General_exception("poll_completions failed unexpectedly (st=%d)
-    // (cf=%lx)", st, completion_flags);
-    PWRN("poll_completions failed unexpectedly (context/got=%p) (param/wanted=%p) (st=%d) (cf=%lx)", context, param, st, completion_flags);
-    return component::IFabric_op_completer::cb_acceptance::ACCEPT;
+    PWRN("poll_completions failed unexpectedly (context=%p) (st=%d) (cf=%lx)", context, st, completion_flags);
+    return;
   }
 
-  if (*(static_cast<void **>(param)) == context) {
+  if (completion_flags & FI_RECV) {
+    /* route a response by its request id: the receive buffer may have been posted by any thread */
+    const void *  base = static_cast<buffer_t *>(context)->base().get();
+    std::uint64_t key;
+    if (t->_continuation) {
+      key               = continuation_key(t->_continuation);
+      t->_continuation = 0;
+    }
+    else {
+      key = response_key(base);
+      if (is_twostage(base)) t->_continuation = key;
+    }
     if (1 < mcas::global::debug_level) {
-      PLOG("COMPletion %p(wanted/got) accept", context);
+      PLOG("COMPletion recv %p request %" PRIx64, context, key);
     }
-    *static_cast<void **>(param) = nullptr; /* signals completion */
-    return component::IFabric_op_completer::cb_acceptance::ACCEPT;
+    if (t->_inline_limit != std::numeric_limits<std::size_t>::max()) t->release_body_ref(key);
+    t->_completions.publish(key, context, len);
   }
   else {
     if (1 < mcas::global::debug_level) {
-      PLOG("COMPletion got %p(want) != %p(got)  defer", *static_cast<void **>(param), context);
+      PLOG("COMPletion %p", context);
     }
-    return component::IFabric_op_completer::cb_acceptance::DEFER;
+    t->_completions.publish(reinterpret_cast<std::uint64_t>(context), context, len);
+  }
+}
+
+void Fabric_transport::send_by_reference(const ::iovec *first, const ::iovec *last, void *context)
+{
+  const auto iob = static_cast<buffer_t *>(context);
+  if (last - first != 1 || first->iov_base != iob->base().get() || !is_numbered_request(first->iov_base))
+    throw Logic_exception("%s: message (%zu bytes) cannot be sent by reference", __func__, first->iov_len);
+
+  const auto msg        = protocol::message_cast(first->iov_base);
+  const auto request_id = static_cast<const protocol::Message_numbered_request *>(msg)->request_id();
+  {
+    std::lock_guard<std::mutex> g(_body_refs_lock);
+    _body_refs.emplace(request_id, context);
+  }
+
+  protocol::Message_body_ref ref(msg->auth_id(), reinterpret_cast<std::uint64_t>(first->iov_base),
+                                 _transport->get_memory_remote_key(iob->region()), first->iov_len);
+  CPLOG(2, "%s request %" PRIx64 " len %zu", __func__, request_id, first->iov_len);
+  _transport->inject_send(&ref, sizeof ref);
+}
+
+void Fabric_transport::release_body_ref(std::uint64_t request_id)
+{
+  std::lock_guard<std::mutex> g(_body_refs_lock);
+  auto it = _body_refs.find(request_id);
+  if (it != _body_refs.end()) {
+    _completions.publish(reinterpret_cast<std::uint64_t>(it->second), it->second, 0);
+    _body_refs.erase(it);
+  }
+}
+
+void Fabric_transport::poll()
+{
+  std::unique_lock<std::mutex> g(_poll_lock, std::try_to_lock);
+  if (g.owns_lock()) {
+    _transport->poll_completions(dispatch_completion, this);
+  }
+  else {
+    cpu_relax();
   }
 }
 
@@ -67,17 +242,154 @@ component::IFabric_op_completer::cb_acceptance Fabric_transport::completion_call
  */
 void Fabric_transport::wait_for_completion(void *wr)
 {
-  CPLOG(1, "%s %p:%p", __func__, wr, *static_cast<void **>(wr));
+  CPLOG(1, "%s %p", __func__, wr);
 
+  response_t r;
   auto start_time = rdtsc();
   // currently setting time out to 2 min...
-  while (wr && static_cast<double>(rdtsc() - start_time) / cycles_per_second <= _patience) {
-    _transport->poll_completions_tentative(completion_callback, &wr);
+  while (!_completions.claim(reinterpret_cast<std::uint64_t>(wr), r)) {
+    if (static_cast<double>(rdtsc() - start_time) / cycles_per_second > _patience)
+      throw Program_exception("time out: start_time %" PRIu64 ", now %" PRIu64 " waited %lu seconds for completion",
+                              start_time, rdtsc(), _patience);
+    poll();
+  }
+}
+
+bool Fabric_transport::test_completion(void *wr)
+{
+  response_t r;
+  const auto key = reinterpret_cast<std::uint64_t>(wr);
+  if (_completions.claim(key, r)) return true;
+  poll();
+  return _completions.claim(key, r);
+}
+
+auto Fabric_transport::wait_for_response(std::uint64_t request_id_) -> response_t
+{
+  CPLOG(1, "%s %" PRIx64, __func__, request_id_);
+
+  response_t r;
+  auto start_time = rdtsc();
+  while (!_completions.claim(request_id_, r)) {
+    if (static_cast<double>(rdtsc() - start_time) / cycles_per_second > _patience)
+      throw Program_exception("time out: start_time %" PRIu64 ", now %" PRIu64 " waited %lu seconds for response",
+                              start_time, rdtsc(), _patience);
+    poll();
+  }
+  return r;
+}
+
+bool Fabric_transport::test_response(std::uint64_t request_id_, response_t &out_response)
+{
+  if (_completions.claim(request_id_, out_response)) return true;
+  poll();
+  return _completions.claim(request_id_, out_response);
+}
+
+auto Fabric_transport::this_thread_context() -> thread_context &
+{
+  /* one-entry cache; a thread alternating between transports takes the lock */
+  struct cache_t {
+    std::uint64_t   transport_id;
+    thread_context *context;
+  };
+  static thread_local cache_t cache{0, nullptr};
+
+  if (UNLIKELY(cache.transport_id != _id)) {
+    thread_context *c;
+    bool            is_new;
+    {
+      std::lock_guard<std::mutex> g(_contexts_lock);
+      auto &                      cp = _context_of[std::this_thread::get_id()];
+      is_new                         = !cp;
+      if (is_new) {
+        if (!_idle_contexts.empty()) {
+          /* an exited thread's: its request ids continue where that thread's ended */
+          cp = _idle_contexts.back();
+          _idle_contexts.pop_back();
+        }
+        else {
+          const std::uint64_t slot = _contexts.size() + 1;
+          _contexts.emplace_back(std::make_unique<thread_context>(
+              debug_level(), _transport, slot == 1 ? NUM_BUFFERS : NUM_THREAD_BUFFERS, slot << REQUEST_ID_SHIFT));
+          cp = _contexts.back().get();
+        }
+      }
+      c = cp;
+    }
+    if (is_new) {
+      static thread_local thread_exit exit;
+      exit.add(_id, c);
+    }
+    cache = cache_t{_id, c};
+  }
+  return *cache.context;
+}
+
+void Fabric_transport::release_context(thread_context *c)
+{
+  /* The buffers belong to the context's buffer manager, which lives on
+   * with the context; the free ones are shared until it is reused.
+   */
+  {
+    std::lock_guard<std::mutex> g(_spill_lock);
+    _spill.insert(_spill.end(), c->free.begin(), c->free.end());
   }
+  c->free.clear();
+
+  std::lock_guard<std::mutex> g(_contexts_lock);
+  _context_of.erase(std::this_thread::get_id());
+  _idle_contexts.push_back(c);
+}
 
-  if (wr)
-    throw Program_exception("time out: start_time %" PRIu64 ", now %" PRIu64 " waited %lu seconds for completion",
-      start_time, rdtsc(), _patience);
+auto Fabric_transport::allocate(buffer_t::completion_t c) -> buffer_t *
+{
+  auto &t = this_thread_context();
+  if (UNLIKELY(t.free.empty())) {
+    std::lock_guard<std::mutex> g(_spill_lock);
+    if (_spill.empty()) throw Program_exception("Fabric_transport: no IO buffers remaining");
+    t.free.push_back(_spill.back());
+    _spill.pop_back();
+  }
+  auto iob = t.free.back();
+  t.free.pop_back();
+  iob->reset_length();
+  iob->set_completion(c);
+  return iob;
+}
+
+void Fabric_transport::free_buffer(buffer_t *iob)
+{
+  assert(iob);
+  if (is_recv_slab(iob->base())) {
+    /* a slab, which took a response for this thread */
+    release_recv_slab(iob->base());
+    return;
+  }
+  /* a buffer may be freed by a thread other than the one which allocated it */
+  auto &t = this_thread_context();
+  iob->reset_length();
+  if (UNLIKELY(t.free.size() >= t.quota)) {
+    std::lock_guard<std::mutex> g(_spill_lock);
+    _spill.push_back(iob);
+  }
+  else {
+    t.free.push_back(iob);
+  }
+}
+
+Recv_slab_pool *Fabric_transport::recv_slabs()
+{
+  auto slabs = _recv_slabs.load(std::memory_order_acquire);
+  if (!slabs) {
+    std::lock_guard<std::mutex> g(_recv_slabs_lock);
+    slabs = _recv_slabs.load(std::memory_order_relaxed);
+    if (!slabs) {
+      slabs = new Recv_slab_pool(debug_level(), _transport, NUM_RECV_SLABS);
+      _recv_slabs.store(slabs, std::memory_order_release);
+    }
+  }
+  return slabs;
 }
 
 }  // namespace client
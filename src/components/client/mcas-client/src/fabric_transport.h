@@ -16,18 +16,41 @@
 #include "mcas_client_config.h"
 
 #include "buffer_manager.h" /* Buffer_manager */
+#include "completion_table.h"
+#include "recv_slab_pool.h"
 
 #include <api/fabric_itf.h> /* IFabric_client, IFabric_memory_region, IFabric_op_completer. IKVStore */
 #include <common/destructible.h>
 #include <common/exceptions.h>
+#include <atomic>
 #include <iterator> /* begin, end */
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace mcas
 {
 using memory_registered_fabric = memory_registered<component::IFabric_client>;
 namespace client
 {
-static constexpr size_t NUM_BUFFERS = 64; /* defines max outstanding */
+static constexpr size_t NUM_BUFFERS        = 64; /* defines max outstanding (first thread) */
+static constexpr size_t NUM_THREAD_BUFFERS = 16; /* IO buffers for each further thread */
+
+/*
+ * Several application threads may share one transport. Each thread has
+ * its own IO buffers and request id space (the thread's slot number in the
+ * top bits, so that ids are unique and never equal a context pointer).
+ * No thread waits on another to poll: whichever thread finds the poll lock
+ * free polls for all, publishing each completion to a table keyed by work
+ * request context, or by request id for a response, from which the waiting
+ * thread claims it.
+ *
+ * When a thread exits, its free IO buffers go to the spill list and its
+ * context (slot, request id space and buffer manager) is kept for the next
+ * new thread, so that contexts are bounded by the threads alive at once.
+ */
 
 class Fabric_transport : protected common::log_source {
   friend struct mcas_client;
@@ -52,14 +75,19 @@ class Fabric_transport : protected common::log_source {
   Fabric_transport(const Fabric_transport &) = delete;
   Fabric_transport &operator=(const Fabric_transport &) = delete;
 
-  ~Fabric_transport() {}
+  ~Fabric_transport();
+
+  /* request id under which responses without a request id (pool, info, stats, handshake) are routed */
+  static constexpr std::uint64_t CONTROL_RESPONSE = 1;
+  static constexpr unsigned      REQUEST_ID_SHIFT = 48;
 
-  static component::IFabric_op_completer::cb_acceptance completion_callback(void *        context,
-                                                                            status_t      st,
-                                                                            std::uint64_t completion_flags,
-                                                                            std::size_t,  // len
-                                                                            void *,       // error_data
-                                                                            void *param);
+  /* The value of a two-stage get arrives as a message of its own, with no
+   * header. It is the next message received after the response header, and
+   * is routed under this key.
+   */
+  static constexpr std::uint64_t continuation_key(std::uint64_t request_id) { return request_id | CONTINUATION_BIT; }
+
+  using response_t = Completion_table::entry_t;
 
   /**
    * Wait for completion of a IO buffer posting
@@ -75,14 +103,36 @@ class Fabric_transport : protected common::log_source {
    *
    * @return True iff complete
    */
-  inline bool test_completion(void *wr)
-  {
-    _transport->poll_completions_tentative(completion_callback, &wr);
-    return (wr == nullptr);
-  }
+  bool test_completion(void *wr);
 
   /**
-   * Forwarders that allow us to avoid exposing _transport and _bm
+   * Wait for the response to a request. The response is received into
+   * whichever receive buffer the fabric took next, which need not be the
+   * one posted by this thread.
+   *
+   * @param request_id Request id, or CONTROL_RESPONSE
+   *
+   * @return Receive context (IO buffer, perhaps a slab) holding the response, and its length
+   */
+  response_t wait_for_response(std::uint64_t request_id);
+
+  /**
+   * Test for the response to a request
+   *
+   * @param request_id Request id, or CONTROL_RESPONSE
+   * @param out_response Receive context holding the response, and its length
+   *
+   * @return True iff the response has arrived
+   */
+  bool test_response(std::uint64_t request_id, response_t &out_response);
+
+  /**
+   * Next request id of the calling thread
+   */
+  std::uint64_t request_id() { return ++this_thread_context().request_id; }
+
+  /**
+   * Forwarders that allow us to avoid exposing _transport
    *
    */
   auto inline make_memory_registered(void *base, size_t len)
@@ -101,11 +151,27 @@ class Fabric_transport : protected common::log_source {
 
   inline void deregister_memory(memory_region_t region) { _transport->deregister_memory(region); }
 
+  /* Post a send. A message longer than the server's inline limit goes by
+   * reference (see protocol::Message_body_ref): its send completes when its
+   * response arrives, since the server reads it until then.
+   */
   inline void post_send(const ::iovec *first, const ::iovec *last, void **descriptors, void *context)
   {
-    _transport->post_send(first, last, descriptors, context);
+    std::size_t len = 0;
+    for (auto i = first; i != last; ++i) len += i->iov_len;
+    if (UNLIKELY(sent_by_reference(len))) {
+      send_by_reference(first, last, context);
+    }
+    else {
+      _transport->post_send(first, last, descriptors, context);
+    }
   }
 
+  /* Limit, set by the handshake, above which messages are sent by reference */
+  void set_inline_limit(std::size_t limit) { _inline_limit = limit; }
+
+  bool sent_by_reference(std::size_t len) const { return _inline_limit < len; }
+
   inline void post_recv(const ::iovec *first, const ::iovec *last, void **descriptors, void *context)
   {
     CPLOG(2, "%s (%p): IOV count %zu first %p:%zx", __func__, context, std::size_t(last - first), first->iov_base, first->iov_len);
@@ -242,14 +308,91 @@ class Fabric_transport : protected common::log_source {
     return S_OK;
   }
 
-  inline auto allocate(buffer_t::completion_t c) { return _bm.allocate(c); }
-  inline void free_buffer(buffer_t *buffer) { _bm.free(buffer); }
+  /* IO buffers come from, and return to, the calling thread's pool (slabs to the slab pool) */
+  buffer_t *allocate(buffer_t::completion_t c);
+  void      free_buffer(buffer_t *buffer);
+
+  /* Receive slabs, created on first use */
+  Recv_slab_pool *recv_slabs();
+
+  bool is_recv_slab(const void *p) const
+  {
+    const auto slabs = _recv_slabs.load(std::memory_order_acquire);
+    return slabs && slabs->slab_of(p);
+  }
+
+  /* return a slab, given any address within it */
+  void release_recv_slab(const void *p)
+  {
+    const auto slabs = _recv_slabs.load(std::memory_order_acquire);
+    slabs->free(slabs->slab_of(p));
+  }
+
+ private:
+  /* state of one application thread */
+  struct thread_context {
+    thread_context(unsigned debug_level_, Transport *transport_, std::size_t buffer_count_, std::uint64_t request_id_)
+        : bm(debug_level_, transport_, buffer_count_),
+          free(),
+          quota(buffer_count_),
+          request_id(request_id_)
+    {
+      free.reserve(buffer_count_);
+      for (std::size_t i = 0; i != buffer_count_; ++i) free.push_back(bm.allocate(nullptr));
+    }
+    Buffer_manager<Transport> bm;         /*< owns the thread's IO buffers */
+    std::vector<buffer_t *>   free;       /*< free IO buffers */
+    std::size_t               quota;      /*< free buffers beyond this are spilled */
+    std::uint64_t             request_id; /*< last request id */
+  };
+
+  thread_context &this_thread_context();
+
+  /* the contexts a thread holds, released when the thread exits */
+  struct thread_exit;
+
+  /* return the context of an exiting thread, for reuse */
+  void release_context(thread_context *c);
+
+  /* poll, unless another thread is already polling */
+  void poll();
+
+  /* send, by reference, a message which lies in one IO buffer (the context) */
+  void send_by_reference(const ::iovec *first, const ::iovec *last, void *context);
+
+  /* complete the send of the message, if any, sent by reference and answered by the response to request_id */
+  void release_body_ref(std::uint64_t request_id);
+
+  static void dispatch_completion(void *        context,
+                                  status_t      st,
+                                  std::uint64_t completion_flags,
+                                  std::size_t   len,
+                                  void *        error_data,
+                                  void *        param);
 
  protected:
-  Transport *               _transport;
-  size_t                    _max_inject_size;
-  Buffer_manager<Transport> _bm;          /*< IO buffer manager */
-  unsigned                  _patience;  // in seconds
+  Transport * _transport;
+  size_t      _max_inject_size;
+  unsigned    _patience;  // in seconds
+  std::size_t _inline_limit;
+
+ private:
+  static constexpr std::uint64_t CONTINUATION_BIT = std::uint64_t(1) << 63; /* above any slot */
+
+  const std::uint64_t                          _id; /*< distinguishes transports in the per-thread cache */
+  std::mutex                                   _contexts_lock;
+  std::vector<std::unique_ptr<thread_context>> _contexts;
+  std::map<std::thread::id, thread_context *>  _context_of;
+  std::vector<thread_context *>                _idle_contexts; /*< of exited threads, for reuse */
+  std::mutex                                   _spill_lock;
+  std::vector<buffer_t *>                      _spill; /*< IO buffers which migrated to a thread above its quota */
+  std::mutex                                   _poll_lock;
+  Completion_table                             _completions;
+  std::uint64_t                                _continuation; /*< request whose value is received next, or 0 (poll lock) */
+  std::mutex                                   _recv_slabs_lock;
+  std::atomic<Recv_slab_pool *>                _recv_slabs; /*< owned */
+  std::mutex                                   _body_refs_lock;
+  std::map<std::uint64_t, void *>              _body_refs; /*< send context of a message sent by reference, by request id */
 };
 
 }  // namespace client
@@ -40,7 +40,7 @@ MCAS_client::MCAS_client(const unsigned                      debug_level,
                          std::uint16_t                       port,
                          const unsigned                      patience_)
     : _debug(debug_level, this, dest_addr, port),
-      _factory(load_factory()),
+      _factory(load_factory(provider)),
       _fabric(make_fabric(*_factory, src_addr, src_device, provider)),
       _transport(_fabric->open_client(common::json::serializer<common::json::dummy_writer>::object{}.str(), dest_addr, port)),
       _connection(std::make_unique<mcas::client::Connection_handler>(debug_level, _transport.get(), patience_)),
@@ -75,9 +75,11 @@ Open_connection::~Open_connection()
   PLOG("%s %p", __func__, static_cast<void *>(this));
 }
 
-auto MCAS_client::load_factory() -> IFabric_factory *
+auto MCAS_client::load_factory(const boost::optional<std::string> &fabric_prov_name_) -> IFabric_factory *
 {
-  IBase *comp = load_component("libcomponent-fabric.so", net_fabric_factory);
+  IBase *comp = is_uring(fabric_prov_name_) ? load_component("libcomponent-uring.so", net_uring_factory)
+              : is_shm(fabric_prov_name_)   ? load_component("libcomponent-shm.so", net_shm_factory)
+                                            : load_component("libcomponent-fabric.so", net_fabric_factory);
 
   if (!comp) throw General_exception("Fabric component not found");
 
@@ -93,6 +95,24 @@ auto MCAS_client::make_fabric(component::IFabric_factory &        factory_,
 {
   namespace c_json = common::json;
   using json = c_json::serializer<c_json::dummy_writer>;
+
+  /* shm: shared memory with a server on this host, found by port alone */
+  if ( is_shm(fabric_prov_name_) )
+  {
+    return factory_.make_fabric(json::object().str());
+  }
+
+  /* uring: plain TCP, so no endpoint type, address format or domain */
+  if ( is_uring(fabric_prov_name_) )
+  {
+    auto uring_spec = json::object();
+    if ( src_addr_ )
+    {
+      uring_spec.append(json::member("src_addr", *src_addr_));
+    }
+    return factory_.make_fabric(uring_spec.str());
+  }
+
   auto fabric_spec =
     json::object(
       json::member("ep_attr", json::object(json::member("type", "FI_EP_MSG")))
@@ -177,7 +197,7 @@ auto MCAS_client::make_fabric(component::IFabric_factory &factory_,
   return factory_.make_fabric(fabric_spec.str());
 }
 
-int MCAS_client::thread_safety() const { return IKVStore::THREAD_MODEL_SINGLE_PER_POOL; }
+int MCAS_client::thread_safety() const { return IKVStore::THREAD_MODEL_MULTI_PER_POOL; }
 
 int MCAS_client::get_capability(Capability cap) const
 {
@@ -262,6 +282,15 @@ status_t MCAS_client::async_put_direct(const IKVStore::pool_t          pool,
   return _connection->async_put_direct(pool, key.data(), key.size(), value, value_len, out_handle, this, handle, flags);
 }
 
+status_t MCAS_client::async_get(const IKVStore::pool_t pool,
+                                const std::string &    key,
+                                void *&                out_value,
+                                size_t &               out_value_len,
+                                async_handle_t &       out_handle)
+{
+  return _connection->async_get(pool, key, out_value, out_value_len, out_handle);
+}
+
 status_t MCAS_client::async_get_direct(IKVStore::pool_t          pool,
                                        const std::string &       key,
                                        void *                    value,
@@ -363,6 +392,41 @@ status_t MCAS_client::async_erase(const IMCAS::pool_t pool, const std::string &k
   return _connection->async_erase(pool, key, out_handle);
 }
 
+status_t MCAS_client::put_batch(const IMCAS::pool_t             pool,
+                                const std::vector<std::string> &keys,
+                                const std::vector<std::string> &values,
+                                std::vector<status_t> &         out_status,
+                                const unsigned int              flags)
+{
+  assert(flags <= IMCAS::FLAGS_MAX_VALUE);
+  return _connection->put_batch(pool, keys, values, out_status, flags);
+}
+
+status_t MCAS_client::get_batch(const IMCAS::pool_t             pool,
+                                const std::vector<std::string> &keys,
+                                std::vector<std::string> &      out_values,
+                                std::vector<status_t> &         out_status)
+{
+  return _connection->get_batch(pool, keys, out_values, out_status);
+}
+
+status_t MCAS_client::erase_batch(const IMCAS::pool_t             pool,
+                                  const std::vector<std::string> &keys,
+                                  std::vector<status_t> &         out_status)
+{
+  return _connection->erase_batch(pool, keys, out_status);
+}
+
+status_t MCAS_client::scan(const IMCAS::pool_t        pool,
+                           const std::string &        key_expression,
+                           std::string &              in_out_cursor,
+                           std::vector<std::string> & out_keys,
+                           std::vector<std::string> * out_values,
+                           const size_t               max_keys)
+{
+  return _connection->scan(pool, key_expression, in_out_cursor, out_keys, out_values, max_keys);
+}
+
 size_t MCAS_client::count(const IKVStore::pool_t pool) { return _connection->count(pool); }
 
 status_t MCAS_client::get_attribute(const IKVStore::pool_t    pool,
@@ -375,12 +439,13 @@ status_t MCAS_client::get_attribute(const IKVStore::pool_t    pool,
 
 status_t MCAS_client::get_statistics(Shard_stats &out_stats) { return _connection->get_statistics(out_stats); }
 
-status_t MCAS_client::free_memory(void *p)
+status_t MCAS_client::get_latency_statistics(std::vector<Latency_histogram> &out_histograms, bool reset)
 {
-  ::free(p);
-  return S_OK;
+  return _connection->get_latency_statistics(out_histograms, reset);
 }
 
+status_t MCAS_client::free_memory(void *p) { return _connection->free_memory(p); }
+
 void MCAS_client::debug(const IKVStore::pool_t  // pool
                         ,
                         unsigned  // cmd
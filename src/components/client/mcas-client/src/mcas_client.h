@@ -71,7 +71,7 @@ class MCAS_client
    * @param owner Owner information (not used)
    * @param addr_port_str Address and port info (e.g. 10.0.0.22:11911)
    * @param device NIC device (e.g., mlx5_0)
-   * @param provider fabric provider ("verbs" or "sockets")
+   * @param provider fabric provider ("verbs", "sockets", "uring" or "shm")
    *
    */
  public:
@@ -169,6 +169,12 @@ class MCAS_client
                        void *&            out_value, /* release with free() */
                        size_t &           out_value_len) override;
 
+  virtual status_t async_get(const pool_t       pool,
+                             const std::string &key,
+                             void *&            out_value,
+                             size_t &           out_value_len,
+                             async_handle_t &   out_handle) override;
+
   virtual status_t async_get_direct(const pool_t                 pool,
                               const std::string &          key,
                               void *                       out_value,
@@ -212,6 +218,28 @@ class MCAS_client
 
   virtual status_t async_erase(const IMCAS::pool_t pool, const std::string &key, async_handle_t &out_handle) override;
 
+  virtual status_t put_batch(const IMCAS::pool_t             pool,
+                             const std::vector<std::string> &keys,
+                             const std::vector<std::string> &values,
+                             std::vector<status_t> &         out_status,
+                             const unsigned int              flags = IMCAS::FLAGS_NONE) override;
+
+  virtual status_t get_batch(const IMCAS::pool_t             pool,
+                             const std::vector<std::string> &keys,
+                             std::vector<std::string> &      out_values,
+                             std::vector<status_t> &         out_status) override;
+
+  virtual status_t erase_batch(const IMCAS::pool_t             pool,
+                               const std::vector<std::string> &keys,
+                               std::vector<status_t> &         out_status) override;
+
+  virtual status_t scan(const IMCAS::pool_t        pool,
+                        const std::string &        key_expression,
+                        std::string &              in_out_cursor,
+                        std::vector<std::string> & out_keys,
+                        std::vector<std::string> * out_values = nullptr,
+                        const size_t               max_keys   = 0) override;
+
   virtual size_t count(const pool_t pool) override;
 
   virtual status_t get_attribute(const IKVStore::pool_t    pool,
@@ -221,6 +249,8 @@ class MCAS_client
 
   virtual status_t get_statistics(Shard_stats &out_stats) override;
 
+  virtual status_t get_latency_statistics(std::vector<Latency_histogram> &out_histograms, bool reset) override;
+
   virtual void debug(const pool_t pool, const unsigned cmd, const uint64_t arg) override;
 
   virtual IMCAS::memory_handle_t register_direct_memory(void *vaddr, const size_t len) override;
@@ -273,7 +303,9 @@ class MCAS_client
 
  private:
   static void set_debug(unsigned debug_level, const void *ths, const std::string &ip_addr, std::uint16_t port);
-  static auto load_factory() -> component::IFabric_factory *;
+  static bool is_uring(const boost::optional<std::string> &provider) { return provider && *provider == "uring"; }
+  static bool is_shm(const boost::optional<std::string> &provider) { return provider && *provider == "shm"; }
+  static auto load_factory(const boost::optional<std::string> &provider) -> component::IFabric_factory *;
   static auto make_fabric(component::IFabric_factory &,
                           const std::string &ip_addr,
                           const std::string &provider,
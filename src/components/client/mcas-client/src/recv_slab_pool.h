@@ -0,0 +1,106 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __CLIENT_RECV_SLAB_POOL_H__
+#define __CLIENT_RECV_SLAB_POOL_H__
+
+#include "buffer_manager.h"
+
+#include <api/fabric_itf.h>
+#include <common/delete_copy.h>
+
+#include <cassert>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace mcas
+{
+namespace client
+{
+static constexpr size_t NUM_RECV_SLABS = 32; /* receive slabs for async get */
+
+/**
+ * Fixed set of receive buffers, allocated and registered once, when the
+ * pool is created. An async get receives its response directly into a
+ * slab. A slab is an IO buffer like any other, so whichever operation the
+ * response belongs to takes the slab as it is, without a copy, and gives
+ * it back here when done with it. A value may also be handed to the
+ * caller in place; its slab comes back on free_memory. Slabs may be
+ * allocated and freed by any thread.
+ */
+class Recv_slab_pool {
+ public:
+  using Transport = component::IFabric_client;
+  using buffer_t  = Buffer_manager<Transport>::buffer_internal;
+
+  Recv_slab_pool(unsigned debug_level_, Transport *transport_, std::size_t slab_count_)
+      : _bm(debug_level_, transport_, slab_count_),
+        _slabs(),
+        _free_lock(),
+        _free()
+  {
+    _free.reserve(slab_count_);
+    for (std::size_t i = 0; i != slab_count_; ++i) {
+      auto slab = _bm.allocate(nullptr);
+      _slabs.emplace(static_cast<const char *>(slab->base().get()), slab);
+      _free.push_back(slab);
+    }
+  }
+
+  DELETE_COPY(Recv_slab_pool);
+
+  /* a free slab, or nullptr if all are in use */
+  buffer_t *allocate(buffer_t::completion_t c)
+  {
+    buffer_t *slab;
+    {
+      std::lock_guard<std::mutex> g(_free_lock);
+      if (_free.empty()) return nullptr;
+      slab = _free.back();
+      _free.pop_back();
+    }
+    slab->reset_length();
+    slab->set_completion(c);
+    return slab;
+  }
+
+  void free(buffer_t *slab)
+  {
+    assert(slab_of(slab->base()) == slab);
+    std::lock_guard<std::mutex> g(_free_lock);
+    _free.push_back(slab);
+  }
+
+  /* the slab whose memory holds p, or nullptr */
+  buffer_t *slab_of(const void *p) const
+  {
+    /* _slabs is not changed after construction, so needs no lock */
+    const auto c  = static_cast<const char *>(p);
+    auto       it = _slabs.upper_bound(c);
+    if (it == _slabs.begin()) return nullptr;
+    --it;
+    return c < it->first + it->second->original_length() ? it->second : nullptr;
+  }
+
+ private:
+  Buffer_manager<Transport>          _bm; /*< owns the slabs */
+  std::map<const char *, buffer_t *> _slabs; /*< by base address */
+  std::mutex                         _free_lock;
+  std::vector<buffer_t *>            _free;
+};
+
+}  // namespace client
+}  // namespace mcas
+
+#endif
@@ -16,6 +16,7 @@
 
 #include <api/components.h>
 #include <api/kvstore_itf.h>
+#include <api/mcas_itf.h>
 #include <common/cpu.h>
 #include <common/str_utils.h>
 #include <common/task.h>
@@ -24,9 +25,11 @@
 
 #include <boost/program_options.hpp>
 #include <boost/optional.hpp>
+#include <atomic>
 #include <chrono> /* milliseconds */
 #include <iostream>
-#include <thread> /* this_thread::sleep_for */
+#include <thread> /* thread, this_thread::sleep_for */
+#include <vector>
 
 //#define TEST_PERF_SMALL_PUT
 //#define TEST_PERF_SMALL_GET_DIRECT
@@ -290,6 +293,216 @@ TEST_F(mcas_client_test, BasicPutAndGet)
   PLOG("BasicPutAndGet OK!");
 }
 
+TEST_F(mcas_client_test, BatchPutGetErase)
+{
+  PMAJOR("Running BatchPutGetErase...");
+  auto mcas = static_cast<component::IMCAS *>(_mcas->query_interface(component::IMCAS::iid()));
+  ASSERT_TRUE(mcas);
+
+  const std::string poolname = Options.pool + "/BatchPutGetErase";
+  auto              pool     = _mcas->create_pool(poolname, MB(64), 0, EXPECTED_OBJECTS);
+  ASSERT_TRUE(pool != IKVStore::POOL_ERROR);
+
+  /* more records than fit in one 2 MiB IO buffer, so the batch needs
+     several request messages (and several responses, for get) */
+  static constexpr unsigned COUNT = 2000;
+  std::vector<std::string>  keys;
+  std::vector<std::string>  values;
+  std::size_t               total = 0;
+  for (unsigned i = 0; i < COUNT; i++) {
+    keys.push_back("batch-" + std::to_string(i));
+    values.push_back(common::random_string(KB(2)));
+    total += keys.back().size() + values.back().size();
+  }
+  ASSERT_GT(total, MB(2));
+
+  /* requests handled by the shard, from its op_request_count */
+  auto requests = [mcas]() {
+    IMCAS::Shard_stats stats;
+    EXPECT_EQ(S_OK, mcas->get_statistics(stats));
+    return stats.op_request_count;
+  };
+
+  std::vector<status_t> status;
+  auto                  before = requests();
+  ASSERT_EQ(S_OK, mcas->put_batch(pool, keys, values, status));
+  EXPECT_LT(before + 1, requests());
+  ASSERT_EQ(COUNT, status.size());
+  for (auto s : status) ASSERT_EQ(S_OK, s);
+
+  /* partial failure: existing keys refuse, new keys are stored */
+  {
+    std::vector<std::string> k{keys[0], "batch-new", keys[1]};
+    std::vector<std::string> v{"x", "new value", "y"};
+    ASSERT_EQ(S_OK, mcas->put_batch(pool, k, v, status, IMCAS::FLAGS_DONT_STOMP));
+    ASSERT_EQ(3UL, status.size());
+    EXPECT_EQ(IKVStore::E_KEY_EXISTS, status[0]);
+    EXPECT_EQ(S_OK, status[1]);
+    EXPECT_EQ(IKVStore::E_KEY_EXISTS, status[2]);
+  }
+
+  /* a value too large for a batch response is fetched individually */
+  const std::string large_key   = "batch-large";
+  const std::string large_value = common::random_string(MB(4));
+  ASSERT_EQ(S_OK, _mcas->put(pool, large_key, large_value.c_str(), large_value.length()));
+
+  std::vector<std::string> get_keys(keys);
+  get_keys.insert(get_keys.begin() + 10, "batch-missing");
+  get_keys.insert(get_keys.begin() + 20, large_key);
+
+  std::vector<std::string> out_values;
+  before = requests();
+  ASSERT_EQ(S_OK, mcas->get_batch(pool, get_keys, out_values, status));
+  EXPECT_LT(before + 2, requests()); /* several batch messages, and the individual get */
+  ASSERT_EQ(get_keys.size(), status.size());
+  ASSERT_EQ(get_keys.size(), out_values.size());
+  for (std::size_t i = 0; i != get_keys.size(); ++i) {
+    if (get_keys[i] == "batch-missing") {
+      EXPECT_EQ(IKVStore::E_KEY_NOT_FOUND, status[i]);
+      EXPECT_TRUE(out_values[i].empty());
+    }
+    else if (get_keys[i] == large_key) {
+      ASSERT_EQ(S_OK, status[i]);
+      EXPECT_EQ(large_value, out_values[i]);
+    }
+    else {
+      ASSERT_EQ(S_OK, status[i]);
+      EXPECT_EQ(values[std::size_t(std::stoul(get_keys[i].substr(6)))], out_values[i]);
+    }
+  }
+
+  /* erase half, and one key which does not exist */
+  std::vector<std::string> erase_keys(keys.begin(), keys.begin() + COUNT / 2);
+  erase_keys.push_back("batch-missing");
+  ASSERT_EQ(S_OK, mcas->erase_batch(pool, erase_keys, status));
+  ASSERT_EQ(erase_keys.size(), status.size());
+  for (std::size_t i = 0; i != COUNT / 2; ++i) ASSERT_EQ(S_OK, status[i]);
+  EXPECT_EQ(IKVStore::E_KEY_NOT_FOUND, status.back());
+
+  ASSERT_EQ(S_OK, mcas->get_batch(pool, keys, out_values, status));
+  for (std::size_t i = 0; i != COUNT; ++i) {
+    if (i < COUNT / 2) {
+      EXPECT_EQ(IKVStore::E_KEY_NOT_FOUND, status[i]);
+    }
+    else {
+      ASSERT_EQ(S_OK, status[i]);
+      EXPECT_EQ(values[i], out_values[i]);
+    }
+  }
+
+  /* mismatched keys and values */
+  EXPECT_EQ(E_INVAL, mcas->put_batch(pool, keys, std::vector<std::string>(1), status));
+
+  _mcas->close_pool(pool);
+  _mcas->delete_pool(poolname);
+  PLOG("BatchPutGetErase OK!");
+}
+
+TEST_F(mcas_client_test, AsyncGet)
+{
+  PMAJOR("Running AsyncGet...");
+  auto mcas = static_cast<component::IMCAS *>(_mcas->query_interface(component::IMCAS::iid()));
+  ASSERT_TRUE(mcas);
+
+  const std::string poolname = Options.pool + "/AsyncGet";
+  auto              pool     = _mcas->create_pool(poolname, MB(8));
+  ASSERT_TRUE(pool != IKVStore::POOL_ERROR);
+
+  /* more gets in flight than there are receive slabs */
+  static constexpr unsigned COUNT = 48;
+  std::vector<std::string>  values;
+  for (unsigned i = 0; i < COUNT; i++) {
+    values.push_back(common::random_string(64));
+    ASSERT_EQ(S_OK, _mcas->put(pool, "key" + std::to_string(i), values.back().c_str(), values.back().length()));
+  }
+
+  std::vector<void *>                           pv(COUNT, nullptr);
+  std::vector<size_t>                           pv_len(COUNT, 0);
+  std::vector<component::IMCAS::async_handle_t> handles(COUNT, component::IMCAS::ASYNC_HANDLE_INIT);
+  for (unsigned i = 0; i < COUNT; i++) {
+    ASSERT_EQ(S_OK, mcas->async_get(pool, "key" + std::to_string(i), pv[i], pv_len[i], handles[i]));
+  }
+
+  /* complete in reverse order */
+  for (unsigned i = COUNT; i != 0; --i) {
+    status_t rc;
+    while ((rc = mcas->check_async_completion(handles[i - 1])) == E_BUSY)
+      ;
+    ASSERT_EQ(S_OK, rc);
+    ASSERT_EQ(values[i - 1].length(), pv_len[i - 1]);
+    ASSERT_EQ(0, memcmp(pv[i - 1], values[i - 1].c_str(), pv_len[i - 1]));
+    mcas->free_memory(pv[i - 1]);
+  }
+
+  /* into a caller buffer */
+  char     buffer[64];
+  void *   p      = buffer;
+  size_t   p_len  = sizeof buffer;
+  auto     handle = component::IMCAS::ASYNC_HANDLE_INIT;
+  status_t rc;
+  ASSERT_EQ(S_OK, mcas->async_get(pool, "key0", p, p_len, handle));
+  while ((rc = mcas->check_async_completion(handle)) == E_BUSY)
+    ;
+  ASSERT_EQ(S_OK, rc);
+  ASSERT_EQ(0, memcmp(buffer, values[0].c_str(), values[0].length()));
+
+  _mcas->close_pool(pool);
+  _mcas->delete_pool(poolname);
+  PLOG("AsyncGet OK!");
+}
+
+TEST_F(mcas_client_test, SharedConnectionThreads)
+{
+  PMAJOR("Running SharedConnectionThreads...");
+  ASSERT_EQ(int(IKVStore::THREAD_MODEL_MULTI_PER_POOL), _mcas->thread_safety());
+  auto mcas = static_cast<component::IMCAS *>(_mcas->query_interface(component::IMCAS::iid()));
+  ASSERT_TRUE(mcas);
+
+  const std::string poolname = Options.pool + "/SharedConnectionThreads";
+  auto              pool     = _mcas->create_pool(poolname, MB(32));
+  ASSERT_TRUE(pool != IKVStore::POOL_ERROR);
+
+  /* responses may be received into buffers posted by other threads: check each thread gets its own */
+  static constexpr unsigned THREADS    = 8;
+  static constexpr unsigned ITERATIONS = 2000;
+  std::atomic<unsigned>     failures{0};
+  std::vector<std::thread>  threads;
+  for (unsigned t = 0; t != THREADS; ++t) {
+    threads.emplace_back([&, t]() {
+      for (unsigned i = 0; i != ITERATIONS; ++i) {
+        const auto key   = "t" + std::to_string(t) + "-" + std::to_string(i % 64);
+        const auto value = key + "-" + std::to_string(i);
+        if (_mcas->put(pool, key, value.c_str(), value.length()) != S_OK) ++failures;
+
+        void * pv     = nullptr;
+        size_t pv_len = 0;
+        if (i % 2) {
+          auto handle = component::IMCAS::ASYNC_HANDLE_INIT;
+          if (mcas->async_get(pool, key, pv, pv_len, handle) != S_OK) {
+            ++failures;
+            continue;
+          }
+          status_t rc;
+          while ((rc = mcas->check_async_completion(handle)) == E_BUSY)
+            ;
+          if (rc != S_OK) ++failures;
+        }
+        else if (_mcas->get(pool, key, pv, pv_len) != S_OK)
+          ++failures;
+
+        if (pv_len != value.length() || memcmp(pv, value.c_str(), pv_len) != 0) ++failures;
+        mcas->free_memory(pv);
+      }
+    });
+  }
+  for (auto &t : threads) t.join();
+  EXPECT_EQ(0U, failures.load());
+
+  _mcas->close_pool(pool);
+  _mcas->delete_pool(poolname);
+  PLOG("SharedConnectionThreads OK!");
+}
+
 #ifdef TEST_SCALE_IOPS
 
 struct record_t {
@@ -0,0 +1,67 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __CLUSTER_HASH_RING_H__
+#define __CLUSTER_HASH_RING_H__
+
+#include <city.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mcas
+{
+namespace cluster
+{
+/**
+ * Consistent-hash ring. Each shard is placed at VNODES points on the ring,
+ * derived from the shard name (its endpoint), and a key belongs to the
+ * shard at the first point at or after the key's hash. The placement
+ * depends only on the shard names, so every client which is given the same
+ * endpoints agrees on the owner of a key whatever the order of endpoints,
+ * and adding or removing a shard moves only about 1/N of the keys.
+ */
+class Hash_ring {
+ public:
+  static constexpr unsigned VNODES = 160;
+
+  explicit Hash_ring(const std::vector<std::string> &shard_names, unsigned vnodes = VNODES) : _points()
+  {
+    _points.reserve(shard_names.size() * vnodes);
+    for (unsigned s = 0; s != shard_names.size(); ++s) {
+      for (unsigned v = 0; v != vnodes; ++v) {
+        const auto point = shard_names[s] + "#" + std::to_string(v);
+        _points.emplace_back(CityHash64(point.data(), point.size()), s);
+      }
+    }
+    std::sort(_points.begin(), _points.end());
+  }
+
+  unsigned shard(const std::string &key) const { return shard(CityHash64(key.data(), key.size())); }
+
+  unsigned shard(std::uint64_t hash) const
+  {
+    auto it = std::lower_bound(_points.begin(), _points.end(), std::make_pair(hash, 0U));
+    return (it == _points.end() ? _points.front() : *it).second;
+  }
+
+ private:
+  std::vector<std::pair<std::uint64_t, unsigned>> _points;
+};
+
+}  // namespace cluster
+}  // namespace mcas
+
+#endif
@@ -0,0 +1,855 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "mcas_cluster_client.h"
+
+#include <common/exceptions.h>
+#include <common/logging.h>
+
+#include <algorithm>
+#include <cassert>
+#include <future>
+#include <map>
+#include <numeric>
+
+using namespace component;
+
+/* per-shard handles of a cluster pool */
+struct MCAS_cluster_client::pool_set {
+  std::vector<pool_t> shard;
+};
+
+/* per-shard registrations of one region of direct memory */
+struct MCAS_cluster_client::memory_handle_set : public IKVStore::Opaque_memory_region {
+  std::vector<IMCAS::memory_handle_t> shard;
+  explicit memory_handle_set(std::size_t n) : shard(n, IMCAS::memory_handle_t(IMCAS::MEMORY_HANDLE_NONE)) {}
+};
+
+/* an async operation on one shard */
+struct MCAS_cluster_client::async_handle_shard : public IMCAS::Opaque_async_handle {
+  unsigned       shard;
+  async_handle_t handle;
+  void **        out_value; /* for a get into memory allocated by the shard */
+  async_handle_shard(unsigned shard_, async_handle_t handle_, void **out_value_)
+      : shard(shard_), handle(handle_), out_value(out_value_)
+  {
+  }
+  async_handle_shard(const async_handle_shard &) = delete;
+  async_handle_shard &operator=(const async_handle_shard &) = delete;
+};
+
+namespace
+{
+/* a shard's name on the hash ring is its address and port, less any provider */
+std::vector<std::string> shard_names(const std::vector<std::string> &endpoints)
+{
+  std::vector<std::string> names;
+  for (const auto &e : endpoints) {
+    auto port_end = e.find(':', e.find(':') + 1);
+    names.push_back(e.substr(0, port_end));
+  }
+  return names;
+}
+
+status_t first_error(const std::vector<status_t> &status)
+{
+  auto it = std::find_if(status.begin(), status.end(), [](status_t s) { return s != S_OK; });
+  return it == status.end() ? S_OK : *it;
+}
+
+std::size_t div_up(std::size_t a, std::size_t b) { return (a + b - 1) / b; }
+}  // namespace
+
+MCAS_cluster_client::MCAS_cluster_client(const unsigned                      debug_level,
+                                         const unsigned                      patience,
+                                         const boost::optional<std::string> &src_device,
+                                         const boost::optional<std::string> &src_addr,
+                                         const std::vector<std::string> &    endpoints)
+    : _debug_level(debug_level),
+      _factory(load_factory()),
+      _shards(),
+      _ring(shard_names(endpoints)),
+      _pool_sets_lock(),
+      _pool_sets(),
+      _memory_lock(),
+      _memory_owner()
+{
+  if (endpoints.empty() || endpoints.size() > MAX_SHARDS)
+    throw API_exception("MCAS_cluster_client: bad shard count (%zu)", endpoints.size());
+
+  for (const auto &e : endpoints) {
+    auto shard = _factory->mcas_create(debug_level, patience, "cluster", src_device, src_addr, e);
+    if (!shard) throw General_exception("MCAS_cluster_client: failed to connect to shard %s", e.c_str());
+    _shards.emplace_back(shard);
+  }
+
+  if (_debug_level > 1) PLOG("%s: %zu shards", __func__, _shards.size());
+}
+
+MCAS_cluster_client::~MCAS_cluster_client() {}
+
+IMCAS_factory *MCAS_cluster_client::load_factory()
+{
+  IBase *comp = load_component("libcomponent-mcasclient.so", mcas_client_factory);
+
+  if (!comp) throw General_exception("MCAS client component not found");
+
+  auto factory = static_cast<IMCAS_factory *>(comp->query_interface(IMCAS_factory::iid()));
+  assert(factory);
+  return factory;
+}
+
+void MCAS_cluster_client::fan_out(const std::vector<unsigned> &shards, const std::function<void(unsigned)> &f)
+{
+  if (shards.empty()) return;
+
+  std::vector<std::future<void>> tasks;
+  tasks.reserve(shards.size() - 1);
+  for (auto it = shards.begin(); it != shards.end() - 1; ++it) {
+    tasks.emplace_back(std::async(std::launch::async, f, *it));
+  }
+  f(shards.back());
+  for (auto &t : tasks) t.get();
+}
+
+void MCAS_cluster_client::fan_out(const std::function<void(unsigned)> &f)
+{
+  std::vector<unsigned> all(_shards.size());
+  std::iota(all.begin(), all.end(), 0U);
+  fan_out(all, f);
+}
+
+auto MCAS_cluster_client::get_pool_set(const pool_t pool) -> std::shared_ptr<const pool_set>
+{
+  std::lock_guard<std::mutex> g(_pool_sets_lock);
+  auto                        it = _pool_sets.find(pool);
+  return it == _pool_sets.end() ? nullptr : it->second;
+}
+
+auto MCAS_cluster_client::take_pool_set(const pool_t pool) -> std::shared_ptr<const pool_set>
+{
+  std::lock_guard<std::mutex>     g(_pool_sets_lock);
+  auto                            it = _pool_sets.find(pool);
+  std::shared_ptr<const pool_set> ps;
+  if (it != _pool_sets.end()) {
+    ps = std::move(it->second);
+    _pool_sets.erase(it);
+  }
+  return ps;
+}
+
+auto MCAS_cluster_client::add_pool_set(std::vector<pool_t> &&pools) -> pool_t
+{
+  std::shared_ptr<const pool_set> ps(new pool_set{std::move(pools)});
+  auto                            pool = reinterpret_cast<pool_t>(ps.get());
+  std::lock_guard<std::mutex>     g(_pool_sets_lock);
+  _pool_sets.emplace(pool, std::move(ps));
+  return pool;
+}
+
+bool MCAS_cluster_client::route(const pool_t pool, const std::string &key, unsigned &out_shard, pool_t &out_shard_pool)
+{
+  out_shard = _ring.shard(key);
+  /* the shard's handle is copied under the lock: no reference need be held */
+  std::lock_guard<std::mutex> g(_pool_sets_lock);
+  auto                        it = _pool_sets.find(pool);
+  if (it == _pool_sets.end()) return false;
+  out_shard_pool = it->second->shard[out_shard];
+  return true;
+}
+
+void MCAS_cluster_client::wrap_async(const unsigned shard, async_handle_t &handle, void **out_value)
+{
+  if (handle != IMCAS::ASYNC_HANDLE_INIT) {
+    handle = new async_handle_shard(shard, handle, out_value);
+  }
+  else if (out_value) {
+    track_memory(shard, *out_value);
+  }
+}
+
+void MCAS_cluster_client::track_memory(const unsigned shard, void *p)
+{
+  if (p) {
+    std::lock_guard<std::mutex> g(_memory_lock);
+    _memory_owner[p] = shard;
+  }
+}
+
+auto MCAS_cluster_client::shard_handle(const IMCAS::memory_handle_t handle, const unsigned shard) -> IMCAS::memory_handle_t
+{
+  if (handle == IMCAS::MEMORY_HANDLE_NONE) return IMCAS::MEMORY_HANDLE_NONE;
+  return static_cast<memory_handle_set *>(handle)->shard[shard];
+}
+
+int MCAS_cluster_client::thread_safety() const { return _shards.front()->thread_safety(); }
+
+int MCAS_cluster_client::get_capability(Capability cap) const
+{
+  switch (cap) {
+    case Capability::POOL_DELETE_CHECK:
+      return 1;
+    case Capability::POOL_THREAD_SAFE:
+      return 1;
+    case Capability::RWLOCK_PER_POOL:
+      return 1;
+    default:
+      return -1;
+  }
+}
+
+IKVStore::pool_t MCAS_cluster_client::create_pool(const std::string &name,
+                                                  const size_t       size,
+                                                  const unsigned int flags,
+                                                  const uint64_t     expected_obj_count)
+{
+  const auto          n = _shards.size();
+  std::vector<pool_t> pools(n, pool_t(IKVStore::POOL_ERROR));
+  std::vector<char>   created(n, false);
+
+  /* Create only, then (unless the caller asked to create only) open what
+   * exists, so that a failure deletes just the pools which this call made.
+   */
+  fan_out([&](unsigned s) {
+    pools[s]   = _shards[s]->create_pool(name, div_up(size, n), flags | IKVStore::FLAGS_CREATE_ONLY,
+                                       div_up(expected_obj_count, n));
+    created[s] = pools[s] != IKVStore::POOL_ERROR;
+    if (!created[s] && !(flags & IKVStore::FLAGS_CREATE_ONLY)) pools[s] = _shards[s]->open_pool(name, flags);
+  });
+
+  if (std::count(pools.begin(), pools.end(), pool_t(IKVStore::POOL_ERROR)) != 0) {
+    PWRN("%s: pool (%s) not created on every shard", __func__, name.c_str());
+    fan_out([&](unsigned s) {
+      if (created[s])
+        _shards[s]->delete_pool(pools[s]);
+      else if (pools[s] != IKVStore::POOL_ERROR)
+        _shards[s]->close_pool(pools[s]);
+    });
+    return IKVStore::POOL_ERROR;
+  }
+
+  return add_pool_set(std::move(pools));
+}
+
+IKVStore::pool_t MCAS_cluster_client::open_pool(const std::string &name, const unsigned int flags)
+{
+  std::vector<pool_t> pools(_shards.size(), pool_t(IKVStore::POOL_ERROR));
+
+  fan_out([&](unsigned s) { pools[s] = _shards[s]->open_pool(name, flags); });
+
+  if (std::count(pools.begin(), pools.end(), pool_t(IKVStore::POOL_ERROR)) != 0) {
+    fan_out([&](unsigned s) {
+      if (pools[s] != IKVStore::POOL_ERROR) _shards[s]->close_pool(pools[s]);
+    });
+    return IKVStore::POOL_ERROR;
+  }
+
+  return add_pool_set(std::move(pools));
+}
+
+status_t MCAS_cluster_client::close_pool(const pool_t pool)
+{
+  auto ps = take_pool_set(pool);
+  if (!ps) return E_INVAL;
+
+  std::vector<status_t> status(_shards.size(), S_OK);
+  fan_out([&](unsigned s) { status[s] = _shards[s]->close_pool(ps->shard[s]); });
+  return first_error(status);
+}
+
+status_t MCAS_cluster_client::delete_pool(const std::string &name)
+{
+  std::vector<status_t> status(_shards.size(), S_OK);
+  fan_out([&](unsigned s) { status[s] = _shards[s]->delete_pool(name); });
+  return first_error(status);
+}
+
+status_t MCAS_cluster_client::delete_pool(const IKVStore::pool_t pool)
+{
+  auto ps = take_pool_set(pool);
+  if (!ps) return E_INVAL;
+
+  std::vector<status_t> status(_shards.size(), S_OK);
+  fan_out([&](unsigned s) { status[s] = _shards[s]->delete_pool(ps->shard[s]); });
+  return first_error(status);
+}
+
+status_t MCAS_cluster_client::configure_pool(const IKVStore::pool_t pool, const std::string &json)
+{
+  auto ps = get_pool_set(pool);
+  if (!ps) return E_INVAL;
+
+  std::vector<status_t> status(_shards.size(), S_OK);
+  fan_out([&](unsigned s) { status[s] = _shards[s]->configure_pool(ps->shard[s], json); });
+  return first_error(status);
+}
+
+status_t MCAS_cluster_client::put(const IKVStore::pool_t pool,
+                                  const std::string &    key,
+                                  const void *           value,
+                                  const size_t           value_len,
+                                  const unsigned int     flags)
+{
+  unsigned s;
+  pool_t   p;
+  if (!route(pool, key, s, p)) return E_INVAL;
+  return _shards[s]->put(p, key, value, value_len, flags);
+}
+
+status_t MCAS_cluster_client::put_direct(const pool_t                 pool,
+                                         const std::string &          key,
+                                         const void *                 value,
+                                         const size_t                 value_len,
+                                         const IMCAS::memory_handle_t handle,
+                                         const unsigned int           flags)
+{
+  unsigned s;
+  pool_t   p;
+  if (!route(pool, key, s, p)) return E_INVAL;
+  return _shards[s]->put_direct(p, key, value, value_len, shard_handle(handle, s), flags);
+}
+
+status_t MCAS_cluster_client::async_put(const IKVStore::pool_t pool,
+                                        const std::string &    key,
+                                        const void *           value,
+                                        const size_t           value_len,
+                                        async_handle_t &       out_handle,
+                                        const unsigned int     flags)
+{
+  unsigned s;
+  pool_t   p;
+  if (!route(pool, key, s, p)) return E_INVAL;
+  auto rc = _shards[s]->async_put(p, key, value, value_len, out_handle, flags);
+  if (rc == S_OK) wrap_async(s, out_handle);
+  return rc;
+}
+
+status_t MCAS_cluster_client::async_put_direct(const IKVStore::pool_t          pool,
+                                               const std::string &             key,
+                                               const void *                    value,
+                                               const size_t                    value_len,
+                                               async_handle_t &                out_handle,
+                                               const IKVStore::memory_handle_t handle,
+                                               const unsigned int              flags)
+{
+  unsigned s;
+  pool_t   p;
+  if (!route(pool, key, s, p)) return E_INVAL;
+  auto rc = _shards[s]->async_put_direct(p, key, value, value_len, out_handle, shard_handle(handle, s), flags);
+  if (rc == S_OK) wrap_async(s, out_handle);
+  return rc;
+}
+
+status_t MCAS_cluster_client::check_async_completion(async_handle_t &handle)
+{
+  auto h = static_cast<async_handle_shard *>(handle);
+  assert(h);
+
+  auto status = _shards[h->shard]->check_async_completion(h->handle);
+  if (status != E_BUSY) {
+    if (status == S_OK && h->out_value) track_memory(h->shard, *h->out_value);
+    delete h;
+  }
+  return status;
+}
+
+status_t MCAS_cluster_client::get(const IKVStore::pool_t pool,
+                                  const std::string &    key,
+                                  void *&                out_value,
+                                  size_t &               out_value_len)
+{
+  unsigned s;
+  pool_t   p;
+  if (!route(pool, key, s, p)) return E_INVAL;
+  auto rc = _shards[s]->get(p, key, out_value, out_value_len);
+  if (rc == S_OK) track_memory(s, out_value);
+  return rc;
+}
+
+status_t MCAS_cluster_client::async_get(const IKVStore::pool_t pool,
+                                        const std::string &    key,
+                                        void *&                out_value,
+                                        size_t &               out_value_len,
+                                        async_handle_t &       out_handle)
+{
+  unsigned s;
+  pool_t   p;
+  if (!route(pool, key, s, p)) return E_INVAL;
+  /* memory is allocated by the shard only if the caller supplies none */
+  const bool allocates = out_value == nullptr;
+  auto       rc        = _shards[s]->async_get(p, key, out_value, out_value_len, out_handle);
+  if (rc == S_OK) wrap_async(s, out_handle, allocates ? &out_value : nullptr);
+  return rc;
+}
+
+status_t MCAS_cluster_client::async_get_direct(const IKVStore::pool_t       pool,
+                                               const std::string &          key,
+                                               void *                       out_value,
+                                               size_t &                     out_value_len,
+                                               async_handle_t &             out_handle,
+                                               const IMCAS::memory_handle_t handle)
+{
+  unsigned s;
+  pool_t   p;
+  if (!route(pool, key, s, p)) return E_INVAL;
+  auto rc = _shards[s]->async_get_direct(p, key, out_value, out_value_len, out_handle, shard_handle(handle, s));
+  if (rc == S_OK) wrap_async(s, out_handle);
+  return rc;
+}
+
+status_t MCAS_cluster_client::get_direct(const pool_t                 pool,
+                                         const std::string &          key,
+                                         void *                       out_value,
+                                         size_t &                     out_value_len,
+                                         const IMCAS::memory_handle_t handle)
+{
+  unsigned s;
+  pool_t   p;
+  if (!route(pool, key, s, p)) return E_INVAL;
+  return _shards[s]->get_direct(p, key, out_value, out_value_len, shard_handle(handle, s));
+}
+
+status_t MCAS_cluster_client::get_direct_offset(const IMCAS::pool_t,
+                                                const offset_t,
+                                                size_t &,
+                                                void *,
+                                                const IMCAS::memory_handle_t)
+{
+  return E_NOT_SUPPORTED;
+}
+
+status_t MCAS_cluster_client::async_get_direct_offset(const IMCAS::pool_t,
+                                                      const offset_t,
+                                                      size_t &,
+                                                      void *,
+                                                      async_handle_t &,
+                                                      const IMCAS::memory_handle_t)
+{
+  return E_NOT_SUPPORTED;
+}
+
+status_t MCAS_cluster_client::put_direct_offset(const IMCAS::pool_t,
+                                                const offset_t,
+                                                size_t &,
+                                                const void *,
+                                                const IMCAS::memory_handle_t)
+{
+  return E_NOT_SUPPORTED;
+}
+
+status_t MCAS_cluster_client::async_put_direct_offset(const IMCAS::pool_t,
+                                                      const offset_t,
+                                                      size_t &,
+                                                      const void *,
+                                                      async_handle_t &,
+                                                      const IMCAS::memory_handle_t)
+{
+  return E_NOT_SUPPORTED;
+}
+
+status_t MCAS_cluster_client::erase(const IKVStore::pool_t pool, const std::string &key)
+{
+  unsigned s;
+  pool_t   p;
+  if (!route(pool, key, s, p)) return E_INVAL;
+  return _shards[s]->erase(p, key);
+}
+
+status_t MCAS_cluster_client::async_erase(const IMCAS::pool_t pool, const std::string &key, async_handle_t &out_handle)
+{
+  unsigned s;
+  pool_t   p;
+  if (!route(pool, key, s, p)) return E_INVAL;
+  auto rc = _shards[s]->async_erase(p, key, out_handle);
+  if (rc == S_OK) wrap_async(s, out_handle);
+  return rc;
+}
+
+namespace
+{
+/* the keys of a batch which belong to each shard, as indices into the batch */
+struct batch_split {
+  std::vector<std::vector<std::size_t>> index;
+  std::vector<unsigned>                 shards; /* shards with at least one key */
+
+  batch_split(const mcas::cluster::Hash_ring &ring, std::size_t shard_count, const std::vector<std::string> &keys)
+      : index(shard_count), shards()
+  {
+    for (std::size_t i = 0; i != keys.size(); ++i) index[ring.shard(keys[i])].push_back(i);
+    for (unsigned s = 0; s != shard_count; ++s)
+      if (!index[s].empty()) shards.push_back(s);
+  }
+
+  template <typename T>
+  std::vector<T> gather(unsigned s, const std::vector<T> &v) const
+  {
+    std::vector<T> r;
+    r.reserve(index[s].size());
+    for (auto i : index[s]) r.push_back(v[i]);
+    return r;
+  }
+
+  template <typename T>
+  void scatter(unsigned s, std::vector<T> &&from, std::vector<T> &to) const
+  {
+    for (std::size_t j = 0; j != index[s].size() && j != from.size(); ++j) to[index[s][j]] = std::move(from[j]);
+  }
+};
+}  // namespace
+
+status_t MCAS_cluster_client::put_batch(const IMCAS::pool_t             pool,
+                                        const std::vector<std::string> &keys,
+                                        const std::vector<std::string> &values,
+                                        std::vector<status_t> &         out_status,
+                                        const unsigned int              flags)
+{
+  auto ps = get_pool_set(pool);
+  if (!ps || keys.size() != values.size()) return E_INVAL;
+
+  const batch_split     split(_ring, _shards.size(), keys);
+  std::vector<status_t> status(_shards.size(), S_OK);
+  out_status.assign(keys.size(), E_FAIL);
+
+  fan_out(split.shards, [&](unsigned s) {
+    std::vector<status_t> shard_status;
+    status[s] = _shards[s]->put_batch(ps->shard[s], split.gather(s, keys), split.gather(s, values), shard_status, flags);
+    split.scatter(s, std::move(shard_status), out_status);
+  });
+  return first_error(status);
+}
+
+status_t MCAS_cluster_client::get_batch(const IMCAS::pool_t             pool,
+                                        const std::vector<std::string> &keys,
+                                        std::vector<std::string> &      out_values,
+                                        std::vector<status_t> &         out_status)
+{
+  auto ps = get_pool_set(pool);
+  if (!ps) return E_INVAL;
+
+  const batch_split     split(_ring, _shards.size(), keys);
+  std::vector<status_t> status(_shards.size(), S_OK);
+  out_values.assign(keys.size(), std::string());
+  out_status.assign(keys.size(), E_FAIL);
+
+  fan_out(split.shards, [&](unsigned s) {
+    std::vector<std::string> shard_values;
+    std::vector<status_t>    shard_status;
+    status[s] = _shards[s]->get_batch(ps->shard[s], split.gather(s, keys), shard_values, shard_status);
+    split.scatter(s, std::move(shard_values), out_values);
+    split.scatter(s, std::move(shard_status), out_status);
+  });
+  return first_error(status);
+}
+
+status_t MCAS_cluster_client::erase_batch(const IMCAS::pool_t             pool,
+                                          const std::vector<std::string> &keys,
+                                          std::vector<status_t> &         out_status)
+{
+  auto ps = get_pool_set(pool);
+  if (!ps) return E_INVAL;
+
+  const batch_split     split(_ring, _shards.size(), keys);
+  std::vector<status_t> status(_shards.size(), S_OK);
+  out_status.assign(keys.size(), E_FAIL);
+
+  fan_out(split.shards, [&](unsigned s) {
+    std::vector<status_t> shard_status;
+    status[s] = _shards[s]->erase_batch(ps->shard[s], split.gather(s, keys), shard_status);
+    split.scatter(s, std::move(shard_status), out_status);
+  });
+  return first_error(status);
+}
+
+status_t MCAS_cluster_client::scan(const IMCAS::pool_t        pool,
+                                   const std::string &        key_expression,
+                                   std::string &              in_out_cursor,
+                                   std::vector<std::string> & out_keys,
+                                   std::vector<std::string> * out_values,
+                                   const size_t               max_keys)
+{
+  auto ps = get_pool_set(pool);
+  if (!ps) return E_INVAL;
+
+  /* the cluster cursor is the shard being scanned, ':', and that shard's cursor */
+  unsigned    s = 0;
+  std::string cursor;
+  if (!in_out_cursor.empty()) {
+    auto colon = in_out_cursor.find(':');
+    if (colon == std::string::npos) return E_INVAL;
+    s      = unsigned(std::stoul(in_out_cursor.substr(0, colon)));
+    cursor = in_out_cursor.substr(colon + 1);
+  }
+
+  const auto first_key = out_keys.size();
+  for (; s < _shards.size(); ++s, cursor.clear()) {
+    const auto remaining = max_keys ? max_keys - (out_keys.size() - first_key) : 0;
+    auto       rc        = _shards[s]->scan(ps->shard[s], key_expression, cursor, out_keys, out_values, remaining);
+    if (rc == S_MORE) {
+      in_out_cursor = std::to_string(s) + ":" + cursor;
+      return S_MORE;
+    }
+    if (rc != S_OK) return rc;
+
+    /* keys are ordered within a shard only; return them before moving on */
+    const auto found = out_keys.size() - first_key;
+    if (s + 1 < _shards.size() && found != 0 && (max_keys == 0 || found == max_keys)) {
+      in_out_cursor = std::to_string(s + 1) + ":";
+      return S_MORE;
+    }
+  }
+
+  in_out_cursor.clear();
+  return S_OK;
+}
+
+size_t MCAS_cluster_client::count(const IKVStore::pool_t pool)
+{
+  auto ps = get_pool_set(pool);
+  if (!ps) return 0;
+
+  std::vector<size_t> counts(_shards.size(), 0);
+  fan_out([&](unsigned s) { counts[s] = _shards[s]->count(ps->shard[s]); });
+  return std::accumulate(counts.begin(), counts.end(), size_t(0));
+}
+
+status_t MCAS_cluster_client::get_attribute(const IKVStore::pool_t    pool,
+                                            const IKVStore::Attribute attr,
+                                            std::vector<uint64_t> &   out_attr,
+                                            const std::string *       key)
+{
+  if (key) {
+    unsigned s;
+    pool_t   p;
+    if (!route(pool, *key, s, p)) return E_INVAL;
+    return _shards[s]->get_attribute(p, attr, out_attr, key);
+  }
+
+  auto ps = get_pool_set(pool);
+  if (!ps) return E_INVAL;
+
+  std::vector<std::vector<uint64_t>> attrs(_shards.size());
+  std::vector<status_t>              status(_shards.size(), S_OK);
+  fan_out([&](unsigned s) { status[s] = _shards[s]->get_attribute(ps->shard[s], attr, attrs[s], nullptr); });
+
+  auto rc = first_error(status);
+  if (rc != S_OK) return rc;
+
+  /* a pool attribute is the same on every shard, except for these */
+  out_attr = attrs.front();
+  if (attr == IKVStore::Attribute::COUNT || attr == IKVStore::Attribute::PERCENT_USED) {
+    for (auto &a : out_attr) a = 0;
+    for (const auto &v : attrs)
+      for (std::size_t i = 0; i != std::min(v.size(), out_attr.size()); ++i) out_attr[i] += v[i];
+    if (attr == IKVStore::Attribute::PERCENT_USED)
+      for (auto &a : out_attr) a /= _shards.size();
+  }
+  return S_OK;
+}
+
+status_t MCAS_cluster_client::get_statistics(Shard_stats &out_stats)
+{
+  std::vector<Shard_stats> stats(_shards.size());
+  std::vector<status_t>    status(_shards.size(), S_OK);
+  fan_out([&](unsigned s) { status[s] = _shards[s]->get_statistics(stats[s]); });
+
+  out_stats = Shard_stats();
+  for (const auto &st : stats) {
+    out_stats.op_request_count += st.op_request_count;
+    out_stats.op_put_count += st.op_put_count;
+    out_stats.op_get_count += st.op_get_count;
+    out_stats.op_put_direct_count += st.op_put_direct_count;
+    out_stats.op_get_direct_count += st.op_get_direct_count;
+    out_stats.op_get_twostage_count += st.op_get_twostage_count;
+    out_stats.op_ado_count += st.op_ado_count;
+    out_stats.op_erase_count += st.op_erase_count;
+    out_stats.op_get_direct_offset_count += st.op_get_direct_offset_count;
+    out_stats.op_failed_request_count += st.op_failed_request_count;
+    out_stats.last_op_count_snapshot += st.last_op_count_snapshot;
+    out_stats.busy_tick_count += st.busy_tick_count;
+    out_stats.tick_msg_count += st.tick_msg_count;
+    out_stats.tick_msg_max = std::max(out_stats.tick_msg_max, st.tick_msg_max);
+    out_stats.batch_budget_reached_count += st.batch_budget_reached_count;
+    out_stats.op_offload_count += st.op_offload_count;
+    out_stats.mr_cache_hit_count += st.mr_cache_hit_count;
+    out_stats.mr_cache_miss_count += st.mr_cache_miss_count;
+    out_stats.idle_block_count += st.idle_block_count;
+    out_stats.idle_block_usec += st.idle_block_usec;
+    out_stats.wake_latency_count += st.wake_latency_count;
+    out_stats.wake_latency_ns_total += st.wake_latency_ns_total;
+    out_stats.wake_latency_ns_max = std::max(out_stats.wake_latency_ns_max, st.wake_latency_ns_max);
+    out_stats.client_count = uint16_t(out_stats.client_count + st.client_count);
+  }
+  return first_error(status);
+}
+
+/* histograms of the same operation and phase are merged; bucket bounds
+ * which differ between shards (different TSC rates) are kept apart
+ */
+status_t MCAS_cluster_client::get_latency_statistics(std::vector<Latency_histogram> &out_histograms, bool reset)
+{
+  std::vector<std::vector<Latency_histogram>> histograms(_shards.size());
+  std::vector<status_t>                       status(_shards.size(), S_OK);
+  fan_out([&](unsigned s) { status[s] = _shards[s]->get_latency_statistics(histograms[s], reset); });
+
+  std::map<std::pair<std::string, std::string>, std::pair<Latency_histogram, std::map<uint64_t, uint64_t>>> merged;
+  for (const auto &shard : histograms) {
+    for (const auto &h : shard) {
+      auto &m = merged[{h.op, h.phase}];
+      m.first.op    = h.op;
+      m.first.phase = h.phase;
+      m.first.count += h.count;
+      m.first.sum_ns += h.sum_ns;
+      for (const auto &b : h.buckets) m.second[b.first] += b.second;
+    }
+  }
+
+  out_histograms.clear();
+  for (auto &m : merged) {
+    m.second.first.buckets.assign(m.second.second.begin(), m.second.second.end());
+    out_histograms.push_back(std::move(m.second.first));
+  }
+  return first_error(status);
+}
+
+void MCAS_cluster_client::debug(const IKVStore::pool_t pool, const unsigned cmd, const uint64_t arg)
+{
+  auto ps = get_pool_set(pool);
+  fan_out([&](unsigned s) { _shards[s]->debug(ps ? ps->shard[s] : pool, cmd, arg); });
+}
+
+IMCAS::memory_handle_t MCAS_cluster_client::register_direct_memory(void *vaddr, const size_t len)
+{
+  auto h = new memory_handle_set(_shards.size());
+  fan_out([&](unsigned s) { h->shard[s] = _shards[s]->register_direct_memory(vaddr, len); });
+
+  if (std::count(h->shard.begin(), h->shard.end(), IMCAS::memory_handle_t(IMCAS::MEMORY_HANDLE_NONE)) != 0) {
+    unregister_direct_memory(h);
+    return IMCAS::MEMORY_HANDLE_NONE;
+  }
+  return h;
+}
+
+status_t MCAS_cluster_client::unregister_direct_memory(const IMCAS::memory_handle_t handle)
+{
+  if (handle == IMCAS::MEMORY_HANDLE_NONE) return E_INVAL;
+
+  auto                  h = static_cast<memory_handle_set *>(handle);
+  std::vector<status_t> status(_shards.size(), S_OK);
+  fan_out([&](unsigned s) {
+    if (h->shard[s] != IMCAS::MEMORY_HANDLE_NONE) status[s] = _shards[s]->unregister_direct_memory(h->shard[s]);
+  });
+  delete h;
+  return first_error(status);
+}
+
+status_t MCAS_cluster_client::free_memory(void *p)
+{
+  unsigned s = 0;
+  {
+    std::lock_guard<std::mutex> g(_memory_lock);
+    auto                        it = _memory_owner.find(p);
+    if (it != _memory_owner.end()) {
+      s = it->second;
+      _memory_owner.erase(it);
+    }
+  }
+  return _shards[s]->free_memory(p);
+}
+
+status_t MCAS_cluster_client::find(const IKVStore::pool_t pool,
+                                   const std::string &    key_expression,
+                                   const offset_t         offset,
+                                   offset_t &             out_matched_offset,
+                                   std::string &          out_matched_key)
+{
+  auto ps = get_pool_set(pool);
+  if (!ps) return E_INVAL;
+
+  constexpr offset_t local_mask = (offset_t(1) << SHARD_SHIFT) - 1;
+
+  /* search shard by shard, from the shard and position encoded in offset */
+  const auto first = unsigned(offset >> SHARD_SHIFT);
+  status_t   rc    = E_FAIL;
+  for (auto s = first; s < _shards.size(); ++s) {
+    offset_t matched = 0;
+    rc = _shards[s]->find(ps->shard[s], key_expression, s == first ? offset & local_mask : 0, matched, out_matched_key);
+    if (rc == S_OK) {
+      out_matched_offset = (offset_t(s) << SHARD_SHIFT) | matched;
+      return S_OK;
+    }
+  }
+  return rc;
+}
+
+status_t MCAS_cluster_client::invoke_ado(const IKVStore::pool_t            pool,
+                                         const std::string &               key,
+                                         const void *                      request,
+                                         const size_t                      request_len,
+                                         const uint32_t                    flags,
+                                         std::vector<IMCAS::ADO_response> &out_response,
+                                         const size_t                      value_size)
+{
+  unsigned s;
+  pool_t   p;
+  if (!route(pool, key, s, p)) return E_INVAL;
+  return _shards[s]->invoke_ado(p, key, request, request_len, flags, out_response, value_size);
+}
+
+status_t MCAS_cluster_client::async_invoke_ado(const IMCAS::pool_t               pool,
+                                               const std::string &               key,
+                                               const void *                      request,
+                                               const size_t                      request_len,
+                                               const ado_flags_t                 flags,
+                                               std::vector<IMCAS::ADO_response> &out_response,
+                                               async_handle_t &                  out_async_handle,
+                                               const size_t                      value_size)
+{
+  unsigned s;
+  pool_t   p;
+  if (!route(pool, key, s, p)) return E_INVAL;
+  auto rc = _shards[s]->async_invoke_ado(p, key, request, request_len, flags, out_response, out_async_handle, value_size);
+  if (rc == S_OK) wrap_async(s, out_async_handle);
+  return rc;
+}
+
+status_t MCAS_cluster_client::invoke_put_ado(const IKVStore::pool_t            pool,
+                                             const std::string &               key,
+                                             const void *                      request,
+                                             const size_t                      request_len,
+                                             const void *                      value,
+                                             const size_t                      value_len,
+                                             const size_t                      root_len,
+                                             const ado_flags_t                 flags,
+                                             std::vector<IMCAS::ADO_response> &out_response)
+{
+  unsigned s;
+  pool_t   p;
+  if (!route(pool, key, s, p)) return E_INVAL;
+  return _shards[s]->invoke_put_ado(p, key, request, request_len, value, value_len, root_len, flags, out_response);
+}
+
+/**
+ * Factory entry point
+ *
+ */
+extern "C" void *factory_createInstance(component::uuid_t component_id)
+{
+  if (component_id == MCAS_cluster_client_factory::component_id()) {
+    auto fact = new MCAS_cluster_client_factory();
+    fact->add_ref();
+    return static_cast<void *>(fact);
+  }
+  else {
+    PWRN("%s: request for bad factory type", __func__);
+    return NULL;
+  }
+}
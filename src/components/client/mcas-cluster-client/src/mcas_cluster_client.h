@@ -0,0 +1,376 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef __MCAS_CLUSTER_CLIENT_COMPONENT_H__
+#define __MCAS_CLUSTER_CLIENT_COMPONENT_H__
+
+#include "hash_ring.h"
+
+#include <api/components.h>
+#include <api/kvstore_itf.h>
+#include <api/mcas_itf.h>
+#include <api/itf_ref.h>
+
+#include <boost/optional.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Client of several MCAS shards, presented as one store. Each key is owned
+ * by one shard, chosen by a consistent-hash ring over the shard endpoints,
+ * so an application can use every shard of a multi-core server (or of
+ * several servers) without partitioning its keys by hand.
+ *
+ * A pool is created, opened, closed and deleted on every shard in
+ * parallel; the size and expected object count of a new pool are divided
+ * evenly among the shards. Keyed operations go to the owning shard, and
+ * batched operations are split per shard and issued in parallel. Pool-wide
+ * operations (count, find, scan, statistics) combine the results of all
+ * shards. Offsets returned by find carry the shard index in their top
+ * bits; pool memory offsets are shard-local and so the direct offset
+ * operations are not supported.
+ */
+class MCAS_cluster_client
+    : public virtual component::IKVStore
+    , public virtual component::IMCAS {
+  friend class MCAS_cluster_client_factory;
+
+ public:
+  static constexpr unsigned SHARD_SHIFT = 56; /* position of the shard index in a find offset */
+  static constexpr unsigned MAX_SHARDS  = 1U << (64 - SHARD_SHIFT);
+
+  /**
+   * Constructor
+   *
+   * @param debug_level Debug level (e.g., 0-3)
+   * @param patience Seconds to wait for a single fabric completion
+   * @param src_device NIC device (e.g., mlx5_0)
+   * @param src_addr Source address
+   * @param endpoints Shard addresses and ports (e.g. 10.0.0.22:11911:sockets)
+   *
+   */
+  MCAS_cluster_client(unsigned                            debug_level,
+                      unsigned                            patience,
+                      const boost::optional<std::string> &src_device,
+                      const boost::optional<std::string> &src_addr,
+                      const std::vector<std::string> &    endpoints);
+
+  MCAS_cluster_client(const MCAS_cluster_client &) = delete;
+  MCAS_cluster_client &operator=(const MCAS_cluster_client &) = delete;
+
+  virtual ~MCAS_cluster_client();
+
+  using pool_t = component::IKVStore::pool_t;
+
+  /**
+   * Component/interface management
+   *
+   */
+  DECLARE_VERSION(0.1f);
+
+  // clang-format off
+  DECLARE_COMPONENT_UUID(0x2f666079, 0xcb8a, 0x4724, 0xa454, 0xd1, 0xd8, 0x8d, 0xe2, 0xdb, 0x87);
+  // clang-format on
+
+  void *query_interface(component::uuid_t &itf_uuid) override
+  {
+    if (itf_uuid == component::IKVStore::iid()) {
+      return static_cast<component::IKVStore *>(this);
+    }
+    else if (itf_uuid == component::IMCAS::iid()) {
+      return static_cast<component::IMCAS *>(this);
+    }
+    else {
+      return NULL;  // we don't support this interface
+    }
+  }
+
+  void unload() override { delete this; }
+
+ public:
+  /* IKVStore (as remote proxy) */
+  virtual int thread_safety() const override;
+
+  virtual int get_capability(Capability cap) const override;
+
+  virtual pool_t create_pool(const std::string &name,
+                             const size_t       size,
+                             const unsigned int flags              = 0,
+                             const uint64_t     expected_obj_count = 0) override;
+
+  virtual pool_t open_pool(const std::string &name, const unsigned int flags = 0) override;
+
+  virtual status_t close_pool(const pool_t pool) override;
+
+  virtual status_t delete_pool(const std::string &name) override;
+
+  virtual status_t delete_pool(const IKVStore::pool_t pool) override;
+
+  virtual status_t configure_pool(const component::IKVStore::pool_t pool, const std::string &json) override;
+
+  virtual status_t put(const pool_t       pool,
+                       const std::string &key,
+                       const void *       value,
+                       const size_t       value_len,
+                       const unsigned int flags = IMCAS::FLAGS_NONE) override;
+
+  virtual status_t put_direct(const pool_t                 pool,
+                              const std::string &          key,
+                              const void *                 value,
+                              const size_t                 value_len,
+                              const IMCAS::memory_handle_t handle = IMCAS::MEMORY_HANDLE_NONE,
+                              const unsigned int           flags  = IMCAS::FLAGS_NONE) override;
+
+  virtual status_t async_put(const IKVStore::pool_t pool,
+                             const std::string &    key,
+                             const void *           value,
+                             const size_t           value_len,
+                             async_handle_t &       out_handle,
+                             const unsigned int     flags = IMCAS::FLAGS_NONE) override;
+
+  virtual status_t async_put_direct(const IKVStore::pool_t          pool,
+                                    const std::string &             key,
+                                    const void *                    value,
+                                    const size_t                    value_len,
+                                    async_handle_t &                out_handle,
+                                    const IKVStore::memory_handle_t handle = IMCAS::MEMORY_HANDLE_NONE,
+                                    const unsigned int              flags  = IMCAS::FLAGS_NONE) override;
+
+  virtual status_t check_async_completion(async_handle_t &handle) override;
+
+  virtual status_t get(const pool_t       pool,
+                       const std::string &key,
+                       void *&            out_value, /* release with free_memory() */
+                       size_t &           out_value_len) override;
+
+  virtual status_t async_get(const pool_t       pool,
+                             const std::string &key,
+                             void *&            out_value,
+                             size_t &           out_value_len,
+                             async_handle_t &   out_handle) override;
+
+  virtual status_t async_get_direct(const pool_t                 pool,
+                                    const std::string &          key,
+                                    void *                       out_value,
+                                    size_t &                     out_value_len,
+                                    async_handle_t &             out_handle,
+                                    const IMCAS::memory_handle_t handle = IMCAS::MEMORY_HANDLE_NONE) override;
+
+  virtual status_t get_direct(const pool_t                 pool,
+                              const std::string &          key,
+                              void *                       out_value,
+                              size_t &                     out_value_len,
+                              const IMCAS::memory_handle_t handle = IMCAS::MEMORY_HANDLE_NONE) override;
+
+  virtual status_t get_direct_offset(const IMCAS::pool_t          pool,
+                                     const offset_t               offset,
+                                     size_t &                     length,
+                                     void *                       out_buffer,
+                                     const IMCAS::memory_handle_t handle) override;
+
+  virtual status_t async_get_direct_offset(const IMCAS::pool_t          pool,
+                                           const offset_t               offset,
+                                           size_t &                     length,
+                                           void *                       out_buffer,
+                                           async_handle_t &             out_handle,
+                                           const IMCAS::memory_handle_t handle = IMCAS::MEMORY_HANDLE_NONE) override;
+
+  virtual status_t put_direct_offset(const IMCAS::pool_t          pool,
+                                     const offset_t               offset,
+                                     size_t &                     length,
+                                     const void *                 out_buffer,
+                                     const IMCAS::memory_handle_t handle) override;
+
+  virtual status_t async_put_direct_offset(const IMCAS::pool_t          pool,
+                                           const offset_t               offset,
+                                           size_t &                     length,
+                                           const void *                 out_buffer,
+                                           async_handle_t &             out_handle,
+                                           const IMCAS::memory_handle_t handle = IMCAS::MEMORY_HANDLE_NONE) override;
+
+  virtual status_t erase(const pool_t pool, const std::string &key) override;
+
+  virtual status_t async_erase(const IMCAS::pool_t pool, const std::string &key, async_handle_t &out_handle) override;
+
+  virtual status_t put_batch(const IMCAS::pool_t             pool,
+                             const std::vector<std::string> &keys,
+                             const std::vector<std::string> &values,
+                             std::vector<status_t> &         out_status,
+                             const unsigned int              flags = IMCAS::FLAGS_NONE) override;
+
+  virtual status_t get_batch(const IMCAS::pool_t             pool,
+                             const std::vector<std::string> &keys,
+                             std::vector<std::string> &      out_values,
+                             std::vector<status_t> &         out_status) override;
+
+  virtual status_t erase_batch(const IMCAS::pool_t             pool,
+                               const std::vector<std::string> &keys,
+                               std::vector<status_t> &         out_status) override;
+
+  virtual status_t scan(const IMCAS::pool_t        pool,
+                        const std::string &        key_expression,
+                        std::string &              in_out_cursor,
+                        std::vector<std::string> & out_keys,
+                        std::vector<std::string> * out_values = nullptr,
+                        const size_t               max_keys   = 0) override;
+
+  virtual size_t count(const pool_t pool) override;
+
+  virtual status_t get_attribute(const IKVStore::pool_t    pool,
+                                 const IKVStore::Attribute attr,
+                                 std::vector<uint64_t> &   out_attr,
+                                 const std::string *       key) override;
+
+  virtual status_t get_statistics(Shard_stats &out_stats) override;
+
+  virtual status_t get_latency_statistics(std::vector<Latency_histogram> &out_histograms, bool reset) override;
+
+  virtual void debug(const pool_t pool, const unsigned cmd, const uint64_t arg) override;
+
+  virtual IMCAS::memory_handle_t register_direct_memory(void *vaddr, const size_t len) override;
+
+  virtual status_t unregister_direct_memory(const IMCAS::memory_handle_t handle) override;
+
+  virtual status_t free_memory(void *p) override;
+
+  /* IMCAS specific methods */
+  virtual status_t find(const IKVStore::pool_t pool,
+                        const std::string &    key_expression,
+                        const offset_t         offset,
+                        offset_t &             out_matched_offset,
+                        std::string &          out_matched_key) override;
+
+  virtual status_t invoke_ado(const IKVStore::pool_t            pool,
+                              const std::string &               key,
+                              const void *                      request,
+                              const size_t                      request_len,
+                              const uint32_t                    flags,
+                              std::vector<IMCAS::ADO_response> &out_response,
+                              const size_t                      value_size = 0) override;
+
+  virtual status_t async_invoke_ado(const IMCAS::pool_t               pool,
+                                    const std::string &               key,
+                                    const void *                      request,
+                                    const size_t                      request_len,
+                                    const ado_flags_t                 flags,
+                                    std::vector<IMCAS::ADO_response> &out_response,
+                                    async_handle_t &                  out_async_handle,
+                                    const size_t                      value_size = 0) override;
+
+  virtual status_t invoke_put_ado(const IKVStore::pool_t            pool,
+                                  const std::string &               key,
+                                  const void *                      request,
+                                  const size_t                      request_len,
+                                  const void *                      value,
+                                  const size_t                      value_len,
+                                  const size_t                      root_len,
+                                  const ado_flags_t                 flags,
+                                  std::vector<IMCAS::ADO_response> &out_response) override;
+
+  unsigned shard_count() const { return unsigned(_shards.size()); }
+
+ private:
+  struct pool_set;
+  struct memory_handle_set;
+  struct async_handle_shard;
+
+  /* per-shard pool handles of a cluster pool, or null if not open. Shared,
+     so that a concurrent close does not free them while in use. */
+  std::shared_ptr<const pool_set> get_pool_set(pool_t pool);
+
+  /* remove a cluster pool, returning its handles, or null if not open */
+  std::shared_ptr<const pool_set> take_pool_set(pool_t pool);
+
+  /* owning shard of a key, and the shard's handle for the pool */
+  bool route(pool_t pool, const std::string &key, unsigned &out_shard, pool_t &out_shard_pool);
+
+  /* run f(shard) for each of the shards in parallel; the calling thread runs the last */
+  void fan_out(const std::vector<unsigned> &shards, const std::function<void(unsigned)> &f);
+  void fan_out(const std::function<void(unsigned)> &f);
+
+  /* wrap a shard's async handle, which is then completed by check_async_completion */
+  void wrap_async(unsigned shard, async_handle_t &handle, void **out_value = nullptr);
+
+  /* record (or, if p is null, ignore) memory returned by a shard */
+  void track_memory(unsigned shard, void *p);
+
+  pool_t add_pool_set(std::vector<pool_t> &&pools);
+
+  /* a shard's registration of direct memory registered with the cluster */
+  static IMCAS::memory_handle_t shard_handle(IMCAS::memory_handle_t handle, unsigned shard);
+
+  static component::IMCAS_factory *load_factory();
+
+  unsigned                                        _debug_level;
+  component::Itf_ref<component::IMCAS_factory>    _factory;
+  std::vector<component::Itf_ref<IMCAS>>          _shards;
+  mcas::cluster::Hash_ring                        _ring;
+  std::mutex                                      _pool_sets_lock;
+  std::unordered_map<pool_t, std::shared_ptr<const pool_set>> _pool_sets;
+  std::mutex                                      _memory_lock;
+  std::unordered_map<void *, unsigned>            _memory_owner; /* memory returned by get, by shard */
+};
+
+class MCAS_cluster_client_factory : public component::IMCAS_factory {
+ public:
+  /**
+   * Component/interface management
+   *
+   */
+  DECLARE_VERSION(0.1f);
+
+  // clang-format off
+  DECLARE_COMPONENT_UUID(0xfac66079, 0xcb8a, 0x4724, 0xa454, 0xd1, 0xd8, 0x8d, 0xe2, 0xdb, 0x87);
+  // clang-format on
+
+  void *query_interface(component::uuid_t &itf_uuid) override
+  {
+    if (itf_uuid == component::IMCAS_factory::iid()) {
+      return static_cast<component::IMCAS_factory *>(this);
+    }
+    else if (itf_uuid == component::IKVStore_factory::iid()) {
+      return static_cast<component::IKVStore_factory *>(this);
+    }
+    else
+      return NULL;  // we don't support this interface
+  }
+
+  void unload() override { delete this; }
+
+  /* dest_addr_with_port is a comma-separated list of shards, e.g.
+   * 10.0.0.21:11911,10.0.0.21:11912 or 9.1.75.6:11911:sockets,9.1.75.6:11912:sockets
+   */
+  component::IMCAS *mcas_create(unsigned                            debug_level,
+                                unsigned                            patience,
+                                const std::string &                 owner,
+                                const boost::optional<std::string> &src_nic_device,
+                                const boost::optional<std::string> &src_ip_addr,
+                                const std::string &                 dest_addr_with_port) override;
+
+  component::IKVStore *create(unsigned           debug_level,
+                              const std::string &owner,
+                              const std::string &addr,
+                              const std::string &device) override;
+
+  /* dest_addr and dest_port may each be comma-separated lists; a single
+   * address applies to every port */
+  component::IKVStore *create(unsigned debug_level, const std::map<std::string, std::string> &) override;
+};
+
+#endif
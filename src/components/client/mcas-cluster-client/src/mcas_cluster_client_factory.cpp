@@ -0,0 +1,104 @@
+/*
+  Copyright [2020] [IBM Corporation]
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+  http://www.apache.org/licenses/LICENSE-2.0
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+#include "mcas_cluster_client.h"
+
+#include <common/exceptions.h>
+#include <common/logging.h>
+
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+std::vector<std::string> split_list(const std::string &s)
+{
+  std::vector<std::string> v;
+  std::istringstream       is(s);
+  for (std::string e; std::getline(is, e, ',');) {
+    if (!e.empty()) v.push_back(e);
+  }
+  return v;
+}
+}  // namespace
+
+component::IMCAS *MCAS_cluster_client_factory::mcas_create(unsigned debug_level,
+                                                           unsigned patience,
+                                                           const std::string &,  // owner
+                                                           const boost::optional<std::string> &src_device,
+                                                           const boost::optional<std::string> &src_addr,
+                                                           const std::string &                 dest_addr_port_str)
+try {
+  component::IMCAS *obj = static_cast<component::IMCAS *>(
+      new MCAS_cluster_client(debug_level, patience, src_device, src_addr, split_list(dest_addr_port_str)));
+  obj->add_ref();
+  return obj;
+}
+catch (const std::exception &e) {
+  PLOG("failed to build IMCAS (mcas cluster client): %s", e.what());
+  /* callers expect nullptr to be the sole indication of failure */
+  return nullptr;
+}
+
+component::IKVStore *MCAS_cluster_client_factory::create(unsigned debug_level,
+                                                         const std::string &,  // owner
+                                                         const std::string &addr,
+                                                         const std::string &device)
+{
+  component::IKVStore *obj = static_cast<component::IKVStore *>(
+      new MCAS_cluster_client(debug_level, 60, device, boost::optional<std::string>(), split_list(addr)));
+  /* at least one caller (kvstore-perf) expects a valid pointer or an exception
+   * (and not a null pointer). */
+  obj->add_ref();
+  return obj;
+}
+
+component::IKVStore *MCAS_cluster_client_factory::create(unsigned debug_level, const IKVStore_factory::map_create &p)
+{
+  using opt_str          = boost::optional<std::string>;
+  auto src_addr_it       = p.find(k_src_addr);
+  auto src_addr          = opt_str(src_addr_it == p.end() ? opt_str() : opt_str(src_addr_it->second));
+  auto src_nic_device_it = p.find(k_interface);
+  auto src_nic_device    = opt_str(src_nic_device_it == p.end() ? opt_str() : opt_str(src_nic_device_it->second));
+  auto provider_it       = p.find(k_provider);
+
+  auto dest_addr_it = p.find(k_dest_addr);
+  if (dest_addr_it == p.end()) {
+    throw std::domain_error("'MCAS_cluster_client_factory' create missing 'dest_addr' element");
+  }
+  auto dest_port_it = p.find(k_dest_port);
+  if (dest_port_it == p.end()) {
+    throw std::domain_error("'MCAS_cluster_client_factory' create missing 'dest_port' element");
+  }
+
+  const auto addrs = split_list(dest_addr_it->second);
+  const auto ports = split_list(dest_port_it->second);
+  if (addrs.empty() || (addrs.size() != 1 && addrs.size() != ports.size())) {
+    throw std::domain_error("'MCAS_cluster_client_factory' create needs one 'dest_addr', or one per 'dest_port'");
+  }
+
+  std::vector<std::string> endpoints;
+  for (std::size_t i = 0; i != ports.size(); ++i) {
+    endpoints.push_back(addrs[addrs.size() == 1 ? 0 : i] + ":" + ports[i] +
+                        (provider_it == p.end() ? "" : ":" + provider_it->second));
+  }
+
+  auto           patience_it = p.find(k_patience);
+  const unsigned patience    = patience_it == p.end() ? 120 : unsigned(std::stoul(patience_it->second));
+
+  component::IKVStore *obj = static_cast<component::IKVStore *>(
+      new MCAS_cluster_client(debug_level, patience, src_nic_device, src_addr, endpoints));
+  /* at least one caller (kvstore-perf) expects a valid pointer or an exception
+   * (and not a null pointer). */
+  obj->add_ref();
+  return obj;
+}
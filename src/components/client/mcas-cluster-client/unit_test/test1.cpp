@@ -0,0 +1,232 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+/*
+ * Run against a server with several shards, e.g. a config with shards on
+ * ports 11911-11914 and "net_providers" : "sockets":
+ *
+ *   mcas-cluster-client-test1 --server-addr 10.0.0.21:11911:sockets,10.0.0.21:11912:sockets,...
+ *
+ * The Ring tests need no server.
+ */
+#include "hash_ring.h"
+
+#include <api/components.h>
+#include <api/kvstore_itf.h>
+#include <api/mcas_itf.h>
+#include <common/str_utils.h>
+#include <gtest/gtest.h>
+
+#include <boost/program_options.hpp>
+#include <boost/optional.hpp>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct {
+  std::string                  addr;
+  std::string                  pool;
+  boost::optional<std::string> device;
+  boost::optional<std::string> src_addr;
+  unsigned                     debug_level;
+} Options{};
+
+namespace
+{
+template <typename T>
+boost::optional<T> optional_option(const boost::program_options::variables_map &vm_, const std::string &key_)
+{
+  return 0 < vm_.count(key_) ? vm_[key_].as<T>() : boost::optional<T>();
+}
+}  // namespace
+
+using namespace component;
+
+namespace
+{
+struct mcas_cluster_client_test : public ::testing::Test {
+ protected:
+  static component::Itf_ref<component::IMCAS> _mcas;
+  static component::IMCAS::pool_t             _pool;
+};
+
+component::Itf_ref<component::IMCAS> mcas_cluster_client_test::_mcas;
+component::IMCAS::pool_t             mcas_cluster_client_test::_pool;
+
+std::vector<std::string> shard_names(unsigned n)
+{
+  std::vector<std::string> v;
+  for (unsigned i = 0; i != n; ++i) v.push_back("10.0.0.21:" + std::to_string(11911 + i));
+  return v;
+}
+
+TEST(Ring, Balance)
+{
+  const unsigned           shards = 4;
+  mcas::cluster::Hash_ring ring(shard_names(shards));
+  std::vector<unsigned>    hits(shards, 0);
+  const unsigned           keys = 100000;
+  for (unsigned i = 0; i != keys; ++i) ++hits[ring.shard("key" + std::to_string(i))];
+
+  for (auto h : hits) {
+    EXPECT_GT(h, keys / shards * 8 / 10);
+    EXPECT_LT(h, keys / shards * 12 / 10);
+  }
+}
+
+TEST(Ring, Stability)
+{
+  /* a key moves only to the added shard, and only about 1/N of keys move */
+  mcas::cluster::Hash_ring before(shard_names(4));
+  mcas::cluster::Hash_ring after(shard_names(5));
+  const unsigned           keys  = 100000;
+  unsigned                 moved = 0;
+  for (unsigned i = 0; i != keys; ++i) {
+    const auto k = "key" + std::to_string(i);
+    if (before.shard(k) != after.shard(k)) {
+      ++moved;
+      EXPECT_EQ(4U, after.shard(k));
+    }
+  }
+  EXPECT_LT(moved, keys / 5 * 13 / 10);
+
+  /* the order of shard names does not matter */
+  auto names = shard_names(4);
+  std::swap(names[0], names[3]);
+  mcas::cluster::Hash_ring reordered(names);
+  EXPECT_EQ(names[reordered.shard("some key")], shard_names(4)[before.shard("some key")]);
+}
+
+TEST_F(mcas_cluster_client_test, Instantiate)
+{
+  auto comp = load_component("libcomponent-mcasclusterclient.so", mcas_cluster_client_factory);
+  ASSERT_TRUE(comp);
+  auto fact = make_itf_ref(static_cast<IMCAS_factory *>(comp->query_interface(IMCAS_factory::iid())));
+  ASSERT_TRUE(fact);
+
+  _mcas.reset(fact->mcas_create(Options.debug_level, 30, "owner", Options.device, Options.src_addr, Options.addr));
+  ASSERT_TRUE(_mcas);
+
+  _pool = _mcas->create_pool(Options.pool, MB(32), 0, 1000);
+  ASSERT_NE(IMCAS::POOL_ERROR, _pool);
+}
+
+TEST_F(mcas_cluster_client_test, PutGet)
+{
+  for (unsigned i = 0; i != 1000; ++i) {
+    const auto key = "key" + std::to_string(i);
+    ASSERT_EQ(S_OK, _mcas->put(_pool, key, "value" + std::to_string(i)));
+  }
+  EXPECT_EQ(1000UL, _mcas->count(_pool));
+
+  for (unsigned i = 0; i != 1000; ++i) {
+    std::string value;
+    ASSERT_EQ(S_OK, _mcas->get(_pool, "key" + std::to_string(i), value));
+    EXPECT_EQ("value" + std::to_string(i), value);
+  }
+}
+
+TEST_F(mcas_cluster_client_test, AsyncGet)
+{
+  void *                 value     = nullptr;
+  size_t                 value_len = 0;
+  IMCAS::async_handle_t  handle    = IMCAS::ASYNC_HANDLE_INIT;
+  ASSERT_EQ(S_OK, _mcas->async_get(_pool, "key7", value, value_len, handle));
+  status_t rc;
+  while ((rc = _mcas->check_async_completion(handle)) == E_BUSY) {
+  }
+  ASSERT_EQ(S_OK, rc);
+  EXPECT_EQ("value7", std::string(static_cast<char *>(value), value_len));
+  _mcas->free_memory(value);
+}
+
+TEST_F(mcas_cluster_client_test, Batch)
+{
+  std::vector<std::string> keys;
+  std::vector<std::string> values;
+  for (unsigned i = 0; i != 200; ++i) {
+    keys.push_back(common::random_string(12));
+    values.push_back("batch" + std::to_string(i));
+  }
+
+  std::vector<status_t> status;
+  ASSERT_EQ(S_OK, _mcas->put_batch(_pool, keys, values, status));
+  ASSERT_EQ(keys.size(), status.size());
+  for (auto s : status) EXPECT_EQ(S_OK, s);
+
+  std::vector<std::string> out_values;
+  ASSERT_EQ(S_OK, _mcas->get_batch(_pool, keys, out_values, status));
+  EXPECT_EQ(values, out_values);
+
+  ASSERT_EQ(S_OK, _mcas->erase_batch(_pool, keys, status));
+  for (auto s : status) EXPECT_EQ(S_OK, s);
+  EXPECT_EQ(1000UL, _mcas->count(_pool));
+}
+
+TEST_F(mcas_cluster_client_test, Scan)
+{
+  ASSERT_EQ(S_OK, _mcas->configure_pool(_pool, "AddIndex::VolatileTree"));
+
+  std::vector<std::string> keys;
+  std::string              cursor;
+  status_t                 rc;
+  while ((rc = _mcas->scan(_pool, "prefix:key", cursor, keys, nullptr, 64)) == S_MORE) {
+  }
+  ASSERT_EQ(S_OK, rc);
+  EXPECT_EQ(1000UL, keys.size());
+}
+
+TEST_F(mcas_cluster_client_test, Release)
+{
+  ASSERT_EQ(S_OK, _mcas->close_pool(_pool));
+  ASSERT_EQ(S_OK, _mcas->delete_pool(Options.pool));
+  _mcas.reset();
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+  try {
+    namespace po = boost::program_options;
+    po::options_description desc("Options");
+    desc.add_options()("help", "Show help")("debug", po::value<unsigned>()->default_value(0), "Debug level 0-3")(
+        "server-addr", po::value<std::string>()->default_value("10.0.0.21:11911:sockets,10.0.0.21:11912:sockets"),
+        "Shard addresses IP:PORT[:PROVIDER],...")("device", po::value<std::string>(), "Network device (e.g., mlx5_0)")(
+        "source-addr", po::value<std::string>(), "Local network address, e.g. 1.0.0.20")(
+        "pool", po::value<std::string>()->default_value("myClusterPool"), "Pool name");
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+
+    if (vm.count("help") > 0) {
+      std::cout << desc;
+      return -1;
+    }
+
+    Options.addr        = vm["server-addr"].as<std::string>();
+    Options.debug_level = vm["debug"].as<unsigned>();
+    Options.pool        = vm["pool"].as<std::string>();
+    Options.device      = optional_option<std::string>(vm, "device");
+    Options.src_addr    = optional_option<std::string>(vm, "source-addr");
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+  }
+  catch (...) {
+    PLOG("bad command line option configuration");
+    return -1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,429 @@
+#include "rambtree.h"
+#include <common/logging.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace component;
+using namespace std;
+
+struct RamBTree::node {
+  explicit node(bool is_leaf_) : is_leaf(is_leaf_) {}
+  node(const node&) = delete;
+  node& operator=(const node&) = delete;
+  virtual ~node() {}
+
+  /* number of keys in the subtree */
+  virtual size_t total() const = 0;
+
+  /* returns false if the key was already present. If the node overflows it
+   * is split, and out_right/out_sep receive the new right sibling and the
+   * least key it can hold
+   */
+  virtual bool insert(const string& key, string& out_sep, unique_ptr<node>& out_right) = 0;
+
+  /* returns false if the key was not present */
+  virtual bool erase(const string& key) = 0;
+
+  virtual bool underfull() const = 0;
+
+  /* absorb right, the next sibling, if the two fit in one node. sep is
+   * the parent's separator between them
+   */
+  virtual bool merge(node& right, const string& sep) = 0;
+
+  const bool is_leaf;
+};
+
+struct RamBTree::leaf : public RamBTree::node {
+  leaf() : node(true), bytes(), ends(), next(nullptr) {}
+  leaf(const leaf&) = delete;
+  leaf& operator=(const leaf&) = delete;
+
+  vector<char>     bytes; /* keys, back to back */
+  vector<uint32_t> ends;  /* offset in bytes of the end of each key */
+  leaf*            next;
+
+  unsigned    size() const { return unsigned(ends.size()); }
+  uint32_t    start(unsigned i) const { return i == 0 ? 0 : ends[i - 1]; }
+  const char* data(unsigned i) const { return bytes.data() + start(i); }
+  size_t      length(unsigned i) const { return ends[i] - start(i); }
+  string      key(unsigned i) const { return string(data(i), length(i)); }
+
+  /* <0, 0 or >0 as key i is less than, equal to or greater than k */
+  int compare(unsigned i, const string& k) const
+  {
+    const auto len = length(i);
+    const auto n   = std::min(len, k.size());
+    const int  r   = n ? std::memcmp(data(i), k.data(), n) : 0;
+    return r != 0 ? r : (len < k.size() ? -1 : len > k.size() ? 1 : 0);
+  }
+
+  /* index of the first key not less than (inclusive) or greater than k */
+  unsigned bound(const string& k, bool inclusive) const
+  {
+    unsigned lo = 0, hi = size();
+    while (lo < hi) {
+      const auto mid = (lo + hi) / 2;
+      const auto c   = compare(mid, k);
+      if (c < 0 || (c == 0 && !inclusive))
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    return lo;
+  }
+
+  size_t total() const override { return size(); }
+
+  bool insert(const string& k, string& out_sep, unique_ptr<node>& out_right) override
+  {
+    const auto i = bound(k, true);
+    if (i != size() && compare(i, k) == 0) return false;
+
+    const auto at  = start(i);
+    const auto len = uint32_t(k.size());
+    bytes.insert(bytes.begin() + at, k.begin(), k.end());
+    ends.insert(ends.begin() + i, at + len);
+    for (auto j = i + 1; j != size(); ++j) ends[j] += len;
+
+    if (size() > LEAF_MAX) {
+      auto r = new leaf;
+      out_right.reset(r);
+
+      const auto half = size() / 2;
+      const auto from = start(half);
+      r->bytes.assign(bytes.begin() + from, bytes.end());
+      for (auto j = half; j != size(); ++j) r->ends.push_back(ends[j] - from);
+      bytes.resize(from);
+      ends.resize(half);
+
+      r->next = next;
+      next    = r;
+      out_sep = r->key(0);
+    }
+    return true;
+  }
+
+  bool erase(const string& k) override
+  {
+    const auto i = bound(k, true);
+    if (i == size() || compare(i, k) != 0) return false;
+
+    const auto at  = start(i);
+    const auto len = ends[i] - at;
+    bytes.erase(bytes.begin() + at, bytes.begin() + at + len);
+    ends.erase(ends.begin() + i);
+    for (auto j = i; j != size(); ++j) ends[j] -= len;
+    return true;
+  }
+
+  bool underfull() const override { return size() < LEAF_MAX / 4; }
+
+  bool merge(node& right_, const string&) override
+  {
+    auto& r = static_cast<leaf&>(right_);
+    if (size() + r.size() > LEAF_MAX) return false;
+
+    const auto at = uint32_t(bytes.size());
+    bytes.insert(bytes.end(), r.bytes.begin(), r.bytes.end());
+    for (auto e : r.ends) ends.push_back(e + at);
+    next = r.next;
+    return true;
+  }
+};
+
+struct RamBTree::inner : public RamBTree::node {
+  inner() : node(false), seps(), children(), counts() {}
+
+  /* seps[i] is greater than every key in children[i], and not greater
+   * than any key in children[i+1]
+   */
+  vector<string>            seps;
+  vector<unique_ptr<node>>  children;
+  vector<size_t>            counts; /* keys in each child subtree */
+
+  unsigned size() const { return unsigned(children.size()); }
+
+  /* the child which holds k, if present */
+  unsigned child_for(const string& k) const { return unsigned(std::upper_bound(seps.begin(), seps.end(), k) - seps.begin()); }
+
+  size_t total() const override
+  {
+    size_t n = 0;
+    for (auto c : counts) n += c;
+    return n;
+  }
+
+  bool insert(const string& k, string& out_sep, unique_ptr<node>& out_right) override
+  {
+    const auto       c = child_for(k);
+    string           child_sep;
+    unique_ptr<node> child_right;
+    if (!children[c]->insert(k, child_sep, child_right)) return false;
+
+    if (!child_right) {
+      ++counts[c];
+      return true;
+    }
+
+    counts[c] = children[c]->total();
+    counts.insert(counts.begin() + c + 1, child_right->total());
+    seps.insert(seps.begin() + c, std::move(child_sep));
+    children.insert(children.begin() + c + 1, std::move(child_right));
+
+    if (size() > INNER_MAX) {
+      auto r = new inner;
+      out_right.reset(r);
+
+      const auto half = size() / 2;
+      out_sep         = std::move(seps[half - 1]);
+      std::move(seps.begin() + half, seps.end(), std::back_inserter(r->seps));
+      std::move(children.begin() + half, children.end(), std::back_inserter(r->children));
+      r->counts.assign(counts.begin() + half, counts.end());
+      seps.resize(half - 1);
+      children.resize(half);
+      counts.resize(half);
+    }
+    return true;
+  }
+
+  bool erase(const string& k) override
+  {
+    const auto c = child_for(k);
+    if (!children[c]->erase(k)) return false;
+    --counts[c];
+
+    /* merge an underfull child with a neighbour, if the two fit in one node */
+    if (children[c]->underfull()) {
+      if (!(c + 1 != size() && merge_children(c)) && c != 0) merge_children(c - 1);
+    }
+    return true;
+  }
+
+  bool underfull() const override { return size() < INNER_MAX / 4; }
+
+  bool merge(node& right_, const string& sep) override
+  {
+    auto& r = static_cast<inner&>(right_);
+    if (size() + r.size() > INNER_MAX) return false;
+
+    seps.push_back(sep);
+    std::move(r.seps.begin(), r.seps.end(), std::back_inserter(seps));
+    std::move(r.children.begin(), r.children.end(), std::back_inserter(children));
+    counts.insert(counts.end(), r.counts.begin(), r.counts.end());
+    return true;
+  }
+
+ private:
+  /* absorb children[i+1] into children[i] */
+  bool merge_children(unsigned i)
+  {
+    if (!children[i]->merge(*children[i + 1], seps[i])) return false;
+    counts[i] += counts[i + 1];
+    counts.erase(counts.begin() + i + 1);
+    children.erase(children.begin() + i + 1);
+    seps.erase(seps.begin() + i);
+    return true;
+  }
+};
+
+namespace
+{
+/* move a cursor which is past the end of its leaf to the next key; l is
+ * null at the end of the index
+ */
+template <typename C>
+void skip_to_key(C& c)
+{
+  while (c.l && c.i == c.l->size()) {
+    c.l = c.l->next;
+    c.i = 0;
+  }
+}
+
+template <typename C>
+void advance_cursor(C& c)
+{
+  ++c.i;
+  skip_to_key(c);
+}
+}  // namespace
+
+RamBTree::RamBTree(const std::string& owner, const std::string& name)
+	: RamBTree{}
+{
+	(void)owner; // unused
+	(void)name; // unused;
+}
+
+RamBTree::RamBTree() : _root(new leaf), _count(0) {}
+
+RamBTree::~RamBTree() {}
+
+void RamBTree::insert(const string& key)
+{
+  string           sep;
+  unique_ptr<node> right;
+  if (!_root->insert(key, sep, right)) return;
+  ++_count;
+
+  if (right) { /* root split: grow the tree by one level */
+    auto r = new inner;
+    r->counts.push_back(_root->total());
+    r->counts.push_back(right->total());
+    r->seps.push_back(std::move(sep));
+    r->children.push_back(std::move(_root));
+    r->children.push_back(std::move(right));
+    _root.reset(r);
+  }
+}
+
+void RamBTree::erase(const std::string& key)
+{
+  if (!_root->erase(key)) return;
+  --_count;
+
+  /* shrink the tree while the root has a single child */
+  while (!_root->is_leaf && static_cast<inner*>(_root.get())->size() == 1) {
+    unique_ptr<node> child(std::move(static_cast<inner*>(_root.get())->children[0]));
+    _root = std::move(child);
+  }
+}
+
+void RamBTree::clear()
+{
+  _root.reset(new leaf);
+  _count = 0;
+}
+
+RamBTree::cursor_t RamBTree::locate(offset_t position) const
+{
+  assert(position < _count);
+  const node* n = _root.get();
+  while (!n->is_leaf) {
+    auto     in = static_cast<const inner*>(n);
+    unsigned c  = 0;
+    while (position >= in->counts[c]) {
+      position -= in->counts[c];
+      ++c;
+    }
+    n = in->children[c].get();
+  }
+  return cursor_t{static_cast<const leaf*>(n), unsigned(position)};
+}
+
+RamBTree::cursor_t RamBTree::lower_bound(const std::string& key, const bool inclusive, offset_t& out_position) const
+{
+  out_position  = 0;
+  const node* n = _root.get();
+  while (!n->is_leaf) {
+    auto in = static_cast<const inner*>(n);
+    auto c  = in->child_for(key);
+    for (unsigned i = 0; i != c; ++i) out_position += in->counts[i];
+    n = in->children[c].get();
+  }
+
+  auto l = static_cast<const leaf*>(n);
+  cursor_t cur{l, l->bound(key, inclusive)};
+  out_position += cur.i;
+  skip_to_key(cur); /* the bound may be past the end of the leaf */
+  return cur;
+}
+
+string RamBTree::get(offset_t position) const
+{
+  if (position >= _count) {
+    throw out_of_range("Position out of range");
+  }
+
+  auto c = locate(position);
+  return c.l->key(c.i);
+}
+
+size_t RamBTree::count() const { return _count; }
+
+status_t RamBTree::find(const std::string& key_expression,
+                        offset_t           begin_position,
+                        find_t             find_type,
+                        offset_t&          out_matched_pos,
+                        std::string&       out_matched_key,
+                        unsigned           max_comparisons)
+{
+  if (begin_position >= _count) {
+    return E_FAIL;
+  }
+
+  return find(*create_matcher(find_type, key_expression), begin_position, out_matched_pos, out_matched_key,
+              max_comparisons);
+}
+
+status_t RamBTree::find(const common::Key_matcher& matcher,
+                        offset_t                   begin_position,
+                        offset_t&                  out_matched_pos,
+                        std::string&               out_matched_key,
+                        unsigned                   max_comparisons)
+{
+  if (begin_position >= _count) {
+    return E_FAIL;
+  }
+
+  /* keys sharing the matcher's literal prefix are contiguous: seek to the
+     first of them, and stop after the last */
+  cursor_t c{nullptr, 0};
+  offset_t pos = 0;
+  if (!matcher.prefix().empty()) {
+    c = lower_bound(matcher.prefix(), true, pos);
+    if (!c.l) return E_FAIL;
+  }
+  if (!c.l || pos < begin_position) {
+    c   = locate(begin_position);
+    pos = begin_position;
+  }
+
+  unsigned attempts = 0;
+  for (; c.l; advance_cursor(c), ++pos) {
+    const auto p   = c.l->data(c.i);
+    const auto len = c.l->length(c.i);
+    if (!matcher.has_prefix(p, len)) break;
+
+    if (matcher.match(p, len)) {
+      out_matched_key.assign(p, len);
+      out_matched_pos = pos;
+      return S_OK;
+    }
+    if (max_comparisons && ++attempts > max_comparisons) {
+      out_matched_pos = pos;
+      return E_MAX_REACHED;
+    }
+  }
+
+  return E_FAIL;
+}
+
+status_t RamBTree::scan(const std::string&                             from,
+                        const bool                                     inclusive,
+                        const std::function<bool(const std::string&)>& visit)
+{
+  offset_t pos;
+  string   key;
+  for (auto c = lower_bound(from, inclusive, pos); c.l; advance_cursor(c)) {
+    key.assign(c.l->data(c.i), c.l->length(c.i));
+    if (!visit(key)) return S_MORE;
+  }
+  return S_OK;
+}
+
+/**
+ * Factory entry point
+ *
+ */
+extern "C" void* factory_createInstance(component::uuid_t component_id)
+{
+  if (component_id == RamBTree_factory::component_id()) {
+    return static_cast<void*>(new RamBTree_factory());
+  }
+  else
+    return NULL;
+}
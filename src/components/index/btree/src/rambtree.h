@@ -0,0 +1,116 @@
+/*
+ * (C) Copyright IBM Corporation 2018, 2020. All rights reserved.
+ *
+ */
+
+#ifndef __RAMBTREE_COMPONENT_H__
+#define __RAMBTREE_COMPONENT_H__
+
+#include <api/kvindex_itf.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Volatile B+-tree index. Leaves hold up to LEAF_MAX keys packed into a
+ * single buffer and are chained for in-order iteration. Inner nodes keep
+ * the key count of each subtree, so positional access (get, find) is
+ * O(log n) rather than the O(n) of walking an ordered set.
+ *
+ * Not thread safe: as with RamRBTree, callers (the shard thread which owns
+ * the pool) serialize access.
+ */
+class RamBTree : public component::IKVIndex {
+ public:
+  static constexpr unsigned LEAF_MAX  = 64;
+  static constexpr unsigned INNER_MAX = 64;
+
+  RamBTree(const std::string& owner, const std::string& name);
+  RamBTree();
+  RamBTree(const RamBTree&) = delete;
+  RamBTree& operator=(const RamBTree&) = delete;
+  virtual ~RamBTree();
+
+  DECLARE_VERSION(0.1f);
+  DECLARE_COMPONENT_UUID(0x8a120985, 0x1253, 0x404d, 0x94d7, 0x77, 0x92, 0x75, 0x21, 0xa1, 0x2a); //
+
+  void* query_interface(component::uuid_t& itf_uuid) override
+  {
+    if (itf_uuid == component::IKVIndex::iid()) {
+      return static_cast<component::IKVIndex*>(this);
+    }
+    else
+      return NULL;  // we don't support this interface
+  }
+
+  void unload() override { delete this; }
+
+ public:
+  virtual void        insert(const std::string& key) override;
+  virtual void        erase(const std::string& key) override;
+  virtual void        clear() override;
+  virtual std::string get(offset_t position) const override;
+  virtual size_t      count() const override;
+  virtual status_t    find(const std::string& key_expression,
+                           offset_t           begin_position,
+                           find_t             find_type,
+                           offset_t&          out_end_position,
+                           std::string&       out_matched_key,
+                           unsigned           max_comparisons = 0) override;
+  virtual status_t    find(const common::Key_matcher& matcher,
+                           offset_t                   begin_position,
+                           offset_t&                  out_end_position,
+                           std::string&               out_matched_key,
+                           unsigned                   max_comparisons = 0) override;
+  virtual status_t    scan(const std::string&                             from,
+                           bool                                           inclusive,
+                           const std::function<bool(const std::string&)>& visit) override;
+
+ private:
+  struct node;
+  struct leaf;
+  struct inner;
+
+  /* position of a key: a leaf and an index within it */
+  struct cursor_t {
+    const leaf* l;
+    unsigned    i;
+  };
+
+  cursor_t locate(offset_t position) const;
+  /* first key not less than (inclusive) or greater than key, and its position */
+  cursor_t lower_bound(const std::string& key, bool inclusive, offset_t& out_position) const;
+
+  std::unique_ptr<node> _root;
+  size_t                _count;
+};
+
+class RamBTree_factory : public component::IKVIndex_factory {
+ public:
+  DECLARE_VERSION(0.1f);
+  DECLARE_COMPONENT_UUID(0xfac20985, 0x1253, 0x404d, 0x94d7, 0x77, 0x92, 0x75, 0x21, 0xa1, 0x2a); //
+
+  void* query_interface(component::uuid_t& itf_uuid) override
+  {
+    if (itf_uuid == component::IKVIndex_factory::iid()) {
+      return static_cast<component::IKVIndex_factory*>(this);
+    }
+    else
+      return NULL;  // we don't support this interface
+  }
+
+  void unload() override { delete this; }
+
+  virtual component::IKVIndex* create(const std::string& owner,
+                                      const std::string& name) override
+  {
+    component::IKVIndex* obj =
+        static_cast<component::IKVIndex*>(new RamBTree(owner, name));
+    assert(obj);
+    obj->add_ref();
+    return obj;
+  }
+};
+#endif
@@ -0,0 +1,199 @@
+/* note: we do not include component source, only the API definition */
+#include <api/components.h>
+#include <api/kvindex_itf.h>
+#include <common/str_utils.h>
+#include <common/utils.h>
+#include <gtest/gtest.h>
+#include <ctime>
+#include <set>
+
+#define COUNT 1000000
+#define LENGTH 16
+
+using namespace component;
+using namespace common;
+using namespace std;
+
+namespace
+{
+// The fixture for testing the btree index.
+class KVIndex_test : public ::testing::Test {
+ protected:
+  // Objects declared here can be used by all tests in the test case
+  static component::IKVIndex *_kvindex;
+  static set<string>          _reference;
+};
+
+component::IKVIndex *KVIndex_test::_kvindex;
+set<string>          KVIndex_test::_reference;
+
+TEST_F(KVIndex_test, Instantiate)
+{
+  /* create object instance through factory */
+  component::IBase *comp = component::load_component(
+      "libcomponent-indexbtree.so", component::btreeindex_factory);
+
+  ASSERT_TRUE(comp);
+  auto fact =
+    make_itf_ref(
+      static_cast<IKVIndex_factory *>(comp->query_interface(IKVIndex_factory::iid()))
+    );
+
+  _kvindex = fact->create("owner", "name");
+}
+
+TEST_F(KVIndex_test, InsertPerf)
+{
+  string *keys = new string[COUNT];
+  for (int i = 0; i < COUNT; i++) {
+    keys[i] = random_string(LENGTH);
+  }
+  clock_t start = clock();
+  for (int i = 0; i < COUNT; i++) {
+    _kvindex->insert(keys[i]);
+  }
+  double duration = double(clock() - start) / double(CLOCKS_PER_SEC);
+  PINF("Time sec: %lf", duration);
+  PINF("Size: %ld", _kvindex->count());
+
+  _reference.insert(keys, keys + COUNT);
+  delete[] keys;
+  ASSERT_EQ(_reference.size(), _kvindex->count());
+}
+
+TEST_F(KVIndex_test, Order)
+{
+  /* positional access agrees with an ordered set */
+  offset_t pos = 0;
+  for (auto &k : _reference) {
+    if (pos % 997 == 0) {
+      ASSERT_EQ(k, _kvindex->get(pos));
+    }
+    ++pos;
+  }
+  ASSERT_THROW(_kvindex->get(pos), std::out_of_range);
+
+  /* as does a full scan */
+  auto it = _reference.begin();
+  ASSERT_EQ(S_OK, _kvindex->scan("", true, [&it](const string &k) { return k == *it++; }));
+  ASSERT_TRUE(it == _reference.end());
+}
+
+TEST_F(KVIndex_test, EraseHalf)
+{
+  /* erase every other key, leaving sparse leaves to be merged */
+  bool odd = false;
+  for (auto it = _reference.begin(); it != _reference.end();) {
+    if ((odd = !odd)) {
+      _kvindex->erase(*it);
+      it = _reference.erase(it);
+    }
+    else
+      ++it;
+  }
+  ASSERT_EQ(_reference.size(), _kvindex->count());
+
+  offset_t pos = 0;
+  for (auto &k : _reference) {
+    if (pos % 997 == 0) {
+      ASSERT_EQ(k, _kvindex->get(pos));
+    }
+    ++pos;
+  }
+}
+
+TEST_F(KVIndex_test, Clean)
+{
+  _kvindex->clear();
+  _reference.clear();
+  ASSERT_EQ(0UL, _kvindex->count());
+}
+
+TEST_F(KVIndex_test, Insert)
+{
+  string key = "MyKey1";
+  _kvindex->insert(key);
+  key = "MyKey2";
+  _kvindex->insert(key);
+  key = "abc";
+  _kvindex->insert(key);
+  _kvindex->insert(key); /* duplicate */
+  ASSERT_EQ(3UL, _kvindex->count());
+}
+
+TEST_F(KVIndex_test, Get)
+{
+  EXPECT_EQ("MyKey1", _kvindex->get(0));
+  EXPECT_EQ("MyKey2", _kvindex->get(1));
+  EXPECT_EQ("abc", _kvindex->get(2));
+}
+
+TEST_F(KVIndex_test, Scan)
+{
+  vector<string> keys;
+  auto collect = [&keys](const string &k) { keys.push_back(k); return true; };
+
+  ASSERT_EQ(S_OK, _kvindex->scan("MyKey1", false, collect));
+  ASSERT_EQ(2UL, keys.size());
+  EXPECT_EQ("MyKey2", keys[0]);
+
+  keys.clear();
+  ASSERT_EQ(S_MORE, _kvindex->scan("MyKey", true, [&keys](const string &k) {
+    keys.push_back(k);
+    return false;
+  }));
+  ASSERT_EQ(1UL, keys.size());
+  EXPECT_EQ("MyKey1", keys[0]);
+}
+
+TEST_F(KVIndex_test, FIND)
+{
+  offset_t pos;
+  string   key;
+  ASSERT_EQ(S_OK, _kvindex->find("abc", 0, IKVIndex::FIND_TYPE_EXACT, pos, key));
+  EXPECT_EQ(2UL, pos);
+  ASSERT_EQ(E_FAIL, _kvindex->find("MyKey1", 1, IKVIndex::FIND_TYPE_EXACT, pos, key));
+
+  ASSERT_EQ(S_OK, _kvindex->find("MyKey.*", 1, IKVIndex::FIND_TYPE_REGEX, pos, key));
+  EXPECT_EQ("MyKey2", key);
+  EXPECT_EQ(1UL, pos);
+
+  ASSERT_EQ(S_OK, _kvindex->find("ab", 0, IKVIndex::FIND_TYPE_PREFIX, pos, key));
+  EXPECT_EQ("abc", key);
+  ASSERT_EQ(E_FAIL, _kvindex->find("bc", 0, IKVIndex::FIND_TYPE_PREFIX, pos, key));
+
+  ASSERT_EQ(S_OK, _kvindex->find("bc", 0, IKVIndex::FIND_TYPE_SUBSTRING, pos, key));
+  EXPECT_EQ("abc", key);
+
+  ASSERT_EQ(E_MAX_REACHED, _kvindex->find(".*c", 0, IKVIndex::FIND_TYPE_REGEX, pos, key, 1));
+  EXPECT_EQ(1UL, pos);
+
+  /* a compiled expression, reused */
+  auto matcher = IKVIndex::create_matcher(IKVIndex::FIND_TYPE_REGEX, "MyKey[0-9]");
+  ASSERT_EQ(S_OK, _kvindex->find(*matcher, 0, pos, key));
+  EXPECT_EQ("MyKey1", key);
+  ASSERT_EQ(S_OK, _kvindex->find(*matcher, pos + 1, pos, key));
+  EXPECT_EQ("MyKey2", key);
+  ASSERT_EQ(E_FAIL, _kvindex->find(*matcher, pos + 1, pos, key));
+}
+
+TEST_F(KVIndex_test, Erase)
+{
+  _kvindex->erase("MyKey");
+  ASSERT_EQ(3UL, _kvindex->count());
+  _kvindex->erase("MyKey1");
+  ASSERT_EQ(2UL, _kvindex->count());
+  EXPECT_EQ("MyKey2", _kvindex->get(0));
+}
+
+TEST_F(KVIndex_test, Release) { _kvindex->release_ref(); }
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  auto r = RUN_ALL_TESTS();
+
+  return r;
+}
@@ -0,0 +1,105 @@
+/* Benchmark: rbtree index versus btree index */
+#include <api/components.h>
+#include <api/kvindex_itf.h>
+#include <common/str_utils.h>
+#include <common/utils.h>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdlib>
+#include <random>
+
+#define COUNT 10000000
+#define LENGTH 16
+#define GET_COUNT 1000
+#define SEEK_COUNT 100000
+
+using namespace component;
+using namespace common;
+using namespace std;
+
+namespace
+{
+class KVIndex_perf : public ::testing::Test {
+ protected:
+  static void SetUpTestCase()
+  {
+    /* INDEX_PERF_COUNT overrides the default of ten million keys */
+    auto   env   = getenv("INDEX_PERF_COUNT");
+    size_t count = env ? size_t(atol(env)) : COUNT;
+    _keys.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+      _keys.push_back(random_string(LENGTH));
+    }
+  }
+
+  static void TearDownTestCase() { _keys.clear(); }
+
+  static double since(chrono::steady_clock::time_point start)
+  {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  }
+
+  static void run(const char *lib, const component::uuid_t &factory_id)
+  {
+    component::IBase *comp = component::load_component(lib, factory_id);
+    ASSERT_TRUE(comp);
+    auto fact = make_itf_ref(static_cast<IKVIndex_factory *>(comp->query_interface(IKVIndex_factory::iid())));
+    auto index = make_itf_ref(fact->create("owner", "name"));
+
+    auto start = chrono::steady_clock::now();
+    for (auto &k : _keys) index->insert(k);
+    PINF("%s: insert %lu keys: %lf sec", lib, _keys.size(), since(start));
+
+    const auto n = index->count();
+    mt19937_64 rng(1);
+
+    start = chrono::steady_clock::now();
+    size_t len = 0;
+    for (unsigned i = 0; i < GET_COUNT; i++) len += index->get(rng() % n).size();
+    PINF("%s: %u positional gets: %lf sec", lib, GET_COUNT, since(start));
+
+    /* ordered seek to a random prefix and read the next few keys */
+    start = chrono::steady_clock::now();
+    for (unsigned i = 0; i < SEEK_COUNT; i++) {
+      unsigned visited = 0;
+      index->scan(random_string(3), true, [&](const string &k) {
+        len += k.size();
+        return ++visited < 10;
+      });
+    }
+    PINF("%s: %u prefix seeks: %lf sec", lib, SEEK_COUNT, since(start));
+
+    start = chrono::steady_clock::now();
+    size_t scanned = 0;
+    ASSERT_EQ(S_OK, index->scan("", true, [&](const string &) {
+      ++scanned;
+      return true;
+    }));
+    ASSERT_EQ(n, scanned);
+    PINF("%s: full scan: %lf sec", lib, since(start));
+
+    start = chrono::steady_clock::now();
+    for (auto &k : _keys) index->erase(k);
+    PINF("%s: erase: %lf sec", lib, since(start));
+    ASSERT_EQ(0UL, index->count());
+    PLOG("(%lu)", len);
+  }
+
+  static vector<string> _keys;
+};
+
+vector<string> KVIndex_perf::_keys;
+
+TEST_F(KVIndex_perf, RBTree) { run("libcomponent-indexrbtree.so", component::rbtreeindex_factory); }
+
+TEST_F(KVIndex_perf, BTree) { run("libcomponent-indexbtree.so", component::btreeindex_factory); }
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  auto r = RUN_ALL_TESTS();
+
+  return r;
+}
@@ -1,6 +1,5 @@
 #include "ramrbtree.h"
 #include <stdlib.h>
-#include <regex>
 #include <set>
 
 #define SINGLE_THREADED
@@ -55,64 +54,63 @@ status_t RamRBTree::find(const std::string& key_expression,
     return E_FAIL;
   }
 
-  offset_t end_position = _index.size();
-  unsigned attempts =0;
-
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wswitch" // enumeration value ‘FIND_TYPE_NONE’ not handled in switch
-  switch (find_type) {
-    case FIND_TYPE_REGEX:
-      {
-        std::regex r(key_expression);
-        for (out_matched_pos = begin_position; out_matched_pos <= end_position; out_matched_pos++) {
-          string key = RamRBTree::get(out_matched_pos);
-          if (regex_match(key, r)) {
-            out_matched_key = key;
-            return S_OK;
-          }
-          else {
-            if(++attempts > max_comparisons)
-              return E_MAX_REACHED;
-          }
-        }
-      }
-      break;
-    case FIND_TYPE_EXACT:
-      for (out_matched_pos = begin_position; out_matched_pos <= end_position; out_matched_pos++) {
-        PLOG("Getting from position %lu", out_matched_pos);
-        string key = RamRBTree::get(out_matched_pos);
-        if (key.compare(key_expression) == 0) {
-          out_matched_key = key;
-          return S_OK;
-        }
-        else {
-          if(++attempts > max_comparisons)
-            return E_MAX_REACHED;
-        }
-      }
-      break;
-    case FIND_TYPE_PREFIX:
-      for (out_matched_pos = begin_position; out_matched_pos <= end_position; out_matched_pos++) {
-        string key = RamRBTree::get(out_matched_pos);
-        if (key.find(key_expression) != string::npos) {
-          out_matched_key = key;
-          return S_OK;
-        }
-      }
-      break;
-    case FIND_TYPE_NEXT:
-      if(begin_position >= end_position)
-        return E_FAIL;
-      out_matched_key = get(begin_position);
-      out_matched_pos = begin_position;
+  return find(*create_matcher(find_type, key_expression), begin_position, out_matched_pos, out_matched_key,
+              max_comparisons);
+}
+
+status_t RamRBTree::find(const common::Key_matcher& matcher,
+                         offset_t                   begin_position,
+                         offset_t&                  out_matched_pos,
+                         std::string&               out_matched_key,
+                         unsigned                   max_comparisons)
+{
+  if (begin_position >= _index.size()) {
+    return E_FAIL;
+  }
+
+  /* keys sharing the matcher's literal prefix are contiguous: seek to the
+     first of them, and stop after the last */
+  const auto& prefix = matcher.prefix();
+  auto        it     = _index.begin();
+  offset_t    pos    = 0;
+  if (!prefix.empty()) {
+    it  = _index.lower_bound(prefix);
+    pos = offset_t(distance(_index.begin(), it));
+  }
+  if (pos < begin_position) {
+    it  = _index.begin();
+    advance(it, begin_position);
+    pos = begin_position;
+  }
+
+  unsigned attempts = 0;
+  for (; it != _index.end(); ++it, ++pos) {
+    if (!matcher.has_prefix(it->data(), it->size())) break;
+
+    if (matcher.match(*it)) {
+      out_matched_key = *it;
+      out_matched_pos = pos;
       return S_OK;
-      break;
+    }
+    if (max_comparisons && ++attempts > max_comparisons) {
+      out_matched_pos = pos;
+      return E_MAX_REACHED;
+    }
   }
-#pragma GCC diagnostic pop
 
   return E_FAIL;
 }
 
+status_t RamRBTree::scan(const std::string&                             from,
+                         const bool                                     inclusive,
+                         const std::function<bool(const std::string&)>& visit)
+{
+  for (auto it = inclusive ? _index.lower_bound(from) : _index.upper_bound(from); it != _index.end(); ++it) {
+    if (!visit(*it)) return S_MORE;
+  }
+  return S_OK;
+}
+
 /**
  * Factory entry point
  *
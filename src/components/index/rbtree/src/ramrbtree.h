@@ -41,6 +41,14 @@ class RamRBTree : public component::IKVIndex {
                            offset_t&          out_end_position,
                            std::string&       out_matched_key,
                            unsigned           max_comparisons = 0) override;
+  virtual status_t    find(const common::Key_matcher& matcher,
+                           offset_t                   begin_position,
+                           offset_t&                  out_end_position,
+                           std::string&               out_matched_key,
+                           unsigned                   max_comparisons = 0) override;
+  virtual status_t    scan(const std::string&                             from,
+                           bool                                           inclusive,
+                           const std::function<bool(const std::string&)>& visit) override;
 private:
   std::set<std::string> _index;
 };
@@ -93,6 +93,32 @@ TEST_F(KVIndex_test, Get)
   PINF("Key= %s", a.c_str());
 }
 
+TEST_F(KVIndex_test, Scan)
+{
+  vector<string> keys;
+  auto collect = [&keys](const string &k) { keys.push_back(k); return true; };
+
+  ASSERT_EQ(S_OK, _kvindex->scan("", true, collect));
+  ASSERT_EQ(3UL, keys.size());
+  EXPECT_EQ("MyKey1", keys[0]);
+  EXPECT_EQ("abc", keys[2]);
+
+  /* resume after a key */
+  keys.clear();
+  ASSERT_EQ(S_OK, _kvindex->scan("MyKey1", false, collect));
+  ASSERT_EQ(2UL, keys.size());
+  EXPECT_EQ("MyKey2", keys[0]);
+
+  /* stopped by the visitor */
+  keys.clear();
+  ASSERT_EQ(S_MORE, _kvindex->scan("MyKey", true, [&keys](const string &k) {
+    keys.push_back(k);
+    return keys.size() < 1;
+  }));
+  ASSERT_EQ(1UL, keys.size());
+  EXPECT_EQ("MyKey1", keys[0]);
+}
+
 TEST_F(KVIndex_test, FIND)
 {
   string   regex = "abc";
@@ -100,6 +126,12 @@ TEST_F(KVIndex_test, FIND)
   string   key;
   _kvindex->find(regex, 0, IKVIndex::FIND_TYPE_EXACT, end, key);
   PINF("Key= %s", key.c_str());
+
+  ASSERT_EQ(S_OK, _kvindex->find("MyK", 0, IKVIndex::FIND_TYPE_PREFIX, end, key));
+  EXPECT_EQ("MyKey1", key);
+  ASSERT_EQ(E_FAIL, _kvindex->find("Key", 0, IKVIndex::FIND_TYPE_PREFIX, end, key));
+  ASSERT_EQ(S_OK, _kvindex->find("Key2", 0, IKVIndex::FIND_TYPE_SUBSTRING, end, key));
+  EXPECT_EQ("MyKey2", key);
 }
 
 TEST_F(KVIndex_test, Erase) { _kvindex->erase("MyKey"); }
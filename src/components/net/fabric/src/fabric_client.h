@@ -134,6 +134,7 @@ public:
    */
   void wait_for_next_completion(std::chrono::milliseconds timeout) override { return Fabric_op_control::wait_for_next_completion(timeout); };
   void unblock_completions() override { return Fabric_op_control::unblock_completions(); };
+  bool arm_wait(std::vector<int> &fds) override { return Fabric_op_control::arm_wait(fds); };
   /* END IFabric_op_completer */
 
   /**
@@ -19,6 +19,7 @@
 #include "fabric_ptr.h" /* fid_unique_ptr */
 #include "rdma-fi_domain.h" /* fi_cq_attr, fi_cq_err_entry, fi_cq_data_entry, FI_CQ_FORMAT_DATA */
 #include <common/delete_copy.h>
+#include <atomic>
 #include <cstddef> /* size_t */
 #include <cstdint> /* uint64_t */
 #include <queue>
@@ -41,7 +42,8 @@ public:
 private:
   fid_unique_ptr<::fid_cq> _cq;
   const char *_type;
-  std::size_t _inflight;
+  /* incremented by posting threads, decremented by the polling thread */
+  std::atomic<std::size_t> _inflight;
 
   using completion_t = std::tuple<::status_t, fi_cq_entry_t>;
   /* completions forwarded to client but deferred (client returned DEFER), to be retried later */
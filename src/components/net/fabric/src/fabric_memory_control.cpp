@@ -150,7 +150,7 @@ auto Fabric_memory_control::register_memory(const void * addr_, std::size_t size
                           size_,
                           std::uint64_t(FI_SEND|FI_RECV|FI_READ|FI_WRITE|FI_REMOTE_READ|FI_REMOTE_WRITE),
                           key_,
-                          flags_)
+                          flags_ & ~component::IFabric_connection::MR_FLAG_SHAREABLE)
       , addr_
       , size_
     );
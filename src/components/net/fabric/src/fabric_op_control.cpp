@@ -529,6 +529,40 @@ void Fabric_op_control::wait_for_next_completion(unsigned polls_limit)
   }
 }
 
+/**
+ * Prepare to wait for a completion on the cq file descriptors.
+ *
+ * @param fds_ Receives the cq file descriptors
+ *
+ * @return false if the caller must not block: completions are, or may
+ * be, waiting, or the connection is shut down
+ */
+bool Fabric_op_control::arm_wait(std::vector<int> &fds_)
+{
+#if USE_WAIT_SETS
+  (void) fds_;
+  return false;
+#else
+  if ( _shut_down || stalled_completion_count() != 0 )
+  {
+    return false;
+  }
+  static constexpr unsigned cq_count = 2;
+  ::fid_t f[cq_count] = { _rxcq.fid(), _txcq.fid() };
+  if ( fabric().trywait(f, cq_count) != FI_SUCCESS )
+  {
+    return false;
+  }
+  for ( unsigned i = 0; i != cq_count; ++i )
+  {
+    int fd;
+    CHECK_FI_ERR(::fi_control(f[i], FI_GETWAIT, &fd));
+    fds_.push_back(fd);
+  }
+  return true;
+#endif
+}
+
 /**
  * Unblock any threads waiting on completions
  *
@@ -197,6 +197,10 @@ public:
    */
   void wait_for_next_completion(std::chrono::milliseconds timeout) override;
   void unblock_completions() override;
+  /*
+   * @throw fabric_runtime_error : std::runtime_error : ::fi_control fail
+   */
+  bool arm_wait(std::vector<int> &fds) override;
 
   std::string get_peer_addr() override;
   std::string get_local_addr() override;
@@ -51,6 +51,8 @@ public:
    */
   component::IFabric_server* get_new_connection() override;
 
+  bool arm_wait(std::vector<int> &fds) override { return Fabric_server_generic_factory::arm_wait(fds); }
+
   void close_connection(component::IFabric_server* connection) override;
 
   std::vector<component::IFabric_server*> connections() override;
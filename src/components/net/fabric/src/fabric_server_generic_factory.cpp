@@ -326,6 +326,13 @@ Fabric_memory_control * Fabric_server_generic_factory::get_new_connection()
   return nullptr;
 }
 
+bool Fabric_server_generic_factory::arm_wait(std::vector<int> &fds_)
+{
+  /* the listener thread queues connections, and signals the queue */
+  fds_.push_back(_pending.ready_fd());
+  return true;
+}
+
 std::vector<Fabric_memory_control *> Fabric_server_generic_factory::connections()
 {
   return _open.enumerate();
@@ -28,6 +28,7 @@
 #include <future>
 #include <memory> /* shared_ptr */
 #include <mutex> /* mutex */
+#include <vector>
 
 struct fi_info;
 struct fid_pep;
@@ -106,6 +107,9 @@ public:
    */
   Fabric_memory_control* get_new_connection();
 
+  /* see IFabric_server_factory::arm_wait */
+  bool arm_wait(std::vector<int> &fds);
+
   void close_connection(Fabric_memory_control* connection);
 
   std::vector<Fabric_memory_control*> connections();
@@ -19,15 +19,40 @@
 
 #include "pending_cnxns.h"
 
+#include "system_fail.h"
+
+#include <sys/eventfd.h>
+#include <unistd.h> /* read, write */
+
+#include <cerrno>
+#include <cstdint> /* uint64_t */
+
+namespace
+{
+  int make_eventfd()
+  {
+    auto fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if ( fd < 0 )
+    {
+      system_fail(errno, __func__);
+    }
+    return fd;
+  }
+}
+
 Pending_cnxns::Pending_cnxns()
   : _m{}
   , _q{}
+  , _ready(make_eventfd())
 {}
 
 void Pending_cnxns::push(cnxn_t c)
 {
   guard g{_m};
   _q.push(c);
+  const std::uint64_t one = 1;
+  auto sz = ::write(_ready.fd(), &one, sizeof one);
+  (void) sz;
 }
 
 auto Pending_cnxns::remove() -> cnxn_t
@@ -39,5 +64,11 @@ auto Pending_cnxns::remove() -> cnxn_t
     c = _q.front();
     _q.pop();
   }
+  if ( _q.size() == 0 )
+  {
+    std::uint64_t count;
+    auto sz = ::read(_ready.fd(), &count, sizeof count);
+    (void) sz;
+  }
   return c;
 }
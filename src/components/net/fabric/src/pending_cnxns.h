@@ -15,6 +15,7 @@
 #ifndef _PENDING_CONNECTIONS_H_
 #define _PENDING_CONNECTIONS_H_
 
+#include <common/fd_open.h>
 #include <memory> /* shared_ptr */
 #include <mutex>
 #include <queue>
@@ -29,10 +30,16 @@ private:
   std::mutex _m; /* protects _q */
   using guard = std::lock_guard<std::mutex>;
   std::queue<cnxn_t> _q;
+  /* an eventfd, readable while _q is not empty */
+  common::Fd_open _ready;
 public:
+  /*
+   * @throw std::system_error - creating the eventfd
+   */
   Pending_cnxns();
   void push(cnxn_t c);
   cnxn_t remove();
+  int ready_fd() const { return _ready.fd(); }
 };
 
 #endif
@@ -0,0 +1,929 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "shm_connection.h"
+
+#include <common/logging.h>
+
+#include <fcntl.h> /* open */
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h> /* shutdown */
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm> /* min */
+#include <cerrno>
+#include <cinttypes> /* PRIu64 */
+#include <cstdio> /* sscanf */
+#include <cstring> /* memcpy */
+#include <fstream>
+#include <system_error>
+
+constexpr std::size_t Shm_connection::MAX_MESSAGE_SIZE;
+constexpr std::size_t Shm_connection::DEFAULT_INJECT_SIZE;
+constexpr std::size_t Shm_connection::DEFAULT_RING_SIZE;
+constexpr unsigned Shm_connection::PEER_CHECK_INTERVAL;
+
+namespace
+{
+  int make_eventfd()
+  {
+    auto fd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if ( fd < 0 )
+    {
+      throw std::system_error(std::error_code(errno, std::system_category()), "eventfd");
+    }
+    return fd;
+  }
+
+  std::size_t iov_total(const ::iovec *first, const ::iovec *last)
+  {
+    std::size_t t = 0;
+    for ( ; first != last; ++first )
+    {
+      t += first->iov_len;
+    }
+    return t;
+  }
+
+  /* drop the first n bytes from an iovec list */
+  void advance(std::vector<::iovec> &v, std::size_t n)
+  {
+    auto it = v.begin();
+    for ( ; it != v.end() && it->iov_len <= n; ++it )
+    {
+      n -= it->iov_len;
+    }
+    if ( it != v.end() )
+    {
+      it->iov_base = static_cast<char *>(it->iov_base) + n;
+      it->iov_len -= n;
+    }
+    v.erase(v.begin(), it);
+  }
+
+  /* copy n bytes to the front of an iovec list, and drop them from it; bytes beyond the list are discarded */
+  void scatter(std::vector<::iovec> &v, const char *p, std::size_t n)
+  {
+    while ( n != 0 && ! v.empty() )
+    {
+      auto &e = v.front();
+      const auto m = std::min(n, e.iov_len);
+      std::memcpy(e.iov_base, p, m);
+      p += m;
+      n -= m;
+      advance(v, m);
+    }
+  }
+
+  frame_header make_header(frame_type type_, std::size_t len_, std::uint64_t tag_ = 0, std::uint64_t addr_ = 0, std::uint64_t key_ = 0)
+  {
+    frame_header h{};
+    h.type = type_;
+    h.len = std::uint32_t(len_);
+    h.tag = tag_;
+    h.addr = addr_;
+    h.key = key_;
+    h.extent = len_;
+    return h;
+  }
+
+  /*
+   * The file, and offset within it, through which memory [base, base+len)
+   * is shared, or an empty path if that memory is not wholly within one
+   * shared file mapping (anonymous and private memory cannot be offered).
+   */
+  std::string backing_file(const char *base_, std::size_t len_, std::uint64_t &offset_)
+  {
+    const auto lo = reinterpret_cast<std::uintptr_t>(base_);
+    std::ifstream maps("/proc/self/maps");
+    std::string line;
+    while ( std::getline(maps, line) )
+    {
+      unsigned long start, end, off;
+      char perms[5];
+      int path_pos = 0;
+      if ( std::sscanf(line.c_str(), "%lx-%lx %4s %lx %*s %*s %n", &start, &end, perms, &off, &path_pos) < 4 || path_pos == 0 )
+      {
+        continue;
+      }
+      if ( start <= lo && lo < end )
+      {
+        const auto path = line.substr(std::size_t(path_pos));
+        const bool deleted = path.size() > 10 && path.compare(path.size() - 10, 10, " (deleted)") == 0;
+        if ( len_ <= end - lo && perms[3] == 's' && ! path.empty() && path[0] == '/' && ! deleted )
+        {
+          offset_ = off + (lo - start);
+          return path;
+        }
+        break;
+      }
+    }
+    return std::string();
+  }
+}
+
+Shm_connection::Shm_connection(shm_link &&link_, std::size_t inject_size_, bool share_regions_)
+  : _m()
+  , _link(std::move(link_))
+  , _tx(&_link.segment.header()->ring[_link.side], _link.segment.ring_data(_link.side), _link.segment.header()->ring_size, true)
+  , _rx(&_link.segment.header()->ring[1 - _link.side], _link.segment.ring_data(1 - _link.side), _link.segment.header()->ring_size, false)
+  , _unblock(make_eventfd())
+  , _inject_size(inject_size_)
+  , _share_regions(share_regions_)
+  , _closed(false)
+  , _close_reason(nullptr)
+  , _peer_gone(false)
+  , _armed(false)
+  , _idle_polls(0)
+  , _regions()
+  , _next_key(1)
+  , _peer_shares()
+  , _rx_blocked(false)
+  , _rx_active(false)
+  , _rx_hdr{}
+  , _rx_iov()
+  , _rx_left(0)
+  , _rx_context(nullptr)
+  , _rx_status(S_OK)
+  , _posted_recvs()
+  , _tx_queue()
+  , _pending_rma()
+  , _next_tag(1)
+  , _completions()
+  , _stalled()
+{
+}
+
+Shm_connection::~Shm_connection()
+{
+  guard g{_m};
+  /* everything sent is already in the ring: the peer may still read it */
+  _link.segment.header()->closed[_link.side].store(1, std::memory_order_release);
+  wake_peer(_tx.ctl().data_wanted);
+  wake_peer(_rx.ctl().space_wanted);
+  ::shutdown(_link.socket.fd(), SHUT_RDWR);
+  for ( const auto &s : _peer_shares )
+  {
+    ::munmap(s.second.map, s.second.map_len);
+  }
+}
+
+void Shm_connection::close(const char *reason_)
+{
+  if ( _closed )
+  {
+    return;
+  }
+  _closed = true;
+  _close_reason = reason_;
+
+  for ( const auto &t : _tx_queue )
+  {
+    if ( t.signal )
+    {
+      complete(t.context, E_FAIL, FI_SEND, 0, reason_);
+    }
+  }
+  _tx_queue.clear();
+  for ( const auto &p : _pending_rma )
+  {
+    complete(p.second.context, E_FAIL, p.second.flags, 0, reason_);
+  }
+  _pending_rma.clear();
+}
+
+void Shm_connection::progress()
+{
+  if ( _closed )
+  {
+    return;
+  }
+  if ( _armed )
+  {
+    disarm();
+  }
+  bool moved = false;
+  /* each round may queue more to send (a response to a remote read) */
+  for ( unsigned round = 0; round != 4; ++round )
+  {
+    const bool tx = push_tx();
+    const bool rx = pull_rx();
+    if ( ! tx && ! rx )
+    {
+      break;
+    }
+    moved = true;
+  }
+  if ( moved )
+  {
+    _idle_polls = 0;
+  }
+  else
+  {
+    check_peer();
+  }
+}
+
+/*
+ * The peer is gone if it said so, or if its end of the socket has closed.
+ * The socket costs a system call, so is checked only now and then.
+ */
+void Shm_connection::check_peer()
+{
+  if ( ! _peer_gone )
+  {
+    if ( _link.segment.header()->closed[1 - _link.side].load(std::memory_order_acquire) )
+    {
+      _peer_gone = true;
+    }
+    else if ( PEER_CHECK_INTERVAL <= ++_idle_polls )
+    {
+      _idle_polls = 0;
+      ::pollfd p{_link.socket.fd(), POLLRDHUP, 0};
+      if ( 0 < ::poll(&p, 1, 0) && (p.revents & (POLLHUP | POLLRDHUP | POLLERR)) )
+      {
+        _peer_gone = true;
+      }
+    }
+  }
+  /* what the peer sent before it went is still delivered, if there is a receive for it */
+  if ( _peer_gone && ! ( _rx_blocked && _rx.available_fresh() != 0 ) )
+  {
+    close("shm: connection closed by peer");
+  }
+}
+
+void Shm_connection::wake_peer(std::atomic<std::uint32_t> &wanted_)
+{
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if ( wanted_.load(std::memory_order_relaxed) && wanted_.exchange(0) )
+  {
+    std::uint64_t one = 1;
+    auto sz = ::write(_link.peer_bell.fd(), &one, sizeof one);
+    (void) sz;
+  }
+}
+
+/* ask the peer to ring the doorbell; false if there is work already */
+bool Shm_connection::arm()
+{
+  _armed = true;
+  _rx.ctl().data_wanted.store(1, std::memory_order_seq_cst);
+  if ( _rx.available_fresh() != 0 && ! _rx_blocked )
+  {
+    return false;
+  }
+  if ( ! _tx_queue.empty() )
+  {
+    _tx.ctl().space_wanted.store(1, std::memory_order_seq_cst);
+    if ( _tx.space_fresh() != 0 )
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+void Shm_connection::disarm()
+{
+  _armed = false;
+  _rx.ctl().data_wanted.store(0, std::memory_order_relaxed);
+  _tx.ctl().space_wanted.store(0, std::memory_order_relaxed);
+  std::uint64_t count;
+  auto sz = ::read(_link.bell.fd(), &count, sizeof count);
+  (void) sz;
+  /* having slept, look at the socket on the next idle poll */
+  _idle_polls = PEER_CHECK_INTERVAL - 1;
+}
+
+/* receive */
+
+bool Shm_connection::pull_rx()
+{
+  bool moved = false;
+  while ( ! _closed )
+  {
+    if ( _rx_active )
+    {
+      if ( _rx_left != 0 )
+      {
+        const auto n = std::min(_rx.available(), _rx_left);
+        if ( n == 0 )
+        {
+          break;
+        }
+        consume(n);
+        moved = true;
+      }
+      if ( _rx_left == 0 )
+      {
+        finish_frame();
+      }
+      continue;
+    }
+
+    if ( _rx.available() < sizeof(frame_header) )
+    {
+      break;
+    }
+    frame_header h;
+    _rx.peek(&h, sizeof h);
+    if ( h.type == FRAME_SEND && _posted_recvs.empty() )
+    {
+      /* hold the message (and everything behind it) until a receive is posted */
+      _rx_blocked = true;
+      break;
+    }
+    _rx.skip(sizeof h);
+    moved = true;
+    start_frame(h);
+  }
+
+  if ( _rx.unreleased() )
+  {
+    _rx.release();
+    wake_peer(_rx.ctl().space_wanted);
+  }
+  return moved;
+}
+
+void Shm_connection::start_frame(const frame_header &h_)
+{
+  _rx_hdr = h_;
+  _rx_left = h_.len;
+  _rx_iov.clear();
+  _rx_context = nullptr;
+  _rx_status = S_OK;
+  _rx_active = true;
+
+  switch ( h_.type )
+  {
+  case FRAME_SEND:
+    {
+      auto &p = _posted_recvs.front();
+      _rx_iov = std::move(p.v);
+      _rx_context = p.context;
+      _posted_recvs.pop_front();
+      std::size_t capacity = 0;
+      for ( const auto &v : _rx_iov )
+      {
+        capacity += v.iov_len;
+      }
+      if ( capacity < h_.len )
+      {
+        _rx_status = E_INSUFFICIENT_BUFFER; /* the excess is discarded */
+      }
+    }
+    break;
+  case FRAME_READ_RESP:
+    {
+      auto it = _pending_rma.find(h_.tag);
+      if ( it != _pending_rma.end() )
+      {
+        _rx_iov = it->second.v;
+      }
+    }
+    break;
+  case FRAME_WRITE:
+    if ( find_region(h_.key, h_.addr, h_.len) )
+    {
+      _rx_iov.push_back(::iovec{reinterpret_cast<void *>(h_.addr), h_.len});
+    }
+    else
+    {
+      _rx_status = E_INVAL;
+    }
+    break;
+  case FRAME_READ_REQ:
+  case FRAME_WRITE_ACK:
+  case FRAME_SHARE:
+  case FRAME_UNSHARE:
+    break;
+  default:
+    PERR("%s: bad frame type %u", __func__, unsigned(h_.type));
+    _rx_active = false;
+    close("shm: protocol error");
+    break;
+  }
+}
+
+void Shm_connection::finish_frame()
+{
+  _rx_active = false;
+  const auto &h = _rx_hdr;
+  switch ( h.type )
+  {
+  case FRAME_SEND:
+    complete(_rx_context, _rx_status, FI_RECV, h.len, _rx_status == S_OK ? nullptr : "shm: message longer than receive buffer");
+    break;
+  case FRAME_READ_REQ:
+    {
+      tx_item t{};
+      t.hdr = make_header(FRAME_READ_RESP, 0, h.tag);
+      if ( find_region(h.key, h.addr, h.extent) && h.extent <= MAX_MESSAGE_SIZE )
+      {
+        t.hdr.len = std::uint32_t(h.extent);
+        t.payload.push_back(::iovec{reinterpret_cast<void *>(h.addr), h.extent});
+      }
+      else
+      {
+        t.hdr.status = FRAME_BAD_KEY;
+      }
+      enqueue(std::move(t));
+    }
+    break;
+  case FRAME_WRITE:
+    {
+      tx_item t{};
+      t.hdr = make_header(FRAME_WRITE_ACK, 0, h.tag);
+      t.hdr.status = _rx_status == S_OK ? FRAME_OK : FRAME_BAD_KEY;
+      enqueue(std::move(t));
+    }
+    break;
+  case FRAME_READ_RESP:
+  case FRAME_WRITE_ACK:
+    {
+      auto it = _pending_rma.find(h.tag);
+      if ( it == _pending_rma.end() )
+      {
+        PWRN("%s: response for unknown operation %" PRIu64, __func__, h.tag);
+        break;
+      }
+      const auto ok = h.status == FRAME_OK;
+      complete(it->second.context, ok ? S_OK : E_FAIL, it->second.flags, ok ? it->second.len : 0, ok ? nullptr : "shm: remote key or range not registered");
+      _pending_rma.erase(it);
+    }
+    break;
+  case FRAME_SHARE:
+    map_peer_share(h);
+    break;
+  case FRAME_UNSHARE:
+    unmap_peer_share(h.key);
+    break;
+  default:
+    break;
+  }
+}
+
+void Shm_connection::consume(std::size_t n_)
+{
+  _rx_left -= n_;
+  while ( n_ != 0 )
+  {
+    const auto c = _rx.contiguous(n_);
+    scatter(_rx_iov, _rx.front(), c);
+    _rx.skip(c);
+    n_ -= c;
+  }
+}
+
+/* send */
+
+void Shm_connection::enqueue(tx_item &&t_)
+{
+  _tx_queue.push_back(std::move(t_));
+}
+
+bool Shm_connection::push_tx()
+{
+  bool moved = false;
+  while ( ! _tx_queue.empty() )
+  {
+    auto &t = _tx_queue.front();
+    if ( t.hdr_done == sizeof t.hdr && t.payload.empty() )
+    {
+      if ( t.signal )
+      {
+        complete(t.context, S_OK, FI_SEND, t.hdr.len);
+      }
+      _tx_queue.pop_front();
+      continue;
+    }
+    const auto space = _tx.space();
+    if ( space == 0 )
+    {
+      break;
+    }
+    if ( t.hdr_done != sizeof t.hdr )
+    {
+      const auto n = std::min(space, sizeof t.hdr - t.hdr_done);
+      _tx.put(reinterpret_cast<const char *>(&t.hdr) + t.hdr_done, n);
+      t.hdr_done += n;
+    }
+    else
+    {
+      const auto n = std::min(space, t.payload.front().iov_len);
+      _tx.put(t.payload.front().iov_base, n);
+      advance(t.payload, n);
+    }
+    moved = true;
+  }
+
+  if ( _tx.uncommitted() )
+  {
+    _tx.commit();
+    wake_peer(_tx.ctl().data_wanted);
+  }
+  return moved;
+}
+
+/* copy a whole frame into the ring, if nothing is queued ahead of it and it fits */
+bool Shm_connection::put_now(const frame_header &h_, const ::iovec *first_, const ::iovec *last_)
+{
+  if ( ! _tx_queue.empty() )
+  {
+    return false;
+  }
+  const auto total = sizeof h_ + h_.len;
+  if ( _tx.space() < total && _tx.space_fresh() < total )
+  {
+    return false;
+  }
+  _tx.put(&h_, sizeof h_);
+  for ( ; first_ != last_; ++first_ )
+  {
+    _tx.put(first_->iov_base, first_->iov_len);
+  }
+  _tx.commit();
+  wake_peer(_tx.ctl().data_wanted);
+  return true;
+}
+
+/* operations */
+
+void Shm_connection::post_send(const ::iovec *first_, const ::iovec *last_, void *context_)
+{
+  const auto len = iov_total(first_, last_);
+  if ( MAX_MESSAGE_SIZE < len )
+  {
+    throw std::range_error("shm: message exceeds max_message_size");
+  }
+  guard g{_m};
+  if ( _closed )
+  {
+    return;
+  }
+  const auto h = make_header(FRAME_SEND, len);
+  if ( put_now(h, first_, last_) )
+  {
+    complete(context_, S_OK, FI_SEND, len);
+    return;
+  }
+  tx_item t{};
+  t.hdr = h;
+  t.payload.assign(first_, last_);
+  t.context = context_;
+  t.signal = true;
+  enqueue(std::move(t));
+  push_tx();
+}
+
+void Shm_connection::inject_send(const void *buf_, std::size_t len_)
+{
+  guard g{_m};
+  if ( _closed )
+  {
+    return;
+  }
+  const auto h = make_header(FRAME_SEND, len_);
+  const ::iovec v{const_cast<void *>(buf_), len_};
+  if ( put_now(h, &v, &v + 1) )
+  {
+    return;
+  }
+  tx_item t{};
+  t.hdr = h;
+  t.copy.assign(static_cast<const char *>(buf_), static_cast<const char *>(buf_) + len_);
+  t.payload.push_back(::iovec{t.copy.data(), t.copy.size()});
+  enqueue(std::move(t));
+  push_tx();
+}
+
+void Shm_connection::post_recv(const ::iovec *first_, const ::iovec *last_, void *context_)
+{
+  guard g{_m};
+  if ( _closed )
+  {
+    return;
+  }
+  _posted_recvs.push_back(posted_recv{std::vector<::iovec>(first_, last_), context_});
+  if ( _rx_blocked )
+  {
+    _rx_blocked = false;
+    pull_rx();
+    push_tx();
+  }
+}
+
+void Shm_connection::post_read(const ::iovec *first_, const ::iovec *last_, std::uint64_t remote_addr_, std::uint64_t key_, void *context_)
+{
+  const auto len = iov_total(first_, last_);
+  guard g{_m};
+  if ( _closed )
+  {
+    return;
+  }
+
+  /* Memory the peer has shared is read in place. (Pull first: the peer may
+   * have shared, or withdrawn, the region.)
+   */
+  pull_rx();
+  {
+    auto it = _peer_shares.find(key_);
+    if ( it != _peer_shares.end() )
+    {
+      const auto &s = it->second;
+      if ( s.addr <= remote_addr_ && len <= s.len && remote_addr_ - s.addr <= s.len - len )
+      {
+        std::vector<::iovec> v(first_, last_);
+        scatter(v, s.data + (remote_addr_ - s.addr), len);
+        complete(context_, S_OK, FI_READ, len);
+        return;
+      }
+    }
+  }
+
+  const auto tag = _next_tag++;
+  _pending_rma.emplace(tag, pending_rma{std::vector<::iovec>(first_, last_), context_, len, FI_READ});
+  auto h = make_header(FRAME_READ_REQ, 0, tag, remote_addr_, key_);
+  h.extent = len;
+  if ( ! put_now(h, nullptr, nullptr) )
+  {
+    tx_item t{};
+    t.hdr = h;
+    enqueue(std::move(t));
+    push_tx();
+  }
+}
+
+void Shm_connection::post_write(const ::iovec *first_, const ::iovec *last_, std::uint64_t remote_addr_, std::uint64_t key_, void *context_)
+{
+  const auto len = iov_total(first_, last_);
+  if ( MAX_MESSAGE_SIZE < len )
+  {
+    throw std::range_error("shm: write exceeds max_message_size");
+  }
+  guard g{_m};
+  if ( _closed )
+  {
+    return;
+  }
+  const auto tag = _next_tag++;
+  _pending_rma.emplace(tag, pending_rma{std::vector<::iovec>(), context_, len, FI_WRITE});
+  const auto h = make_header(FRAME_WRITE, len, tag, remote_addr_, key_);
+  if ( ! put_now(h, first_, last_) )
+  {
+    tx_item t{};
+    t.hdr = h;
+    t.payload.assign(first_, last_);
+    enqueue(std::move(t));
+    push_tx();
+  }
+}
+
+/* completions */
+
+auto Shm_connection::take_completions() -> std::deque<completion>
+{
+  guard g{_m};
+  progress();
+  std::deque<completion> ready;
+  ready.swap(_completions);
+  ready.insert(ready.end(), _stalled.begin(), _stalled.end());
+  _stalled.clear();
+  if ( ready.empty() && _closed )
+  {
+    throw std::logic_error(_close_reason);
+  }
+  return ready;
+}
+
+void Shm_connection::stall(std::deque<completion> &&deferred_)
+{
+  guard g{_m};
+  _stalled.insert(_stalled.end(), deferred_.begin(), deferred_.end());
+}
+
+std::size_t Shm_connection::stalled_completion_count()
+{
+  guard g{_m};
+  return _stalled.size();
+}
+
+void Shm_connection::wait(int timeout_ms_)
+{
+  {
+    guard g{_m};
+    progress();
+    if ( ! _completions.empty() || _closed || ! arm() )
+    {
+      return;
+    }
+  }
+  ::pollfd p[3] = { {_link.bell.fd(), POLLIN, 0}, {_unblock.fd(), POLLIN, 0}, {_link.socket.fd(), POLLRDHUP, 0} };
+  if ( ::poll(p, 3, timeout_ms_) < 0 && errno != EINTR )
+  {
+    throw std::system_error(std::error_code(errno, std::system_category()), "shm: poll");
+  }
+  if ( p[1].revents )
+  {
+    std::uint64_t count;
+    auto sz = ::read(_unblock.fd(), &count, sizeof count);
+    (void) sz;
+  }
+}
+
+void Shm_connection::wait_for_next_completion(unsigned /* polls_limit */)
+{
+  wait(-1);
+}
+
+void Shm_connection::wait_for_next_completion(std::chrono::milliseconds timeout_)
+{
+  wait(int(timeout_.count()));
+}
+
+void Shm_connection::unblock_completions()
+{
+  std::uint64_t one = 1;
+  auto sz = ::write(_unblock.fd(), &one, sizeof one);
+  (void) sz;
+}
+
+bool Shm_connection::arm_wait(std::vector<int> &fds_)
+{
+  guard g{_m};
+  progress();
+  if ( ! _completions.empty() || ! _stalled.empty() || _closed || ! arm() )
+  {
+    return false;
+  }
+  /* the doorbell is readable when the peer sends, or frees space we wait for */
+  fds_.push_back(_link.bell.fd());
+  return true;
+}
+
+/* memory */
+
+auto Shm_connection::register_memory(const void *contig_addr_, std::size_t size_, std::uint64_t, std::uint64_t flags_) -> memory_region_t
+{
+  /* Only memory its owner marks shareable (pool regions, registered once
+   * per pool) is looked up in /proc/self/maps, and not under the lock:
+   * message buffers, registered per message, are anonymous in any case.
+   */
+  std::uint64_t offset = 0;
+  const auto path =
+    _share_regions && (flags_ & component::IFabric_connection::MR_FLAG_SHAREABLE)
+    ? backing_file(static_cast<const char *>(contig_addr_), size_, offset)
+    : std::string();
+
+  guard g{_m};
+  std::unique_ptr<region> r(new region{static_cast<const char *>(contig_addr_), size_, _next_key++, false});
+  if ( ! path.empty() && ! _closed )
+  {
+    share_region(*r, path, offset);
+  }
+  auto p = r.get();
+  _regions.emplace(p->key, std::move(r));
+  return reinterpret_cast<memory_region_t>(p);
+}
+
+void Shm_connection::deregister_memory(const memory_region_t memory_region_)
+{
+  guard g{_m};
+  const auto p = reinterpret_cast<const region *>(memory_region_);
+  auto it = _regions.find(p->key);
+  if ( it == _regions.end() || it->second.get() != p )
+  {
+    throw std::range_error("shm: memory region not registered");
+  }
+  if ( p->shared && ! _closed )
+  {
+    tx_item t{};
+    t.hdr = make_header(FRAME_UNSHARE, 0, 0, 0, p->key);
+    enqueue(std::move(t));
+    push_tx();
+  }
+  _regions.erase(it);
+}
+
+/*
+ * Offer a region to the peer: its file descriptor goes over the socket,
+ * then FRAME_SHARE, which the peer reads in order with everything else,
+ * tells the peer to collect it.
+ */
+void Shm_connection::share_region(region &r_, const std::string &path, std::uint64_t offset)
+{
+  const auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if ( fd < 0 )
+  {
+    return;
+  }
+  common::Fd_open file(fd);
+  struct ::stat st{};
+  /* a file shorter than the mapping would fault the peer */
+  if ( ::fstat(file.fd(), &st) != 0 || ( S_ISREG(st.st_mode) && std::uint64_t(st.st_size) < offset + r_.len ) )
+  {
+    return;
+  }
+  try
+  {
+    shm_send_fd(_link.socket.fd(), file.fd());
+  }
+  catch ( const std::exception & )
+  {
+    return;
+  }
+  tx_item t{};
+  t.hdr = make_header(FRAME_SHARE, 0, offset, reinterpret_cast<std::uintptr_t>(r_.base), r_.key);
+  t.hdr.extent = r_.len;
+  enqueue(std::move(t));
+  push_tx();
+  r_.shared = true;
+}
+
+void Shm_connection::map_peer_share(const frame_header &h_)
+{
+  common::Fd_open file;
+  try
+  {
+    file = shm_recv_fd(_link.socket.fd());
+  }
+  catch ( const std::exception &e )
+  {
+    PWRN("%s: %s", __func__, e.what());
+    return;
+  }
+  if ( ! file )
+  {
+    return;
+  }
+  unmap_peer_share(h_.key);
+  const auto page = std::uint64_t(::sysconf(_SC_PAGESIZE));
+  const auto offset = h_.tag;
+  const auto delta = offset % page;
+  const auto map_len = std::size_t(h_.extent + delta);
+  auto p = ::mmap(nullptr, map_len, PROT_READ, MAP_SHARED, file.fd(), off_t(offset - delta));
+  if ( p == MAP_FAILED )
+  {
+    /* e.g. a device which needs greater alignment: reads go through the peer */
+    PLOG("%s: cannot map peer region %" PRIu64 " (%s); reading through peer", __func__, h_.key, std::strerror(errno));
+    return;
+  }
+  _peer_shares.emplace(h_.key, peer_share{h_.addr, std::size_t(h_.extent), p, map_len, static_cast<const char *>(p) + delta});
+}
+
+void Shm_connection::unmap_peer_share(std::uint64_t key_)
+{
+  auto it = _peer_shares.find(key_);
+  if ( it != _peer_shares.end() )
+  {
+    ::munmap(it->second.map, it->second.map_len);
+    _peer_shares.erase(it);
+  }
+}
+
+std::uint64_t Shm_connection::get_memory_remote_key(const memory_region_t memory_region_) const noexcept
+{
+  return reinterpret_cast<const region *>(memory_region_)->key;
+}
+
+void *Shm_connection::get_memory_descriptor(const memory_region_t memory_region_) const noexcept
+{
+  return memory_region_;
+}
+
+auto Shm_connection::find_region(std::uint64_t key_, std::uint64_t addr_, std::uint64_t len_) const -> const region *
+{
+  auto it = _regions.find(key_);
+  if ( it == _regions.end() )
+  {
+    return nullptr;
+  }
+  const auto &r = *it->second;
+  const auto base = reinterpret_cast<std::uintptr_t>(r.base);
+  return base <= addr_ && len_ <= r.len && addr_ - base <= r.len - len_ ? &r : nullptr;
+}
+
+std::string Shm_connection::get_peer_addr()
+{
+  return "shm:" + std::to_string(_link.peer_pid);
+}
+
+std::string Shm_connection::get_local_addr()
+{
+  return "shm:" + std::to_string(::getpid());
+}
@@ -0,0 +1,263 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef _SHM_CONNECTION_H_
+#define _SHM_CONNECTION_H_
+
+#include <api/fabric_itf.h>
+#include <common/errors.h> /* status_t */
+#include <common/fd_open.h>
+
+#include "shm_frame.h"
+#include "shm_link.h"
+#include "shm_ring.h"
+
+#include <sys/uio.h> /* iovec */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * One connection between two processes on the same host: a pair of byte
+ * rings in a shared segment, one per direction. The implementation shared
+ * by Shm_server and Shm_client.
+ *
+ * A send copies its frame into the outbound ring, and completes as soon as
+ * the copy is done; a frame which does not fit waits in a queue, and is
+ * streamed into the ring as the peer frees space. Receives copy out of the
+ * inbound ring into the posted buffer. Neither side makes a system call to
+ * move a message unless its peer is asleep.
+ *
+ * If the owner of registered memory allows it (share_regions), regions
+ * registered with MR_FLAG_SHAREABLE and backed by a file are offered to the
+ * peer, which maps them read-only and satisfies remote reads of them by
+ * copying in place.
+ */
+class Shm_connection
+{
+public:
+  using memory_region_t = component::IFabric_memory_region *;
+  using cb_acceptance = component::IFabric_op_completer::cb_acceptance;
+
+  static constexpr std::size_t MAX_MESSAGE_SIZE = std::size_t(1) << 30;
+  static constexpr std::size_t DEFAULT_INJECT_SIZE = 128;
+  static constexpr std::size_t DEFAULT_RING_SIZE = std::size_t(4) << 20;
+  /* polls which find nothing to do between checks that the peer is alive */
+  static constexpr unsigned PEER_CHECK_INTERVAL = 1024;
+
+  struct completion
+  {
+    void *context;
+    ::status_t status;
+    std::uint64_t flags;
+    std::size_t len;
+    const char *error;
+  };
+
+private:
+  struct region
+  {
+    const char *base;
+    std::size_t len;
+    std::uint64_t key;
+    bool shared; /* offered to the peer */
+  };
+
+  /* a region of the peer, mapped read-only here */
+  struct peer_share
+  {
+    std::uint64_t addr; /* in the peer */
+    std::size_t len;
+    void *map;
+    std::size_t map_len;
+    const char *data;   /* where addr is mapped */
+  };
+
+  struct posted_recv
+  {
+    std::vector<::iovec> v;
+    void *context;
+  };
+
+  struct pending_rma
+  {
+    std::vector<::iovec> v; /* destination of a read */
+    void *context;
+    std::size_t len;
+    std::uint64_t flags;    /* completion flags */
+  };
+
+  struct tx_item
+  {
+    frame_header hdr;
+    std::vector<::iovec> payload; /* remaining */
+    std::vector<char> copy;       /* inject_send: the payload, copied */
+    std::size_t hdr_done;         /* header bytes already in the ring */
+    void *context;
+    bool signal;                  /* post_send: complete when sent */
+  };
+
+  using guard = std::lock_guard<std::mutex>;
+
+  std::mutex _m; /* protects everything below */
+  shm_link _link;
+  Shm_ring _tx;
+  Shm_ring _rx;
+  common::Fd_open _unblock; /* eventfd, to end a wait_for_next_completion */
+  std::size_t _inject_size;
+  bool _share_regions;
+  bool _closed;
+  const char *_close_reason;
+  bool _peer_gone;
+  bool _armed;            /* this side may have asked the peer for a wakeup */
+  unsigned _idle_polls;
+
+  /* memory registration */
+  std::unordered_map<std::uint64_t, std::unique_ptr<region>> _regions;
+  std::uint64_t _next_key;
+  std::unordered_map<std::uint64_t, peer_share> _peer_shares;
+
+  /* receive */
+  bool _rx_blocked;          /* a message arrived, but no receive is posted */
+  bool _rx_active;           /* _rx_hdr is a frame whose payload is being received */
+  frame_header _rx_hdr;
+  std::vector<::iovec> _rx_iov; /* remaining destination */
+  std::size_t _rx_left;      /* payload bytes not yet received, including any discarded */
+  void *_rx_context;
+  ::status_t _rx_status;
+  std::deque<posted_recv> _posted_recvs;
+
+  /* send */
+  std::deque<tx_item> _tx_queue;
+
+  /* emulated one-sided operations awaiting the peer's response */
+  std::unordered_map<std::uint64_t, pending_rma> _pending_rma;
+  std::uint64_t _next_tag;
+
+  std::deque<completion> _completions;
+  std::deque<completion> _stalled;
+
+  void progress();
+  void close(const char *reason);
+  void check_peer();
+  void wake_peer(std::atomic<std::uint32_t> &wanted);
+  bool arm();
+  void disarm();
+
+  bool pull_rx();
+  void start_frame(const frame_header &h);
+  void finish_frame();
+  void consume(std::size_t n);
+
+  bool push_tx();
+  bool put_now(const frame_header &h, const ::iovec *first, const ::iovec *last);
+  void enqueue(tx_item &&t);
+
+  void share_region(region &r, const std::string &path, std::uint64_t offset);
+  void map_peer_share(const frame_header &h);
+  void unmap_peer_share(std::uint64_t key);
+  const region *find_region(std::uint64_t key, std::uint64_t addr, std::uint64_t len) const;
+
+  void complete(void *context, ::status_t status, std::uint64_t flags, std::size_t len, const char *error = nullptr)
+  {
+    _completions.push_back(completion{context, status, flags, len, error});
+  }
+
+  /* take new completions, then those stalled earlier */
+  std::deque<completion> take_completions();
+  void stall(std::deque<completion> &&deferred);
+  void wait(int timeout_ms);
+
+protected:
+  /* destroyed only as the base of a Shm_endpoint */
+  ~Shm_connection();
+
+public:
+  /*
+   * Adopts a link on which the handshake is done
+   *
+   * @throw std::system_error - eventfd fail
+   */
+  Shm_connection(shm_link &&link, std::size_t inject_size, bool share_regions);
+  Shm_connection(const Shm_connection &) = delete;
+  Shm_connection &operator=(const Shm_connection &) = delete;
+
+  void post_send(const ::iovec *first, const ::iovec *last, void *context);
+  void post_recv(const ::iovec *first, const ::iovec *last, void *context);
+  void post_read(const ::iovec *first, const ::iovec *last, std::uint64_t remote_addr, std::uint64_t key, void *context);
+  void post_write(const ::iovec *first, const ::iovec *last, std::uint64_t remote_addr, std::uint64_t key, void *context);
+  void inject_send(const void *buf, std::size_t len);
+
+  /*
+   * Deliver completions to f, a function of (const completion &) returning
+   * cb_acceptance. Deferred completions are offered again on the next call.
+   *
+   * @throw std::logic_error - called on closed connection
+   */
+  template <typename F>
+    std::size_t poll_completions(F f)
+    {
+      auto ready = take_completions();
+      std::size_t ct = 0;
+      std::deque<completion> deferred;
+      for ( const auto &c : ready )
+      {
+        if ( f(c) == cb_acceptance::DEFER )
+        {
+          deferred.push_back(c);
+        }
+        else
+        {
+          ++ct;
+        }
+      }
+      if ( ! deferred.empty() )
+      {
+        stall(std::move(deferred));
+      }
+      return ct;
+    }
+
+  std::size_t stalled_completion_count();
+  void wait_for_next_completion(unsigned polls_limit);
+  void wait_for_next_completion(std::chrono::milliseconds timeout);
+  void unblock_completions();
+  bool arm_wait(std::vector<int> &fds);
+
+  /*
+   * Keys are chosen by the provider (as with FI_MR_PROV_KEY); the requested
+   * key and flags are ignored.
+   */
+  memory_region_t register_memory(const void *contig_addr, std::size_t size, std::uint64_t key, std::uint64_t flags);
+  /*
+   * @throw std::range_error - address not registered
+   */
+  void deregister_memory(memory_region_t memory_region);
+  std::uint64_t get_memory_remote_key(memory_region_t memory_region) const noexcept;
+  void *get_memory_descriptor(memory_region_t memory_region) const noexcept;
+
+  std::string get_peer_addr();
+  std::string get_local_addr();
+  std::size_t max_message_size() const noexcept { return MAX_MESSAGE_SIZE; }
+  std::size_t max_inject_size() const noexcept { return _inject_size; }
+};
+
+#endif
@@ -0,0 +1,96 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "shm_fabric.h"
+
+#include "shm_endpoint.h"
+#include "shm_link.h"
+#include "shm_server_factory.h"
+
+#include <rapidjson/document.h>
+#include <rapidjson/error/en.h>
+
+#include <stdexcept>
+
+constexpr const char *Shm_fabric::PROVIDER_NAME;
+
+namespace
+{
+  rapidjson::Document parse(const std::string &json_configuration_)
+  {
+    rapidjson::Document jdoc;
+    jdoc.Parse(json_configuration_.c_str());
+    if ( jdoc.HasParseError() )
+    {
+      throw std::domain_error{std::string{"JSON parse error \""} + rapidjson::GetParseError_En(jdoc.GetParseError()) + "\" at " + std::to_string(jdoc.GetErrorOffset())};
+    }
+    if ( ! jdoc.IsObject() )
+    {
+      throw std::domain_error{"shm: JSON configuration is not an object"};
+    }
+    return jdoc;
+  }
+}
+
+Shm_fabric::Shm_fabric(const std::string &json_configuration_)
+  : _inject_size(Shm_connection::DEFAULT_INJECT_SIZE)
+  , _ring_size(Shm_connection::DEFAULT_RING_SIZE)
+  , _share_regions(false)
+{
+  auto jdoc = parse(json_configuration_);
+  auto share = jdoc.FindMember("share_regions");
+  if ( share != jdoc.MemberEnd() && share->value.IsBool() )
+  {
+    _share_regions = share->value.GetBool();
+  }
+  auto ring = jdoc.FindMember("ring_size");
+  if ( ring != jdoc.MemberEnd() && ring->value.IsUint() )
+  {
+    _ring_size = ring->value.GetUint();
+    if ( _ring_size == 0 || (_ring_size & (_ring_size - 1)) != 0 )
+    {
+      throw std::domain_error{"shm: ring_size must be a power of 2"};
+    }
+  }
+  auto tx = jdoc.FindMember("tx_attr");
+  if ( tx != jdoc.MemberEnd() && tx->value.IsObject() )
+  {
+    auto inject = tx->value.FindMember("inject_size");
+    if ( inject != tx->value.MemberEnd() && inject->value.IsUint() )
+    {
+      _inject_size = inject->value.GetUint();
+    }
+  }
+}
+
+auto Shm_fabric::open_server_factory(const std::string &json_configuration_, std::uint16_t port_) -> component::IFabric_server_factory *
+{
+  parse(json_configuration_);
+  return new Shm_server_factory(port_, _inject_size, _share_regions);
+}
+
+auto Shm_fabric::open_server_grouped_factory(const std::string &, std::uint16_t) -> component::IFabric_server_grouped_factory *
+{
+  throw std::logic_error("shm: grouped endpoints are not supported");
+}
+
+auto Shm_fabric::open_client(const std::string &json_configuration_, const std::string &, std::uint16_t port_) -> component::IFabric_client *
+{
+  parse(json_configuration_);
+  return new Shm_client(shm_connect(port_, _ring_size), _inject_size, _share_regions);
+}
+
+auto Shm_fabric::open_client_grouped(const std::string &, const std::string &, std::uint16_t) -> component::IFabric_client_grouped *
+{
+  throw std::logic_error("shm: grouped endpoints are not supported");
+}
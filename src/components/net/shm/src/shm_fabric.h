@@ -0,0 +1,69 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef _SHM_FABRIC_H_
+#define _SHM_FABRIC_H_
+
+#include <api/fabric_itf.h> /* component::IFabric */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+ * Shared memory, between processes on one host. Configuration (JSON)
+ * members understood:
+ *   "share_regions" : false  - offer file-backed registered memory, if
+ *                              registered with MR_FLAG_SHAREABLE, to the
+ *                              peer, which may then read it in place
+ *   "ring_size" : 4194304    - bytes in each direction (client only; a power of 2)
+ *   "tx_attr" : { "inject_size" : 128 }
+ * Other members, which may be meant for the libfabric provider, are ignored.
+ * The port selects the server; a client's remote_endpoint is ignored.
+ */
+class Shm_fabric
+  : public component::IFabric
+{
+  std::size_t _inject_size;
+  std::size_t _ring_size;
+  bool _share_regions;
+
+public:
+  static constexpr const char *PROVIDER_NAME = "shm";
+
+  /*
+   * @throw std::domain_error : json file parse-detected error
+   */
+  explicit Shm_fabric(const std::string &json_configuration);
+
+  /*
+   * @throw std::system_error - socket, bind or listen fail
+   */
+  component::IFabric_server_factory *open_server_factory(const std::string &json_configuration, std::uint16_t port) override;
+  /*
+   * @throw std::logic_error - not supported
+   */
+  component::IFabric_server_grouped_factory *open_server_grouped_factory(const std::string &json_configuration, std::uint16_t port) override;
+  /*
+   * @throw std::system_error - connect fail
+   * @throw std::runtime_error - server refused the connection
+   */
+  component::IFabric_client *open_client(const std::string &json_configuration, const std::string &remote_endpoint, std::uint16_t port) override;
+  /*
+   * @throw std::logic_error - not supported
+   */
+  component::IFabric_client_grouped *open_client_grouped(const std::string &json_configuration, const std::string &remote_endpoint, std::uint16_t port) override;
+  const char *prov_name() const noexcept override { return PROVIDER_NAME; }
+};
+
+#endif
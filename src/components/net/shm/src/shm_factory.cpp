@@ -0,0 +1,43 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "shm_factory.h"
+
+#include "shm_fabric.h"
+
+/**
+ * Shared memory network component
+ *
+ */
+
+Shm_factory::Shm_factory()
+{
+}
+
+auto Shm_factory::make_fabric(const std::string & json_configuration) -> component::IFabric *
+{
+  return new Shm_fabric(json_configuration);
+}
+
+void *Shm_factory::query_interface(component::uuid_t& itf_uuid) {
+  return itf_uuid == IFabric_factory::iid() ? this : nullptr;
+}
+
+/**
+ * Factory entry point
+ *
+ */
+extern "C" void * factory_createInstance(component::uuid_t component_id)
+{
+  return component_id == Shm_factory::component_id() ? new Shm_factory() : nullptr;
+}
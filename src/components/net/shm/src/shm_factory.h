@@ -0,0 +1,49 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef _SHM_FACTORY_H_
+#define _SHM_FACTORY_H_
+
+#include <api/fabric_itf.h>
+
+#include <component/base.h> /* DECLARE_VERSION, DECLARE_COMPONENT_UUID */
+
+/*
+ * Note: Shm_factory makes fabrics which carry IFabric traffic through
+ * shared memory rings, for clients on the same host as the server. Select
+ * it with the provider name "shm".
+ */
+class Shm_factory
+  : public component::IFabric_factory
+{
+public:
+  DECLARE_VERSION(0.1f);
+  DECLARE_COMPONENT_UUID(0xfac5a11e,0x2c4f,0x4e7d,0x8b13,0x5e,0x91,0x0a,0x4d,0x37,0xc2);
+  void *query_interface(component::uuid_t& itf_uuid) override;
+  void unload() override { delete this; }
+
+  Shm_factory();
+  /**
+   * Open a shm fabric
+   *
+   * @param json_configuration Configuration string in JSON
+   * form. e.g. {
+   *   "share_regions": true,
+   *   "tx_attr": { "inject_size" : 128 } }
+   *
+   * @throw std::domain_error : json file parse-detected error
+   */
+  component::IFabric * make_fabric(const std::string& json_configuration) override;
+};
+
+#endif
@@ -0,0 +1,61 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef _SHM_FRAME_H_
+#define _SHM_FRAME_H_
+
+#include <cstdint>
+
+/*
+ * Every transfer through a shm ring is a frame: this header, followed by
+ * len bytes of payload.
+ *
+ * Messages (post_send/post_recv) are FRAME_SEND. The one-sided operations
+ * are emulated as they are by the uring transport: the initiator sends
+ * FRAME_READ_REQ or FRAME_WRITE and the peer, while polling its own
+ * completions, answers from (or into) its registered memory. A remote read
+ * of memory which the peer has shared (FRAME_SHARE) needs no frames at all:
+ * the initiator copies from its own mapping of that memory.
+ */
+enum frame_type : std::uint8_t
+{
+  FRAME_SEND = 1,
+  FRAME_READ_REQ = 2,   /* extent bytes at addr, key wanted; no payload */
+  FRAME_READ_RESP = 3,  /* payload is the data read */
+  FRAME_WRITE = 4,      /* payload is the data to write at addr, key */
+  FRAME_WRITE_ACK = 5,  /* no payload */
+  FRAME_SHARE = 6,      /* region key (len extent at addr) is readable through the file descriptor now on the socket */
+  FRAME_UNSHARE = 7,    /* region key is no longer shared */
+};
+
+enum frame_status : std::uint8_t
+{
+  FRAME_OK = 0,
+  FRAME_BAD_KEY = 1,    /* key unknown, or range outside the region */
+};
+
+struct frame_header
+{
+  std::uint32_t len;     /* payload bytes following the header */
+  std::uint8_t type;     /* frame_type */
+  std::uint8_t status;   /* frame_status, for READ_RESP and WRITE_ACK */
+  std::uint16_t reserved;
+  std::uint64_t tag;     /* initiator's operation tag, echoed in the response; FRAME_SHARE: file offset */
+  std::uint64_t addr;
+  std::uint64_t key;
+  std::uint64_t extent;
+};
+
+static_assert(sizeof(frame_header) == 40, "frame_header size");
+
+#endif
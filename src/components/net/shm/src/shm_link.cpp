@@ -0,0 +1,333 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "shm_link.h"
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h> /* fstat */
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <new> /* placement new */
+#include <stdexcept>
+#include <system_error>
+
+constexpr std::uint64_t shm_segment_header::MAGIC;
+constexpr std::uint32_t shm_segment_header::VERSION;
+
+namespace
+{
+  /* ring data starts on a page boundary after the header */
+  constexpr std::size_t DATA_OFFSET = 4096;
+  static_assert(sizeof(shm_segment_header) <= DATA_OFFSET, "shm_segment_header too large");
+
+  /* handshake messages, which accompany the descriptors */
+  struct hello
+  {
+    std::uint64_t magic;
+    std::uint32_t version;
+    std::uint32_t ring_size;
+  };
+
+  struct welcome
+  {
+    std::uint64_t magic;
+    std::int32_t status; /* 0, or an errno value */
+    std::uint32_t reserved;
+  };
+
+  [[noreturn]] void throw_errno(const std::string &what_)
+  {
+    throw std::system_error(std::error_code(errno, std::system_category()), "shm: " + what_);
+  }
+
+  void send_with_fds(int socket_, const void *msg_, std::size_t len_, const int *fds_, unsigned fd_count_)
+  {
+    ::iovec v{const_cast<void *>(msg_), len_};
+    ::msghdr m{};
+    m.msg_iov = &v;
+    m.msg_iovlen = 1;
+    alignas(::cmsghdr) char control[CMSG_SPACE(2 * sizeof(int))];
+    if ( fd_count_ )
+    {
+      std::memset(control, 0, sizeof control);
+      m.msg_control = control;
+      m.msg_controllen = CMSG_SPACE(fd_count_ * sizeof(int));
+      auto c = CMSG_FIRSTHDR(&m);
+      c->cmsg_level = SOL_SOCKET;
+      c->cmsg_type = SCM_RIGHTS;
+      c->cmsg_len = CMSG_LEN(fd_count_ * sizeof(int));
+      std::memcpy(CMSG_DATA(c), fds_, fd_count_ * sizeof(int));
+    }
+    if ( ::sendmsg(socket_, &m, MSG_NOSIGNAL) != ssize_t(len_) )
+    {
+      throw_errno("sendmsg");
+    }
+  }
+
+  /* returns the number of descriptors received (at most 2), which the caller owns */
+  unsigned recv_with_fds(int socket_, void *msg_, std::size_t len_, int *fds_)
+  {
+    ::iovec v{msg_, len_};
+    ::msghdr m{};
+    m.msg_iov = &v;
+    m.msg_iovlen = 1;
+    alignas(::cmsghdr) char control[CMSG_SPACE(2 * sizeof(int))];
+    m.msg_control = control;
+    m.msg_controllen = sizeof control;
+    ssize_t r;
+    do
+    {
+      r = ::recvmsg(socket_, &m, MSG_CMSG_CLOEXEC);
+    } while ( r < 0 && errno == EINTR );
+    if ( r < 0 )
+    {
+      throw_errno("recvmsg");
+    }
+    unsigned count = 0;
+    for ( auto c = CMSG_FIRSTHDR(&m); c; c = CMSG_NXTHDR(&m, c) )
+    {
+      if ( c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_RIGHTS )
+      {
+        const auto n = (c->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        for ( std::size_t i = 0; i != n; ++i )
+        {
+          int fd;
+          std::memcpy(&fd, CMSG_DATA(c) + i * sizeof(int), sizeof fd);
+          if ( count < 2 )
+          {
+            fds_[count++] = fd;
+          }
+          else
+          {
+            ::close(fd);
+          }
+        }
+      }
+    }
+    if ( std::size_t(r) != len_ || (m.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) )
+    {
+      for ( unsigned i = 0; i != count; ++i )
+      {
+        ::close(fds_[i]);
+      }
+      throw std::runtime_error("shm: truncated handshake message");
+    }
+    return count;
+  }
+
+  int make_eventfd()
+  {
+    auto fd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if ( fd < 0 )
+    {
+      throw_errno("eventfd");
+    }
+    return fd;
+  }
+
+  ::sockaddr_un socket_address(std::uint16_t port_, ::socklen_t &len_)
+  {
+    ::sockaddr_un a{};
+    a.sun_family = AF_UNIX;
+    const auto name = shm_socket_name(port_);
+    /* abstract namespace: leading NUL, no terminator, nothing to unlink */
+    std::memcpy(a.sun_path + 1, name.data(), name.size());
+    len_ = ::socklen_t(offsetof(::sockaddr_un, sun_path) + 1 + name.size());
+    return a;
+  }
+
+  /* descriptor i of the n received, or none */
+  common::Fd_open adopt(const int *fds_, unsigned n_, unsigned i_)
+  {
+    return i_ < n_ ? common::Fd_open(fds_[i_]) : common::Fd_open();
+  }
+
+  ::pid_t peer_pid(int socket_)
+  {
+    ::ucred cred{};
+    ::socklen_t len = sizeof cred;
+    return ::getsockopt(socket_, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0 ? cred.pid : 0;
+  }
+}
+
+Shm_segment::Shm_segment(int fd_, std::size_t len_)
+  : _p(::mmap(nullptr, len_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0))
+  , _len(len_)
+{
+  if ( _p == MAP_FAILED )
+  {
+    _p = nullptr;
+    throw_errno("mmap segment");
+  }
+}
+
+Shm_segment::~Shm_segment()
+{
+  if ( _p )
+  {
+    ::munmap(_p, _len);
+  }
+}
+
+char *Shm_segment::ring_data(unsigned i_) const
+{
+  return static_cast<char *>(_p) + DATA_OFFSET + i_ * header()->ring_size;
+}
+
+std::size_t Shm_segment::size_for(std::size_t ring_size_)
+{
+  return DATA_OFFSET + 2 * ring_size_;
+}
+
+std::string shm_socket_name(std::uint16_t port_)
+{
+  return "mcas-shm-" + std::to_string(port_);
+}
+
+shm_link shm_connect(std::uint16_t port_, std::size_t ring_size_)
+{
+  if ( ring_size_ == 0 || (ring_size_ & (ring_size_ - 1)) != 0 || ring_size_ > (std::size_t(1) << 31) )
+  {
+    throw std::domain_error("shm: ring size must be a power of 2, at most 2 GiB");
+  }
+
+  auto s = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+  if ( s < 0 )
+  {
+    throw_errno("socket");
+  }
+  common::Fd_open sock(s);
+  ::socklen_t alen;
+  auto a = socket_address(port_, alen);
+  if ( ::connect(sock.fd(), reinterpret_cast<const ::sockaddr *>(&a), alen) != 0 )
+  {
+    throw_errno("connect to local port " + std::to_string(port_));
+  }
+
+  auto m = ::memfd_create("mcas-shm", MFD_CLOEXEC);
+  if ( m < 0 )
+  {
+    throw_errno("memfd_create");
+  }
+  common::Fd_open mem(m);
+  const auto len = Shm_segment::size_for(ring_size_);
+  if ( ::ftruncate(mem.fd(), off_t(len)) != 0 )
+  {
+    throw_errno("ftruncate segment");
+  }
+  Shm_segment seg(mem.fd(), len);
+  auto h = new (seg.header()) shm_segment_header{};
+  h->magic = shm_segment_header::MAGIC;
+  h->version = shm_segment_header::VERSION;
+  h->ring_size = std::uint32_t(ring_size_);
+
+  common::Fd_open bell(make_eventfd());
+  /* a server which never accepts must not hold up the client forever */
+  ::timeval tv{10, 0};
+  ::setsockopt(sock.fd(), SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof tv);
+  const hello hi{shm_segment_header::MAGIC, shm_segment_header::VERSION, std::uint32_t(ring_size_)};
+  const int fds[2] = { mem.fd(), bell.fd() };
+  send_with_fds(sock.fd(), &hi, sizeof hi, fds, 2);
+
+  welcome w{};
+  int rfds[2];
+  auto n = recv_with_fds(sock.fd(), &w, sizeof w, rfds);
+  auto peer_bell = adopt(rfds, n, 0);
+  auto extra = adopt(rfds, n, 1);
+  if ( w.magic != shm_segment_header::MAGIC || w.status != 0 || ! peer_bell )
+  {
+    throw std::runtime_error("shm: server refused connection: " + std::string(w.status ? std::strerror(w.status) : "bad handshake"));
+  }
+  ::timeval none{0, 0};
+  ::setsockopt(sock.fd(), SOL_SOCKET, SO_RCVTIMEO, &none, sizeof none);
+  const auto pid = peer_pid(sock.fd());
+  return shm_link{std::move(sock), std::move(seg), std::move(bell), std::move(peer_bell), 0, pid};
+}
+
+shm_link shm_accept(int socket_)
+{
+  common::Fd_open sock(socket_);
+  /* a client which connects but says nothing must not hold up the server */
+  ::timeval tv{1, 0};
+  ::setsockopt(sock.fd(), SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof tv);
+
+  hello hi{};
+  int fds[2];
+  auto n = recv_with_fds(sock.fd(), &hi, sizeof hi, fds);
+  auto mem = adopt(fds, n, 0);
+  auto peer_bell = adopt(fds, n, 1);
+
+  welcome w{shm_segment_header::MAGIC, 0, 0};
+  const auto refuse = [&sock, &w] (int err, const char *why)
+    {
+      w.status = err;
+      try
+      {
+        send_with_fds(sock.fd(), &w, sizeof w, nullptr, 0);
+      }
+      catch ( const std::exception & )
+      {
+      }
+      throw std::runtime_error(std::string("shm: refused client: ") + why);
+    };
+
+  if ( n != 2 || hi.magic != shm_segment_header::MAGIC || hi.version != shm_segment_header::VERSION )
+  {
+    refuse(EPROTO, "bad hello");
+  }
+  const std::size_t ring_size = hi.ring_size;
+  if ( ring_size == 0 || (ring_size & (ring_size - 1)) != 0 )
+  {
+    refuse(EINVAL, "bad ring size");
+  }
+  struct ::stat st{};
+  const auto len = Shm_segment::size_for(ring_size);
+  if ( ::fstat(mem.fd(), &st) != 0 || std::size_t(st.st_size) < len )
+  {
+    refuse(EINVAL, "segment too small");
+  }
+  Shm_segment seg(mem.fd(), len);
+  if ( seg.header()->magic != shm_segment_header::MAGIC || seg.header()->ring_size != ring_size )
+  {
+    refuse(EPROTO, "bad segment");
+  }
+
+  common::Fd_open bell(make_eventfd());
+  const int b = bell.fd();
+  send_with_fds(sock.fd(), &w, sizeof w, &b, 1);
+
+  ::timeval none{0, 0};
+  ::setsockopt(sock.fd(), SOL_SOCKET, SO_RCVTIMEO, &none, sizeof none);
+  const auto pid = peer_pid(sock.fd());
+  return shm_link{std::move(sock), std::move(seg), std::move(bell), std::move(peer_bell), 1, pid};
+}
+
+void shm_send_fd(int socket_, int fd_)
+{
+  const char c = 0;
+  send_with_fds(socket_, &c, sizeof c, &fd_, 1);
+}
+
+common::Fd_open shm_recv_fd(int socket_)
+{
+  char c;
+  int fds[2];
+  auto n = recv_with_fds(socket_, &c, sizeof c, fds);
+  auto extra = adopt(fds, n, 1);
+  return adopt(fds, n, 0);
+}
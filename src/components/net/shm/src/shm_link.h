@@ -0,0 +1,98 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef _SHM_LINK_H_
+#define _SHM_LINK_H_
+
+#include "shm_ring.h"
+
+#include <common/fd_open.h>
+
+#include <sys/types.h> /* pid_t */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+ * A mapping of a shared segment: the header and the two rings.
+ */
+class Shm_segment
+{
+  void *_p;
+  std::size_t _len;
+
+public:
+  Shm_segment() : _p(nullptr), _len(0) {}
+  /*
+   * Map len bytes of the file fd, read/write and shared
+   *
+   * @throw std::system_error - mmap fail
+   */
+  Shm_segment(int fd, std::size_t len);
+  ~Shm_segment();
+  Shm_segment(Shm_segment &&o) noexcept : _p(o._p), _len(o._len) { o._p = nullptr; o._len = 0; }
+  Shm_segment &operator=(Shm_segment &&) = delete;
+  Shm_segment(const Shm_segment &) = delete;
+  Shm_segment &operator=(const Shm_segment &) = delete;
+
+  shm_segment_header *header() const { return static_cast<shm_segment_header *>(_p); }
+  char *ring_data(unsigned i) const;
+  static std::size_t size_for(std::size_t ring_size);
+};
+
+/*
+ * Everything a connection needs, once the two sides have met.
+ *
+ * The client creates the segment (a memfd) and its doorbell, connects to
+ * the server's abstract unix socket "mcas-shm-<port>", and passes both
+ * descriptors; the server maps the segment and passes back its own
+ * doorbell. The socket stays open: it carries the descriptors of shared
+ * regions, and its closure tells each side that the other has gone.
+ */
+struct shm_link
+{
+  common::Fd_open socket;
+  Shm_segment segment;
+  common::Fd_open bell;       /* written by the peer to wake this side */
+  common::Fd_open peer_bell;  /* written by this side to wake the peer */
+  unsigned side;              /* 0: client, 1: server */
+  ::pid_t peer_pid;
+};
+
+/* the abstract socket address for a port */
+std::string shm_socket_name(std::uint16_t port);
+
+/*
+ * @throw std::system_error - connect, memfd or mmap fail
+ * @throw std::runtime_error - server refused or handshake failed
+ */
+shm_link shm_connect(std::uint16_t port, std::size_t ring_size);
+
+/*
+ * Complete the handshake on a newly accepted socket, which the link adopts.
+ *
+ * @throw std::system_error - receive, mmap or eventfd fail
+ * @throw std::runtime_error - bad handshake
+ */
+shm_link shm_accept(int socket);
+
+/*
+ * Pass a file descriptor over the unix socket, and receive one
+ *
+ * @throw std::system_error - sendmsg/recvmsg fail
+ */
+void shm_send_fd(int socket, int fd);
+common::Fd_open shm_recv_fd(int socket);
+
+#endif
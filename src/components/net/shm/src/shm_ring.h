@@ -0,0 +1,166 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef _SHM_RING_H_
+#define _SHM_RING_H_
+
+#include <algorithm> /* min */
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring> /* memcpy */
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2, "shm rings need address-free atomics");
+
+/*
+ * The control block of one byte ring, in shared memory. head and tail are
+ * running byte counts: the producer advances head, the consumer tail, in
+ * the manner of common::Spsc_bounded_lfq (which cannot itself live in
+ * shared memory, as it holds a process-local buffer pointer).
+ *
+ * A side about to sleep sets a flag and then re-checks the ring; a side
+ * which changes the ring checks the flag and, if set, rings the sleeper's
+ * doorbell (an eventfd).
+ */
+struct shm_ring_ctl
+{
+  alignas(64) std::atomic<std::uint64_t> head;
+  alignas(64) std::atomic<std::uint64_t> tail;
+  alignas(64) std::atomic<std::uint32_t> data_wanted;  /* consumer sleeps until data arrives */
+  std::atomic<std::uint32_t> space_wanted;             /* producer sleeps until space frees */
+};
+
+/*
+ * Start of the shared segment. Ring 0 carries client-to-server traffic,
+ * ring 1 server-to-client.
+ */
+struct shm_segment_header
+{
+  static constexpr std::uint64_t MAGIC = 0x6d6361732d73686dULL; /* "mcas-shm" */
+  static constexpr std::uint32_t VERSION = 1;
+
+  std::uint64_t magic;
+  std::uint32_t version;
+  std::uint32_t ring_size;
+  shm_ring_ctl ring[2];
+  alignas(64) std::atomic<std::uint32_t> closed[2]; /* side i has closed */
+};
+
+/*
+ * One side's view of a byte ring, as producer or consumer. Neither side
+ * trusts the counters it reads from the peer beyond the ring bounds.
+ */
+class Shm_ring
+{
+  shm_ring_ctl *_ctl;
+  char *_data;
+  std::size_t _size;
+  std::uint64_t _mask;
+  std::uint64_t _local;  /* producer: head, including bytes not yet committed; consumer: tail */
+  std::uint64_t _peer;   /* the peer's counter, as last read */
+
+public:
+  Shm_ring(shm_ring_ctl *ctl_, char *data_, std::size_t size_, bool producer_)
+    : _ctl(ctl_)
+    , _data(data_)
+    , _size(size_)
+    , _mask(size_ - 1)
+    , _local(producer_ ? ctl_->head.load(std::memory_order_relaxed) : ctl_->tail.load(std::memory_order_relaxed))
+    , _peer(producer_ ? ctl_->tail.load(std::memory_order_acquire) : ctl_->head.load(std::memory_order_acquire))
+  {}
+  Shm_ring(const Shm_ring &) = delete;
+  Shm_ring &operator=(const Shm_ring &) = delete;
+
+  shm_ring_ctl &ctl() const { return *_ctl; }
+
+  /* producer */
+
+  std::size_t space()
+  {
+    auto s = _size - std::min<std::uint64_t>(_local - _peer, _size);
+    if ( s == 0 )
+    {
+      _peer = _ctl->tail.load(std::memory_order_acquire);
+      s = _size - std::min<std::uint64_t>(_local - _peer, _size);
+    }
+    return s;
+  }
+
+  std::size_t space_fresh()
+  {
+    _peer = _ctl->tail.load(std::memory_order_seq_cst);
+    return _size - std::min<std::uint64_t>(_local - _peer, _size);
+  }
+
+  /* copy n bytes (no more than space()) in, uncommitted */
+  void put(const void *p_, std::size_t n_)
+  {
+    const auto off = _local & _mask;
+    const auto first = std::min(n_, _size - off);
+    std::memcpy(_data + off, p_, first);
+    std::memcpy(_data, static_cast<const char *>(p_) + first, n_ - first);
+    _local += n_;
+  }
+
+  bool uncommitted() const { return _local != _ctl->head.load(std::memory_order_relaxed); }
+
+  /* make the bytes put visible to the consumer */
+  void commit()
+  {
+    _ctl->head.store(_local, std::memory_order_release);
+  }
+
+  /* consumer */
+
+  std::size_t available()
+  {
+    auto a = std::min<std::uint64_t>(_peer - _local, _size);
+    if ( a == 0 )
+    {
+      _peer = _ctl->head.load(std::memory_order_acquire);
+      a = std::min<std::uint64_t>(_peer - _local, _size);
+    }
+    return a;
+  }
+
+  std::size_t available_fresh()
+  {
+    _peer = _ctl->head.load(std::memory_order_seq_cst);
+    return std::min<std::uint64_t>(_peer - _local, _size);
+  }
+
+  /* copy n bytes (no more than available()) out, without consuming them */
+  void peek(void *p_, std::size_t n_) const
+  {
+    const auto off = _local & _mask;
+    const auto first = std::min(n_, _size - off);
+    std::memcpy(p_, _data + off, first);
+    std::memcpy(static_cast<char *>(p_) + first, _data, n_ - first);
+  }
+
+  /* the bytes available without wrapping */
+  std::size_t contiguous(std::size_t n_) const { return std::min(n_, _size - (_local & _mask)); }
+  const char *front() const { return _data + (_local & _mask); }
+
+  void skip(std::size_t n_) { _local += n_; }
+
+  /* return the bytes consumed to the producer */
+  void release()
+  {
+    _ctl->tail.store(_local, std::memory_order_release);
+  }
+
+  bool unreleased() const { return _local != _ctl->tail.load(std::memory_order_relaxed); }
+};
+
+#endif
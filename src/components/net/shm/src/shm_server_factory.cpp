@@ -0,0 +1,133 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "shm_server_factory.h"
+
+#include "shm_endpoint.h"
+#include "shm_fabric.h" /* Shm_fabric::PROVIDER_NAME */
+#include "shm_link.h"
+
+#include <common/logging.h>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <cerrno>
+#include <cstddef> /* offsetof */
+#include <cstring> /* memcpy */
+#include <stdexcept>
+#include <system_error>
+
+namespace
+{
+  common::Fd_open listen_socket(std::uint16_t port_)
+  {
+    auto s = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if ( s < 0 )
+    {
+      throw std::system_error(std::error_code(errno, std::system_category()), "shm: socket");
+    }
+    common::Fd_open fd(s);
+
+    ::sockaddr_un a{};
+    a.sun_family = AF_UNIX;
+    const auto name = shm_socket_name(port_);
+    std::memcpy(a.sun_path + 1, name.data(), name.size());
+    const auto len = ::socklen_t(offsetof(::sockaddr_un, sun_path) + 1 + name.size());
+    if ( ::bind(fd.fd(), reinterpret_cast<const ::sockaddr *>(&a), len) != 0 )
+    {
+      throw std::system_error(std::error_code(errno, std::system_category()), "shm: bind " + name);
+    }
+    if ( ::listen(fd.fd(), SOMAXCONN) != 0 )
+    {
+      throw std::system_error(std::error_code(errno, std::system_category()), "shm: listen");
+    }
+    return fd;
+  }
+}
+
+Shm_server_factory::Shm_server_factory(std::uint16_t port_, std::size_t inject_size_, bool share_regions_)
+  : _listen(listen_socket(port_))
+  , _inject_size(inject_size_)
+  , _share_regions(share_regions_)
+  , _m()
+  , _open()
+{
+}
+
+Shm_server_factory::~Shm_server_factory()
+{
+  for ( auto c : _open )
+  {
+    delete c;
+  }
+}
+
+component::IFabric_server *Shm_server_factory::get_new_connection()
+{
+  auto fd = ::accept4(_listen.fd(), nullptr, nullptr, SOCK_CLOEXEC);
+  if ( fd < 0 )
+  {
+    if ( errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR || errno == ECONNABORTED )
+    {
+      return nullptr;
+    }
+    throw std::system_error(std::error_code(errno, std::system_category()), "shm: accept");
+  }
+
+  component::IFabric_server *c = nullptr;
+  try
+  {
+    c = new Shm_server(shm_accept(fd), _inject_size, _share_regions);
+  }
+  catch ( const std::exception &e )
+  {
+    /* one misbehaving client must not stop the server */
+    PWRN("%s: %s", __func__, e.what());
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> g{_m};
+  _open.insert(c);
+  return c;
+}
+
+bool Shm_server_factory::arm_wait(std::vector<int> &fds_)
+{
+  fds_.push_back(_listen.fd());
+  return true;
+}
+
+void Shm_server_factory::close_connection(component::IFabric_server *connection_)
+{
+  {
+    std::lock_guard<std::mutex> g{_m};
+    _open.erase(connection_);
+  }
+  delete connection_;
+}
+
+std::vector<component::IFabric_server *> Shm_server_factory::connections()
+{
+  std::lock_guard<std::mutex> g{_m};
+  return std::vector<component::IFabric_server *>(_open.begin(), _open.end());
+}
+
+std::size_t Shm_server_factory::max_message_size() const noexcept
+{
+  return Shm_connection::MAX_MESSAGE_SIZE;
+}
+
+std::string Shm_server_factory::get_provider_name() const
+{
+  return Shm_fabric::PROVIDER_NAME;
+}
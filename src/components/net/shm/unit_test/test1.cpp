@@ -0,0 +1,452 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Weffc++"
+
+#include <api/components.h>
+#include <api/fabric_itf.h>
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib> /* mkstemp */
+#include <cstring>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <system_error>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Tests for the shm transport: one client connected to one server, both in
+ * this process. The rings are small, so that large messages must stream.
+ */
+
+namespace
+{
+using namespace component;
+
+constexpr std::uint16_t port = 11982;
+constexpr std::size_t big = std::size_t(2) << 20;
+
+struct done
+{
+  void *context;
+  status_t status;
+  std::uint64_t flags;
+  std::size_t len;
+};
+
+/*
+ * Poll a for n completions. The peer b is polled too, so that it services
+ * emulated remote reads and writes, but its completions are deferred.
+ */
+std::vector<done> wait_n(IFabric_op_completer *a, IFabric_op_completer *b, std::size_t n = 1)
+{
+  std::vector<done> got;
+  for ( auto start = std::chrono::steady_clock::now();
+        got.size() < n && std::chrono::steady_clock::now() - start < std::chrono::seconds(10);
+      )
+  {
+    a->poll_completions(
+      [&got] (void *c_, status_t s_, std::uint64_t f_, std::size_t l_, void *) { got.push_back(done{c_, s_, f_, l_}); }
+    );
+    if ( b )
+    {
+      b->poll_completions_tentative(
+        [] (void *, status_t, std::uint64_t, std::size_t, void *) { return IFabric_op_completer::cb_acceptance::DEFER; }
+      );
+    }
+  }
+  return got;
+}
+
+class Shm_test : public ::testing::Test
+{
+protected:
+  static IFabric_factory *factory;
+  std::unique_ptr<IFabric> fabric;
+  std::unique_ptr<IFabric_server_factory> server_factory;
+  std::unique_ptr<IFabric_client> client;
+  IFabric_server *server;
+  std::vector<char> sbuf;
+  std::vector<char> cbuf;
+
+  Shm_test()
+    : fabric()
+    , server_factory()
+    , client()
+    , server(nullptr)
+    , sbuf(big)
+    , cbuf(big)
+  {}
+
+  static void SetUpTestCase()
+  {
+    IBase *comp = load_component("libcomponent-shm.so", net_shm_factory);
+    ASSERT_TRUE(comp);
+    factory = static_cast<IFabric_factory *>(comp->query_interface(IFabric_factory::iid()));
+    ASSERT_TRUE(factory);
+  }
+
+  static void TearDownTestCase()
+  {
+    factory->release_ref();
+  }
+
+  void SetUp() override
+  {
+    fabric.reset(factory->make_fabric("{ \"share_regions\" : true, \"ring_size\" : 65536, \"tx_attr\" : { \"inject_size\" : 128 } }"));
+    server_factory.reset(fabric->open_server_factory("{}", port));
+    /* the client waits for the server to accept */
+    auto f = std::async(std::launch::async, [this] () { return fabric->open_client("{}", "unused", port); });
+    for ( auto start = std::chrono::steady_clock::now();
+          ! server && std::chrono::steady_clock::now() - start < std::chrono::seconds(5);
+        )
+    {
+      server = server_factory->get_new_connection();
+    }
+    client.reset(f.get());
+    ASSERT_TRUE(server);
+  }
+
+  void TearDown() override
+  {
+    client.reset();
+    if ( server )
+    {
+      server_factory->close_connection(server);
+    }
+    server_factory.reset();
+    fabric.reset();
+  }
+};
+
+IFabric_factory *Shm_test::factory;
+
+TEST_F(Shm_test, Names)
+{
+  const auto self = "shm:" + std::to_string(::getpid());
+  EXPECT_EQ("shm", server_factory->get_provider_name());
+  EXPECT_EQ(self, server->get_peer_addr());
+  EXPECT_EQ(self, client->get_local_addr());
+}
+
+TEST_F(Shm_test, SmallMessage)
+{
+  ::iovec rv{sbuf.data(), 4096};
+  server->post_recv(&rv, &rv + 1, nullptr, &rv);
+  const char msg[] = "hello";
+  std::memcpy(cbuf.data(), msg, sizeof msg);
+  ::iovec sv{cbuf.data(), sizeof msg};
+  client->post_send(&sv, &sv + 1, nullptr, &sv);
+
+  auto g = wait_n(server, client.get());
+  ASSERT_EQ(1U, g.size());
+  EXPECT_EQ(&rv, g[0].context);
+  EXPECT_EQ(S_OK, g[0].status);
+  EXPECT_EQ(sizeof msg, g[0].len);
+  EXPECT_TRUE(g[0].flags & FI_RECV);
+  EXPECT_STREQ("hello", sbuf.data());
+
+  auto h = wait_n(client.get(), nullptr);
+  ASSERT_EQ(1U, h.size());
+  EXPECT_EQ(&sv, h[0].context);
+  EXPECT_TRUE(h[0].flags & FI_SEND);
+}
+
+TEST_F(Shm_test, LargerThanRing)
+{
+  auto smr = server->register_memory(sbuf.data(), big, 0, 0);
+  auto cmr = client->register_memory(cbuf.data(), big, 0, 0);
+  for ( std::size_t i = 0; i != big; ++i )
+  {
+    sbuf[i] = char(i * 7);
+  }
+  ::iovec rv{cbuf.data(), big};
+  client->post_recv(&rv, &rv + 1, nullptr, &rv);
+  ::iovec sv{sbuf.data(), big};
+  void *desc = server->get_memory_descriptor(smr);
+  server->post_send(&sv, &sv + 1, &desc, &sv);
+
+  auto g = wait_n(client.get(), server);
+  auto h = wait_n(server, nullptr);
+  ASSERT_EQ(1U, g.size());
+  EXPECT_EQ(S_OK, g[0].status);
+  EXPECT_EQ(big, g[0].len);
+  ASSERT_EQ(1U, h.size());
+  EXPECT_EQ(&sv, h[0].context);
+  EXPECT_EQ(0, std::memcmp(cbuf.data(), sbuf.data(), big));
+
+  client->deregister_memory(cmr);
+  server->deregister_memory(smr);
+}
+
+TEST_F(Shm_test, ManySmallInOrder)
+{
+  const unsigned n = 200;
+  std::vector<::iovec> rvs(n);
+  for ( unsigned i = 0; i != n; ++i )
+  {
+    rvs[i] = ::iovec{sbuf.data() + i * 64, 64};
+    server->post_recv(&rvs[i], &rvs[i] + 1, nullptr, &rvs[i]);
+  }
+  /* alternate injected and posted sends; only the posted sends complete */
+  for ( unsigned i = 0; i != n; ++i )
+  {
+    if ( i % 2 )
+    {
+      client->inject_send(&i, sizeof i);
+    }
+    else
+    {
+      std::memcpy(cbuf.data() + i * 8, &i, sizeof i);
+      ::iovec sv{cbuf.data() + i * 8, sizeof i};
+      client->post_send(&sv, &sv + 1, nullptr, nullptr);
+    }
+  }
+
+  auto g = wait_n(server, client.get(), n);
+  ASSERT_EQ(n, g.size());
+  for ( unsigned i = 0; i != n; ++i )
+  {
+    unsigned v;
+    std::memcpy(&v, static_cast<::iovec *>(g[i].context)->iov_base, sizeof v);
+    EXPECT_EQ(&rvs[i], g[i].context);
+    EXPECT_EQ(i, v);
+  }
+  EXPECT_EQ(n / 2, wait_n(client.get(), nullptr, n / 2).size());
+}
+
+TEST_F(Shm_test, RemoteReadWrite)
+{
+  auto mr = server->register_memory(sbuf.data(), big, 0, 0);
+  for ( std::size_t i = 0; i != big; ++i )
+  {
+    sbuf[i] = char(i * 13);
+  }
+  auto key = server->get_memory_remote_key(mr);
+  auto addr = std::uint64_t(reinterpret_cast<std::uintptr_t>(sbuf.data()));
+  int ctx;
+
+  std::vector<::iovec> rv{{cbuf.data(), big / 2}, {cbuf.data() + big / 2, big / 2}};
+  client->post_read(rv, addr, key, &ctx);
+  auto g = wait_n(client.get(), server);
+  ASSERT_EQ(1U, g.size());
+  EXPECT_EQ(&ctx, g[0].context);
+  EXPECT_EQ(S_OK, g[0].status);
+  EXPECT_TRUE(g[0].flags & FI_READ);
+  EXPECT_EQ(0, std::memcmp(cbuf.data(), sbuf.data(), big));
+
+  std::memset(cbuf.data(), 'w', 100);
+  std::vector<::iovec> wv{{cbuf.data(), 100}};
+  client->post_write(wv, addr + 1000, key, &ctx);
+  g = wait_n(client.get(), server);
+  ASSERT_EQ(1U, g.size());
+  EXPECT_EQ(S_OK, g[0].status);
+  EXPECT_TRUE(g[0].flags & FI_WRITE);
+  EXPECT_EQ('w', sbuf[1000]);
+  EXPECT_EQ('w', sbuf[1099]);
+  EXPECT_EQ(char(1100 * 13), sbuf[1100]);
+
+  /* beyond the region, and an unknown key */
+  client->post_read(rv, addr + 1, key, &ctx);
+  g = wait_n(client.get(), server);
+  ASSERT_EQ(1U, g.size());
+  EXPECT_NE(S_OK, g[0].status);
+  client->post_write(wv, addr, key + 77, &ctx);
+  g = wait_n(client.get(), server);
+  ASSERT_EQ(1U, g.size());
+  EXPECT_NE(S_OK, g[0].status);
+
+  server->deregister_memory(mr);
+}
+
+TEST_F(Shm_test, SharedRegionReadInPlace)
+{
+  char path[] = "/tmp/shm-test-XXXXXX";
+  int fd = ::mkstemp(path);
+  ASSERT_LE(0, fd);
+  ::unlink(path);
+  ASSERT_EQ(0, ::ftruncate(fd, off_t(big)));
+  auto p = static_cast<char *>(::mmap(nullptr, big, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+  ASSERT_NE(MAP_FAILED, p);
+  ::close(fd);
+  for ( std::size_t i = 0; i != big; ++i )
+  {
+    p[i] = char(i * 11);
+  }
+  auto mr = server->register_memory(p + 4096, big - 4096, 0, component::IFabric_connection::MR_FLAG_SHAREABLE);
+  auto key = server->get_memory_remote_key(mr);
+  auto addr = std::uint64_t(reinterpret_cast<std::uintptr_t>(p + 4096));
+  int ctx;
+  /* the file is unlinked: the region cannot be shared, and is read through the server */
+  ::iovec rv{cbuf.data(), 1000};
+  client->post_read(&rv, &rv + 1, nullptr, addr + 17, key, &ctx);
+  auto g = wait_n(client.get(), server);
+  ASSERT_EQ(1U, g.size());
+  EXPECT_EQ(S_OK, g[0].status);
+  EXPECT_EQ(0, std::memcmp(cbuf.data(), p + 4096 + 17, 1000));
+  server->deregister_memory(mr);
+  ::munmap(p, big);
+
+  /* a linked file registered as shareable is shared: the read needs nothing from the server */
+  char path2[] = "/tmp/shm-test-XXXXXX";
+  fd = ::mkstemp(path2);
+  ASSERT_LE(0, fd);
+  ASSERT_EQ(0, ::ftruncate(fd, off_t(big)));
+  p = static_cast<char *>(::mmap(nullptr, big, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+  ASSERT_NE(MAP_FAILED, p);
+  ::close(fd);
+  for ( std::size_t i = 0; i != big; ++i )
+  {
+    p[i] = char(i * 11);
+  }
+  mr = server->register_memory(p + 4096 + 100, big - 8192, 0, component::IFabric_connection::MR_FLAG_SHAREABLE);
+  key = server->get_memory_remote_key(mr);
+  addr = std::uint64_t(reinterpret_cast<std::uintptr_t>(p + 4096 + 100));
+  rv = ::iovec{cbuf.data(), big - 8192};
+  client->post_read(&rv, &rv + 1, nullptr, addr, key, &ctx);
+  g = wait_n(client.get(), nullptr);
+  ASSERT_EQ(1U, g.size());
+  EXPECT_EQ(S_OK, g[0].status);
+  EXPECT_TRUE(g[0].flags & FI_READ);
+  EXPECT_EQ(0, std::memcmp(cbuf.data(), p + 4096 + 100, big - 8192));
+
+  /* writes by the server are seen in place */
+  p[5000] = 'x';
+  ::iovec rv1{cbuf.data(), 1};
+  client->post_read(&rv1, &rv1 + 1, nullptr, std::uint64_t(reinterpret_cast<std::uintptr_t>(p + 5000)), key, &ctx);
+  g = wait_n(client.get(), nullptr);
+  ASSERT_EQ(1U, g.size());
+  EXPECT_EQ('x', cbuf[0]);
+
+  /* once withdrawn, reads go through the server again */
+  server->deregister_memory(mr);
+  client->post_read(&rv1, &rv1 + 1, nullptr, addr, key, &ctx);
+  g = wait_n(client.get(), server);
+  ASSERT_EQ(1U, g.size());
+  EXPECT_NE(S_OK, g[0].status);
+  ::munmap(p, big);
+  ::unlink(path2);
+}
+
+TEST_F(Shm_test, Truncation)
+{
+  ::iovec rv{sbuf.data(), 8};
+  server->post_recv(&rv, &rv + 1, nullptr, &rv);
+  ::iovec sv{cbuf.data(), 100};
+  client->post_send(&sv, &sv + 1, nullptr, nullptr);
+  auto g = wait_n(server, client.get());
+  ASSERT_EQ(1U, g.size());
+  EXPECT_EQ(E_INSUFFICIENT_BUFFER, g[0].status);
+
+  /* the stream is still in step */
+  ::iovec rv2{sbuf.data(), 64};
+  server->post_recv(&rv2, &rv2 + 1, nullptr, &rv2);
+  unsigned v = 42;
+  client->inject_send(&v, sizeof v);
+  g = wait_n(server, client.get());
+  ASSERT_EQ(1U, g.size());
+  EXPECT_EQ(S_OK, g[0].status);
+  EXPECT_EQ(0, std::memcmp(sbuf.data(), &v, sizeof v));
+}
+
+TEST_F(Shm_test, ArmWait)
+{
+  ::iovec rv{sbuf.data(), 64};
+  server->post_recv(&rv, &rv + 1, nullptr, &rv);
+  std::vector<int> fds;
+  ASSERT_TRUE(server->arm_wait(fds));
+  ASSERT_EQ(1U, fds.size());
+  std::thread t(
+    [this] ()
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      unsigned v = 7;
+      client->inject_send(&v, sizeof v);
+    }
+  );
+  ::pollfd p{fds[0], POLLIN, 0};
+  EXPECT_EQ(1, ::poll(&p, 1, 2000));
+  t.join();
+  EXPECT_EQ(1U, wait_n(server, client.get()).size());
+
+  server->post_recv(&rv, &rv + 1, nullptr, &rv);
+  auto start = std::chrono::steady_clock::now();
+  server->wait_for_next_completion(std::chrono::milliseconds(100));
+  EXPECT_LT(std::chrono::milliseconds(90), std::chrono::steady_clock::now() - start);
+}
+
+TEST_F(Shm_test, ListenerArmWait)
+{
+  std::vector<int> fds;
+  ASSERT_TRUE(server_factory->arm_wait(fds));
+  ASSERT_EQ(1U, fds.size());
+  ::pollfd p{fds[0], POLLIN, 0};
+  EXPECT_EQ(0, ::poll(&p, 1, 0));
+
+  auto f = std::async(std::launch::async, [this] () { return fabric->open_client("{}", "unused", port); });
+  EXPECT_EQ(1, ::poll(&p, 1, 2000));
+  auto s2 = server_factory->get_new_connection();
+  std::unique_ptr<IFabric_client> c2(f.get());
+  ASSERT_TRUE(s2);
+  server_factory->close_connection(s2);
+}
+
+TEST_F(Shm_test, Disconnect)
+{
+  client.reset();
+  bool closed = false;
+  for ( auto start = std::chrono::steady_clock::now();
+        ! closed && std::chrono::steady_clock::now() - start < std::chrono::seconds(5);
+      )
+  {
+    try
+    {
+      server->poll_completions([] (void *, status_t, std::uint64_t, std::size_t, void *) {});
+    }
+    catch ( const std::logic_error & )
+    {
+      closed = true;
+    }
+  }
+  EXPECT_TRUE(closed);
+}
+
+TEST_F(Shm_test, GroupedUnsupported)
+{
+  EXPECT_THROW(fabric->open_client_grouped("{}", "unused", port), std::logic_error);
+}
+
+TEST_F(Shm_test, NoServer)
+{
+  EXPECT_THROW(fabric->open_client("{}", "unused", port + 1), std::system_error);
+}
+}  // namespace
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#pragma GCC diagnostic pop
@@ -0,0 +1,230 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "uring.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h> /* iovec */
+#include <unistd.h>
+
+#include <algorithm> /* max */
+#include <cerrno>
+#include <cstring> /* memset */
+#include <memory> /* unique_ptr */
+#include <system_error>
+
+namespace
+{
+  int io_uring_setup(unsigned entries, ::io_uring_params *p)
+  {
+    return int(::syscall(__NR_io_uring_setup, entries, p));
+  }
+
+  int io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+  {
+    return int(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+  }
+
+  int io_uring_register(int fd, unsigned opcode, const void *arg, unsigned nr_args)
+  {
+    return int(::syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+  }
+
+  void *map_ring(int fd, std::size_t len, off_t offset)
+  {
+    auto p = ::mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+    if ( p == MAP_FAILED )
+    {
+      throw std::system_error(std::error_code(errno, std::system_category()), "io_uring mmap");
+    }
+    return p;
+  }
+
+  template <typename T>
+    T *at(void *base, unsigned offset)
+    {
+      return reinterpret_cast<T *>(static_cast<char *>(base) + offset);
+    }
+}
+
+Uring::mapping::~mapping()
+{
+  if ( p )
+  {
+    ::munmap(p, len);
+  }
+}
+
+Uring::Uring(unsigned entries_)
+  : _fd()
+  , _params{}
+  , _sq_ring()
+  , _cq_ring()
+  , _sqes_map()
+  , _sq_head(nullptr)
+  , _sq_tail(nullptr)
+  , _sq_array(nullptr)
+  , _sq_mask(0)
+  , _sqes(nullptr)
+  , _sq_local_tail(0)
+  , _sq_submitted(0)
+  , _cq_head(nullptr)
+  , _cq_tail(nullptr)
+  , _cq_mask(0)
+  , _cqes(nullptr)
+  , _op_supported()
+  , _buffer_slots(0)
+{
+  /* twice as many completion entries: a zero-copy send completes twice */
+  _params.flags = IORING_SETUP_CQSIZE;
+  _params.cq_entries = 2 * entries_;
+  {
+    auto fd = io_uring_setup(entries_, &_params);
+    if ( fd < 0 )
+    {
+      throw std::system_error(std::error_code(errno, std::system_category()), "io_uring_setup");
+    }
+    _fd = common::Fd_open(fd);
+  }
+
+  _sq_ring.len = _params.sq_off.array + _params.sq_entries * sizeof(unsigned);
+  _cq_ring.len = _params.cq_off.cqes + _params.cq_entries * sizeof(::io_uring_cqe);
+  if ( _params.features & IORING_FEAT_SINGLE_MMAP )
+  {
+    _sq_ring.len = std::max(_sq_ring.len, _cq_ring.len);
+    _sq_ring.p = map_ring(fd(), _sq_ring.len, IORING_OFF_SQ_RING);
+  }
+  else
+  {
+    _sq_ring.p = map_ring(fd(), _sq_ring.len, IORING_OFF_SQ_RING);
+    _cq_ring.p = map_ring(fd(), _cq_ring.len, IORING_OFF_CQ_RING);
+  }
+  auto cq_base = _cq_ring.p ? _cq_ring.p : _sq_ring.p;
+
+  _sqes_map.len = _params.sq_entries * sizeof(::io_uring_sqe);
+  _sqes_map.p = map_ring(fd(), _sqes_map.len, IORING_OFF_SQES);
+
+  _sq_head = at<unsigned>(_sq_ring.p, _params.sq_off.head);
+  _sq_tail = at<unsigned>(_sq_ring.p, _params.sq_off.tail);
+  _sq_array = at<unsigned>(_sq_ring.p, _params.sq_off.array);
+  _sq_mask = *at<unsigned>(_sq_ring.p, _params.sq_off.ring_mask);
+  _sqes = static_cast<::io_uring_sqe *>(_sqes_map.p);
+  _sq_local_tail = _sq_submitted = *_sq_tail;
+
+  _cq_head = at<unsigned>(cq_base, _params.cq_off.head);
+  _cq_tail = at<unsigned>(cq_base, _params.cq_off.tail);
+  _cq_mask = *at<unsigned>(cq_base, _params.cq_off.ring_mask);
+  _cqes = at<::io_uring_cqe>(cq_base, _params.cq_off.cqes);
+
+  /* which operations does this kernel know? (IORING_REGISTER_PROBE itself is 5.6) */
+  constexpr unsigned probe_ops = 256;
+  std::unique_ptr<char[]> probe_mem(new char[sizeof(::io_uring_probe) + probe_ops * sizeof(::io_uring_probe_op)]());
+  auto probe = reinterpret_cast<::io_uring_probe *>(probe_mem.get());
+  if ( io_uring_register(fd(), IORING_REGISTER_PROBE, probe, probe_ops) == 0 )
+  {
+    _op_supported.resize(probe->ops_len);
+    for ( unsigned i = 0; i != probe->ops_len; ++i )
+    {
+      _op_supported[i] = probe->ops[i].flags & IO_URING_OP_SUPPORTED;
+    }
+  }
+}
+
+::io_uring_sqe *Uring::get_sqe()
+{
+  const auto head = __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+  if ( _params.sq_entries <= _sq_local_tail - head )
+  {
+    return nullptr;
+  }
+  const auto ix = _sq_local_tail & _sq_mask;
+  auto sqe = &_sqes[ix];
+  std::memset(sqe, 0, sizeof *sqe);
+  _sq_array[ix] = ix;
+  ++_sq_local_tail;
+  return sqe;
+}
+
+unsigned Uring::submit(unsigned wait_nr_)
+{
+  const auto to_submit = _sq_local_tail - _sq_submitted;
+  if ( to_submit == 0 && wait_nr_ == 0 )
+  {
+    return 0;
+  }
+  __atomic_store_n(_sq_tail, _sq_local_tail, __ATOMIC_RELEASE);
+  auto rc = io_uring_enter(fd(), to_submit, wait_nr_, wait_nr_ ? IORING_ENTER_GETEVENTS : 0U);
+  if ( rc < 0 )
+  {
+    /* interrupted, or completions must be reaped before more can be submitted */
+    if ( errno == EINTR || errno == EAGAIN || errno == EBUSY )
+    {
+      return 0;
+    }
+    throw std::system_error(std::error_code(errno, std::system_category()), "io_uring_enter");
+  }
+  _sq_submitted += unsigned(rc);
+  return unsigned(rc);
+}
+
+::io_uring_cqe *Uring::peek_cqe() const
+{
+  const auto head = *_cq_head;
+  return head == __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE) ? nullptr : &_cqes[head & _cq_mask];
+}
+
+void Uring::cqe_seen()
+{
+  __atomic_store_n(_cq_head, *_cq_head + 1, __ATOMIC_RELEASE);
+}
+
+bool Uring::cq_ready() const
+{
+  return peek_cqe() != nullptr;
+}
+
+bool Uring::register_buffer_slots(unsigned count_)
+{
+#ifdef URING_HAVE_SPARSE_BUFFERS
+  ::io_uring_rsrc_register r{};
+  r.nr = count_;
+  r.flags = IORING_RSRC_REGISTER_SPARSE;
+  if ( io_uring_register(fd(), IORING_REGISTER_BUFFERS2, &r, sizeof r) != 0 )
+  {
+    return false;
+  }
+  _buffer_slots = count_;
+  return true;
+#else
+  (void) count_;
+  return false;
+#endif
+}
+
+bool Uring::update_buffer_slot(unsigned slot_, const void *base_, std::size_t len_)
+{
+#ifdef URING_HAVE_SPARSE_BUFFERS
+  ::iovec v{const_cast<void *>(base_), len_};
+  ::io_uring_rsrc_update2 u{};
+  u.offset = slot_;
+  u.data = reinterpret_cast<std::uintptr_t>(&v);
+  u.nr = 1;
+  return io_uring_register(fd(), IORING_REGISTER_BUFFERS_UPDATE, &u, sizeof u) == 1;
+#else
+  (void) slot_;
+  (void) base_;
+  (void) len_;
+  return false;
+#endif
+}
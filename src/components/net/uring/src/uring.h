@@ -0,0 +1,118 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef _URING_H_
+#define _URING_H_
+
+#include <common/fd_open.h>
+
+#include <linux/io_uring.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Kernel headers from 5.6 suffice. Newer features are used only if the
+ * headers define them: sparse fixed buffer registration (5.19) and
+ * zero-copy send (6.0, with IORING_CQE_F_NOTIF). Without them there are
+ * no fixed buffers, and sends copy.
+ */
+#ifdef IORING_RSRC_REGISTER_SPARSE
+#define URING_HAVE_SPARSE_BUFFERS 1
+#endif
+#ifdef IORING_CQE_F_NOTIF
+#define URING_HAVE_SEND_ZC 1
+#endif
+
+/*
+ * A minimal io_uring: the submission and completion rings mapped from the
+ * kernel, driven by the raw system calls (there is no liburing dependency).
+ * Not thread safe; the owner serializes access.
+ */
+class Uring
+{
+  struct mapping
+  {
+    void *p;
+    std::size_t len;
+    mapping() : p(nullptr), len(0) {}
+    ~mapping();
+    mapping(const mapping &) = delete;
+    mapping &operator=(const mapping &) = delete;
+  };
+
+  common::Fd_open _fd;
+  ::io_uring_params _params;
+  mapping _sq_ring;
+  mapping _cq_ring;
+  mapping _sqes_map;
+
+  /* submission ring */
+  unsigned *_sq_head;
+  unsigned *_sq_tail;
+  unsigned *_sq_array;
+  unsigned _sq_mask;
+  ::io_uring_sqe *_sqes;
+  unsigned _sq_local_tail; /* tail, including entries not yet published to the kernel */
+  unsigned _sq_submitted;  /* tail as of the last io_uring_enter */
+
+  /* completion ring */
+  unsigned *_cq_head;
+  unsigned *_cq_tail;
+  unsigned _cq_mask;
+  ::io_uring_cqe *_cqes;
+
+  std::vector<bool> _op_supported;
+  unsigned _buffer_slots;
+
+public:
+  /*
+   * @throw std::system_error - io_uring_setup or mmap fail
+   */
+  explicit Uring(unsigned entries);
+  Uring(const Uring &) = delete;
+  Uring &operator=(const Uring &) = delete;
+
+  int fd() const { return _fd.fd(); }
+
+  /* @return a zeroed submission entry, or nullptr if the ring is full (submit, then retry) */
+  ::io_uring_sqe *get_sqe();
+
+  /*
+   * Pass all prepared entries to the kernel in a single system call, and
+   * optionally wait for completions.
+   *
+   * @throw std::system_error - io_uring_enter fail
+   */
+  unsigned submit(unsigned wait_nr = 0);
+
+  /* @return the next completion, or nullptr. Release it with cqe_seen */
+  ::io_uring_cqe *peek_cqe() const;
+  void cqe_seen();
+  bool cq_ready() const;
+
+  bool supports(unsigned op) const { return op < _op_supported.size() && _op_supported[op]; }
+
+  /*
+   * Fixed (registered) buffers: a sparse table of slots, filled and
+   * emptied one at a time.
+   *
+   * @return false if the kernel refused (e.g. RLIMIT_MEMLOCK)
+   */
+  bool register_buffer_slots(unsigned count);
+  unsigned buffer_slots() const { return _buffer_slots; }
+  bool update_buffer_slot(unsigned slot, const void *base, std::size_t len);
+};
+
+#endif
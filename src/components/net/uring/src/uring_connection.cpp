@@ -0,0 +1,991 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "uring_connection.h"
+
+#include <common/logging.h>
+
+#include <arpa/inet.h> /* inet_ntop */
+#include <netinet/in.h>
+#include <netinet/tcp.h> /* TCP_NODELAY */
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm> /* min */
+#include <cerrno>
+#include <cstring> /* memcpy, memmove */
+#include <system_error>
+
+constexpr std::size_t Uring_connection::MAX_MESSAGE_SIZE;
+constexpr std::size_t Uring_connection::DEFAULT_INJECT_SIZE;
+constexpr std::size_t Uring_connection::STAGING_SIZE;
+constexpr std::size_t Uring_connection::DIRECT_RECV_MIN;
+constexpr std::size_t Uring_connection::ZC_THRESHOLD;
+constexpr std::size_t Uring_connection::FIXED_BUFFER_MAX;
+constexpr unsigned Uring_connection::BUFFER_SLOTS;
+constexpr unsigned Uring_connection::RING_ENTRIES;
+constexpr unsigned Uring_connection::SEND_IOV_MAX;
+
+namespace
+{
+  int make_eventfd()
+  {
+    auto fd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if ( fd < 0 )
+    {
+      throw std::system_error(std::error_code(errno, std::system_category()), "eventfd");
+    }
+    return fd;
+  }
+
+  bool zc_supported(const Uring &ring_)
+  {
+#ifdef URING_HAVE_SEND_ZC
+    return ring_.supports(IORING_OP_SEND_ZC);
+#else
+    (void) ring_;
+    return false;
+#endif
+  }
+
+  /* a zero-copy send completion which a notification will follow */
+  bool zc_more(bool zc_send_, unsigned flags_)
+  {
+#ifdef URING_HAVE_SEND_ZC
+    return zc_send_ && (flags_ & IORING_CQE_F_MORE);
+#else
+    (void) zc_send_;
+    (void) flags_;
+    return false;
+#endif
+  }
+
+  /* the notification that a zero-copy send buffer is free again */
+  bool zc_notification(unsigned flags_)
+  {
+#ifdef URING_HAVE_SEND_ZC
+    return flags_ & IORING_CQE_F_NOTIF;
+#else
+    (void) flags_;
+    return false;
+#endif
+  }
+
+  std::size_t iov_total(const std::vector<::iovec> &v)
+  {
+    std::size_t t = 0;
+    for ( const auto &e : v )
+    {
+      t += e.iov_len;
+    }
+    return t;
+  }
+
+  std::size_t iov_total(const ::iovec *first, const ::iovec *last)
+  {
+    std::size_t t = 0;
+    for ( ; first != last; ++first )
+    {
+      t += first->iov_len;
+    }
+    return t;
+  }
+
+  /* drop the first n bytes from an iovec list */
+  void advance(std::vector<::iovec> &v, std::size_t n)
+  {
+    auto it = v.begin();
+    for ( ; it != v.end() && it->iov_len <= n; ++it )
+    {
+      n -= it->iov_len;
+    }
+    if ( it != v.end() )
+    {
+      it->iov_base = static_cast<char *>(it->iov_base) + n;
+      it->iov_len -= n;
+    }
+    v.erase(v.begin(), it);
+  }
+
+  frame_header make_header(frame_type type_, std::size_t len_, std::uint64_t tag_ = 0, std::uint64_t addr_ = 0, std::uint64_t key_ = 0)
+  {
+    frame_header h{};
+    h.type = type_;
+    h.len = std::uint32_t(len_);
+    h.tag = tag_;
+    h.addr = addr_;
+    h.key = key_;
+    h.extent = len_;
+    return h;
+  }
+
+  std::string addr_string(const ::sockaddr_storage &ss)
+  {
+    char buf[INET6_ADDRSTRLEN] = "";
+    if ( ss.ss_family == AF_INET )
+    {
+      ::inet_ntop(AF_INET, &reinterpret_cast<const ::sockaddr_in *>(&ss)->sin_addr, buf, sizeof buf);
+    }
+    else if ( ss.ss_family == AF_INET6 )
+    {
+      ::inet_ntop(AF_INET6, &reinterpret_cast<const ::sockaddr_in6 *>(&ss)->sin6_addr, buf, sizeof buf);
+    }
+    return buf;
+  }
+}
+
+Uring_connection::Uring_connection(int socket_, std::size_t inject_size_)
+  : _m()
+  , _socket(socket_)
+  , _ring(RING_ENTRIES)
+  , _unblock(make_eventfd())
+  , _inject_size(inject_size_)
+  , _zc_ok(zc_supported(_ring))
+  , _closed(false)
+  , _close_reason(nullptr)
+  , _inflight(0)
+  , _regions()
+  , _region_set()
+  , _next_key(1)
+  , _free_slots()
+  , _staging(new char[STAGING_SIZE])
+  , _staging_fixed(false)
+  , _stage_begin(0)
+  , _stage_end(0)
+  , _rx_in_flight(false)
+  , _rx_blocked(false)
+  , _rx_active(false)
+  , _rx_hdr{}
+  , _rx_iov()
+  , _rx_left(0)
+  , _rx_context(nullptr)
+  , _rx_status(S_OK)
+  , _rx_direct_iov()
+  , _rx_msg{}
+  , _posted_recvs()
+  , _tx_queue()
+  , _tx_batch()
+  , _tx_iov()
+  , _tx_msg{}
+  , _tx_outstanding(0)
+  , _pending_rma()
+  , _next_tag(1)
+  , _completions()
+  , _stalled()
+{
+  int one = 1;
+  ::setsockopt(_socket.fd(), IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+
+  /* The staging buffer, and any registered memory which fits, are fixed
+   * buffers: the kernel pins them once rather than on every operation.
+   */
+  if ( _ring.register_buffer_slots(BUFFER_SLOTS) && _ring.update_buffer_slot(0, _staging.get(), STAGING_SIZE) )
+  {
+    _staging_fixed = true;
+    for ( auto s = BUFFER_SLOTS; s != 1; --s )
+    {
+      _free_slots.push_back(s - 1);
+    }
+  }
+  else
+  {
+    PWRN("%s: fixed buffers not available (RLIMIT_MEMLOCK?); continuing without", __func__);
+  }
+
+  guard g{_m};
+  kick_recv();
+  _ring.submit();
+}
+
+Uring_connection::~Uring_connection()
+{
+  guard g{_m};
+  ::shutdown(_socket.fd(), SHUT_RDWR);
+  /* in-flight operations refer to our buffers: wait (a while) for them to end */
+  for ( unsigned i = 0; _inflight != 0 && i != 50; ++i )
+  {
+    ::pollfd p{_ring.fd(), POLLIN, 0};
+    ::poll(&p, 1, 100);
+    reap(false);
+  }
+  if ( _inflight != 0 )
+  {
+    PWRN("%s: %u operations outstanding at close", __func__, _inflight);
+  }
+}
+
+::io_uring_sqe *Uring_connection::get_sqe()
+{
+  auto sqe = _ring.get_sqe();
+  if ( ! sqe )
+  {
+    _ring.submit();
+    sqe = _ring.get_sqe();
+    if ( ! sqe )
+    {
+      throw std::runtime_error("uring: submission ring full");
+    }
+  }
+  return sqe;
+}
+
+void Uring_connection::close(const char *reason_)
+{
+  if ( _closed )
+  {
+    return;
+  }
+  _closed = true;
+  _close_reason = reason_;
+  ::shutdown(_socket.fd(), SHUT_RDWR);
+
+  /* Operations which will not now complete fail. (Buffers of the batch in
+   * flight stay allocated until the ring is done with them.)
+   */
+  for ( auto &t : _tx_batch )
+  {
+    if ( t.signal )
+    {
+      complete(t.context, E_FAIL, FI_SEND, 0, reason_);
+      t.signal = false;
+    }
+  }
+  for ( const auto &t : _tx_queue )
+  {
+    if ( t.signal )
+    {
+      complete(t.context, E_FAIL, FI_SEND, 0, reason_);
+    }
+  }
+  _tx_queue.clear();
+  for ( const auto &p : _pending_rma )
+  {
+    complete(p.second.context, E_FAIL, p.second.flags, 0, reason_);
+  }
+  _pending_rma.clear();
+}
+
+void Uring_connection::progress()
+{
+  kick_send();
+  kick_recv();
+  _ring.submit();
+  /* each round may post more work (a response to a remote read, a receive) */
+  for ( unsigned round = 0; round != 8 && _ring.cq_ready(); ++round )
+  {
+    reap(true);
+    kick_send();
+    kick_recv();
+    _ring.submit();
+  }
+}
+
+void Uring_connection::reap(bool process_)
+{
+  while ( auto cqe = _ring.peek_cqe() )
+  {
+    const auto op = cqe->user_data;
+    const auto res = cqe->res;
+    const auto flags = cqe->flags;
+    _ring.cqe_seen();
+    --_inflight;
+    if ( zc_more(op == OP_SEND_ZC, flags) )
+    {
+      ++_inflight; /* the notification follows */
+    }
+    if ( process_ )
+    {
+      if ( op == OP_RECV_STAGE || op == OP_RECV_DIRECT )
+      {
+        on_recv(op, res);
+      }
+      else
+      {
+        on_send(op, res, flags);
+      }
+    }
+  }
+}
+
+/* receive */
+
+void Uring_connection::on_recv(std::uint64_t op_, int res_)
+{
+  _rx_in_flight = false;
+  if ( res_ < 0 )
+  {
+    if ( res_ != -EINTR && res_ != -EAGAIN )
+    {
+      close("uring: receive failed");
+    }
+  }
+  else if ( res_ == 0 )
+  {
+    close("uring: connection closed by peer");
+  }
+  else if ( op_ == OP_RECV_STAGE )
+  {
+    _stage_end += std::size_t(res_);
+  }
+  else
+  {
+    advance(_rx_iov, std::size_t(res_));
+    _rx_left -= std::size_t(res_);
+  }
+}
+
+void Uring_connection::kick_recv()
+{
+  if ( ! _closed && ! _rx_in_flight )
+  {
+    process_rx();
+  }
+}
+
+void Uring_connection::process_rx()
+{
+  while ( ! _closed )
+  {
+    if ( _rx_active )
+    {
+      const auto n = std::min(_stage_end - _stage_begin, _rx_left);
+      consume(&_staging[_stage_begin], n);
+      _stage_begin += n;
+      if ( _rx_left == 0 )
+      {
+        finish_frame();
+        continue;
+      }
+      /* the rest of the payload is still on the wire */
+      _stage_begin = _stage_end = 0;
+      if ( DIRECT_RECV_MIN <= std::min(iov_total(_rx_iov), _rx_left) )
+      {
+        submit_direct_recv();
+      }
+      else
+      {
+        submit_stage_recv();
+      }
+      return;
+    }
+
+    if ( _stage_end - _stage_begin < sizeof(frame_header) )
+    {
+      std::memmove(&_staging[0], &_staging[_stage_begin], _stage_end - _stage_begin);
+      _stage_end -= _stage_begin;
+      _stage_begin = 0;
+      submit_stage_recv();
+      return;
+    }
+
+    frame_header h;
+    std::memcpy(&h, &_staging[_stage_begin], sizeof h);
+    if ( h.type == FRAME_SEND && _posted_recvs.empty() )
+    {
+      /* hold the message (and everything behind it) until a receive is posted */
+      _rx_blocked = true;
+      return;
+    }
+    _stage_begin += sizeof h;
+    start_frame(h);
+  }
+}
+
+void Uring_connection::start_frame(const frame_header &h_)
+{
+  _rx_hdr = h_;
+  _rx_left = h_.len;
+  _rx_iov.clear();
+  _rx_context = nullptr;
+  _rx_status = S_OK;
+  _rx_active = true;
+
+  switch ( h_.type )
+  {
+  case FRAME_SEND:
+    {
+      auto &p = _posted_recvs.front();
+      _rx_iov = std::move(p.v);
+      _rx_context = p.context;
+      _posted_recvs.pop_front();
+      if ( iov_total(_rx_iov) < h_.len )
+      {
+        _rx_status = E_INSUFFICIENT_BUFFER; /* the excess is discarded */
+      }
+    }
+    break;
+  case FRAME_READ_RESP:
+    {
+      auto it = _pending_rma.find(h_.tag);
+      if ( it != _pending_rma.end() )
+      {
+        _rx_iov = it->second.v;
+      }
+    }
+    break;
+  case FRAME_WRITE:
+    if ( find_region(h_.key, h_.addr, h_.len) )
+    {
+      _rx_iov.push_back(::iovec{reinterpret_cast<void *>(h_.addr), h_.len});
+    }
+    else
+    {
+      _rx_status = E_INVAL;
+    }
+    break;
+  case FRAME_READ_REQ:
+  case FRAME_WRITE_ACK:
+    break;
+  default:
+    PERR("%s: bad frame type %u", __func__, unsigned(h_.type));
+    _rx_active = false;
+    close("uring: protocol error");
+    break;
+  }
+}
+
+void Uring_connection::finish_frame()
+{
+  _rx_active = false;
+  const auto &h = _rx_hdr;
+  switch ( h.type )
+  {
+  case FRAME_SEND:
+    complete(_rx_context, _rx_status, FI_RECV, h.len, _rx_status == S_OK ? nullptr : "uring: message longer than receive buffer");
+    break;
+  case FRAME_READ_REQ:
+    {
+      tx_item t{};
+      t.hdr = make_header(FRAME_READ_RESP, 0, h.tag);
+      const auto r = find_region(h.key, h.addr, h.extent);
+      if ( r && h.extent <= MAX_MESSAGE_SIZE )
+      {
+        t.hdr.len = std::uint32_t(h.extent);
+        t.payload.push_back(::iovec{reinterpret_cast<void *>(h.addr), h.extent});
+        t.fixed = r;
+      }
+      else
+      {
+        t.hdr.status = FRAME_BAD_KEY;
+      }
+      enqueue(std::move(t));
+    }
+    break;
+  case FRAME_WRITE:
+    {
+      tx_item t{};
+      t.hdr = make_header(FRAME_WRITE_ACK, 0, h.tag);
+      t.hdr.status = _rx_status == S_OK ? FRAME_OK : FRAME_BAD_KEY;
+      enqueue(std::move(t));
+    }
+    break;
+  case FRAME_READ_RESP:
+  case FRAME_WRITE_ACK:
+    {
+      auto it = _pending_rma.find(h.tag);
+      if ( it == _pending_rma.end() )
+      {
+        PWRN("%s: response for unknown operation %lu", __func__, h.tag);
+        break;
+      }
+      const auto ok = h.status == FRAME_OK;
+      complete(it->second.context, ok ? S_OK : E_FAIL, it->second.flags, ok ? it->second.len : 0, ok ? nullptr : "uring: remote key or range not registered");
+      _pending_rma.erase(it);
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+void Uring_connection::consume(const char *p_, std::size_t n_)
+{
+  _rx_left -= n_;
+  while ( n_ != 0 && ! _rx_iov.empty() )
+  {
+    auto &v = _rx_iov.front();
+    const auto m = std::min(n_, v.iov_len);
+    std::memcpy(v.iov_base, p_, m);
+    p_ += m;
+    n_ -= m;
+    advance(_rx_iov, m);
+  }
+  /* bytes beyond the destination are discarded */
+}
+
+void Uring_connection::submit_stage_recv()
+{
+  auto sqe = get_sqe();
+  sqe->fd = _socket.fd();
+  sqe->addr = reinterpret_cast<std::uintptr_t>(&_staging[_stage_end]);
+  sqe->len = std::uint32_t(STAGING_SIZE - _stage_end);
+  if ( _staging_fixed )
+  {
+    sqe->opcode = IORING_OP_READ_FIXED;
+    sqe->buf_index = 0;
+  }
+  else
+  {
+    sqe->opcode = IORING_OP_RECV;
+  }
+  sqe->user_data = OP_RECV_STAGE;
+  _rx_in_flight = true;
+  ++_inflight;
+}
+
+void Uring_connection::submit_direct_recv()
+{
+  /* the destination, limited to this frame's payload */
+  _rx_direct_iov.clear();
+  auto left = _rx_left;
+  for ( auto it = _rx_iov.begin(); left != 0 && it != _rx_iov.end(); ++it )
+  {
+    const auto m = std::min(left, it->iov_len);
+    _rx_direct_iov.push_back(::iovec{it->iov_base, m});
+    left -= m;
+  }
+  _rx_msg = ::msghdr{};
+  _rx_msg.msg_iov = _rx_direct_iov.data();
+  _rx_msg.msg_iovlen = _rx_direct_iov.size();
+
+  auto sqe = get_sqe();
+  sqe->opcode = IORING_OP_RECVMSG;
+  sqe->fd = _socket.fd();
+  sqe->addr = reinterpret_cast<std::uintptr_t>(&_rx_msg);
+  sqe->len = 1;
+  sqe->msg_flags = MSG_WAITALL;
+  sqe->user_data = OP_RECV_DIRECT;
+  _rx_in_flight = true;
+  ++_inflight;
+}
+
+/* send */
+
+void Uring_connection::enqueue(tx_item &&t_)
+{
+  _tx_queue.push_back(std::move(t_));
+  kick_send();
+}
+
+void Uring_connection::kick_send()
+{
+  if ( _closed || _tx_outstanding != 0 || _tx_queue.empty() )
+  {
+    return;
+  }
+
+  _tx_batch.clear();
+  _tx_iov.clear();
+
+  const auto zero_copy = [this] (const tx_item &t) { return _zc_ok && t.payload.size() == 1 && ZC_THRESHOLD <= t.payload[0].iov_len; };
+
+#ifdef URING_HAVE_SEND_ZC
+  if ( zero_copy(_tx_queue.front()) )
+  {
+    _tx_batch.push_back(std::move(_tx_queue.front()));
+    _tx_queue.pop_front();
+    auto &t = _tx_batch.back();
+    _tx_iov.push_back(::iovec{&t.hdr, sizeof t.hdr});
+    _tx_iov.push_back(t.payload[0]);
+
+    /* the header, linked to the zero-copy payload so that the two stay in order */
+    auto h = get_sqe();
+    h->opcode = IORING_OP_SEND;
+    h->fd = _socket.fd();
+    h->addr = reinterpret_cast<std::uintptr_t>(&t.hdr);
+    h->len = sizeof t.hdr;
+    h->msg_flags = MSG_MORE | MSG_WAITALL | MSG_NOSIGNAL;
+    h->flags = IOSQE_IO_LINK;
+    h->user_data = OP_SEND;
+
+    auto z = get_sqe();
+    z->opcode = IORING_OP_SEND_ZC;
+    z->fd = _socket.fd();
+    z->addr = reinterpret_cast<std::uintptr_t>(t.payload[0].iov_base);
+    z->len = std::uint32_t(t.payload[0].iov_len);
+    z->msg_flags = MSG_WAITALL | MSG_NOSIGNAL;
+    if ( t.fixed && 0 <= t.fixed->slot )
+    {
+      z->ioprio = IORING_RECVSEND_FIXED_BUF;
+      z->buf_index = std::uint16_t(t.fixed->slot);
+    }
+    z->user_data = OP_SEND_ZC;
+
+    _tx_outstanding = 2;
+    _inflight += 2;
+    return;
+  }
+#endif
+
+  /* everything else queued, up to the first zero-copy candidate, goes out as one sendmsg */
+  std::size_t iov_count = 0;
+  while (
+    ! _tx_queue.empty()
+    && ( _tx_batch.empty() || ( ! zero_copy(_tx_queue.front()) && iov_count + 1 + _tx_queue.front().payload.size() <= SEND_IOV_MAX ) )
+  )
+  {
+    iov_count += 1 + _tx_queue.front().payload.size();
+    _tx_batch.push_back(std::move(_tx_queue.front()));
+    _tx_queue.pop_front();
+  }
+
+  for ( auto &t : _tx_batch )
+  {
+    _tx_iov.push_back(::iovec{&t.hdr, sizeof t.hdr});
+    _tx_iov.insert(_tx_iov.end(), t.payload.begin(), t.payload.end());
+  }
+  submit_sendmsg();
+}
+
+void Uring_connection::submit_sendmsg()
+{
+  _tx_msg = ::msghdr{};
+  _tx_msg.msg_iov = _tx_iov.data();
+  _tx_msg.msg_iovlen = _tx_iov.size();
+
+  auto sqe = get_sqe();
+  sqe->opcode = IORING_OP_SENDMSG;
+  sqe->fd = _socket.fd();
+  sqe->addr = reinterpret_cast<std::uintptr_t>(&_tx_msg);
+  sqe->len = 1;
+  sqe->msg_flags = MSG_WAITALL | MSG_NOSIGNAL;
+  sqe->user_data = OP_SEND;
+  _tx_outstanding = 1;
+  ++_inflight;
+}
+
+void Uring_connection::on_send(std::uint64_t op_, int res_, unsigned flags_)
+{
+  --_tx_outstanding;
+  if ( ! zc_notification(flags_) )
+  {
+    if ( zc_more(op_ == OP_SEND_ZC, flags_) )
+    {
+      ++_tx_outstanding;
+    }
+    if ( 0 < res_ )
+    {
+      advance(_tx_iov, std::size_t(res_));
+    }
+    else if ( res_ == -ECANCELED || res_ == -EINTR || res_ == -EAGAIN )
+    {
+      /* what was not sent is sent again, below */
+    }
+    else if ( op_ == OP_SEND_ZC && (res_ == -EOPNOTSUPP || res_ == -EINVAL) )
+    {
+      PWRN("%s: zero-copy send unavailable (%d); copying instead", __func__, -res_);
+      _zc_ok = false;
+    }
+    else
+    {
+      close("uring: send failed");
+    }
+  }
+  if ( _tx_outstanding == 0 )
+  {
+    send_done();
+  }
+}
+
+void Uring_connection::send_done()
+{
+  if ( _closed )
+  {
+    _tx_batch.clear();
+    _tx_iov.clear();
+    return;
+  }
+  if ( ! _tx_iov.empty() )
+  {
+    submit_sendmsg();
+    return;
+  }
+  for ( const auto &t : _tx_batch )
+  {
+    if ( t.signal )
+    {
+      complete(t.context, S_OK, FI_SEND, t.hdr.len);
+    }
+  }
+  _tx_batch.clear();
+  kick_send();
+}
+
+/* operations */
+
+void Uring_connection::post_send(const ::iovec *first_, const ::iovec *last_, void **desc_, void *context_)
+{
+  const auto len = iov_total(first_, last_);
+  if ( MAX_MESSAGE_SIZE < len )
+  {
+    throw std::range_error("uring: message exceeds max_message_size");
+  }
+  guard g{_m};
+  if ( _closed )
+  {
+    return;
+  }
+  tx_item t{};
+  t.hdr = make_header(FRAME_SEND, len);
+  t.payload.assign(first_, last_);
+  t.fixed = last_ - first_ == 1 && desc_ ? own_region(desc_[0]) : nullptr;
+  t.context = context_;
+  t.signal = true;
+  enqueue(std::move(t));
+  _ring.submit();
+}
+
+void Uring_connection::inject_send(const void *buf_, std::size_t len_)
+{
+  guard g{_m};
+  if ( _closed )
+  {
+    return;
+  }
+  tx_item t{};
+  t.hdr = make_header(FRAME_SEND, len_);
+  t.copy.assign(static_cast<const char *>(buf_), static_cast<const char *>(buf_) + len_);
+  t.payload.push_back(::iovec{t.copy.data(), t.copy.size()});
+  enqueue(std::move(t));
+  _ring.submit();
+}
+
+void Uring_connection::post_recv(const ::iovec *first_, const ::iovec *last_, void *context_)
+{
+  guard g{_m};
+  if ( _closed )
+  {
+    return;
+  }
+  _posted_recvs.push_back(posted_recv{std::vector<::iovec>(first_, last_), context_});
+  if ( _rx_blocked )
+  {
+    _rx_blocked = false;
+    kick_recv();
+    _ring.submit();
+  }
+}
+
+void Uring_connection::post_read(const ::iovec *first_, const ::iovec *last_, std::uint64_t remote_addr_, std::uint64_t key_, void *context_)
+{
+  const auto len = iov_total(first_, last_);
+  guard g{_m};
+  if ( _closed )
+  {
+    return;
+  }
+  const auto tag = _next_tag++;
+  _pending_rma.emplace(tag, pending_rma{std::vector<::iovec>(first_, last_), context_, len, FI_READ});
+  tx_item t{};
+  t.hdr = make_header(FRAME_READ_REQ, 0, tag, remote_addr_, key_);
+  t.hdr.extent = len;
+  enqueue(std::move(t));
+  _ring.submit();
+}
+
+void Uring_connection::post_write(const ::iovec *first_, const ::iovec *last_, void **desc_, std::uint64_t remote_addr_, std::uint64_t key_, void *context_)
+{
+  const auto len = iov_total(first_, last_);
+  if ( MAX_MESSAGE_SIZE < len )
+  {
+    throw std::range_error("uring: write exceeds max_message_size");
+  }
+  guard g{_m};
+  if ( _closed )
+  {
+    return;
+  }
+  const auto tag = _next_tag++;
+  _pending_rma.emplace(tag, pending_rma{std::vector<::iovec>(), context_, len, FI_WRITE});
+  tx_item t{};
+  t.hdr = make_header(FRAME_WRITE, len, tag, remote_addr_, key_);
+  t.payload.assign(first_, last_);
+  t.fixed = last_ - first_ == 1 && desc_ ? own_region(desc_[0]) : nullptr;
+  enqueue(std::move(t));
+  _ring.submit();
+}
+
+/* completions */
+
+auto Uring_connection::take_completions() -> std::deque<completion>
+{
+  guard g{_m};
+  progress();
+  std::deque<completion> ready;
+  ready.swap(_completions);
+  ready.insert(ready.end(), _stalled.begin(), _stalled.end());
+  _stalled.clear();
+  if ( ready.empty() && _closed )
+  {
+    throw std::logic_error(_close_reason);
+  }
+  return ready;
+}
+
+void Uring_connection::stall(std::deque<completion> &&deferred_)
+{
+  guard g{_m};
+  _stalled.insert(_stalled.end(), deferred_.begin(), deferred_.end());
+}
+
+std::size_t Uring_connection::stalled_completion_count()
+{
+  guard g{_m};
+  return _stalled.size();
+}
+
+void Uring_connection::wait(int timeout_ms_)
+{
+  ::pollfd p[2] = { {_ring.fd(), POLLIN, 0}, {_unblock.fd(), POLLIN, 0} };
+  if ( ::poll(p, 2, timeout_ms_) < 0 && errno != EINTR )
+  {
+    throw std::system_error(std::error_code(errno, std::system_category()), "uring: poll");
+  }
+  if ( p[1].revents )
+  {
+    std::uint64_t count;
+    auto sz = ::read(_unblock.fd(), &count, sizeof count);
+    (void) sz;
+  }
+}
+
+void Uring_connection::wait_for_next_completion(unsigned /* polls_limit */)
+{
+  {
+    guard g{_m};
+    progress();
+    if ( ! _completions.empty() || _closed )
+    {
+      return;
+    }
+  }
+  wait(-1);
+}
+
+void Uring_connection::wait_for_next_completion(std::chrono::milliseconds timeout_)
+{
+  {
+    guard g{_m};
+    progress();
+    if ( ! _completions.empty() || _closed )
+    {
+      return;
+    }
+  }
+  wait(int(timeout_.count()));
+}
+
+void Uring_connection::unblock_completions()
+{
+  std::uint64_t one = 1;
+  auto sz = ::write(_unblock.fd(), &one, sizeof one);
+  (void) sz;
+}
+
+bool Uring_connection::arm_wait(std::vector<int> &fds_)
+{
+  guard g{_m};
+  progress();
+  if ( ! _completions.empty() || ! _stalled.empty() || _closed )
+  {
+    return false;
+  }
+  /* the ring is readable when a completion (e.g. of the receive always in flight) arrives */
+  fds_.push_back(_ring.fd());
+  return true;
+}
+
+/* memory */
+
+auto Uring_connection::register_memory(const void *contig_addr_, std::size_t size_, std::uint64_t, std::uint64_t) -> memory_region_t
+{
+  guard g{_m};
+  std::unique_ptr<region> r(new region{static_cast<const char *>(contig_addr_), size_, _next_key++, -1});
+  if ( size_ <= FIXED_BUFFER_MAX && ! _free_slots.empty() )
+  {
+    const auto slot = _free_slots.back();
+    if ( _ring.update_buffer_slot(slot, contig_addr_, size_) )
+    {
+      r->slot = int(slot);
+      _free_slots.pop_back();
+    }
+  }
+  auto p = r.get();
+  _region_set.insert(p);
+  _regions.emplace(p->key, std::move(r));
+  return reinterpret_cast<memory_region_t>(p);
+}
+
+void Uring_connection::deregister_memory(const memory_region_t memory_region_)
+{
+  guard g{_m};
+  const auto p = reinterpret_cast<const region *>(memory_region_);
+  auto it = _regions.find(p->key);
+  if ( it == _regions.end() || it->second.get() != p )
+  {
+    throw std::range_error("uring: memory region not registered");
+  }
+  if ( 0 <= p->slot )
+  {
+    _ring.update_buffer_slot(unsigned(p->slot), nullptr, 0);
+    _free_slots.push_back(unsigned(p->slot));
+  }
+  _region_set.erase(p);
+  _regions.erase(it);
+}
+
+std::uint64_t Uring_connection::get_memory_remote_key(const memory_region_t memory_region_) const noexcept
+{
+  return reinterpret_cast<const region *>(memory_region_)->key;
+}
+
+void *Uring_connection::get_memory_descriptor(const memory_region_t memory_region_) const noexcept
+{
+  return memory_region_;
+}
+
+auto Uring_connection::find_region(std::uint64_t key_, std::uint64_t addr_, std::uint64_t len_) const -> const region *
+{
+  auto it = _regions.find(key_);
+  if ( it == _regions.end() )
+  {
+    return nullptr;
+  }
+  const auto &r = *it->second;
+  const auto base = reinterpret_cast<std::uintptr_t>(r.base);
+  return base <= addr_ && len_ <= r.len && addr_ - base <= r.len - len_ ? &r : nullptr;
+}
+
+/* a descriptor is ours if it names a region registered with this connection */
+auto Uring_connection::own_region(void *desc_) const -> const region *
+{
+  const auto p = static_cast<const region *>(desc_);
+  return _region_set.count(p) ? p : nullptr;
+}
+
+std::string Uring_connection::get_peer_addr()
+{
+  ::sockaddr_storage ss{};
+  ::socklen_t len = sizeof ss;
+  ::getpeername(_socket.fd(), reinterpret_cast<::sockaddr *>(&ss), &len);
+  return addr_string(ss);
+}
+
+std::string Uring_connection::get_local_addr()
+{
+  ::sockaddr_storage ss{};
+  ::socklen_t len = sizeof ss;
+  ::getsockname(_socket.fd(), reinterpret_cast<::sockaddr *>(&ss), &len);
+  return addr_string(ss);
+}
@@ -0,0 +1,279 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef _URING_CONNECTION_H_
+#define _URING_CONNECTION_H_
+
+#include <api/fabric_itf.h>
+#include <common/errors.h> /* status_t */
+#include <common/fd_open.h>
+
+#include "uring.h"
+#include "uring_frame.h"
+
+#include <sys/socket.h> /* msghdr */
+#include <sys/uio.h> /* iovec */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/*
+ * One TCP connection driven through its own io_uring: the implementation
+ * shared by Uring_server and Uring_client.
+ *
+ * Sends are serialized, one batch in flight at a time, so frames cannot
+ * interleave on the stream; frames posted while a batch is in flight go
+ * out together, as one sendmsg, in the next batch. A payload of at least
+ * ZC_THRESHOLD bytes in a single buffer is sent zero-copy, from a fixed
+ * (registered) buffer if it lies within registered memory.
+ *
+ * Receives go to a registered staging buffer, from which headers and small
+ * payloads are copied. The rest of a large payload is received directly
+ * into its destination: the posted receive buffer, or registered memory
+ * for an emulated remote write.
+ */
+class Uring_connection
+{
+public:
+  using memory_region_t = component::IFabric_memory_region *;
+  using cb_acceptance = component::IFabric_op_completer::cb_acceptance;
+
+  static constexpr std::size_t MAX_MESSAGE_SIZE = std::size_t(1) << 30;
+  static constexpr std::size_t DEFAULT_INJECT_SIZE = 128;
+  static constexpr std::size_t STAGING_SIZE = std::size_t(64) << 10;
+  /* payload left to receive for which a direct receive is worth its setup */
+  static constexpr std::size_t DIRECT_RECV_MIN = std::size_t(4) << 10;
+  static constexpr std::size_t ZC_THRESHOLD = std::size_t(32) << 10;
+  /* the kernel limit for one fixed buffer */
+  static constexpr std::size_t FIXED_BUFFER_MAX = std::size_t(1) << 30;
+  static constexpr unsigned BUFFER_SLOTS = 256; /* slot 0 is the staging buffer */
+  static constexpr unsigned RING_ENTRIES = 64;
+  static constexpr unsigned SEND_IOV_MAX = 64;
+
+  struct completion
+  {
+    void *context;
+    ::status_t status;
+    std::uint64_t flags;
+    std::size_t len;
+    const char *error;
+  };
+
+private:
+  enum op_kind : std::uint64_t
+  {
+    OP_RECV_STAGE = 1,
+    OP_RECV_DIRECT,
+    OP_SEND,
+    OP_SEND_ZC,
+  };
+
+  struct region
+  {
+    const char *base;
+    std::size_t len;
+    std::uint64_t key;
+    int slot; /* fixed buffer slot, or -1 */
+  };
+
+  struct posted_recv
+  {
+    std::vector<::iovec> v;
+    void *context;
+  };
+
+  struct pending_rma
+  {
+    std::vector<::iovec> v; /* destination of a read */
+    void *context;
+    std::size_t len;
+    std::uint64_t flags;    /* completion flags */
+  };
+
+  struct tx_item
+  {
+    frame_header hdr;
+    std::vector<::iovec> payload;
+    std::vector<char> copy;  /* inject_send: the payload, copied */
+    const region *fixed;     /* region holding a single payload buffer, or nullptr */
+    void *context;
+    bool signal;             /* post_send: complete when sent */
+  };
+
+  using guard = std::lock_guard<std::mutex>;
+
+  std::mutex _m; /* protects everything below */
+  common::Fd_open _socket;
+  Uring _ring;
+  common::Fd_open _unblock; /* eventfd, to end a wait_for_next_completion */
+  std::size_t _inject_size;
+  bool _zc_ok;
+  bool _closed;
+  const char *_close_reason;
+  unsigned _inflight; /* completions still expected from the ring */
+
+  /* memory registration */
+  std::unordered_map<std::uint64_t, std::unique_ptr<region>> _regions;
+  std::unordered_set<const region *> _region_set; /* to validate descriptors */
+  std::uint64_t _next_key;
+  std::vector<unsigned> _free_slots;
+
+  /* receive */
+  std::unique_ptr<char[]> _staging;
+  bool _staging_fixed;
+  std::size_t _stage_begin;
+  std::size_t _stage_end;
+  bool _rx_in_flight;
+  bool _rx_blocked;          /* a message arrived, but no receive is posted */
+  bool _rx_active;           /* _rx_hdr is a frame whose payload is being received */
+  frame_header _rx_hdr;
+  std::vector<::iovec> _rx_iov; /* remaining destination */
+  std::size_t _rx_left;      /* payload bytes not yet received, including any discarded */
+  void *_rx_context;
+  ::status_t _rx_status;
+  std::vector<::iovec> _rx_direct_iov;
+  ::msghdr _rx_msg;
+  std::deque<posted_recv> _posted_recvs;
+
+  /* send */
+  std::deque<tx_item> _tx_queue;
+  std::vector<tx_item> _tx_batch;
+  std::vector<::iovec> _tx_iov;
+  ::msghdr _tx_msg;
+  unsigned _tx_outstanding; /* completions due for the batch in flight */
+
+  /* emulated one-sided operations awaiting the peer's response */
+  std::unordered_map<std::uint64_t, pending_rma> _pending_rma;
+  std::uint64_t _next_tag;
+
+  std::deque<completion> _completions;
+  std::deque<completion> _stalled;
+
+  ::io_uring_sqe *get_sqe();
+  void progress();
+  void reap(bool process);
+  void on_recv(std::uint64_t op, int res);
+  void on_send(std::uint64_t op, int res, unsigned flags);
+  void close(const char *reason);
+
+  void kick_recv();
+  void process_rx();
+  void start_frame(const frame_header &h);
+  void finish_frame();
+  void consume(const char *p, std::size_t n);
+  void submit_stage_recv();
+  void submit_direct_recv();
+
+  void kick_send();
+  void submit_sendmsg();
+  void send_done();
+  void enqueue(tx_item &&t);
+
+  const region *find_region(std::uint64_t key, std::uint64_t addr, std::uint64_t len) const;
+  const region *own_region(void *desc) const;
+
+  void complete(void *context, ::status_t status, std::uint64_t flags, std::size_t len, const char *error = nullptr)
+  {
+    _completions.push_back(completion{context, status, flags, len, error});
+  }
+
+  /* take new completions, then those stalled earlier */
+  std::deque<completion> take_completions();
+  void stall(std::deque<completion> &&deferred);
+  void wait(int timeout_ms);
+
+protected:
+  /* destroyed only as the base of a Uring_endpoint */
+  ~Uring_connection();
+
+public:
+  /*
+   * Adopts a connected socket
+   *
+   * @throw std::system_error - io_uring setup or eventfd fail
+   */
+  Uring_connection(int socket, std::size_t inject_size);
+  Uring_connection(const Uring_connection &) = delete;
+  Uring_connection &operator=(const Uring_connection &) = delete;
+
+  void post_send(const ::iovec *first, const ::iovec *last, void **desc, void *context);
+  void post_recv(const ::iovec *first, const ::iovec *last, void *context);
+  void post_read(const ::iovec *first, const ::iovec *last, std::uint64_t remote_addr, std::uint64_t key, void *context);
+  void post_write(const ::iovec *first, const ::iovec *last, void **desc, std::uint64_t remote_addr, std::uint64_t key, void *context);
+  void inject_send(const void *buf, std::size_t len);
+
+  /*
+   * Deliver completions to f, a function of (const completion &) returning
+   * cb_acceptance. Deferred completions are offered again on the next call.
+   *
+   * @throw std::logic_error - called on closed connection
+   * @throw std::system_error - io_uring_enter fail
+   */
+  template <typename F>
+    std::size_t poll_completions(F f)
+    {
+      auto ready = take_completions();
+      std::size_t ct = 0;
+      std::deque<completion> deferred;
+      for ( const auto &c : ready )
+      {
+        if ( f(c) == cb_acceptance::DEFER )
+        {
+          deferred.push_back(c);
+        }
+        else
+        {
+          ++ct;
+        }
+      }
+      if ( ! deferred.empty() )
+      {
+        stall(std::move(deferred));
+      }
+      return ct;
+    }
+
+  std::size_t stalled_completion_count();
+  void wait_for_next_completion(unsigned polls_limit);
+  void wait_for_next_completion(std::chrono::milliseconds timeout);
+  void unblock_completions();
+  bool arm_wait(std::vector<int> &fds);
+
+  /*
+   * Keys are chosen by the provider (as with FI_MR_PROV_KEY); the requested
+   * key and flags are ignored.
+   */
+  memory_region_t register_memory(const void *contig_addr, std::size_t size, std::uint64_t key, std::uint64_t flags);
+  /*
+   * @throw std::range_error - address not registered
+   */
+  void deregister_memory(memory_region_t memory_region);
+  std::uint64_t get_memory_remote_key(memory_region_t memory_region) const noexcept;
+  void *get_memory_descriptor(memory_region_t memory_region) const noexcept;
+
+  std::string get_peer_addr();
+  std::string get_local_addr();
+  std::size_t max_message_size() const noexcept { return MAX_MESSAGE_SIZE; }
+  std::size_t max_inject_size() const noexcept { return _inject_size; }
+};
+
+#endif
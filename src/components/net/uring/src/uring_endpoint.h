@@ -0,0 +1,144 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef _URING_ENDPOINT_H_
+#define _URING_ENDPOINT_H_
+
+#include <api/fabric_itf.h> /* component::IFabric_server, component::IFabric_client */
+#include "uring_connection.h"
+
+#pragma GCC diagnostic push
+#if defined __GNUC__ && 6 < __GNUC__ && __cplusplus < 201703L
+#pragma GCC diagnostic ignored "-Wnoexcept-type"
+#endif
+
+/*
+ * A uring connection presented as an IFabric_server or an IFabric_client
+ * (which differ only in name).
+ */
+template <typename Itf>
+  class Uring_endpoint
+    : public Itf
+    , public Uring_connection
+  {
+    using completer = component::IFabric_op_completer;
+    using region_t = component::IFabric_connection::memory_region_t;
+  public:
+    explicit Uring_endpoint(int socket_, std::size_t inject_size_)
+      : Itf()
+      , Uring_connection(socket_, inject_size_)
+    {}
+
+    /* BEGIN IFabric_op_completer */
+    /*
+     * @throw std::logic_error - called on closed connection
+     */
+    std::size_t poll_completions(const completer::complete_old &cb_) override
+    {
+      return Uring_connection::poll_completions([&cb_] (const completion &c) { cb_(c.context, c.status); return cb_acceptance::ACCEPT; });
+    }
+    std::size_t poll_completions(const completer::complete_definite &cb_) override
+    {
+      return Uring_connection::poll_completions([&cb_] (const completion &c) { cb_(c.context, c.status, c.flags, c.len, const_cast<char *>(c.error)); return cb_acceptance::ACCEPT; });
+    }
+    std::size_t poll_completions_tentative(const completer::complete_tentative &cb_) override
+    {
+      return Uring_connection::poll_completions([&cb_] (const completion &c) { return cb_(c.context, c.status, c.flags, c.len, const_cast<char *>(c.error)); });
+    }
+    std::size_t poll_completions(const completer::complete_param_definite &cb_, void *param_) override
+    {
+      return Uring_connection::poll_completions([&cb_, param_] (const completion &c) { cb_(c.context, c.status, c.flags, c.len, const_cast<char *>(c.error), param_); return cb_acceptance::ACCEPT; });
+    }
+    std::size_t poll_completions_tentative(const completer::complete_param_tentative &cb_, void *param_) override
+    {
+      return Uring_connection::poll_completions([&cb_, param_] (const completion &c) { return cb_(c.context, c.status, c.flags, c.len, const_cast<char *>(c.error), param_); });
+    }
+    std::size_t poll_completions(const completer::complete_param_definite_ptr_noexcept cb_, void *param_) override
+    {
+      return Uring_connection::poll_completions([cb_, param_] (const completion &c) { cb_(c.context, c.status, c.flags, c.len, const_cast<char *>(c.error), param_); return cb_acceptance::ACCEPT; });
+    }
+    std::size_t poll_completions_tentative(const completer::complete_param_tentative_ptr_noexcept cb_, void *param_) override
+    {
+      return Uring_connection::poll_completions([cb_, param_] (const completion &c) { return cb_(c.context, c.status, c.flags, c.len, const_cast<char *>(c.error), param_); });
+    }
+
+    std::size_t stalled_completion_count() override { return Uring_connection::stalled_completion_count(); }
+    void wait_for_next_completion(unsigned polls_limit_) override { return Uring_connection::wait_for_next_completion(polls_limit_); }
+    void wait_for_next_completion(std::chrono::milliseconds timeout_) override { return Uring_connection::wait_for_next_completion(timeout_); }
+    void unblock_completions() override { return Uring_connection::unblock_completions(); }
+    bool arm_wait(std::vector<int> &fds_) override { return Uring_connection::arm_wait(fds_); }
+    /* END IFabric_op_completer */
+
+    /* BEGIN IFabric_communicator */
+    void post_send(const ::iovec *first_, const ::iovec *last_, void **desc_, void *context_) override
+    {
+      return Uring_connection::post_send(first_, last_, desc_, context_);
+    }
+    void post_send(const std::vector<::iovec> &buffers_, void *context_) override
+    {
+      return Uring_connection::post_send(buffers_.data(), buffers_.data() + buffers_.size(), nullptr, context_);
+    }
+    void post_recv(const ::iovec *first_, const ::iovec *last_, void **, void *context_) override
+    {
+      return Uring_connection::post_recv(first_, last_, context_);
+    }
+    void post_recv(const std::vector<::iovec> &buffers_, void *context_) override
+    {
+      return Uring_connection::post_recv(buffers_.data(), buffers_.data() + buffers_.size(), context_);
+    }
+    void post_read(const ::iovec *first_, const ::iovec *last_, void **, std::uint64_t remote_addr_, std::uint64_t key_, void *context_) override
+    {
+      return Uring_connection::post_read(first_, last_, remote_addr_, key_, context_);
+    }
+    void post_read(const std::vector<::iovec> &buffers_, std::uint64_t remote_addr_, std::uint64_t key_, void *context_) override
+    {
+      return Uring_connection::post_read(buffers_.data(), buffers_.data() + buffers_.size(), remote_addr_, key_, context_);
+    }
+    void post_write(const ::iovec *first_, const ::iovec *last_, void **desc_, std::uint64_t remote_addr_, std::uint64_t key_, void *context_) override
+    {
+      return Uring_connection::post_write(first_, last_, desc_, remote_addr_, key_, context_);
+    }
+    void post_write(const std::vector<::iovec> &buffers_, std::uint64_t remote_addr_, std::uint64_t key_, void *context_) override
+    {
+      return Uring_connection::post_write(buffers_.data(), buffers_.data() + buffers_.size(), nullptr, remote_addr_, key_, context_);
+    }
+    void inject_send(const void *buf_, std::size_t len_) override { return Uring_connection::inject_send(buf_, len_); }
+    /* END IFabric_communicator */
+
+    /* BEGIN IFabric_connection */
+    region_t register_memory(const void *contig_addr_, std::size_t size_, std::uint64_t key_, std::uint64_t flags_) override
+    {
+      return Uring_connection::register_memory(contig_addr_, size_, key_, flags_);
+    }
+    void deregister_memory(const region_t memory_region_) override { return Uring_connection::deregister_memory(memory_region_); }
+    std::uint64_t get_memory_remote_key(const region_t memory_region_) const noexcept override
+    {
+      return Uring_connection::get_memory_remote_key(memory_region_);
+    }
+    void *get_memory_descriptor(const region_t memory_region_) const noexcept override
+    {
+      return Uring_connection::get_memory_descriptor(memory_region_);
+    }
+    std::string get_peer_addr() override { return Uring_connection::get_peer_addr(); }
+    std::string get_local_addr() override { return Uring_connection::get_local_addr(); }
+    std::size_t max_message_size() const noexcept override { return Uring_connection::max_message_size(); }
+    std::size_t max_inject_size() const noexcept override { return Uring_connection::max_inject_size(); }
+    /* END IFabric_connection */
+  };
+
+#pragma GCC diagnostic pop
+
+using Uring_server = Uring_endpoint<component::IFabric_server>;
+using Uring_client = Uring_endpoint<component::IFabric_client>;
+
+#endif
@@ -0,0 +1,129 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "uring_fabric.h"
+
+#include "uring_endpoint.h"
+#include "uring_server_factory.h"
+
+#include <netdb.h> /* getaddrinfo */
+#include <sys/socket.h>
+#include <unistd.h> /* close */
+
+#include <rapidjson/document.h>
+#include <rapidjson/error/en.h>
+
+#include <cerrno>
+#include <memory> /* unique_ptr */
+#include <stdexcept>
+#include <system_error>
+
+constexpr const char *Uring_fabric::PROVIDER_NAME;
+
+namespace
+{
+  rapidjson::Document parse(const std::string &json_configuration_)
+  {
+    rapidjson::Document jdoc;
+    jdoc.Parse(json_configuration_.c_str());
+    if ( jdoc.HasParseError() )
+    {
+      throw std::domain_error{std::string{"JSON parse error \""} + rapidjson::GetParseError_En(jdoc.GetParseError()) + "\" at " + std::to_string(jdoc.GetErrorOffset())};
+    }
+    if ( ! jdoc.IsObject() )
+    {
+      throw std::domain_error{"uring: JSON configuration is not an object"};
+    }
+    return jdoc;
+  }
+
+  struct addrinfo_deleter
+  {
+    void operator()(::addrinfo *a) const { ::freeaddrinfo(a); }
+  };
+
+  int connect_socket(const std::string &remote_endpoint_, std::uint16_t port_)
+  {
+    ::addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    ::addrinfo *res = nullptr;
+    auto rc = ::getaddrinfo(remote_endpoint_.c_str(), std::to_string(port_).c_str(), &hints, &res);
+    if ( rc != 0 )
+    {
+      throw std::system_error(std::error_code(rc == EAI_SYSTEM ? errno : EHOSTUNREACH, std::system_category()), std::string("uring: resolving ") + remote_endpoint_ + ": " + ::gai_strerror(rc));
+    }
+    std::unique_ptr<::addrinfo, addrinfo_deleter> ai(res);
+
+    int err = EHOSTUNREACH;
+    for ( auto a = ai.get(); a; a = a->ai_next )
+    {
+      auto s = ::socket(a->ai_family, a->ai_socktype | SOCK_CLOEXEC, a->ai_protocol);
+      if ( s < 0 )
+      {
+        err = errno;
+        continue;
+      }
+      if ( ::connect(s, a->ai_addr, a->ai_addrlen) == 0 )
+      {
+        return s; /* ownership passes to the connection */
+      }
+      err = errno;
+      ::close(s);
+    }
+    throw std::system_error(std::error_code(err, std::system_category()), "uring: connect to " + remote_endpoint_ + ":" + std::to_string(port_));
+  }
+}
+
+Uring_fabric::Uring_fabric(const std::string &json_configuration_)
+  : _src_addr()
+  , _inject_size(Uring_connection::DEFAULT_INJECT_SIZE)
+{
+  auto jdoc = parse(json_configuration_);
+  auto src = jdoc.FindMember("src_addr");
+  if ( src != jdoc.MemberEnd() && src->value.IsString() )
+  {
+    _src_addr = std::string(src->value.GetString());
+  }
+  auto tx = jdoc.FindMember("tx_attr");
+  if ( tx != jdoc.MemberEnd() && tx->value.IsObject() )
+  {
+    auto inject = tx->value.FindMember("inject_size");
+    if ( inject != tx->value.MemberEnd() && inject->value.IsUint() )
+    {
+      _inject_size = inject->value.GetUint();
+    }
+  }
+}
+
+auto Uring_fabric::open_server_factory(const std::string &json_configuration_, std::uint16_t port_) -> component::IFabric_server_factory *
+{
+  parse(json_configuration_);
+  return new Uring_server_factory(_src_addr, port_, _inject_size);
+}
+
+auto Uring_fabric::open_server_grouped_factory(const std::string &, std::uint16_t) -> component::IFabric_server_grouped_factory *
+{
+  throw std::logic_error("uring: grouped endpoints are not supported");
+}
+
+auto Uring_fabric::open_client(const std::string &json_configuration_, const std::string &remote_endpoint_, std::uint16_t port_) -> component::IFabric_client *
+{
+  parse(json_configuration_);
+  return new Uring_client(connect_socket(remote_endpoint_, port_), _inject_size);
+}
+
+auto Uring_fabric::open_client_grouped(const std::string &, const std::string &, std::uint16_t) -> component::IFabric_client_grouped *
+{
+  throw std::logic_error("uring: grouped endpoints are not supported");
+}
@@ -0,0 +1,66 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef _URING_FABRIC_H_
+#define _URING_FABRIC_H_
+
+#include <api/fabric_itf.h> /* component::IFabric */
+
+#include <boost/optional.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+ * TCP, through io_uring. Configuration (JSON) members understood:
+ *   "src_addr" : "10.0.0.1"  - local IPv4 address (default: any)
+ *   "tx_attr" : { "inject_size" : 128 }
+ * Other members, which may be meant for the libfabric provider, are ignored.
+ */
+class Uring_fabric
+  : public component::IFabric
+{
+  boost::optional<std::string> _src_addr;
+  std::size_t _inject_size;
+
+public:
+  static constexpr const char *PROVIDER_NAME = "uring";
+
+  /*
+   * @throw std::domain_error : json file parse-detected error
+   */
+  explicit Uring_fabric(const std::string &json_configuration);
+
+  /*
+   * @throw std::system_error - socket, bind or listen fail
+   */
+  component::IFabric_server_factory *open_server_factory(const std::string &json_configuration, std::uint16_t port) override;
+  /*
+   * @throw std::logic_error - not supported
+   */
+  component::IFabric_server_grouped_factory *open_server_grouped_factory(const std::string &json_configuration, std::uint16_t port) override;
+  /*
+   * @throw std::system_error - resolving address
+   * @throw std::system_error - connect fail
+   * @throw std::system_error - io_uring setup fail
+   */
+  component::IFabric_client *open_client(const std::string &json_configuration, const std::string &remote_endpoint, std::uint16_t port) override;
+  /*
+   * @throw std::logic_error - not supported
+   */
+  component::IFabric_client_grouped *open_client_grouped(const std::string &json_configuration, const std::string &remote_endpoint, std::uint16_t port) override;
+  const char *prov_name() const noexcept override { return PROVIDER_NAME; }
+};
+
+#endif
@@ -0,0 +1,49 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef _URING_FACTORY_H_
+#define _URING_FACTORY_H_
+
+#include <api/fabric_itf.h>
+
+#include <component/base.h> /* DECLARE_VERSION, DECLARE_COMPONENT_UUID */
+
+/*
+ * Note: Uring_factory makes fabrics which carry IFabric traffic over TCP,
+ * driven through io_uring, for hosts without RDMA hardware (or without
+ * libfabric). Select it with the provider name "uring".
+ */
+class Uring_factory
+  : public component::IFabric_factory
+{
+public:
+  DECLARE_VERSION(0.1f);
+  DECLARE_COMPONENT_UUID(0xfac7e1a4,0x5b0d,0x4c39,0x9e51,0x3a,0x6d,0x12,0x88,0xc4,0x07);
+  void *query_interface(component::uuid_t& itf_uuid) override;
+  void unload() override { delete this; }
+
+  Uring_factory();
+  /**
+   * Open a uring fabric
+   *
+   * @param json_configuration Configuration string in JSON
+   * form. e.g. {
+   *   "src_addr": "10.0.0.1",
+   *   "tx_attr": { "inject_size" : 128 } }
+   *
+   * @throw std::domain_error : json file parse-detected error
+   */
+  component::IFabric * make_fabric(const std::string& json_configuration) override;
+};
+
+#endif
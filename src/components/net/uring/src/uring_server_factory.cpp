@@ -0,0 +1,122 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "uring_server_factory.h"
+
+#include "uring_endpoint.h"
+#include "uring_fabric.h" /* Uring_fabric::PROVIDER_NAME */
+
+#include <arpa/inet.h> /* inet_pton */
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <cerrno>
+#include <stdexcept>
+#include <system_error>
+
+namespace
+{
+  common::Fd_open listen_socket(const boost::optional<std::string> &src_addr_, std::uint16_t port_)
+  {
+    auto s = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if ( s < 0 )
+    {
+      throw std::system_error(std::error_code(errno, std::system_category()), "uring: socket");
+    }
+    common::Fd_open fd(s);
+    int one = 1;
+    ::setsockopt(fd.fd(), SOL_SOCKET, SO_REUSEADDR, &one, sizeof one);
+
+    ::sockaddr_in a{};
+    a.sin_family = AF_INET;
+    a.sin_port = htons(port_);
+    a.sin_addr.s_addr = htonl(INADDR_ANY);
+    if ( src_addr_ && ::inet_pton(AF_INET, src_addr_->c_str(), &a.sin_addr) != 1 )
+    {
+      throw std::domain_error("uring: bad src_addr " + *src_addr_);
+    }
+    if ( ::bind(fd.fd(), reinterpret_cast<const ::sockaddr *>(&a), sizeof a) != 0 )
+    {
+      throw std::system_error(std::error_code(errno, std::system_category()), "uring: bind port " + std::to_string(port_));
+    }
+    if ( ::listen(fd.fd(), SOMAXCONN) != 0 )
+    {
+      throw std::system_error(std::error_code(errno, std::system_category()), "uring: listen");
+    }
+    return fd;
+  }
+}
+
+Uring_server_factory::Uring_server_factory(const boost::optional<std::string> &src_addr_, std::uint16_t port_, std::size_t inject_size_)
+  : _listen(listen_socket(src_addr_, port_))
+  , _inject_size(inject_size_)
+  , _m()
+  , _open()
+{
+}
+
+Uring_server_factory::~Uring_server_factory()
+{
+  for ( auto c : _open )
+  {
+    delete c;
+  }
+}
+
+component::IFabric_server *Uring_server_factory::get_new_connection()
+{
+  auto fd = ::accept4(_listen.fd(), nullptr, nullptr, SOCK_CLOEXEC);
+  if ( fd < 0 )
+  {
+    if ( errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR || errno == ECONNABORTED )
+    {
+      return nullptr;
+    }
+    throw std::system_error(std::error_code(errno, std::system_category()), "uring: accept");
+  }
+  auto c = new Uring_server(fd, _inject_size);
+  std::lock_guard<std::mutex> g{_m};
+  _open.insert(c);
+  return c;
+}
+
+bool Uring_server_factory::arm_wait(std::vector<int> &fds_)
+{
+  fds_.push_back(_listen.fd());
+  return true;
+}
+
+void Uring_server_factory::close_connection(component::IFabric_server *connection_)
+{
+  {
+    std::lock_guard<std::mutex> g{_m};
+    _open.erase(connection_);
+  }
+  delete connection_;
+}
+
+std::vector<component::IFabric_server *> Uring_server_factory::connections()
+{
+  std::lock_guard<std::mutex> g{_m};
+  return std::vector<component::IFabric_server *>(_open.begin(), _open.end());
+}
+
+std::size_t Uring_server_factory::max_message_size() const noexcept
+{
+  return Uring_connection::MAX_MESSAGE_SIZE;
+}
+
+std::string Uring_server_factory::get_provider_name() const
+{
+  return Uring_fabric::PROVIDER_NAME;
+}
@@ -0,0 +1,61 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef _URING_SERVER_FACTORY_H_
+#define _URING_SERVER_FACTORY_H_
+
+#include <api/fabric_itf.h> /* component::IFabric_server_factory */
+#include <common/fd_open.h>
+
+#include <boost/optional.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory> /* unique_ptr */
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+/*
+ * A listening TCP socket. get_new_connection does not block: it returns
+ * nullptr when no connection is waiting.
+ */
+class Uring_server_factory
+  : public component::IFabric_server_factory
+{
+  common::Fd_open _listen;
+  std::size_t _inject_size;
+  std::mutex _m; /* protects _open */
+  std::set<component::IFabric_server *> _open;
+
+public:
+  /*
+   * @throw std::system_error - socket, bind or listen fail
+   */
+  Uring_server_factory(const boost::optional<std::string> &src_addr, std::uint16_t port, std::size_t inject_size);
+  ~Uring_server_factory();
+
+  /*
+   * @throw std::system_error - accept fail
+   */
+  component::IFabric_server *get_new_connection() override;
+  /* the listening socket is readable while a connection is waiting */
+  bool arm_wait(std::vector<int> &fds) override;
+  void close_connection(component::IFabric_server *connection) override;
+  std::vector<component::IFabric_server *> connections() override;
+  std::size_t max_message_size() const noexcept override;
+  std::string get_provider_name() const override;
+};
+
+#endif
@@ -0,0 +1,353 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Weffc++"
+
+#include <api/components.h>
+#include <api/fabric_itf.h>
+#include <gtest/gtest.h>
+
+#include <poll.h>
+#include <sys/uio.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Loopback tests for the uring transport: one client connected to one
+ * server over 127.0.0.1.
+ */
+
+namespace
+{
+using namespace component;
+
+constexpr std::uint16_t port = 11981;
+constexpr std::size_t big = std::size_t(2) << 20;
+
+struct done
+{
+  void *context;
+  status_t status;
+  std::uint64_t flags;
+  std::size_t len;
+};
+
+/*
+ * Poll a for n completions. The peer b is polled too, so that it services
+ * emulated remote reads and writes, but its completions are deferred.
+ */
+std::vector<done> wait_n(IFabric_op_completer *a, IFabric_op_completer *b, std::size_t n = 1)
+{
+  std::vector<done> got;
+  for ( auto start = std::chrono::steady_clock::now();
+        got.size() < n && std::chrono::steady_clock::now() - start < std::chrono::seconds(10);
+      )
+  {
+    a->poll_completions(
+      [&got] (void *c_, status_t s_, std::uint64_t f_, std::size_t l_, void *) { got.push_back(done{c_, s_, f_, l_}); }
+    );
+    if ( b )
+    {
+      b->poll_completions_tentative(
+        [] (void *, status_t, std::uint64_t, std::size_t, void *) { return IFabric_op_completer::cb_acceptance::DEFER; }
+      );
+    }
+  }
+  return got;
+}
+
+class Uring_test : public ::testing::Test
+{
+protected:
+  static IFabric_factory *factory;
+  std::unique_ptr<IFabric> fabric;
+  std::unique_ptr<IFabric_server_factory> server_factory;
+  std::unique_ptr<IFabric_client> client;
+  IFabric_server *server;
+  std::vector<char> sbuf;
+  std::vector<char> cbuf;
+
+  Uring_test()
+    : fabric()
+    , server_factory()
+    , client()
+    , server(nullptr)
+    , sbuf(big)
+    , cbuf(big)
+  {}
+
+  static void SetUpTestCase()
+  {
+    IBase *comp = load_component("libcomponent-uring.so", net_uring_factory);
+    ASSERT_TRUE(comp);
+    factory = static_cast<IFabric_factory *>(comp->query_interface(IFabric_factory::iid()));
+    ASSERT_TRUE(factory);
+  }
+
+  static void TearDownTestCase()
+  {
+    factory->release_ref();
+  }
+
+  void SetUp() override
+  {
+    fabric.reset(factory->make_fabric("{ \"src_addr\" : \"127.0.0.1\", \"tx_attr\" : { \"inject_size\" : 128 } }"));
+    server_factory.reset(fabric->open_server_factory("{}", port));
+    client.reset(fabric->open_client("{}", "127.0.0.1", port));
+    for ( auto start = std::chrono::steady_clock::now();
+          ! server && std::chrono::steady_clock::now() - start < std::chrono::seconds(5);
+        )
+    {
+      server = server_factory->get_new_connection();
+    }
+    ASSERT_TRUE(server);
+  }
+
+  void TearDown() override
+  {
+    client.reset();
+    if ( server )
+    {
+      server_factory->close_connection(server);
+    }
+    server_factory.reset();
+    fabric.reset();
+  }
+};
+
+IFabric_factory *Uring_test::factory;
+
+TEST_F(Uring_test, Names)
+{
+  EXPECT_EQ("uring", server_factory->get_provider_name());
+  EXPECT_EQ("127.0.0.1", server->get_peer_addr());
+  EXPECT_EQ("127.0.0.1", client->get_local_addr());
+}
+
+TEST_F(Uring_test, SmallMessage)
+{
+  ::iovec rv{sbuf.data(), 4096};
+  server->post_recv(&rv, &rv + 1, nullptr, &rv);
+  const char msg[] = "hello";
+  std::memcpy(cbuf.data(), msg, sizeof msg);
+  ::iovec sv{cbuf.data(), sizeof msg};
+  client->post_send(&sv, &sv + 1, nullptr, &sv);
+
+  auto g = wait_n(server, client.get());
+  ASSERT_EQ(1U, g.size());
+  EXPECT_EQ(&rv, g[0].context);
+  EXPECT_EQ(S_OK, g[0].status);
+  EXPECT_EQ(sizeof msg, g[0].len);
+  EXPECT_TRUE(g[0].flags & FI_RECV);
+  EXPECT_STREQ("hello", sbuf.data());
+
+  auto h = wait_n(client.get(), nullptr);
+  ASSERT_EQ(1U, h.size());
+  EXPECT_EQ(&sv, h[0].context);
+  EXPECT_TRUE(h[0].flags & FI_SEND);
+}
+
+TEST_F(Uring_test, LargeRegisteredMessage)
+{
+  auto smr = server->register_memory(sbuf.data(), big, 0, 0);
+  auto cmr = client->register_memory(cbuf.data(), big, 0, 0);
+  for ( std::size_t i = 0; i != big; ++i )
+  {
+    sbuf[i] = char(i * 7);
+  }
+  ::iovec rv{cbuf.data(), big};
+  client->post_recv(&rv, &rv + 1, nullptr, &rv);
+  ::iovec sv{sbuf.data(), big};
+  void *desc = server->get_memory_descriptor(smr);
+  server->post_send(&sv, &sv + 1, &desc, &sv);
+
+  auto g = wait_n(client.get(), server);
+  auto h = wait_n(server, nullptr);
+  ASSERT_EQ(1U, g.size());
+  EXPECT_EQ(S_OK, g[0].status);
+  EXPECT_EQ(big, g[0].len);
+  ASSERT_EQ(1U, h.size());
+  EXPECT_EQ(&sv, h[0].context);
+  EXPECT_EQ(0, std::memcmp(cbuf.data(), sbuf.data(), big));
+
+  client->deregister_memory(cmr);
+  server->deregister_memory(smr);
+}
+
+TEST_F(Uring_test, ManySmallInOrder)
+{
+  const unsigned n = 200;
+  std::vector<::iovec> rvs(n);
+  for ( unsigned i = 0; i != n; ++i )
+  {
+    rvs[i] = ::iovec{sbuf.data() + i * 64, 64};
+    server->post_recv(&rvs[i], &rvs[i] + 1, nullptr, &rvs[i]);
+  }
+  /* alternate injected and posted sends; only the posted sends complete */
+  for ( unsigned i = 0; i != n; ++i )
+  {
+    if ( i % 2 )
+    {
+      client->inject_send(&i, sizeof i);
+    }
+    else
+    {
+      std::memcpy(cbuf.data() + i * 8, &i, sizeof i);
+      ::iovec sv{cbuf.data() + i * 8, sizeof i};
+      client->post_send(&sv, &sv + 1, nullptr, nullptr);
+    }
+  }
+
+  auto g = wait_n(server, client.get(), n);
+  ASSERT_EQ(n, g.size());
+  for ( unsigned i = 0; i != n; ++i )
+  {
+    unsigned v;
+    std::memcpy(&v, static_cast<::iovec *>(g[i].context)->iov_base, sizeof v);
+    EXPECT_EQ(&rvs[i], g[i].context);
+    EXPECT_EQ(i, v);
+  }
+  EXPECT_EQ(n / 2, wait_n(client.get(), nullptr, n / 2).size());
+}
+
+TEST_F(Uring_test, RemoteReadWrite)
+{
+  auto mr = server->register_memory(sbuf.data(), big, 0, 0);
+  for ( std::size_t i = 0; i != big; ++i )
+  {
+    sbuf[i] = char(i * 13);
+  }
+  auto key = server->get_memory_remote_key(mr);
+  auto addr = std::uint64_t(reinterpret_cast<std::uintptr_t>(sbuf.data()));
+  int ctx;
+
+  std::vector<::iovec> rv{{cbuf.data(), big / 2}, {cbuf.data() + big / 2, big / 2}};
+  client->post_read(rv, addr, key, &ctx);
+  auto g = wait_n(client.get(), server);
+  ASSERT_EQ(1U, g.size());
+  EXPECT_EQ(&ctx, g[0].context);
+  EXPECT_EQ(S_OK, g[0].status);
+  EXPECT_TRUE(g[0].flags & FI_READ);
+  EXPECT_EQ(0, std::memcmp(cbuf.data(), sbuf.data(), big));
+
+  std::memset(cbuf.data(), 'w', 100);
+  std::vector<::iovec> wv{{cbuf.data(), 100}};
+  client->post_write(wv, addr + 1000, key, &ctx);
+  g = wait_n(client.get(), server);
+  ASSERT_EQ(1U, g.size());
+  EXPECT_EQ(S_OK, g[0].status);
+  EXPECT_TRUE(g[0].flags & FI_WRITE);
+  EXPECT_EQ('w', sbuf[1000]);
+  EXPECT_EQ('w', sbuf[1099]);
+  EXPECT_EQ(char(1100 * 13), sbuf[1100]);
+
+  /* beyond the region, and an unknown key */
+  client->post_read(rv, addr + 1, key, &ctx);
+  g = wait_n(client.get(), server);
+  ASSERT_EQ(1U, g.size());
+  EXPECT_NE(S_OK, g[0].status);
+  client->post_write(wv, addr, key + 77, &ctx);
+  g = wait_n(client.get(), server);
+  ASSERT_EQ(1U, g.size());
+  EXPECT_NE(S_OK, g[0].status);
+
+  server->deregister_memory(mr);
+}
+
+TEST_F(Uring_test, Truncation)
+{
+  ::iovec rv{sbuf.data(), 8};
+  server->post_recv(&rv, &rv + 1, nullptr, &rv);
+  ::iovec sv{cbuf.data(), 100};
+  client->post_send(&sv, &sv + 1, nullptr, nullptr);
+  auto g = wait_n(server, client.get());
+  ASSERT_EQ(1U, g.size());
+  EXPECT_EQ(E_INSUFFICIENT_BUFFER, g[0].status);
+
+  /* the stream is still in step */
+  ::iovec rv2{sbuf.data(), 64};
+  server->post_recv(&rv2, &rv2 + 1, nullptr, &rv2);
+  unsigned v = 42;
+  client->inject_send(&v, sizeof v);
+  g = wait_n(server, client.get());
+  ASSERT_EQ(1U, g.size());
+  EXPECT_EQ(S_OK, g[0].status);
+  EXPECT_EQ(0, std::memcmp(sbuf.data(), &v, sizeof v));
+}
+
+TEST_F(Uring_test, ArmWait)
+{
+  ::iovec rv{sbuf.data(), 64};
+  server->post_recv(&rv, &rv + 1, nullptr, &rv);
+  std::vector<int> fds;
+  ASSERT_TRUE(server->arm_wait(fds));
+  ASSERT_EQ(1U, fds.size());
+  std::thread t(
+    [this] ()
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      unsigned v = 7;
+      client->inject_send(&v, sizeof v);
+    }
+  );
+  ::pollfd p{fds[0], POLLIN, 0};
+  EXPECT_EQ(1, ::poll(&p, 1, 2000));
+  t.join();
+  EXPECT_EQ(1U, wait_n(server, client.get()).size());
+
+  server->post_recv(&rv, &rv + 1, nullptr, &rv);
+  auto start = std::chrono::steady_clock::now();
+  server->wait_for_next_completion(std::chrono::milliseconds(100));
+  EXPECT_LT(std::chrono::milliseconds(90), std::chrono::steady_clock::now() - start);
+}
+
+TEST_F(Uring_test, Disconnect)
+{
+  client.reset();
+  bool closed = false;
+  for ( auto start = std::chrono::steady_clock::now();
+        ! closed && std::chrono::steady_clock::now() - start < std::chrono::seconds(5);
+      )
+  {
+    try
+    {
+      server->poll_completions([] (void *, status_t, std::uint64_t, std::size_t, void *) {});
+    }
+    catch ( const std::logic_error & )
+    {
+      closed = true;
+    }
+  }
+  EXPECT_TRUE(closed);
+}
+
+TEST_F(Uring_test, GroupedUnsupported)
+{
+  EXPECT_THROW(fabric->open_client_grouped("{}", "127.0.0.1", port), std::logic_error);
+}
+}  // namespace
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#pragma GCC diagnostic pop
@@ -94,6 +94,16 @@ template <typename T, typename Persister = persister>
 			Persister::persist(ptr, len);
 		}
 
+		void flush(const void *ptr, size_type len, const char * = nullptr)
+		{
+			Persister::flush(ptr, len);
+		}
+
+		void memcpy_flush(void *dst, const void *src, size_type len)
+		{
+			Persister::memcpy_flush(dst, src, len);
+		}
+
 		auto &heap() const
 		{
 			return *_heap;
@@ -20,8 +20,10 @@
 #include "hop_hash_log.h"
 #include "segment_layout.h"
 #include "trace_flags.h"
+#include <sys/uio.h> /* iovec */
 #include <array>
 #include <cstddef> /* size_t */
+#include <vector>
 
 namespace impl
 {
@@ -85,26 +87,6 @@ namespace impl
 				}
 			}
 
-			void deconstitute()
-			{
-#if USE_CC_HEAP == 3
-				for ( auto it = _buckets; it != _buckets_end; ++it )
-				{
-					typename bucket_type::owner_type &w = *it;
-					/* deconsititute key and value */
-					if ( w.is_adjacent_content_in_use() )
-					{
-						typename bucket_type::content_type &c = *it;
-						c.value().first.deconstitute();
-						/* ERROR: depends on the types of first and second,
-						 * so should be handled by the session level, not here
-						 */
-						std::get<0>(c.value().second).deconstitute();
-					}
-				}
-#endif
-			}
-
 		public:
 			using bucket_type = Bucket;
 			using bucket_aligned_t = bucket_aligned<Bucket>;
@@ -143,7 +125,6 @@ namespace impl
 					report();
 				}
 #endif
-				deconstitute();
 			}
 
 			bucket_control_unlocked operator=(const bucket_control_unlocked &) = delete;
@@ -174,6 +155,58 @@ namespace impl
 						}
 					}
 				}
+
+#if USE_CC_HEAP == 3
+			/* Reconstitution of buckets [first_, last_) by one of several threads.
+			 * Allocations of keys and values are listed in found_ for the caller
+			 * to inject; see persist_fixed_string::reconstitute_scan.
+			 */
+			template <typename Allocator>
+				void reconstitute_scan(
+					Allocator av_
+					, bix_t first_
+					, bix_t last_
+					, std::vector<::iovec> &found_
+				)
+				{
+					for ( auto it = _buckets + first_; it != _buckets + last_; ++it )
+					{
+						typename bucket_type::owner_type &w = *it;
+						typename bucket_type::content_type &c = *it;
+						if ( w.is_adjacent_content_in_use() )
+						{
+							/* ERROR: depends on the types of first and second,
+							 * so should be handled by the session level, not here
+							 */
+							const_cast<
+								typename std::remove_const<typename bucket_type::content_type::key_t>::type &
+							>(c.value().first).reconstitute_scan(av_, found_);
+							std::get<0>(c.value().second).reconstitute_scan(av_, found_);
+						}
+					}
+				}
+#endif
+
+			/* At a clean close, list the allocations of keys and values in
+			 * buckets [first_, last_) for the heap snapshot.
+			 */
+			void deconstitute(
+				bix_t first_
+				, bix_t last_
+				, std::vector<::iovec> &found_
+			) const
+			{
+				for ( auto it = _buckets + first_; it != _buckets + last_; ++it )
+				{
+					const typename bucket_type::owner_type &w = *it;
+					if ( w.is_adjacent_content_in_use() )
+					{
+						typename bucket_type::content_type &c = *it;
+						c.value().first.deconstitute(found_);
+						std::get<0>(c.value().second).deconstitute(found_);
+					}
+				}
+			}
 		};
 }
 
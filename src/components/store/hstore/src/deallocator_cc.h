@@ -98,6 +98,16 @@ template <typename T, typename Persister = persister>
 			persister_type::persist(ptr, len);
 		}
 
+		void flush(const void *ptr, size_type len, const char * = nullptr) const
+		{
+			persister_type::flush(ptr, len);
+		}
+
+		void memcpy_flush(void *dst, const void *src, size_type len) const
+		{
+			persister_type::memcpy_flush(dst, src, len);
+		}
+
 		auto pool() const
 		{
 			return _pool;
@@ -78,6 +78,16 @@ template <typename T, typename Persister = persister>
 			Persister::persist(ptr, len);
 		}
 
+		void flush(const void *ptr, size_type len, const char * = nullptr) const
+		{
+			Persister::flush(ptr, len);
+		}
+
+		void memcpy_flush(void *dst, const void *src, size_type len) const
+		{
+			Persister::memcpy_flush(dst, src, len);
+		}
+
 		auto pool() const
 		{
 			return _pool;
@@ -0,0 +1,91 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+
+#ifndef MCAS_HSTORE_FINGERPRINT_H
+#define MCAS_HSTORE_FINGERPRINT_H
+
+#if defined __AVX2__ || defined __SSE2__
+#include <immintrin.h>
+#endif
+
+#include <cstddef> /* size_t */
+#include <cstdint> /* uint8_t, uint64_t */
+
+/*
+ * Hash fingerprints.
+ *
+ * Each bucket has a one-byte fingerprint of the hash of its key, kept in
+ * DRAM beside the bucket mutexes. A lookup compares the fingerprints of a
+ * whole neighbourhood at once and reads (persistent) keys only where the
+ * fingerprint matches.
+ *
+ * Fingerprint 0 means "unknown", as after a restart. It matches every hash,
+ * and is replaced by the real fingerprint when the key is next examined.
+ */
+
+namespace impl
+{
+	using fingerprint_t = std::uint8_t;
+
+	/* Readable bytes beyond the end of a fingerprint array, so that a
+	 * neighbourhood which ends at the end of the array can be read
+	 * as a whole.
+	 */
+	static constexpr std::size_t fingerprint_pad = 64U;
+
+	/* The fingerprint of a hash: the high byte, which does not select the
+	 * bucket, but never 0.
+	 */
+	inline fingerprint_t fingerprint(std::uint64_t h_)
+	{
+		const auto f = fingerprint_t(h_ >> 56U);
+		return f == 0U ? fingerprint_t(1U) : f;
+	}
+
+	/* Bit i of the result is set iff p_[i] is f_ or is 0 (unknown), for i in [0, 64) */
+	inline std::uint64_t fingerprint_match(const fingerprint_t *p_, fingerprint_t f_)
+	{
+		std::uint64_t m = 0U;
+#if defined __AVX2__
+		const auto f = _mm256_set1_epi8(char(f_));
+		const auto z = _mm256_setzero_si256();
+		for ( unsigned i = 0U; i != 64U; i += 32U )
+		{
+			const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p_ + i));
+			const auto e = _mm256_or_si256(_mm256_cmpeq_epi8(v, f), _mm256_cmpeq_epi8(v, z));
+			m |= std::uint64_t(std::uint32_t(_mm256_movemask_epi8(e))) << i;
+		}
+#elif defined __SSE2__
+		const auto f = _mm_set1_epi8(char(f_));
+		const auto z = _mm_setzero_si128();
+		for ( unsigned i = 0U; i != 64U; i += 16U )
+		{
+			const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p_ + i));
+			const auto e = _mm_or_si128(_mm_cmpeq_epi8(v, f), _mm_cmpeq_epi8(v, z));
+			m |= std::uint64_t(std::uint16_t(_mm_movemask_epi8(e))) << i;
+		}
+#else
+		for ( unsigned i = 0U; i != 64U; ++i )
+		{
+			if ( p_[i] == f_ || p_[i] == 0U )
+			{
+				m |= std::uint64_t(1U) << i;
+			}
+		}
+#endif
+		return m;
+	}
+}
+
+#endif
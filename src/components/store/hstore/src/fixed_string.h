@@ -99,6 +99,38 @@ template <typename T>
 				);
 			}
 
+		/* contiguous source: copy by the allocator's persistent memcpy,
+		 * which may bypass the cache for large strings, and flush the rest.
+		 */
+		template <typename Allocator>
+			fixed_string(
+				const T *first_, const T *last_
+				, std::size_t pad_
+				, std::size_t alignment_
+				, const Allocator &al_
+			)
+				: fixed_string(
+					std::size_t(last_-first_) + pad_
+					, alignment_
+				)
+			{
+				const auto c0 =
+					std::fill_n(
+						static_cast<char *>(static_cast<void *>(this+1))
+						, front_pad()
+						, 0
+				);
+				const auto e0 = static_cast<T *>(static_cast<void *>(c0));
+				const auto n = std::size_t(last_-first_);
+				al_.memcpy_flush(e0, first_, n * sizeof(T));
+				std::fill_n(e0 + n, pad_, T());
+				al_.flush(this, data_offset());
+				if ( pad_ != 0 )
+				{
+					al_.flush(e0 + n, pad_ * sizeof(T));
+				}
+			}
+
 		fixed_string(std::size_t data_len_, std::size_t alignment_)
 			: _ref_count(1U)
 			, _alignment(unsigned(alignment_))
@@ -120,6 +152,14 @@ template <typename T>
 			{
 				al_.persist(this, sizeof *this + alloc_element_count() * sizeof(T));
 			}
+		/* Write back only. The string is durable after the caller's next
+		 * persist, which must precede any persistent reference to the string.
+		 */
+		template <typename Allocator>
+			void flush_this(const Allocator &al_)
+			{
+				al_.flush(this, sizeof *this + alloc_element_count() * sizeof(T));
+			}
 		uint64_t size() const { return _size; }
 		uint64_t alignment() const noexcept { return _alignment; }
 		unsigned inc_ref(int, const char *) noexcept { return _ref_count++; }
@@ -130,48 +170,47 @@ template <typename T>
 		}
 		unsigned ref_count() noexcept { return _ref_count; }
 
+		/* The lock word is updated atomically, as read locks may be taken
+		 * by threads which share the pool's writer lock.
+		 */
 		bool try_lock_shared()
 		{
-			const bool ok = 0 <= _lock;
-			if ( ok )
+			auto v = __atomic_load_n(&_lock, __ATOMIC_RELAXED);
+			while ( 0 <= v )
 			{
-				++_lock;
+				if ( __atomic_compare_exchange_n(&_lock, &v, v + 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED) )
+				{
+					return true;
+				}
 			}
-			return ok;
+			return false;
 		}
 
 		bool try_lock_exclusive()
 		{
-			bool ok = 0 == _lock;
-			if ( ok )
-			{
-				_lock = -1;
-			}
-			return ok;
+			signed v = 0;
+			return __atomic_compare_exchange_n(&_lock, &v, -1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
 		}
 
 		void unlock()
 		{
-			switch ( _lock )
+			auto v = __atomic_load_n(&_lock, __ATOMIC_RELAXED);
+			while (
+				v != 0
+				&& ! __atomic_compare_exchange_n(&_lock, &v, v == -1 ? 0 : v - 1, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED)
+			)
 			{
-			case 0:
-				break;
-			case -1:
-				_lock = 0;
-				break;
-			default:
-				--_lock;
 			}
 		}
 
 		bool is_locked() const
 		{
-			return _lock != 0;
+			return __atomic_load_n(&_lock, __ATOMIC_ACQUIRE) != 0;
 		}
 
 		bool is_locked_exclusive() const
 		{
-			return _lock == -1;
+			return __atomic_load_n(&_lock, __ATOMIC_ACQUIRE) == -1;
 		}
 
 		void reset_lock()
@@ -15,10 +15,12 @@
 #include "dax_manager.h"
 #include "hstore_config.h"
 #include <common/utils.h>
+#include <algorithm> /* inplace_merge, max, min, upper_bound */
 #include <cinttypes>
 
 constexpr unsigned heap_rc_shared_ephemeral::log_min_alignment;
 constexpr unsigned heap_rc_shared_ephemeral::hist_report_upper_bound;
+constexpr std::size_t heap_rc_shared::snapshot_block_extents;
 
 heap_rc_shared_ephemeral::heap_rc_shared_ephemeral(
 	unsigned debug_level_
@@ -30,6 +32,8 @@ heap_rc_shared_ephemeral::heap_rc_shared_ephemeral(
 	, _allocated(0)
 	, _capacity(0)
 	, _reconstituted()
+	, _reconstituted_bulk()
+	, _snapshot_restored(false)
 	, _hist_alloc()
 	, _hist_inject()
 	, _hist_free()
@@ -54,6 +58,30 @@ void heap_rc_shared_ephemeral::inject_allocation(void *p_, std::size_t sz_, unsi
 	_hist_alloc.enter(sz_);
 }
 
+void heap_rc_shared_ephemeral::inject_allocations(std::vector<::iovec> &&extents_, unsigned numa_node_)
+{
+	for ( const auto &e : extents_ )
+	{
+		_heap.inject_allocation(e.iov_base, e.iov_len, int(numa_node_));
+		_allocated += e.iov_len;
+		_hist_inject.enter(e.iov_len);
+	}
+
+	if ( _reconstituted_bulk.empty() )
+	{
+		_reconstituted_bulk = std::move(extents_);
+	}
+	else
+	{
+		const auto mid = _reconstituted_bulk.size();
+		_reconstituted_bulk.insert(_reconstituted_bulk.end(), extents_.begin(), extents_.end());
+		std::inplace_merge(
+			_reconstituted_bulk.begin(), _reconstituted_bulk.begin() + std::ptrdiff_t(mid), _reconstituted_bulk.end()
+			, [] (const ::iovec &a, const ::iovec &b) { return a.iov_base < b.iov_base; }
+		);
+	}
+}
+
 void *heap_rc_shared_ephemeral::allocate(std::size_t sz_, unsigned _numa_node_, std::size_t alignment_)
 {
 	auto p = _heap.alloc(sz_, int(_numa_node_), alignment_);
@@ -71,6 +99,20 @@ void heap_rc_shared_ephemeral::free(void *p_, std::size_t sz_, unsigned numa_nod
 
 bool heap_rc_shared_ephemeral::is_reconstituted(const void * p_) const
 {
+	/* the last bulk extent which starts at or before p_ */
+	auto it =
+		std::upper_bound(
+			_reconstituted_bulk.begin(), _reconstituted_bulk.end(), p_
+			, [] (const void *p, const ::iovec &e) { return p < e.iov_base; }
+		);
+	if ( it != _reconstituted_bulk.begin() )
+	{
+		--it;
+		if ( p_ < static_cast<const char *>(it->iov_base) + it->iov_len )
+		{
+			return true;
+		}
+	}
 	return contains(_reconstituted, static_cast<alloc_set_t::element_type>(p_));
 }
 
@@ -115,6 +157,7 @@ heap_rc_shared::heap_rc_shared(unsigned debug_level_, ::iovec pool0_full_, ::iov
 	, _numa_node(numa_node_)
 	, _more_region_uuids_size(0)
 	, _more_region_uuids()
+	, _snapshot(nullptr)
 	, _eph(std::make_unique<heap_rc_shared_ephemeral>(debug_level_, backing_file_))
 {
 	void *last = static_cast<char *>(pool0_heap_.iov_base) + pool0_heap_.iov_len;
@@ -148,6 +191,7 @@ heap_rc_shared::heap_rc_shared(unsigned debug_level_, const std::unique_ptr<dax_
 	, _numa_node(this->_numa_node)
 	, _more_region_uuids_size(this->_more_region_uuids_size)
 	, _more_region_uuids(this->_more_region_uuids)
+	, _snapshot(this->_snapshot)
 	, _eph(std::make_unique<heap_rc_shared_ephemeral>(debug_level_, backing_file_))
 {
 	_eph->add_managed_region(_pool0_full, _pool0_heap, _numa_node);
@@ -168,9 +212,87 @@ heap_rc_shared::heap_rc_shared(unsigned debug_level_, const std::unique_ptr<dax_
 		VALGRIND_MAKE_MEM_DEFINED(r.iov_base, r.iov_len);
 		VALGRIND_CREATE_MEMPOOL(r.iov_base, 0, true);
 	}
+
+	snapshot_restore();
 }
 #pragma GCC diagnostic pop
 
+void heap_rc_shared::snapshot_restore()
+{
+	if ( _snapshot )
+	{
+		std::vector<::iovec> extents;
+		std::vector<heap_rc_snapshot *> blocks;
+		for ( auto b = _snapshot; b; b = b->next )
+		{
+			blocks.push_back(b);
+			extents.insert(extents.end(), b->extents(), b->extents() + b->count);
+		}
+		hop_hash_log<trace_heap_summary>::write(
+			LOG_LOCATION
+			, " pool ", _pool0_full.iov_base
+			, " snapshot blocks ", blocks.size(), " allocations ", extents.size()
+		);
+		inject_allocations(std::move(extents));
+		for ( const auto b : blocks )
+		{
+			inject_allocation(b, heap_rc_snapshot::size(b->count));
+		}
+
+		/* The snapshot is consumed: any later open must find it absent,
+		 * unless a later clean close writes a new one.
+		 */
+		_snapshot = nullptr;
+		persister_nupm::persist(&_snapshot, sizeof _snapshot);
+		for ( const auto b : blocks )
+		{
+			free(b, heap_rc_snapshot::size(b->count), alignof(heap_rc_snapshot));
+		}
+		_eph->set_snapshot_restored();
+	}
+}
+
+void heap_rc_shared::snapshot_write(const std::vector<::iovec> &extents_)
+{
+	heap_rc_snapshot *head = nullptr;
+	try
+	{
+		/* Blocks are written last to first, so that the chain is in address order */
+		const auto block_count = std::max(std::size_t(1), (extents_.size() + snapshot_block_extents - 1U) / snapshot_block_extents);
+		for ( auto i = block_count; i != 0; --i )
+		{
+			const auto first = (i - 1U) * snapshot_block_extents;
+			const auto count = std::min(extents_.size(), first + snapshot_block_extents) - first;
+			auto b = static_cast<heap_rc_snapshot *>(alloc(heap_rc_snapshot::size(count), alignof(heap_rc_snapshot)));
+			b->next = head;
+			b->count = count;
+			persister_nupm::memcpy_flush(b->extents(), extents_.data() + first, count * sizeof(::iovec));
+			persister_nupm::flush(b, sizeof *b);
+			head = b;
+		}
+	}
+	catch ( const std::bad_alloc & )
+	{
+		/* No snapshot. The next open will scan the table. */
+		while ( head )
+		{
+			auto next = head->next;
+			free(head, heap_rc_snapshot::size(head->count), alignof(heap_rc_snapshot));
+			head = next;
+		}
+		hop_hash_log<trace_heap_summary>::write(LOG_LOCATION, " pool ", _pool0_full.iov_base, " snapshot failed: out of space");
+		return;
+	}
+
+	_snapshot = head;
+	persister_nupm::persist(&_snapshot, sizeof _snapshot);
+	hop_hash_log<trace_heap_summary>::write(
+		LOG_LOCATION
+		, " pool ", _pool0_full.iov_base
+		, " snapshot allocations ", extents_.size()
+	);
+}
+
 heap_rc_shared::~heap_rc_shared()
 {
 	quiesce();
@@ -357,6 +479,20 @@ void heap_rc_shared::inject_allocation(const void * p, std::size_t sz_)
 	hop_hash_log<trace_heap>::write(LOG_LOCATION, "pool ", _pool0_heap.iov_base, " addr ", p, " size ", sz);
 }
 
+void heap_rc_shared::inject_allocations(std::vector<::iovec> extents_)
+{
+	for ( auto &e : extents_ )
+	{
+		/* round as inject_allocation does */
+		const auto alignment = sizeof(void *);
+		const auto sz = std::max(e.iov_len, alignment);
+		e.iov_len = (sz + alignment - 1U)/alignment * alignment;
+		VALGRIND_MEMPOOL_ALLOC(_pool0_heap.iov_base, e.iov_base, e.iov_len);
+	}
+	hop_hash_log<trace_heap>::write(LOG_LOCATION, "pool ", _pool0_heap.iov_base, " count ", extents_.size());
+	_eph->inject_allocations(std::move(extents_), _numa_node);
+}
+
 void heap_rc_shared::free(void *p_, std::size_t sz_, std::size_t alignment_)
 {
 	alignment_ = std::max(alignment_, sizeof(void *));
@@ -65,6 +65,13 @@ private:
 	 */
 	using alloc_set_t = boost::icl::interval_set<const char *>; /* std::byte_t in C++17 */
 	alloc_set_t _reconstituted; /* std::byte_t in C++17 */
+	/* Reconstituted allocations injected in bulk (from a snapshot, or by a
+	 * parallel table scan), in address order. Kept apart from _reconstituted,
+	 * as an interval_set insert per allocation is slow for large pools.
+	 */
+	std::vector<::iovec> _reconstituted_bulk;
+	/* true iff the allocations of the table were restored from a snapshot */
+	bool _snapshot_restored;
 	using hist_type = util::histogram_log2<std::size_t>;
 	hist_type _hist_alloc;
 	hist_type _hist_inject;
@@ -107,9 +114,22 @@ public:
 	std::size_t allocated() const {  return _allocated; }
 	std::size_t capacity() const { return _capacity; };
 	void inject_allocation(void *p, std::size_t sz, unsigned numa_node);
+	/* extents_ must be in address order, and must not overlap */
+	void inject_allocations(std::vector<::iovec> &&extents, unsigned numa_node);
 	void *allocate(std::size_t sz, unsigned numa_node, std::size_t alignment);
 	void free(void *p, std::size_t sz, unsigned numa_node);
 	bool is_reconstituted(const void *p) const;
+	bool snapshot_restored() const { return _snapshot_restored; }
+	void set_snapshot_restored() { _snapshot_restored = true; }
+};
+
+/* A block of the allocation snapshot. count extents follow the header. */
+struct heap_rc_snapshot
+{
+	heap_rc_snapshot *next;
+	std::size_t count;
+	::iovec *extents() { return static_cast<::iovec *>(static_cast<void *>(this + 1)); }
+	static std::size_t size(std::size_t count_) { return sizeof(heap_rc_snapshot) + count_ * sizeof(::iovec); }
 };
 
 struct heap_rc_shared
@@ -121,7 +141,15 @@ private:
 	unsigned _numa_node;
 	std::size_t _more_region_uuids_size;
 	std::array<std::uint64_t, 1024U> _more_region_uuids;
+	/* The allocations of the table, as of the last clean close. Consumed
+	 * (and cleared) by the next open, which then need not scan the table.
+	 * nullptr after a crash, or if the snapshot could not be written.
+	 */
+	heap_rc_snapshot *_snapshot;
 	std::unique_ptr<heap_rc_shared_ephemeral> _eph;
+	/* extents per snapshot block: 16 MiB, well within Rca_LB limits */
+	static constexpr std::size_t snapshot_block_extents = std::size_t(1) << 20U;
+	void snapshot_restore();
 public:
 	explicit heap_rc_shared(unsigned debug_level, ::iovec pool0_full, ::iovec pool0_heap, unsigned numa_node, const std::string &backing_file);
 	explicit heap_rc_shared(unsigned debug_level, const std::unique_ptr<dax_manager> &dax_manager, const std::string &backing_file);
@@ -152,6 +180,17 @@ public:
 
 	void inject_allocation(const void * p, std::size_t sz);
 
+	/* Bulk inject_allocation. extents must be in address order, and must not overlap */
+	void inject_allocations(std::vector<::iovec> extents);
+
+	/* Record the allocations of the table (in address order) at a clean close */
+	void snapshot_write(const std::vector<::iovec> &extents);
+
+	/* true iff the table's allocations were restored from a snapshot, and the
+	 * table need not be scanned to reconstitute them.
+	 */
+	bool snapshot_restored() const { return _eph->snapshot_restored(); }
+
 	void free(void *p, std::size_t sz, std::size_t alignment);
 
 	unsigned percent_used() const {
@@ -188,7 +227,9 @@ public:
 
 	heap_rc & operator=(const heap_rc &) = default;
 
-    static constexpr std::uint64_t magic_value = 0xc74892d72eed493a;
+    /* changed when heap_rc_shared gained the snapshot anchor: older pools
+     * are not opened */
+    static constexpr std::uint64_t magic_value = 0xc74892d72eed493b;
 
 	heap_rc_shared *operator->() const
 	{
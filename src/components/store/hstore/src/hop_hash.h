@@ -19,6 +19,7 @@
 
 #include "bucket_control_unlocked.h"
 #include "construction_mode.h"
+#include "fingerprint.h"
 #include "hash_bucket.h"
 #include "hop_hash_log.h"
 #include "trace_flags.h"
@@ -37,6 +38,7 @@
 #include <stdexcept>
 #include <string>
 #include <utility> /* hash, pair */
+#include <vector>
 
 /* Inteded to implement Hopscotch hashing
  * http://mcg.cs.tau.ac.il/papers/disc2008-hopscotch.pdf
@@ -208,6 +210,7 @@ namespace impl
 			: public bucket_control_unlocked<Bucket>
 		{
 			std::unique_ptr<bucket_mutexes<Mutex>[]> _bucket_mutexes;
+			std::unique_ptr<fingerprint_t[]> _fingerprints;
 		public:
 			using base = bucket_control_unlocked<Bucket>;
 			using typename base::bucket_aligned_t;
@@ -218,8 +221,16 @@ namespace impl
 			)
 				: bucket_control_unlocked<Bucket>(index_, buckets_)
 				, _bucket_mutexes(nullptr)
+				, _fingerprints(nullptr)
 			{
 			}
+			/* (re)create the DRAM companions of the segment buckets */
+			void dram_reset(std::size_t segment_size_)
+			{
+				_bucket_mutexes.reset(new bucket_mutexes<Mutex>[segment_size_]);
+				/* all fingerprints "unknown" */
+				_fingerprints.reset(new fingerprint_t[segment_size_ + fingerprint_pad]());
+			}
 			explicit bucket_control()
 				: bucket_control(0U, nullptr)
 			{
@@ -348,12 +359,47 @@ namespace impl
 			hasher _hasher;
 
 			bool _auto_resize;
+			/* filter lookup candidates by fingerprint (may be disabled to measure the filter) */
+			bool _fingerprint_filter;
+
+			/* Incremental resize (DRAM state).
+			 *
+			 * Prepare: the junior segment is allocated when the table is three
+			 * quarters full, and is constructed a few buckets per operation.
+			 *
+			 * Migrate: when the table first fills, the junior segment joins the
+			 * table and the mask doubles. A senior owner at or beyond the cursor
+			 * may still own keys which belong to the junior owner
+			 * _migrate_senior_count buckets to its right. Those keys are moved a
+			 * few owners per operation, and lookups which miss in a junior owner
+			 * also try its senior owner.
+			 */
+			bool _resize_preparing;
+			bix_t _resize_constructed;
+			bix_t _migrate_senior_count; /* 0 if not migrating */
+			bix_t _migrate_cursor;
+			static constexpr bix_t resize_construct_step = 1024U;
+			static constexpr bix_t resize_migrate_step = 64U;
 
 			bucket_control_t _bc[_segment_capacity];
 
+			/* A range of buckets [first, last) in segment ix, as a unit of
+			 * work for the scans at open and close.
+			 */
+			struct scan_range
+			{
+				six_t ix;
+				bix_t first;
+				bix_t last;
+			};
+			static constexpr bix_t scan_step = 1U << 16U;
+			auto scan_ranges(six_t segment_count) const -> std::vector<scan_range>;
+			void reconstitute_segments(const Allocator &av);
+
 			six_t segment_count() const override
 			{
-				return persist_controller_t::segment_count_actual().value();
+				/* While migrating, the (unstable) count includes the junior segment */
+				return persist_controller_t::segment_count_actual().value_not_stable();
 			}
 
 			six_t segment_count_not_stable() const
@@ -375,22 +421,49 @@ namespace impl
 				auto content_index_of_key(
 					Lock &bi
 					, const K &k
+					, fingerprint_t f
 				) const -> owner::index_type;
 
 			template <typename Lock, typename K>
 				auto locate_key(
 					Lock &bi
 					, const K &k
+					, fingerprint_t f
 				) const -> std::tuple<bucket_t *, segment_and_bucket_t>;
 
+			auto locate_fingerprint(const segment_and_bucket_t &a) const -> fingerprint_t &;
+			/* the ownership bits of owner a_ whose content may match fingerprint f */
+			auto fingerprint_candidates(
+				const segment_and_bucket_t &a
+				, owner::value_type owned
+				, fingerprint_t f
+			) const -> owner::value_type;
+			/* true iff the content at a_ may match fingerprint f. Learns unknown fingerprints. */
+			bool fingerprint_check(const segment_and_bucket_t &a, fingerprint_t f) const;
+
 			void resize(AK_FORMAL0);
-			void resize_pass1();
-			void resize_pass2();
+			void resize_prepare(AK_FORMAL0);
+			void resize_construct(bix_t n);
+			void resize_pass1(bix_t ix_senior_end);
+			void resize_pass2(bix_t ix_senior_end);
 			bool resize_pass2_adjust_owner(
 				bix_t ix_senior
 				, bucket_control_t &junior_bucket_control
 				, content_unique_lock_t &populated_content_lk
 			);
+			void resize_migrate_begin();
+			void resize_migrate(bix_t n);
+			void resize_migrate_owner(bix_t ix_senior);
+			void resize_migrate_content(bix_t ix_senior, owner::index_type p, bix_t ix_junior);
+			void resize_migrate_neighbourhood(bix_t ix);
+			void resize_step();
+			bool is_migrating() const { return _migrate_senior_count != 0U; }
+			/* true iff the junior owner at ix_ may have keys still held by its senior owner */
+			bool is_senior_owner_pending(bix_t ix_) const
+			{
+				return is_migrating() && _migrate_senior_count + _migrate_cursor <= ix_;
+			}
+			bool relock_senior_owner(owner_shared_lock_t &bi) const;
 			auto locate_bucket_mutexes(
 				const segment_and_bucket_t &
 			) const -> bucket_mutexes_t &;
@@ -405,8 +478,6 @@ namespace impl
 				, unsigned bkwd
 			) const -> owner_unique_lock_t;
 
-			template <typename K>
-				auto make_owner_shared_lock(const K &k) const -> owner_shared_lock_t;
 			auto make_owner_shared_lock(
 				const segment_and_bucket_t &
 			) const -> owner_shared_lock_t;
@@ -453,11 +524,10 @@ namespace impl
 			 */
 			auto distance_wrapped(bix_t first, bix_t last) -> unsigned;
 
-			unsigned _locate_key_call;
-			unsigned _locate_key_owned;
-			unsigned _locate_key_unowned;
-			unsigned _locate_key_match;
-			unsigned _locate_key_mismatch;
+			std::uint64_t _locate_key_call;
+			std::uint64_t _locate_key_owned;
+			std::uint64_t _locate_key_match;
+			std::uint64_t _locate_key_mismatch;
 
 		public:
 			explicit hop_hash_base(
@@ -476,6 +546,12 @@ namespace impl
 				return static_cast<const hop_hash_allocator<Allocator> &>(*this);
 			}
 
+			/* At a clean close: list the allocations of all keys and values, in
+			 * address order, in extents. False (and no list) if a resize is
+			 * in preparation.
+			 */
+			bool deconstitute(std::vector<::iovec> &extents) const;
+
 			template <typename ... Args>
 				auto emplace(
 					AK_FORMAL
@@ -562,6 +638,16 @@ namespace impl
 
 			bool set_auto_resize(bool v1) { auto v0 = _auto_resize; _auto_resize = v1; return v0; }
 			bool get_auto_resize() const { return _auto_resize; }
+			bool set_fingerprint_filter(bool v1) { auto v0 = _fingerprint_filter; _fingerprint_filter = v1; return v0; }
+			/* lookup counters: calls, owned candidates, key matches, key mismatches. Reset by the call. */
+			void locate_key_stats(std::uint64_t (&stats)[4]);
+			/* resize state: bucket count, resize in preparation (0 or 1), senior owners yet to migrate */
+			void resize_state(std::uint64_t (&state)[3]) const
+			{
+				state[0] = bucket_count();
+				state[1] = _resize_preparing;
+				state[2] = is_migrating() ? _migrate_senior_count - _migrate_cursor : 0U;
+			}
 
 #if TRACED_TABLE
 			friend
@@ -660,6 +746,7 @@ template <
 		using const_iterator = impl::hop_hash_const_iterator<base>;
 		using persist_data_t = typename base::persist_data_t;
 		using allocator_type = typename base::allocator_type;
+		using mutex_type     = SharedMutex;
 
 		/* contruct/destroy/copy */
 		explicit hop_hash(
@@ -672,6 +759,7 @@ template <
 		{}
 
 		using base::get_allocator;
+		using base::deconstitute;
 
 		/* size and capacity */
 		auto empty() const noexcept -> bool
@@ -681,6 +769,9 @@ template <
 		using base::size;
 		using base::get_auto_resize;
 		using base::set_auto_resize;
+		using base::set_fingerprint_filter;
+		using base::locate_key_stats;
+		using base::resize_state;
 		using base::bucket_count;
 		auto max_size() const noexcept -> size_type
 		{
@@ -20,6 +20,7 @@
 #include "key_not_found.h"
 #include "perishable.h"
 #include "perishable_expiry.h"
+#include "parallel_for.h"
 #include "persistent.h"
 #include "test_flags.h"
 
@@ -28,6 +29,7 @@
 #include <algorithm>
 #include <cassert>
 #include <exception>
+#include <new> /* bad_alloc */
 #include <utility> /* move */
 
 
@@ -49,9 +51,13 @@ template <
 		, persist_controller_t(AK_REF av_, pc_, mode_)
 		, _hasher{}
 		, _auto_resize{true}
+		, _fingerprint_filter{true}
+		, _resize_preparing(false)
+		, _resize_constructed(0)
+		, _migrate_senior_count(0)
+		, _migrate_cursor(0)
 		, _locate_key_call(0)
 		, _locate_key_owned(0)
-		, _locate_key_unowned(0)
 		, _locate_key_match(0)
 		, _locate_key_mismatch(0)
 	{
@@ -76,12 +82,8 @@ template <
 			_bc[ix]._next = &_bc[0];
 			_bc[ix]._prev = &_bc[0];
 			const auto segment_size = base_segment_size;
-			_bc[ix]._bucket_mutexes.reset(new bucket_mutexes_t[segment_size]);
+			_bc[ix].dram_reset(segment_size);
 			_bc[ix]._buckets_end = _bc[ix]._buckets + segment_size;
-			if ( mode_ == construction_mode::reconstitute )
-			{
-				_bc[ix].reconstitute(av_);
-			}
 		}
 
 		for ( segment_layout::six_t ix = 1U; ix != this->persist_controller_t::segment_count_actual().value_not_stable(); ++ix )
@@ -92,13 +94,14 @@ template <
 			_bc[ix]._next = &_bc[0];
 			_bc[0]._prev = &_bc[ix];
 			const auto segment_size = base_segment_size << (ix-1U);
-			_bc[ix]._bucket_mutexes.reset(new bucket_mutexes_t[segment_size]);
+			_bc[ix].dram_reset(segment_size);
 			_bc[ix]._buckets_end = _bc[ix]._buckets + segment_size;
-			if ( mode_ == construction_mode::reconstitute )
-			{
-				_bc[ix].reconstitute(av_);
-			}
 		}
+		if ( mode_ == construction_mode::reconstitute )
+		{
+			reconstitute_segments(av_);
+		}
+
 		hop_hash_log<HSTORE_TRACE_MANY>::write(LOG_LOCATION, " segment_count ", this->persist_controller_t::segment_count_actual().value_not_stable()
 			, " segment_count_specified ", this->persist_controller_t::segment_count_specified());
 		/* If table allocation incomplete (perhaps in the middle of a resize op), resize until large enough. */
@@ -106,9 +109,16 @@ template <
 		hop_hash_log<TEST_HSTORE_PERISHABLE>::write(LOG_LOCATION, "HopHash base constructor: "
 			, (this->is_size_stable() ? "stable" : "unstable"), " segment_count ", this->segment_count_actual().value_not_stable());
 
-		if ( ! this->persist_controller_t::segment_count_actual().is_stable() )
+		if ( this->persist_controller_t::resize_is_switched() )
+		{
+			/* The junior segment has joined the table, but migration of keys
+			 * from senior owners is incomplete. Finished below, once the
+			 * content state is known.
+			 */
+			resize_migrate_begin();
+		}
+		else if ( ! this->persist_controller_t::segment_count_actual().is_stable() )
 		{
-			/* ERROR: reconstruction code for resize state not written. */
 			const auto ix = this->persist_controller_t::segment_count_actual().value_not_stable();
 			bucket_control_t &junior_bucket_control = _bc[ix];
 
@@ -117,7 +127,7 @@ template <
 			junior_bucket_control._prev = &_bc[ix-1];
 			junior_bucket_control._index = ix;
 			const auto segment_size = base_segment_size << (ix-1U);
-			junior_bucket_control._bucket_mutexes.reset(new bucket_mutexes_t[segment_size]);
+			junior_bucket_control.dram_reset(segment_size);
 			junior_bucket_control._buckets_end = junior_bucket_control._buckets + segment_size;
 
 			junior_bucket_control.reconstitute(av_);
@@ -125,8 +135,12 @@ template <
 			hop_hash_log<HSTORE_TRACE_RESIZE>::write(LOG_LOCATION
 				, " finishing resize in constructor"
 			);
-			resize_pass2();
-			this->persist_controller_t::resize_epilog();
+			/* A full pass 2 also finishes a resize begun by the older,
+			 * non-incremental scheme, which copied all content in pass 1.
+			 */
+			resize_pass2(bucket_count());
+			this->persist_controller_t::resize_switch();
+			resize_migrate_begin();
 		}
 
 		hop_hash_log<TEST_HSTORE_PERISHABLE>::write(LOG_LOCATION, "HopHash base constructor: "
@@ -163,11 +177,12 @@ template <
 					content_lk.owner_ref().set_adjacent_content_in_use(in_use);
 
 					/*
-					 * Persists the entire owner, although only the in_use bit has changed.
-					 * Persisting only the in_uze bit would require an additional function
-					 * in persist_controller_t.
+					 * Flushes the entire owner, although only the in_use bit has changed.
+					 * Flushing only the in_uze bit would require an additional function
+					 * in persist_controller_t. The size_set persist below orders every
+					 * such flush before the size becomes stable.
 					 */
-					this->persist_controller_t::persist_owner(content_lk.owner_ref(), "summary content state from owner");
+					this->persist_controller_t::flush_owner(content_lk.owner_ref(), "summary content state from owner");
 				}
 			}
 			this->persist_controller_t::size_set(s);
@@ -175,6 +190,14 @@ template <
 			hop_hash_log<HSTORE_TRACE_MANY>::write(LOG_LOCATION, "Restored size ", size());
 
 		}
+
+		if ( is_migrating() )
+		{
+			hop_hash_log<HSTORE_TRACE_RESIZE>::write(LOG_LOCATION
+				, " finishing resize migration in constructor"
+			);
+			resize_migrate(_migrate_senior_count);
+		}
 	}
 
 template <
@@ -186,6 +209,167 @@ template <
 		perishable::report();
 	}
 
+template <
+	typename Key, typename T, typename Hash, typename Pred
+	, typename Allocator, typename SharedMutex
+>
+	auto impl::hop_hash_base<Key, T, Hash, Pred, Allocator, SharedMutex>::scan_ranges(
+		six_t segment_count_
+	) const -> std::vector<scan_range>
+	{
+		std::vector<scan_range> r;
+		for ( six_t ix = 0U; ix != segment_count_; ++ix )
+		{
+			const auto segment_size = _bc[ix].segment_size();
+			for ( bix_t b = 0U; b < segment_size; b += scan_step )
+			{
+				r.push_back(scan_range{ix, b, std::min(segment_size, b + scan_step)});
+			}
+		}
+		return r;
+	}
+
+/*
+ * Reconstitution of the segments (apart from any junior segment) at open.
+ *
+ * With the rc heap, every key and value allocation must be injected into the
+ * heap. A snapshot written at the last clean close supplies them; otherwise
+ * (after a crash) segments are scanned by several threads, each bucket range
+ * listing the allocations it finds. The lists are merged and injected in
+ * address order, and each allocation reset with the count of references to
+ * it (more than one only for a key copied by an incomplete resize).
+ */
+template <
+	typename Key, typename T, typename Hash, typename Pred
+	, typename Allocator, typename SharedMutex
+>
+	void impl::hop_hash_base<Key, T, Hash, Pred, Allocator, SharedMutex>::reconstitute_segments(
+		const Allocator &av_
+	)
+	{
+		const auto segment_count = this->persist_controller_t::segment_count_actual().value_not_stable();
+#if USE_CC_HEAP == 3
+		if ( av_.pool()->snapshot_restored() )
+		{
+			hop_hash_log<HSTORE_TRACE_MANY>::write(LOG_LOCATION, " allocations restored from snapshot");
+			return;
+		}
+
+		const auto ranges = scan_ranges(segment_count);
+		const auto thread_count = parallel_thread_count(ranges.size());
+		std::vector<std::vector<::iovec>> found(thread_count);
+		parallel_for(
+			ranges.size(), thread_count
+			, [this, &av_, &ranges, &found] (unsigned t_, std::size_t i_)
+			{
+				const auto &r = ranges[i_];
+				_bc[r.ix].reconstitute_scan(av_, r.first, r.last, found[t_]);
+			}
+		);
+
+		std::vector<::iovec> all;
+		for ( auto &f : found )
+		{
+			all.insert(all.end(), f.begin(), f.end());
+			std::vector<::iovec>().swap(f);
+		}
+		std::sort(
+			all.begin(), all.end()
+			, [] (const ::iovec &a, const ::iovec &b) { return a.iov_base < b.iov_base; }
+		);
+
+		/* Remove duplicates, counting references */
+		std::vector<unsigned> ref_count;
+		{
+			auto o = all.begin();
+			for ( auto it = all.begin(); it != all.end(); ++it )
+			{
+				if ( o != all.begin() && (o-1)->iov_base == it->iov_base )
+				{
+					++ref_count.back();
+				}
+				else
+				{
+					*o = *it;
+					++o;
+					ref_count.push_back(1U);
+				}
+			}
+			all.erase(o, all.end());
+		}
+
+		const auto element_chunks = (all.size() + scan_step - 1U) / scan_step;
+		parallel_for(
+			element_chunks, parallel_thread_count(element_chunks)
+			, [&all, &ref_count] (unsigned, std::size_t i_)
+			{
+				const auto last = std::min(all.size(), (i_ + 1U) * scan_step);
+				for ( auto i = i_ * scan_step; i != last; ++i )
+				{
+					/* keys and values share the element type, fixed_string<char> */
+					key_type::reconstitute_element(all[i], ref_count[i]);
+				}
+			}
+		);
+
+		hop_hash_log<HSTORE_TRACE_MANY>::write(LOG_LOCATION, " threads ", thread_count, " allocations ", all.size());
+		av_.pool()->inject_allocations(std::move(all));
+#else
+		for ( six_t ix = 0U; ix != segment_count; ++ix )
+		{
+			_bc[ix].reconstitute(av_);
+		}
+#endif
+	}
+
+template <
+	typename Key, typename T, typename Hash, typename Pred
+	, typename Allocator, typename SharedMutex
+>
+	bool impl::hop_hash_base<Key, T, Hash, Pred, Allocator, SharedMutex>::deconstitute(
+		std::vector<::iovec> &extents_
+	) const
+	{
+		/* A junior segment under construction may be partly uninitialized.
+		 * Leave that case to the reconstitute scan.
+		 */
+		if ( ! this->persist_controller_t::segment_count_actual().is_stable() )
+		{
+			return false;
+		}
+		const auto ranges = scan_ranges(this->persist_controller_t::segment_count_actual().value());
+		const auto thread_count = parallel_thread_count(ranges.size());
+		std::vector<std::vector<::iovec>> found(thread_count);
+		parallel_for(
+			ranges.size(), thread_count
+			, [this, &ranges, &found] (unsigned t_, std::size_t i_)
+			{
+				const auto &r = ranges[i_];
+				_bc[r.ix].deconstitute(r.first, r.last, found[t_]);
+			}
+		);
+
+		auto &all = extents_;
+		for ( auto &f : found )
+		{
+			all.insert(all.end(), f.begin(), f.end());
+			std::vector<::iovec>().swap(f);
+		}
+		std::sort(
+			all.begin(), all.end()
+			, [] (const ::iovec &a, const ::iovec &b) { return a.iov_base < b.iov_base; }
+		);
+		/* A key may be referenced twice while migrating after a resize */
+		all.erase(
+			std::unique(
+				all.begin(), all.end()
+				, [] (const ::iovec &a, const ::iovec &b) { return a.iov_base == b.iov_base; }
+			)
+			, all.end()
+		);
+		return true;
+	}
+
 template <
 	typename Key, typename T, typename Hash, typename Pred
 	, typename Allocator, typename SharedMutex
@@ -524,9 +708,11 @@ template <
 				assert(is_free(b_dst_lock_.sb()));
 
 				b_dst_lock_.ref().content_share(b_src_lock.ref());
+				locate_fingerprint(b_dst_lock_.sb()) = locate_fingerprint(b_src_lock.sb());
 				b_dst_lock_.owner_ref().set_adjacent_content_in_use(true);
 
-				this->persist_controller_t::persist_content(b_src_lock.ref(), "content free");
+				/* one fence for both contents */
+				this->persist_controller_t::flush_content(b_src_lock.ref(), "content free");
 				this->persist_controller_t::persist_content(b_dst_lock_.ref(), "content in use");
 
 				owner_lock.ref().move(q, p, owner_lock);
@@ -637,26 +823,48 @@ template <
 				, LOG_LOCATION, " END LIST"
 			);
 
+			if (
+				_auto_resize
+				&& ! _resize_preparing
+				&& ! is_migrating()
+				&& segment_count() < _segment_capacity
+				&& bucket_count() / 4U * 3U <= size()
+			)
+			{
+				try
+				{
+					resize_prepare(AK_REF0);
+				}
+				catch ( const std::bad_alloc & )
+				{
+					/* No room to grow ahead of time. Try again when the table fills. */
+				}
+			}
+			resize_step();
+
+			bool neighbourhood_migrated = false;
 		RETRY:
 			/* convert the args to a value_type */
 			value_type v(std::forward<Args>(args)...);
 
 			/* The bucket in which to place the new entry */
-			auto sbw = make_segment_and_bucket(bucket(v.first));
+			const auto h = _hasher.hf(v.first);
+			const auto f = fingerprint(h);
+			auto sbw = make_segment_and_bucket(bucket_ix(h));
+			if ( is_senior_owner_pending(sbw.index()) )
+			{
+				/* bring any copy of the key held by the senior owner under the junior owner */
+				resize_migrate_owner(sbw.index() - _migrate_senior_count);
+			}
 			auto owner_lk = make_owner_unique_lock(sbw);
 
 			/* If the key already exists, refuse to emplace */
-			if ( auto cv = owner_lk.ref().ownership_bits(owner_lk) )
 			{
-				auto sbc = sbw;
-				owner::index_type i = 0;
-				for ( ; cv ; cv >>= 1U, sbc.incr_with_wrap(), ++i )
+				const auto i = content_index_of_key(owner_lk, v.first, f);
+				if ( i != owner::size )
 				{
-					if ( (cv & 1U) && key_equal()(sbc.deref().key(), v.first) )
-					{
-						hop_hash_log<HSTORE_TRACE_MANY>::write(LOG_LOCATION, " (already present)");
-						return {iterator{sbw, i}, false};
-					}
+					hop_hash_log<HSTORE_TRACE_MANY>::write(LOG_LOCATION, " (already present)");
+					return {iterator{sbw, i}, false};
 				}
 			}
 
@@ -684,6 +892,7 @@ template <
 				{
 					persist_size_change<Allocator, size_incr> s(*this);
 					b_dst.ref().content_construct(owner_lk.index(), std::move(v));
+					locate_fingerprint(b_dst.sb()) = f;
 					if ( owner_lk.index() == b_dst.index() )
 					{
 						owner_lk.ref().set_adjacent_content_in_use();
@@ -721,9 +930,27 @@ template <
 
 					hop_hash_log<HSTORE_TRACE_MANY>::write(LOG_LOCATION, "1. before resize\n", dump<HSTORE_TRACE_MANY>::make_hop_hash_dump(*this));
 
+					if ( is_migrating() )
+					{
+						/* Moving keys out of the neighbourhood makes room in it.
+						 * If that is not enough, finish the migration.
+						 */
+						if ( neighbourhood_migrated )
+						{
+							resize_migrate(_migrate_senior_count);
+						}
+						else
+						{
+							resize_migrate_neighbourhood(sbw.index());
+							neighbourhood_migrated = true;
+						}
+						goto RETRY;
+					}
+
 					if ( segment_count() < _segment_capacity )
 					{
 						resize(AK_REF0);
+						neighbourhood_migrated = false;
 						hop_hash_log<HSTORE_TRACE_MANY>::write(LOG_LOCATION, "2. after resize\n", dump<HSTORE_TRACE_MANY>::make_hop_hash_dump(*this));
 						goto RETRY;
 					}
@@ -762,27 +989,31 @@ template <
 			, " capacity ", bucket_count()
 			, " size ", size()
 		);
+		assert( ! is_migrating() );
+
+		if ( ! _resize_preparing )
 		{
-#if 0
-			monitor_extend<Allocator> m{bucket_allocator_t(av)};
-#endif
-			_bc[segment_count()]._buckets = this->persist_controller_t::resize_prolog(AK_REF0);
+			resize_prepare(AK_REF0);
 		}
-		_bc[segment_count()]._next = &_bc[0];
-		_bc[segment_count()]._prev = &_bc[segment_count()-1];
-		_bc[segment_count()]._index = segment_count();
-		auto segment_size = bucket_count();
-		_bc[segment_count()]._bucket_mutexes.reset(new bucket_mutexes_t[segment_size]);
-		_bc[segment_count()]._buckets_end = _bc[segment_count()]._buckets + segment_size;
+		/* Construction is normally complete, but the table may have filled early */
+		resize_construct(bucket_count());
+		_resize_preparing = false;
 
 		/* adjust count and everything which depends on it (size, mask) */
 
-		/* PASS 1: copy content */
+		/* PASS 1: copy content.
+		 *
+		 * Only the content at the start of the table, which may be owned by a
+		 * wrapped owner at the end of the table, is examined. Afterwards, every
+		 * ownership bit in the table means the same bucket whether the table
+		 * wraps at the old or at the new bucket count, and the remaining keys
+		 * can be migrated later, a few owners at a time.
+		 */
 
 		hop_hash_log<HSTORE_TRACE_RESIZE>::write(LOG_LOCATION, "before pass 1"
 			, "\n", dump<HSTORE_TRACE_RESIZE>::make_hop_hash_dump(*this));
 
-		resize_pass1();
+		resize_pass1(owner::size);
 
 		hop_hash_log<HSTORE_TRACE_RESIZE>::write(LOG_LOCATION, "after pass 1"
 			, "\n", dump<HSTORE_TRACE_RESIZE>::make_hop_hash_dump(*this));
@@ -803,6 +1034,11 @@ template <
 		 * Exactly when the "actual size" changes to encompass the junior content,
 		 * the junior content scan must no longer be performed. Therefore the "actual size"
 		 * and the "need to scan junior content bit" must be updated together.
+		 *
+		 * The "actual size" is incremented (the switch) while it remains unstable,
+		 * and is marked stable only when the migration is complete. A restart
+		 * which finds the count unstable and no segment allocated at the count
+		 * finishes the migration.
 		 */
 
 		this->persist_controller_t::resize_interlog();
@@ -811,31 +1047,76 @@ template <
 		 * removed if pass 2 was restarted, so use the new (junior) content to drive
 		 * the operations.
 		 */
-		resize_pass2();
+		resize_pass2(owner::size);
 
-		this->persist_controller_t::resize_epilog();
+		this->persist_controller_t::resize_switch();
+		resize_migrate_begin();
 	}
 
 template <
 	typename Key, typename T, typename Hash, typename Pred
 	, typename Allocator, typename SharedMutex
 >
-	void impl::hop_hash_base<Key, T, Hash, Pred, Allocator, SharedMutex>::resize_pass1()
+	void impl::hop_hash_base<Key, T, Hash, Pred, Allocator, SharedMutex>::resize_prepare(AK_ACTUAL0)
 	{
-		/* PASS 1: copy content */
+		{
+#if 0
+			monitor_extend<Allocator> m{bucket_allocator_t(av)};
+#endif
+			_bc[segment_count()]._buckets = this->persist_controller_t::resize_prolog(AK_REF0);
+		}
+		_bc[segment_count()]._next = &_bc[0];
+		_bc[segment_count()]._prev = &_bc[segment_count()-1];
+		_bc[segment_count()]._index = segment_count();
+		auto segment_size = bucket_count();
+		_bc[segment_count()].dram_reset(segment_size);
+		_bc[segment_count()]._buckets_end = _bc[segment_count()]._buckets + segment_size;
+		_resize_preparing = true;
+		_resize_constructed = 0U;
+
+		hop_hash_log<HSTORE_TRACE_RESIZE>::write(LOG_LOCATION
+			, " prepare junior segment of ", segment_size, " buckets"
+		);
+	}
+
+/* Construct (and persist) up to n more buckets of the junior segment */
+template <
+	typename Key, typename T, typename Hash, typename Pred
+	, typename Allocator, typename SharedMutex
+>
+	void impl::hop_hash_base<Key, T, Hash, Pred, Allocator, SharedMutex>::resize_construct(
+		bix_t n_
+	)
+	{
+		const auto last =
+			bucket_count() - _resize_constructed < n_
+			? bucket_count()
+			: _resize_constructed + n_
+			;
+		this->persist_controller_t::resize_construct(_resize_constructed, last);
+		_resize_constructed = last;
+	}
+
+template <
+	typename Key, typename T, typename Hash, typename Pred
+	, typename Allocator, typename SharedMutex
+>
+	void impl::hop_hash_base<Key, T, Hash, Pred, Allocator, SharedMutex>::resize_pass1(
+		bix_t ix_senior_end_
+	)
+	{
+		/* PASS 1: copy content of senior buckets [0, ix_senior_end_) */
 
 		bix_t ix_senior = 0U;
-		const auto sb_senior_end =
-			make_segment_and_bucket_at_end();
 
 			hop_hash_log<HSTORE_TRACE_MANY>::write(LOG_LOCATION
 				, " bucket_count ", bucket_count()
-				, " sb_senior_end ", sb_senior_end.si(), ",", sb_senior_end.bi()
+				, " ix_senior_end ", ix_senior_end_
 			);
 
 		for (
 			auto sb_senior = make_segment_and_bucket(0U)
-			; sb_senior != sb_senior_end
+			; ix_senior != ix_senior_end_
 			; sb_senior.incr_without_wrap(), ++ix_senior
 		)
 		{
@@ -884,6 +1165,7 @@ template <
 				{
 					/* content must move */
 					junior_content.content_share(senior_content_lk.ref(), ix_owner);
+					_bc[segment_count()]._fingerprints[ix_senior] = fingerprint(hash);
 					junior_owner.set_adjacent_content_in_use();
 
 					hop_hash_log<HSTORE_TRACE_MANY>::write(LOG_LOCATION
@@ -900,7 +1182,14 @@ template <
 		}
 
 		/* persist new content */
-		this->persist_controller_t::persist_new_segment("pass 1 copied content");
+		if ( ix_senior_end_ == bucket_count() )
+		{
+			this->persist_controller_t::persist_new_segment("pass 1 copied content");
+		}
+		else
+		{
+			this->persist_controller_t::persist_segment_prefixes(ix_senior_end_, "pass 1 copied content");
+		}
 	}
 
 /* Returns true iff ownership wraps the table, i.e. the owner is near the end of the table
@@ -980,7 +1269,8 @@ template <
 				, senior_owner_lk
 				, static_cast<persist_controller_t *>(this)
 			);
-			this->persist_controller_t::persist_owner(junior_owner_lk.ref(), "pass 2 junior owner");
+			/* one fence for both owners, already written */
+			this->persist_controller_t::flush_owner(junior_owner_lk.ref(), "pass 2 junior owner");
 			this->persist_controller_t::persist_owner(senior_owner_lk.ref(), "pass 2 senior owner");
 			/*
 			 * If the owner index exceeds the content index (which can only happen due to wrap)
@@ -995,7 +1285,9 @@ template <
 	typename Key, typename T, typename Hash, typename Pred
 	, typename Allocator, typename SharedMutex
 >
-	void impl::hop_hash_base<Key, T, Hash, Pred, Allocator, SharedMutex>::resize_pass2()
+	void impl::hop_hash_base<Key, T, Hash, Pred, Allocator, SharedMutex>::resize_pass2(
+		bix_t ix_senior_end_
+	)
 	{
 
 		hop_hash_log<HSTORE_TRACE_RESIZE>::write(LOG_LOCATION, "entering pass 2"
@@ -1008,10 +1300,9 @@ template <
 		bucket_control_t &junior_bucket_control = _bc[old_segment_count];
 
 		bix_t ix_senior = 0U;
-		const auto sb_senior_end = make_segment_and_bucket_at_end();
 		for (
 			auto sb_senior = make_segment_and_bucket(0U)
-			; sb_senior != sb_senior_end
+			; ix_senior != ix_senior_end_
 			; sb_senior.incr_without_wrap(), ++ix_senior
 		)
 		{
@@ -1042,9 +1333,16 @@ template <
 				senior_content_lk.ref().content_erase();
 				make_owner_unique_lock(sb_senior).ref().set_adjacent_content_in_use(false);
 			}
-			else if ( make_owner_shared_lock(sb_senior).ref().is_adjacent_content_in_use() )
+			else if (
+				make_owner_shared_lock(sb_senior).ref().is_adjacent_content_in_use()
+				&&
+				ix_senior < bucket_ix(_hasher.hf(senior_content_lk.ref().key()))
+			)
 			{
-				/* The content has not moved, but it might need a new owner */
+				/* The content has not moved, but its owner wraps and might need to change.
+				 * (Content which has not moved and whose owner does not wrap keeps its
+				 * senior owner, and is left to the incremental migration.)
+				 */
 				auto wrapped_owner = resize_pass2_adjust_owner(ix_senior, junior_bucket_control, senior_content_lk);
 				if ( wrapped_owner )
 				{
@@ -1060,16 +1358,286 @@ template <
 			}
 		}
 
-		/* flush for state_set bucket_t::FREE in loop above. */
-		this->persist_controller_t::persist_existing_segments("pass 2 senior content");
-		/* flush for state_set owner::LIVE in loop above. */
-		this->persist_controller_t::persist_new_segment("pass 2 junior owner");
+		if ( ix_senior_end_ == bucket_count() )
+		{
+			/* flush for state_set bucket_t::FREE in loop above. */
+			this->persist_controller_t::persist_existing_segments("pass 2 senior content");
+			/* flush for state_set owner::LIVE in loop above. */
+			this->persist_controller_t::persist_new_segment("pass 2 junior owner");
+		}
+		else
+		{
+			this->persist_controller_t::persist_segment_prefixes(ix_senior_end_, "pass 2 senior content and junior owner");
+		}
 
 		/* link in new segment in non-persistent circular list of segments */
 		_bc[old_segment_count-1]._next = &junior_bucket_control;
 		_bc[0]._prev = &junior_bucket_control;
 	}
 
+template <
+	typename Key, typename T, typename Hash, typename Pred
+	, typename Allocator, typename SharedMutex
+>
+	void impl::hop_hash_base<Key, T, Hash, Pred, Allocator, SharedMutex>::resize_migrate_begin()
+	{
+		_migrate_senior_count = bucket_count() / 2U;
+		_migrate_cursor = 0U;
+
+		hop_hash_log<HSTORE_TRACE_RESIZE>::write(LOG_LOCATION
+			, " migrate ", _migrate_senior_count, " senior owners"
+		);
+	}
+
+/* Migrate up to n more senior owners. Completes the resize if no senior owners remain. */
+template <
+	typename Key, typename T, typename Hash, typename Pred
+	, typename Allocator, typename SharedMutex
+>
+	void impl::hop_hash_base<Key, T, Hash, Pred, Allocator, SharedMutex>::resize_migrate(
+		bix_t n_
+	)
+	{
+		for ( ; n_ != 0U && _migrate_cursor != _migrate_senior_count; --n_ )
+		{
+			resize_migrate_owner(_migrate_cursor);
+			++_migrate_cursor;
+		}
+
+		if ( is_migrating() && _migrate_cursor == _migrate_senior_count )
+		{
+			this->persist_controller_t::resize_migrate_epilog();
+			_migrate_senior_count = 0U;
+			_migrate_cursor = 0U;
+
+			hop_hash_log<HSTORE_TRACE_RESIZE>::write(LOG_LOCATION
+				, " resize complete, capacity ", bucket_count()
+				, " size ", size()
+			);
+		}
+	}
+
+/* Move each key held by the senior owner ix_senior_ which belongs to
+ * the junior owner ix_senior_ + _migrate_senior_count.
+ */
+template <
+	typename Key, typename T, typename Hash, typename Pred
+	, typename Allocator, typename SharedMutex
+>
+	void impl::hop_hash_base<Key, T, Hash, Pred, Allocator, SharedMutex>::resize_migrate_owner(
+		bix_t ix_senior_
+	)
+	{
+		const auto sb_senior = make_segment_and_bucket(ix_senior_);
+		/* ownership bits of keys known to stay with the senior owner */
+		owner::value_type stay = 0U;
+		for ( ;; )
+		{
+			auto p = owner::size;
+			{
+				auto senior_owner_lk = make_owner_unique_lock(sb_senior);
+				for (
+					auto cv = senior_owner_lk.ref().ownership_bits(senior_owner_lk) & ~stay
+					; cv != 0U && p == owner::size
+					;
+				)
+				{
+					const auto q = owner::nearest_owned_content_offset(cv);
+					auto content_lk = make_content_unique_lock(senior_owner_lk, q);
+					if ( bucket_ix(_hasher.hf(content_lk.ref().key())) == ix_senior_ )
+					{
+						stay |= owner::value_type(1U) << q;
+						cv &= ~(owner::value_type(1U) << q);
+					}
+					else
+					{
+						p = q;
+					}
+				}
+			}
+
+			if ( p == owner::size )
+			{
+				return;
+			}
+
+			resize_migrate_content(ix_senior_, p, ix_senior_ + _migrate_senior_count);
+		}
+	}
+
+/* Move the content at ix_senior_ + p_ from its senior owner ix_senior_ to the
+ * junior owner ix_junior_, using the same steps as make_space_for_insert.
+ */
+template <
+	typename Key, typename T, typename Hash, typename Pred
+	, typename Allocator, typename SharedMutex
+>
+	void impl::hop_hash_base<Key, T, Hash, Pred, Allocator, SharedMutex>::resize_migrate_content(
+		bix_t ix_senior_
+		, owner::index_type p_
+		, bix_t ix_junior_
+	)
+	{
+		const auto sb_senior = make_segment_and_bucket(ix_senior_);
+		auto junior_owner_lk = make_owner_unique_lock(make_segment_and_bucket(ix_junior_));
+
+		/* A restart between the junior insert and the senior erase leaves
+		 * the key owned by both. If so, the senior copy is simply dropped.
+		 */
+		{
+			auto senior_owner_lk = make_owner_unique_lock(sb_senior);
+			auto src_lk = make_content_unique_lock(senior_owner_lk, p_);
+			const auto f = fingerprint(_hasher.hf(src_lk.ref().key()));
+			if ( content_index_of_key(junior_owner_lk, src_lk.ref().key(), f) != owner::size )
+			{
+				hop_hash_log<HSTORE_TRACE_RESIZE>::write(LOG_LOCATION
+					, " drop duplicate content at ", src_lk.index()
+					, " owned by ", ix_senior_, " and ", ix_junior_
+				);
+				{
+					persist_size_change<Allocator, size_decr> s(*this);
+					senior_owner_lk.ref().erase(
+						p_
+						, senior_owner_lk
+						, static_cast<persist_controller_t *>(this)
+					);
+					this->persist_controller_t::persist_owner(senior_owner_lk.ref(), "migrate senior owner (duplicate)");
+					src_lk.ref().content_erase();
+					src_lk.owner_ref().set_adjacent_content_in_use(false);
+				}
+				perishable::test();
+				return;
+			}
+		}
+
+		/* The preferred destination, at the same offset from the junior owner, is
+		 * free unless a new key has been placed there since the resize began.
+		 */
+		auto sb_dst = junior_owner_lk.sb();
+		sb_dst.add_small(p_);
+		auto dst_lk =
+			is_free(sb_dst)
+			? make_content_unique_lock(sb_dst)
+			: make_space_for_insert(ix_junior_, nearest_free_bucket(junior_owner_lk.sb()))
+			;
+		const auto q = distance_wrapped(ix_junior_, dst_lk.index());
+
+		/* make_space_for_insert may have moved the content, if the senior owner
+		 * was within reach of the destination. If so, examine the owner again.
+		 */
+		auto senior_owner_lk = make_owner_unique_lock(sb_senior);
+		if ( ! senior_owner_lk.ref().is_in_use(senior_owner_lk, p_) )
+		{
+			return;
+		}
+		auto src_lk = make_content_unique_lock(senior_owner_lk, p_);
+		if ( bucket_ix(_hasher.hf(src_lk.ref().key())) != ix_junior_ )
+		{
+			return;
+		}
+
+		hop_hash_log<HSTORE_TRACE_MANY>::write(LOG_LOCATION
+			, " migrate content ", src_lk.index(), " owner ", ix_senior_
+			, " -> content ", dst_lk.index(), " owner ", ix_junior_
+		);
+
+		{
+			persist_size_change<Allocator, size_no_change> s(*this);
+			assert(!is_free(src_lk.sb()));
+			assert(is_free(dst_lk.sb()));
+
+			dst_lk.ref().content_share(src_lk.ref(), ix_junior_);
+			dst_lk.owner_ref().set_adjacent_content_in_use(true);
+			locate_fingerprint(dst_lk.sb()) = locate_fingerprint(src_lk.sb());
+			this->persist_controller_t::persist_content(dst_lk.ref(), "migrate content in use");
+
+			junior_owner_lk.ref().insert(
+				ix_junior_
+				, q
+				, junior_owner_lk
+				, static_cast<persist_controller_t *>(this)
+			);
+			this->persist_controller_t::persist_owner(junior_owner_lk.ref(), "migrate junior owner");
+			senior_owner_lk.ref().erase(
+				p_
+				, senior_owner_lk
+				, static_cast<persist_controller_t *>(this)
+			);
+			this->persist_controller_t::persist_owner(senior_owner_lk.ref(), "migrate senior owner");
+
+			src_lk.ref().content_erase();
+			src_lk.owner_ref().set_adjacent_content_in_use(false);
+		}
+		perishable::test();
+	}
+
+/* Migrate the senior owners whose keys may lie in the neighbourhood of bucket ix_ */
+template <
+	typename Key, typename T, typename Hash, typename Pred
+	, typename Allocator, typename SharedMutex
+>
+	void impl::hop_hash_base<Key, T, Hash, Pred, Allocator, SharedMutex>::resize_migrate_neighbourhood(
+		bix_t ix_
+	)
+	{
+		const auto ix_senior = ix_ % _migrate_senior_count;
+		const auto first =
+			ix_senior < owner::size
+			? bix_t(0U)
+			: ix_senior - owner::size
+			;
+		const auto last =
+			_migrate_senior_count - ix_senior < owner::size
+			? _migrate_senior_count
+			: ix_senior + owner::size
+			;
+
+		hop_hash_log<HSTORE_TRACE_RESIZE>::write(LOG_LOCATION
+			, " migrate senior owners ", first, "..", last, " near ", ix_
+		);
+
+		for ( auto ix = std::max(first, _migrate_cursor); ix < last; ++ix )
+		{
+			resize_migrate_owner(ix);
+		}
+	}
+
+/* A bounded amount of resize work, done by each insert and erase */
+template <
+	typename Key, typename T, typename Hash, typename Pred
+	, typename Allocator, typename SharedMutex
+>
+	void impl::hop_hash_base<Key, T, Hash, Pred, Allocator, SharedMutex>::resize_step()
+	{
+		if ( _resize_preparing )
+		{
+			resize_construct(resize_construct_step);
+		}
+		else if ( is_migrating() )
+		{
+			resize_migrate(resize_migrate_step);
+		}
+	}
+
+/* After a lookup at owner bi_ fails, relock bi_ to the senior owner which may
+ * still hold the key. Returns false if there is no such owner.
+ */
+template <
+	typename Key, typename T, typename Hash, typename Pred
+	, typename Allocator, typename SharedMutex
+>
+	bool impl::hop_hash_base<Key, T, Hash, Pred, Allocator, SharedMutex>::relock_senior_owner(
+		owner_shared_lock_t &bi_
+	) const
+	{
+		if ( ! is_senior_owner_pending(bi_.index()) )
+		{
+			return false;
+		}
+		bi_ = make_owner_shared_lock(make_segment_and_bucket(bi_.index() - _migrate_senior_count));
+		return true;
+	}
+
 template <
 	typename Key, typename T, typename Hash, typename Pred
 	, typename Allocator, typename SharedMutex
@@ -1239,6 +1807,68 @@ template <
 		return _bc[a_.si()]._bucket_mutexes[a_.bi()];
 	}
 
+template <
+	typename Key, typename T, typename Hash, typename Pred
+	, typename Allocator, typename SharedMutex
+>
+	auto impl::hop_hash_base<
+		Key, T, Hash, Pred, Allocator, SharedMutex
+	>::locate_fingerprint(
+		const segment_and_bucket_t &a_
+	) const -> fingerprint_t &
+	{
+		return _bc[a_.si()]._fingerprints[a_.bi()];
+	}
+
+template <
+	typename Key, typename T, typename Hash, typename Pred
+	, typename Allocator, typename SharedMutex
+>
+	auto impl::hop_hash_base<
+		Key, T, Hash, Pred, Allocator, SharedMutex
+	>::fingerprint_candidates(
+		const segment_and_bucket_t &a_
+		, owner::value_type owned_
+		, fingerprint_t f_
+	) const -> owner::value_type
+	{
+		const auto &bc = _bc[a_.si()];
+		/* A neighbourhood which wraps into the next segment is left to
+		 * fingerprint_check, one bucket at a time.
+		 */
+		return
+			_fingerprint_filter && owned_ != 0U && a_.bi() + owner::size <= bc.segment_size()
+			? owned_ & fingerprint_match(&bc._fingerprints[a_.bi()], f_)
+			: owned_
+			;
+	}
+
+template <
+	typename Key, typename T, typename Hash, typename Pred
+	, typename Allocator, typename SharedMutex
+>
+	bool impl::hop_hash_base<
+		Key, T, Hash, Pred, Allocator, SharedMutex
+	>::fingerprint_check(
+		const segment_and_bucket_t &a_
+		, fingerprint_t f_
+	) const
+	{
+		/* Readers which share the owner lock may learn the same fingerprint
+		 * at once, so the byte is read and written atomically. (The
+		 * neighbourhood compare in fingerprint_candidates may see either
+		 * value; both are correct, as 0 matches every hash.)
+		 */
+		auto &fp = locate_fingerprint(a_);
+		auto f = __atomic_load_n(&fp, __ATOMIC_RELAXED);
+		if ( f == 0U )
+		{
+			f = fingerprint(_hasher.hf(a_.deref().key()));
+			__atomic_store_n(&fp, f, __ATOMIC_RELAXED);
+		}
+		return ! _fingerprint_filter || f == f_;
+	}
+
 template <
 	typename Key, typename T, typename Hash, typename Pred
 	, typename Allocator, typename SharedMutex
@@ -1279,20 +1909,6 @@ template <
 		return owner_unique_lock_t(a.deref(), a, locate_bucket_mutexes(a)._m_owner);
 	}
 
-template <
-	typename Key, typename T, typename Hash, typename Pred
-	, typename Allocator, typename SharedMutex
->
-	template < typename K >
-		auto impl::hop_hash_base<
-			Key, T, Hash, Pred, Allocator, SharedMutex
-		>::make_owner_shared_lock(
-			const K &k_
-		) const -> owner_shared_lock_t
-		{
-			return make_owner_shared_lock(make_segment_and_bucket(bucket(k_)));
-		}
-
 template <
 	typename Key, typename T, typename Hash, typename Pred
 	, typename Allocator, typename SharedMutex
@@ -1351,33 +1967,34 @@ template <
 		auto impl::hop_hash_base<Key, T, Hash, Pred, Allocator, SharedMutex>::content_index_of_key(
 			Lock &bi_
 			, const K &k_
+			, fingerprint_t f_
 		) const -> owner::index_type
 		{
-			/* Use the owner to filter key checks, a performance aid
-			 * to reduce the number of key compares.
+			/* Use the owner, and then the fingerprints, to filter key checks,
+			 * a performance aid to reduce the number of key compares.
 			 */
-			auto wv = bi_.ref().ownership_bits(bi_);
+			const auto owned = bi_.ref().ownership_bits(bi_);
+			auto wv = fingerprint_candidates(bi_.sb(), owned, f_);
 
 			hop_hash_log<HSTORE_TRACE_MANY>::write(LOG_LOCATION
 				, " owner "
 				, dump<HSTORE_TRACE_MANY>::make_owner_print(this->bucket_count(), bi_)
-				, " value ", wv
+				, " value ", owned
+				, " candidates ", wv
 			);
 
-			auto bfp = bi_.sb();
 			auto &t =
 				*const_cast<hop_hash_base<Key, T, Hash, Pred, Allocator, SharedMutex> *>(this);
 			++t._locate_key_call;
+			t._locate_key_owned += std::uint64_t(__builtin_popcountll(owned));
 
-			typename owner::index_type content_index = 0U;
-			for (
-				; content_index != owner::size
-				; ++content_index
-			)
+			for ( ; wv != 0U ; wv &= wv - 1U )
 			{
-				if ( ( wv & 1 ) == 1 )
+				const auto content_index = owner::index_type(__builtin_ctzll(wv));
+				auto bfp = bi_.sb();
+				bfp.add_small(content_index);
+				if ( fingerprint_check(bfp, f_) )
 				{
-					++t._locate_key_owned;
 					auto c = &bfp.deref();
 					if ( key_equal()(c->key(), k_) )
 					{
@@ -1390,16 +2007,11 @@ template <
 						++t._locate_key_mismatch;
 					}
 				}
-				{
-					++t._locate_key_unowned;
-				}
-				bfp.incr_with_wrap();
-				wv >>= 1U;
 			}
 
-			hop_hash_log<HSTORE_TRACE_MANY>::write(LOG_LOCATION, " returns (failure) ", bfp.index());
+			hop_hash_log<HSTORE_TRACE_MANY>::write(LOG_LOCATION, " returns (failure)");
 
-			return content_index;
+			return owner::size;
 		}
 
 template <
@@ -1410,32 +2022,33 @@ template <
 		auto impl::hop_hash_base<Key, T, Hash, Pred, Allocator, SharedMutex>::locate_key(
 			Lock &bi_
 			, const K &k_
+			, fingerprint_t f_
 		) const -> std::tuple<bucket_t *, segment_and_bucket_t>
 		{
-			/* Use the ownership bits to filter key checks, a performance aid
-			 * to reduce the number of key compares.
+			/* Use the ownership bits, and then the fingerprints, to filter key
+			 * checks, a performance aid to reduce the number of key compares.
 			 */
-			auto wv = bi_.ref().ownership_bits(bi_);
+			const auto owned = bi_.ref().ownership_bits(bi_);
+			auto wv = fingerprint_candidates(bi_.sb(), owned, f_);
 
 			hop_hash_log<HSTORE_TRACE_MANY>::write(LOG_LOCATION
 				, " owner "
 				, dump<HSTORE_TRACE_MANY>::make_owner_print(this->bucket_count(), bi_)
-				, " value ", wv
+				, " value ", owned
+				, " candidates ", wv
 			);
 
-			auto bfp = bi_.sb();
 			auto &t =
 				*const_cast<hop_hash_base<Key, T, Hash, Pred, Allocator, SharedMutex> *>(this);
 			++t._locate_key_call;
-			typename owner::index_type content_index = 0U;
-			for (
-				; content_index != owner::size
-				; ++content_index
-			)
+			t._locate_key_owned += std::uint64_t(__builtin_popcountll(owned));
+
+			for ( ; wv != 0U ; wv &= wv - 1U )
 			{
-				if ( ( wv & 1 ) == 1 )
+				auto bfp = bi_.sb();
+				bfp.add_small(owner::index_type(__builtin_ctzll(wv)));
+				if ( fingerprint_check(bfp, f_) )
 				{
-					++t._locate_key_owned;
 					auto c = &bfp.deref();
 					if ( key_equal()(c->key(), k_) )
 					{
@@ -1451,14 +2064,9 @@ template <
 						++t._locate_key_mismatch;
 					}
 				}
-				{
-					++t._locate_key_unowned;
-				}
-				bfp.incr_with_wrap();
-				wv >>= 1U;
 			}
 
-			hop_hash_log<HSTORE_TRACE_MANY>::write(LOG_LOCATION, " returns (failure) ", bfp.index());
+			hop_hash_log<HSTORE_TRACE_MANY>::write(LOG_LOCATION, " returns (failure)");
 
 			return
 				std::tuple<bucket_t *, segment_and_bucket_t>(
@@ -1467,6 +2075,24 @@ template <
 				);
 		}
 
+template <
+	typename Key, typename T, typename Hash, typename Pred
+	, typename Allocator, typename SharedMutex
+>
+	void impl::hop_hash_base<Key, T, Hash, Pred, Allocator, SharedMutex>::locate_key_stats(
+		std::uint64_t (&stats_)[4]
+	)
+	{
+		stats_[0] = _locate_key_call;
+		stats_[1] = _locate_key_owned;
+		stats_[2] = _locate_key_match;
+		stats_[3] = _locate_key_mismatch;
+		_locate_key_call = 0;
+		_locate_key_owned = 0;
+		_locate_key_match = 0;
+		_locate_key_mismatch = 0;
+	}
+
 template <
 	typename Key, typename T, typename Hash, typename Pred
 	, typename Allocator, typename SharedMutex
@@ -1474,8 +2100,14 @@ template <
 	template <typename K>
 		auto impl::hop_hash_base<Key, T, Hash, Pred, Allocator, SharedMutex>::find(const K &k_) -> iterator
 		{
-			auto bi_lk = make_owner_shared_lock(k_);
-			const auto content_ix = content_index_of_key(bi_lk, k_);
+			const auto h = _hasher.hf(k_);
+			const auto f = fingerprint(h);
+			auto bi_lk = make_owner_shared_lock(make_segment_and_bucket(bucket_ix(h)));
+			auto content_ix = content_index_of_key(bi_lk, k_, f);
+			if ( content_ix == owner::size && relock_senior_owner(bi_lk) )
+			{
+				content_ix = content_index_of_key(bi_lk, k_, f);
+			}
 			return content_ix == owner::size ? end() : iterator{bi_lk.sb(), content_ix};
 		}
 
@@ -1486,8 +2118,14 @@ template <
 	template <typename K>
 		auto impl::hop_hash_base<Key, T, Hash, Pred, Allocator, SharedMutex>::find(const K &k_) const -> const_iterator
 		{
-			auto bi_lk = make_owner_shared_lock(k_);
-			const auto bf = locate_key(bi_lk, k_);
+			const auto h = _hasher.hf(k_);
+			const auto f = fingerprint(h);
+			auto bi_lk = make_owner_shared_lock(make_segment_and_bucket(bucket_ix(h)));
+			auto bf = locate_key(bi_lk, k_, f);
+			if ( ! std::get<0>(bf) && relock_senior_owner(bi_lk) )
+			{
+				bf = locate_key(bi_lk, k_, f);
+			}
 			return std::get<0>(bf) ? std::get<1>(bf) : end();
 		}
 
@@ -1516,7 +2154,8 @@ template <
 		 *  persist
 		 */
 
-		this->persist_controller_t::persist_content(erase_src_lk.ref(), "content erase exiting");
+		/* ordered before the owner erase by the fence of the size destabilize */
+		this->persist_controller_t::flush_content(erase_src_lk.ref(), "content erase exiting");
 		{
 			persist_size_change<Allocator, size_decr> s(*this);
 			owner_lk.ref().erase(
@@ -1553,6 +2192,7 @@ template <
 		) -> size_type
 		try
 		{
+			resize_step();
 			auto it = find(k_);
 			return
 				it == end()
@@ -1576,8 +2216,14 @@ template <
 			const K &k_
 		) const -> size_type
 		{
-			auto bi_lk = make_owner_shared_lock(k_);
-			const auto bf = locate_key(bi_lk, k_);
+			const auto h = _hasher.hf(k_);
+			const auto f = fingerprint(h);
+			auto bi_lk = make_owner_shared_lock(make_segment_and_bucket(bucket_ix(h)));
+			auto bf = locate_key(bi_lk, k_, f);
+			if ( ! std::get<0>(bf) && relock_senior_owner(bi_lk) )
+			{
+				bf = locate_key(bi_lk, k_, f);
+			}
 
 			hop_hash_log<HSTORE_TRACE_MANY>::write(LOG_LOCATION
 				, " ", k_
@@ -1600,8 +2246,14 @@ template <
 		) const -> const mapped_type &
 		{
 			/* The bucket which owns the entry */
-			auto bi_lk = make_owner_shared_lock(k_);
-			const auto bf = std::get<0>(locate_key(bi_lk, k_));
+			const auto h = _hasher.hf(k_);
+			const auto f = fingerprint(h);
+			auto bi_lk = make_owner_shared_lock(make_segment_and_bucket(bucket_ix(h)));
+			auto bf = std::get<0>(locate_key(bi_lk, k_, f));
+			if ( ! bf && relock_senior_owner(bi_lk) )
+			{
+				bf = std::get<0>(locate_key(bi_lk, k_, f));
+			}
 			if ( ! bf )
 			{
 				/* no such element */
@@ -1621,8 +2273,14 @@ template <
 		) -> mapped_type &
 		{
 			/* Lock the entry owner */
-			auto bi_lk = make_owner_shared_lock(k_);
-			const auto bf = std::get<0>(locate_key(bi_lk, k_));
+			const auto h = _hasher.hf(k_);
+			const auto f = fingerprint(h);
+			auto bi_lk = make_owner_shared_lock(make_segment_and_bucket(bucket_ix(h)));
+			auto bf = std::get<0>(locate_key(bi_lk, k_, f));
+			if ( ! bf && relock_senior_owner(bi_lk) )
+			{
+				bf = std::get<0>(locate_key(bi_lk, k_, f));
+			}
 			if ( ! bf )
 			{
 				/* no such element */
@@ -37,6 +37,7 @@
 #pragma GCC diagnostic pop
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cerrno>
 #include <cstring> /* strerror, memcmp, memcpy */
@@ -61,6 +62,13 @@ template<> struct type_number<impl::mod_control> { static constexpr std::uint64_
 /* globals */
 
 thread_local std::map<void *, hstore::open_pool_t *> tls_cache = {};
+#if THREAD_SAFE_HASH == 1
+/* Bumped whenever a pool is closed. A thread whose tls_cache predates the
+ * current generation may hold a closed pool, and empties its cache.
+ */
+std::atomic<std::uint64_t> pools_generation{0};
+thread_local std::uint64_t tls_generation = 0;
+#endif
 
 /* forced because pool_t is an integral tye, not a pointer */
 void *to_ptr(component::IKVStore::pool_t p) { return reinterpret_cast<void *>(p); }
@@ -69,6 +77,15 @@ component::IKVStore::pool_t to_pool_t(void *v) { return reinterpret_cast<compone
 auto hstore::locate_session(const component::IKVStore::pool_t p) -> open_pool_t *
 {
   auto *const v = to_ptr(p);
+#if THREAD_SAFE_HASH == 1
+  /* tls_cache entries are only erased in the thread which closes the pool */
+  const auto g = pools_generation.load(std::memory_order_acquire);
+  if ( g != tls_generation )
+  {
+    tls_cache.clear();
+    tls_generation = g;
+  }
+#endif
   auto it = tls_cache.find(v);
   if ( it == tls_cache.end() )
   {
@@ -95,6 +112,9 @@ auto hstore::move_pool(const component::IKVStore::pool_t p) -> std::shared_ptr<o
     }
 
   tls_cache.erase(v);
+#if THREAD_SAFE_HASH == 1
+  pools_generation.fetch_add(1, std::memory_order_release);
+#endif
   auto s2 = ps->second;
   _pools.erase(ps);
   return s2;
@@ -133,6 +153,16 @@ int hstore::get_capability(const Capability cap) const
 
 #include "session.h"
 
+namespace
+{
+  /* A lock of the pool's writer mutex, or no lock if there is no pool */
+  template <typename Lock, typename Session>
+    Lock pool_lock(Session *session_)
+    {
+      return session_ ? Lock(session_->writer_mutex()) : Lock();
+    }
+}
+
 auto hstore::create_pool(const std::string & name_,
                          const std::size_t size_,
                          flags_t flags_,
@@ -184,6 +214,8 @@ catch ( std::bad_alloc & )
 auto hstore::open_pool(const std::string &name_,
                        flags_t flags) -> pool_t
 {
+  /* recovery flushes the content state of each element, ahead of one fence */
+  persister_nupm::domain pd;
   auto path = pool_path(name_);
   try {
     auto v = _pool_manager->pool_open_1(path);
@@ -229,7 +261,17 @@ status_t hstore::close_pool(const pool_t p)
   std::string path;
   try
   {
-    auto pool = move_pool(p);
+    const auto session = static_cast<session_t *>(locate_session(p));
+    if ( ! session )
+    {
+      return E_POOL_NOT_FOUND;
+    }
+    std::shared_ptr<open_pool_t> pool;
+    {
+      /* wait for operations in the pool to finish */
+      writer_lock_t wl(session->writer_mutex());
+      pool = move_pool(p);
+    }
     CPLOG(1, PREFIX "closed pool (%" PRIxIKVSTORE_POOL_T ")", LOCATION, p);
     _pool_manager->pool_close_check(path);
   }
@@ -267,6 +309,7 @@ auto hstore::grow_pool( //
   std::size_t& reconfigured_size ) -> status_t
 {
   const auto session = static_cast<session_t *>(locate_session(pool));
+  auto wl = pool_lock<writer_lock_t>(session);
   if ( ! session )
   {
     return component::IKVStore::E_POOL_NOT_FOUND;
@@ -282,12 +325,26 @@ auto hstore::grow_pool( //
   return S_OK;
 }
 
+auto hstore::configure_pool(
+  const pool_t pool,
+  const std::string &setting) -> status_t
+{
+  const auto session = static_cast<session_t *>(locate_session(pool));
+  auto wl = pool_lock<writer_lock_t>(session);
+  if ( ! session )
+  {
+    return component::IKVStore::E_POOL_NOT_FOUND;
+  }
+  return session->configure(setting);
+}
+
 auto hstore::put(const pool_t pool,
                  const std::string &key,
                  const void * value,
                  const std::size_t value_len,
                  flags_t flags) -> status_t
 {
+  persister_nupm::domain pd;
   CPLOG(
     1
     , PREFIX "(key=%s) (value=%.*s)"
@@ -313,6 +370,7 @@ auto hstore::put(const pool_t pool,
   }
 
   const auto session = static_cast<session_t *>(locate_session(pool));
+  auto wl = pool_lock<writer_lock_t>(session);
 
   if ( session )
   {
@@ -320,7 +378,7 @@ auto hstore::put(const pool_t pool,
     {
       auto i = session->insert(AK_INSTANCE key, value, value_len);
 
-      return
+      const auto r =
         i.second                   ? S_OK
         : flags & FLAGS_DONT_STOMP ? int(component::IKVStore::E_KEY_EXISTS)
         : (
@@ -334,6 +392,11 @@ auto hstore::put(const pool_t pool,
             , S_OK
           )
         ;
+      if ( r == S_OK )
+      {
+        session->time_index_touch(key);
+      }
+      return r;
     }
     catch ( const std::bad_alloc & )
     {
@@ -381,6 +444,7 @@ auto hstore::get(const pool_t pool,
                  std::size_t& out_value_len) -> status_t
 {
   const auto session = static_cast<const session_t *>(locate_session(pool));
+  auto rl = pool_lock<reader_lock_t>(session);
   if ( ! session )
   {
     return component::IKVStore::E_POOL_NOT_FOUND;
@@ -435,6 +499,7 @@ auto hstore::get_direct(const pool_t pool,
                         memory_handle_t) -> status_t
 {
   const auto session = static_cast<const session_t *>(locate_session(pool));
+  auto rl = pool_lock<reader_lock_t>(session);
   if ( ! session )
   {
     return component::IKVStore::E_POOL_NOT_FOUND;
@@ -456,6 +521,33 @@ auto hstore::get_direct(const pool_t pool,
   }
 }
 
+auto hstore::get_optimistic(const pool_t pool,
+                            const string_view key,
+                            void* out_value,
+                            std::size_t& out_value_len) -> status_t
+{
+  const auto session = static_cast<const session_t *>(locate_session(pool));
+  auto rl = pool_lock<reader_lock_t>(session);
+  if ( ! session )
+  {
+    return component::IKVStore::E_POOL_NOT_FOUND;
+  }
+
+  try
+  {
+    const auto buffer_size = out_value_len;
+    if ( ! session->get_optimistic(key, out_value, buffer_size, out_value_len) )
+    {
+      return E_BUSY;
+    }
+    return buffer_size < out_value_len ? E_INSUFFICIENT_BUFFER : S_OK;
+  }
+  catch ( const impl::key_not_found & )
+  {
+    return component::IKVStore::E_KEY_NOT_FOUND;
+  }
+}
+
 auto hstore::get_attribute(
   const pool_t pool,
   const Attribute attr,
@@ -465,6 +557,7 @@ auto hstore::get_attribute(
   out_attr.clear();
 
   const auto session = static_cast<const session_t *>(locate_session(pool));
+  auto rl = pool_lock<reader_lock_t>(session);
   if ( ! session )
   {
     return component::IKVStore::E_POOL_NOT_FOUND;
@@ -544,6 +637,7 @@ auto hstore::set_attribute(
   , const std::string *) -> status_t
 {
   auto session = static_cast<session_t *>(locate_session(pool));
+  auto wl = pool_lock<writer_lock_t>(session);
   if ( ! session )
   {
     return component::IKVStore::E_POOL_NOT_FOUND;
@@ -570,7 +664,9 @@ auto hstore::resize_value(
   , const std::size_t alignment
 ) -> status_t
 {
+  persister_nupm::domain pd;
   const auto session = static_cast<session_t *>(locate_session(pool));
+  auto wl = pool_lock<writer_lock_t>(session);
   try
   {
     return
@@ -609,9 +705,33 @@ auto hstore::lock(
 ) -> status_t
 try
 {
-  const auto session = static_cast<session_t *>(locate_session(pool));
-  if(!session) return E_FAIL;
-  auto r = session->lock(AK_INSTANCE key, type, out_value, out_value_len);
+  lock_result r{};
+  bool shared = false;
+  /* A read lock which cannot create the key, of a key which need not be
+   * pinned, allocates nothing: it need not exclude other readers.
+   */
+  if ( type == STORE_LOCK_READ && out_value_len == 0 )
+  {
+    const auto session = static_cast<session_t *>(locate_session(pool));
+    auto rl = pool_lock<reader_lock_t>(session);
+    if(!session) return E_FAIL;
+    shared = session->lock_read_pinned(key, r);
+  }
+
+  if ( ! shared )
+  {
+    persister_nupm::domain pd;
+    const auto session = static_cast<session_t *>(locate_session(pool));
+    auto wl = pool_lock<writer_lock_t>(session);
+    if(!session) return E_FAIL;
+    r = session->lock(AK_INSTANCE key, type, out_value, out_value_len);
+
+    /* a write lock or a creation updates the key's timestamp */
+    if ( r.key != component::IKVStore::KEY_NONE && ( type == STORE_LOCK_WRITE || r.state == lock_result::e_state::created ) )
+    {
+      session->time_index_touch(key);
+    }
+  }
 
   out_key = r.key;
   if ( out_key_ptr )
@@ -650,10 +770,13 @@ auto hstore::unlock(const pool_t pool,
                     component::IKVStore::key_t key_,
                     component::IKVStore::unlock_flags_t flags_) -> status_t
 {
+  /* unlock neither allocates nor frees */
+  persister_nupm::domain pd;
   /* NOTE: if flags & UNLOCK_FLAGS_PMFLUSH, only flush if the lock held
      is a write lock
   */
   const auto session = static_cast<session_t *>(locate_session(pool));
+  auto rl = pool_lock<reader_lock_t>(session);
   return
     session
     ? session->unlock(key_, flags_)
@@ -665,7 +788,9 @@ auto hstore::erase(const pool_t pool,
                    const std::string &key
                    ) -> status_t
 {
+  persister_nupm::domain pd;
   const auto session = static_cast<session_t *>(locate_session(pool));
+  auto wl = pool_lock<writer_lock_t>(session);
   return session
     ? session->erase(key)
     : component::IKVStore::E_POOL_NOT_FOUND
@@ -675,6 +800,7 @@ auto hstore::erase(const pool_t pool,
 std::size_t hstore::count(const pool_t pool)
 {
   const auto session = static_cast<session_t *>(locate_session(pool));
+  auto rl = pool_lock<reader_lock_t>(session);
   if ( ! session )
   {
     return std::size_t(component::IKVStore::E_POOL_NOT_FOUND);
@@ -683,7 +809,7 @@ std::size_t hstore::count(const pool_t pool)
   return session->count();
 }
 
-void hstore::debug(const pool_t, const unsigned cmd, const uint64_t arg)
+void hstore::debug(const pool_t pool, const unsigned cmd, const uint64_t arg)
 {
   switch ( cmd )
     {
@@ -697,6 +823,40 @@ void hstore::debug(const pool_t, const unsigned cmd, const uint64_t arg)
       {
       }
       break;
+    case 3:
+      /* arg: address of std::uint64_t[4], receives key lookup counts
+       * (lookups, owned buckets, key matches, key mismatches), which are then reset
+       */
+      if ( const auto session = static_cast<session_t *>(locate_session(pool)) )
+      {
+        session->locate_key_stats(*reinterpret_cast<std::uint64_t (*)[4]>(arg));
+      }
+      break;
+    case 4:
+      /* arg: enable (1) or disable (0) the key fingerprint filter */
+      if ( const auto session = static_cast<session_t *>(locate_session(pool)) )
+      {
+        session->set_fingerprint_filter(bool(arg));
+      }
+      break;
+    case 5:
+      /* arg: write (1) or omit (0) the allocation snapshot at close. Without a
+       * snapshot, the next open scans the table, as after a crash.
+       */
+      if ( const auto session = static_cast<session_t *>(locate_session(pool)) )
+      {
+        session->set_snapshot_on_close(bool(arg));
+      }
+      break;
+    case 6:
+      /* arg: address of std::uint64_t[3], receives the table's resize state
+       * (bucket count, resize in preparation, senior owners yet to migrate)
+       */
+      if ( const auto session = static_cast<session_t *>(locate_session(pool)) )
+      {
+        session->resize_state(*reinterpret_cast<std::uint64_t (*)[3]>(arg));
+      }
+      break;
     default:
       break;
     };
@@ -712,6 +872,7 @@ auto hstore::map(
                  ) -> status_t
 {
   const auto session = static_cast<session_t *>(locate_session(pool));
+  auto rl = pool_lock<reader_lock_t>(session);
 
   return session
     ? ( session->map(f_), S_OK )
@@ -735,6 +896,7 @@ auto hstore::map(
 ) -> status_t
 {
   const auto session = static_cast<session_t *>(locate_session(pool_));
+  auto rl = pool_lock<reader_lock_t>(session);
 
   return session
     ? ( session->map(f_, t_begin_, t_end_) ? S_OK : E_NOT_SUPPORTED )
@@ -751,6 +913,7 @@ auto hstore::map_keys(
                  ) -> status_t
 {
   const auto session = static_cast<session_t *>(locate_session(pool));
+  auto rl = pool_lock<reader_lock_t>(session);
 
   return session
     ? ( session->map([&f_] (const void * key, std::size_t key_len,
@@ -776,11 +939,13 @@ auto hstore::atomic_update(
 	, const bool take_lock) -> status_t
 try
 {
+  persister_nupm::domain pd;
   const auto update_method = take_lock ? &session_t::lock_and_atomic_update : &session_t::atomic_update;
   const auto session = static_cast<session_t *>(locate_session(pool));
+  auto wl = pool_lock<writer_lock_t>(session);
   return
     session
-    ? ( (session->*update_method)(AK_INSTANCE key, op_vector), S_OK )
+    ? ( (session->*update_method)(AK_INSTANCE key, op_vector), session->time_index_touch(key), S_OK )
     : int(component::IKVStore::E_POOL_NOT_FOUND)
     ;
 }
@@ -812,12 +977,20 @@ auto hstore::swap_keys(
 ) -> status_t
 try
 {
+  persister_nupm::domain pd;
   const auto session = static_cast<session_t *>(locate_session(pool));
-  return
-    session
-    ? session->swap_keys(AK_INSTANCE key0, key1)
-    : int(component::IKVStore::E_POOL_NOT_FOUND)
-    ;
+  auto wl = pool_lock<writer_lock_t>(session);
+  if ( ! session )
+  {
+    return component::IKVStore::E_POOL_NOT_FOUND;
+  }
+  const auto r = session->swap_keys(AK_INSTANCE key0, key1);
+  if ( r == S_OK )
+  {
+    session->time_index_touch(key0);
+    session->time_index_touch(key1);
+  }
+  return r;
 }
 catch ( const std::bad_alloc & )
 {
@@ -833,6 +1006,7 @@ auto hstore::allocate_pool_memory(
 try
 {
   const auto session = static_cast<session_t *>(locate_session(pool));
+  auto wl = pool_lock<writer_lock_t>(session);
   return
     session
     ? ( out_addr = session->allocate_memory(AK_INSTANCE size, alignment), S_OK )
@@ -856,6 +1030,7 @@ auto hstore::free_pool_memory(
 try
 {
   const auto session = static_cast<session_t *>(locate_session(pool));
+  auto wl = pool_lock<writer_lock_t>(session);
   return
     session
     ? ( session->free_memory(addr, size), S_OK )
@@ -914,7 +1089,9 @@ status_t hstore::deref_pool_iterator(
   , bool increment
 )
 {
+  /* a time-constrained dereference reads _time_index, which writers change */
   const auto session = static_cast<session_t *>(locate_session(pool));
+  auto rl = pool_lock<reader_lock_t>(session);
   return
     session
     ? session->deref_iterator(
@@ -942,3 +1119,25 @@ status_t  hstore::close_pool_iterator(
     ;
 }
 
+status_t hstore::ioctl(const std::string& command)
+{
+#if USE_CC_HEAP == 4
+  /* The crash-consistent heap keeps allocation logs of its own, which
+   * are not group aware: its fences stay per operation.
+   */
+  (void) command;
+  return E_NOT_SUPPORTED;
+#else
+  if ( command == "persist_group_open" )
+  {
+    persister_nupm::group_open();
+    return S_OK;
+  }
+  if ( command == "persist_group_commit" )
+  {
+    persister_nupm::group_commit();
+    return S_OK;
+  }
+  return E_NOT_SUPPORTED;
+#endif
+}
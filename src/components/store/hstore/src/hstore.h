@@ -19,7 +19,7 @@
 
 #if THREAD_SAFE_HASH == 1
 /* thread-safe hash */
-#include <mutex>
+#include <shared_mutex>
 #else
 /* not a thread-safe hash */
 #include "dummy_shared_mutex.h"
@@ -82,6 +82,26 @@ private:
   static constexpr auto is_thread_safe = false;
 #endif
 
+#if THREAD_SAFE_HASH == 1
+  /* hop_hash locks its own buckets, but a pool's heap and its crash-consistency
+   * (emplace, pin, extend, atomic update) state are single, per pool, and not
+   * locked. Operations which may allocate or free in a pool take that pool's
+   * writer mutex uniquely; others share it. Operations on different pools do
+   * not contend.
+   */
+  using writer_lock_t = std::unique_lock<hstore_shared_mutex>;
+  using reader_lock_t = std::shared_lock<hstore_shared_mutex>;
+#else
+  struct no_lock
+  {
+    no_lock() {}
+    explicit no_lock(hstore_shared_mutex &) {}
+    ~no_lock() {} /* a guard, like the locks it stands in for */
+  };
+  using writer_lock_t = no_lock;
+  using reader_lock_t = no_lock;
+#endif
+
   using table_t =
     hop_hash<
       key_t
@@ -171,6 +191,9 @@ public:
                              std::size_t increment_size,
                              std::size_t& reconfigured_size ) override;
 
+  status_t configure_pool(pool_t pool,
+                          const std::string &setting) override;
+
   status_t put(pool_t pool,
                const std::string &key,
                const void * value,
@@ -195,6 +218,11 @@ public:
                       std::size_t& out_value_len,
                       component::IKVStore::memory_handle_t handle) override;
 
+  status_t get_optimistic(pool_t pool,
+                          string_view key,
+                          void* out_value,
+                          std::size_t& out_value_len) override;
+
   status_t get_attribute(pool_t pool,
                                  Attribute attr,
                                  std::vector<uint64_t>& out_attr,
@@ -308,6 +336,12 @@ public:
     pool_t pool
     , pool_iterator_t iter
   ) override;
+
+  /* "persist_group_open", "persist_group_commit": defer the persistence
+   * fences of operations on the calling thread to a single group commit.
+   * Not supported with the crash-consistent heap (hstore-cc, hstore-mt).
+   */
+  status_t ioctl(const std::string& command) override;
 };
 
 struct hstore_factory : public component::IKVStore_factory
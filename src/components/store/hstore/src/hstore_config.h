@@ -28,7 +28,17 @@
 #define USE_CC_HEAP 3
 #endif
 
+/*
+ *   THREAD_SAFE_HASH 1: per-bucket shared_timed_mutex locking; pools may be used by
+ *   several threads at once (THREAD_MODEL_MULTI_PER_POOL). Built as component-hstore-mt.
+ */
+
+#if defined MCAS_HSTORE_THREAD_SAFE_HASH
+#define THREAD_SAFE_HASH MCAS_HSTORE_THREAD_SAFE_HASH
+#else
 #define THREAD_SAFE_HASH 0
+#endif
+
 #define PREFIX_STATIC "HSTORE %s %s:%d "
 #define LOCATION_STATIC __func__, __FILE__, __LINE__
 #define PREFIX PREFIX_STATIC "%p "
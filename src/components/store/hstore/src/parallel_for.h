@@ -0,0 +1,91 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+
+#ifndef MCAS_HSTORE_PARALLEL_FOR_H
+#define MCAS_HSTORE_PARALLEL_FOR_H
+
+#include <algorithm> /* max, min */
+#include <atomic>
+#include <cstddef> /* size_t */
+#include <cstdlib> /* getenv, strtoul */
+#include <exception> /* exception_ptr */
+#include <thread>
+#include <vector>
+
+/*
+ * Work sharing for the long, one-time scans of a pool: reconstitution at
+ * open, and the allocation snapshot at close.
+ */
+
+namespace impl
+{
+	/* Threads to use for work_count_ work items: one per CPU, but no more than
+	 * the items. The CPU count may be overridden by the environment variable
+	 * HSTORE_SCAN_THREADS.
+	 */
+	inline unsigned parallel_thread_count(std::size_t work_count_)
+	{
+		const auto e = std::getenv("HSTORE_SCAN_THREADS");
+		const auto cpus = e ? unsigned(std::strtoul(e, nullptr, 0)) : std::thread::hardware_concurrency();
+		return unsigned(std::max(std::size_t(1), std::min(work_count_, std::size_t(cpus))));
+	}
+
+	/* Call f_(t, i) for each i in [0, work_count_), where t in [0, thread_count_)
+	 * identifies the calling thread. Items are claimed one at a time, so items
+	 * need not be of equal cost. The first exception thrown by any f_ is
+	 * rethrown after all threads finish.
+	 */
+	template <typename F>
+		void parallel_for(std::size_t work_count_, unsigned thread_count_, F f_)
+		{
+			std::atomic<std::size_t> next(0);
+			std::vector<std::exception_ptr> ex(thread_count_);
+			auto work =
+				[&next, &ex, &f_, work_count_] (unsigned t_)
+				{
+					try
+					{
+						for ( auto i = next++; i < work_count_; i = next++ )
+						{
+							f_(t_, i);
+						}
+					}
+					catch ( ... )
+					{
+						ex[t_] = std::current_exception();
+						next = work_count_;
+					}
+				};
+
+			std::vector<std::thread> threads;
+			for ( unsigned t = 1; t < thread_count_; ++t )
+			{
+				threads.emplace_back(work, t);
+			}
+			work(0);
+			for ( auto &th : threads )
+			{
+				th.join();
+			}
+			for ( const auto &e : ex )
+			{
+				if ( e )
+				{
+					std::rethrow_exception(e);
+				}
+			}
+		}
+}
+
+#endif
@@ -85,11 +85,17 @@ namespace impl
 			std::size_t _bucket_count_cached;
 
 			void persist_segment_table(); /* Flush the bucket pointers (*_b) */
+			void resize_release_abandoned();
 			void persist_internal(
 				const void *first
 				, const void *last
 				, const char *what
 			);
+			void flush_internal(
+				const void *first
+				, const void *last
+				, const char *what
+			);
 			auto bucket_count_uncached() -> size_type
 			{
 				return base_segment_size << (segment_count_actual().value_not_stable() - 1U);
@@ -106,9 +112,12 @@ namespace impl
 			) -> persist_controller & = delete;
 
 			auto resize_prolog(AK_FORMAL0) -> bucket_aligned_t *;
+			void resize_construct(bix_t first, bix_t last);
 			auto resize_restart_prolog() -> bucket_aligned_t *;
 			void resize_interlog();
-			void resize_epilog();
+			void resize_switch();
+			void resize_migrate_epilog();
+			bool resize_is_switched() const;
 
 			void size_stabilize();
 			void size_destabilize();
@@ -121,10 +130,22 @@ namespace impl
 				const content_t &b
 				, const char *what = "bucket_content"
 			);
+			/* Write back only: for an owner or content durable by the next
+			 * persist of the operation, with no dependent store before it.
+			 */
+			void flush_owner(
+				const owner &b
+				, const char *what = "bucket_owner"
+			);
+			void flush_content(
+				const content_t &b
+				, const char *what = "bucket_content"
+			);
 			void persist_segment_count(); /* Flush the bucket pointer count (_count) */
 			void persist_size();
 			void persist_existing_segments(const char *what = "old segments");
 			void persist_new_segment(const char *what = "new segments");
+			void persist_segment_prefixes(bix_t n, const char *what = "segment prefixes");
 			void em_record_owner_addr_and_bitmask(
 				persistent_atomic_t<owner::value_type> *pmask_
 				, owner::value_type mask_
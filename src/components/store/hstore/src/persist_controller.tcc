@@ -12,6 +12,7 @@
 */
 
 #include "hstore_config.h"
+#include "monitor_emplace.h"
 
 /*
  * Hopscotch hash table - template Key, Value, and allocators
@@ -58,6 +59,7 @@ template <typename Allocator>
 			_persist->reconstitute(av_);
 		}
 #endif
+		resize_release_abandoned();
 	}
 
 template <typename Allocator>
@@ -98,6 +100,26 @@ template <typename Allocator>
 		persist_internal(&ba, &ba + 1U, why_);
 	}
 
+template <typename Allocator>
+	void impl::persist_controller<Allocator>::flush_owner(
+		const owner &c_
+		, const char *why_
+	)
+	{
+		flush_internal(&c_, &c_ + 1U, why_);
+	}
+
+template <typename Allocator>
+	void impl::persist_controller<Allocator>::flush_content(
+		const content_t &c_
+		, const char *why_
+	)
+	{
+		auto &hb = static_cast<const hash_bucket<value_type> &>(c_);
+		auto &ba = static_cast<const bucket_aligned_t &>(hb);
+		flush_internal(&ba, &ba + 1U, why_);
+	}
+
 template <typename Allocator>
 	void impl::persist_controller<Allocator>::persist_internal(
 		const void *first_
@@ -108,6 +130,16 @@ template <typename Allocator>
 		this->Allocator::persist(first_, std::size_t(static_cast<const char *>(last_) - static_cast<const char *>(first_)));
 	}
 
+template <typename Allocator>
+	void impl::persist_controller<Allocator>::flush_internal(
+		const void *first_
+		, const void *last_
+		, const char * // what_
+	)
+	{
+		this->Allocator::flush(first_, std::size_t(static_cast<const char *>(last_) - static_cast<const char *>(first_)));
+	}
+
 template <typename Allocator>
 	void impl::persist_controller<Allocator>::persist_existing_segments(const char *)
 	{
@@ -142,6 +174,24 @@ template <typename Allocator>
 		);
 	}
 
+/* Flush the first n buckets of segment 0 and of the junior segment:
+ * the buckets touched by the bounded resize passes.
+ */
+template <typename Allocator>
+	void impl::persist_controller<Allocator>::persist_segment_prefixes(bix_t n_, const char *)
+	{
+		auto sc = &*_persist->_sc;
+		assert(n_ <= base_segment_size);
+		{
+			auto bp = &*sc[0].bp;
+			persist_internal(&bp[0], &bp[n_], "segment 0 prefix");
+		}
+		{
+			auto bp = &*sc[segment_count_actual().value_not_stable()].bp;
+			persist_internal(&bp[0], &bp[n_], "segment new prefix");
+		}
+	}
+
 template <typename Allocator>
 	void impl::persist_controller<Allocator>::persist_segment_table()
 	{
@@ -186,7 +236,15 @@ template <typename Allocator>
 	void impl::persist_controller<Allocator>::size_stabilize()
 	{
 		_persist->_size_control.stabilize();
-		persist_size();
+		/* Nothing is ordered after the stable size within the operation,
+		 * which may therefore leave it to the commit of its persistence domain.
+		 * Until then a crash finds the size unstable, and recounts it.
+		 */
+		flush_internal(
+			&_persist->_size_control
+			, (&_persist->_size_control)+1U
+			, "size stable"
+		);
 	}
 
 template <typename Allocator>
@@ -194,24 +252,39 @@ template <typename Allocator>
 		AK_ACTUAL0
 	) -> bucket_aligned_t *
 	{
-		persistent_t<typename std::allocator_traits<bucket_allocator_t>::pointer> ptr = nullptr;
-
+		/* Allocated in place, so that a junior segment abandoned by a close or
+		 * crash before the switch is found, and released, by the next open.
+		 */
+		auto &bp = _persist->_sc[segment_count_actual().value()].bp;
 		{
 #if USE_CC_HEAP == 4
 			monitor_extend<Allocator> m(bucket_allocator_t{*this});
 #endif
 			bucket_allocator_t(*this).allocate(
 				AK_REF
-				ptr
+				bp
 				, bucket_count()
 				, alignof(bucket_aligned_t)
 			);
 		}
 
-		new (&*ptr) typename persist_data_t::bucket_aligned_t[bucket_count()];
-		_persist->_sc[_persist->_segment_count.actual().value()].bp = ptr;
+		/* The buckets are constructed later, by resize_construct */
+		return &*bp;
+	}
+
+template <typename Allocator>
+	void impl::persist_controller<Allocator>::resize_construct(
+		bix_t first_
+		, bix_t last_
+	)
+	{
 		auto sc = &*_persist->_sc;
-		return &*(sc[segment_count_actual().value()].bp);
+		auto bp = &*sc[segment_count_actual().value()].bp;
+		for ( auto i = first_; i != last_; ++i )
+		{
+			new (&bp[i]) typename persist_data_t::bucket_aligned_t;
+		}
+		persist_internal(&bp[first_], &bp[last_], "segment new (construct)");
 	}
 
 template <typename Allocator>
@@ -230,10 +303,59 @@ template <typename Allocator>
 		persist_segment_count();
 	}
 
+/* The construction of a junior segment is not persistent: a close or crash
+ * before resize_interlog leaves the count stable, and a segment allocated at
+ * index "actual". Resize starts over, so release that segment.
+ */
+template <typename Allocator>
+	void impl::persist_controller<Allocator>::resize_release_abandoned()
+	{
+		const auto ct = segment_count_actual().value_not_stable();
+		if ( segment_count_actual().is_stable() && ct != _segment_capacity && _persist->_sc[ct].bp )
+		{
+			auto &bp = _persist->_sc[ct].bp;
+#if USE_CC_HEAP == 4
+			monitor_emplace<Allocator> m(*this);
+			bucket_allocator_t(*this).deallocate(bp, bucket_count());
+#else
+			/* The heap was reconstituted from the segments of the table only:
+			 * it already counts the junior segment as free.
+			 */
+			bp = nullptr;
+#endif
+			persist_internal(&bp, &bp + 1U, "segment abandoned");
+		}
+	}
+
+/* Incremental resize: the junior segment becomes part of the table, but
+ * the count remains "unstable" until every senior owner has been migrated.
+ */
 template <typename Allocator>
-	void impl::persist_controller<Allocator>::resize_epilog()
+	void impl::persist_controller<Allocator>::resize_switch()
 	{
-		_persist->_segment_count.actual_value_set_stable(_persist->_segment_count.actual().value_not_stable() + 1U);
+		_persist->_segment_count.actual_incr();
 		_bucket_count_cached = bucket_count_uncached();
 		persist_segment_count();
 	}
+
+template <typename Allocator>
+	void impl::persist_controller<Allocator>::resize_migrate_epilog()
+	{
+		_persist->_segment_count.actual_stabilize();
+		persist_segment_count();
+	}
+
+/* Before the switch, the junior segment is allocated at index "actual".
+ * After the switch, the junior segment is at index "actual" - 1, and
+ * nothing is allocated at index "actual".
+ */
+template <typename Allocator>
+	bool impl::persist_controller<Allocator>::resize_is_switched() const
+	{
+		const auto ct = segment_count_actual().value_not_stable();
+		return
+			! segment_count_actual().is_stable()
+			&&
+			( ct == _segment_capacity || ! _persist->_sc[ct].bp )
+			;
+	}
@@ -25,12 +25,15 @@
 #include "persistent.h"
 #include "perishable_expiry.h"
 
+#include <sys/uio.h> /* iovec */
+
 #include <algorithm> /* fill_n, copy */
 #include <array>
 #include <cassert>
 #include <cstddef> /* size_t */
 #include <cstring> /* memcpy */
 #include <memory> /* allocator_traits */
+#include <vector>
 
 struct fixed_data_location_t {};
 constexpr fixed_data_location_t fixed_data_location = fixed_data_location_t();
@@ -55,6 +58,34 @@ template <typename T, std::size_t SmallLimit, typename Allocator>
 
 		using ptr_t = persistent_t<typename allocator_traits_type::pointer>;
 
+		template <typename IT, typename AL>
+			static void construct_flush(
+				element_type *p_
+				, IT first_
+				, IT last_
+				, std::size_t fill_len_
+				, std::size_t alignment_
+				, const AL &al_
+			)
+			{
+				new (p_) element_type(first_, last_, fill_len_, alignment_);
+				p_->flush_this(al_);
+			}
+
+		/* contiguous source: the copy may use non-temporal stores */
+		template <typename AL>
+			static void construct_flush(
+				element_type *p_
+				, const T *first_
+				, const T *last_
+				, std::size_t fill_len_
+				, std::size_t alignment_
+				, const AL &al_
+			)
+			{
+				new (p_) element_type(first_, last_, fill_len_, alignment_, al_);
+			}
+
 		struct small_t
 		{
 			std::array<char, SmallLimit-1> value;
@@ -164,10 +195,8 @@ template <typename T, std::size_t SmallLimit, typename Allocator>
 							+ data_size
 						, alignment_
 					);
-					new (ptr())
-						element_type(first_, last_, fill_len_, alignment_);
+					construct_flush(ptr(), first_, last_, fill_len_, alignment_, al_);
 					new (&al()) allocator_char_type(al_);
-					ptr()->persist_this(al_);
 				}
 
 			void clear()
@@ -280,9 +309,7 @@ template <typename T, std::size_t SmallLimit, typename Allocator>
 							+ data_size
 						, alignment_
 					);
-					new (large.ptr())
-						element_type(first_, last_, fill_len_, alignment_);
-					large.ptr()->persist_this(al_);
+					construct_flush(large.ptr(), first_, last_, fill_len_, alignment_, al_);
 				}
 			}
 
@@ -578,21 +605,25 @@ template <typename T, std::size_t SmallLimit, typename Allocator>
 			}
 		}
 
-		void deconstitute() const
+		/* Used only at a clean close, to list the allocation for the heap snapshot.
+		 * The string is left as the next open will find it: unlocked, and with
+		 * its reference count intact, as no reconstitute will restore it.
+		 */
+		void deconstitute(std::vector<::iovec> &found_) const
 		{
 #if USE_CC_HEAP == 3
 			if ( ! is_inline() )
 			{
-				/* used only by the table_base destructor, at which time
-				 * the reference count should be 1. There is not much point
-				 * in decreasing the reference count except to mirror
-				 * reconstitute.
-				 */
-				if ( large.ptr()->dec_ref(__LINE__, "deconstitute") == 0 )
+				const auto e = large.ptr();
+				found_.push_back(::iovec{e, e->alloc_element_count() * sizeof(T)});
+				if ( e->is_locked() || e->ref_count() != 1U )
 				{
-					large.al().~allocator_char_type();
+					e->reset_lock();
+					large.al().flush(e, sizeof *e);
 				}
 			}
+#else
+			(void) found_;
 #endif
 		}
 
@@ -636,6 +667,35 @@ template <typename T, std::size_t SmallLimit, typename Allocator>
 				}
 			}
 
+#if USE_CC_HEAP == 3
+		/* Reconstitution by several threads. First (in parallel), restore the
+		 * allocator and list the allocation. Then (serially) inject the listed
+		 * allocations, without duplicates. Finally (in parallel) reset each
+		 * allocation by reconstitute_element, with the number of references
+		 * found to it.
+		 */
+		template <typename AL>
+			void reconstitute_scan(AL al_, std::vector<::iovec> &found_)
+			{
+				if ( ! is_inline() )
+				{
+					new (&const_cast<persist_fixed_string *>(this)->large.al()) allocator_char_type(al_);
+					const auto e = large.ptr();
+					found_.push_back(::iovec{e, e->alloc_element_count() * sizeof(T)});
+				}
+			}
+
+		static void reconstitute_element(const ::iovec &e_, unsigned ref_count_)
+		{
+			const auto e = static_cast<element_type *>(e_.iov_base);
+			new (e) element_type( e->size(), e->alignment() );
+			for ( ; 1U < ref_count_; --ref_count_ )
+			{
+				e->inc_ref(__LINE__, "reconstitute");
+			}
+		}
+#endif
+
 		bool is_inline() const
 		{
 			return small.is_inline();
@@ -691,6 +751,7 @@ template <typename T, std::size_t SmallLimit, typename Allocator>
 		bool try_lock_shared() const { return lockable() && large.ptr()->try_lock_shared(); }
 		bool try_lock_exclusive() const { return lockable() && large.ptr()->try_lock_exclusive(); }
 		bool is_locked() const { return lockable() && large.ptr()->is_locked(); }
+		bool is_locked_exclusive() const { return lockable() && large.ptr()->is_locked_exclusive(); }
 		template <typename AL>
 			void flush_if_locked_exclusive(AL al_) const
 			{
@@ -699,7 +760,7 @@ template <typename T, std::size_t SmallLimit, typename Allocator>
 #if 0
 					PLOG("FLUSH %p: %zu", large.ptr()->data(), large.ptr()->size());
 #endif
-					large.ptr()->persist_this(al_);
+					large.ptr()->flush_this(al_);
 				}
 				else
 				{
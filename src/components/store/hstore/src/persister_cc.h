@@ -16,12 +16,15 @@
 #define COMANCHE_HSTORE_PERSISTER_H
 
 #include <cstddef> /* size_t */
+#include <cstring> /* memcpy */
 
 /* default "persister" for persistent memory: a no-op.
  */
 struct persister
 {
   void persist(const void *, std::size_t) {}
+  void flush(const void *, std::size_t) {}
+  void memcpy_flush(void *dst, const void *src, std::size_t sz) { std::memcpy(dst, src, sz); }
 };
 
 #endif
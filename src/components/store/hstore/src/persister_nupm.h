@@ -23,14 +23,95 @@
 #include <libpmem.h>
 #pragma GCC diagnostic pop
 
+#include <nupm/memcpy_persist.h>
+
 #include <cstddef>
 
+/*
+ * Persistence domains.
+ *
+ * persist is an ordering point: the range, and every range flushed before
+ * it, is durable when it returns. flush only writes the range back; within
+ * a domain, the range becomes durable at the next ordering point or, at
+ * the latest, when the outermost domain on the thread commits. Outside any
+ * domain flush is the same as persist.
+ *
+ * An operation opens a domain, so that its trailing flushes share one
+ * fence. A caller which opens a group around several operations (a shard
+ * batch) defers those fences to the group commit.
+ */
 struct persister_nupm
 {
+private:
+	struct domain_state
+	{
+		unsigned depth;
+		bool pending;
+	};
+	static domain_state &state()
+	{
+		static thread_local domain_state s{0U, false};
+		return s;
+	}
+public:
 	static void persist(const void * a, std::size_t sz)
 	{
 		pmem_persist(a,sz);
+		state().pending = false;
 	}
+
+	static void flush(const void * a, std::size_t sz)
+	{
+		auto &s = state();
+		if ( s.depth == 0U )
+		{
+			pmem_persist(a,sz);
+		}
+		else
+		{
+			pmem_flush(a,sz);
+			s.pending = true;
+		}
+	}
+
+	/* copy to persistent memory, then flush the copy */
+	static void memcpy_flush(void * dst, const void * src, std::size_t sz)
+	{
+		auto &s = state();
+		if ( s.depth == 0U )
+		{
+			nupm::memcpy_persist(dst, src, sz);
+		}
+		else
+		{
+			nupm::memcpy_nodrain(dst, src, sz);
+			s.pending = true;
+		}
+	}
+
+	static void group_open()
+	{
+		++state().depth;
+	}
+
+	static void group_commit()
+	{
+		auto &s = state();
+		if ( --s.depth == 0U && s.pending )
+		{
+			pmem_drain();
+			s.pending = false;
+		}
+	}
+
+	/* The domain of a single operation */
+	struct domain
+	{
+		domain() { group_open(); }
+		domain(const domain &) = delete;
+		domain &operator=(const domain &) = delete;
+		~domain() { group_commit(); }
+	};
 };
 
 #endif
@@ -15,6 +15,8 @@
 #define _MCAS_PSTR_EQUAL_H_
 
 #include <cstring>
+#include <experimental/string_view>
+#include <string>
 
 template <typename Key>
   struct pstr_equal
@@ -29,6 +31,10 @@ template <typename Key>
     {
       return a.size() == b.size() && 0 == std::memcmp(a.data(), b.data(), a.size());
     }
+    result_type operator()(const argument_type &a, const std::experimental::string_view &b) const
+    {
+      return a.size() == b.size() && 0 == std::memcmp(a.data(), b.data(), a.size());
+    }
   };
 
 #endif
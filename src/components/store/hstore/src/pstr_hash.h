@@ -16,6 +16,9 @@
 
 #include <city.h>
 
+#include <experimental/string_view>
+#include <string>
+
 template <typename Key>
   struct pstr_hash
   {
@@ -35,6 +38,10 @@ template <typename Key>
     {
       return CityHash64(s.data(), s.size());
     }
+    static result_type hf(const std::experimental::string_view &s)
+    {
+      return CityHash64(s.data(), s.size());
+    }
   };
 
 #endif
@@ -30,7 +30,7 @@ template <typename PersistData, typename Heap, typename HeapAllocator>
   struct region
   {
   private:
-    static constexpr std::uint64_t magic_value = HeapAllocator::magic_value; // 0xc74892d72eed493a;
+    static constexpr std::uint64_t magic_value = HeapAllocator::magic_value; // 0xc74892d72eed493b;
   public:
     using heap_type = Heap;
     using persist_data_type = PersistData;
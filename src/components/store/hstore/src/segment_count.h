@@ -44,6 +44,7 @@ namespace impl
 		auto specified() const { return _specified; }
 		void actual_destabilize() { _actual.destabilize(); }
 		void actual_incr() { _actual.incr(); }
+		void actual_stabilize() { _actual.stabilize(); }
 		void actual_value_set_stable(segment_layout::six_t v) { _actual.value_set_stable(v); }
 	};
 }
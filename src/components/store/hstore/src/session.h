@@ -32,6 +32,8 @@
 #pragma GCC diagnostic pop
 #include <common/logging.h>
 #include <common/time.h>
+#include <common/time_index.h>
+#include <atomic> /* atomic_thread_fence */
 #include <limits>
 #include <map>
 #include <memory>
@@ -75,6 +77,11 @@ template <typename Handle, typename Allocator, typename Table, typename LockType
 		impl::atomic_controller<table_t> _atomic_state;
 		std::uint64_t _writes;
 		std::map<pool_iterator *, std::shared_ptr<pool_iterator>> _iterators;
+		bool _snapshot_on_close;
+		/* optional, volatile index of keys by last write time (configure "AddIndex::Time") */
+		std::unique_ptr<common::Time_index> _time_index;
+		/* held uniquely by operations which may allocate or free in this pool (see hstore.h) */
+		mutable typename table_t::mutex_type _writer_mutex;
 
 		struct pool_iterator
 			: public component::IKVStore::Opaque_pool_iterator
@@ -92,10 +99,19 @@ template <typename Handle, typename Allocator, typename Table, typename LockType
 				: _mark(session_->writes())
 				, _end(session_->map().end())
 				, _iter(session_->map().begin())
+				, _fresh(true)
+				, _windowed(false)
+				, _window()
+				, _window_pos(0)
 			{}
 
 			bool is_end() const { return _iter == _end; }
 			bool check_mark(std::uint64_t writes) const { return _mark == writes; }
+			/* set on first deref: iterate keys from the time index rather than the table */
+			bool _fresh;
+			bool _windowed;
+			std::vector<std::string> _window;
+			std::size_t _window_pos;
 		};
 
 		struct lock_impl
@@ -241,9 +257,13 @@ template <typename Handle, typename Allocator, typename Table, typename LockType
 			, _atomic_state(*persist_data_, _map)
 			, _writes(0)
 			, _iterators()
+			, _snapshot_on_close(true)
+			, _time_index()
+			, _writer_mutex()
 		{}
 
 		auto writes() const { return _writes; }
+		auto &writer_mutex() const { return _writer_mutex; }
 
 		explicit session(
 			AK_ACTUAL
@@ -263,10 +283,28 @@ template <typename Handle, typename Allocator, typename Table, typename LockType
 			, _atomic_state(this->pool()->persist_data()._persist_atomic, _map, mode_)
 			, _writes(0)
 			, _iterators()
+			, _snapshot_on_close(true)
+			, _time_index()
+			, _writer_mutex()
 		{}
 
 		~session()
 		{
+#if USE_CC_HEAP == 3
+			/* Record the table's allocations, so that the next open need not scan the table */
+			try
+			{
+				std::vector<::iovec> extents;
+				if ( _snapshot_on_close && _map.deconstitute(extents) )
+				{
+					_heap.pool()->snapshot_write(extents);
+				}
+			}
+			catch ( const std::exception &e )
+			{
+				PLOG(PREFIX "no allocation snapshot: %s", LOCATION, e.what());
+			}
+#endif
 #if USE_CC_HEAP == 3 || USE_CC_HEAP == 4
 			this->pool()->quiesce();
 #endif
@@ -469,6 +507,41 @@ template <typename Handle, typename Allocator, typename Table, typename LockType
 			return value_len;
 		}
 
+		/*
+		 * Copy a value without locking it. The value's lock word serves as
+		 * its version: an exclusive lock means that a (direct) write may be
+		 * in progress. Any other change to the value or its location, and
+		 * an exclusive lock, requires the pool's writer lock, which the
+		 * caller holds shared. Returns false, copying nothing, if the value is being
+		 * written.
+		 */
+		auto get_optimistic(
+			const component::IKVStore::string_view key
+			, void* buffer
+			, const std::size_t buffer_size
+			, std::size_t &value_len
+		) const -> bool
+		{
+			const auto &d = std::get<0>(map().at(key));
+			if ( d.is_locked_exclusive() )
+			{
+				return false;
+			}
+			value_len = d.size();
+			if ( value_len <= buffer_size )
+			{
+				const auto data = d.data();
+				std::memcpy(buffer, data, value_len);
+				/* loads of the value precede the validating loads */
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if ( d.is_locked_exclusive() || d.data() != data || d.size() != value_len )
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
 		auto get_alloc(
 			const std::string &key
 		) const -> std::tuple<void *, std::size_t>
@@ -659,6 +732,41 @@ template <typename Handle, typename Allocator, typename Table, typename LockType
 			}
 		}
 
+		/*
+		 * A read lock of an extant key, or the report that it is absent,
+		 * which needs no allocation and so may be taken while other threads
+		 * share the store. Returns false if the key or its value must first
+		 * be pinned, which only lock may do.
+		 */
+		bool lock_read_pinned(
+			const std::string &key
+			, lock_result &r
+		)
+		{
+			auto it = this->map().find(key);
+			if ( it == this->map().end() )
+			{
+				r = { lock_result::e_state::not_created, component::IKVStore::KEY_NONE, nullptr, 0, nullptr };
+				return true;
+			}
+			const key_t &k = it->first;
+			auto &d = std::get<0>(it->second);
+			if ( ! k.is_fixed() || ! d.is_fixed() )
+			{
+				return false;
+			}
+			r = {
+				lock_result::e_state::extant
+				, try_lock(d, component::IKVStore::STORE_LOCK_READ)
+					? new lock_impl(key)
+					: component::IKVStore::KEY_NONE
+				, d.data_fixed()
+				, d.size()
+				, k.data_fixed()
+			};
+			return true;
+		}
+
 		auto unlock(component::IKVStore::key_t key_, component::IKVStore::unlock_flags_t flags_) -> status_t
 		{
 			if ( key_ )
@@ -712,6 +820,105 @@ template <typename Handle, typename Allocator, typename Table, typename LockType
 			this->map().set_auto_resize(auto_resize);
 		}
 
+		bool set_fingerprint_filter(bool fingerprint_filter)
+		{
+			return this->map().set_fingerprint_filter(fingerprint_filter);
+		}
+
+		void locate_key_stats(std::uint64_t (&stats)[4])
+		{
+			this->map().locate_key_stats(stats);
+		}
+
+		void resize_state(std::uint64_t (&state)[3]) const
+		{
+			this->map().resize_state(state);
+		}
+
+		void set_snapshot_on_close(bool snapshot_on_close)
+		{
+			_snapshot_on_close = snapshot_on_close;
+		}
+
+		auto configure(
+			const std::string &setting
+		) -> status_t
+		{
+#if ENABLE_TIMESTAMPS
+			if ( setting == "AddIndex::Time" )
+			{
+				if ( ! _time_index )
+				{
+					auto ix = std::make_unique<common::Time_index>();
+					for ( const auto &mt : this->map() )
+					{
+						const auto &pstring = mt.first;
+						ix->touch(
+							std::string(reinterpret_cast<const char *>(pstring.data()), pstring.size())
+							, std::get<1>(mt.second).raw()
+						);
+					}
+					_time_index = std::move(ix);
+				}
+				return S_OK;
+			}
+			if ( setting == "RemoveIndex::Time" )
+			{
+				_time_index.reset();
+				return S_OK;
+			}
+#endif
+			return E_BAD_PARAM;
+		}
+
+		/* Record the current timestamp of key in the time index, if any */
+		void time_index_touch(
+			const std::string &key
+		)
+		{
+#if ENABLE_TIMESTAMPS
+			if ( _time_index )
+			{
+				auto it = this->map().find(key);
+				if ( it != this->map().end() )
+				{
+					_time_index->touch(key, std::get<1>(it->second).raw());
+				}
+			}
+#else
+			(void) key;
+#endif
+		}
+
+		/* The time window [t_begin, t_end] as keys from the time index.
+		 * False if there is no index, or if the window is unconstrained
+		 * (a scan of the table is as good).
+		 */
+		bool time_index_window(
+			const common::epoch_time_t t_begin
+			, const common::epoch_time_t t_end
+			, std::vector<std::string> &keys_
+		) const
+		{
+#if ENABLE_TIMESTAMPS
+			if ( _time_index && ! ( t_begin.is_defined() && t_end.is_defined() ) )
+			{
+				using raw_t = common::Time_index::time_type;
+				keys_ =
+					_time_index->keys_in_range(
+						t_begin.is_defined() ? std::numeric_limits<raw_t>::min() : impl::epoch_to_tsc(t_begin).raw()
+						, t_end.is_defined() ? std::numeric_limits<raw_t>::max() : impl::epoch_to_tsc(t_end).raw()
+					);
+				return true;
+			}
+#else
+			(void) t_begin;
+			(void) t_end;
+			(void) keys_;
+#endif
+			return false;
+		}
+
 		auto erase(
 			const std::string &key
 		) -> status_t
@@ -729,6 +936,10 @@ template <typename Handle, typename Allocator, typename Table, typename LockType
 #endif
 					++_writes;
 					map().erase(it);
+					if ( _time_index )
+					{
+						_time_index->erase(key);
+					}
 					return S_OK;
 				}
 				else
@@ -807,6 +1018,28 @@ template <typename Handle, typename Allocator, typename Table, typename LockType
 			auto begin_tsc = t_begin.is_defined() ? std::numeric_limits<raw_t>::min() : impl::epoch_to_tsc(t_begin).raw();
 			auto end_tsc = t_end.is_defined() ? std::numeric_limits<raw_t>::max() : impl::epoch_to_tsc(t_end).raw();
 
+			std::vector<std::string> window;
+			if ( time_index_window(t_begin, t_end, window) )
+			{
+				for ( const auto &key : window )
+				{
+					auto it = this->map().find(key);
+					if ( it != this->map().end() )
+					{
+						const auto &pstring = it->first;
+						const auto &m = it->second;
+						function_(
+							reinterpret_cast<const void*>(pstring.data())
+							, pstring.size()
+							, std::get<0>(m).data()
+							, std::get<0>(m).size()
+							, impl::tsc_to_epoch(std::get<1>(m))
+						);
+					}
+				}
+				return S_OK;
+			}
+
 			for ( auto &mt : this->map() )
 			{
 				const auto &pstring = mt.first;
@@ -967,6 +1200,17 @@ PLOG("%s", s.str().c_str());
 				return E_INVAL;
 			}
 
+			if ( i->_fresh )
+			{
+				i->_fresh = false;
+				i->_windowed = time_index_window(t_begin, t_end, i->_window);
+			}
+
+			if ( i->_windowed )
+			{
+				return deref_window(*i, t_begin, t_end, ref, time_match, increment);
+			}
+
 			if ( i->is_end() )
 			{
 				return E_OUT_OF_BOUNDS;
@@ -1019,6 +1263,58 @@ PLOG("%s", s.str().c_str());
 			return S_OK;
 		}
 
+		/* Iteration over keys taken from the time index. Keys are found by
+		 * name, so writes do not disturb the iterator; keys erased since the
+		 * window was taken are skipped.
+		 */
+		status_t deref_window(
+			pool_iterator &i
+			, const common::epoch_time_t t_begin
+			, const common::epoch_time_t t_end
+			, component::IKVStore::pool_reference_t & ref
+			, bool& time_match
+			, bool increment
+		)
+		{
+#if ENABLE_TIMESTAMPS
+			using raw_t = decltype(impl::epoch_to_tsc(t_begin).raw());
+			auto begin_tsc = t_begin.is_defined() ? std::numeric_limits<raw_t>::min() : impl::epoch_to_tsc(t_begin).raw();
+			auto end_tsc = t_end.is_defined() ? std::numeric_limits<raw_t>::max() : impl::epoch_to_tsc(t_end).raw();
+
+			for ( ; i._window_pos != i._window.size(); ++i._window_pos )
+			{
+				auto it = this->map().find(i._window[i._window_pos]);
+				if ( it != this->map().end() )
+				{
+					const auto &k = it->first;
+					ref.key = k.data();
+					ref.key_len = k.size();
+					const auto &m = it->second;
+					const auto &d = std::get<0>(m);
+					ref.value = d.data();
+					ref.value_len = d.size();
+					ref.timestamp = impl::tsc_to_epoch(std::get<1>(m));
+					/* the key may have been rewritten since the window was taken */
+					const auto t = std::get<1>(m).raw();
+					time_match = ( begin_tsc <= t && t <= end_tsc );
+					if ( increment )
+					{
+						++i._window_pos;
+					}
+					return S_OK;
+				}
+			}
+#else
+			(void) i;
+			(void) t_begin;
+			(void) t_end;
+			(void) ref;
+			(void) time_match;
+			(void) increment;
+#endif
+			return E_OUT_OF_BOUNDS;
+		}
+
 		status_t close_iterator(component::IKVStore::pool_iterator_t iter)
 		{
 			if ( iter == nullptr )
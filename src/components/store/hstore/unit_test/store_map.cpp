@@ -19,6 +19,7 @@ const std::string store_map::impl_default = "hstore-cc";
 const store_map::impl_map_t store_map::impl_map = {
   { "hstore-cc", { "hstore-cc", component::hstore_factory } }
   , { "hstore", { "hstore", component::hstore_factory } }
+  , { "hstore-mt", { "hstore-mt", component::hstore_factory } }
 };
 
 namespace
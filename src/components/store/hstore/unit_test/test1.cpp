@@ -23,6 +23,8 @@
 #include <set>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
 
 using namespace component;
 
@@ -1189,6 +1191,23 @@ TEST_F(KVStore_test, AllocDealloc)
 #endif
 }
 
+TEST_F(KVStore_test, GroupCommit)
+{
+  ASSERT_NE(nullptr, _kvstore);
+  /* supported only without the crash-consistent heap */
+  if ( store_map::impl->name == "hstore" )
+  {
+    EXPECT_EQ(S_OK, _kvstore->ioctl("persist_group_open"));
+    auto r = _kvstore->put(pool, single_key, single_value.data(), single_value.length());
+    EXPECT_EQ(S_OK, r);
+    EXPECT_EQ(S_OK, _kvstore->ioctl("persist_group_commit"));
+  }
+  else
+  {
+    EXPECT_EQ(E_NOT_SUPPORTED, _kvstore->ioctl("persist_group_open"));
+  }
+}
+
 TEST_F(KVStore_test, DeletePool)
 {
   ASSERT_NE(nullptr, _kvstore);
@@ -1511,6 +1530,83 @@ TEST_F(KVStore_test, KeySwap)
   ASSERT_EQ(S_OK, _kvstore->close_pool(pool));
 }
 
+/* Threads put, get and erase their own keys in two pools at once.
+ * Only for stores which allow several threads per pool (hstore-mt).
+ */
+TEST_F(KVStore_test, ParallelPools)
+{
+  ASSERT_TRUE(_kvstore);
+  if ( _kvstore->thread_safety() != IKVStore::THREAD_MODEL_MULTI_PER_POOL )
+  {
+    PINF("ParallelPools skipped: %s is not thread safe", store_map::impl->name.c_str());
+    return;
+  }
+
+  constexpr unsigned thread_count = 8;
+  constexpr unsigned key_count = 2000;
+  std::vector<IKVStore::pool_t> pools;
+  for ( auto name : { "parallel0", "parallel1" } )
+  {
+    pools.push_back(_kvstore->create_pool(name, MB(64)));
+    ASSERT_NE(IKVStore::POOL_ERROR+0, pools.back());
+  }
+
+  std::vector<std::thread> threads;
+  std::vector<unsigned> failures(thread_count, 0);
+  for ( unsigned t = 0; t != thread_count; ++t )
+  {
+    threads.emplace_back(
+      [t, &pools, &failures] ()
+      {
+        auto p = pools[t % pools.size()];
+        auto key = [t] (unsigned i) { return "t" + std::to_string(t) + "k" + std::to_string(i) + "-long-enough-to-allocate"; };
+        for ( unsigned i = 0; i != key_count; ++i )
+        {
+          auto value = key(i) + std::string(i % 100, 'v');
+          failures[t] += _kvstore->put(p, key(i), value.data(), value.size()) != S_OK;
+        }
+        for ( unsigned i = 0; i != key_count; ++i )
+        {
+          auto value = key(i) + std::string(i % 100, 'v');
+          void *v = nullptr;
+          std::size_t v_len = 0;
+          if ( _kvstore->get(p, key(i), v, v_len) == S_OK )
+          {
+            failures[t] += v_len != value.size() || 0 != memcmp(v, value.data(), v_len);
+            _kvstore->free_memory(v);
+          }
+          else
+          {
+            ++failures[t];
+          }
+          if ( i % 2 == 0 )
+          {
+            failures[t] += _kvstore->erase(p, key(i)) != S_OK;
+          }
+        }
+      }
+    );
+  }
+  for ( auto &th : threads )
+  {
+    th.join();
+  }
+
+  for ( unsigned t = 0; t != thread_count; ++t )
+  {
+    EXPECT_EQ(0, failures[t]) << "thread " << t;
+  }
+  for ( auto p : pools )
+  {
+    EXPECT_EQ(thread_count / pools.size() * key_count / 2, _kvstore->count(p));
+    EXPECT_EQ(S_OK, _kvstore->close_pool(p));
+  }
+  for ( auto name : { "parallel0", "parallel1" } )
+  {
+    EXPECT_EQ(S_OK, _kvstore->delete_pool(name));
+  }
+}
+
 /* copied from mapstore */
 TEST_F(KVStore_test, OutOfMemory)
 {
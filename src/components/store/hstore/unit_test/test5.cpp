@@ -0,0 +1,267 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "store_map.h"
+#include "timer.h"
+
+#include <gtest/gtest.h>
+#include <common/utils.h>
+#include <api/components.h>
+/* note: we do not include component source, only the API definition */
+#include <api/kvstore_itf.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <random>
+#include <sstream>
+#include <vector>
+
+/*
+ * Microbenchmark: key fingerprint filter.
+ *
+ * Keys are longer than the 23 byte limit for keys held in the hash table, so
+ * each key compare reads at least one out-of-line (persistent memory) cache
+ * line. Hit and miss lookups are run with the fingerprint filter enabled and
+ * disabled, and the key compares per lookup reported.
+ *
+ * export PMEM_IS_PMEM_FORCE=1
+ * ./src/components/hstore/unit_test/hstore-test5
+ */
+
+using namespace component;
+
+namespace {
+
+class KVStore_test
+  : public ::testing::Test
+{
+  static constexpr std::size_t many_count_target_large = 2000000;
+  /* Shorter test: use when PMEM_IS_PMEM_FORCE=0 */
+  static constexpr std::size_t many_count_target_small = 40000;
+
+ protected:
+
+  /* debug commands of hstore */
+  static constexpr unsigned debug_locate_key_stats = 3;
+  static constexpr unsigned debug_fingerprint_filter = 4;
+
+  /* persistent memory if enabled at all, is simulated and not real */
+  static bool pmem_simulated;
+  static component::IKVStore * _kvstore;
+  static component::IKVStore::pool_t pool;
+
+  static constexpr unsigned key_length = 32;
+  static constexpr unsigned value_length = 16;
+  static constexpr unsigned get_expand = 4;
+
+  static std::vector<std::string> keys_present;
+  static std::vector<std::string> keys_absent;
+  static std::size_t many_count_target;
+
+  /* key compares per lookup, by [hit/miss][filter off/on] */
+  static double compares[2][2];
+
+  static void populate_many(std::vector<std::string> &keys, char tag);
+  static double get_many(const std::vector<std::string> &keys, bool present, bool filter, const std::string &descr);
+
+  std::string pool_name() const
+  {
+    return "/mnt/pmem0/pool/0/test-" + store_map::impl->name + store_map::numa_zone() + ".pool";
+  }
+};
+
+constexpr std::size_t KVStore_test::many_count_target_large;
+constexpr std::size_t KVStore_test::many_count_target_small;
+constexpr unsigned KVStore_test::debug_locate_key_stats;
+constexpr unsigned KVStore_test::debug_fingerprint_filter;
+constexpr unsigned KVStore_test::key_length;
+constexpr unsigned KVStore_test::value_length;
+constexpr unsigned KVStore_test::get_expand;
+
+bool KVStore_test::pmem_simulated = getenv("PMEM_IS_PMEM_FORCE");
+component::IKVStore *KVStore_test::_kvstore;
+component::IKVStore::pool_t KVStore_test::pool;
+
+std::vector<std::string> KVStore_test::keys_present;
+std::vector<std::string> KVStore_test::keys_absent;
+std::size_t KVStore_test::many_count_target = KVStore_test::pmem_simulated ? many_count_target_small : many_count_target_large;
+double KVStore_test::compares[2][2];
+
+TEST_F(KVStore_test, Instantiate)
+{
+  /* create object instance through factory */
+  auto link_library = "libcomponent-" + store_map::impl->name + ".so";
+  component::IBase * comp = component::load_component(link_library,
+                                                      store_map::impl->factory_id);
+
+  ASSERT_TRUE(comp);
+  auto fact = component::make_itf_ref(static_cast<IKVStore_factory *>(comp->query_interface(IKVStore_factory::iid())));
+
+  _kvstore =
+    fact->create(
+      0
+      , {
+          { +component::IKVStore_factory::k_dax_config, store_map::location }
+        }
+    );
+}
+
+TEST_F(KVStore_test, RemoveOldPool)
+{
+  if ( _kvstore )
+  {
+    try
+    {
+      _kvstore->delete_pool(pool_name());
+    }
+    catch ( Exception & )
+    {
+    }
+  }
+}
+
+TEST_F(KVStore_test, CreatePool)
+{
+  ASSERT_TRUE(_kvstore);
+  pool = _kvstore->create_pool(pool_name(), MB(8192UL), 0, many_count_target);
+  ASSERT_LT(0, int64_t(pool));
+}
+
+void KVStore_test::populate_many(std::vector<std::string> &keys, const char tag)
+{
+  std::mt19937_64 r0{std::uint64_t(tag)};
+  for ( auto i = 0UL; i != many_count_target; ++i )
+  {
+    std::ostringstream s;
+    s << tag << std::hex << r0();
+    auto key = s.str();
+    key.resize(key_length, '.');
+    keys.emplace_back(key);
+  }
+}
+
+TEST_F(KVStore_test, Populate)
+{
+  populate_many(keys_present, 'P');
+  populate_many(keys_absent, 'Q');
+}
+
+TEST_F(KVStore_test, PutMany)
+{
+  ASSERT_NE(_kvstore, nullptr);
+  ASSERT_LT(0, int64_t(pool));
+
+  std::size_t count = 0;
+  for ( const auto &key : keys_present )
+  {
+    std::string value(value_length, '.');
+    if ( S_OK == _kvstore->put(pool, key, value.data(), value.length()) )
+    {
+      ++count;
+    }
+  }
+  EXPECT_LE(many_count_target * 99 / 100, count);
+}
+
+double KVStore_test::get_many(const std::vector<std::string> &keys, const bool present, const bool filter, const std::string &descr)
+{
+  _kvstore->debug(pool, debug_fingerprint_filter, filter);
+  std::uint64_t stats[4];
+  /* discard counts from earlier operations */
+  _kvstore->debug(pool, debug_locate_key_stats, reinterpret_cast<std::uint64_t>(&stats));
+
+  const auto count = get_expand * keys.size();
+  {
+    timer t(
+      [&descr, count] (timer::duration_t d) {
+        auto seconds = std::chrono::duration<double>(d).count();
+        std::cout << descr << " " << count << " in " << seconds << " seconds -> " << double(count) / seconds << " per second\n";
+      }
+    );
+    for ( auto i = 0U; i != get_expand; ++i )
+    {
+      for ( const auto &key : keys )
+      {
+        void * value = nullptr;
+        size_t value_len = 0;
+        auto r = _kvstore->get(pool, key, value, value_len);
+        EXPECT_EQ(present ? status_t(S_OK) : status_t(IKVStore::E_KEY_NOT_FOUND), r);
+        if ( S_OK == r )
+        {
+          _kvstore->free_memory(value);
+        }
+      }
+    }
+  }
+
+  _kvstore->debug(pool, debug_locate_key_stats, reinterpret_cast<std::uint64_t>(&stats));
+  const auto lookups = double(stats[0]);
+  const auto key_compares = double(stats[2] + stats[3]) / lookups;
+  /* Each compare of an out-of-line key reads at least one persistent memory
+   * cache line beyond the bucket itself.
+   */
+  std::cout << descr
+    << " lookups " << stats[0]
+    << " owned/lookup " << double(stats[1]) / lookups
+    << " key compares/lookup " << key_compares
+    << " (est. pmem key lines/lookup " << key_compares << ")\n";
+  return key_compares;
+}
+
+TEST_F(KVStore_test, GetHit)
+{
+  ASSERT_NE(_kvstore, nullptr);
+  ASSERT_LT(0, int64_t(pool));
+
+  compares[0][0] = get_many(keys_present, true, false, "hit, no filter");
+  compares[0][1] = get_many(keys_present, true, true, "hit, filter");
+  /* a hit always compares the matching key */
+  EXPECT_LE(1.0, compares[0][1]);
+  EXPECT_LE(compares[0][1], compares[0][0]);
+}
+
+TEST_F(KVStore_test, GetMiss)
+{
+  ASSERT_NE(_kvstore, nullptr);
+  ASSERT_LT(0, int64_t(pool));
+
+  compares[1][0] = get_many(keys_absent, false, false, "miss, no filter");
+  compares[1][1] = get_many(keys_absent, false, true, "miss, filter");
+  EXPECT_LE(compares[1][1], compares[1][0]);
+}
+
+TEST_F(KVStore_test, ClosePool)
+{
+  if ( _kvstore && 0 < int64_t(pool) )
+  {
+    _kvstore->debug(pool, debug_fingerprint_filter, true);
+    _kvstore->close_pool(pool);
+  }
+}
+
+TEST_F(KVStore_test, DeletePool)
+{
+  _kvstore->delete_pool(pool_name());
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  auto r = RUN_ALL_TESTS();
+
+  return r;
+}
@@ -0,0 +1,299 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "store_map.h"
+#include "timer.h"
+
+#include <gtest/gtest.h>
+#include <common/utils.h>
+#include <api/components.h>
+/* note: we do not include component source, only the API definition */
+#include <api/kvstore_itf.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <random>
+#include <sstream>
+#include <vector>
+
+/*
+ * Benchmark: pool restart time.
+ *
+ * Keys and values are longer than the 23 byte limit for data held in the
+ * hash table, so that each element has two heap allocations which a reopen
+ * must reconstitute. The pool is reopened after a clean close (allocations
+ * restored from the snapshot written at close), and after a close which
+ * omits the snapshot (allocations found by scanning the table, as after a
+ * crash) with one scan thread and with the default number of threads.
+ *
+ * Meaningful only for the rc heap (MCAS_HSTORE_USE_CC_HEAP=3); other heaps
+ * ignore the snapshot.
+ *
+ * export PMEM_IS_PMEM_FORCE=1
+ * ./src/components/hstore/unit_test/hstore-test6
+ */
+
+using namespace component;
+
+namespace {
+
+class KVStore_test
+  : public ::testing::Test
+{
+  static constexpr std::size_t many_count_target_large = 4000000;
+  /* Shorter test: use when PMEM_IS_PMEM_FORCE=0 */
+  static constexpr std::size_t many_count_target_small = 40000;
+
+ protected:
+
+  /* debug command of hstore */
+  static constexpr unsigned debug_snapshot_on_close = 5;
+
+  /* persistent memory if enabled at all, is simulated and not real */
+  static bool pmem_simulated;
+  static component::IKVStore * _kvstore;
+  static component::IKVStore::pool_t pool;
+
+  static constexpr unsigned key_length = 32;
+  static constexpr unsigned value_length = 32;
+
+  static std::vector<std::string> keys;
+  static std::size_t many_count_target;
+
+  static void reopen(bool snapshot, const char *scan_threads, const std::string &descr);
+  static void check_all();
+
+  static std::string pool_name()
+  {
+    return "/mnt/pmem0/pool/0/test-" + store_map::impl->name + store_map::numa_zone() + ".pool";
+  }
+};
+
+constexpr std::size_t KVStore_test::many_count_target_large;
+constexpr std::size_t KVStore_test::many_count_target_small;
+constexpr unsigned KVStore_test::debug_snapshot_on_close;
+constexpr unsigned KVStore_test::key_length;
+constexpr unsigned KVStore_test::value_length;
+
+bool KVStore_test::pmem_simulated = getenv("PMEM_IS_PMEM_FORCE");
+component::IKVStore *KVStore_test::_kvstore;
+component::IKVStore::pool_t KVStore_test::pool;
+
+std::vector<std::string> KVStore_test::keys;
+std::size_t KVStore_test::many_count_target = KVStore_test::pmem_simulated ? many_count_target_small : many_count_target_large;
+
+TEST_F(KVStore_test, Instantiate)
+{
+  /* create object instance through factory */
+  auto link_library = "libcomponent-" + store_map::impl->name + ".so";
+  component::IBase * comp = component::load_component(link_library,
+                                                      store_map::impl->factory_id);
+
+  ASSERT_TRUE(comp);
+  auto fact = component::make_itf_ref(static_cast<IKVStore_factory *>(comp->query_interface(IKVStore_factory::iid())));
+
+  _kvstore =
+    fact->create(
+      0
+      , {
+          { +component::IKVStore_factory::k_dax_config, store_map::location }
+        }
+    );
+}
+
+TEST_F(KVStore_test, RemoveOldPool)
+{
+  if ( _kvstore )
+  {
+    try
+    {
+      _kvstore->delete_pool(pool_name());
+    }
+    catch ( Exception & )
+    {
+    }
+  }
+}
+
+TEST_F(KVStore_test, CreatePool)
+{
+  ASSERT_TRUE(_kvstore);
+  pool = _kvstore->create_pool(pool_name(), MB(8192UL), 0, many_count_target);
+  ASSERT_LT(0, int64_t(pool));
+}
+
+TEST_F(KVStore_test, PutMany)
+{
+  ASSERT_NE(_kvstore, nullptr);
+  ASSERT_LT(0, int64_t(pool));
+
+  std::mt19937_64 r0{};
+  std::size_t count = 0;
+  for ( auto i = 0UL; i != many_count_target; ++i )
+  {
+    std::ostringstream s;
+    s << std::hex << r0();
+    auto key = s.str();
+    key.resize(key_length, '.');
+    std::string value(value_length, '.');
+    if ( S_OK == _kvstore->put(pool, key, value.data(), value.length()) )
+    {
+      keys.emplace_back(key);
+      ++count;
+    }
+  }
+  EXPECT_LE(many_count_target * 99 / 100, count);
+}
+
+void KVStore_test::reopen(const bool snapshot, const char *const scan_threads, const std::string &descr)
+{
+  _kvstore->debug(pool, debug_snapshot_on_close, snapshot);
+  ASSERT_EQ(S_OK, _kvstore->close_pool(pool));
+
+  if ( scan_threads )
+  {
+    ::setenv("HSTORE_SCAN_THREADS", scan_threads, 1);
+  }
+  else
+  {
+    ::unsetenv("HSTORE_SCAN_THREADS");
+  }
+
+  const auto count = keys.size();
+  {
+    timer t(
+      [&descr, count] (timer::duration_t d) {
+        auto seconds = std::chrono::duration<double>(d).count();
+        std::cout << descr << ": reopen of " << count << " elements in " << seconds << " seconds\n";
+      }
+    );
+    pool = _kvstore->open_pool(pool_name());
+  }
+  ASSERT_LT(0, int64_t(pool));
+}
+
+void KVStore_test::check_all()
+{
+  /* Every element reconstituted, and usable: replace each value */
+  std::size_t count = 0;
+  for ( const auto &key : keys )
+  {
+    void * value = nullptr;
+    size_t value_len = 0;
+    auto r = _kvstore->get(pool, key, value, value_len);
+    EXPECT_EQ(S_OK, r);
+    if ( S_OK == r )
+    {
+      EXPECT_EQ(value_length, value_len);
+      _kvstore->free_memory(value);
+      std::string new_value(value_length, '+');
+      if ( S_OK == _kvstore->put(pool, key, new_value.data(), new_value.length()) )
+      {
+        ++count;
+      }
+    }
+  }
+  EXPECT_EQ(keys.size(), count);
+}
+
+TEST_F(KVStore_test, ReopenSnapshot)
+{
+  ASSERT_NE(_kvstore, nullptr);
+  ASSERT_LT(0, int64_t(pool));
+  reopen(true, nullptr, "snapshot");
+  check_all();
+}
+
+TEST_F(KVStore_test, ReopenScanOneThread)
+{
+  ASSERT_NE(_kvstore, nullptr);
+  ASSERT_LT(0, int64_t(pool));
+  reopen(false, "1", "scan, 1 thread");
+  check_all();
+}
+
+TEST_F(KVStore_test, ReopenScanThreads)
+{
+  ASSERT_NE(_kvstore, nullptr);
+  ASSERT_LT(0, int64_t(pool));
+  reopen(false, nullptr, "scan, default threads");
+  check_all();
+}
+
+TEST_F(KVStore_test, AllocFreeAfterSnapshot)
+{
+  ASSERT_NE(_kvstore, nullptr);
+  ASSERT_LT(0, int64_t(pool));
+  reopen(true, nullptr, "snapshot, before allocate and free");
+
+  /* The snapshot's allocations are freed by erase and by replacement with
+   * values of another size, and new allocations must not overlap those
+   * which remain.
+   */
+  const std::string grown(value_length * 2, 'g');
+  const std::string shrunk(value_length / 2 + 24, 's');
+  for ( std::size_t i = 0; i != keys.size(); ++i )
+  {
+    if ( i % 2 == 0 )
+    {
+      ASSERT_EQ(S_OK, _kvstore->erase(pool, keys[i]));
+      ASSERT_EQ(S_OK, _kvstore->put(pool, keys[i], grown.data(), grown.size()));
+    }
+    else
+    {
+      ASSERT_EQ(S_OK, _kvstore->put(pool, keys[i], shrunk.data(), shrunk.size()));
+    }
+  }
+
+  void *p = nullptr;
+  ASSERT_EQ(S_OK, _kvstore->allocate_pool_memory(pool, 4096, 64, p));
+  ASSERT_NE(nullptr, p);
+  ASSERT_EQ(S_OK, _kvstore->free_pool_memory(pool, p, 4096));
+
+  /* and the heap so changed must snapshot and reopen in turn */
+  reopen(true, nullptr, "snapshot, after allocate and free");
+  for ( std::size_t i = 0; i != keys.size(); ++i )
+  {
+    void * value = nullptr;
+    size_t value_len = 0;
+    ASSERT_EQ(S_OK, _kvstore->get(pool, keys[i], value, value_len));
+    const auto &expected = i % 2 == 0 ? grown : shrunk;
+    EXPECT_EQ(expected, std::string(static_cast<const char *>(value), value_len));
+    _kvstore->free_memory(value);
+  }
+}
+
+TEST_F(KVStore_test, ClosePool)
+{
+  if ( _kvstore && 0 < int64_t(pool) )
+  {
+    _kvstore->close_pool(pool);
+  }
+}
+
+TEST_F(KVStore_test, DeletePool)
+{
+  _kvstore->delete_pool(pool_name());
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  auto r = RUN_ALL_TESTS();
+
+  return r;
+}
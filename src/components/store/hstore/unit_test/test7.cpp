@@ -0,0 +1,341 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "store_map.h"
+
+#include <gtest/gtest.h>
+#include <common/utils.h>
+#include <api/components.h>
+/* note: we do not include component source, only the API definition */
+#include <api/kvstore_itf.h>
+
+#include <algorithm> /* count */
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+/*
+ * Incremental resize of the hash table.
+ *
+ * The pool starts with a small table, which grows through several resizes.
+ * While a resize migrates keys from senior to junior owners, every key must
+ * be found (lookups which miss at a junior owner try the senior owner), and
+ * erase must find keys not yet migrated. A pool closed in mid-migration
+ * must reopen with every key, after a clean close and after a close which
+ * omits the allocation snapshot (as after a crash). A pool closed while the
+ * junior segment is under construction releases that segment at reopen, and
+ * starts the resize over.
+ */
+
+using namespace component;
+
+namespace {
+
+class KVStore_test
+  : public ::testing::Test
+{
+  static constexpr std::size_t many_count_target_large = 400000;
+  /* Shorter test: use when PMEM_IS_PMEM_FORCE=0 */
+  static constexpr std::size_t many_count_target_small = 40000;
+
+ protected:
+
+  /* debug commands of hstore */
+  static constexpr unsigned debug_snapshot_on_close = 5;
+  static constexpr unsigned debug_resize_state = 6;
+
+  /* persistent memory if enabled at all, is simulated and not real */
+  static bool pmem_simulated;
+  static component::IKVStore * _kvstore;
+  static component::IKVStore::pool_t pool;
+
+  static std::vector<std::string> keys;
+  static std::vector<bool> erased;
+  static std::size_t many_count_target;
+
+  static std::string pool_name()
+  {
+    return "/mnt/pmem0/pool/0/test-" + store_map::impl->name + store_map::numa_zone() + ".pool";
+  }
+
+  struct resize_state
+  {
+    std::uint64_t bucket_count;
+    std::uint64_t preparing;
+    std::uint64_t unmigrated;
+  };
+
+  static resize_state state()
+  {
+    std::uint64_t s[3] = {};
+    _kvstore->debug(pool, debug_resize_state, reinterpret_cast<std::uint64_t>(&s));
+    return resize_state{s[0], s[1], s[2]};
+  }
+
+  static bool present(const std::string &key)
+  {
+    void * value = nullptr;
+    size_t value_len = 0;
+    auto r = _kvstore->get(pool, key, value, value_len);
+    if ( S_OK == r )
+    {
+      EXPECT_EQ(key, std::string(static_cast<const char *>(value), value_len));
+      _kvstore->free_memory(value);
+    }
+    return S_OK == r;
+  }
+
+  /* put one new key, whose value is the key */
+  static void put_next()
+  {
+    auto key = "key-" + std::to_string(keys.size());
+    ASSERT_EQ(S_OK, _kvstore->put(pool, key, key.data(), key.size()));
+    keys.push_back(key);
+    erased.push_back(false);
+  }
+
+  /* put new keys until a resize is migrating; false if none began in
+   * enough puts to double the table */
+  static bool put_until_migrating()
+  {
+    for ( const auto limit = 2 * keys.size() + many_count_target; keys.size() != limit; )
+    {
+      put_next();
+      if ( HasFatalFailure() )
+      {
+        return false;
+      }
+      if ( state().unmigrated != 0 )
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /* put new keys until a junior segment is under construction */
+  static bool put_until_preparing()
+  {
+    for ( const auto limit = 2 * keys.size() + many_count_target; keys.size() != limit; )
+    {
+      put_next();
+      if ( HasFatalFailure() )
+      {
+        return false;
+      }
+      if ( state().preparing )
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static void check_all()
+  {
+    for ( std::size_t i = 0; i != keys.size(); ++i )
+    {
+      EXPECT_EQ(! erased[i], present(keys[i])) << keys[i];
+    }
+  }
+
+  static void reopen(bool snapshot);
+};
+
+constexpr std::size_t KVStore_test::many_count_target_large;
+constexpr std::size_t KVStore_test::many_count_target_small;
+constexpr unsigned KVStore_test::debug_snapshot_on_close;
+constexpr unsigned KVStore_test::debug_resize_state;
+
+bool KVStore_test::pmem_simulated = getenv("PMEM_IS_PMEM_FORCE");
+component::IKVStore *KVStore_test::_kvstore;
+component::IKVStore::pool_t KVStore_test::pool;
+
+std::vector<std::string> KVStore_test::keys;
+std::vector<bool> KVStore_test::erased;
+std::size_t KVStore_test::many_count_target = KVStore_test::pmem_simulated ? many_count_target_small : many_count_target_large;
+
+void KVStore_test::reopen(const bool snapshot)
+{
+  _kvstore->debug(pool, debug_snapshot_on_close, snapshot);
+  ASSERT_EQ(S_OK, _kvstore->close_pool(pool));
+  pool = _kvstore->open_pool(pool_name());
+  ASSERT_LT(0, int64_t(pool));
+}
+
+TEST_F(KVStore_test, Instantiate)
+{
+  /* create object instance through factory */
+  auto link_library = "libcomponent-" + store_map::impl->name + ".so";
+  component::IBase * comp = component::load_component(link_library,
+                                                      store_map::impl->factory_id);
+
+  ASSERT_TRUE(comp);
+  auto fact = component::make_itf_ref(static_cast<IKVStore_factory *>(comp->query_interface(IKVStore_factory::iid())));
+
+  _kvstore =
+    fact->create(
+      0
+      , {
+          { +component::IKVStore_factory::k_dax_config, store_map::location }
+        }
+    );
+}
+
+TEST_F(KVStore_test, RemoveOldPool)
+{
+  if ( _kvstore )
+  {
+    try
+    {
+      _kvstore->delete_pool(pool_name());
+    }
+    catch ( Exception & )
+    {
+    }
+  }
+}
+
+TEST_F(KVStore_test, CreatePool)
+{
+  ASSERT_TRUE(_kvstore);
+  /* expect few keys, so that the table starts small */
+  pool = _kvstore->create_pool(pool_name(), MB(2048UL), 0, 1);
+  ASSERT_LT(0, int64_t(pool));
+}
+
+TEST_F(KVStore_test, LookupDuringMigration)
+{
+  ASSERT_NE(_kvstore, nullptr);
+  ASSERT_LT(0, int64_t(pool));
+
+  const auto initial = state();
+  std::size_t preparing_puts = 0;
+  std::size_t migrating_checks = 0;
+  for ( auto i = 0UL; i != many_count_target; ++i )
+  {
+    put_next();
+    const auto s = state();
+    if ( s.preparing )
+    {
+      ++preparing_puts;
+    }
+    /* every key, at the start of each migration and now and then during it */
+    if ( s.unmigrated != 0 && ( migrating_checks == 0 || i % 1021 == 0 ) )
+    {
+      ++migrating_checks;
+      check_all();
+    }
+  }
+  EXPECT_LT(initial.bucket_count, state().bucket_count);
+  EXPECT_LT(0U, preparing_puts);
+  EXPECT_LT(0U, migrating_checks);
+  check_all();
+}
+
+TEST_F(KVStore_test, EraseDuringMigration)
+{
+  ASSERT_NE(_kvstore, nullptr);
+  ASSERT_LT(0, int64_t(pool));
+  ASSERT_TRUE(put_until_migrating());
+
+  /* erase every third key while keys remain with their senior owners */
+  for ( std::size_t i = 0; i < keys.size() && state().unmigrated != 0; i += 3 )
+  {
+    if ( ! erased[i] )
+    {
+      EXPECT_EQ(S_OK, _kvstore->erase(pool, keys[i]));
+      erased[i] = true;
+    }
+  }
+  check_all();
+  EXPECT_EQ(std::size_t(std::count(erased.begin(), erased.end(), false)), _kvstore->count(pool));
+}
+
+TEST_F(KVStore_test, ReopenMidMigration)
+{
+  ASSERT_NE(_kvstore, nullptr);
+  ASSERT_LT(0, int64_t(pool));
+  ASSERT_TRUE(put_until_migrating());
+
+  const auto before = state();
+  reopen(true);
+  const auto after = state();
+  /* the reopen finishes the migration */
+  EXPECT_EQ(before.bucket_count, after.bucket_count);
+  EXPECT_EQ(0U, after.unmigrated);
+  check_all();
+
+  /* and the table grows again */
+  put_until_migrating();
+  check_all();
+}
+
+TEST_F(KVStore_test, ReopenMidMigrationNoSnapshot)
+{
+  ASSERT_NE(_kvstore, nullptr);
+  ASSERT_LT(0, int64_t(pool));
+  ASSERT_TRUE(put_until_migrating());
+
+  reopen(false);
+  EXPECT_EQ(0U, state().unmigrated);
+  check_all();
+  EXPECT_EQ(std::size_t(std::count(erased.begin(), erased.end(), false)), _kvstore->count(pool));
+}
+
+TEST_F(KVStore_test, ReopenWhilePreparing)
+{
+  ASSERT_NE(_kvstore, nullptr);
+  ASSERT_LT(0, int64_t(pool));
+
+  for ( const auto snapshot : { true, false } )
+  {
+    ASSERT_TRUE(put_until_preparing());
+    const auto before = state();
+    reopen(snapshot);
+    const auto after = state();
+    /* the junior segment is released, and the table is as before the resize */
+    EXPECT_EQ(before.bucket_count, after.bucket_count);
+    EXPECT_EQ(0U, after.preparing);
+    EXPECT_EQ(0U, after.unmigrated);
+    check_all();
+  }
+
+  /* and the resize starts over */
+  ASSERT_TRUE(put_until_migrating());
+  check_all();
+  EXPECT_EQ(std::size_t(std::count(erased.begin(), erased.end(), false)), _kvstore->count(pool));
+}
+
+TEST_F(KVStore_test, ClosePool)
+{
+  if ( _kvstore && 0 < int64_t(pool) )
+  {
+    _kvstore->close_pool(pool);
+  }
+}
+
+TEST_F(KVStore_test, DeletePool)
+{
+  _kvstore->delete_pool(pool_name());
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  auto r = RUN_ALL_TESTS();
+
+  return r;
+}
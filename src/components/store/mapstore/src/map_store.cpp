@@ -15,6 +15,7 @@
 #include <common/exceptions.h>
 #include <common/rwlock.h>
 #include <common/cycles.h>
+#include <common/time_index.h>
 #include <common/utils.h>
 #include <fcntl.h>
 #include <nupm/allocator_ra.h>
@@ -23,14 +24,20 @@
 #include <time.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <algorithm>
+#include <atomic>
 #include <cerrno>
 #include <cmath>
+#include <limits>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <set>
 #include <sstream>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 #include <chrono>  // seconds
 #include <thread> // sleep_for
 
@@ -40,7 +47,6 @@
 #pragma GCC diagnostic pop
 
 #define DEFAULT_ALIGNMENT 8
-#define SINGLE_THREADED
 #define NUMA_ZONE 0 /* treat memory as a single zone, although it may not be */
 #define MIN_POOL (1ULL << DM_REGION_LOG_GRAIN_SIZE)
 
@@ -49,28 +55,139 @@
 using namespace component;
 using namespace common;
 
+/*
+  Value lock with a version counter, odd while the value is write locked.
+  Readers which copy a value without locking it (get_optimistic) validate
+  the copy against the version, seqlock style.
+*/
+class Value_lock : public common::RWLock {
+public:
+  Value_lock() : common::RWLock(), _version(0) {}
+
+  int write_trylock() {
+    auto rc = common::RWLock::write_trylock();
+    if (rc == 0) {
+      _version.fetch_add(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+    }
+    return rc;
+  }
+
+  int unlock() {
+    /* a read lock cannot coexist with a write lock, so an odd version means
+       the lock being released is the write lock */
+    auto v = _version.load(std::memory_order_relaxed);
+    if (v % 2 != 0) _version.store(v + 1, std::memory_order_release);
+    return common::RWLock::unlock();
+  }
+
+  std::uint64_t version(std::memory_order order) const { return _version.load(order); }
+
+private:
+  std::atomic<std::uint64_t> _version;
+};
+
 struct Value_type {
   Value_type() : _ptr(nullptr), _length(0), _value_lock(nullptr), _tsc() {
   }
 
-  Value_type(void* ptr, size_t length, common::RWLock * value_lock) :
+  Value_type(void* ptr, size_t length, Value_lock * value_lock) :
     _ptr(ptr), _length(length), _value_lock(value_lock), _tsc() {
   }
   void * _ptr;
   size_t _length;
-  common::RWLock * _value_lock; /*< read write lock */
+  Value_lock * _value_lock; /*< read write lock */
   common::tsc_time_t _tsc;
 };
 
+using Std_lock_guard = std::lock_guard<std::mutex>;
+
+/*
+  Rca_LB is not thread safe. Each stripe of a pool has its own heap, over a
+  slice of each pool region, so that threads working in different stripes
+  do not contend for one allocator. The rest of each region belongs to the
+  pool's shared heap, to which a stripe heap overflows: it holds the values
+  larger than a slice, and whatever a full stripe cannot. The mutex
+  serializes the users of a heap; it is a leaf lock, taken under a stripe
+  lock of either mode, and released before overflowing.
+*/
+class Stripe_heap {
+public:
+  explicit Stripe_heap(Stripe_heap *overflow = nullptr) : _lb(), _lock(), _overflow(overflow), _ranges(), _largest(0) {}
+
+  Stripe_heap(const Stripe_heap &) = delete;
+  Stripe_heap &operator=(const Stripe_heap &) = delete;
+
+  void add_managed_region(void *base, size_t len, int numa_node) {
+    Std_lock_guard g(_lock);
+    _lb.add_managed_region(base, len, numa_node);
+    _ranges.push_back({base, len});
+    _largest = std::max(_largest, len);
+  }
+
+  /* from this heap, or else from the overflow heap */
+  void *alloc(size_t size, int numa_node, size_t alignment = 0) {
+    try { return alloc_local(size, numa_node, alignment); }
+    catch (const std::bad_alloc &) {
+      if (!_overflow) throw;
+    }
+    return _overflow->alloc(size, numa_node, alignment);
+  }
+
+  /* from this heap only */
+  void *alloc_local(size_t size, int numa_node, size_t alignment = 0) {
+    Std_lock_guard g(_lock);
+    if (size > _largest) throw std::bad_alloc();
+    return _lb.alloc(size, numa_node, alignment);
+  }
+
+  void free(void *p, int numa_node, size_t size = 0) {
+    {
+      Std_lock_guard g(_lock);
+      if (!_overflow || owns(p)) {
+        _lb.free(p, numa_node, size);
+        return;
+      }
+    }
+    _overflow->free(p, numa_node, size);
+  }
+
+private:
+  bool owns(const void *p) const {
+    const auto c = static_cast<const char *>(p);
+    return std::any_of(_ranges.begin(), _ranges.end(), [c] (const ::iovec &r) {
+        return static_cast<const char *>(r.iov_base) <= c && c < static_cast<const char *>(r.iov_base) + r.iov_len;
+      });
+  }
+
+  nupm::Rca_LB         _lb;
+  std::mutex           _lock;
+  Stripe_heap *        _overflow;
+  std::vector<::iovec> _ranges;
+  size_t               _largest; /*< no larger allocation can succeed */
+};
+
+template <>
+struct mr_traits<Stripe_heap>
+{
+  static auto allocate(Stripe_heap *pmr, unsigned numa_node, std::size_t bytes, std::size_t alignment)
+  {
+    return pmr->alloc(bytes, int(numa_node), alignment);
+  }
+  static auto deallocate(Stripe_heap *pmr, unsigned numa_node, void *p, std::size_t bytes, std::size_t)
+  {
+    return pmr->free(p, int(numa_node), bytes);
+  }
+};
+
 class Key_hash;
 
-using aac_t = nupm::allocator_adaptor<char, nupm::Rca_LB>;
+using aac_t = nupm::allocator_adaptor<char, Stripe_heap>;
 using string_t = std::basic_string<char, std::char_traits<char>, aac_t>;
-using aam_t = nupm::allocator_adaptor<std::pair<string_t, Value_type>, nupm::Rca_LB>;
+using aam_t = nupm::allocator_adaptor<std::pair<string_t, Value_type>, Stripe_heap>;
 using map_t = std::unordered_map<string_t, Value_type, Key_hash,
                                  std::equal_to<string_t>, aam_t>;
-using aal_t = nupm::allocator_adaptor<common::RWLock, nupm::Rca_LB>;
-
+using aal_t = nupm::allocator_adaptor<Value_lock, Stripe_heap>;
 static size_t choose_alignment(size_t size)
 {
   if((size >= 4096) && (size % 4096 == 0)) return 4096;
@@ -146,6 +263,33 @@ static void * allocate_region_memory(size_t alignment, size_t size)
 }
 
 
+/*
+  One lock stripe of a pool: the keys which hash to the stripe, the lock
+  which guards them, and the heap for their keys and value locks. Values
+  are allocated from the stripe's heap while it has space.
+*/
+struct Stripe {
+  explicit Stripe(Stripe_heap *overflow) : heap(overflow), map(aam_t(heap)), lock(), aac(heap), aal(heap) {}
+
+  Stripe_heap    heap;
+  map_t          map;
+  common::RWLock lock; /*< read write lock */
+  aac_t          aac;
+  aal_t          aal;
+};
+
+namespace
+{
+  /* Stripes per pool: MAPSTORE_STRIPES (default 16), but no more than leaves
+     each stripe a MIN_POOL share of the pool. */
+  size_t stripe_count(size_t pool_size)
+  {
+    const auto e = getenv("MAPSTORE_STRIPES");
+    const auto n = e ? std::strtoul(e, nullptr, 10) : 16UL;
+    return std::max(size_t(1), std::min(size_t(n), size_t(pool_size / MIN_POOL)));
+  }
+}
+
 class Pool_handle {
 private:
   static constexpr unsigned debug_level() { return Map_store::debug_level(); }
@@ -173,17 +317,54 @@ private:
     explicit Iterator(const Pool_handle * pool)
       : _pool(checked_pool(pool)),
         _mark(_pool->writes()),
-        _iter(_pool->_map.begin()),
-        _end(_pool->_map.end())
-    {}
+        _stripe(0),
+        _iter(),
+        _end(),
+        _fresh(true),
+        _windowed(false),
+        _window(),
+        _window_pos(0)
+    {
+      auto &s = *_pool->_stripes[_stripe];
+      RWLock_guard guard(s.lock);
+      _iter = s.map.begin();
+      _end = s.map.end();
+    }
+
+    Iterator(const Iterator &) = delete;
+    Iterator &operator=(const Iterator &) = delete;
+
+    /* move past the ends of stripes, to an element or the end of the last stripe */
+    void settle() {
+      while (_iter == _end && _stripe + 1 < _pool->_stripes.size()) {
+        auto &s = *_pool->_stripes[++_stripe];
+        RWLock_guard guard(s.lock);
+        _iter = s.map.begin();
+        _end = s.map.end();
+      }
+    }
 
     bool is_end() const { return _iter == _end; }
     bool check_mark(uint32_t writes) const { return _mark == writes; }
 
     const Pool_handle *   _pool;
     uint32_t              _mark;
+    size_t                _stripe;
     map_t::const_iterator _iter;
     map_t::const_iterator _end;
+    /* with a time index, a time-constrained iterator visits only the keys
+       in the window given at its first dereference */
+    bool                     _fresh;
+    bool                     _windowed;
+    std::vector<std::string> _window;
+    size_t                   _window_pos;
+  };
+
+  /* address range of a region slice, and the heap which manages it */
+  struct Slice {
+    const char *  base;
+    size_t        len;
+    Stripe_heap * heap;
   };
 
 public:
@@ -191,11 +372,12 @@ public:
 #pragma GCC diagnostic ignored "-Weffc++" // several unitialized/default initialized members
   Pool_handle(size_t nsize)
     : _nsize(nsize < MIN_POOL ? MIN_POOL : nsize),
-      _tmp({allocate_region_memory(MB(2) /* alignment */, _nsize), _nsize}),
-      _regions{_tmp},
-      _map({(_lb.add_managed_region(_tmp.iov_base, _nsize, NUMA_ZONE), aam_t(_lb))})
+      _stripes(stripe_count(_nsize))
   {
-    CPLOG(0, "Map_store: added memory region (%p,%lu)",_tmp.iov_base, _tmp.iov_len);
+    for (auto &s : _stripes) s.reset(new Stripe(&_shared_heap));
+    add_region({allocate_region_memory(MB(2) /* alignment */, _nsize), _nsize});
+    CPLOG(0, "Map_store: added memory region (%p,%lu) in %zu stripes",
+          _regions.front().iov_base, _regions.front().iov_len, _stripes.size());
   }
 #pragma GCC diagnostic pop
 
@@ -205,29 +387,74 @@ public:
     //      release_region_memory(r.iov_base, r.iov_len);
   }
 
-  size_t               _nsize; /*< order important */
-  ::iovec              _tmp;
-  std::vector<::iovec> _regions;
+  std::atomic<size_t>  _nsize; /*< order important */
   std::string          _name;
-  nupm::Rca_LB         _lb;
-  map_t                _map; /*< hash table based map */
-  common::RWLock       _map_lock; /*< read write lock */
   unsigned int         _flags;
-  std::set<Iterator*>  _iterators;
 
 private:
+  Stripe_heap          _shared_heap; /*< values too large for a stripe, and overflow */
+  std::vector<std::unique_ptr<Stripe>> _stripes;
+  common::RWLock       _regions_lock; /*< guards _regions and _slices */
+  std::vector<::iovec> _regions;
+  std::vector<Slice>   _slices; /*< ordered by base */
+  std::atomic<size_t>  _next_heap{0}; /*< round robin for pool memory */
+  std::mutex           _iterators_lock;
+  std::set<Iterator*>  _iterators;
+  std::atomic<bool>    _time_indexed{false};
+  std::mutex           _time_index_lock; /*< leaf lock, taken under stripe locks */
+  std::unique_ptr<common::Time_index> _time_index;
+
   /*
     We use this counter to see if new writes have come in
     during an iteration.  This is essentially an optmistic
     locking strategy.
   */
-  uint32_t             _writes __attribute__((aligned(4)));
+  std::atomic<uint32_t> _writes{0};
 
   inline void write_touch() { _writes++; }
   inline uint32_t writes() const { return _writes; }
 
-  aac_t aac{_lb};
-  aal_t aal{_lb};
+  Stripe &stripe(const char *key, size_t key_len) const {
+    /* high hash bits: the low bits choose buckets within the stripe */
+    return *_stripes[(CityHash64(key, key_len) >> 40) % _stripes.size()];
+  }
+
+  void add_region(const ::iovec &region);
+
+  void index_touch(const std::string &key, const Value_type &v) {
+    if (_time_indexed) {
+      Std_lock_guard g(_time_index_lock);
+      if (_time_index) _time_index->touch(key, v._tsc.raw());
+    }
+  }
+
+  void index_erase(const std::string &key) {
+    if (_time_indexed) {
+      Std_lock_guard g(_time_index_lock);
+      if (_time_index) _time_index->erase(key);
+    }
+  }
+
+  bool index_window(const common::epoch_time_t t_begin,
+                    const common::epoch_time_t t_end,
+                    std::vector<std::string> &out_keys);
+
+  status_t deref_window(Iterator &i,
+                        const common::epoch_time_t t_begin,
+                        const common::epoch_time_t t_end,
+                        IKVStore::pool_reference_t& ref,
+                        bool& time_match,
+                        bool increment);
+  Stripe_heap *heap_of(const void *p);
+  void *alloc_value(Stripe &s, size_t size, size_t alignment);
+  void free_value(void *p, size_t size);
+
+  status_t lock_value(map_t::value_type &element,
+                      IKVStore::lock_type_t type,
+                      void *&out_value,
+                      size_t &out_value_len,
+                      IKVStore::key_t& out_key,
+                      const char ** out_key_ptr);
 
 public:
   status_t put(const std::string &key, const void *value,
@@ -238,6 +465,9 @@ public:
   status_t get_direct(const std::string &key, void *out_value,
                       size_t &out_value_len);
 
+  status_t get_optimistic(IKVStore::string_view key, void *out_value,
+                          size_t &out_value_len);
+
   status_t get_attribute(const IKVStore::Attribute attr,
                          std::vector<uint64_t> &out_attr,
                          const std::string *key);
@@ -262,6 +492,8 @@ public:
 
   size_t count();
 
+  status_t configure(const std::string &setting);
+
   status_t map(std::function<int(const void * key,
                                  const size_t key_len,
                                  const void * value,
@@ -316,8 +548,6 @@ std::set<Pool_session *>                       _pool_sessions;
 std::unordered_map<std::string, Pool_handle *> _pools; /*< existing pools */
 static __thread tls_cache_t tls_cache = {nullptr};
 
-using Std_lock_guard = std::lock_guard<std::mutex>;
-
 Pool_session *get_session(const IKVStore::pool_t pid) {
   auto session = reinterpret_cast<Pool_session *>(pid);
 
@@ -332,6 +562,62 @@ Pool_session *get_session(const IKVStore::pool_t pid) {
   assert(session);
   return session;
 }
+void Pool_handle::add_region(const ::iovec &region) {
+  /* one 2MiB-aligned slice per stripe, over half the region; the other
+     half, or all of a region too small to share or with only one stripe to
+     share it, goes to the shared heap */
+  const auto base = static_cast<const char *>(region.iov_base);
+  const auto n = _stripes.size();
+  const auto slice_len = n == 1 ? 0 : region.iov_len / 2 / n / MB(2) * MB(2);
+
+  auto add_slice =
+    [this] (const char *slice_base, size_t len, Stripe_heap &heap) {
+      heap.add_managed_region(const_cast<char *>(slice_base), len, NUMA_ZONE);
+      Slice slice{slice_base, len, &heap};
+      _slices.insert(
+        std::upper_bound(_slices.begin(), _slices.end(), slice,
+                         [] (const Slice &a, const Slice &b) { return a.base < b.base; }),
+        slice);
+    };
+
+  for (size_t i = 0; slice_len != 0 && i != n; ++i) {
+    add_slice(base + i * slice_len, slice_len, _stripes[i]->heap);
+  }
+  add_slice(base + n * slice_len, region.iov_len - n * slice_len, _shared_heap);
+  _regions.push_back(region);
+}
+
+Stripe_heap *Pool_handle::heap_of(const void *p) {
+  const auto c = static_cast<const char *>(p);
+  RWLock_guard guard(_regions_lock);
+  auto i = std::upper_bound(_slices.begin(), _slices.end(), c,
+                            [] (const char *a, const Slice &s) { return a < s.base; });
+  if (i == _slices.begin()) return nullptr;
+  --i;
+  return c < i->base + i->len ? i->heap : nullptr;
+}
+
+void *Pool_handle::alloc_value(Stripe &s, size_t size, size_t alignment) {
+  /* prefer the stripe's heap, then the shared heap, but a value may live in
+     any heap */
+  try { return s.heap.alloc(size, NUMA_ZONE, alignment); }
+  catch (const std::bad_alloc &) {}
+
+  for (auto &o : _stripes) {
+    if (o.get() != &s) {
+      try { return o->heap.alloc_local(size, NUMA_ZONE, alignment); }
+      catch (const std::bad_alloc &) {}
+    }
+  }
+  throw std::bad_alloc();
+}
+
+void Pool_handle::free_value(void *p, size_t size) {
+  auto heap = heap_of(p);
+  if (heap == nullptr)
+    throw Logic_exception("Map_store: value memory %p not in pool", p);
+  heap->free(p, NUMA_ZONE, size);
+}
 
 status_t Pool_handle::put(const std::string &key,
                           const void *value,
@@ -343,33 +629,32 @@ status_t Pool_handle::put(const std::string &key,
     return E_INVAL;
   }
 
-#ifndef SINGLE_THREADED
-  RWLock_guard guard(map_lock, RWLock_guard::WRITE);
-#endif
+  auto &s = stripe(key.data(), key.length());
+  RWLock_guard guard(s.lock, RWLock_guard::WRITE);
 
   write_touch(); /* this could be early, but over-conservative is ok */
 
-  string_t k(key.data(), key.length(), aac);
+  string_t k(key.data(), key.length(), s.aac);
 
-  auto i = _map.find(k);
+  auto i = s.map.find(k);
 
-  if (i != _map.end()) {
+  if (i != s.map.end()) {
 
     if (flags & IKVStore::FLAGS_DONT_STOMP) {
       PWRN("put refuses to stomp (%s)", key.c_str());
       return IKVStore::E_KEY_EXISTS;
     }
 
+    auto &p = i->second;
+
     /* take lock */
     int rc;
-    if((rc = _map[k]._value_lock->write_trylock()) != 0) {
+    if((rc = p._value_lock->write_trylock()) != 0) {
       PWRN("put refuses, already locked (%d)",rc);
       assert(rc == EBUSY);
       return E_LOCKED;
     }
 
-    auto &p = i->second;
-
     if (p._length == value_len) {
       memcpy(p._ptr, value, value_len);
     }
@@ -378,38 +663,36 @@ status_t Pool_handle::put(const std::string &key,
       auto p_to_free = p._ptr;
       auto len_to_free = p._length;
 
-      p._ptr = _lb.alloc(value_len > 8 ? value_len : 8,
-                         NUMA_ZONE, choose_alignment(value_len));
+      p._ptr = alloc_value(s, value_len > 8 ? value_len : 8, choose_alignment(value_len));
 
       memcpy(p._ptr, value, value_len);
 
       /* update entry */
-      i->second._length = value_len > 8 ? value_len : 8;
-      i->second._ptr = p._ptr;
+      p._length = value_len > 8 ? value_len : 8;
 
       /* release old memory*/
-      try {  _lb.free(p_to_free, NUMA_ZONE, len_to_free);      }
+      try {  free_value(p_to_free, len_to_free);      }
       catch(...) {  throw Logic_exception("unable to release old value memory");   }
     }
 
     wmb();
-    i->second._tsc.update(); /* update timestamp */
+    p._tsc.update(); /* update timestamp */
+    index_touch(key, p);
 
     /* release lock */
-    _map[k]._value_lock->unlock();
+    p._value_lock->unlock();
   }
   else { /* key does not already exist */
     auto round_up_len = value_len > 8 ? value_len : 8;
-    auto buffer = _lb.alloc(round_up_len,
-                            NUMA_ZONE,
-                            choose_alignment(round_up_len));
+    auto buffer = alloc_value(s, round_up_len, choose_alignment(round_up_len));
 
     memcpy(buffer, value, value_len);
-    common::RWLock * p = new (aal.allocate(1, DEFAULT_ALIGNMENT)) common::RWLock();
+    Value_lock * p = new (s.aal.allocate(1, DEFAULT_ALIGNMENT)) Value_lock();
 
     //    auto ts = rdtsc();
     //    _map.emplace(k, Value_type{buffer, round_up_len, p, ts});
-    _map.emplace(k, Value_type{buffer, round_up_len, p});
+    auto e = s.map.emplace(k, Value_type{buffer, round_up_len, p});
+    index_touch(key, e.first->second);
   }
 
   return S_OK;
@@ -420,13 +703,12 @@ status_t Pool_handle::get(const std::string &key,
                           size_t &out_value_len) {
   CPLOG(0, "Map_store: get(%s,%p,%lu)", key.c_str(), out_value, out_value_len);
 
-#ifndef SINGLE_THREADED
-  RWLock_guard guard(map_lock);
-#endif
-  string_t k(key.c_str(), aac);
-  auto i = _map.find(k);
+  auto &s = stripe(key.data(), key.length());
+  RWLock_guard guard(s.lock);
+  string_t k(key.data(), key.length(), s.aac);
+  auto i = s.map.find(k);
 
-  if (i == _map.end()) return IKVStore::E_KEY_NOT_FOUND;
+  if (i == s.map.end()) return IKVStore::E_KEY_NOT_FOUND;
 
   out_value_len = i->second._length;
 
@@ -451,13 +733,12 @@ status_t Pool_handle::get_direct(const std::string &key,
   if (out_value == nullptr || out_value_len == 0)
     throw API_exception("invalid parameter");
 
-#ifndef SINGLE_THREADED
-  RWLock_guard guard(map_lock);
-#endif
-  string_t k(key.c_str(), aac);
-  auto i = _map.find(k);
+  auto &s = stripe(key.data(), key.length());
+  RWLock_guard guard(s.lock);
+  string_t k(key.data(), key.length(), s.aac);
+  auto i = s.map.find(k);
 
-  if (i == _map.end()) {
+  if (i == s.map.end()) {
     if (debug_level()) PERR("Map_store: error key not found");
     return IKVStore::E_KEY_NOT_FOUND;
   }
@@ -474,6 +755,43 @@ status_t Pool_handle::get_direct(const std::string &key,
   return S_OK;
 }
 
+status_t Pool_handle::get_optimistic(const IKVStore::string_view key,
+                                     void *out_value,
+                                     size_t &out_value_len) {
+  /* attempts to copy a value which changes under the copy */
+  static constexpr unsigned attempts = 3;
+
+  auto &s = stripe(key.data(), key.size());
+  RWLock_guard guard(s.lock);
+  /* unordered_map has no lookup by string_view; short keys fit the
+     string's internal buffer and are not allocated */
+  auto i = s.map.find(string_t(key.data(), key.size(), s.aac));
+
+  if (i == s.map.end()) return IKVStore::E_KEY_NOT_FOUND;
+
+  const auto &v = i->second;
+  for (unsigned a = 0; a != attempts; ++a) {
+    const auto version = v._value_lock->version(std::memory_order_acquire);
+    if (version % 2 != 0) break; /* write locked */
+
+    const auto ptr = v._ptr;
+    const auto len = v._length;
+    if (out_value_len < len) {
+      out_value_len = len;
+      return E_INSUFFICIENT_BUFFER;
+    }
+    memcpy(out_value, ptr, len);
+
+    /* loads of the value precede the validating load */
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (v._value_lock->version(std::memory_order_relaxed) == version) {
+      out_value_len = len;
+      return S_OK;
+    }
+  }
+  return E_BUSY;
+}
+
 status_t Pool_handle::get_attribute(const IKVStore::Attribute attr,
                                     std::vector<uint64_t> &out_attr,
                                     const std::string *key) {
@@ -484,27 +802,26 @@ status_t Pool_handle::get_attribute(const IKVStore::Attribute attr,
   }
   case IKVStore::Attribute::VALUE_LEN: {
     if (key == nullptr) return E_INVALID_ARG;
-#ifndef SINGLE_THREADED
-    RWLock_guard guard(map_lock);
-#endif
-    string_t k(key->c_str(), aac);
-    auto i = _map.find(k);
-    if (i == _map.end()) return IKVStore::E_KEY_NOT_FOUND;
+    auto &s = stripe(key->data(), key->length());
+    RWLock_guard guard(s.lock);
+    string_t k(key->data(), key->length(), s.aac);
+    auto i = s.map.find(k);
+    if (i == s.map.end()) return IKVStore::E_KEY_NOT_FOUND;
     out_attr.push_back(i->second._length);
     break;
   }
   case IKVStore::Attribute::WRITE_EPOCH_TIME: {
-#ifndef SINGLE_THREADED
-    RWLock_guard guard(map_lock);
-#endif
-    string_t k(key->c_str(), aac);
-    auto i = _map.find(k);
-    if (i == _map.end()) return IKVStore::E_KEY_NOT_FOUND;
+    if (key == nullptr) return E_INVALID_ARG;
+    auto &s = stripe(key->data(), key->length());
+    RWLock_guard guard(s.lock);
+    string_t k(key->data(), key->length(), s.aac);
+    auto i = s.map.find(k);
+    if (i == s.map.end()) return IKVStore::E_KEY_NOT_FOUND;
     out_attr.push_back(boost::numeric_cast<uint64_t>(i->second._tsc.to_epoch().seconds()));
     break;
   }
   case IKVStore::Attribute::COUNT: {
-    out_attr.push_back(_map.size());
+    out_attr.push_back(count());
     break;
   }
   default:
@@ -519,13 +836,24 @@ status_t Pool_handle::get_attribute(const IKVStore::Attribute attr,
 status_t Pool_handle::swap_keys(const std::string key0,
                                 const std::string key1)
 {
-  string_t k0(key0.data(), key0.length(), aac);
-  auto i0 = _map.find(k0);
-  if(i0 == _map.end()) return IKVStore::E_KEY_NOT_FOUND;
+  auto &s0 = stripe(key0.data(), key0.length());
+  auto &s1 = stripe(key1.data(), key1.length());
+
+  /* when the keys are in different stripes, the stripe locks are taken in
+     address order */
+  auto &first = std::less<Stripe *>()(&s0, &s1) ? s0 : s1;
+  auto &second = &first == &s0 ? s1 : s0;
+  RWLock_guard guard_first(first.lock, RWLock_guard::WRITE);
+  std::unique_ptr<RWLock_guard> guard_second(
+    &second == &first ? nullptr : new RWLock_guard(second.lock, RWLock_guard::WRITE));
 
-  string_t k1(key1.data(), key1.length(), aac);
-  auto i1 = _map.find(k1);
-  if(i1 == _map.end()) return IKVStore::E_KEY_NOT_FOUND;
+  string_t k0(key0.data(), key0.length(), s0.aac);
+  auto i0 = s0.map.find(k0);
+  if(i0 == s0.map.end()) return IKVStore::E_KEY_NOT_FOUND;
+
+  string_t k1(key1.data(), key1.length(), s1.aac);
+  auto i1 = s1.map.find(k1);
+  if(i1 == s1.map.end()) return IKVStore::E_KEY_NOT_FOUND;
 
   /* lock both k-v pairs */
   auto& left = i0->second;
@@ -553,6 +881,64 @@ status_t Pool_handle::swap_keys(const std::string key0,
   return S_OK;
 }
 
+status_t Pool_handle::lock_value(map_t::value_type &element,
+                                 IKVStore::lock_type_t type,
+                                 void *&out_value,
+                                 size_t &out_value_len,
+                                 IKVStore::key_t& out_key,
+                                 const char ** out_key_ptr)
+{
+  auto &v = element.second;
+
+  if (type == IKVStore::STORE_LOCK_READ) {
+    if(v._value_lock->read_trylock() != 0) {
+      if(debug_level())
+        PWRN("Map_store: key (%s) unable to take read lock", element.first.c_str());
+
+      out_key = IKVStore::KEY_NONE;
+      return E_LOCKED;
+    }
+  }
+  else if (type == IKVStore::STORE_LOCK_WRITE) {
+
+    write_touch();
+
+    if(v._value_lock->write_trylock() != 0) {
+      if(debug_level())
+        PWRN("Map_store: key (%s) unable to take write lock", element.first.c_str());
+
+      out_key = IKVStore::KEY_NONE;
+      return E_LOCKED;
+    }
+
+  }
+  else throw API_exception("invalid lock type");
+
+  out_value = v._ptr;
+  out_value_len = v._length;
+
+  out_key = reinterpret_cast<IKVStore::key_t>(v._value_lock);
+
+  /* C++11 standard: § 23.2.5/8
+
+     The elements of an unordered associative container are organized
+     into buckets. Keys with the same hash code appear in the same
+     bucket. The number of buckets is automatically increased as
+     elements are added to an unordered associative container, so that
+     the average number of elements per bucket is kept below a
+     bound. Rehashing invalidates iterators, changes ordering between
+     elements, and changes which buckets elements appear in, but does
+     not invalidate pointers or references to elements. For
+     unordered_multiset and unordered_multimap, rehashing preserves
+     the relative ordering of equivalent elements.
+  */
+  if(out_key_ptr) {
+    *out_key_ptr = element.first.c_str();
+  }
+
+  return S_OK;
+}
+
 status_t Pool_handle::lock(const std::string &key,
                            IKVStore::lock_type_t type,
                            void *&out_value,
@@ -560,19 +946,29 @@ status_t Pool_handle::lock(const std::string &key,
                            IKVStore::key_t& out_key,
                            const char ** out_key_ptr)
 {
-
-  void *buffer = nullptr;
-  string_t k(key.c_str(), aac);
-  bool created = false;
-
-  auto i = _map.find(k);
+  auto &s = stripe(key.data(), key.length());
+  string_t k(key.data(), key.length(), s.aac);
 
   CPLOG(0, "Map_store: looking for key:(%s)", key.c_str());
 
   if(out_value_len != 0 && out_value_len < 8)
     out_value_len = 8; /* minimum object size */
 
-  if (i == _map.end()) {
+  /* an existing key needs only the stripe read lock */
+  {
+    RWLock_guard guard(s.lock);
+    auto i = s.map.find(k);
+    if (i != s.map.end()) {
+      CPLOG(0, "Map_store: got key");
+      return lock_value(*i, type, out_value, out_value_len, out_key, out_key_ptr);
+    }
+  }
+
+  RWLock_guard guard(s.lock, RWLock_guard::WRITE);
+  auto i = s.map.find(k);
+  bool created = false;
+
+  if (i == s.map.end()) {
 
     write_touch();
 
@@ -586,7 +982,7 @@ status_t Pool_handle::lock(const std::string &key,
 
     CPLOG(0, "Map_store: lock is on-demand allocating:(%s) %lu", key.c_str(), out_value_len);
 
-    buffer = _lb.alloc(out_value_len, NUMA_ZONE, choose_alignment(out_value_len));
+    void *buffer = alloc_value(s, out_value_len, choose_alignment(out_value_len));
 
     if (buffer == nullptr)
       throw General_exception("Pool_handle::lock on-demand create allocate_memory failed (len=%lu)",
@@ -597,61 +993,17 @@ status_t Pool_handle::lock(const std::string &key,
            key.c_str(),
            out_value_len);
 
-    common::RWLock * p = new (aal.allocate(1, DEFAULT_ALIGNMENT)) common::RWLock();
+    Value_lock * p = new (s.aal.allocate(1, DEFAULT_ALIGNMENT)) Value_lock();
 
-    _map.emplace(k, Value_type{buffer, out_value_len, p});
+    i = s.map.emplace(k, Value_type{buffer, out_value_len, p}).first;
+    index_touch(key, i->second);
   }
 
   CPLOG(0, "Map_store: got key");
 
-  if (type == IKVStore::STORE_LOCK_READ) {
-    if(_map[k]._value_lock->read_trylock() != 0) {
-      if(debug_level())
-        PWRN("Map_store: key (%s) unable to take read lock", key.c_str());
-
-      out_key = IKVStore::KEY_NONE;
-      return E_LOCKED;
-    }
-  }
-  else if (type == IKVStore::STORE_LOCK_WRITE) {
+  auto rc = lock_value(*i, type, out_value, out_value_len, out_key, out_key_ptr);
 
-    write_touch();
-
-    if(_map[k]._value_lock->write_trylock() != 0) {
-      if(debug_level())
-        PWRN("Map_store: key (%s) unable to take write lock", key.c_str());
-
-      out_key = IKVStore::KEY_NONE;
-      return E_LOCKED;
-    }
-
-  }
-  else throw API_exception("invalid lock type");
-
-  out_value = _map[k]._ptr;
-  out_value_len = _map[k]._length;
-
-  out_key = reinterpret_cast<IKVStore::key_t>(_map[k]._value_lock);
-
-  /* C++11 standard: § 23.2.5/8
-
-     The elements of an unordered associative container are organized
-     into buckets. Keys with the same hash code appear in the same
-     bucket. The number of buckets is automatically increased as
-     elements are added to an unordered associative container, so that
-     the average number of elements per bucket is kept below a
-     bound. Rehashing invalidates iterators, changes ordering between
-     elements, and changes which buckets elements appear in, but does
-     not invalidate pointers or references to elements. For
-     unordered_multiset and unordered_multimap, rehashing preserves
-     the relative ordering of equivalent elements.
-  */
-  if(out_key_ptr) {
-    auto element = _map.find(k);
-    *out_key_ptr = element->first.c_str();
-  }
-
-  return created ? S_OK_CREATED : S_OK;
+  return rc == S_OK && created ? S_OK_CREATED : rc;
 }
 
 status_t Pool_handle::unlock(IKVStore::key_t key_handle) {
@@ -659,7 +1011,7 @@ status_t Pool_handle::unlock(IKVStore::key_t key_handle) {
   if(key_handle == nullptr) return E_INVAL;
 
   /* TODO: how do we know key_handle is valid? */
-  if(reinterpret_cast<common::RWLock *>(key_handle)->unlock() != 0) {
+  if(reinterpret_cast<Value_lock *>(key_handle)->unlock() != 0) {
     PWRN("Map_store: bad parameter to unlock");
     return E_INVAL;
   }
@@ -667,13 +1019,12 @@ status_t Pool_handle::unlock(IKVStore::key_t key_handle) {
 }
 
 status_t Pool_handle::erase(const std::string &key) {
-#ifndef SINGLE_THREADED
-  RWLock_guard guard(map_lock, RWLock_guard::WRITE);
-#endif
-  string_t k(key.c_str(), aac);
-  auto i = _map.find(k);
+  auto &s = stripe(key.data(), key.length());
+  RWLock_guard guard(s.lock, RWLock_guard::WRITE);
+  string_t k(key.data(), key.length(), s.aac);
+  auto i = s.map.find(k);
 
-  if (i == _map.end()) return IKVStore::E_KEY_NOT_FOUND;
+  if (i == s.map.end()) return IKVStore::E_KEY_NOT_FOUND;
 
   if(i->second._value_lock->write_trylock() != 0) { /* check pair is not locked */
     if(debug_level())
@@ -684,19 +1035,23 @@ status_t Pool_handle::erase(const std::string &key) {
 
 
   write_touch();
-  _map.erase(i);
+  const auto v = i->second;
+  s.map.erase(i);
+  index_erase(key);
 
-  _lb.free(i->second._ptr, NUMA_ZONE, i->second._length);
-  aal.deallocate(i->second._value_lock, 1, DEFAULT_ALIGNMENT);
+  free_value(v._ptr, v._length);
+  s.aal.deallocate(v._value_lock, 1, DEFAULT_ALIGNMENT);
 
   return S_OK;
 }
 
 size_t Pool_handle::count() {
-#ifndef SINGLE_THREADED
-  RWLock_guard guard(map_lock);
-#endif
-  return _map.size();
+  size_t n = 0;
+  for (auto &s : _stripes) {
+    RWLock_guard guard(s->lock);
+    n += s->map.size();
+  }
+  return n;
 }
 
 status_t Pool_handle::map(std::function<int(const void * key,
@@ -704,13 +1059,13 @@ status_t Pool_handle::map(std::function<int(const void * key,
                                             const void * value,
                                             const size_t value_len)> function)
 {
-#ifndef SINGLE_THREADED
-  RWLock_guard guard(map_lock);
-#endif
+  for (auto &s : _stripes) {
+    RWLock_guard guard(s->lock);
 
-  for (auto &pair : _map) {
-    auto val = pair.second;
-    function(pair.first.c_str(), pair.first.length(), val._ptr, val._length);
+    for (auto &pair : s->map) {
+      auto val = pair.second;
+      function(pair.first.c_str(), pair.first.length(), val._ptr, val._length);
+    }
   }
 
   return S_OK;
@@ -724,23 +1079,46 @@ status_t Pool_handle::map(std::function<int(const void* key,
                           const common::epoch_time_t t_begin,
                           const common::epoch_time_t t_end)
 {
-#ifndef SINGLE_THREADED
-  RWLock_guard guard(map_lock);
-#endif
-
   common::tsc_time_t begin_tsc(t_begin);
   common::tsc_time_t end_tsc(t_end);
 
-  for (auto &pair : _map) {
-    auto val = pair.second;
+  std::vector<std::string> window;
+  if (index_window(t_begin, t_end, window)) {
+    /* visit the keys in the window, oldest first */
+    for (const auto &key : window) {
+      auto &s = stripe(key.data(), key.length());
+      RWLock_guard guard(s.lock);
+      auto i = s.map.find(string_t(key.data(), key.length(), s.aac));
+      if (i == s.map.end()) continue; /* erased since */
+      const auto &val = i->second;
+
+      if(val._tsc >= begin_tsc && (end_tsc == 0 || val._tsc <= end_tsc)) {
+        if(function(i->first.c_str(),
+                    i->first.length(),
+                    val._ptr,
+                    val._length,
+                    val._tsc) < 0) {
+          return S_MORE;
+        }
+      }
+    }
+    return S_OK;
+  }
+
+  for (auto &s : _stripes) {
+    RWLock_guard guard(s->lock);
 
-    if(val._tsc >= begin_tsc && (end_tsc == 0 || val._tsc <= end_tsc)) {
-      if(function(pair.first.c_str(),
-                  pair.first.length(),
-                  val._ptr,
-                  val._length,
-                  val._tsc) < 0) {
-        return S_MORE; /* break out of the loop if function returns < 0 */
+    for (auto &pair : s->map) {
+      auto val = pair.second;
+
+      if(val._tsc >= begin_tsc && (end_tsc == 0 || val._tsc <= end_tsc)) {
+        if(function(pair.first.c_str(),
+                    pair.first.length(),
+                    val._ptr,
+                    val._length,
+                    val._tsc) < 0) {
+          return S_MORE; /* break out of the loop if function returns < 0 */
+        }
       }
     }
   }
@@ -750,63 +1128,109 @@ status_t Pool_handle::map(std::function<int(const void* key,
 
 
 status_t Pool_handle::map_keys(std::function<int(const std::string &key)> function) {
-#ifndef SINGLE_THREADED
-  RWLock_guard guard(map_lock);
-#endif
+  for (auto &s : _stripes) {
+    RWLock_guard guard(s->lock);
 
-  for (auto &pair : _map) function(std::string(pair.first.c_str()));
+    for (auto &pair : s->map) function(std::string(pair.first.c_str()));
+  }
 
   return S_OK;
 }
 
+status_t Pool_handle::configure(const std::string &setting) {
+  if (setting == "AddIndex::Time") {
+    {
+      Std_lock_guard g(_time_index_lock);
+      if (_time_index) return S_OK;
+      _time_index.reset(new common::Time_index());
+      _time_indexed = true;
+    }
+
+    /* writes are indexed from here on; add the existing keys. A write and
+       the scan of its stripe are ordered by the stripe lock, so the index
+       ends with the later time. */
+    for (auto &s : _stripes) {
+      RWLock_guard guard(s->lock);
+      Std_lock_guard g(_time_index_lock);
+      if (!_time_index) return S_OK; /* removed meanwhile */
+      for (auto &pair : s->map)
+        _time_index->touch(std::string(pair.first.data(), pair.first.length()), pair.second._tsc.raw());
+    }
+    CPLOG(1, "Map_store: time index added to pool (%s)", _name.c_str());
+    return S_OK;
+  }
+
+  if (setting == "RemoveIndex::Time") {
+    Std_lock_guard g(_time_index_lock);
+    _time_indexed = false;
+    _time_index.reset();
+    return S_OK;
+  }
+
+  PWRN("Map_store: unknown pool setting (%s)", setting.c_str());
+  return E_BAD_PARAM;
+}
+
+bool Pool_handle::index_window(const common::epoch_time_t t_begin,
+                               const common::epoch_time_t t_end,
+                               std::vector<std::string> &out_keys) {
+  if (!_time_indexed) return false;
+
+  common::tsc_time_t begin_tsc(t_begin);
+  common::tsc_time_t end_tsc(t_end);
+
+  /* an unconstrained window is the whole pool; a scan is as good */
+  if (begin_tsc == 0 && end_tsc == 0) return false;
+
+  Std_lock_guard g(_time_index_lock);
+  if (!_time_index) return false;
+  out_keys = _time_index->keys_in_range(begin_tsc.raw(),
+                                        end_tsc == 0 ? std::numeric_limits<common::Time_index::time_type>::max() : end_tsc.raw());
+  return true;
+}
+
 status_t Pool_handle::resize_value(const std::string &key,
                                    const size_t new_size,
                                    const size_t alignment) {
   if (new_size == 0) return E_INVAL;
 
-#ifndef SINGLE_THREADED
-  RWLock_guard guard(map_lock);
-#endif
+  auto &s = stripe(key.data(), key.length());
+  RWLock_guard guard(s.lock, RWLock_guard::WRITE);
 
-  auto i = _map.find(string_t(key.c_str(), aac));
+  auto i = s.map.find(string_t(key.data(), key.length(), s.aac));
 
-  if (i == _map.end()) return IKVStore::E_KEY_NOT_FOUND;
-  if (i->second._length == new_size) return E_INVAL;
+  if (i == s.map.end()) return IKVStore::E_KEY_NOT_FOUND;
+  auto &v = i->second;
+  if (v._length == new_size) return E_INVAL;
 
   write_touch();
 
   /* perform resize */
-  auto buffer = _lb.alloc(new_size, NUMA_ZONE, alignment);
+  auto buffer = alloc_value(s, new_size, alignment);
 
   /* lock KV-pair */
-  void *out_value;
-  size_t out_value_len;
-  IKVStore::key_t out_key;
-  status_t s = lock(key,
-                    IKVStore::STORE_LOCK_WRITE,
-                    out_value,
-                    out_value_len,
-                    out_key,
-                    nullptr);
-
-  if (out_key == IKVStore::KEY_NONE) return E_INVAL;
+  if (v._value_lock->write_trylock() != 0) {
+    free_value(buffer, new_size);
+    return E_INVAL;
+  }
 
-  size_t size_to_copy = std::min<size_t>(new_size, boost::numeric_cast<size_t>(i->second._length));
+  size_t size_to_copy = std::min<size_t>(new_size, boost::numeric_cast<size_t>(v._length));
 
-  memcpy(buffer, i->second._ptr, size_to_copy);
+  memcpy(buffer, v._ptr, size_to_copy);
 
   /* free previous memory */
-  _lb.free(i->second._ptr, NUMA_ZONE, i->second._length);
+  free_value(v._ptr, v._length);
 
-  i->second._ptr = buffer;
-  i->second._length = new_size;
+  v._ptr = buffer;
+  v._length = new_size;
 
   /* release lock */
-  unlock(out_key);
-  return s;
+  v._value_lock->unlock();
+  return S_OK;
 }
 
 status_t Pool_handle::get_pool_regions(std::vector<::iovec> &out_regions) {
+  RWLock_guard guard(_regions_lock);
   if (_regions.empty()) {
     return E_INVAL;
   }
@@ -820,23 +1244,23 @@ status_t Pool_handle::grow_pool(const size_t increment_size,
   if (increment_size <= 0) {
     return E_INVAL;
   }
-  reconfigured_size = _nsize + increment_size;
   void *new_region = allocate_region_memory(DEFAULT_ALIGNMENT, increment_size);
-  _lb.add_managed_region(new_region, increment_size, NUMA_ZONE);
-  _regions.push_back({new_region, increment_size});
-  _nsize = reconfigured_size;
+  RWLock_guard guard(_regions_lock, RWLock_guard::WRITE);
+  add_region({new_region, increment_size});
+  reconfigured_size = _nsize += increment_size;
   return S_OK;
 }
 
 status_t Pool_handle::free_pool_memory(const void *addr, const size_t size) {
-  if (!addr || _regions.empty()) {
+  auto heap = addr ? heap_of(addr) : nullptr;
+  if (heap == nullptr) {
     return E_INVAL;
   }
 
   if(size)
-    _lb.free(const_cast<void *>(addr), NUMA_ZONE, size);
+    heap->free(const_cast<void *>(addr), NUMA_ZONE, size);
   else
-    _lb.free(const_cast<void *>(addr), NUMA_ZONE); //, size);
+    heap->free(const_cast<void *>(addr), NUMA_ZONE); //, size);
 
   /* the regions are not freed */
   return S_OK;
@@ -845,7 +1269,7 @@ status_t Pool_handle::free_pool_memory(const void *addr, const size_t size) {
 status_t Pool_handle::allocate_pool_memory(const size_t size,
                                            const size_t alignment,
                                            void *&out_addr) {
-  if (size == 0 || size > _nsize || _regions.empty()) {
+  if (size == 0 || size > _nsize) {
     PWRN("Map_store: invalid allocate_pool_memory request");
     return E_INVAL;
   }
@@ -855,7 +1279,8 @@ status_t Pool_handle::allocate_pool_memory(const size_t size,
 
   try {
     /* we can't fully support alignment choice */
-    out_addr = _lb.alloc(size, NUMA_ZONE, (alignment > 0) && (size % alignment == 0) ? alignment : choose_alignment(size));
+    out_addr = alloc_value(*_stripes[_next_heap++ % _stripes.size()],
+                           size, (alignment > 0) && (size % alignment == 0) ? alignment : choose_alignment(size));
   }
   catch(...) {
     PWRN("Map_store: unable to allocate (%lu) bytes aligned by %lu", size, choose_alignment(size));
@@ -869,6 +1294,8 @@ status_t Pool_handle::allocate_pool_memory(const size_t size,
 IKVStore::pool_iterator_t Pool_handle::open_pool_iterator()
 {
   auto i = new Iterator(this);
+  i->settle();
+  Std_lock_guard g(_iterators_lock);
   _iterators.insert(i);
   return reinterpret_cast<IKVStore::pool_iterator_t>(i);
 }
@@ -881,45 +1308,99 @@ status_t Pool_handle::deref_pool_iterator(IKVStore::pool_iterator_t iter,
                                           bool increment)
 {
   auto i = reinterpret_cast<Iterator*>(iter);
-  if(_iterators.count(i) != 1) return E_INVAL;
+  {
+    Std_lock_guard g(_iterators_lock);
+    if(_iterators.count(i) != 1) return E_INVAL;
+  }
+
+  if(i->_fresh) {
+    i->_fresh = false;
+    i->_windowed = index_window(t_begin, t_end, i->_window);
+  }
+  if(i->_windowed) return deref_window(*i, t_begin, t_end, ref, time_match, increment);
+
   if(i->is_end()) return E_OUT_OF_BOUNDS;
-  if(!i->check_mark(_writes)) return E_ITERATOR_DISTURBED;
 
-  common::tsc_time_t begin_tsc(t_begin);
-  common::tsc_time_t end_tsc(t_end);
+  /* the mark is checked under the stripe lock, which excludes writes to
+     the elements in the stripe */
+  {
+    RWLock_guard guard(_stripes[i->_stripe]->lock);
+    if(!i->check_mark(_writes)) return E_ITERATOR_DISTURBED;
 
-  auto r = i->_iter;
-  ref.key = r->first.data();
-  ref.key_len = r->first.length();
-  ref.value = r->second._ptr;
-  ref.value_len = r->second._length;
+    common::tsc_time_t begin_tsc(t_begin);
+    common::tsc_time_t end_tsc(t_end);
 
-  ref.timestamp = r->second._tsc.to_epoch();
+    auto r = i->_iter;
+    ref.key = r->first.data();
+    ref.key_len = r->first.length();
+    ref.value = r->second._ptr;
+    ref.value_len = r->second._length;
 
-  /* leave condition in timestamp cycles for better accuracy */
-  time_match = (r->second._tsc >= begin_tsc) && (end_tsc == 0 || r->second._tsc <= end_tsc);
+    ref.timestamp = r->second._tsc.to_epoch();
 
-  if(increment) {
-    try {
-      i->_iter++;
-    }
-    catch(...) {
-      return E_ITERATOR_DISTURBED;
+    /* leave condition in timestamp cycles for better accuracy */
+    time_match = (r->second._tsc >= begin_tsc) && (end_tsc == 0 || r->second._tsc <= end_tsc);
+
+    if(increment) {
+      try {
+        i->_iter++;
+      }
+      catch(...) {
+        return E_ITERATOR_DISTURBED;
+      }
     }
   }
 
+  if(increment) i->settle();
+
   return S_OK;
 }
 
+status_t Pool_handle::deref_window(Iterator &i,
+                                   const common::epoch_time_t t_begin,
+                                   const common::epoch_time_t t_end,
+                                   IKVStore::pool_reference_t& ref,
+                                   bool& time_match,
+                                   bool increment)
+{
+  /* keys are found by name, so writes do not disturb the iterator; keys
+     erased since the window was taken are skipped */
+  common::tsc_time_t begin_tsc(t_begin);
+  common::tsc_time_t end_tsc(t_end);
+
+  for ( ; i._window_pos != i._window.size(); ++i._window_pos) {
+    const auto &key = i._window[i._window_pos];
+    auto &s = stripe(key.data(), key.length());
+    RWLock_guard guard(s.lock);
+    auto r = s.map.find(string_t(key.data(), key.length(), s.aac));
+    if (r == s.map.end()) continue;
+
+    ref.key = r->first.data();
+    ref.key_len = r->first.length();
+    ref.value = r->second._ptr;
+    ref.value_len = r->second._length;
+    ref.timestamp = r->second._tsc.to_epoch();
+
+    /* the key may have been rewritten since the window was taken */
+    time_match = (r->second._tsc >= begin_tsc) && (end_tsc == 0 || r->second._tsc <= end_tsc);
+
+    if(increment) ++i._window_pos;
+    return S_OK;
+  }
+  return E_OUT_OF_BOUNDS;
+}
+
 status_t Pool_handle::close_pool_iterator(IKVStore::pool_iterator_t iter)
 {
   auto i = reinterpret_cast<Iterator*>(iter);
-  if(iter == nullptr || _iterators.erase(i) != 1) return E_INVAL;
+  {
+    Std_lock_guard g(_iterators_lock);
+    if(iter == nullptr || _iterators.erase(i) != 1) return E_INVAL;
+  }
   delete i;
   return S_OK;
 }
 
-
 /** Main class */
 
 Map_store::Map_store(const std::string&, const std::string &)
@@ -988,6 +1469,8 @@ IKVStore::pool_t Map_store::open_pool(const std::string &name,
                                       unsigned int /*flags*/) {
   const std::string &key = name;
 
+  Std_lock_guard g(_pool_sessions_lock);
+
   Pool_handle *ph = nullptr;
   /* see if a pool exists that matches the key */
   for (auto &h : _pools) {
@@ -1086,6 +1569,14 @@ status_t Map_store::get_direct(const pool_t pid, const std::string &key,
   return session->pool->get_direct(key, out_value, out_value_len);
 }
 
+status_t Map_store::get_optimistic(const pool_t pid, const string_view key,
+                                   void *out_value, size_t &out_value_len) {
+  auto session = get_session(pid);
+  if (!session) return IKVStore::E_POOL_NOT_FOUND;
+
+  return session->pool->get_optimistic(key, out_value, out_value_len);
+}
+
 status_t Map_store::put_direct(const pool_t pid, const std::string &key,
                                const void *value, const size_t value_len,
                                memory_handle_t /*memory_handle*/,
@@ -1172,6 +1663,13 @@ size_t Map_store::count(const pool_t pid) {
   return session->pool->count();
 }
 
+status_t Map_store::configure_pool(const pool_t pid, const std::string &setting) {
+  auto session = get_session(pid);
+  if (!session) return IKVStore::E_POOL_NOT_FOUND;
+
+  return session->pool->configure(setting);
+}
+
 status_t Map_store::free_memory(void *p) {
   //   return free_memory(p);
   ::free(p);
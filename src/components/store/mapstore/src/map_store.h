@@ -63,7 +63,7 @@ public:
 
 public:
   /* IKVStore */
-  virtual int thread_safety() const override { return THREAD_MODEL_RWLOCK_PER_POOL; }
+  virtual int thread_safety() const override { return THREAD_MODEL_MULTI_PER_POOL; }
 
   virtual int get_capability(Capability cap) const override;
 
@@ -89,6 +89,9 @@ public:
                               size_t &out_value_len,
                               IKVStore::memory_handle_t handle) override;
 
+  virtual status_t get_optimistic(const pool_t pool, string_view key, void *out_value,
+                                  size_t &out_value_len) override;
+
   virtual status_t put_direct(const pool_t pool, const std::string &key,
                               const void *value, const size_t value_len,
                               IKVStore::memory_handle_t handle = HANDLE_NONE,
@@ -120,6 +123,8 @@ public:
 
   virtual size_t count(const pool_t pool) override;
 
+  virtual status_t configure_pool(const pool_t pool, const std::string &setting) override;
+
   virtual status_t free_memory(void *p) override;
 
   virtual status_t map(const pool_t pool,
@@ -357,6 +357,35 @@ TEST_F(KVStore_test, KeySwap)
   ASSERT_TRUE(_kvstore->close_pool(pool) == S_OK);
 }
 
+TEST_F(KVStore_test, LargeValue)
+{
+  ASSERT_TRUE(_kvstore);
+  /* four stripes, each with a 16MiB slice: the value fits none of them */
+  ::setenv("MAPSTORE_STRIPES", "4", 1);
+  pool = _kvstore->create_pool("large-value", MB(128));
+  ::unsetenv("MAPSTORE_STRIPES");
+  ASSERT_TRUE(pool != IKVStore::POOL_ERROR);
+
+  std::string large(MB(40), 'L');
+  std::string small(KB(8), 's');
+  ASSERT_OK(_kvstore->put(pool, "large", large.data(), large.length()));
+  ASSERT_OK(_kvstore->put(pool, "small", small.data(), small.length()));
+
+  void * value = nullptr;
+  size_t value_len = 0;
+  ASSERT_OK(_kvstore->get(pool, "large", value, value_len));
+  ASSERT_EQ(large.length(), value_len);
+  ASSERT_EQ(0, memcmp(value, large.data(), value_len));
+  _kvstore->free_memory(value);
+
+  /* the space is reusable once freed */
+  ASSERT_OK(_kvstore->erase(pool, "large"));
+  large.assign(MB(40), 'M');
+  ASSERT_OK(_kvstore->put(pool, "large", large.data(), large.length()));
+
+  ASSERT_OK(_kvstore->close_pool(pool));
+  ASSERT_OK(_kvstore->delete_pool("large-value"));
+}
 
 } // namespace
 
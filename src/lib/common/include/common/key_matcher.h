@@ -0,0 +1,86 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef _MCAS_COMMON_KEY_MATCHER_H_
+#define _MCAS_COMMON_KEY_MATCHER_H_
+
+#include <cstddef>
+#include <memory>
+#include <regex>
+#include <string>
+
+namespace common
+{
+/**
+ * Substring search. Uses AVX2 where the CPU supports it, else SSE2.
+ *
+ * @param haystack Data to search
+ * @param haystack_len Length of data
+ * @param needle Substring to search for
+ * @param needle_len Length of substring
+ *
+ * @return Pointer to the first occurrence in haystack, or nullptr
+ */
+const char *find_substring(const char *haystack, std::size_t haystack_len, const char *needle, std::size_t needle_len);
+
+/**
+ * Key match expression, compiled once and applied to many keys. Besides
+ * the match itself, a matcher reports the literal prefix shared by all
+ * keys which can match, so that an ordered index can seek to the first
+ * candidate and stop at the last.
+ */
+class Key_matcher {
+ public:
+  enum type_t {
+    MATCH_ANY,       /*< every key */
+    MATCH_EXACT,     /*< key equal to expression */
+    MATCH_PREFIX,    /*< key starts with expression */
+    MATCH_SUBSTRING, /*< key contains expression */
+    MATCH_REGEX,     /*< key matches (ECMAScript) regular expression */
+  };
+
+  /**
+   * Constructor. Throws std::regex_error for a bad regular expression.
+   *
+   * @param type Type of match
+   * @param expression Expression
+   */
+  Key_matcher(type_t type, const std::string &expression);
+
+  Key_matcher(const Key_matcher &) = delete;
+  Key_matcher &operator=(const Key_matcher &) = delete;
+
+  type_t             type() const { return _type; }
+  const std::string &expression() const { return _expr; }
+
+  /* literal prefix of every key which can match; empty if there is none */
+  const std::string &prefix() const { return _prefix; }
+
+  bool has_prefix(const char *key, std::size_t key_len) const
+  {
+    return key_len >= _prefix.size() && _prefix.compare(0, _prefix.size(), key, _prefix.size()) == 0;
+  }
+
+  bool match(const char *key, std::size_t key_len) const;
+  bool match(const std::string &key) const { return match(key.data(), key.size()); }
+
+ private:
+  type_t                      _type;
+  std::string                 _expr;
+  std::string                 _prefix;
+  std::unique_ptr<std::regex> _re;
+};
+
+}  // namespace common
+
+#endif
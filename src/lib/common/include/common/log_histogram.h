@@ -0,0 +1,100 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef _MCAS_COMMON_LOG_HISTOGRAM_H_
+#define _MCAS_COMMON_LOG_HISTOGRAM_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace common
+{
+/**
+ * Log-bucketed histogram in the style of HdrHistogram: each power of two is
+ * divided into 2^SUB_BITS linear sub-buckets, so a recorded value is known
+ * to within 1/2^SUB_BITS of itself (12.5% for the default). Values below
+ * 2^(SUB_BITS+1) have a bucket each; values of 2^MAX_BITS and above share
+ * the last bucket. Recording is a count-leading-zeros, a shift and an
+ * increment. Not thread safe.
+ */
+template <unsigned SUB_BITS = 3, unsigned MAX_BITS = 40>
+class Log_histogram {
+  static_assert(SUB_BITS < MAX_BITS && MAX_BITS < 64, "bad Log_histogram bounds");
+
+ public:
+  static constexpr unsigned sub_bits     = SUB_BITS;
+  static constexpr unsigned max_bits     = MAX_BITS;
+  static constexpr unsigned sub_count    = 1U << SUB_BITS;
+  static constexpr unsigned bucket_count = (MAX_BITS - SUB_BITS + 1) * sub_count;
+
+  Log_histogram() : _counts{}, _total(0), _sum(0) {}
+
+  static unsigned index(const std::uint64_t v)
+  {
+    if (v < sub_count) return unsigned(v);
+    const auto msb = unsigned(63 - __builtin_clzll(v));
+    if (MAX_BITS <= msb) return bucket_count - 1;
+    const auto shift = msb - SUB_BITS;
+    return (shift + 1) * sub_count + (unsigned(v >> shift) & (sub_count - 1));
+  }
+
+  /** Smallest value counted in bucket i */
+  static std::uint64_t bucket_low(const unsigned i)
+  {
+    if (i < 2 * sub_count) return i;
+    const auto shift = i / sub_count - 1;
+    return std::uint64_t(sub_count + i % sub_count) << shift;
+  }
+
+  /** Largest value counted in bucket i (but the last bucket is unbounded) */
+  static std::uint64_t bucket_high(const unsigned i) { return bucket_low(i + 1) - 1; }
+
+  void record(const std::uint64_t v)
+  {
+    ++_counts[index(v)];
+    ++_total;
+    _sum += v;
+  }
+
+  void reset()
+  {
+    _counts.fill(0);
+    _total = 0;
+    _sum   = 0;
+  }
+
+  std::uint64_t count(const unsigned i) const { return _counts[i]; }
+  std::uint64_t total() const { return _total; }
+  std::uint64_t sum() const { return _sum; }
+
+  /** Upper bound of the bucket holding the p'th percentile value */
+  std::uint64_t percentile(const double p) const
+  {
+    const auto target = std::uint64_t(double(_total) * p / 100.0 + 0.5);
+    std::uint64_t seen = 0;
+    for (unsigned i = 0; i != bucket_count; ++i) {
+      seen += _counts[i];
+      if (seen != 0 && target <= seen) return bucket_high(i);
+    }
+    return 0;
+  }
+
+ private:
+  std::array<std::uint64_t, bucket_count> _counts;
+  std::uint64_t                           _total;
+  std::uint64_t                           _sum;
+};
+}  // namespace common
+
+#endif
@@ -154,6 +154,15 @@ public:
     return false;
   }
 
+  /**
+   * Check, as the consumer, for an item without dequeuing it
+   *
+   * @return True if no item is waiting
+   */
+  bool empty() const {
+    return ((_head.load(std::memory_order_acquire) - _tail.load(std::memory_order_relaxed)) & _mask) == 0;
+  }
+
   inline bool push(const T &data) { return enqueue(data); }
 
   inline bool pop(T &data) { return dequeue(data); }
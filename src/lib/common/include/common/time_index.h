@@ -0,0 +1,111 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef _MCAS_COMMON_TIME_INDEX_H_
+#define _MCAS_COMMON_TIME_INDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace common
+{
+/**
+ * Secondary index of keys ordered by last write time, so that a time
+ * window costs O(log n + matches) rather than a scan of the pool.
+ * Times are raw timestamp values (tsc_time_t::raw()). Volatile, and not
+ * thread safe: the owning store serializes access.
+ */
+class Time_index {
+ public:
+  using time_type = std::uint64_t;
+
+  Time_index() : _by_time(), _by_key() {}
+
+  /**
+   * Record a write of key at time t, replacing any earlier time for the key
+   */
+  void touch(const std::string &key, const time_type t)
+  {
+    auto it = _by_key.find(key);
+    if (it == _by_key.end()) {
+      _by_key.emplace(key, t);
+    }
+    else {
+      if (it->second == t) return;
+      _by_time.erase(entry(it->second, key));
+      it->second = t;
+    }
+    _by_time.insert(entry(t, key));
+  }
+
+  /**
+   * Forget key
+   */
+  void erase(const std::string &key)
+  {
+    auto it = _by_key.find(key);
+    if (it != _by_key.end()) {
+      _by_time.erase(entry(it->second, key));
+      _by_key.erase(it);
+    }
+  }
+
+  void clear()
+  {
+    _by_time.clear();
+    _by_key.clear();
+  }
+
+  std::size_t size() const { return _by_key.size(); }
+
+  /**
+   * Call f(key, t) for each key last written in [begin, end], oldest first,
+   * until f returns false
+   *
+   * @return false if f ended the walk
+   */
+  template <typename F>
+  bool for_range(const time_type begin, const time_type end, F f) const
+  {
+    for (auto it = _by_time.lower_bound(entry(begin, std::string())); it != _by_time.end() && it->first <= end; ++it) {
+      if (!f(it->second, it->first)) return false;
+    }
+    return true;
+  }
+
+  /**
+   * Keys last written in [begin, end], oldest first
+   */
+  std::vector<std::string> keys_in_range(const time_type begin, const time_type end) const
+  {
+    std::vector<std::string> v;
+    for_range(begin, end, [&v](const std::string &key, time_type) {
+      v.push_back(key);
+      return true;
+    });
+    return v;
+  }
+
+ private:
+  using entry = std::pair<time_type, std::string>;
+  std::set<entry>                              _by_time;
+  std::unordered_map<std::string, time_type>   _by_key;
+};
+}  // namespace common
+
+#endif
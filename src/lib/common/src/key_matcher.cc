@@ -0,0 +1,162 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <common/key_matcher.h>
+
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+/* finish a search from offset i, one position at a time */
+const char *find_substring_tail(const char *h, std::size_t n, const char *nd, std::size_t m, std::size_t i)
+{
+  for (; i + m <= n; ++i) {
+    if (h[i] == nd[0] && std::memcmp(h + i + 1, nd + 1, m - 1) == 0) return h + i;
+  }
+  return nullptr;
+}
+
+#if defined(__x86_64__)
+/* Compare the first and last needle characters at many positions at once,
+ * and the whole needle only where both match. Requires 2 <= m <= n.
+ */
+const char *find_substring_sse2(const char *h, std::size_t n, const char *nd, std::size_t m)
+{
+  const __m128i first = _mm_set1_epi8(nd[0]);
+  const __m128i last  = _mm_set1_epi8(nd[m - 1]);
+  std::size_t   i     = 0;
+  for (; i + m + 15 <= n; i += 16) {
+    const __m128i bf = _mm_loadu_si128(reinterpret_cast<const __m128i *>(h + i));
+    const __m128i bl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(h + i + m - 1));
+    auto mask = unsigned(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, bf), _mm_cmpeq_epi8(last, bl))));
+    while (mask) {
+      const auto bit = unsigned(__builtin_ctz(mask));
+      if (std::memcmp(h + i + bit + 1, nd + 1, m - 2) == 0) return h + i + bit;
+      mask &= mask - 1;
+    }
+  }
+  return find_substring_tail(h, n, nd, m, i);
+}
+
+__attribute__((target("avx2")))
+const char *find_substring_avx2(const char *h, std::size_t n, const char *nd, std::size_t m)
+{
+  const __m256i first = _mm256_set1_epi8(nd[0]);
+  const __m256i last  = _mm256_set1_epi8(nd[m - 1]);
+  std::size_t   i     = 0;
+  for (; i + m + 31 <= n; i += 32) {
+    const __m256i bf = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(h + i));
+    const __m256i bl = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(h + i + m - 1));
+    auto mask = unsigned(_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(first, bf), _mm256_cmpeq_epi8(last, bl))));
+    while (mask) {
+      const auto bit = unsigned(__builtin_ctz(mask));
+      if (std::memcmp(h + i + bit + 1, nd + 1, m - 2) == 0) return h + i + bit;
+      mask &= mask - 1;
+    }
+  }
+  return find_substring_tail(h, n, nd, m, i);
+}
+
+using find_substring_fn = const char *(*)(const char *, std::size_t, const char *, std::size_t);
+
+find_substring_fn select_find_substring()
+{
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") ? find_substring_avx2 : find_substring_sse2;
+}
+#endif
+
+/* Literal characters with which every match of an ECMAScript regex must
+ * begin. Conservative: stops at the first special character, and gives
+ * up on alternation. Sets literal if the whole expression is literal.
+ */
+std::string regex_literal_prefix(const std::string &re, bool &literal)
+{
+  literal = false;
+  if (re.find('|') != std::string::npos) return std::string();
+
+  std::string prefix;
+  for (auto c : re) {
+    if (c == '\0' || std::strchr(".[]{}()\\*+?^$", c)) {
+      /* a quantifier which allows zero repeats makes the preceding character optional */
+      if ((c == '*' || c == '?' || c == '{') && !prefix.empty()) prefix.pop_back();
+      return prefix;
+    }
+    prefix += c;
+  }
+  literal = true;
+  return prefix;
+}
+}  // namespace
+
+namespace common
+{
+const char *find_substring(const char *haystack, std::size_t haystack_len, const char *needle, std::size_t needle_len)
+{
+  if (needle_len == 0) return haystack;
+  if (needle_len > haystack_len) return nullptr;
+  if (needle_len == 1) return static_cast<const char *>(std::memchr(haystack, needle[0], haystack_len));
+#if defined(__x86_64__)
+  static const find_substring_fn fn = select_find_substring();
+  return fn(haystack, haystack_len, needle, needle_len);
+#else
+  return find_substring_tail(haystack, haystack_len, needle, needle_len, 0);
+#endif
+}
+
+Key_matcher::Key_matcher(type_t type, const std::string &expression)
+    : _type(type),
+      _expr(expression),
+      _prefix(),
+      _re()
+{
+  switch (_type) {
+  case MATCH_EXACT:
+  case MATCH_PREFIX:
+    _prefix = _expr;
+    break;
+  case MATCH_REGEX: {
+    bool literal;
+    _prefix = regex_literal_prefix(_expr, literal);
+    if (literal)
+      _type = MATCH_EXACT;
+    else
+      _re.reset(new std::regex(_expr));
+  } break;
+  default:
+    break;
+  }
+}
+
+bool Key_matcher::match(const char *key, std::size_t key_len) const
+{
+  switch (_type) {
+  case MATCH_ANY:
+    return true;
+  case MATCH_EXACT:
+    return key_len == _expr.size() && _expr.compare(0, _expr.size(), key, key_len) == 0;
+  case MATCH_PREFIX:
+    return has_prefix(key, key_len);
+  case MATCH_SUBSTRING:
+    return find_substring(key, key_len, _expr.data(), _expr.size()) != nullptr;
+  case MATCH_REGEX:
+    return has_prefix(key, key_len) && std::regex_match(key, key + key_len, *_re);
+  }
+  return false;
+}
+
+}  // namespace common
@@ -1,9 +1,13 @@
 /* note: we do not include component source, only the API definition */
 #include <common/cycles.h>
+#include <common/key_matcher.h>
+#include <common/log_histogram.h>
 #include <common/mpmc_bounded_queue.h>
 #include <common/rand.h>
+#include <common/time_index.h>
 #include <common/utils.h>
 #include <gtest/gtest.h>
+#include <cstring>
 #include <thread>
 
 //#define TEST_MPMC
@@ -105,6 +109,99 @@ TEST_F(Libcommon_test, get_rdtsc_frequency_mhz)
   PMAJOR("Clock frequency %f MHz", common::get_rdtsc_frequency_mhz());
 }
 
+TEST_F(Libcommon_test, find_substring)
+{
+  const std::string h = "the quick brown fox jumps over the lazy dog, the quick brown fox";
+  for (std::size_t len = 0; len <= h.size(); ++len) {
+    for (auto n : {"", "t", "he", "fox", "dog,", "lazy dog", "brown fox", "cat", "xo"}) {
+      const auto p = common::find_substring(h.data(), len, n, std::strlen(n));
+      const auto e = h.substr(0, len).find(n);
+      ASSERT_EQ(e, p ? std::size_t(p - h.data()) : std::string::npos);
+    }
+  }
+}
+
+TEST_F(Libcommon_test, key_matcher)
+{
+  using common::Key_matcher;
+  Key_matcher prefix(Key_matcher::MATCH_PREFIX, "car");
+  ASSERT_TRUE(prefix.match("carKey"));
+  ASSERT_FALSE(prefix.match("myCar"));
+
+  Key_matcher substring(Key_matcher::MATCH_SUBSTRING, "Key");
+  ASSERT_TRUE(substring.match("carKey1"));
+  ASSERT_FALSE(substring.match("carkey1"));
+
+  Key_matcher re(Key_matcher::MATCH_REGEX, "car[0-9]+");
+  ASSERT_EQ("car", re.prefix());
+  ASSERT_TRUE(re.match("car12"));
+  ASSERT_FALSE(re.match("car"));
+
+  /* an optional character is not part of the literal prefix */
+  ASSERT_EQ("ca", Key_matcher(Key_matcher::MATCH_REGEX, "car?").prefix());
+  ASSERT_EQ("", Key_matcher(Key_matcher::MATCH_REGEX, "car|bus").prefix());
+
+  /* a literal regex is an exact match */
+  ASSERT_EQ(Key_matcher::MATCH_EXACT, Key_matcher(Key_matcher::MATCH_REGEX, "car").type());
+}
+
+TEST_F(Libcommon_test, time_index)
+{
+  common::Time_index index;
+  index.touch("a", 10);
+  index.touch("b", 20);
+  index.touch("c", 30);
+  ASSERT_EQ(3UL, index.size());
+
+  using keys = std::vector<std::string>;
+  ASSERT_EQ((keys{"a", "b", "c"}), index.keys_in_range(0, 100));
+  ASSERT_EQ((keys{"b"}), index.keys_in_range(11, 29));
+  ASSERT_EQ((keys{"b", "c"}), index.keys_in_range(20, 30));
+
+  /* a rewrite moves the key */
+  index.touch("a", 40);
+  ASSERT_EQ((keys{"b", "c", "a"}), index.keys_in_range(0, 100));
+  ASSERT_EQ((keys{}), index.keys_in_range(0, 19));
+
+  index.erase("c");
+  index.erase("z");
+  ASSERT_EQ(2UL, index.size());
+  ASSERT_EQ((keys{"b", "a"}), index.keys_in_range(0, 100));
+
+  /* the walk stops when the function returns false */
+  unsigned calls = 0;
+  ASSERT_FALSE(index.for_range(0, 100, [&calls](const std::string &, common::Time_index::time_type) { return ++calls < 1; }));
+  ASSERT_EQ(1U, calls);
+}
+
+TEST_F(Libcommon_test, log_histogram)
+{
+  using hist_t = common::Log_histogram<3, 40>;
+
+  /* buckets tile the values: each bucket starts where the previous ended */
+  for (unsigned i = 1; i != hist_t::bucket_count; ++i) {
+    ASSERT_EQ(hist_t::bucket_high(i - 1) + 1, hist_t::bucket_low(i));
+    ASSERT_EQ(i, hist_t::index(hist_t::bucket_low(i)));
+    ASSERT_EQ(i, hist_t::index(hist_t::bucket_high(i)));
+  }
+  /* small values are exact; larger values within 1/8 */
+  ASSERT_EQ(15U, hist_t::index(15));
+  ASSERT_LE(hist_t::bucket_high(hist_t::index(1000000)) - hist_t::bucket_low(hist_t::index(1000000)), 1000000U / 8);
+  ASSERT_EQ(hist_t::bucket_count - 1, hist_t::index(~0ULL));
+
+  hist_t h;
+  for (unsigned v = 1; v <= 1000; ++v) h.record(v);
+  ASSERT_EQ(1000U, h.total());
+  ASSERT_EQ(500500U, h.sum());
+  const auto p50 = h.percentile(50.0);
+  ASSERT_LE(500U, p50);
+  ASSERT_GE(500U + 500U / 8, p50);
+  ASSERT_LE(1000U, h.percentile(100.0));
+  h.reset();
+  ASSERT_EQ(0U, h.total());
+  ASSERT_EQ(0U, h.percentile(99.0));
+}
+
 //-------------------------------
 
 int main(int argc, char** argv)
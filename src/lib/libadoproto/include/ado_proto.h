@@ -19,6 +19,7 @@
 #include "uipc.h"
 #include <common/errors.h>
 #include <common/exceptions.h>
+#include <common/fd_open.h>
 #include <common/types.h>
 #include <common/utils.h>
 #include <api/kvindex_itf.h>
@@ -88,8 +89,12 @@ private:
     {
       cpu_relax();
     }
+    ring_doorbell(_channel);
   }
 
+  /* ACCEPT side: signal the shard, if it is waiting, that a message was sent on ch */
+  void ring_doorbell(channel_t ch);
+
   inline status_t recv(channel_t ch, Buffer_header *& out_buffer) __attribute__((warn_unused_result))
   {
     void *v;
@@ -317,6 +322,7 @@ public:
     {
       cpu_relax();
     }
+    ring_doorbell(_channel_callback);
   }
 
   inline status_t recv(Buffer_header *& out_buffer) __attribute__((warn_unused_result)) { return recv(_channel, out_buffer); }
@@ -327,6 +333,17 @@ public:
   }
 
   inline size_t max_message_size() const { return MAX_MESSAGE_SIZE; }
+
+  /* CONNECT side: readable (for poll), while the doorbell is armed, after
+   * the ADO sends a message; or -1 if there is no doorbell */
+  int doorbell_fd() const { return _doorbell_writer ? -1 : _doorbell.fd(); }
+
+  /* CONNECT side: ask the ADO to ring the doorbell on its next message.
+   * False (and not armed) if a message is waiting already. */
+  bool arm_doorbell();
+
+  /* CONNECT side: after a wait, stop the doorbell ringing and clear it */
+  void disarm_doorbell();
   /* out of line, to avoid exposing Buffer_header layout */
   static const uint8_t * buffer_header_to_message(Buffer_header *buffer);
 
@@ -363,6 +380,13 @@ private:
   std::string _channel_prefix;
   Channel_wrap _channel;
   Channel_wrap _channel_callback;
+  /* A FIFO beside the UIPC channels, written by the ADO after a message
+   * it sends while the shard waits (a flag in the channel memory), so that
+   * the shard may block rather than poll the channels.
+   */
+  std::string _doorbell_name;
+  common::Fd_open _doorbell;
+  bool _doorbell_writer;
   /* A non-shared buffer "pool," for messages.
    * Required because the ADO interface does not otherwise ensure that a buffer
    * is available. We hope that the ADO protocol will not exhaust the pool.
@@ -118,6 +118,34 @@ status_t uipc_send(channel_t channel, void* data) __attribute__((warn_unused_res
  * @return S_OK or E_EMPTY
  */
 status_t uipc_recv(channel_t channel, void** data_out) __attribute__((warn_unused_result));
+
+/**
+ * Master side: ask the slave to signal the master, by some other means,
+ * after its next send. The request stands until uipc_disarm_master_wait.
+ *
+ * @param channel Channel handle
+ *
+ * @return S_OK, or E_BUSY if a message is waiting already (the master
+ * should not wait)
+ */
+status_t uipc_arm_master_wait(channel_t channel);
+
+/**
+ * Master side: withdraw a uipc_arm_master_wait request
+ *
+ * @param channel Channel handle
+ */
+void uipc_disarm_master_wait(channel_t channel);
+
+/**
+ * Slave side, after a send: check for (and consume) a master request to
+ * be signalled
+ *
+ * @param channel Channel handle
+ *
+ * @return Non-zero if the master asked to be signalled
+ */
+int uipc_master_wait_armed(channel_t channel);
 #ifdef __cplusplus
 }
 #endif
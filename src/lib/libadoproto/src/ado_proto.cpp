@@ -27,6 +27,9 @@
 #include <sys/types.h>
 #include <sys/ipc.h>
 #include <sys/msg.h>
+#include <sys/stat.h> /* mkfifo */
+#include <fcntl.h>
+#include <unistd.h>
 
 using namespace component;
 using namespace mcas::ipc;
@@ -78,6 +81,10 @@ ADO_protocol_builder::ADO_protocol_builder(unsigned option_DEBUG_, const std::st
   , _channel_prefix(channel_prefix)
   , _channel()
   , _channel_callback()
+  /* beside the UIPC address negotiation FIFOs */
+  , _doorbell_name("/tmp/fifo." + channel_prefix + ".wake")
+  , _doorbell()
+  , _doorbell_writer(false)
   , _b_mutex()
   , _buffer()
 {
@@ -92,16 +99,78 @@ ADO_protocol_builder::ADO_protocol_builder(unsigned option_DEBUG_, const std::st
       _buffer.emplace_back(buffer_allocate());
     }
     _channel_callback.open(_channel_prefix + "-cb");
+
+    /* The proxy made the doorbell before the channels. Without it, the
+     * shard polls for our messages. */
+    auto fd = ::open(_doorbell_name.c_str(), O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    if ( fd != -1 ) {
+      _doorbell = common::Fd_open(fd);
+      _doorbell_writer = true;
+    }
+    else {
+      PWRN("%s: no doorbell %s: %s", __func__, _doorbell_name.c_str(), std::strerror(errno));
+    }
   }
   else throw Logic_exception("bad role");
 }
 
 ADO_protocol_builder::~ADO_protocol_builder()
 {
+  if ( _doorbell && ! _doorbell_writer ) {
+    ::unlink(_doorbell_name.c_str());
+  }
+}
+
+void ADO_protocol_builder::ring_doorbell(channel_t ch)
+{
+  /* only if the shard is waiting: the write is a system call */
+  if ( _doorbell_writer && ::uipc_master_wait_armed(ch) ) {
+    const char c = 0;
+    /* EAGAIN: the FIFO is full, and the doorbell rung already */
+    auto sz = ::write(_doorbell.fd(), &c, sizeof c);
+    (void) sz;
+  }
+}
+
+bool ADO_protocol_builder::arm_doorbell()
+{
+  if ( ::uipc_arm_master_wait(_channel) != S_OK ) {
+    ::uipc_disarm_master_wait(_channel);
+    return false;
+  }
+  if ( ::uipc_arm_master_wait(_channel_callback) != S_OK ) {
+    disarm_doorbell();
+    return false;
+  }
+  return true;
+}
+
+void ADO_protocol_builder::disarm_doorbell()
+{
+  ::uipc_disarm_master_wait(_channel);
+  ::uipc_disarm_master_wait(_channel_callback);
+  char buf[64];
+  while ( ::read(_doorbell.fd(), buf, sizeof buf) > 0 ) {
+  }
 }
 
 void ADO_protocol_builder::create_uipc_channels()
 {
+  /* The doorbell, before the channels which the ADO opens first. Opened for
+   * read and write, so that it never reports a hangup. If it cannot be
+   * made, the shard simply polls. Only our user may ring it.
+   */
+  ::unlink(_doorbell_name.c_str());
+  if ( ::mkfifo(_doorbell_name.c_str(), 0600) == 0 ) {
+    auto fd = ::open(_doorbell_name.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if ( fd != -1 ) {
+      _doorbell = common::Fd_open(fd);
+    }
+  }
+  if ( ! _doorbell ) {
+    PWRN("%s: no doorbell %s: %s", __func__, _doorbell_name.c_str(), std::strerror(errno));
+  }
+
   _channel.create(_channel_prefix, MAX_MESSAGE_SIZE, QUEUE_SIZE);
   
   std::lock_guard<std::mutex> g{_b_mutex};
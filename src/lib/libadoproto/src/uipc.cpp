@@ -87,4 +87,22 @@ status_t uipc_recv(channel_t channel, void** data_out) {
   assert(ch);
   return ch->recv(*data_out);
 }
+
+status_t uipc_arm_master_wait(channel_t channel) {
+  auto ch = static_cast<core::uipc::Channel*>(channel);
+  assert(ch);
+  return ch->arm_master_wait() ? S_OK : E_BUSY;
+}
+
+void uipc_disarm_master_wait(channel_t channel) {
+  auto ch = static_cast<core::uipc::Channel*>(channel);
+  assert(ch);
+  ch->disarm_master_wait();
+}
+
+int uipc_master_wait_armed(channel_t channel) {
+  auto ch = static_cast<core::uipc::Channel*>(channel);
+  assert(ch);
+  return ch->master_wait_armed();
+}
 }
@@ -48,6 +48,17 @@ namespace core
 namespace uipc
 {
 
+namespace
+{
+/* room, at the end of the s2m FIFO memory, for the master waiting flag */
+constexpr size_t flag_footprint = 64;
+
+std::atomic<std::uint32_t>* master_waiting_flag(Shared_memory &s2m)
+{
+  return reinterpret_cast<std::atomic<std::uint32_t>*>(static_cast<char*>(s2m.get_addr()) + s2m.get_size() - flag_footprint);
+}
+}  // namespace
+
 #if 0
 typedef common::Spsc_bounded_lfq_sleeping<
   Dataplane::Command_t, 32 /* queue size */
@@ -65,8 +76,9 @@ Channel::Channel(const std::string &name, size_t message_size, size_t queue_size
   , _shmem_slab()
   , _in_queue(nullptr)
   , _out_queue(nullptr)
-  , _slab_ring(nullptr) {
-  const size_t queue_footprint = queue_t::memory_footprint(queue_size);
+  , _slab_ring(nullptr)
+  , _master_waiting(nullptr) {
+  const size_t queue_footprint = queue_t::memory_footprint(queue_size) + flag_footprint;
   size_t pages_per_queue = round_up(queue_footprint, PAGE_SIZE) / PAGE_SIZE;
 
   assert((queue_size != 0) && ((queue_size & (~queue_size + 1)) ==
@@ -110,6 +122,8 @@ Channel::Channel(const std::string &name, size_t message_size, size_t queue_size
   _in_queue = new (_shmem_fifo_s2m->get_addr()) queue_t(
       queue_size, (static_cast<char*>(_shmem_fifo_s2m->get_addr())) + sizeof(queue_t));
 
+  _master_waiting = new (master_waiting_flag(*_shmem_fifo_s2m)) std::atomic<std::uint32_t>(0);
+
   size_t slab_slots = queue_size * slab_multiplier;
   _slab_ring = new (_shmem_slab_ring->get_addr()) mqueue_t(
       slab_slots, (static_cast<char*>(_shmem_slab_ring->get_addr())) + sizeof(mqueue_t));
@@ -139,7 +153,8 @@ Channel::Channel(const std::string &name)
   , _shmem_slab(std::make_unique<Shared_memory>(name + "-slab"))
   , _in_queue(reinterpret_cast<queue_t*>(_shmem_fifo_m2s->get_addr()))
   , _out_queue(reinterpret_cast<queue_t*>(_shmem_fifo_s2m->get_addr()))
-  , _slab_ring(reinterpret_cast<mqueue_t*>(_shmem_slab_ring->get_addr())) {
+  , _slab_ring(reinterpret_cast<mqueue_t*>(_shmem_slab_ring->get_addr()))
+  , _master_waiting(master_waiting_flag(*_shmem_fifo_s2m)) {
 
   CPLOG(1, "got fifo (m2s) @ %p - %lu bytes", _shmem_fifo_m2s->get_addr(),
         _shmem_fifo_m2s->get_size());
@@ -182,6 +197,25 @@ status_t Channel::recv(void*& recvd_msg) {
 
 void Channel::unblock_threads() { _in_queue->exit_threads(); }
 
+bool Channel::arm_master_wait() {
+  assert(_master);
+  _master_waiting->store(1, std::memory_order_seq_cst);
+  return _in_queue->empty();
+}
+
+void Channel::disarm_master_wait() {
+  assert(_master);
+  _master_waiting->store(0, std::memory_order_relaxed);
+}
+
+bool Channel::master_wait_armed() {
+  assert(!_master);
+  /* the send must be visible before the flag is read; the master sets the
+   * flag before it re-checks the queue */
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  return _master_waiting->load(std::memory_order_relaxed) && _master_waiting->exchange(0);
+}
+
 void* Channel::alloc_msg() {
   assert(_slab_ring);
   void* msg = nullptr;
@@ -26,6 +26,8 @@
 #include <common/mpmc_bounded_queue.h>
 #include <common/spsc_bounded_queue.h>
 #include <common/logging.h>
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <string>
 
@@ -126,6 +128,27 @@ class Channel : public uipc_channel, private common::log_source {
    */
   void unblock_threads();
 
+  /**
+   * Master side: set the flag which asks the slave to signal (out of band)
+   * its next message, then re-check the incoming queue
+   *
+   * @return False if a message is waiting already
+   */
+  bool arm_master_wait();
+
+  /**
+   * Master side: clear the flag set by arm_master_wait
+   *
+   */
+  void disarm_master_wait();
+
+  /**
+   * Slave side, after a send: test and clear the master's flag
+   *
+   * @return True if the master should be signalled
+   */
+  bool master_wait_armed();
+
   /**
    * Shutdown handling
    *
@@ -156,6 +179,9 @@ class Channel : public uipc_channel, private common::log_source {
   queue_t* _in_queue;
   queue_t* _out_queue;
   mqueue_t* _slab_ring;
+  /* in the last cache line of the s2m FIFO memory: set while the master
+   * waits for a signal of the slave's next message */
+  std::atomic<std::uint32_t>* _master_waiting;
 };
 
 }  // namespace uipc
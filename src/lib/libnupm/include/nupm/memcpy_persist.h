@@ -0,0 +1,43 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef __NUPM_MEMCPY_PERSIST_H__
+#define __NUPM_MEMCPY_PERSIST_H__
+
+#include <cstddef>
+
+namespace nupm
+{
+/*
+ * Copies to persistent memory. The copy kernel (SSE2, AVX or AVX-512F,
+ * written back by CLWB, CLFLUSHOPT or CLFLUSH) is chosen by libpmem from
+ * the CPU features at load time.
+ *
+ * Copies of at least memcpy_nt_threshold() bytes use non-temporal stores,
+ * and so do not displace the caller's cache; shorter copies use ordinary
+ * stores followed by a write-back. The threshold defaults to 4 KiB and may
+ * be set by the environment variable NUPM_MEMCPY_NT_THRESHOLD.
+ */
+
+std::size_t memcpy_nt_threshold();
+
+/* Copy, write back, and fence: the destination is durable on return */
+void *memcpy_persist(void *dst, const void *src, std::size_t len);
+
+/* Copy and write back, without a fence: the destination is durable after
+ * the caller's next drain (e.g. pmem_drain or pmem_persist).
+ */
+void *memcpy_nodrain(void *dst, const void *src, std::size_t len);
+}  // namespace nupm
+
+#endif  // __NUPM_MEMCPY_PERSIST_H__
@@ -0,0 +1,46 @@
+/*
+   Copyright [2020] [IBM Corporation]
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+       http://www.apache.org/licenses/LICENSE-2.0
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "memcpy_persist.h"
+
+#include <libpmem.h>
+
+#include <cstdlib> /* getenv, strtoul */
+
+namespace
+{
+std::size_t nt_threshold_init()
+{
+  const auto e = std::getenv("NUPM_MEMCPY_NT_THRESHOLD");
+  return e ? std::strtoul(e, nullptr, 0) : 4096;
+}
+
+const std::size_t nt_threshold = nt_threshold_init();
+
+unsigned store_flags(std::size_t len)
+{
+  return len < nt_threshold ? PMEM_F_MEM_TEMPORAL : PMEM_F_MEM_NONTEMPORAL;
+}
+}  // namespace
+
+std::size_t nupm::memcpy_nt_threshold() { return nt_threshold; }
+
+void *nupm::memcpy_persist(void *dst, const void *src, std::size_t len)
+{
+  return pmem_memcpy(dst, src, len, store_flags(len));
+}
+
+void *nupm::memcpy_nodrain(void *dst, const void *src, std::size_t len)
+{
+  return pmem_memcpy(dst, src, len, store_flags(len) | PMEM_F_MEM_NODRAIN);
+}
@@ -0,0 +1,104 @@
+/*
+ * Throughput of nupm::memcpy_persist, by copy size.
+ *
+ * libpmem chooses its copy kernels when it loads: SSE2 unless PMEM_AVX=1
+ * or PMEM_AVX512F=1 (and the CPU supports them). Run once with each
+ * setting, and with NUPM_MEMCPY_NT_THRESHOLD, to compare, e.g.
+ *
+ *   libnupm-test3
+ *   PMEM_AVX=1 libnupm-test3
+ *   PMEM_AVX512F=1 libnupm-test3
+ *
+ * The destination is in DRAM unless NUPM_TEST_DST names a file (e.g. on a
+ * DAX file system), which is then mapped.
+ */
+#include "memcpy_persist.h"
+
+#include <common/logging.h>
+#include <common/utils.h>
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+constexpr std::size_t region_size = MiB(64);
+
+class Libnupm_memcpy_test : public ::testing::Test {
+ protected:
+  static char *dst;
+  static int dst_fd;
+  static std::vector<char> src;
+
+  static void SetUpTestCase()
+  {
+    const char *path = std::getenv("NUPM_TEST_DST");
+    if ( path )
+    {
+      dst_fd = ::open(path, O_RDWR | O_CREAT, 0666);
+      ASSERT_LE(0, dst_fd);
+      ASSERT_EQ(0, ::ftruncate(dst_fd, off_t(region_size)));
+    }
+    auto p = ::mmap(nullptr, region_size, PROT_READ | PROT_WRITE,
+                    dst_fd == -1 ? MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE : MAP_SHARED | MAP_POPULATE, dst_fd, 0);
+    ASSERT_NE(MAP_FAILED, p);
+    dst = static_cast<char *>(p);
+    src.resize(region_size);
+    for ( std::size_t i = 0; i != src.size(); ++i )
+    {
+      src[i] = char(i * 7);
+    }
+  }
+
+  static void TearDownTestCase()
+  {
+    ::munmap(dst, region_size);
+    if ( dst_fd != -1 )
+    {
+      ::close(dst_fd);
+    }
+  }
+};
+
+char *Libnupm_memcpy_test::dst = nullptr;
+int Libnupm_memcpy_test::dst_fd = -1;
+std::vector<char> Libnupm_memcpy_test::src;
+
+TEST_F(Libnupm_memcpy_test, Throughput)
+{
+  PLOG("PMEM_AVX=%s PMEM_AVX512F=%s non-temporal from %zu bytes",
+       std::getenv("PMEM_AVX") ? std::getenv("PMEM_AVX") : "(unset)",
+       std::getenv("PMEM_AVX512F") ? std::getenv("PMEM_AVX512F") : "(unset)",
+       nupm::memcpy_nt_threshold());
+
+  for ( std::size_t len : {std::size_t(256), std::size_t(KiB(4)), std::size_t(KiB(64)), std::size_t(MiB(2))} )
+  {
+    /* about 1 GiB in all, through the whole region so that the copies
+     * are not served from cache */
+    const auto count = GiB(1) / len;
+    std::size_t off = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for ( std::size_t i = 0; i != count; ++i )
+    {
+      nupm::memcpy_persist(dst + off, src.data() + off, len);
+      off = (off + len) % region_size;
+    }
+    const std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+    PLOG("%8zu bytes: %8.2f GB/s %8.0f ns/copy", len, double(count * len) / secs.count() / 1e9, secs.count() * 1e9 / double(count));
+    EXPECT_EQ(0, std::memcmp(dst, src.data(), len));
+  }
+}
+}  // namespace
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
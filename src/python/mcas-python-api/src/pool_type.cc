@@ -28,6 +28,7 @@ static PyObject * pool_get_size(Pool* self, PyObject *args, PyObject *kwds);
 static PyObject * pool_erase(Pool* self, PyObject *args, PyObject *kwds);
 static PyObject * pool_configure(Pool* self, PyObject *args, PyObject *kwds);
 static PyObject * pool_find_key(Pool* self, PyObject *args, PyObject *kwds);
+static PyObject * pool_scan(Pool* self, PyObject *args, PyObject *kwds);
 static PyObject * pool_get_attribute(Pool* self, PyObject* args, PyObject* kwds);
 static PyObject * pool_type(Pool* self);
 
@@ -74,6 +75,7 @@ PyDoc_STRVAR(count_doc,"Pool.count() -> Get number of objects in the pool.");
 PyDoc_STRVAR(erase_doc,"Pool.erase(key) -> Erase object from the pool.");
 PyDoc_STRVAR(configure_doc,"Pool.configure(jsoncmd) -> Configure pool.");
 PyDoc_STRVAR(find_key_doc,"Pool.find(expr, [limit]) -> Find keys using expression.");
+PyDoc_STRVAR(scan_doc,"Pool.scan(expr, [cursor, limit, values]) -> List keys (or (key,value) pairs) in key order, and cursor to continue (None when complete).");
 PyDoc_STRVAR(get_attribute_doc,"Pool.get_attribute(key, attribute_name) -> Attribute value(s).");
 
 static PyMethodDef Pool_methods[] = {
@@ -90,6 +92,7 @@ static PyMethodDef Pool_methods[] = {
   {"erase",(PyCFunction) pool_erase, METH_VARARGS | METH_KEYWORDS, erase_doc},
   {"configure",(PyCFunction) pool_configure, METH_VARARGS | METH_KEYWORDS, configure_doc},
   {"find_key",(PyCFunction) pool_find_key, METH_VARARGS | METH_KEYWORDS, find_key_doc},
+  {"scan",(PyCFunction) pool_scan, METH_VARARGS | METH_KEYWORDS, scan_doc},
   {"get_attribute",(PyCFunction) pool_get_attribute, METH_VARARGS | METH_KEYWORDS, get_attribute_doc},
   {NULL}
 };
@@ -693,6 +696,101 @@ static PyObject * pool_find_key(Pool* self, PyObject *args, PyObject *kwds)
 }
 
 
+static PyObject * pool_scan(Pool* self, PyObject *args, PyObject *kwds)
+{
+  static const char *kwlist[] = {"expr",
+                                 "cursor",
+                                 "limit",
+                                 "values",
+                                 NULL};
+
+  const char * expr_param = nullptr;
+  const char * cursor_param = nullptr;
+  unsigned long limit_param = 0;
+  int values_param = 0;
+
+  if (! PyArg_ParseTupleAndKeywords(args,
+                                    kwds,
+                                    "s|zkp",
+                                    const_cast<char**>(kwlist),
+                                    &expr_param,
+                                    &cursor_param,
+                                    &limit_param,
+                                    &values_param)) {
+    PyErr_SetString(PyExc_RuntimeError,"bad arguments");
+    return NULL;
+  }
+
+  assert(self->_pool);
+
+  std::string cursor(cursor_param ? cursor_param : "");
+  std::vector<std::string> keys;
+  std::vector<std::string> values;
+
+  auto hr = self->_mcas->scan(self->_pool,
+                              expr_param,
+                              cursor,
+                              keys,
+                              values_param ? &values : nullptr,
+                              limit_param);
+
+  if(hr != S_OK && hr != S_MORE) {
+    std::stringstream ss;
+    ss << "pool.scan [status:" << hr << "]";
+    PyErr_SetString(PyExc_RuntimeError,ss.str().c_str());
+    return NULL;
+  }
+
+  /* A key which is not UTF-8 fails to decode: release what was built and
+     raise the UnicodeDecodeError */
+  auto list = PyList_New(keys.size());
+  if(list == NULL) return NULL;
+  for(size_t i = 0; i < keys.size(); i++) {
+    PyObject * item = PyUnicode_FromStringAndSize(keys[i].data(), keys[i].size());
+    if(item && values_param) {
+      auto value = PyBytes_FromStringAndSize(values[i].data(), values[i].size());
+      auto pair = value ? PyTuple_New(2) : NULL;
+      if(pair) {
+        PyTuple_SET_ITEM(pair, 0, item);
+        PyTuple_SET_ITEM(pair, 1, value);
+      }
+      else {
+        Py_DECREF(item);
+        Py_XDECREF(value);
+      }
+      item = pair;
+    }
+    if(item == NULL) {
+      Py_DECREF(list);
+      return NULL;
+    }
+    PyList_SET_ITEM(list, i, item);
+  }
+
+  PyObject * next;
+  if(hr == S_MORE) {
+    next = PyUnicode_FromStringAndSize(cursor.data(), cursor.size());
+    if(next == NULL) {
+      Py_DECREF(list);
+      return NULL;
+    }
+  }
+  else {
+    Py_INCREF(Py_None);
+    next = Py_None;
+  }
+
+  auto tuple = PyTuple_New(2);
+  if(tuple == NULL) {
+    Py_DECREF(list);
+    Py_DECREF(next);
+    return NULL;
+  }
+  PyTuple_SET_ITEM(tuple, 0, list);
+  PyTuple_SET_ITEM(tuple, 1, next);
+  return tuple;
+}
+
 static PyObject * pool_get_attribute(Pool* self, PyObject *args, PyObject *kwds)
 {
   static const char *kwlist[] = {"key",
@@ -26,6 +26,7 @@ static PyObject * open_pool(Session* self, PyObject *args, PyObject *kwds);
 static PyObject * create_pool(Session* self, PyObject *args, PyObject *kwds);
 static PyObject * delete_pool(Session* self, PyObject *args, PyObject *kwds);
 static PyObject * get_stats(Session* self, PyObject *args, PyObject *kwds);
+static PyObject * get_latency_stats(Session* self, PyObject *args, PyObject *kwds);
 
   
 static PyObject *
@@ -140,12 +141,15 @@ PyDoc_STRVAR(open_pool_doc,"Session.open_pool(name,[readonly=True]) -> Open pool
 PyDoc_STRVAR(create_pool_doc,"Session.create_pool(name,pool_size,objcount) -> Create pool.");
 PyDoc_STRVAR(delete_pool_doc,"Session.delete_pool(name) -> Delete pool.");
 PyDoc_STRVAR(get_stats_doc,"Session.get_stats() -> Get shard statistics.");
+PyDoc_STRVAR(get_latency_stats_doc,"Session.get_latency_stats([reset=False]) -> Get shard latency histograms, "
+             "a list of {op, phase, count, sum_ns, buckets: [(upper_ns, count)]}. Optionally reset them.");
 
 static PyMethodDef Session_methods[] = {
   {"open_pool",  (PyCFunction) open_pool, METH_VARARGS | METH_KEYWORDS, open_pool_doc},
   {"create_pool",  (PyCFunction) create_pool, METH_VARARGS | METH_KEYWORDS, create_pool_doc},
   {"delete_pool",  (PyCFunction) delete_pool, METH_VARARGS | METH_KEYWORDS, delete_pool_doc},
   {"get_stats",  (PyCFunction) get_stats, METH_VARARGS | METH_KEYWORDS, get_stats_doc},
+  {"get_latency_stats",  (PyCFunction) get_latency_stats, METH_VARARGS | METH_KEYWORDS, get_latency_stats_doc},
   {NULL}
 };
 
@@ -335,8 +339,76 @@ static PyObject * get_stats(Session* self, PyObject *args, PyObject *kwds)
   macro_add_dict_item(op_erase_count);
   macro_add_dict_item(op_failed_request_count);
   macro_add_dict_item(last_op_count_snapshot);
+  macro_add_dict_item(busy_tick_count);
+  macro_add_dict_item(tick_msg_count);
+  macro_add_dict_item(tick_msg_max);
+  macro_add_dict_item(batch_budget_reached_count);
+  macro_add_dict_item(op_offload_count);
+  macro_add_dict_item(mr_cache_hit_count);
+  macro_add_dict_item(mr_cache_miss_count);
+  macro_add_dict_item(idle_block_count);
+  macro_add_dict_item(idle_block_usec);
+  macro_add_dict_item(wake_latency_count);
+  macro_add_dict_item(wake_latency_ns_total);
+  macro_add_dict_item(wake_latency_ns_max);
 
   return dict;
 }
 
+static void set_dict_item(PyObject* dict, const char* name, PyObject* value)
+{
+  PyDict_SetItemString(dict, name, value);
+  Py_DECREF(value);
+}
+
+static PyObject * get_latency_stats(Session* self, PyObject *args, PyObject *kwds)
+{
+  static const char *kwlist[] = {"reset",
+                                 NULL};
+
+  int reset = 0;
+
+  if (! PyArg_ParseTupleAndKeywords(args,
+                                    kwds,
+                                    "|p",
+                                    const_cast<char**>(kwlist),
+                                    &reset)) {
+    PyErr_SetString(PyExc_RuntimeError,"bad arguments");
+    return NULL;
+  }
+
+  std::vector<component::IMCAS::Latency_histogram> histograms;
+  status_t hr = self->_mcas->get_latency_statistics(histograms, reset);
+
+  if(hr != S_OK) {
+    std::stringstream ss;
+    ss << "mcas.Session.get_latency_stats failed [status:" << hr << "]";
+    PyErr_SetString(PyExc_RuntimeError,ss.str().c_str());
+    return NULL;
+  }
+
+  /* convert result to a list of dictionaries */
+  PyObject* list = PyList_New(0);
+  for(const auto& h : histograms) {
+    PyObject* dict = PyDict_New();
+    set_dict_item(dict, "op", PyUnicode_FromString(h.op.c_str()));
+    set_dict_item(dict, "phase", PyUnicode_FromString(h.phase.c_str()));
+    set_dict_item(dict, "count", PyLong_FromUnsignedLongLong(h.count));
+    set_dict_item(dict, "sum_ns", PyLong_FromUnsignedLongLong(h.sum_ns));
+
+    PyObject* buckets = PyList_New(0);
+    for(const auto& b : h.buckets) {
+      PyObject* t = Py_BuildValue("(KK)", (unsigned long long) b.first, (unsigned long long) b.second);
+      PyList_Append(buckets, t);
+      Py_DECREF(t);
+    }
+    set_dict_item(dict, "buckets", buckets);
+
+    PyList_Append(list, dict);
+    Py_DECREF(dict);
+  }
+
+  return list;
+}
+
 #endif
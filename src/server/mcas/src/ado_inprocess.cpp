@@ -0,0 +1,586 @@
+/*
+  Copyright [2017-2020] [IBM Corporation]
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+  http://www.apache.org/licenses/LICENSE-2.0
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include "ado_inprocess.h"
+
+#include <api/interfaces.h>
+#include <common/exceptions.h>
+
+#include <boost/numeric/conversion/cast.hpp>
+#include <stdexcept>
+
+namespace mcas
+{
+using namespace component;
+
+constexpr size_t ADO_inprocess_proxy::MAX_ALLOWED_DEFERRED_LOCKS;
+
+ADO_inprocess_proxy::callback_request::callback_request(kind_t kind_)
+  : kind(kind_),
+    work_id(0),
+    op(ADO_op::UNDEFINED),
+    key(),
+    value_len(0),
+    align_or_flags(0),
+    addr(nullptr),
+    begin_pos(0),
+    find_type(0),
+    t_begin(0),
+    t_end(0),
+    iterator(nullptr),
+    key_handle(nullptr),
+    options(0)
+{
+}
+
+ADO_inprocess_proxy::work_completion::work_completion(uint64_t work_key_)
+  : work_key(work_key_),
+    status(E_FAIL),
+    response_buffers()
+{
+}
+
+ADO_inprocess_proxy::callback_response::callback_response()
+  : given(false),
+    status(E_FAIL),
+    value_addr(nullptr),
+    value_len(0),
+    key_ptr(nullptr),
+    key_handle(nullptr),
+    matched_position(0),
+    matched_key(),
+    vector(),
+    iterator(nullptr),
+    reference(),
+    info()
+{
+}
+
+ADO_inprocess_proxy::ADO_inprocess_proxy(const uint64_t                  auth_id,
+                                         const unsigned                  debug_level_,
+                                         IKVStore *                      kvs,
+                                         IKVStore::pool_t                pool_id,
+                                         const std::string &             pool_name,
+                                         const size_t                    pool_size,
+                                         const unsigned int              pool_flags,
+                                         const uint64_t                  expected_obj_count,
+                                         const std::vector<std::string> &plugins,
+                                         const std::vector<std::string> &params,
+                                         dispatch_t                      dispatch)
+  : common::log_source(debug_level_),
+    _auth_id(auth_id),
+    _kvs(kvs),
+    _pool_id(pool_id),
+    _pool_name(pool_name),
+    _pool_size(pool_size),
+    _pool_flags(pool_flags),
+    _expected_obj_count(expected_obj_count),
+    _params(params),
+    _dispatch(std::move(dispatch)),
+    _plugins(),
+    _completions(),
+    _op_event_responses(),
+    _response(),
+    _deferred_unlocks(),
+    _life_unlocks()
+{
+  assert(_kvs);
+  assert(_dispatch);
+
+  const auto cb_table = make_callback_table();
+  for (const auto &ppath : plugins) {
+    _plugins.push_back(make_itf_ref(static_cast<IADO_plugin *>(load_component(ppath.c_str(), interface::ado_plugin))));
+    if (!_plugins.back()) throw General_exception("unable to load ADO plugin (%s)", ppath.c_str());
+
+    _plugins.back()->register_callbacks(cb_table);
+    PLOG("ADO_inprocess_proxy: plugin loaded OK (%s)", ppath.c_str());
+  }
+}
+
+ADO_inprocess_proxy::~ADO_inprocess_proxy() {}
+
+IADO_plugin::Callback_table ADO_inprocess_proxy::make_callback_table()
+{
+  using kind_t = callback_request::kind_t;
+
+  auto create_key = [this](const uint64_t work_id, const std::string &key_name, const size_t value_size,
+                           const int flags, void *&out_value_addr, const char **out_key_ptr,
+                           IKVStore::key_t *out_key_handle) -> status_t {
+    callback_request rq(kind_t::TABLE_OP);
+    rq.work_id        = work_id;
+    rq.op             = ADO_op::CREATE;
+    rq.key            = key_name;
+    rq.value_len      = value_size;
+    rq.align_or_flags = static_cast<size_t>(flags);
+    auto rc           = call(rq);
+    out_value_addr    = const_cast<void *>(_response.value_addr);
+    if (out_key_ptr) *out_key_ptr = _response.key_ptr;
+    if (out_key_handle) *out_key_handle = _response.key_handle;
+    return rc;
+  };
+
+  auto open_key = [this](const uint64_t work_id, const std::string &key_name, const int flags, void *&out_value_addr,
+                         size_t &out_value_len, const char **out_key_ptr, IKVStore::key_t *out_key_handle) -> status_t {
+    callback_request rq(kind_t::TABLE_OP);
+    rq.work_id        = work_id;
+    rq.op             = ADO_op::OPEN;
+    rq.key            = key_name;
+    rq.value_len      = out_value_len;
+    rq.align_or_flags = static_cast<size_t>(flags);
+    auto rc           = call(rq);
+    out_value_addr    = const_cast<void *>(_response.value_addr);
+    out_value_len     = _response.value_len;
+    if (out_key_ptr) *out_key_ptr = _response.key_ptr;
+    if (out_key_handle) *out_key_handle = _response.key_handle;
+    return rc;
+  };
+
+  auto erase_key = [this](const std::string &key_name) -> status_t {
+    callback_request rq(kind_t::TABLE_OP);
+    rq.op  = ADO_op::ERASE;
+    rq.key = key_name;
+    return call(rq);
+  };
+
+  auto resize_value = [this](const uint64_t work_id, const std::string &key_name, const size_t new_value_size,
+                             void *&out_new_value_addr) -> status_t {
+    callback_request rq(kind_t::TABLE_OP);
+    rq.work_id         = work_id;
+    rq.op              = ADO_op::VALUE_RESIZE;
+    rq.key             = key_name;
+    rq.value_len       = new_value_size;
+    auto rc            = call(rq);
+    out_new_value_addr = const_cast<void *>(_response.value_addr);
+    return rc;
+  };
+
+  auto allocate_pool_memory = [this](const size_t size, const size_t alignment, void *&out_new_addr) -> status_t {
+    callback_request rq(kind_t::TABLE_OP);
+    rq.op             = ADO_op::ALLOCATE_POOL_MEMORY;
+    rq.value_len      = size;
+    rq.align_or_flags = alignment;
+    auto rc           = call(rq);
+    out_new_addr      = const_cast<void *>(_response.value_addr);
+    return rc;
+  };
+
+  auto free_pool_memory = [this](const size_t size, const void *addr) -> status_t {
+    callback_request rq(kind_t::TABLE_OP);
+    rq.op        = ADO_op::FREE_POOL_MEMORY;
+    rq.value_len = size;
+    rq.addr      = const_cast<void *>(addr);
+    return call(rq);
+  };
+
+  auto get_reference_vector = [this](const common::epoch_time_t t_begin, const common::epoch_time_t t_end,
+                                     IADO_plugin::Reference_vector &out_vector) -> status_t {
+    callback_request rq(kind_t::VECTOR_OP);
+    rq.t_begin = t_begin;
+    rq.t_end   = t_end;
+    auto rc    = call(rq);
+    out_vector = _response.vector;
+    return rc;
+  };
+
+  auto find_key = [this](const std::string &key_expression, const offset_t begin_position,
+                         const IKVIndex::find_t find_type, offset_t &out_matched_position,
+                         std::string &out_matched_key) -> status_t {
+    callback_request rq(kind_t::INDEX_OP);
+    rq.key               = key_expression;
+    rq.begin_pos         = begin_position;
+    rq.find_type         = int(find_type);
+    auto rc              = call(rq);
+    out_matched_position = _response.matched_position;
+    out_matched_key      = _response.matched_key;
+    return rc;
+  };
+
+  auto get_pool_info = [this](std::string &out_result) -> status_t {
+    callback_request rq(kind_t::POOL_INFO);
+    auto             rc = call(rq);
+    out_result          = _response.info;
+    return rc;
+  };
+
+  auto iterate = [this](const common::epoch_time_t t_begin, const common::epoch_time_t t_end,
+                        IKVStore::pool_iterator_t &iterator, IKVStore::pool_reference_t &reference) -> status_t {
+    callback_request rq(kind_t::ITERATE);
+    rq.t_begin  = t_begin;
+    rq.t_end    = t_end;
+    rq.iterator = iterator;
+    auto rc     = call(rq);
+    iterator    = _response.iterator;
+    reference   = _response.reference;
+    return rc;
+  };
+
+  auto unlock = [this](const uint64_t work_id, const IKVStore::key_t key_handle) -> status_t {
+    if (work_id == 0 || key_handle == nullptr) return E_INVAL;
+    callback_request rq(kind_t::UNLOCK);
+    rq.work_id    = work_id;
+    rq.key_handle = key_handle;
+    return call(rq);
+  };
+
+  auto configure = [this](const uint64_t options) -> status_t {
+    callback_request rq(kind_t::CONFIGURE);
+    rq.options = options;
+    return call(rq);
+  };
+
+  return IADO_plugin::Callback_table{create_key,
+                                     open_key,
+                                     erase_key,
+                                     resize_value,
+                                     allocate_pool_memory,
+                                     free_pool_memory,
+                                     get_reference_vector,
+                                     find_key,
+                                     get_pool_info,
+                                     iterate,
+                                     unlock,
+                                     configure};
+}
+
+status_t ADO_inprocess_proxy::call(const callback_request &rq)
+{
+  _response = callback_response();
+  _dispatch(this, &rq);
+  if (!_response.given) throw Logic_exception("ADO_inprocess_proxy: callback request was not answered");
+  return _response.status;
+}
+
+ADO_inprocess_proxy::callback_response *ADO_inprocess_proxy::answer(status_t status)
+{
+  if (_response.given) return nullptr;
+  _response.given  = true;
+  _response.status = status;
+  return &_response;
+}
+
+status_t ADO_inprocess_proxy::bootstrap_ado(bool opened_existing)
+{
+  std::vector<uint64_t> attrs;
+  if (_kvs->get_attribute(_pool_id, IKVStore::Attribute::MEMORY_TYPE, attrs) != S_OK)
+    throw Logic_exception("get_attributes failed on storage engine");
+
+  CPLOG(1, "ADO_inprocess_proxy: bootstrap (%s, opened_existing=%d)", _pool_name.c_str(), opened_existing);
+
+  for (const auto &p : _plugins)
+    p->launch_event(_auth_id, _pool_name, _pool_size, _pool_flags, boost::numeric_cast<unsigned int>(attrs[0]),
+                    _expected_obj_count, _params);
+  return S_OK;
+}
+
+status_t ADO_inprocess_proxy::send_op_event(ADO_op op)
+{
+  for (const auto &p : _plugins) p->notify_op_event(op);
+
+  /* the ADO process acknowledges every op event; the shard acts on the
+     acknowledgement, not on the event */
+  std::unique_ptr<callback_request> rq(new callback_request(callback_request::kind_t::OP_EVENT_RESPONSE));
+  rq->op = op;
+  _op_event_responses.push_back(std::move(rq));
+  return S_OK;
+}
+
+status_t ADO_inprocess_proxy::send_cluster_event(const std::string &sender,
+                                                 const std::string &type,
+                                                 const std::string &content)
+{
+  for (const auto &p : _plugins) p->cluster_event(sender, type, content);
+  return S_OK;
+}
+
+status_t ADO_inprocess_proxy::send_memory_map(uint64_t, size_t size, void *value_vaddr)
+{
+  /* pool memory is already mapped, at the same address */
+  status_t s = S_OK;
+  for (const auto &p : _plugins) s |= p->register_mapped_memory(value_vaddr, value_vaddr, size);
+  return s;
+}
+
+status_t ADO_inprocess_proxy::send_memory_map_named(unsigned, string_view, std::size_t, ::iovec iov)
+{
+  return send_memory_map(0, iov.iov_len, iov.iov_base);
+}
+
+status_t ADO_inprocess_proxy::send_work_request(const uint64_t work_request_key,
+                                                const char *   key,
+                                                const size_t   key_len,
+                                                const void *   value_addr,
+                                                const size_t   value_len,
+                                                const void *   detached_value,
+                                                const size_t   detached_value_len,
+                                                const void *   invocation_data,
+                                                const size_t   invocation_data_len,
+                                                const bool     new_root)
+{
+  _completions.emplace_back(work_request_key);
+  auto &c = _completions.back();
+
+  IADO_plugin::value_space_t values;
+  values.append(const_cast<void *>(value_addr), value_len);
+  if (detached_value_len > 0) {
+    assert(detached_value != nullptr);
+    values.append(const_cast<void *>(detached_value), detached_value_len);
+  }
+
+  /* a plugin which throws would have ended the ADO process; here it only
+     fails its request */
+  try {
+    status_t s = S_OK;
+    for (const auto &p : _plugins)
+      s |= p->do_work(work_request_key, key, key_len, values, invocation_data, invocation_data_len, new_root,
+                      c.response_buffers);
+    c.status = s;
+  }
+  catch (const Exception &e) {
+    PWRN("ADO_inprocess_proxy: plugin do_work failed: %s", e.cause());
+    c.status = E_FAIL;
+  }
+  catch (const std::exception &e) {
+    PWRN("ADO_inprocess_proxy: plugin do_work failed: %s", e.what());
+    c.status = E_FAIL;
+  }
+  return S_OK;
+}
+
+bool ADO_inprocess_proxy::check_work_completions(uint64_t &                             request_key,
+                                                 status_t &                             out_status,
+                                                 IADO_plugin::response_buffer_vector_t &response_buffers)
+{
+  if (_completions.empty()) return false;
+
+  auto &c          = _completions.front();
+  request_key      = c.work_key;
+  out_status       = c.status;
+  response_buffers = std::move(c.response_buffers);
+  _completions.pop_front();
+  return true;
+}
+
+status_t ADO_inprocess_proxy::recv_callback_buffer(Buffer_header *&out_buffer)
+{
+  /* plugin callbacks are dispatched as they are made; only op event
+     acknowledgements wait here */
+  if (_op_event_responses.empty()) return E_EMPTY;
+
+  out_buffer = reinterpret_cast<Buffer_header *>(_op_event_responses.front().release());
+  _op_event_responses.pop_front();
+  return S_OK;
+}
+
+void ADO_inprocess_proxy::free_callback_buffer(void *buffer)
+{
+  delete static_cast<callback_request *>(buffer);
+}
+
+bool ADO_inprocess_proxy::check_table_ops(const void *buffer,
+                                          uint64_t &  work_request_id,
+                                          ADO_op &    op,
+                                          std::string &key,
+                                          size_t &    value_len,
+                                          size_t &    align_or_flags,
+                                          void *&     addr)
+{
+  auto rq = as_request(buffer);
+  if (rq->kind != callback_request::kind_t::TABLE_OP) return false;
+  work_request_id = rq->work_id;
+  op              = rq->op;
+  key             = rq->key;
+  value_len       = rq->value_len;
+  align_or_flags  = rq->align_or_flags;
+  addr            = rq->addr;
+  return true;
+}
+
+bool ADO_inprocess_proxy::check_index_ops(const void * buffer,
+                                          std::string &key_expression,
+                                          offset_t &   begin_pos,
+                                          int &        find_type,
+                                          uint32_t)
+{
+  auto rq = as_request(buffer);
+  if (rq->kind != callback_request::kind_t::INDEX_OP) return false;
+  key_expression = rq->key;
+  begin_pos      = rq->begin_pos;
+  find_type      = rq->find_type;
+  return true;
+}
+
+bool ADO_inprocess_proxy::check_vector_ops(const void *buffer, common::epoch_time_t &t_begin, common::epoch_time_t &t_end)
+{
+  auto rq = as_request(buffer);
+  if (rq->kind != callback_request::kind_t::VECTOR_OP) return false;
+  t_begin = rq->t_begin;
+  t_end   = rq->t_end;
+  return true;
+}
+
+bool ADO_inprocess_proxy::check_pool_info_op(const void *buffer)
+{
+  return as_request(buffer)->kind == callback_request::kind_t::POOL_INFO;
+}
+
+bool ADO_inprocess_proxy::check_iterate(const void *               buffer,
+                                        common::epoch_time_t &     t_begin,
+                                        common::epoch_time_t &     t_end,
+                                        IKVStore::pool_iterator_t &iterator)
+{
+  auto rq = as_request(buffer);
+  if (rq->kind != callback_request::kind_t::ITERATE) return false;
+  t_begin  = rq->t_begin;
+  t_end    = rq->t_end;
+  iterator = rq->iterator;
+  return true;
+}
+
+bool ADO_inprocess_proxy::check_op_event_response(const void *buffer, ADO_op &op)
+{
+  auto rq = as_request(buffer);
+  if (rq->kind != callback_request::kind_t::OP_EVENT_RESPONSE) return false;
+  op = rq->op;
+  return true;
+}
+
+bool ADO_inprocess_proxy::check_unlock_request(const void *buffer, uint64_t &work_id, IKVStore::key_t &key_handle)
+{
+  auto rq = as_request(buffer);
+  if (rq->kind != callback_request::kind_t::UNLOCK) return false;
+  work_id    = rq->work_id;
+  key_handle = rq->key_handle;
+  return true;
+}
+
+bool ADO_inprocess_proxy::check_configure_request(const void *buffer, uint64_t &options)
+{
+  auto rq = as_request(buffer);
+  if (rq->kind != callback_request::kind_t::CONFIGURE) return false;
+  options = rq->options;
+  return true;
+}
+
+void ADO_inprocess_proxy::send_unlock_response(const status_t status) { answer(status); }
+
+void ADO_inprocess_proxy::send_configure_response(const status_t status) { answer(status); }
+
+void ADO_inprocess_proxy::send_table_op_response(const status_t        status,
+                                                 const void *          value_addr,
+                                                 size_t                value_len,
+                                                 const char *          key_ptr,
+                                                 IKVStore::key_t       key_handle)
+{
+  if (auto r = answer(status)) {
+    r->value_addr = value_addr;
+    r->value_len  = value_len;
+    r->key_ptr    = key_ptr;
+    r->key_handle = key_handle;
+  }
+}
+
+void ADO_inprocess_proxy::send_find_index_response(const status_t     status,
+                                                   const offset_t     matched_position,
+                                                   const std::string &matched_key)
+{
+  if (auto r = answer(status)) {
+    r->matched_position = matched_position;
+    r->matched_key      = matched_key;
+  }
+}
+
+void ADO_inprocess_proxy::send_vector_response(const status_t status, const IADO_plugin::Reference_vector &rv)
+{
+  if (auto r = answer(status)) r->vector = rv;
+}
+
+void ADO_inprocess_proxy::send_iterate_response(const status_t                   status,
+                                                const IKVStore::pool_iterator_t  iterator,
+                                                const IKVStore::pool_reference_t reference)
+{
+  if (auto r = answer(status)) {
+    r->iterator  = iterator;
+    r->reference = reference;
+  }
+}
+
+void ADO_inprocess_proxy::send_pool_info_response(const status_t status, const std::string &info)
+{
+  if (auto r = answer(status)) r->info = info;
+}
+
+status_t ADO_inprocess_proxy::shutdown()
+{
+  PLOG("ADO_inprocess_proxy: shutting down plugins");
+  release_life_locks();
+  for (const auto &p : _plugins) p->shutdown();
+  return S_OK;
+}
+
+void ADO_inprocess_proxy::add_deferred_unlock(const uint64_t work_request_id, const IKVStore::key_t key)
+{
+  if (_deferred_unlocks.size() > MAX_ALLOWED_DEFERRED_LOCKS) throw std::range_error("too many deferred locks");
+
+  _deferred_unlocks[work_request_id].insert(key);
+}
+
+status_t ADO_inprocess_proxy::update_deferred_unlock(const uint64_t work_request_id, const IKVStore::key_t key)
+{
+  auto i = _deferred_unlocks.find(work_request_id);
+  if (i == _deferred_unlocks.end()) return E_NOT_FOUND;
+  auto iter_pos = i->second.find(key);
+  if (iter_pos == i->second.end()) return E_NOT_FOUND;
+  i->second.erase(iter_pos);
+  return S_OK;
+}
+
+void ADO_inprocess_proxy::get_deferred_unlocks(const uint64_t work_request_id, std::vector<IKVStore::key_t> &keys)
+{
+  keys.clear();
+  auto i = _deferred_unlocks.find(work_request_id);
+  if (i == _deferred_unlocks.end()) return;
+  keys.assign(i->second.begin(), i->second.end());
+  _deferred_unlocks.erase(i);
+}
+
+bool ADO_inprocess_proxy::check_for_implicit_unlock(const uint64_t work_request_id, const IKVStore::key_t key)
+{
+  auto i = _deferred_unlocks.find(work_request_id);
+  if (i != _deferred_unlocks.end() && i->second.find(key) != i->second.end()) return true;
+
+  return _life_unlocks.find(key) != _life_unlocks.end();
+}
+
+void ADO_inprocess_proxy::add_life_unlock(const IKVStore::key_t key) { _life_unlocks.insert(key); }
+
+status_t ADO_inprocess_proxy::remove_life_unlock(const IKVStore::key_t key)
+{
+  auto pos = _life_unlocks.find(key);
+  if (pos == _life_unlocks.end()) return E_NOT_FOUND;
+  _life_unlocks.erase(pos);
+  return S_OK;
+}
+
+void ADO_inprocess_proxy::release_life_locks()
+{
+  auto lock_count = _life_unlocks.size();
+  for (auto &lock : _life_unlocks) {
+    CPLOG(1, "ADO_inprocess_proxy: releasing lock pool_id=%lx lock=%p", _pool_id, static_cast<const void *>(lock));
+    status_t rc = _kvs->unlock(_pool_id, lock);
+    if (rc != S_OK) throw Logic_exception("release_life_locks: pool unlock failed (%d)", rc);
+  }
+  _life_unlocks.clear();
+  CPLOG(1, "ADO_inprocess_proxy: %zu life locks released.", lock_count);
+}
+
+}  // namespace mcas
@@ -0,0 +1,275 @@
+/*
+  Copyright [2017-2020] [IBM Corporation]
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+  http://www.apache.org/licenses/LICENSE-2.0
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef __MCAS_ADO_INPROCESS_H__
+#define __MCAS_ADO_INPROCESS_H__
+
+#include <api/ado_itf.h>
+#include <api/itf_ref.h>
+#include <api/kvstore_itf.h>
+#include <common/logging.h> /* log_source */
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace mcas
+{
+/**
+ * @brief      ADO proxy which runs the ADO plugins in the shard process
+ *
+ * The plugins are loaded into the shard, as the ADO process would load
+ * them, and are called directly: a work request runs to completion inside
+ * send_work_request, on the shard thread, and its completion is queued for
+ * check_work_completions. Plugin callbacks are handed, as in-memory
+ * requests, to a dispatch function supplied by the shard, which interprets
+ * them with the check_xxx functions and answers through the
+ * send_xxx_response functions, exactly as it handles callbacks arriving
+ * from an ADO process. There is no IPC, no memory exposure and no process.
+ *
+ * Only for trusted plugins: a plugin fault takes down the shard, and all
+ * pools of all shards share one copy of each plugin's global state.
+ */
+class ADO_inprocess_proxy : public component::IADO_proxy,
+                            private common::log_source {
+ public:
+  /* dispatch of a callback request: the proxy and the request "buffer" */
+  using dispatch_t = std::function<void(component::IADO_proxy *, const void *)>;
+
+  static constexpr size_t MAX_ALLOWED_DEFERRED_LOCKS = 256;
+
+  /**
+   * Constructor
+   *
+   * @param plugins Paths of the ADO plugin shared objects
+   * @param params Plugin parameters, as given to the ADO process
+   * @param dispatch Shard handler for callback requests
+   *
+   * @throw General_exception - plugin cannot be loaded
+   */
+  ADO_inprocess_proxy(const uint64_t                  auth_id,
+                      const unsigned                  debug_level,
+                      component::IKVStore *           kvs,
+                      component::IKVStore::pool_t     pool_id,
+                      const std::string &             pool_name,
+                      const size_t                    pool_size,
+                      const unsigned int              pool_flags,
+                      const uint64_t                  expected_obj_count,
+                      const std::vector<std::string> &plugins,
+                      const std::vector<std::string> &params,
+                      dispatch_t                      dispatch);
+
+  ADO_inprocess_proxy(const ADO_inprocess_proxy &) = delete;
+  ADO_inprocess_proxy &operator=(const ADO_inprocess_proxy &) = delete;
+
+  virtual ~ADO_inprocess_proxy();
+
+  void *query_interface(component::uuid_t &itf_uuid) override
+  {
+    if (itf_uuid == component::IADO_proxy::iid()) return static_cast<component::IADO_proxy *>(this);
+    return nullptr;
+  }
+
+  void unload() override { delete this; }
+
+  status_t bootstrap_ado(bool opened_existing) override;
+
+  status_t send_op_event(component::ADO_op op) override;
+
+  status_t send_cluster_event(const std::string &sender, const std::string &type, const std::string &content) override;
+
+  status_t send_memory_map(uint64_t token, size_t size, void *value_vaddr) override;
+
+  status_t send_memory_map_named(unsigned region_id, string_view pool_name, std::size_t offset, ::iovec iov) override;
+
+  status_t send_work_request(const uint64_t work_request_key,
+                             const char *   key,
+                             const size_t   key_len,
+                             const void *   value_addr,
+                             const size_t   value_len,
+                             const void *   detached_value,
+                             const size_t   detached_value_len,
+                             const void *   invocation_data,
+                             const size_t   invocation_data_len,
+                             const bool     new_root) override;
+
+  bool check_work_completions(uint64_t &                                        request_key,
+                              status_t &                                        out_status,
+                              component::IADO_plugin::response_buffer_vector_t &response_buffers) override;
+
+  status_t recv_callback_buffer(Buffer_header *&out_buffer) override;
+
+  void free_callback_buffer(void *buffer) override;
+
+  bool check_table_ops(const void *       buffer,
+                       uint64_t &         work_request_id,
+                       component::ADO_op &op,
+                       std::string &      key,
+                       size_t &           value_len,
+                       size_t &           value_alignment,
+                       void *&            addr) override;
+
+  bool check_index_ops(const void * buffer,
+                       std::string &key_expression,
+                       offset_t &   begin_pos,
+                       int &        find_type,
+                       uint32_t     max_comp) override;
+
+  bool check_vector_ops(const void *buffer, common::epoch_time_t &t_begin, common::epoch_time_t &t_end) override;
+
+  bool check_pool_info_op(const void *buffer) override;
+
+  bool check_iterate(const void *                          buffer,
+                     common::epoch_time_t &                t_begin,
+                     common::epoch_time_t &                t_end,
+                     component::IKVStore::pool_iterator_t &iterator) override;
+
+  bool check_op_event_response(const void *buffer, component::ADO_op &op) override;
+
+  bool check_unlock_request(const void *buffer, uint64_t &work_id, component::IKVStore::key_t &key_handle) override;
+
+  void send_unlock_response(const status_t status) override;
+
+  bool check_configure_request(const void *buffer, uint64_t &options) override;
+
+  void send_configure_response(const status_t status) override;
+
+  void send_table_op_response(const status_t             status,
+                              const void *               value_addr     = nullptr,
+                              size_t                     value_len      = 0,
+                              const char *               key_ptr        = nullptr,
+                              component::IKVStore::key_t out_key_handle = nullptr) override;
+
+  void send_find_index_response(const status_t     status,
+                                const offset_t     matched_position,
+                                const std::string &matched_key) override;
+
+  void send_vector_response(const status_t status, const component::IADO_plugin::Reference_vector &rv) override;
+
+  void send_iterate_response(const status_t                              status,
+                             const component::IKVStore::pool_iterator_t  iterator,
+                             const component::IKVStore::pool_reference_t reference) override;
+
+  void send_pool_info_response(const status_t status, const std::string &info) override;
+
+  bool has_exited() override { return false; }
+
+  status_t shutdown() override;
+
+  component::IKVStore::pool_t pool_id() const override { return _pool_id; }
+
+  std::string ado_id() const override { return "in-process"; }
+
+  const std::string &pool_name() const override { return _pool_name; }
+
+  void add_deferred_unlock(const uint64_t work_request_id, const component::IKVStore::key_t key) override;
+
+  status_t update_deferred_unlock(const uint64_t work_request_id, const component::IKVStore::key_t key) override;
+
+  void get_deferred_unlocks(const uint64_t work_request_id, std::vector<component::IKVStore::key_t> &keys) override;
+
+  void add_life_unlock(const component::IKVStore::key_t key) override;
+
+  bool check_for_implicit_unlock(const uint64_t work_request_id, const component::IKVStore::key_t key) override;
+
+  status_t remove_life_unlock(const component::IKVStore::key_t key) override;
+
+  void release_life_locks() override;
+
+ private:
+  /* a plugin callback, or an op event response, in place of an IPC message */
+  struct callback_request {
+    enum class kind_t { TABLE_OP, INDEX_OP, VECTOR_OP, POOL_INFO, ITERATE, OP_EVENT_RESPONSE, UNLOCK, CONFIGURE };
+
+    explicit callback_request(kind_t kind_);
+    callback_request(const callback_request &) = delete;
+    callback_request &operator=(const callback_request &) = delete;
+
+    kind_t                               kind;
+    uint64_t                             work_id;
+    component::ADO_op                    op;
+    std::string                          key; /* or key expression */
+    size_t                               value_len;
+    size_t                               align_or_flags;
+    void *                               addr;
+    offset_t                             begin_pos;
+    int                                  find_type;
+    common::epoch_time_t                 t_begin;
+    common::epoch_time_t                 t_end;
+    component::IKVStore::pool_iterator_t iterator;
+    component::IKVStore::key_t           key_handle;
+    uint64_t                             options;
+  };
+
+  /* the shard's answer to the callback in progress */
+  struct callback_response {
+    callback_response();
+    callback_response(const callback_response &) = default;
+    callback_response &operator=(const callback_response &) = default;
+
+    bool                                     given;
+    status_t                                 status;
+    const void *                             value_addr;
+    size_t                                   value_len;
+    const char *                             key_ptr;
+    component::IKVStore::key_t               key_handle;
+    offset_t                                 matched_position;
+    std::string                              matched_key;
+    component::IADO_plugin::Reference_vector vector;
+    component::IKVStore::pool_iterator_t     iterator;
+    component::IKVStore::pool_reference_t    reference;
+    std::string                              info;
+  };
+
+  struct work_completion {
+    explicit work_completion(uint64_t work_key_);
+
+    uint64_t                                         work_key;
+    status_t                                         status;
+    component::IADO_plugin::response_buffer_vector_t response_buffers;
+  };
+
+  /* hand a callback to the shard; returns the status of its answer */
+  status_t call(const callback_request &rq);
+
+  /* first answer wins, as the ADO process would only read the first */
+  callback_response *answer(status_t status);
+
+  static const callback_request *as_request(const void *buffer) { return static_cast<const callback_request *>(buffer); }
+
+  component::IADO_plugin::Callback_table make_callback_table();
+
+  const uint64_t                                            _auth_id;
+  component::IKVStore *                                     _kvs;
+  const component::IKVStore::pool_t                         _pool_id;
+  const std::string                                         _pool_name;
+  const size_t                                              _pool_size;
+  const unsigned int                                        _pool_flags;
+  const uint64_t                                            _expected_obj_count;
+  const std::vector<std::string>                            _params;
+  dispatch_t                                                _dispatch;
+  std::vector<component::Itf_ref<component::IADO_plugin>>   _plugins;
+  std::deque<work_completion>                               _completions;
+  std::deque<std::unique_ptr<callback_request>>             _op_event_responses;
+  callback_response                                         _response;
+  std::map<uint64_t, std::set<component::IKVStore::key_t>> _deferred_unlocks;
+  std::set<component::IKVStore::key_t>                      _life_unlocks;
+};
+
+}  // namespace mcas
+
+#endif  // __MCAS_ADO_INPROCESS_H__
@@ -27,15 +27,20 @@
 #include "mcas_config.h"
 #include "memory_registered.h"
 #include <gsl/pointers> /* not_null */
+#include <algorithm>    /* min */
+#include <array>
 #include <cassert>
 #include <cstring>      /* memset */
 #include <memory>       /* unique_ptr */
+#include <unordered_map>
+#include <vector>
 
 namespace
 {
   inline auto alloc_base(std::size_t len) -> gsl::not_null<void *>
   {
-    auto b = ::aligned_alloc(MiB(2), len);
+    /* huge page alignment for the large buffers, page alignment otherwise */
+    auto b = ::aligned_alloc(std::min(len, std::size_t(MiB(2))), len);
     if (b == nullptr) {
       throw std::bad_alloc();
     }
@@ -54,6 +59,29 @@ class Buffer_manager : private common::log_source {
 public:
   static constexpr size_t DEFAULT_BUFFER_COUNT = NUM_SHARD_BUFFERS;
   static constexpr size_t BUFFER_LEN           = MiB(2); /* corresponds to huge page see below */
+  static constexpr size_t DEFAULT_RETAIN       = 8;      /* free buffers kept, per size class */
+
+  /* Buffers come in three sizes. Receives, and responses of unknown size,
+   * take a LARGE buffer (BUFFER_LEN, the largest message); fixed-size
+   * responses a SMALL one; small values a MEDIUM one.
+   */
+  enum size_class : unsigned {
+    SMALL,
+    MEDIUM,
+    LARGE,
+    SIZE_CLASS_COUNT,
+  };
+
+  static constexpr size_t class_length(size_class c)
+  {
+    return c == SMALL ? KiB(4) : c == MEDIUM ? KiB(16) : BUFFER_LEN;
+  }
+
+  /* the smallest class which holds len bytes */
+  static constexpr size_class class_for(size_t len)
+  {
+    return len <= class_length(SMALL) ? SMALL : len <= class_length(MEDIUM) ? MEDIUM : LARGE;
+  }
   using memory_registered_t                    = memory_registered<Transport>;
 
   using memory_region_t = typename Transport::memory_region_t;
@@ -66,7 +94,10 @@ public:
     iov_mem_lock(::iovec *iov_)
       : _iov(iov_)
     {
-      ::madvise(_iov->iov_base, _iov->iov_len, MADV_HUGEPAGE);
+      if ( MiB(2) <= _iov->iov_len )
+      {
+        ::madvise(_iov->iov_base, _iov->iov_len, MADV_HUGEPAGE);
+      }
       ::mlock(_iov->iov_base, _iov->iov_len);
     }
     iov_mem_lock(iov_mem_lock &&) noexcept = default;
@@ -184,6 +215,12 @@ public:
     unsigned int crc32() const { return common::chksum32(iov->iov_base, iov->iov_len); }
   };
 
+  /**
+   * Ctor. Buffers are allocated (and registered) when first needed, not
+   * here, so that an idle connection pins only the buffers it has posted.
+   *
+   * @param buffer_count Limit on the buffers allocated at once
+   */
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Weffc++"  // missing initializers
   Buffer_manager(unsigned debug_level_,
@@ -191,14 +228,12 @@ public:
                  size_t buffer_count = DEFAULT_BUFFER_COUNT)
     : common::log_source(debug_level_),
       _buffer_count(buffer_count),
-      _transport(transport)
+      _transport(transport),
+      _retain{{DEFAULT_RETAIN, DEFAULT_RETAIN, DEFAULT_RETAIN}},
+      _bytes(0),
+      _bytes_peak(0)
   {
-    for (unsigned i = 0; i < _buffer_count; i++) {
-      const auto len  = BUFFER_LEN;
-      _buffers.emplace_back(std::make_unique<buffer_internal>(debug_level_, _transport, len));
-      _free.push_back(_buffers.back().get());
-    }
-    PLOG("%s %p allocated %lu buffers", __func__, static_cast<void *>(this), buffer_count);
+    CPLOG(1, "%s %p limit %lu buffers", __func__, static_cast<void *>(this), buffer_count);
   }
 #pragma GCC diagnostic pop
 
@@ -210,12 +245,25 @@ public:
 
   using completion_t = void (*)(void *, buffer_internal *);
 
-  buffer_internal *allocate(completion_t completion_)
+  buffer_internal *allocate(completion_t completion_, size_class c = LARGE)
   {
-    if (UNLIKELY(_free.empty())) throw Program_exception("Buffer_manager: no shard buffers remaining");
-    auto iob = _free.back();
-    _free.pop_back();
-    CPLOG(3, "%s::%s %p (%lu free)", _cname, __func__, static_cast<const void *>(iob), _free.size());
+    auto &free_list = _free[c];
+    buffer_internal *iob;
+    if (free_list.empty()) {
+      if (UNLIKELY(_buffers.size() == _buffer_count)) throw Program_exception("Buffer_manager: no shard buffers remaining");
+      auto b = std::make_unique<buffer_internal>(debug_level(), _transport, class_length(c));
+      iob = b.get();
+      _buffers.emplace(iob, std::move(b));
+      _bytes += class_length(c);
+      _bytes_peak = std::max(_bytes_peak, _bytes);
+      CPLOG(2, "%s::%s new %p len %zu (%zu buffers)", _cname, __func__, static_cast<const void *>(iob),
+            class_length(c), _buffers.size());
+    }
+    else {
+      iob = free_list.back();
+      free_list.pop_back();
+    }
+    CPLOG(3, "%s::%s %p (%lu free)", _cname, __func__, static_cast<const void *>(iob), free_list.size());
     assert(iob);
     iob->reset_length();
     iob->set_completion(completion_);
@@ -225,13 +273,30 @@ public:
   void free(buffer_internal *iob)
   {
     assert(iob);
-
-    CPLOG(3, "%s::%s %p (%lu free)", _cname, __func__, static_cast<const void *>(iob), _free.size());
+    auto &free_list = _free[class_for(iob->original_length())];
+
+    CPLOG(3, "%s::%s %p (%lu free)", _cname, __func__, static_cast<const void *>(iob), free_list.size());
+    if (_retain[class_for(iob->original_length())] <= free_list.size()) {
+      /* more than a burst's worth: give the memory back */
+      _bytes -= iob->original_length();
+      _buffers.erase(iob);
+      return;
+    }
     iob->reset_length();
     iob->set_completion(nullptr);
-    _free.push_back(iob);
+    free_list.push_back(iob);
   }
 
+  /**
+   * Set the number of free buffers of a class kept for reuse; buffers freed
+   * beyond that are deregistered and released.
+   */
+  void set_retain(size_class c, size_t count) { _retain[c] = count; }
+
+  /* bytes of buffers allocated (and registered and locked), now and at most */
+  size_t bytes() const { return _bytes; }
+  size_t bytes_peak() const { return _bytes_peak; }
+
 private:
   // static constexpr size_t buffer_len() { return BUFFER_LEN; }
 
@@ -240,8 +305,11 @@ private:
 
   const size_t                           _buffer_count;
   gsl::not_null<Transport *>             _transport;
-  std::vector<std::unique_ptr<buffer_internal>> _buffers;
-  std::vector<buffer_internal *>        _free;
+  std::unordered_map<const buffer_internal *, std::unique_ptr<buffer_internal>> _buffers;
+  std::array<std::vector<buffer_internal *>, SIZE_CLASS_COUNT> _free;
+  std::array<size_t, SIZE_CLASS_COUNT>  _retain;
+  size_t                                 _bytes;
+  size_t                                 _bytes_peak;
 };
 }  // namespace mcas
 
@@ -62,12 +62,19 @@ namespace config
   static constexpr const char *ado_plugins = "ado_plugins";
   static constexpr const char *ado_params = "ado_params";
   static constexpr const char *ado_path = "ado_path";
+  static constexpr const char *ado_in_process = "ado_in_process";
   static constexpr const char *security = "security";
   static constexpr const char *cert = "cert";
   static constexpr const char *cluster = "cluster";
   static constexpr const char *core = "core";
   static constexpr const char *group = "group";
   static constexpr const char *name = "name";
+  static constexpr const char *batch_budget = "batch_budget";
+  static constexpr const char *worker_threads = "worker_threads";
+  static constexpr const char *group_commit = "group_commit";
+  static constexpr const char *idle_spin_usec = "idle_spin_usec";
+  static constexpr const char *local_clients = "local_clients";
+  static constexpr const char *local_share_regions = "local_share_regions";
 }
 
 namespace
@@ -282,6 +289,57 @@ namespace
                 )
               )
             )
+          , json::member
+            ( config::batch_budget
+            , json::object
+              ( json::member(schema::description, "Maximum number of pending messages to handle from one client connection before moving on to the next. Default 1.")
+              , json::member(schema::examples, json::array(json::number(1), json::number(16)))
+              , json::member(schema::type, schema::integer)
+              , json::member(schema::minimum, json::number(1))
+              )
+            )
+          , json::member
+            ( config::worker_threads
+            , json::object
+              ( json::member(schema::description, "Number of threads which execute PUT, GET and ERASE requests on behalf of the shard thread. Requires a thread-safe backend such as hstore-mt. Default 0 (shard thread executes all requests).")
+              , json::member(schema::examples, json::array(json::number(0), json::number(4)))
+              , json::member(schema::type, schema::integer)
+              , json::member(schema::minimum, json::number(0))
+              )
+            )
+          , json::member
+            ( config::group_commit
+            , json::object
+              ( json::member(schema::description, "Make the stores of each batch of requests durable with one persistence fence, before sending any of their responses. Requires a backend which supports it (hstore). Default false.")
+              , json::member(schema::examples, json::array(json::boolean(false), json::boolean(true)))
+              , json::member(schema::type, schema::boolean)
+              )
+            )
+          , json::member
+            ( config::idle_spin_usec
+            , json::object
+              ( json::member(schema::description, "Microseconds for which the shard thread polls without finding work before it blocks until a client message arrives, freeing its core. Default: never block.")
+              , json::member(schema::examples, json::array(json::number(0), json::number(200)))
+              , json::member(schema::type, schema::integer)
+              , json::member(schema::minimum, json::number(0))
+              )
+            )
+          , json::member
+            ( config::local_clients
+            , json::object
+              ( json::member(schema::description, "Also accept clients on this host through shared memory (net_providers \"shm\" in the client), on the same port number. Default false.")
+              , json::member(schema::examples, json::array(json::boolean(false), json::boolean(true)))
+              , json::member(schema::type, schema::boolean)
+              )
+            )
+          , json::member
+            ( config::local_share_regions
+            , json::object
+              ( json::member(schema::description, "Let shared memory clients map file-backed pool memory read-only, so that they read values in place rather than through the shard. Any local client may then read any such pool of this shard. Default false.")
+              , json::member(schema::examples, json::array(json::boolean(false), json::boolean(true)))
+              , json::member(schema::type, schema::boolean)
+              )
+            )
           , json::member
             ( config::index
               , json::object
@@ -309,7 +367,7 @@ namespace
             ( config::default_backend
               , json::object
                 ( json::member(schema::description, "Key/value store implementation to use.")
-                , json::member(schema::examples, json::array("hstore", "hstore-cc", "mapstore"))
+                , json::member(schema::examples, json::array("hstore", "hstore-cc", "hstore-mt", "mapstore"))
                 , json::member(schema::type, schema::string)
                 , json::member(schema::type, schema::string)
                 )
@@ -333,6 +391,14 @@ namespace
                 )
               )
             )
+          , json::member
+            ( config::ado_in_process
+            , json::object
+              ( json::member(schema::description, "Load the ADO plugins into the shard process and call them directly, rather than through a separate ADO process. Only for trusted plugins: a plugin fault ends the shard. Default false.")
+              , json::member(schema::examples, json::array(json::boolean(false), json::boolean(true)))
+              , json::member(schema::type, schema::boolean)
+              )
+            )
           , json::member
             ( config::ado_params
             , json::object
@@ -421,8 +487,8 @@ namespace
           , json::member
             ( config::net_providers
             , json::object
-              ( json::member(schema::description, "ilibfabric net provider ('verbs' or 'sockets')")
-              , json::member(schema::examples, json::array("verbs", "sockets"))
+              ( json::member(schema::description, "ilibfabric net provider ('verbs' or 'sockets'), 'uring' for TCP through io_uring, or 'shm' for shared memory (clients on this host only)")
+              , json::member(schema::examples, json::array("verbs", "sockets", "uring", "shm"))
               , json::member(schema::type, schema::string))
             )
           , json::member
@@ -729,6 +795,60 @@ unsigned int mcas::Config_file::get_shard_port(rapidjson::SizeType i) const
   return m == shard.MemberEnd() ? 0 : m->value.GetUint();
 }
 
+unsigned int mcas::Config_file::get_shard_batch_budget(rapidjson::SizeType i) const
+{
+  if (i > shard_count()) throw Config_exception("%s out of bounds", __func__);
+  assert(_shards[i].IsObject());
+  auto shard = _shards[i].GetObject();
+  auto m     = shard.FindMember(config::batch_budget);
+  return m == shard.MemberEnd() ? 1 : std::max(1U, m->value.GetUint());
+}
+
+unsigned int mcas::Config_file::get_shard_worker_threads(rapidjson::SizeType i) const
+{
+  if (i > shard_count()) throw Config_exception("%s out of bounds", __func__);
+  assert(_shards[i].IsObject());
+  auto shard = _shards[i].GetObject();
+  auto m     = shard.FindMember(config::worker_threads);
+  return m == shard.MemberEnd() ? 0 : m->value.GetUint();
+}
+
+bool mcas::Config_file::get_shard_group_commit(rapidjson::SizeType i) const
+{
+  if (i > shard_count()) throw Config_exception("%s out of bounds", __func__);
+  assert(_shards[i].IsObject());
+  auto shard = _shards[i].GetObject();
+  auto m     = shard.FindMember(config::group_commit);
+  return m != shard.MemberEnd() && m->value.GetBool();
+}
+
+boost::optional<unsigned int> mcas::Config_file::get_shard_idle_spin_usec(rapidjson::SizeType i) const
+{
+  if (i > shard_count()) throw Config_exception("%s out of bounds", __func__);
+  assert(_shards[i].IsObject());
+  auto shard = _shards[i].GetObject();
+  auto m     = shard.FindMember(config::idle_spin_usec);
+  return m == shard.MemberEnd() ? boost::optional<unsigned int>() : m->value.GetUint();
+}
+
+bool mcas::Config_file::get_shard_local_clients(rapidjson::SizeType i) const
+{
+  if (i > shard_count()) throw Config_exception("%s out of bounds", __func__);
+  assert(_shards[i].IsObject());
+  auto shard = _shards[i].GetObject();
+  auto m     = shard.FindMember(config::local_clients);
+  return m != shard.MemberEnd() && m->value.GetBool();
+}
+
+bool mcas::Config_file::get_shard_local_share_regions(rapidjson::SizeType i) const
+{
+  if (i > shard_count()) throw Config_exception("%s out of bounds", __func__);
+  assert(_shards[i].IsObject());
+  auto shard = _shards[i].GetObject();
+  auto m     = shard.FindMember(config::local_share_regions);
+  return m != shard.MemberEnd() && m->value.GetBool();
+}
+
 boost::optional<std::string> mcas::Config_file::get_shard_optional(std::string field, rapidjson::SizeType i) const
 {
   if (field.empty()) throw Config_exception("%s invalid field", __func__);
@@ -763,6 +883,15 @@ std::vector<std::string> mcas::Config_file::get_shard_ado_plugins(rapidjson::Siz
   return result;
 }
 
+bool mcas::Config_file::get_shard_ado_in_process(rapidjson::SizeType i) const
+{
+  if (i > shard_count()) throw Config_exception("%s out of bounds", __func__);
+  assert(_shards[i].IsObject());
+  auto shard = _shards[i].GetObject();
+  auto m     = shard.FindMember(config::ado_in_process);
+  return m != shard.MemberEnd() && m->value.GetBool();
+}
+
 std::map<std::string, std::string> mcas::Config_file::get_shard_ado_params(rapidjson::SizeType i) const
 {
   auto result = std::map<std::string, std::string>();
@@ -79,6 +79,18 @@ class Config_file : private common::log_source {
 
   unsigned int get_shard_port(rapidjson::SizeType i) const;
 
+  unsigned int get_shard_batch_budget(rapidjson::SizeType i) const;
+
+  unsigned int get_shard_worker_threads(rapidjson::SizeType i) const;
+
+  bool get_shard_group_commit(rapidjson::SizeType i) const;
+
+  boost::optional<unsigned int> get_shard_idle_spin_usec(rapidjson::SizeType i) const;
+
+  bool get_shard_local_clients(rapidjson::SizeType i) const;
+
+  bool get_shard_local_share_regions(rapidjson::SizeType i) const;
+
   boost::optional<std::string> get_shard_optional(std::string field, rapidjson::SizeType i) const;
 
   std::string get_shard_required(std::string field, rapidjson::SizeType i) const;
@@ -89,6 +101,8 @@ class Config_file : private common::log_source {
 
   std::vector<std::string> get_shard_ado_plugins(rapidjson::SizeType i) const;
 
+  bool get_shard_ado_in_process(rapidjson::SizeType i) const;
+
   std::map<std::string, std::string> get_shard_ado_params(rapidjson::SizeType i) const;
 
   auto get_shard_object(std::string name, rapidjson::SizeType i) const;
@@ -25,6 +25,7 @@ Connection_handler::Connection_handler(unsigned debug_level_, gsl::not_null<Fact
       _tick_count(0),
       _auth_id(0),
       _pending_msgs{},
+      _pending_stamps{},
       _pending_actions
 {
 }
@@ -75,10 +76,27 @@ int Connection_handler::tick()
   }
 
   switch (_state) {
-    case WAIT_NEW_MSG_RECV:
-      if (check_for_posted_recv_complete()) /*< check for recv completion */
+    case WAIT_NEW_MSG_RECV: {
+      if (!next_msg_ready()) { /*< check for recv (or read) completion */
+        ++_stats.wait_msg_recv_misses;
+        break;
+      }
+
+      /* move every completed receive to the pending queue; with a recv
+         depth above one, a pipelining client may have several in flight */
+      const auto stamp = rdtsc();
+      while (response == TICK_RESPONSE_CONTINUE && next_msg_ready())
       {
-        auto iob = posted_recv();
+        buffer_t *iob = _body;
+        if (iob) {
+          /* a message sent by reference, now read, in its turn */
+          _body = nullptr;
+        }
+        else {
+          iob = posted_recv();
+          assert(_recv_buffer_posted_count < _recv_depth + EXTRA_BISCUITS); /* no extra biscuits */
+          post_recv_buffer(allocate_recv());
+        }
         assert(iob);
 
         const auto msg = protocol::message_cast(iob->base());
@@ -89,21 +107,16 @@ int Connection_handler::tick()
         switch (msg->type_id()) {
           case MSG_TYPE_IO_REQUEST:
             if (option_DEBUG > 2) PMAJOR("Shard: IO_REQUEST");
-            _pending_msgs.push(iob);
-            post_recv_buffer(allocate_recv());
+            push_pending_msg(iob, stamp);
             break;
 
           case MSG_TYPE_PUT_ADO_REQUEST:
           case MSG_TYPE_ADO_REQUEST:
             if (option_DEBUG > 2) PMAJOR("Shard: ADO_REQUEST");
-            _pending_msgs.push(iob);
-            assert(_recv_buffer_posted_count <= EXTRA_BISCUITS); /* no extra biscuits */
-            post_recv_buffer(allocate_recv());
+            push_pending_msg(iob, stamp);
             break;
 
           case MSG_TYPE_CLOSE_SESSION:
-            assert(_recv_buffer_posted_count <= EXTRA_BISCUITS); /* no extra biscuits */
-            post_recv_buffer(allocate_recv());
             if (option_DEBUG > 2) PMAJOR("Shard: CLOSE_SESSION");
             free_recv_buffer();
             response = TICK_RESPONSE_CLOSE;
@@ -111,17 +124,25 @@ int Connection_handler::tick()
 
           case MSG_TYPE_POOL_REQUEST:
             if (option_DEBUG > 2) PMAJOR("Shard: POOL_REQUEST");
-            _pending_msgs.push(iob);
-            assert(_recv_buffer_posted_count <= EXTRA_BISCUITS); /* no extra biscuits */
-            post_recv_buffer(allocate_recv());
+            push_pending_msg(iob, stamp);
             break;
 
           case MSG_TYPE_INFO_REQUEST:
             if (option_DEBUG > 2) PMAJOR("Shard: INFO_REQUEST");
-            _pending_msgs.push(iob);
-            assert(_recv_buffer_posted_count <= EXTRA_BISCUITS); /* no extra biscuits */
-            post_recv_buffer(allocate_recv());
+            push_pending_msg(iob, stamp);
+            break;
+
+          case MSG_TYPE_BODY_REF: {
+            /* read the message into a LARGE buffer; later messages wait for it */
+            const auto ref = msg->ptr_cast<Message_body_ref>();
+            if (option_DEBUG > 2) PMAJOR("Shard: BODY_REF (len %lu)", ref->len);
+            if (ref->len < sizeof(Message) || IO_buffer_size() < ref->len)
+              throw Protocol_exception("%s - bad BODY_REF length %lu", __func__, ref->len);
+            _body = allocate(static_body_callback);
+            post_read_buffer(_body, ref->len, ref->addr, ref->key);
+            free_buffer(iob);
             break;
+          }
 
           default:
             throw Logic_exception("unhandled message (type:%x)", int(msg->type_id()));
@@ -132,11 +153,9 @@ int Connection_handler::tick()
         if (option_DEBUG > 2)
           PMAJOR("Shard State: %lu %p WAIT_MSG_RECV complete", _tick_count, static_cast<const void *>(this));
       }
-      else {
-        ++_stats.wait_msg_recv_misses;
-      }
 
       break;
+    }
 
     case INITIAL: {
       static int handshakes = 0;
@@ -144,13 +163,14 @@ int Connection_handler::tick()
       if (option_DEBUG > 2)
         PMAJOR("Shard State: %lu %p POST_HANDSHAKE (%d)", _tick_count, static_cast<const void *>(this), handshakes);
 
-      assert(_recv_buffer_posted_count <= EXTRA_BISCUITS); /* no extra biscuits */
-      post_recv_buffer(allocate_recv());
+      /* the client sends nothing more until the handshake is answered; the
+         other receives wait for the handshake to settle their length */
+      post_recv_buffer(allocate(static_recv_callback, sizeof(protocol::Message_handshake)));
 
       /* For an unknown reason, allocating an extra buffer or three makes the
        * hstore benchmark run about 10% faster */
       for (auto i = EXTRA_BISCUITS; i != 0; --i) {
-        assert(_recv_buffer_posted_count <= EXTRA_BISCUITS); /* no extra biscuits */
+        assert(_recv_buffer_posted_count < _recv_depth + EXTRA_BISCUITS); /* no extra biscuits */
         post_recv_buffer(allocate_recv());
       }
 
@@ -179,22 +199,33 @@ int Connection_handler::tick()
         /* set authentication token ; TODO - verify token with AAA */
         set_auth_id(msg->auth_id());
 
-        auto reply_iob = allocate_send();
+        auto reply_iob = allocate_send(sizeof(protocol::Message_handshake_reply));
         assert(reply_iob);
 
+        /* a client which can send long messages by reference gets MEDIUM
+           receive buffers, which pin far less memory than LARGE ones */
+        if (msg->is_body_by_reference()) {
+          _recv_len = Buffer_manager<component::IFabric_server>::class_length(size_class::MEDIUM);
+          retain_buffers_for_depth();
+        }
+
         auto reply_msg = new (reply_iob->base()) protocol::Message_handshake_reply(
-            iob->length(), auth_id(), 1 /* seq */, max_message_size(), reinterpret_cast<uint64_t>(this),
+            reply_iob->length(), auth_id(), 1 /* seq */, reinterpret_cast<uint64_t>(this),
+            msg->is_body_by_reference() ? _recv_len : max_message_size(),
             nullptr,  // cert
             0);
+        if (msg->is_body_by_reference()) reply_msg->set_body_by_reference();
 
         if (option_DEBUG > 2) {
-          PINF("RDMA: max message size (%lu)", max_message_size());
+          PINF("RDMA: max message size (%lu) inline limit (%zu)", max_message_size(), _recv_len);
         }
 
         /* post response */
         reply_iob->set_length(reply_msg->msg_len());
-        assert(_recv_buffer_posted_count <= EXTRA_BISCUITS); /* no extra biscuits */
-        post_recv_buffer(allocate_recv());
+        for (auto i = _recv_depth; i != 0; --i) {
+          assert(_recv_buffer_posted_count < _recv_depth + EXTRA_BISCUITS); /* no extra biscuits */
+          post_recv_buffer(allocate_recv());
+        }
         post_send_buffer(reply_iob, reply_msg, __func__);
         free_buffer(iob);
         set_state(WAIT_NEW_MSG_RECV);
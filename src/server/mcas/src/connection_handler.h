@@ -26,10 +26,12 @@
 #include <api/components.h>
 #include <api/fabric_itf.h>
 #include <api/kvstore_itf.h>
+#include <common/cycles.h>
 #include <common/exceptions.h>
 #include <common/logging.h>
 #include <gsl/pointers>
 
+#include <algorithm> /* max, min */
 #include <cassert>
 #include <map>
 #include <queue>
@@ -71,13 +73,30 @@ class Connection_handler
  private:
   State    _state       = State::INITIAL;
   unsigned option_DEBUG = mcas::global::debug_level;
+  unsigned _recv_depth  = 1; /* receive buffers kept posted */
+  /* length of the receive buffers; less than IO_buffer_size() if the client
+     sends longer messages by reference (see protocol::Message_body_ref) */
+  std::size_t _recv_len = Buffer_manager<component::IFabric_server>::BUFFER_LEN;
+  buffer_t *  _body     = nullptr; /* message being read from the client, handled next */
 
   /* list of pre-registered memory regions; normally one region */
   std::vector<component::IKVStore::memory_handle_t> _mr_vector;
 
+  /* sends deferred by hold_sends, until the shard's group commit */
+  struct held_send {
+    buffer_t *buffer;
+    ::iovec   val_iov;
+    void *    val_desc;
+    bool      has_value;
+  };
+  bool                   _hold_sends = false;
+  std::vector<held_send> _held_sends{};
+
   uint64_t               _tick_count alignas(8);
   uint64_t               _auth_id;
   std::queue<buffer_t *> _pending_msgs;
+  std::queue<cpu_time_t> _pending_stamps; /* receipt time of each pending message */
+  cpu_time_t             _post_cycles = 0; /* spent posting sends, since take_post_cycles */
   std::queue<action_t>   _pending_actions;
 #if 0
   double                 _freq_mhz;
@@ -122,6 +141,7 @@ class Connection_handler
     PINF("Response count              : %lu", _stats.response_count);
     PINF("WAIT_SEND_VALUE misses      : %lu", _stats.wait_send_value_misses);
     PINF("WAIT_RESPOND_COMPLETE misses: %lu", _stats.wait_respond_complete_misses);
+    PINF("Buffer bytes pinned (peak)  : %zu", buffer_bytes_peak());
     PINF("-----------------------------------------");
   }
 
@@ -146,6 +166,44 @@ class Connection_handler
     static_cast<Connection_handler *>(base)->send_callback2(iob);
   }
 
+  static void static_body_callback(void *cnxn, buffer_t *iob) noexcept
+  {
+    auto base = static_cast<Fabric_connection_base *>(cnxn);
+    static_cast<Connection_handler *>(base)->body_callback(iob);
+  }
+
+  void body_callback(buffer_t *iob) noexcept
+  {
+    --_read_posted_count;
+    posted_count_log();
+    if (1 < option_DEBUG) {
+      PLOG("Completed read (%p)", static_cast<const void *>(iob));
+    }
+  }
+
+  /* true if the next message, received or read by reference, is ready to handle */
+  bool next_msg_ready() { return _body ? _read_posted_count == 0 : check_for_posted_recv_complete(); }
+
+  void retain_buffers_for_depth()
+  {
+    /* each message in flight may hold a response, SMALL or (for a small
+       value) MEDIUM, until its send completes; never fewer than the default */
+    const auto responses = std::max(std::size_t(Buffer_manager<component::IFabric_server>::DEFAULT_RETAIN), std::size_t(_recv_depth));
+    retain_buffers(size_class::SMALL, responses);
+    if (_recv_len < IO_buffer_size()) {
+      /* receives are MEDIUM; a LARGE buffer is taken on demand, for a message
+         read by reference or a long response, and few are worth keeping */
+      retain_buffers(size_class::LARGE, 2);
+      retain_buffers(size_class::MEDIUM, 2 * _recv_depth + responses);
+    }
+    else {
+      /* a receive buffer is replaced when its message arrives and freed when
+         the message is handled, so keep enough for a full pipeline in turnover */
+      retain_buffers(size_class::LARGE, 2 * _recv_depth);
+      retain_buffers(size_class::MEDIUM, responses);
+    }
+  }
+
   void send_callback2(buffer_t *iob) noexcept
   {
     assert(iob->value_adjunct);
@@ -161,12 +219,30 @@ class Connection_handler
     gsl::not_null<Factory *> factory,
     gsl::not_null<Connection *> connection);
 
+  Connection_handler(const Connection_handler &) = delete;
+  Connection_handler &operator=(const Connection_handler &) = delete;
+
   ~Connection_handler();
 
   inline bool client_connected() { return _state != State::CLIENT_DISCONNECTED; }
 
+  /**
+   * Set the number of receive buffers kept posted, which bounds the number
+   * of messages a client can have in flight. Effective only before the
+   * first tick.
+   *
+   * @param depth Receive depth
+   */
+  void set_recv_depth(unsigned depth)
+  {
+    _recv_depth = std::max(1U, std::min(depth, unsigned(NUM_SHARD_BUFFERS / 4)));
+    retain_buffers_for_depth();
+  }
+
   auto allocate_send() { return allocate(static_send_callback); }
-  auto allocate_recv() { return allocate(static_recv_callback); }
+  /* a send buffer of at least len bytes, perhaps smaller than IO_buffer_size() */
+  auto allocate_send(std::size_t len) { return allocate(static_send_callback, len); }
+  auto allocate_recv() { return allocate(static_recv_callback, _recv_len); }
 
   /**
    * State machine transition tick.  It is really important that this tick
@@ -224,9 +300,35 @@ class Connection_handler
     assert(!_pending_msgs.empty());
     auto iob = _pending_msgs.front();
     _pending_msgs.pop();
+    _pending_stamps.pop();
     return iob;
   }
 
+  inline void push_pending_msg(buffer_t *iob, cpu_time_t stamp)
+  {
+    _pending_msgs.push(iob);
+    _pending_stamps.push(stamp);
+  }
+
+  /**
+   * Receipt time (rdtsc) of the message which peek_pending_msg returns
+   */
+  inline cpu_time_t pending_msg_stamp() const
+  {
+    assert(!_pending_stamps.empty());
+    return _pending_stamps.front();
+  }
+
+  /**
+   * Cycles spent posting sends since the last call
+   */
+  inline cpu_time_t take_post_cycles()
+  {
+    auto c       = _post_cycles;
+    _post_cycles = 0;
+    return c;
+  }
+
   /**
    * Get deferred actions
    *
@@ -294,7 +396,14 @@ class Connection_handler
   void post_send_buffer(gsl::not_null<buffer_t *> buffer, Msg *msg, const char *desc)
   {
     msg_send_log(msg, desc);
-    Connection_base::post_send_buffer(buffer);
+    if (_hold_sends) {
+      _held_sends.push_back(held_send{buffer, ::iovec{nullptr, 0}, nullptr, false});
+    }
+    else {
+      const auto start = rdtsc();
+      Connection_base::post_send_buffer(buffer);
+      _post_cycles += rdtsc() - start;
+    }
   }
 
   template <typename Msg>
@@ -305,7 +414,38 @@ class Connection_handler
                          const char *              func_name)
   {
     msg_send_log(msg, func_name);
-    Connection_base::post_send_buffer2(buffer, val_iov, val_desc);
+    if (_hold_sends) {
+      _held_sends.push_back(held_send{buffer, val_iov, val_desc, true});
+    }
+    else {
+      const auto start = rdtsc();
+      Connection_base::post_send_buffer2(buffer, val_iov, val_desc);
+      _post_cycles += rdtsc() - start;
+    }
+  }
+
+  /**
+   * Hold back sends (responses) until release_sends. Used by a shard in
+   * group commit mode, which must make the effects of a batch of requests
+   * durable before responding to any of them.
+   */
+  void hold_sends() { _hold_sends = true; }
+
+  /**
+   * Post, in order, the sends held since hold_sends, and stop holding.
+   */
+  void release_sends()
+  {
+    _hold_sends = false;
+    for (const auto &h : _held_sends) {
+      if (h.has_value) {
+        Connection_base::post_send_buffer2(h.buffer, h.val_iov, h.val_desc);
+      }
+      else {
+        Connection_base::post_send_buffer(h.buffer);
+      }
+    }
+    _held_sends.clear();
   }
 
   /**
@@ -26,7 +26,8 @@ Fabric_connection_base::Fabric_connection_base(unsigned debug_level_,
     _recv_buffer_posted_count{},
     _completed_recv_buffers{},
     _send_buffer_posted_count{},
-    _send_value_posted_count{}
+    _send_value_posted_count{},
+    _read_posted_count{}
 {
 }
 
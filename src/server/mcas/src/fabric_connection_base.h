@@ -100,6 +100,9 @@ class Fabric_connection_base : protected common::log_source {
    */
   unsigned _send_value_posted_count;
 
+  /* messages sent by reference, being read from the client */
+  unsigned _read_posted_count;
+
   /**
    * Ctor
    *
@@ -220,6 +223,16 @@ class Fabric_connection_base : protected common::log_source {
     transport()->post_send(buffer->iov, buffer->iov + 2, buffer->desc, buffer);
   }
 
+  /* read a message which the client sent by reference (see protocol::Message_body_ref) */
+  void post_read_buffer(buffer_t *buffer, std::size_t len, std::uint64_t remote_addr, std::uint64_t key)
+  {
+    buffer->set_length(len);
+    transport()->post_read(buffer->iov, buffer->iov + 1, buffer->desc, remote_addr, key, buffer);
+    ++_read_posted_count;
+    posted_count_log();
+    CPLOG(2, "Posted read (%p) len %zu", static_cast<const void *>(buffer), len);
+  }
+
   buffer_t *posted_recv()
   {
     if (_completed_recv_buffers.size() == 0) return nullptr;
@@ -232,13 +245,14 @@ class Fabric_connection_base : protected common::log_source {
 
   void posted_count_log() const
   {
-    CPLOG(1, "POSTs recv %u send %u value %u", _recv_buffer_posted_count, _send_buffer_posted_count,
-           _send_value_posted_count);
+    CPLOG(1, "POSTs recv %u send %u value %u read %u", _recv_buffer_posted_count, _send_buffer_posted_count,
+           _send_value_posted_count, _read_posted_count);
   }
 
   Completion_state poll_completions()
   {
-    if (_recv_buffer_posted_count != 0 || _send_buffer_posted_count != 0 || _send_value_posted_count != 0) {
+    if (_recv_buffer_posted_count != 0 || _send_buffer_posted_count != 0 || _send_value_posted_count != 0 ||
+        _read_posted_count != 0) {
 #if 0
       PLOG("%s posted_recv %u posted_send %u posted_value %u", __func__, _recv_buffer_posted_count, _send_buffer_posted_count, _send_value_posted_count);
 #endif
@@ -253,6 +267,9 @@ class Fabric_connection_base : protected common::log_source {
     return Completion_state::NONE;
   }
 
+  /* see IFabric_op_completer::arm_wait */
+  bool arm_wait(std::vector<int> &fds) { return transport()->arm_wait(fds); }
+
   /**
    * Forwarders that allow us to avoid exposing transport() and _bm
    *
@@ -270,8 +287,18 @@ class Fabric_connection_base : protected common::log_source {
   inline uint64_t get_memory_remote_key(memory_region_t region) { return transport()->get_memory_remote_key(region); }
 
  protected:
+  using size_class = Buffer_manager<component::IFabric_server>::size_class;
+
   inline auto allocate(buffer_t::completion_t c) { return _bm.allocate(c); }
 
+  inline auto allocate(buffer_t::completion_t c, std::size_t len) { return _bm.allocate(c, _bm.class_for(len)); }
+
+  inline void retain_buffers(size_class c, std::size_t count) { _bm.set_retain(c, count); }
+
+  inline std::size_t buffer_bytes() const { return _bm.bytes(); }
+
+  inline std::size_t buffer_bytes_peak() const { return _bm.bytes_peak(); }
+
   inline void free_buffer(buffer_t *buffer) { _bm.free(buffer); }
 
   inline size_t IO_buffer_size() const { return Buffer_manager<component::IFabric_server>::BUFFER_LEN; }
@@ -26,10 +26,36 @@ namespace
 
   const char *optional_print(const boost::optional<std::string> &value) { return optional_string(value).c_str(); }
 
+  bool is_shm(const boost::optional<std::string> &fabric_prov_name_)
+  {
+    return fabric_prov_name_ && *fabric_prov_name_ == "shm";
+  }
+
+  /* SHM: shared memory rings, for clients on this host. No address or domain. */
+  auto make_shm_fabric(bool share_regions_) -> component::IFabric *
+  {
+    using namespace component;
+    namespace c_json = common::json;
+    using json = c_json::serializer<c_json::dummy_writer>;
+
+    auto i_shm_factory =
+      make_itf_ref(static_cast<IFabric_factory *>(load_component("libcomponent-shm.so", net_shm_factory)));
+
+    if (!i_shm_factory.get()) throw General_exception("unable to load shm component");
+
+    auto shm_spec =
+      json::object(
+        json::member("share_regions", json::boolean(share_regions_))
+        , json::member("tx_attr", json::object(json::member("inject_size", mcas::Fabric_transport::INJECT_SIZE)))
+      );
+    return i_shm_factory->make_fabric(shm_spec.str());
+  }
+
   auto make_fabric( //
     const boost::optional<std::string> &src_addr_,
     const boost::optional<std::string> &fabric_prov_name_,
     const boost::optional<std::string> &domain_name_,
+    bool                                share_regions_,
     bool                                debug
   ) -> component::IFabric *
   {
@@ -39,6 +65,30 @@ namespace
 
     if (debug) PLOG("Fabric: bound to (%s,%s)", optional_print(src_addr_), optional_print(domain_name_));
 
+    if ( is_shm(fabric_prov_name_) )
+    {
+      return make_shm_fabric(share_regions_);
+    }
+
+    /* URING: TCP through io_uring, for hosts without RDMA. No domain. */
+    if ( fabric_prov_name_ && *fabric_prov_name_ == "uring" )
+    {
+      auto i_uring_factory =
+        make_itf_ref(static_cast<IFabric_factory *>(load_component("libcomponent-uring.so", net_uring_factory)));
+
+      if (!i_uring_factory.get()) throw General_exception("unable to load uring component");
+
+      auto uring_spec =
+        json::object(
+          json::member("tx_attr", json::object(json::member("inject_size", mcas::Fabric_transport::INJECT_SIZE)))
+        );
+      if ( src_addr_ )
+      {
+        uring_spec.append(json::member("src_addr", *src_addr_));
+      }
+      return i_uring_factory->make_fabric(uring_spec.str());
+    }
+
     /* FABRIC */
     auto i_fabric_factory =
       make_itf_ref(static_cast<IFabric_factory *>(load_component("libcomponent-fabric.so", net_fabric_factory)));
@@ -103,25 +153,41 @@ constexpr unsigned Fabric_transport::INJECT_SIZE;
 Fabric_transport::Fabric_transport(const boost::optional<std::string> &fabric,
                    const boost::optional<std::string> &fabric_provider,
                    const boost::optional<std::string> &device,
-                   unsigned                            port)
+                   unsigned                            port,
+                   bool                                local_clients,
+                   bool                                local_share_regions)
   : _fabric_debug(mcas::global::debug_level > 1),
-    _fabric(make_fabric(fabric, fabric_provider, device, port)),
+    _fabric(make_fabric(fabric, fabric_provider, device, local_share_regions, _fabric_debug)),
     _server_factory(make_server_factory(*_fabric, boost::numeric_cast<uint16_t>(port))),
+    /* a second listener, for clients on this host, unless the first is already one */
+    _local_fabric(local_clients && !is_shm(fabric_provider) ? make_shm_fabric(local_share_regions) : nullptr),
+    _local_server_factory(_local_fabric ? make_server_factory(*_local_fabric, boost::numeric_cast<uint16_t>(port)) : nullptr),
     _port(port)
 {
   if (_fabric_debug)
-    PLOG("fabric_transport: (fabric=%s, provider=%s, device=%s, port=%u)", optional_print(fabric),
-         optional_print(fabric_provider), optional_print(device), port);
+    PLOG("fabric_transport: (fabric=%s, provider=%s, device=%s, port=%u, local=%d)", optional_print(fabric),
+         optional_print(fabric_provider), optional_print(device), port, int(bool(_local_server_factory)));
 }
 
 auto Fabric_transport::get_new_connection() -> Connection_handler *
 {
-  auto connection = _server_factory->get_new_connection();
-  return
-    connection
-    ? new Connection_handler(mcas::global::debug_level, _server_factory.get(), connection)
-    : nullptr;
+  for (auto factory : {_server_factory.get(), _local_server_factory.get()}) {
+    if (factory) {
+      if (auto connection = factory->get_new_connection()) {
+        return new Connection_handler(mcas::global::debug_level, factory, connection);
+      }
+    }
+  }
+  return nullptr;
+}
+
+bool Fabric_transport::arm_wait_listeners(std::vector<int> &fds)
+{
+  bool armed = true;
+  for (auto factory : {_server_factory.get(), _local_server_factory.get()}) {
+    if (factory && !factory->arm_wait(fds)) armed = false;
+  }
+  return armed;
 }
 
-  
 }  // namespace mcas
@@ -21,6 +21,7 @@
 #include "buffer_manager.h"
 #include <memory>  // unique_ptr
 #include <string>
+#include <vector>
 
 namespace mcas
 {
@@ -38,15 +39,24 @@ class Fabric_transport {
   Fabric_transport(const boost::optional<std::string> &fabric,
                    const boost::optional<std::string> &fabric_provider,
                    const boost::optional<std::string> &device,
-                   unsigned                            port);
+                   unsigned                            port,
+                   bool                                local_clients = false,
+                   bool                                local_share_regions = false);
 
   Connection_handler *get_new_connection();
 
+  /* see IFabric_server_factory::arm_wait: false if some listener cannot be
+   * waited on */
+  bool arm_wait_listeners(std::vector<int> &fds);
+
   inline unsigned get_port() const { return _port; }
 
  private:
   std::unique_ptr<component::IFabric>                _fabric;
   std::unique_ptr<component::IFabric_server_factory> _server_factory;
+  /* shared memory listener on the same port number, for clients on this host */
+  std::unique_ptr<component::IFabric>                _local_fabric;
+  std::unique_ptr<component::IFabric_server_factory> _local_server_factory;
   unsigned                                           _port;
 };
 
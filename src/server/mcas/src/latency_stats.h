@@ -0,0 +1,128 @@
+/*
+  Copyright [2020] [IBM Corporation]
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+  http://www.apache.org/licenses/LICENSE-2.0
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef __MCAS_LATENCY_STATS_H__
+#define __MCAS_LATENCY_STATS_H__
+
+#include <common/cycles.h>
+#include <common/log_histogram.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "protocol.h"
+
+namespace mcas
+{
+/**
+ * Per-shard latency histograms, in TSC cycles, for each class of operation
+ * and each phase of its handling. Used only by the shard thread.
+ */
+class Latency_stats {
+ public:
+  static constexpr unsigned SUB_BITS = 3;
+  static constexpr unsigned MAX_BITS = 40; /* about five minutes at 3GHz */
+  using histogram_t                  = common::Log_histogram<SUB_BITS, MAX_BITS>;
+
+  Latency_stats() : _h{}, _tsc_mhz(double(common::get_rdtsc_frequency_mhz())) {}
+
+  inline void record(protocol::STATS_OP op, protocol::STATS_PHASE phase, std::uint64_t cycles)
+  {
+    _h[op][phase].record(cycles);
+  }
+
+  void reset()
+  {
+    for (auto &op : _h)
+      for (auto &h : op) h.reset();
+  }
+
+  static protocol::STATS_OP classify(const protocol::Message *msg)
+  {
+    using namespace protocol;
+    switch (msg->type_id()) {
+    case MSG_TYPE_IO_REQUEST:
+      switch (msg->op()) {
+      case OP_PUT:
+        return STATS_OP_PUT;
+      case OP_GET:
+        return STATS_OP_GET;
+      case OP_PUT_LOCATE:
+      case OP_PUT_RELEASE:
+        return STATS_OP_PUT_DIRECT;
+      case OP_GET_LOCATE:
+      case OP_GET_RELEASE:
+        return STATS_OP_GET_DIRECT;
+      case OP_ERASE:
+        return STATS_OP_ERASE;
+      default:
+        return STATS_OP_IO_OTHER;
+      }
+    case MSG_TYPE_ADO_REQUEST:
+    case MSG_TYPE_PUT_ADO_REQUEST:
+      return STATS_OP_ADO;
+    case MSG_TYPE_POOL_REQUEST:
+      return STATS_OP_POOL;
+    default:
+      return STATS_OP_INFO;
+    }
+  }
+
+  /**
+   * Append the version 1 extension to a stats response
+   *
+   * @return false if the buffer is too small
+   */
+  bool append_to(protocol::Message_stats *msg, std::size_t buffer_size) const
+  {
+    using namespace protocol;
+    Message_stats::latency_header hdr{};
+    hdr.version  = STATS_VERSION_LATENCY;
+    hdr.sub_bits = SUB_BITS;
+    hdr.max_bits = MAX_BITS;
+    hdr.tsc_mhz  = _tsc_mhz;
+    for (const auto &op : _h)
+      for (const auto &h : op) hdr.record_count = std::uint16_t(hdr.record_count + (h.total() != 0));
+    if (!msg->append(buffer_size, &hdr, sizeof hdr)) return false;
+
+    for (unsigned op = 0; op != STATS_OP_COUNT; ++op) {
+      for (unsigned phase = 0; phase != STATS_PHASE_COUNT; ++phase) {
+        const auto &h = _h[op][phase];
+        if (h.total() == 0) continue;
+        Message_stats::latency_record rec{};
+        rec.op         = std::uint8_t(op);
+        rec.phase      = std::uint8_t(phase);
+        rec.count      = h.total();
+        rec.sum_cycles = h.sum();
+        for (unsigned i = 0; i != histogram_t::bucket_count; ++i) rec.bucket_count = std::uint16_t(rec.bucket_count + (h.count(i) != 0));
+        if (!msg->append(buffer_size, &rec, sizeof rec)) return false;
+        for (unsigned i = 0; i != histogram_t::bucket_count; ++i) {
+          if (h.count(i) == 0) continue;
+          Message_stats::latency_bucket b{};
+          b.index = std::uint16_t(i);
+          b.count = h.count(i);
+          if (!msg->append(buffer_size, &b, sizeof b)) return false;
+        }
+      }
+    }
+    return true;
+  }
+
+ private:
+  std::array<std::array<histogram_t, protocol::STATS_PHASE_COUNT>, protocol::STATS_OP_COUNT> _h;
+  double                                                                                    _tsc_mhz;
+};
+}  // namespace mcas
+
+#endif
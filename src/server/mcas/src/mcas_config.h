@@ -15,7 +15,8 @@
 
 #include <cstddef> /* size_t */
 
-/* NUM_SHARD_BUFFERS: number of buffers per connection */
+/* NUM_SHARD_BUFFERS: limit on buffers allocated at once per connection;
+   buffers are allocated on demand */
 static constexpr std::size_t NUM_SHARD_BUFFERS = 128;
 
 /* WORK_REQUEST_ALLOCATOR_COUNT: number of work request slots for ADO
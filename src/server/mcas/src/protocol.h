@@ -56,6 +56,7 @@ enum MSG_TYPE : uint8_t {
   MSG_TYPE_ADO_REQUEST     = 0x40,
   MSG_TYPE_ADO_RESPONSE    = 0x41,
   MSG_TYPE_PUT_ADO_REQUEST = 0x42,
+  MSG_TYPE_BODY_REF        = 0x50,
 };
 
 template <typename T>
@@ -73,6 +74,52 @@ enum INFO_TYPE : uint32_t {
   INFO_TYPE_GET_STATS = 0xF1,
 };
 
+/* INFO_TYPE_GET_STATS: the request offset selects the response version.
+ * Version 0 is Message_stats alone. From version 1, latency histograms
+ * follow it. A server which predates versions ignores the offset and sends
+ * version 0.
+ */
+enum : uint64_t {
+  STATS_VERSION_BASE    = 0,
+  STATS_VERSION_LATENCY = 1,
+  STATS_VERSION_MASK    = 0xFFFFFFFF,
+  STATS_FLAG_RESET      = 1ULL << 32, /* clear the latency histograms after reading */
+};
+
+/* latency histogram classes of operation, and phases of handling */
+enum STATS_OP : uint8_t {
+  STATS_OP_PUT,
+  STATS_OP_GET,
+  STATS_OP_PUT_DIRECT,
+  STATS_OP_GET_DIRECT,
+  STATS_OP_ERASE,
+  STATS_OP_IO_OTHER,
+  STATS_OP_ADO,
+  STATS_OP_POOL,
+  STATS_OP_INFO,
+  STATS_OP_COUNT,
+};
+
+enum STATS_PHASE : uint8_t {
+  STATS_PHASE_QUEUE, /* receipt to start of handling */
+  STATS_PHASE_STORE, /* handling, less response posting */
+  STATS_PHASE_POST,  /* posting the response */
+  STATS_PHASE_COUNT,
+};
+
+inline const char* stats_op_name(unsigned op)
+{
+  static const char* const names[STATS_OP_COUNT] = {"put", "get", "put_direct", "get_direct", "erase",
+                                                    "io_other", "ado", "pool", "info"};
+  return op < STATS_OP_COUNT ? names[op] : "unknown";
+}
+
+inline const char* stats_phase_name(unsigned phase)
+{
+  static const char* const names[STATS_PHASE_COUNT] = {"queue", "store", "post"};
+  return phase < STATS_PHASE_COUNT ? names[phase] : "unknown";
+}
+
 enum {
   PROTOCOL_V1 = 0x1, /*< Key-Value Store */
   PROTOCOL_V2 = 0x2, /*< Memory-Centric Active Storage */
@@ -80,8 +127,9 @@ enum {
 
 /* _resvd flags */
 enum {
-  MSG_RESVD_SCBE   = 0x2, /* indicates short-circuit function (testing only) */
-  MSG_RESVD_DIRECT = 0x4, /* indicate get_direct from client side */
+  MSG_RESVD_SCBE     = 0x2, /* indicates short-circuit function (testing only) */
+  MSG_RESVD_DIRECT   = 0x4, /* indicate get_direct from client side */
+  MSG_RESVD_BODY_REF = 0x8, /* handshake: long messages go by reference (see Message_body_ref) */
 };
 
 enum OP_TYPE : uint8_t {
@@ -109,6 +157,10 @@ enum OP_TYPE : uint8_t {
   OP_LOCATE      = 19,  // locate space for DMA access
   OP_RELEASE     = 20,  // release space located for DMA access
   OP_RELEASE_WITH_FLUSH = 21,  // flush and release space located for DMA access
+  OP_MULTI_GET   = 22,  // get many small values in one message
+  OP_MULTI_PUT   = 23,  // put many small key/value pairs in one message
+  OP_MULTI_ERASE = 24,  // erase many keys in one message
+  OP_SCAN        = 25,  // list keys (and optionally values) matching an expression
   OP_INVALID     = 0xFE, // not applicable
 };
 
@@ -128,6 +180,30 @@ enum IO_TYPE : uint8_t {
 };
 #endif
 
+/* Framing for the records carried by OP_MULTI_GET/OP_MULTI_PUT/OP_MULTI_ERASE.
+ * Request records are [batch_element][key][value] (value empty except for
+ * MULTI_PUT). Response records are [batch_element][value], where the
+ * element carries the per-key status in place of the key length.
+ */
+struct batch_element {
+  union {
+    uint32_t key_len; /* request */
+    int32_t  status;  /* response */
+  };
+  uint32_t val_len;
+} __attribute__((packed));
+
+/* OP_SCAN request flags */
+enum : uint32_t {
+  SCAN_FLAG_VALUES = 0x1, /* return values with keys */
+};
+
+/* OP_SCAN response records are [batch_element][key][value]. A value which
+ * was not returned inline (too large, or locked) is marked with val_len
+ * SCAN_VALUE_DEFERRED and no value bytes; the client fetches it separately.
+ */
+static constexpr uint32_t SCAN_VALUE_DEFERRED = std::numeric_limits<uint32_t>::max();
+
 /* Base for all messages */
 class Message {
   uint64_t _auth_id;  // authorization token
@@ -165,6 +241,8 @@ class Message {
 
   void add_scbe() { _resvd |= MSG_RESVD_SCBE; }
 
+  void set_body_by_reference() { _resvd |= MSG_RESVD_BODY_REF; }
+
   void set_direct()
   {
     /* indicate that this is a direct request */
@@ -190,6 +268,8 @@ class Message {
 
   bool is_direct() const { return bool(_resvd & MSG_RESVD_DIRECT); }
 
+  bool is_body_by_reference() const { return bool(_resvd & MSG_RESVD_BODY_REF); }
+
   /* Convert the response to the expected type after verifying that the
      type_id field matches what is expected.
    */
@@ -423,6 +503,26 @@ struct Message_IO_request : public Message_numbered_request {
   {
   }
 
+  /* For OP_MULTI_GET/OP_MULTI_PUT/OP_MULTI_ERASE. Records are added with
+   * append_batch_element. Borrow _key_len field to store the record count,
+   * and _val_len field to store the length of the records
+   */
+  Message_IO_request(size_t   // buffer_size
+                     ,
+                     uint64_t auth_id,
+                     uint64_t request_id_,
+                     uint64_t pool_id_,
+                     OP_TYPE  op_,
+                     uint32_t flags_)
+      : Message_numbered_request(auth_id, (sizeof *this), id, op_, request_id_, pool_id_),
+        _key_len(),
+        _val_len(),
+        addr(),
+        _flags(flags_),
+        _padding()
+  {
+  }
+
   Message_IO_request(size_t             buffer_size,
                      uint64_t           auth_id,
                      uint64_t           request_id,
@@ -552,6 +652,39 @@ struct Message_IO_request : public Message_numbered_request {
     return needed <= buffer_size - sizeof(Message_IO_request);
   }
 
+  /* OP_MULTI_xxx: add a record, returns false if the buffer has no room for it */
+  bool append_batch_element(const size_t buffer_size,
+                            const void*  p_key,
+                            const size_t p_key_len,
+                            const void*  p_value,
+                            const size_t p_value_len)
+  {
+    const auto needed = sizeof(batch_element) + p_key_len + p_value_len;
+    if (msg_len() + needed > buffer_size) return false;
+
+    auto p = &data()[_val_len];
+    batch_element e;
+    e.key_len = boost::numeric_cast<uint32_t>(p_key_len);
+    e.val_len = boost::numeric_cast<uint32_t>(p_value_len);
+    std::memcpy(p, &e, sizeof e);
+    std::memcpy(p + sizeof e, p_key, p_key_len);
+    if (p_value_len) std::memcpy(p + sizeof e + p_key_len, p_value, p_value_len);
+
+    ++_key_len;
+    _val_len += needed;
+    increase_msg_len(needed);
+    return true;
+  }
+
+  /* OP_SCAN: maximum number of keys to return (0 for no limit) */
+  void set_scan_limit(uint64_t max_keys) { addr = max_keys; }
+  auto scan_limit() const { return addr; }
+
+  /* OP_MULTI_xxx: number of records, and the records themselves */
+  auto batch_count() const { return _key_len; }
+  auto batch_data_len() const { return _val_len; }
+  const uint8_t* batch_data() const { return data(); }
+
   auto key_len() const { return _key_len; }
   auto flags() const { return _flags; }
 
@@ -561,7 +694,7 @@ struct Message_IO_request : public Message_numbered_request {
   uint64_t _val_len;
 
  public:
-  uint64_t addr; /* PUT_RELEASE only */
+  uint64_t addr; /* PUT_RELEASE, and key limit for SCAN */
  private:
   uint32_t _flags;
   uint32_t _padding;
@@ -615,6 +748,22 @@ class Message_IO_response : public Message_numbered_response {
     _data_len = len;
   }
 
+  /* For data copied in place by the caller (e.g. by IKVStore::get_optimistic):
+   * the data area, then the length copied into it
+   */
+  void* data_for_copy_in()
+  {
+    assert(!is_set_twostage_bit());
+    return data();
+  }
+
+  void set_data_copied_in(size_t len)
+  {
+    assert(!is_set_twostage_bit());
+    _data_len = len;
+    increase_msg_len(_data_len);
+  }
+
   size_t base_message_size() const { return (sizeof *this); }
 
   void set_twostage_bit() { _data_len |= BIT_TWOSTAGE; }
@@ -628,12 +777,79 @@ class Message_IO_response : public Message_numbered_response {
     return data_length() / sizeof(locate_element);
   }
 
+  /* OP_MULTI_xxx: add a result record, returns false if the buffer has no room for it */
+  bool append_batch_element(const size_t buffer_size, const status_t status, const void* value, const size_t value_len)
+  {
+    assert(!is_set_twostage_bit());
+    const auto needed = sizeof(batch_element) + value_len;
+    if (msg_len() + needed > buffer_size) return false;
+
+    auto p = &data()[_data_len];
+    batch_element e;
+    e.status  = status;
+    e.val_len = boost::numeric_cast<uint32_t>(value_len);
+    std::memcpy(p, &e, sizeof e);
+    if (value_len) std::memcpy(p + sizeof e, value, value_len);
+
+    ++key;
+    _data_len += needed;
+    increase_msg_len(needed);
+    return true;
+  }
+
+  /* OP_SCAN: add a key record, returns false if the buffer does not have room
+   * for it and for cursor_reserve further bytes. value_len SCAN_VALUE_DEFERRED
+   * adds the key alone, marked for a separate fetch.
+   */
+  bool append_scan_element(const size_t buffer_size,
+                           const void*  p_key,
+                           const size_t p_key_len,
+                           const void*  value,
+                           const size_t value_len,
+                           const size_t cursor_reserve)
+  {
+    assert(!is_set_twostage_bit());
+    const auto copy_len = value_len == SCAN_VALUE_DEFERRED ? 0 : value_len;
+    const auto needed   = sizeof(batch_element) + p_key_len + copy_len;
+    if (msg_len() + needed + cursor_reserve > buffer_size) return false;
+
+    auto p = &data()[_data_len];
+    batch_element e;
+    e.key_len = boost::numeric_cast<uint32_t>(p_key_len);
+    e.val_len = boost::numeric_cast<uint32_t>(value_len);
+    std::memcpy(p, &e, sizeof e);
+    std::memcpy(p + sizeof e, p_key, p_key_len);
+    if (copy_len) std::memcpy(p + sizeof e + p_key_len, value, copy_len);
+
+    ++key;
+    _data_len += needed;
+    increase_msg_len(needed);
+    return true;
+  }
+
+  /* OP_SCAN: the resume cursor follows the records; its length is in addr */
+  void set_scan_cursor(const std::string& cursor)
+  {
+    assert(!is_set_twostage_bit());
+    std::memcpy(&data()[_data_len], cursor.data(), cursor.size());
+    _data_len += cursor.size();
+    addr = cursor.size();
+    increase_msg_len(cursor.size());
+  }
+
+  std::string scan_cursor() const { return std::string(cdata() + data_length() - addr, addr); }
+
+  /* OP_MULTI_xxx: number of request records processed. May be fewer than
+   * requested if the response buffer filled; the client resends the rest.
+   */
+  auto batch_count() const { return key; }
+
   // fields
  public:
   uint64_t _data_len; /* bit 63 is twostage flag */
  public:
-  uint64_t addr; /* for PUT_LOCATE/GET_LOCATE response */
-  uint64_t key;  /* for PUT_LOCATE/GET_LOCATE/LOCATE response */
+  uint64_t addr; /* for PUT_LOCATE/GET_LOCATE response, cursor length for SCAN */
+  uint64_t key;  /* for PUT_LOCATE/GET_LOCATE/LOCATE response, record count for MULTI_xxx and SCAN */
   /* data immediately follows */
 } __attribute__((packed));
 
@@ -824,11 +1040,39 @@ struct Message_handshake_reply : public Message {
   // fields
   uint64_t seq;
   uint64_t session_id;
-  size_t   max_message_size; /* RDMA max message size in bytes */
+  size_t   max_message_size; /* RDMA max message size in bytes; with MSG_RESVD_BODY_REF, the inline limit */
   uint32_t x509_cert_len;
   /* x509_cert innediately follows */
 } __attribute__((packed));
 
+////////////////////////////////////////////////////////////////////////
+// BODY REFERENCE
+
+/* A server which sets MSG_RESVD_BODY_REF in its handshake reply (in answer
+ * to a client which set it in the handshake) receives messages inline only
+ * up to the reply's max_message_size. The client sends a longer message as
+ * this reference to the registered buffer which holds it; the server reads
+ * the message from there, then handles it as though it had been received.
+ * The buffer must stay unchanged until the response to the message arrives.
+ */
+struct Message_body_ref : public Message {
+  static constexpr auto        id          = MSG_TYPE_BODY_REF;
+  static constexpr const char* description = "Message_body_ref";
+
+  Message_body_ref(uint64_t auth_id, uint64_t addr_, uint64_t key_, uint64_t len_)
+      : Message(auth_id, (sizeof *this), id, OP_INVALID),
+        addr(addr_),
+        key(key_),
+        len(len_)
+  {
+  }
+
+  // fields
+  uint64_t addr; /* of the message, in the client */
+  uint64_t key;  /* remote key of the buffer */
+  uint64_t len;  /* of the message */
+} __attribute__((packed));
+
 ////////////////////////////////////////////////////////////////////////
 // CLOSE SESSION
 
@@ -853,7 +1097,50 @@ struct Message_stats : public Message {
   {
   }
 
-  size_t message_size() const { return sizeof(Message_stats); }
+  size_t message_size() const { return msg_len(); }
+
+  /* Version 1 extension: a latency header, then for each histogram a
+   * latency record followed by its non-empty buckets. Bucket indexes are
+   * those of common::Log_histogram<sub_bits, max_bits> over TSC cycles.
+   */
+  struct latency_header {
+    uint32_t version;
+    uint16_t record_count;
+    uint8_t  sub_bits;
+    uint8_t  max_bits;
+    double   tsc_mhz;
+  } __attribute__((packed));
+
+  struct latency_record {
+    uint8_t  op;    /* STATS_OP */
+    uint8_t  phase; /* STATS_PHASE */
+    uint16_t bucket_count;
+    uint64_t count;
+    uint64_t sum_cycles;
+  } __attribute__((packed));
+
+  struct latency_bucket {
+    uint16_t index;
+    uint64_t count;
+  } __attribute__((packed));
+
+  /* append len bytes; returns false if the buffer has no room for them */
+  bool append(const size_t buffer_size, const void* p, const size_t len)
+  {
+    if (msg_len() + len > buffer_size) return false;
+    std::memcpy(reinterpret_cast<char*>(this) + msg_len(), p, len);
+    increase_msg_len(len);
+    return true;
+  }
+
+  /* the extension, or nullptr if the response is version 0 */
+  const latency_header* latency() const
+  {
+    return msg_len() < sizeof *this + sizeof(latency_header)
+      ? nullptr
+      : static_cast<const latency_header*>(static_cast<const void*>(this + 1));
+  }
+
   // fields
   /* TROUBLE: the stats are not packed */
   component::IMCAS::Shard_stats stats;
@@ -1105,6 +1392,7 @@ struct Message_ado_response : public Message_numbered_response {
 
 static_assert(sizeof(Message_IO_request) % 8 == 0, "Message_IO_request should be 64bit aligned");
 static_assert(sizeof(Message_IO_response) % 8 == 0, "Message_IO_request should be 64bit aligned");
+static_assert(sizeof(batch_element) == 8, "Unexpected batch_element data structure size");
 
 }  // namespace protocol
 namespace Protocol = protocol;
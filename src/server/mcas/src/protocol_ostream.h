@@ -40,6 +40,7 @@ static const std::map<mcas::protocol::MSG_TYPE, msg_attrs> type_map{
     {mcas::protocol::MSG_TYPE_ADO_REQUEST, {"ADO", msg_attrs::category::req}},
     {mcas::protocol::MSG_TYPE_ADO_RESPONSE, {"ADO", msg_attrs::category::rsp}},
     {mcas::protocol::MSG_TYPE_PUT_ADO_REQUEST, {"PUT_ADO", msg_attrs::category::req}},
+    {mcas::protocol::MSG_TYPE_BODY_REF, {"BODY_REF", msg_attrs::category::other}},
 };
 
 static const std::map<mcas::protocol::OP_TYPE, const char *> op_map{
@@ -66,6 +67,11 @@ static const std::map<mcas::protocol::OP_TYPE, const char *> op_map{
     {mcas::protocol::OP_GET_RELEASE, "GET_RELEASE"},
     {mcas::protocol::OP_LOCATE, "LOCATE"},
     {mcas::protocol::OP_RELEASE, "RELEASE"},
+    {mcas::protocol::OP_RELEASE_WITH_FLUSH, "RELEASE_WITH_FLUSH"},
+    {mcas::protocol::OP_MULTI_GET, "MULTI_GET"},
+    {mcas::protocol::OP_MULTI_PUT, "MULTI_PUT"},
+    {mcas::protocol::OP_MULTI_ERASE, "MULTI_ERASE"},
+    {mcas::protocol::OP_SCAN, "SCAN"},
     {mcas::protocol::OP_INVALID, "N/A"},
 };
 
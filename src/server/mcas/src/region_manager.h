@@ -18,7 +18,14 @@
 #include <common/utils.h>
 #include <gsl/pointers>
 
-#include <set>
+#include <sys/uio.h> /* iovec */
+
+#include <cstdint>
+#include <iterator> /* next */
+#include <map>
+#include <tuple> /* forward_as_tuple */
+#include <utility> /* piecewise_construct */
+#include <vector>
 
 #include "connection_handler.h"
 #include "memory_registered.h"
@@ -26,6 +33,12 @@
 
 namespace mcas
 {
+/*
+ * Registrations of pool regions, per connection. A pool's regions are
+ * registered once, when the connection opens or creates the pool, so that
+ * direct and two-stage requests for values within a region need not
+ * register memory of their own.
+ */
 class Region_manager : private common::log_source {
  public:
   Region_manager(unsigned debug_level_, gsl::not_null<Connection *> conn) : common::log_source(debug_level_), _conn(conn), _reg{}
@@ -40,24 +53,83 @@ class Region_manager : private common::log_source {
   }
 
   /**
-   * Register memory with network transport for direct IO.  Cache in map.
+   * Register pool regions with network transport for direct IO, unless
+   * already registered. Cache in map.
+   *
+   * @param pool Pool which owns the regions
+   * @param regions Pool regions, as reported by IKVStore::get_pool_regions
+   *
+   * @return Number of regions newly registered
+   */
+  unsigned register_pool_regions(std::uint64_t pool, const std::vector<::iovec> &regions)
+  {
+    unsigned count = 0;
+    for (const auto &r : regions) {
+      const auto base = static_cast<const char *>(r.iov_base);
+      auto       it   = _reg.find(base);
+      if (it == _reg.end() || it->second.len < r.iov_len) {
+        if (it != _reg.end()) {
+          _reg.erase(it);
+        }
+        _reg.emplace(std::piecewise_construct, std::forward_as_tuple(base),
+                     std::forward_as_tuple(pool, r.iov_len,
+                                           memory_registered<Connection>(debug_level(), _conn, base, r.iov_len, 0,
+                                                                         component::IFabric_connection::MR_FLAG_SHAREABLE)));
+        ++count;
+        CPLOG(2, "%s registered %p 0x%zx (total %zu)", __func__, r.iov_base, r.iov_len, _reg.size());
+      }
+    }
+    return count;
+  }
+
+  /**
+   * Release the registrations of a pool's regions
+   *
+   * @param pool Pool which owns the regions
+   */
+  void deregister_pool(std::uint64_t pool)
+  {
+    for (auto it = _reg.begin(); it != _reg.end();) {
+      it = it->second.pool == pool ? _reg.erase(it) : std::next(it);
+    }
+  }
+
+  /**
+   * Find a registered region which covers memory
    *
-   * @param target Pointer to start or region
-   * @param target_len Region length in bytes
+   * @param target Pointer to start of memory
+   * @param target_len Memory length in bytes
    *
-   * @return Memory region handle
+   * @return Memory region handle, or nullptr if no region covers the memory
    */
-  inline memory_region_t ondemand_register(const void* target, size_t target_len)
+  memory_region_t lookup_registered(const void *target, size_t target_len) const
   {
-    /* transport will now take care of repeat registrations */
-    auto it = _reg.emplace(debug_level(), _conn, target, target_len, 0, 0);
-    CPLOG(2, "%s registered %p 0x%zx (total %zu)", __func__, target, target_len, _reg.size());
-    return it->mr();
+    const auto p  = static_cast<const char *>(target);
+    auto       it = _reg.upper_bound(p);
+    if (it != _reg.begin()) {
+      --it;
+      if (p + target_len <= it->first + it->second.len) {
+        return it->second.mr.mr();
+      }
+    }
+    return nullptr;
   }
 
  private:
-  Connection*                    _conn;
-  std::multiset<memory_registered<Connection>> _reg;
+  struct region_t {
+    std::uint64_t                 pool;
+    std::size_t                   len;
+    memory_registered<Connection> mr;
+    region_t(std::uint64_t pool_, std::size_t len_, memory_registered<Connection> &&mr_)
+        : pool(pool_),
+          len(len_),
+          mr(std::move(mr_))
+    {
+    }
+  };
+
+  Connection*                      _conn;
+  std::map<const char *, region_t> _reg; /* by region base */
 };
 }  // namespace mcas
 
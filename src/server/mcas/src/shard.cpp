@@ -16,6 +16,7 @@
 #include <api/components.h>
 #include <api/kvindex_itf.h>
 #include <common/dump_utils.h>
+#include <common/key_matcher.h>
 #include <common/profiler.h>
 #include <common/utils.h>
 #include <common/str_utils.h>
@@ -42,7 +43,9 @@ void ProfilerStop() {}
 void ProfilerFlush() {}
 #endif
 
+#include <sys/eventfd.h>
 #include <sys/types.h> /* getpid */
+#include <poll.h>
 #include <unistd.h>
 
 #include <algorithm> /* remove */
@@ -50,6 +53,7 @@ void ProfilerFlush() {}
 #include <cstdlib> /* system */
 
 #include <limits>
+#include <regex>
 #include <sstream>
 
 volatile sig_atomic_t signals::sigint = 0;
@@ -106,6 +110,41 @@ public:
       return _lock_handle;
     }
   };
+
+  /* IKVStore::ioctl commands of group commit (constructed once: called every loop) */
+  const std::string persist_group_open("persist_group_open");
+  const std::string persist_group_commit("persist_group_commit");
+
+  /* A persistence group of the calling thread, if given a store: opened
+   * by the ctor, committed by commit or, if an exception intervenes, when
+   * the object goes out of scope, so that the group depth is not left open
+   */
+  struct persist_group
+  {
+    common::moveable_ptr<component::IKVStore> _store;
+    explicit persist_group(component::IKVStore *store_)
+      : _store(store_)
+    {
+      if ( _store )
+      {
+        _store->ioctl(persist_group_open);
+      }
+    }
+    persist_group(const persist_group &) = delete;
+    persist_group &operator=(const persist_group &) = delete;
+    ~persist_group()
+    {
+      commit();
+    }
+    void commit()
+    {
+      if ( _store )
+      {
+        _store->ioctl(persist_group_commit);
+        _store.release();
+      }
+    }
+  };
 }  // namespace
 
 namespace mcas
@@ -132,9 +171,12 @@ Shard::Shard(const Config_file &config_file,
                     /* libfabric calls this "info::domain::name", and also (as a separate
                        parameter) "node" */
                     config_file.get_shard_optional(config::net, shard_index),
-                    config_file.get_shard_port(shard_index)),
+                    config_file.get_shard_port(shard_index),
+                    config_file.get_shard_local_clients(shard_index),
+                    config_file.get_shard_local_share_regions(shard_index)),
     common::log_source(debug_level_),
     _stats{},
+    _latency{},
     _wr_allocator{},
     _net_addr(config_file.get_shard_optional(config::addr, shard_index)
               ? *config_file.get_shard_optional(config::addr, shard_index)
@@ -144,6 +186,14 @@ Shard::Shard(const Config_file &config_file,
     _thread_exit(false),
     _forced_exit(forced_exit),
     _core(config_file.get_shard_core(shard_index)),
+    _batch_budget(config_file.get_shard_batch_budget(shard_index)),
+    _worker_threads(config_file.get_shard_worker_threads(shard_index)),
+    _group_commit(config_file.get_shard_group_commit(shard_index)),
+    _tsc_mhz(double(common::get_rdtsc_frequency_mhz())),
+    _idle_spin_cycles(config_file.get_shard_idle_spin_usec(shard_index)
+                      ? std::max(cpu_time_t(1), cpu_time_t(*config_file.get_shard_idle_spin_usec(shard_index) * _tsc_mhz))
+                      : 0),
+    _wakeup(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
     _max_message_size(0),
     _i_kvstore(nullptr),
     _i_ado_mgr(nullptr),
@@ -160,9 +210,13 @@ Shard::Shard(const Config_file &config_file,
     _ado_path(config_file.get_ado_path() ? *config_file.get_ado_path() : ""),
     _ado_plugins(config_file.get_shard_ado_plugins(shard_index)),
     _ado_params(config_file.get_shard_ado_params(shard_index)),
+    _ado_in_process(config_file.get_shard_ado_in_process(shard_index)),
     _security(config_file.get_cert_path()),
     _cluster_signal_queue(),
     _backend(config_file.get_shard_required(config::default_backend, shard_index)),
+    _workers(nullptr),
+    _offloaded{},
+    _free_jobs{},
     _thread(std::async(std::launch::async,
                        &Shard::thread_entry,
                        this,
@@ -248,6 +302,8 @@ void Shard::initialize_components(const std::string &backend,
       comp = load_component("libcomponent-hstore.so", hstore_factory);
     else if (backend == "hstore-cc")
       comp = load_component("libcomponent-hstore-cc.so", hstore_factory);
+    else if (backend == "hstore-mt")
+      comp = load_component("libcomponent-hstore-mt.so", hstore_factory);
     else
       throw General_exception("unrecognized backend (%s)", backend.c_str());
 
@@ -258,7 +314,7 @@ void Shard::initialize_components(const std::string &backend,
     auto fact = make_itf_ref(static_cast<IKVStore_factory *>(comp->query_interface(IKVStore_factory::iid())));
     assert(fact);
 
-    if (backend == "hstore" || backend == "hstore-cc") {
+    if (backend == "hstore" || backend == "hstore-cc" || backend == "hstore-mt") {
       if (dax_config.empty()) throw General_exception("hstore backend requires dax configuration");
 
       _i_kvstore.reset(
@@ -276,8 +332,35 @@ void Shard::initialize_components(const std::string &backend,
     }
   }
 
-  /* optional ADO components */
-  {
+  /* optional worker pool */
+  if (_worker_threads) {
+    if (_i_kvstore->thread_safety() == IKVStore::THREAD_MODEL_MULTI_PER_POOL) {
+      std::ostringstream ss;
+      ss << "shard-" << _core;
+      _workers.reset(new Shard_worker_pool(debug_level(), _worker_threads, ss.str()));
+      PMAJOR("Shard: %u worker threads executing requests", _worker_threads);
+    }
+    else {
+      PWRN("Shard: backend (%s) is not thread safe; ignoring worker_threads", backend.c_str());
+    }
+  }
+
+  /* optional group commit: probe for backend support */
+  if (_group_commit) {
+    if (_i_kvstore->ioctl(persist_group_open) == S_OK && _i_kvstore->ioctl(persist_group_commit) == S_OK) {
+      PMAJOR("Shard: group commit of persistence");
+    }
+    else {
+      PWRN("Shard: backend (%s) does not support group commit; ignoring group_commit", backend.c_str());
+      _group_commit = false;
+    }
+  }
+
+  /* optional ADO components; in-process plugins need no ADO manager */
+  if (_ado_in_process) {
+    if (!_ado_plugins.empty()) PMAJOR("ADO plugins will run in the shard process.");
+  }
+  else {
 #if 0
     /* check XPMEM kernel module */
     if (!check_mcas_module()) {
@@ -329,6 +412,59 @@ void Shard::service_cluster_signals()
   }
 }
 
+void Shard::wakeup()
+{
+  const std::uint64_t one = 1;
+  auto sz = ::write(_wakeup.fd(), &one, sizeof one);
+  (void) sz;
+}
+
+bool Shard::wait_for_work(std::chrono::milliseconds timeout, bool &client_ready, bool &listener_ready)
+{
+  std::vector<int> fds;
+  for (const auto handler : _handlers) {
+    if (!handler->arm_wait(fds)) return false;
+  }
+  const auto client_end = fds.size();
+  /* listeners and ADOs which cannot be waited on are polled on timeout */
+  arm_wait_listeners(fds);
+  const auto listener_end = fds.size();
+  /* ADOs signal only while armed, so that a spinning shard costs them nothing */
+  std::vector<component::IADO_proxy *> armed;
+  for (const auto &a : _ado_pool_map) {
+    const auto proxy = std::get<0>(a.second);
+    const auto fd    = proxy->wakeup_fd();
+    if (fd != -1) {
+      if (!proxy->arm_wakeup()) {
+        for (const auto p : armed) p->disarm_wakeup();
+        return false;
+      }
+      armed.push_back(proxy);
+      fds.push_back(fd);
+    }
+  }
+
+  std::vector<::pollfd> pfds;
+  pfds.reserve(fds.size() + 1);
+  pfds.push_back(::pollfd{_wakeup.fd(), POLLIN, 0});
+  for (const auto fd : fds) pfds.push_back(::pollfd{fd, POLLIN | POLLPRI, 0});
+
+  /* EINTR (e.g. SIGINT) simply ends the wait */
+  ::poll(pfds.data(), pfds.size(), int(timeout.count()));
+
+  if (pfds[0].revents) {
+    std::uint64_t count;
+    auto sz = ::read(_wakeup.fd(), &count, sizeof count);
+    (void) sz;
+  }
+  const auto ready = [](const ::pollfd &p) { return p.revents != 0; };
+  client_ready   = std::any_of(pfds.begin() + 1, pfds.begin() + 1 + long(client_end), ready);
+  listener_ready = std::any_of(pfds.begin() + 1 + long(client_end), pfds.begin() + 1 + long(listener_end), ready);
+  /* the messages which the ADO doorbells announce are taken next */
+  for (const auto p : armed) p->disarm_wakeup();
+  return true;
+}
+
 //#define DEBUG_LIVENESS // use this to show how live the shard loop threads are
 #define LIVENESS_DURATION 10000
 #define LIVENESS_SHARDS 18
@@ -345,7 +481,13 @@ void Shard::main_loop(common::profiler &pr_)
   static constexpr uint64_t CHECK_CONNECTION_INTERVAL     = 1000;
   static constexpr uint64_t CHECK_CLUSTER_SIGNAL_INTERVAL = 10000;
   static constexpr uint64_t OUTPUT_DEBUG_INTERVAL         = 10000000;
-  static constexpr unsigned SESSIONS_EMPTY_USLEEP         = 50000;
+  /* While blocked, disconnects (and, from a listener which cannot be waited
+   * on, new connections) are noticed on timeout. An ADO proxy which
+   * cannot signal the shard (IADO_proxy::wakeup_fd) is polled more often
+   * while there is ADO work.
+   */
+  static constexpr std::chrono::milliseconds IDLE_WAIT_TIMEOUT{50};
+  static constexpr std::chrono::milliseconds ADO_WAIT_TIMEOUT{1};
 
   Connection_handler::action_t action;
 
@@ -356,6 +498,9 @@ void Shard::main_loop(common::profiler &pr_)
 
   unsigned idle            = 0;
   uint64_t tick alignas(8) = 0;
+  cpu_time_t idle_start    = 0; /* when the shard last had work */
+  cpu_time_t woken_at      = 0; /* when a client ended the last block, until its message is handled */
+  bool       check_connections = false; /* a listener ended the last block */
 
   for (; _thread_exit == false; ++idle, ++tick) {
 
@@ -383,8 +528,9 @@ void Shard::main_loop(common::profiler &pr_)
       PLOG("Shard: received SIGINT");
       _thread_exit = true;
     }
-    else if (_handlers.empty()) { /* if there are no sessions, sleep thread */
-      usleep(SESSIONS_EMPTY_USLEEP);
+    else if (_handlers.empty()) { /* if there are no sessions, block until a connection may be waiting */
+      bool client_ready, listener_ready;
+      wait_for_work(IDLE_WAIT_TIMEOUT, client_ready, listener_ready);
       try {
         check_for_new_connections();
       }
@@ -396,8 +542,38 @@ void Shard::main_loop(common::profiler &pr_)
       continue;
     }
 
+    /* Adaptive polling: having found no work for the spin budget, block
+     * until a client message arrives. Offloaded requests and tasks are
+     * short, and are polled for.
+     */
+    if (_idle_spin_cycles != 0) {
+      if (idle == 1) {
+        idle_start = rdtsc();
+      }
+      else if (_idle_spin_cycles <= rdtsc() - idle_start && _tasks.empty() &&
+               std::all_of(_offloaded.begin(), _offloaded.end(), [](const decltype(_offloaded)::value_type &o) { return o.second.jobs.empty(); })) {
+        const auto start          = rdtsc();
+        bool       client_ready   = false;
+        bool       listener_ready = false;
+        const bool ado_polled =
+            !_outstanding_work.empty() && std::any_of(_ado_pool_map.begin(), _ado_pool_map.end(), [](const auto &a) {
+              return std::get<0>(a.second)->wakeup_fd() == -1;
+            });
+        woken_at = 0;
+        if (wait_for_work(ado_polled ? ADO_WAIT_TIMEOUT : IDLE_WAIT_TIMEOUT, client_ready, listener_ready)) {
+          const auto end = rdtsc();
+          ++_stats.idle_block_count;
+          _stats.idle_block_usec += uint64_t(double(end - start) / _tsc_mhz);
+          if (client_ready) woken_at = end;
+          check_connections = listener_ready;
+        }
+        idle = 0;
+      }
+    }
+
     /* check for new connections or sleep on none */
-    if (tick % CHECK_CONNECTION_INTERVAL == 0) {
+    if (check_connections || tick % CHECK_CONNECTION_INTERVAL == 0) {
+      check_connections = false;
       try {
         check_for_new_connections();
       }
@@ -425,6 +601,16 @@ void Shard::main_loop(common::profiler &pr_)
 
       assert(_handlers.size() < 1000);
 
+      uint64_t tick_msgs = 0;
+
+      /* In group commit mode, stores made while handling the batch are left
+       * to one persistence fence, and responses are held until it is done.
+       */
+      persist_group group(_group_commit ? _i_kvstore.get() : nullptr);
+      if (_group_commit) {
+        for (const auto handler : _handlers) handler->hold_sends();
+      }
+
       /* iterate connection handlers (each connection is a client session) */
       for (const auto handler : _handlers) {
 
@@ -437,6 +623,9 @@ void Shard::main_loop(common::profiler &pr_)
             (signals::sigint > 0)) {
           idle = 0;
 
+          /* requests still executing may refer to the pools and buffers */
+          complete_offloaded(handler, false);
+
           /* close all open pools belonging to session  */
           CPLOG(1, "Shard: forcing pool closures");
 
@@ -503,11 +692,38 @@ void Shard::main_loop(common::profiler &pr_)
          */
         try {
 
-          /* collect ONE available messages ; don't collect them ALL, they just keep coming! */
-          if (const protocol::Message *p_msg = handler->peek_pending_msg()) {
+          /* collect up to _batch_budget available messages ; don't collect them ALL, they just keep coming!
+           * Handlers are visited in turn, so no client is starved by another's pipeline.
+           */
+          unsigned handled = 0;
+          /* responses to offloaded requests are posted in request order */
+          bool in_flight = _workers && !complete_offloaded(handler, true);
+          for (const protocol::Message *p_msg; handled != _batch_budget && (p_msg = handler->peek_pending_msg()) != nullptr; ++handled) {
 
             idle = 0;
+            if (woken_at) {
+              const auto ns = uint64_t(double(rdtsc() - woken_at) * 1000.0 / _tsc_mhz);
+              ++_stats.wake_latency_count;
+              _stats.wake_latency_ns_total += ns;
+              _stats.wake_latency_ns_max = std::max(_stats.wake_latency_ns_max, ns);
+              woken_at = 0;
+            }
             assert(p_msg);
+            if (_workers && is_offloadable(p_msg)) {
+              if (_offloaded[handler].jobs.size() == MAX_OFFLOADED_PER_CONNECTION) break;
+              offload_io_request(handler);
+              in_flight = true;
+              ++tick_msgs;
+              continue;
+            }
+            /* other requests may not overtake those still with the workers */
+            if (in_flight) break;
+
+            const auto op    = Latency_stats::classify(p_msg);
+            const auto start = rdtsc();
+            const auto queue = start - handler->pending_msg_stamp();
+            handler->take_post_cycles();
+
             switch (p_msg->type_id()) {
             case MSG_TYPE_IO_REQUEST:
               process_message_IO_request(handler, static_cast<const protocol::Message_IO_request *>(p_msg));
@@ -527,7 +743,20 @@ void Shard::main_loop(common::profiler &pr_)
             default:
               throw General_exception("unrecognizable message type");
             }
+            {
+              const auto post  = handler->take_post_cycles();
+              const auto store = rdtsc() - start;
+              _latency.record(op, protocol::STATS_PHASE_QUEUE, queue);
+              _latency.record(op, protocol::STATS_PHASE_STORE, store > post ? store - post : 0);
+              /* ADO and some pool requests respond later, or not at all */
+              if (post) _latency.record(op, protocol::STATS_PHASE_POST, post);
+            }
             handler->free_buffer(handler->pop_pending_msg());
+            ++tick_msgs;
+          }
+
+          if (handled == _batch_budget && handler->peek_pending_msg()) {
+            ++_stats.batch_budget_reached_count;
           }
         }
         catch (const resource_unavailable &e) {
@@ -539,6 +768,17 @@ void Shard::main_loop(common::profiler &pr_)
         }
       }  // iteration of handlers
 
+      if (_group_commit) {
+        group.commit();
+        for (const auto handler : _handlers) handler->release_sends();
+      }
+
+      if (tick_msgs) {
+        ++_stats.busy_tick_count;
+        _stats.tick_msg_count += tick_msgs;
+        _stats.tick_msg_max = std::max(_stats.tick_msg_max, tick_msgs);
+      }
+
       /* handle messages send back from ADO */
       try {
         process_messages_from_ado();
@@ -563,6 +803,8 @@ void Shard::main_loop(common::profiler &pr_)
         CPLOG(1, "Deleting handler (%p)", static_cast<const void *>(h));
 
         assert(h);
+        complete_offloaded(h, false);
+        _offloaded.erase(h);
         delete h;
 
         CPLOG(1, "# remaining handlers (%lu)", _handlers.size());
@@ -575,6 +817,7 @@ void Shard::main_loop(common::profiler &pr_)
     }
   }
 
+  _workers.reset();
   close_all_ado();
 
   PLOG("Shard (%p) exited", static_cast<const void *>(this));
@@ -644,20 +887,11 @@ void Shard::process_message_pool_request(Connection_handler *handler, const prot
         }
 
         CPLOG(2, "OP_CREATE: new pool id: %lx", pool);
+      }
 
-        /* check for ability to pre-register memory with RDMA stack */
-        std::pair<std::string, std::vector<::iovec>> regions;
-        status_t             hr;
-        if ((hr = _i_kvstore->get_pool_regions(pool, regions)) == S_OK) {
-          for (auto &r : regions.second) {
-            CPLOG(1, "region: %p %lu MiB", r.iov_base, REDUCE_MB(r.iov_len));
-            /* pre-register memory region with RDMA */
-            handler->ondemand_register(r.iov_base, r.iov_len);
-          }
-        }
-        else {
-          PLOG("pool region query NOT supported, using on-demand");
-        }
+      /* pre-register pool memory with RDMA stack */
+      if (pool != IKVStore::POOL_ERROR && response->get_status() == S_OK) {
+        register_pool_regions(handler, pool);
       }
 
       if (pool && ado_enabled()) { /* if ADO is enabled start ADO process */
@@ -700,6 +934,11 @@ void Shard::process_message_pool_request(Connection_handler *handler, const prot
       }
       if (debug_level() > 1) PMAJOR("POOL OPEN: pool id: %lx", pool);
 
+      /* pre-register pool memory with RDMA stack */
+      if (pool != IKVStore::POOL_ERROR) {
+        register_pool_regions(handler, pool);
+      }
+
       if (pool != IKVStore::POOL_ERROR && ado_enabled()) { /* if ADO is enabled start ADO process */
         IADO_proxy *ado  = nullptr;
         pool_desc_t desc = {pool_name, msg->pool_size(), msg->flags(), msg->expected_object_count(), true};
@@ -717,6 +956,8 @@ void Shard::process_message_pool_request(Connection_handler *handler, const prot
         if (pool_mgr.release_pool_reference(msg->pool_id())) {
           CPLOG(1, "Shard: pool reference now zero. pool_id=%lx", msg->pool_id());
 
+          handler->deregister_pool(msg->pool_id());
+
           /* close ADO process on pool close */
           if (ado_enabled()) {
             {
@@ -757,6 +998,8 @@ void Shard::process_message_pool_request(Connection_handler *handler, const prot
             if (!pool_mgr.release_pool_reference(msg->pool_id()))
               throw Logic_exception("unexpected pool reference count");
 
+            handler->deregister_pool(msg->pool_id());
+
             /* notify ADO if needed */
             if (ado_enabled()) {
               auto ado_itf = get_ado_interface(msg->pool_id());
@@ -823,22 +1066,22 @@ void Shard::process_message_pool_request(Connection_handler *handler, const prot
   handler->post_response(response_iob, response, __func__);
 }
 
-void Shard::add_locked_value_shared(const pool_t                         pool_id,
-                                    component::IKVStore::key_t           key,
-                                    void *                               target,
-                                    size_t                               target_len,
-                                    memory_registered<Connection_base> &&mr)
+void Shard::add_locked_value_shared(const pool_t               pool_id,
+                                    component::IKVStore::key_t key,
+                                    void *                     target,
+                                    size_t                     target_len,
+                                    owned_mr_t &&              mr)
 {
   auto it = _locked_values_shared.emplace(std::piecewise_construct, std::forward_as_tuple(target),
                                           std::forward_as_tuple(pool_id, key, target_len, std::move(mr)));
   ++it.first->second.count;
 }
 
-void Shard::add_locked_value_exclusive(const pool_t                         pool_id,
-                                       component::IKVStore::key_t           key,
-                                       void *                               target,
-                                       size_t                               target_len,
-                                       memory_registered<Connection_base> &&mr)
+void Shard::add_locked_value_exclusive(const pool_t               pool_id,
+                                       component::IKVStore::key_t key,
+                                       void *                     target,
+                                       size_t                     target_len,
+                                       owned_mr_t &&              mr)
 {
   auto it = _locked_values_exclusive.emplace(std::piecewise_construct, std::forward_as_tuple(target),
                                              std::forward_as_tuple(pool_id, key, target_len, std::move(mr)));
@@ -875,7 +1118,7 @@ void Shard::release_locked_value_exclusive(const void *target)
   }
 }
 
-void Shard::add_space_shared(const range<std::uint64_t> &range_, memory_registered<Connection_base> &&mr_)
+void Shard::add_space_shared(const range<std::uint64_t> &range_, owned_mr_t &&mr_)
 {
   auto i = _spaces_shared
     .emplace(std::piecewise_construct, std::forward_as_tuple(range_), std::forward_as_tuple(std::move(mr_)))
@@ -903,6 +1146,49 @@ void Shard::release_space_shared(const range<std::uint64_t> &range_)
   }
 }
 
+unsigned Shard::register_pool_regions(Connection_handler *handler, const pool_t pool_id)
+{
+  std::pair<std::string, std::vector<::iovec>> regions;
+  if (_i_kvstore->get_pool_regions(pool_id, regions) != S_OK) {
+    CPLOG(1, "pool region query NOT supported, using on-demand");
+    return 0;
+  }
+
+  for (const auto &r : regions.second) {
+    CPLOG(1, "region: %p %lu MiB", r.iov_base, REDUCE_MB(r.iov_len));
+  }
+
+  try {
+    return handler->register_pool_regions(pool_id, regions.second);
+  }
+  catch (const std::exception &e) {
+    PLOG("%s failed: %s, using on-demand", __func__, e.what());
+    return 0;
+  }
+}
+
+auto Shard::register_memory(Connection_handler *handler,
+                            const pool_t        pool_id,
+                            const void *        target,
+                            size_t              target_len) -> registration_t
+{
+  auto mr = handler->lookup_registered(target, target_len);
+  /* a miss may be memory added to the pool since it was registered */
+  if (!mr && register_pool_regions(handler, pool_id) != 0) {
+    mr = handler->lookup_registered(target, target_len);
+  }
+
+  if (mr) {
+    ++_stats.mr_cache_hit_count;
+    return registration_t{nullptr, mr};
+  }
+
+  ++_stats.mr_cache_miss_count;
+  owned_mr_t owned(new memory_registered<Connection_base>(debug_level(), handler, target, target_len, 0, 0));
+  mr = owned->mr();
+  return registration_t{std::move(owned), mr};
+}
+
 /* note, target address is used because it is unique for the shard */
 void Shard::add_pending_rename(const pool_t pool_id, const void *target, const std::string &from, const std::string &to)
 {
@@ -986,6 +1272,33 @@ void Shard::release_pending_rename(const void *target)
 }
 
 /* like respond2, but omits the final post */
+std::size_t Shard::io_response_len(const protocol::Message_IO_request *msg)
+{
+  using bm_t = Buffer_manager<component::IFabric_server>;
+  static_assert(TWO_STAGE_THRESHOLD + sizeof(protocol::Message_IO_response) <= bm_t::class_length(bm_t::MEDIUM),
+                "a small GET value must fit a MEDIUM buffer");
+
+  switch (msg->op()) {
+  case protocol::OP_PUT:
+  case protocol::OP_ERASE:
+  case protocol::OP_PUT_LOCATE:
+  case protocol::OP_PUT_RELEASE:
+  case protocol::OP_GET_LOCATE:
+  case protocol::OP_GET_RELEASE:
+  case protocol::OP_RELEASE:
+  case protocol::OP_RELEASE_WITH_FLUSH:
+  case protocol::OP_CONFIGURE:
+    /* status and header fields only */
+    return sizeof(protocol::Message_IO_response);
+  case protocol::OP_GET:
+    /* a value below the two stage threshold is copied in */
+    return sizeof(protocol::Message_IO_response) + TWO_STAGE_THRESHOLD;
+  default:
+    /* multi-operations, scans and locates fill what they are given */
+    return bm_t::BUFFER_LEN;
+  }
+}
+
 auto Shard::respond1(
   const Connection_handler *handler_,
   buffer_t *iob_,
@@ -1011,6 +1324,38 @@ void Shard::respond2(
   handler_->post_response(iob_, response, func_);  // issue IO request response
 }
 
+/* A GET whose value fits the response, copied by IKVStore::get_optimistic:
+ * no key string, no lock and no unlock flush. Values which are too large,
+ * are being written, or are in a store without the operation are left to
+ * the locking path, with iob as it was.
+ */
+auto Shard::get_optimistic(
+  component::IKVStore *kvstore_,
+  const Connection_handler *handler_,
+  buffer_t *iob_,
+  const protocol::Message_IO_request *msg_) -> protocol::Message_IO_response *
+{
+  const auto buffer_len = iob_->length();
+  auto       response   = respond1(handler_, iob_, msg_, S_OK);
+  auto       value_len  = std::min(TWO_STAGE_THRESHOLD - 1, buffer_len - response->base_message_size());
+
+  const IKVStore::string_view key(reinterpret_cast<const char *>(msg_->key()), msg_->key_len());
+  auto rc = kvstore_->get_optimistic(msg_->pool_id(), key, response->data_for_copy_in(), value_len);
+  switch (rc) {
+  case S_OK:
+    response->set_data_copied_in(value_len);
+    iob_->set_length(response->msg_len());
+    return response;
+  case IKVStore::E_KEY_NOT_FOUND:
+  case IKVStore::E_POOL_NOT_FOUND:
+    response->set_status(rc);
+    return response;
+  default:
+    iob_->set_length(buffer_len);
+    return nullptr;
+  }
+}
+
 /////////////////////////////////////////////////////////////////////////////
 //   PUT ADVANCE   //
 /////////////////////
@@ -1067,11 +1412,11 @@ void Shard::io_response_put_advance(Connection_handler *handler, const protocol:
       std::uint64_t key = 0;
       try
       {
-        memory_registered<Connection_base> mr(debug_level(), handler, target, target_len, 0, 0);
-        key = mr.key();
+        auto r = register_memory(handler, pool_id, target, target_len);
+        key = handler->get_memory_remote_key(r.mr);
 
         /* register clean and rename tasks for value */
-        add_locked_value_exclusive(pool_id, lk.release(), target, target_len, std::move(mr));
+        add_locked_value_exclusive(pool_id, lk.release(), target, target_len, std::move(r.owned));
         add_pending_rename(pool_id, target, k, actual_key);
       }
       catch ( const std::exception &e )
@@ -1133,10 +1478,10 @@ void Shard::io_response_get_locate(Connection_handler *handler, const protocol::
     std::uint64_t key = 0;
     try
     {
-      memory_registered<Connection_base> mr(debug_level(), handler, target, target_len, 0, 0);
-      key = mr.key();
+      auto r = register_memory(handler, pool_id, target, target_len);
+      key = handler->get_memory_remote_key(r.mr);
       /* register clean and deregister tasks for value */
-      add_locked_value_shared(pool_id, lk.release(), target, target_len, std::move(mr));
+      add_locked_value_shared(pool_id, lk.release(), target, target_len, std::move(r.owned));
     }
     catch ( const std::exception &e )
     {
@@ -1228,10 +1573,10 @@ void Shard::io_response_put_locate(Connection_handler *handler, const protocol::
       std::uint64_t key = 0;
       try
       {
-        memory_registered<Connection_base> mr(debug_level(), handler, target, target_len, 0, 0);
-        key = mr.key();
+        auto r = register_memory(handler, pool_id, target, target_len);
+        key = handler->get_memory_remote_key(r.mr);
         /* register clean and rename tasks for value */
-        add_locked_value_exclusive(pool_id, lk.release(), target, target_len, std::move(mr));
+        add_locked_value_exclusive(pool_id, lk.release(), target, target_len, std::move(r.owned));
         add_pending_rename(pool_id, target, k, actual_key);
       }
       catch ( const std::exception &e )
@@ -1299,10 +1644,10 @@ void Shard::io_response_put(Connection_handler *handler, const protocol::Message
 
       status = _i_kvstore->put(msg->pool_id(), k, msg->value(), msg->get_value_len(), msg->flags());
 
+      if (status != S_OK) _stats.op_failed_request_count++;
       if (debug_level() > 2) {
         if (status == E_ALREADY_EXISTS) {
           PLOG("kvstore->put returned E_ALREADY_EXISTS");
-          _stats.op_failed_request_count++;
         }
         else {
           PLOG("kvstore->put returned %d", status);
@@ -1332,6 +1677,16 @@ void Shard::io_response_get(Connection_handler *handler, const protocol::Message
       respond2(handler, iob, msg, S_OK, __func__);
     }
   }
+  else if (auto optimistic = msg->is_direct() ? nullptr : get_optimistic(_i_kvstore.get(), handler, iob, msg)) {
+    CPLOG(2, "Shard: optimistic get status %d", optimistic->get_status());
+    if (optimistic->get_status() == S_OK) {
+      ++_stats.op_get_count;
+    }
+    else {
+      ++_stats.op_failed_request_count;
+    }
+    handler->post_response(iob, optimistic, __func__);
+  }
   else {
     ::iovec value_out{nullptr, 0};
     std::string k             = msg->skey();
@@ -1408,10 +1763,8 @@ void Shard::io_response_get(Connection_handler *handler, const protocol::Message
         else {
           try
           {
-            memory_registered<Connection_base> mr(debug_level(), handler, value_out.iov_base, value_out.iov_len, 0, 0);
-            // auto mr = make_memory_registered(debug_level(), handler, target,
-            // target_len, 0, 0);
-            auto desc = mr.desc();
+            auto r = register_memory(handler, msg->pool_id(), value_out.iov_base, value_out.iov_len);
+            auto desc = handler->get_memory_descriptor(r.mr);
 
             auto response = respond1(handler, iob, msg, S_OK);
 
@@ -1419,7 +1772,7 @@ void Shard::io_response_get(Connection_handler *handler, const protocol::Message
 
             assert(response->get_status() == S_OK);
             /* register clean up task for value */
-            add_locked_value_shared(msg->pool_id(), lk.release(), value_out.iov_base, value_out.iov_len, std::move(mr));
+            add_locked_value_shared(msg->pool_id(), lk.release(), value_out.iov_base, value_out.iov_len, std::move(r.owned));
 
             if (!is_direct && (value_out.iov_len <= (handler->IO_buffer_size() - response->base_message_size()))) {
               CPLOG(2, "posting response header and value together");
@@ -1462,12 +1815,545 @@ void Shard::io_response_erase(Connection_handler *handler, const protocol::Messa
   respond2(handler, iob, msg, status, __func__);
 }
 
+/////////////////////////////////////////////////////////////////////////////
+//   WORKER OFFLOAD   //
+////////////////////////
+bool Shard::is_offloadable(const protocol::Message *p_msg)
+{
+  if (p_msg->type_id() != protocol::MSG_TYPE_IO_REQUEST) return false;
+
+  auto msg = static_cast<const protocol::Message_IO_request *>(p_msg);
+  switch (msg->op()) {
+  case protocol::OP_PUT:
+  case protocol::OP_GET:
+  case protocol::OP_ERASE:
+    /* index maintenance and the short-circuit path stay with the shard thread */
+    return !msg->is_scbe() && lookup_index(msg->pool_id()) == nullptr;
+  default:
+    return false;
+  }
+}
+
+void Shard::offload_io_request(Connection_handler *handler)
+{
+  auto msg = static_cast<const protocol::Message_IO_request *>(handler->peek_pending_msg());
+  handler->msg_recv_log(msg, __func__);
+  /* the workers' own time is not attributed; only the wait for the shard is */
+  _latency.record(Latency_stats::classify(msg), protocol::STATS_PHASE_QUEUE, rdtsc() - handler->pending_msg_stamp());
+
+  const auto iob = handler->allocate_send(io_response_len(msg));
+  assert(iob);
+
+  std::unique_ptr<offload_job_t> job;
+  if (_free_jobs.empty()) {
+    job.reset(new offload_job_t());
+  }
+  else {
+    job = std::move(_free_jobs.back());
+    _free_jobs.pop_back();
+  }
+
+  job->kvstore      = _i_kvstore.get();
+  job->handler      = handler;
+  job->msg_iob      = handler->pop_pending_msg();
+  job->iob          = iob;
+  job->msg          = msg;
+  job->response     = nullptr;
+  job->fallback     = false;
+  job->put_count    = 0;
+  job->get_count    = 0;
+  job->erase_count  = 0;
+  job->failed_count = 0;
+
+  ++_stats.op_request_count;
+  ++_stats.op_offload_count;
+
+  auto &q = _offloaded[handler];
+  _workers->submit(job.get(), q.strand);
+  q.jobs.push_back(std::move(job));
+}
+
+/* runs on a worker thread: touches only the store and the job's buffers */
+void Shard::execute_offloaded(offload_job_t &job)
+{
+  const auto msg = job.msg;
+  try {
+    switch (msg->op()) {
+    case protocol::OP_PUT: {
+      auto status = job.kvstore->put(msg->pool_id(), msg->skey(), msg->value(), msg->get_value_len(), msg->flags());
+      if (status != S_OK) ++job.failed_count;
+      ++job.put_count;
+      job.response = respond1(job.handler, job.iob, msg, status);
+      break;
+    }
+    case protocol::OP_ERASE: {
+      auto status = job.kvstore->erase(msg->pool_id(), msg->skey());
+      if (status != S_OK) ++job.failed_count;
+      ++job.erase_count;
+      job.response = respond1(job.handler, job.iob, msg, status);
+      break;
+    }
+    case protocol::OP_GET: {
+      if (!msg->is_direct() && (job.response = get_optimistic(job.kvstore, job.handler, job.iob, msg))) {
+        if (job.response->get_status() == S_OK) {
+          ++job.get_count;
+        }
+        else {
+          ++job.failed_count;
+        }
+        break;
+      }
+
+      ::iovec                    value_out{nullptr, 0};
+      component::IKVStore::key_t key_handle;
+      status_t rc = job.kvstore->lock(msg->pool_id(), msg->skey(), IKVStore::STORE_LOCK_READ, value_out.iov_base,
+                                      value_out.iov_len, key_handle);
+
+      if (!is_locked(rc) || key_handle == component::IKVStore::KEY_NONE) {
+        ++job.failed_count;
+        job.response = respond1(job.handler, job.iob, msg, rc);
+      }
+      else if (msg->is_direct() || TWO_STAGE_THRESHOLD <= value_out.iov_len) {
+        /* two-stage responses register memory with the connection; the shard thread does that */
+        job.kvstore->unlock(msg->pool_id(), key_handle);
+        job.fallback = true;
+      }
+      else {
+        job.response = respond1(job.handler, job.iob, msg, S_OK);
+        job.response->copy_in_data(value_out.iov_base, value_out.iov_len);
+        job.iob->set_length(job.response->msg_len());
+        job.kvstore->unlock(msg->pool_id(), key_handle, IKVStore::UNLOCK_FLAGS_FLUSH);
+        ++job.get_count;
+      }
+      break;
+    }
+    default:
+      job.fallback = true;
+    }
+  }
+  catch (const std::exception &e) {
+    PLOG("%s: exception in op %i handling: %s", __func__, int(msg->op()), e.what());
+    ++job.failed_count;
+    job.response = respond1(job.handler, job.iob, msg, E_FAIL);
+  }
+}
+
+/* Post (or, for a closing connection, discard) the responses of completed
+ * offloaded requests, oldest first. Returns true if none remain in flight.
+ */
+bool Shard::complete_offloaded(Connection_handler *handler, const bool post)
+{
+  auto it = _offloaded.find(handler);
+  if (it == _offloaded.end()) return true;
+
+  auto &jobs = it->second.jobs;
+  while (!jobs.empty()) {
+    auto &job = *jobs.front();
+    if (!job.complete()) {
+      if (post) return false;
+      _workers->wait_idle();
+    }
+
+    if (!post) {
+      handler->free_buffer(job.iob);
+    }
+    else if (job.fallback) {
+      /* the worker declined it: execute here, in order */
+      switch (job.msg->op()) {
+      case protocol::OP_GET:
+        io_response_get(handler, job.msg, job.iob);
+        break;
+      default:
+        respond2(handler, job.iob, job.msg, E_FAIL, __func__);
+      }
+    }
+    else {
+      handler->post_response(job.iob, job.response, __func__);
+    }
+
+    _stats.op_put_count += job.put_count;
+    _stats.op_get_count += job.get_count;
+    _stats.op_erase_count += job.erase_count;
+    _stats.op_failed_request_count += job.failed_count;
+
+    handler->free_buffer(job.msg_iob);
+    _free_jobs.push_back(std::move(jobs.front()));
+    jobs.pop_front();
+  }
+  return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//   MULTI GET/PUT/ERASE   //
+/////////////////////////////
+namespace
+{
+  /* Iterates the records of an OP_MULTI_xxx request. Record bounds are
+   * checked by well_formed() before any record is acted upon.
+   */
+  class batch_cursor
+  {
+    const std::uint8_t *_p;
+    const std::uint8_t *_end;
+  public:
+    explicit batch_cursor(const protocol::Message_IO_request *msg_)
+      : _p(msg_->batch_data())
+      , _end(msg_->batch_data() + msg_->batch_data_len())
+    {}
+
+    bool well_formed(const protocol::Message_IO_request *msg_) const
+    {
+      if ( sizeof *msg_ + msg_->batch_data_len() > msg_->msg_len() ) return false;
+      std::size_t count = 0;
+      for ( auto p = _p; p != _end; ++count )
+      {
+        protocol::batch_element e;
+        if ( std::size_t(_end - p) < sizeof e ) return false;
+        std::memcpy(&e, p, sizeof e);
+        if ( std::size_t(_end - p) < sizeof e + e.key_len + e.val_len ) return false;
+        p += sizeof e + e.key_len + e.val_len;
+      }
+      return count == msg_->batch_count();
+    }
+
+    /* returns false at end of records */
+    bool next(std::string &key_, const void *&value_, std::size_t &value_len_)
+    {
+      if ( _p == _end ) return false;
+      protocol::batch_element e;
+      std::memcpy(&e, _p, sizeof e);
+      key_.assign(reinterpret_cast<const char *>(_p + sizeof e), e.key_len);
+      value_ = _p + sizeof e + e.key_len;
+      value_len_ = e.val_len;
+      _p += sizeof e + e.key_len + e.val_len;
+      return true;
+    }
+  };
+}
+
+void Shard::io_response_multi_get(Connection_handler *handler, const protocol::Message_IO_request *msg, buffer_t *iob)
+{
+  CPLOG(2, "MULTI_GET: (%p) (request=%lu) count=%lu", static_cast<const void *>(this), msg->request_id(), msg->batch_count());
+
+  batch_cursor c(msg);
+  if ( ! c.well_formed(msg) )
+  {
+    ++_stats.op_failed_request_count;
+    respond2(handler, iob, msg, E_INVAL, __func__);
+    return;
+  }
+
+  auto response = respond1(handler, iob, msg, S_OK);
+  const auto buffer_size = handler->IO_buffer_size();
+
+  std::string k;
+  const void *v;
+  std::size_t v_len;
+  while ( c.next(k, v, v_len) )
+  {
+    if ( msg->is_scbe() )
+    {
+      if ( ! response->append_batch_element(buffer_size, S_OK, nullptr, 0) ) break;
+      continue;
+    }
+
+    ::iovec value_out{nullptr, 0};
+    component::IKVStore::key_t key_handle;
+    status_t rc = _i_kvstore->lock(msg->pool_id(), k, IKVStore::STORE_LOCK_READ, value_out.iov_base, value_out.iov_len, key_handle);
+
+    if ( ! is_locked(rc) || key_handle == component::IKVStore::KEY_NONE )
+    {
+      if ( ! response->append_batch_element(buffer_size, rc == S_OK ? E_FAIL : rc, nullptr, 0) ) break;
+      ++_stats.op_failed_request_count;
+      continue;
+    }
+
+    locked_key lk(_i_kvstore.get(), msg->pool_id(), key_handle);
+
+    if ( ! response->append_batch_element(buffer_size, S_OK, value_out.iov_base, value_out.iov_len) )
+    {
+      /* Response is full. If this is the first record the value can
+       * never be batched; the client must fetch it with a plain get.
+       * Otherwise the client resends the unprocessed records.
+       */
+      if ( response->batch_count() == 0 )
+      {
+        response->append_batch_element(buffer_size, component::IKVStore::E_TOO_LARGE, nullptr, 0);
+      }
+      break;
+    }
+    ++_stats.op_get_count;
+  }
+
+  iob->set_length(response->msg_len());
+  handler->post_response(iob, response, __func__);
+}
+
+void Shard::io_response_multi_put(Connection_handler *handler, const protocol::Message_IO_request *msg, buffer_t *iob)
+{
+  CPLOG(2, "MULTI_PUT: (%p) (request=%lu) count=%lu", static_cast<const void *>(this), msg->request_id(), msg->batch_count());
+
+  batch_cursor c(msg);
+  if ( ! c.well_formed(msg) )
+  {
+    ++_stats.op_failed_request_count;
+    respond2(handler, iob, msg, E_INVAL, __func__);
+    return;
+  }
+
+  auto response = respond1(handler, iob, msg, S_OK);
+  const auto buffer_size = handler->IO_buffer_size();
+
+  /* request records are never smaller than response records, so every
+   * status will fit in the response
+   */
+  std::string k;
+  const void *v;
+  std::size_t v_len;
+  while ( c.next(k, v, v_len) )
+  {
+    status_t status = S_OK;
+    if ( ! msg->is_scbe() )
+    {
+      status = _i_kvstore->put(msg->pool_id(), k, v, v_len, msg->flags());
+      if ( status == S_OK )
+        add_index_key(msg->pool_id(), k);
+      else
+        ++_stats.op_failed_request_count;
+    }
+    response->append_batch_element(buffer_size, status, nullptr, 0);
+    ++_stats.op_put_count;
+  }
+
+  iob->set_length(response->msg_len());
+  handler->post_response(iob, response, __func__);
+}
+
+void Shard::io_response_multi_erase(Connection_handler *handler, const protocol::Message_IO_request *msg, buffer_t *iob)
+{
+  CPLOG(2, "MULTI_ERASE: (%p) (request=%lu) count=%lu", static_cast<const void *>(this), msg->request_id(), msg->batch_count());
+
+  batch_cursor c(msg);
+  if ( ! c.well_formed(msg) )
+  {
+    ++_stats.op_failed_request_count;
+    respond2(handler, iob, msg, E_INVAL, __func__);
+    return;
+  }
+
+  auto response = respond1(handler, iob, msg, S_OK);
+  const auto buffer_size = handler->IO_buffer_size();
+
+  std::string k;
+  const void *v;
+  std::size_t v_len;
+  while ( c.next(k, v, v_len) )
+  {
+    status_t status = S_OK;
+    if ( ! msg->is_scbe() )
+    {
+      status = _i_kvstore->erase(msg->pool_id(), k);
+      if ( status == S_OK )
+        remove_index_key(msg->pool_id(), k);
+      else
+        ++_stats.op_failed_request_count;
+    }
+    response->append_batch_element(buffer_size, status, nullptr, 0);
+    ++_stats.op_erase_count;
+  }
+
+  iob->set_length(response->msg_len());
+  handler->post_response(iob, response, __func__);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//   SCAN          //
+/////////////////////
+namespace
+{
+  /* A scan expression ("next:", "prefix:p", "range:lo..hi", "regex:r",
+   * "substring:s" or "exact:k") reduced to the ordered key range it covers,
+   * with an additional per-key filter for regex and substring.
+   */
+  class scan_expression
+  {
+    std::string                          _lo;
+    std::string                          _hi; /* exclusive, empty for no upper bound */
+    bool                                 _prefix;
+    std::unique_ptr<common::Key_matcher> _filter;
+  public:
+    scan_expression() : _lo(), _hi(), _prefix(false), _filter() {}
+
+    /* returns false if the expression is not recognized */
+    bool parse(const std::string &expr_)
+    {
+      if ( expr_ == "next:" ) return true;
+      if ( expr_.compare(0, 7, "prefix:") == 0 )
+      {
+        _lo = expr_.substr(7);
+        _prefix = true;
+        return true;
+      }
+      if ( expr_.compare(0, 6, "exact:") == 0 )
+      {
+        _lo = expr_.substr(6);
+        _hi = _lo + '\0'; /* the least key greater than _lo */
+        return true;
+      }
+      if ( expr_.compare(0, 6, "range:") == 0 )
+      {
+        auto sep = expr_.find("..", 6);
+        if ( sep == std::string::npos ) return false;
+        _lo = expr_.substr(6, sep - 6);
+        _hi = expr_.substr(sep + 2);
+        return true;
+      }
+      if ( expr_.compare(0, 10, "substring:") == 0 )
+      {
+        _filter.reset(new common::Key_matcher(common::Key_matcher::MATCH_SUBSTRING, expr_.substr(10)));
+        return true;
+      }
+      if ( expr_.compare(0, 6, "regex:") == 0 )
+      {
+        /* throws std::regex_error */
+        _filter.reset(new common::Key_matcher(common::Key_matcher::MATCH_REGEX, expr_.substr(6)));
+        /* only keys with the regex's literal prefix can match */
+        _lo = _filter->prefix();
+        _prefix = ! _lo.empty();
+        return true;
+      }
+      return false;
+    }
+
+    const std::string &lo() const { return _lo; }
+
+    /* keys are visited in order, so the first key past the range ends the scan */
+    bool past_end(const std::string &k_) const
+    {
+      if ( _prefix ) return k_.compare(0, _lo.size(), _lo) != 0;
+      return ! _hi.empty() && ! (k_ < _hi);
+    }
+
+    bool match(const std::string &k_) const { return ! _filter || _filter->match(k_); }
+  };
+}
+
+void Shard::io_response_scan(Connection_handler *handler, const protocol::Message_IO_request *msg, buffer_t *iob)
+{
+  CPLOG(2, "SCAN: (%p) (request=%lu) (%.*s)", static_cast<const void *>(this), msg->request_id(), int(msg->get_key_len()), msg->cmd());
+
+  auto index = lookup_index(msg->pool_id());
+  scan_expression expr;
+  bool ok = index && sizeof *msg + msg->get_key_len() + 1 + msg->get_value_len() <= msg->msg_len();
+  try {
+    ok = ok && expr.parse(msg->skey());
+  }
+  catch ( const std::regex_error & ) {
+    ok = false;
+  }
+
+  if ( ! ok )
+  {
+    if ( ! index ) PWRN("Shard: cannot perform scan request, no index! use configure('AddIndex::VolatileTree')");
+    ++_stats.op_failed_request_count;
+    respond2(handler, iob, msg, E_INVAL, __func__);
+    return;
+  }
+
+  const std::string cursor(reinterpret_cast<const char *>(msg->value()), msg->get_value_len());
+  const bool with_values = msg->flags() & protocol::SCAN_FLAG_VALUES;
+  const auto max_keys = msg->scan_limit();
+
+  auto response = respond1(handler, iob, msg, S_OK);
+  const auto buffer_size = handler->IO_buffer_size();
+
+  /* The cursor is the last key examined. The response always keeps room
+   * for it, so that the scan can resume after any key it has examined.
+   */
+  std::string last;
+  unsigned compares = 0;
+  bool end_of_range = false;
+
+  auto visit = [&] (const std::string &k) -> bool
+  {
+    if ( expr.past_end(k) )
+    {
+      end_of_range = true;
+      return false;
+    }
+    if ( compares == MAX_INDEX_COMPARISONS
+         || ( max_keys && response->batch_count() == max_keys )
+         || response->msg_len() + k.size() > buffer_size )
+      return false;
+
+    ++compares;
+    if ( expr.match(k) )
+    {
+      if ( ! with_values )
+      {
+        if ( ! response->append_scan_element(buffer_size, k.data(), k.size(), nullptr, 0, k.size()) ) return false;
+      }
+      else
+      {
+        ::iovec value_out{nullptr, 0};
+        component::IKVStore::key_t key_handle;
+        status_t rc = _i_kvstore->lock(msg->pool_id(), k, IKVStore::STORE_LOCK_READ, value_out.iov_base, value_out.iov_len, key_handle);
+
+        if ( ! is_locked(rc) || key_handle == component::IKVStore::KEY_NONE )
+        {
+          /* an index entry for a key which has since gone is skipped;
+           * otherwise the client fetches the value itself
+           */
+          if ( rc != IKVStore::E_KEY_NOT_FOUND
+               && ! response->append_scan_element(buffer_size, k.data(), k.size(), nullptr, protocol::SCAN_VALUE_DEFERRED, k.size()) )
+            return false;
+        }
+        else
+        {
+          locked_key lk(_i_kvstore.get(), msg->pool_id(), key_handle);
+          if ( ! response->append_scan_element(buffer_size, k.data(), k.size(), value_out.iov_base, value_out.iov_len, k.size()) )
+          {
+            /* a value which cannot share the buffer with any other is deferred */
+            if ( response->batch_count() != 0
+                 || ! response->append_scan_element(buffer_size, k.data(), k.size(), nullptr, protocol::SCAN_VALUE_DEFERRED, k.size()) )
+              return false;
+          }
+          else
+            ++_stats.op_get_count;
+        }
+      }
+    }
+    last = k;
+    return true;
+  };
+
+  const bool resume = ! cursor.empty() && ! (cursor < expr.lo());
+  status_t rc = index->scan(resume ? cursor : expr.lo(), ! resume, visit);
+
+  if ( rc == S_MORE && ! end_of_range )
+  {
+    if ( last.empty() )
+      rc = E_FAIL; /* not even the first key fits: no progress is possible */
+    else
+      response->set_scan_cursor(last);
+  }
+  else if ( rc == S_MORE )
+    rc = S_OK;
+
+  if ( rc != S_OK && rc != S_MORE ) ++_stats.op_failed_request_count;
+  response->set_status(rc);
+  iob->set_length(response->msg_len());
+  handler->post_response(iob, response, __func__);
+}
+
 /////////////////////////////////////////////////////////////////////////////
 //   CONFIGURE     //
 /////////////////////
 void Shard::io_response_configure(Connection_handler *handler, const protocol::Message_IO_request *msg, buffer_t *iob)
 {
   if (debug_level() > 1) PMAJOR("Shard: pool CONFIGURE (%s)", msg->cmd());
+  /* index changes must not race with puts and erases on other connections */
+  if (_workers) _workers->wait_idle();
   respond2(handler, iob, msg, process_configure(msg), __func__);
 }
 
@@ -1476,7 +2362,7 @@ try {
   handler->msg_recv_log(msg, __func__);
   using namespace component;
 
-  const auto iob = handler->allocate_send();
+  const auto iob = handler->allocate_send(io_response_len(msg));
   assert(iob);
 
   ++_stats.op_request_count;
@@ -1515,6 +2401,18 @@ try {
   case protocol::OP_CONFIGURE:
     io_response_configure(handler, msg, iob);
     break;
+  case protocol::OP_MULTI_GET:
+    io_response_multi_get(handler, msg, iob);
+    break;
+  case protocol::OP_MULTI_PUT:
+    io_response_multi_put(handler, msg, iob);
+    break;
+  case protocol::OP_MULTI_ERASE:
+    io_response_multi_erase(handler, msg, iob);
+    break;
+  case protocol::OP_SCAN:
+    io_response_scan(handler, msg, iob);
+    break;
   default:
     throw Protocol_exception("operation not implemented");
   }
@@ -1632,16 +2530,15 @@ void Shard::io_response_locate(Connection_handler *handler, const protocol::Mess
     std::uint64_t key = 0;
     try
     {
-      memory_registered<Connection_base> mr(debug_level(), handler, reinterpret_cast<void *>(sgr.mr_low), sgr.mr_high - sgr.mr_low, 0,
-                                          0);
+      auto r = register_memory(handler, msg->pool_id(), reinterpret_cast<void *>(sgr.mr_low), sgr.mr_high - sgr.mr_low);
 #if 0
     auto cmd = "/bin/cat /proc/" + std::to_string(::getpid()) + "/smaps";
     CPLOG(2, "%s::%s: bounds %p %p %s", _cname, __func__, reinterpret_cast<const void *>(mr_low),  reinterpret_cast<const void *>(mr_high),  cmd.c_str());
     ::system(cmd.c_str());
 #endif
-      key = mr.key();
+      key = handler->get_memory_remote_key(r.mr);
       /* register deregister task for space */
-      add_space_shared(range<std::uint64_t>(t.first, t.second - sgr.excess_length), std::move(mr));
+      add_space_shared(range<std::uint64_t>(t.first, t.second - sgr.excess_length), std::move(r.owned));
     }
     catch ( const std::exception &e )
     {
@@ -1775,11 +2672,21 @@ void Shard::process_info_request(Connection_handler *handler, const protocol::Me
   if (msg->type() == protocol::INFO_TYPE_GET_STATS) {
     protocol::Message_stats *response = new (iob->base()) protocol::Message_stats(handler->auth_id(), _stats);
     response->set_status(S_OK);
-    iob->set_length(sizeof(protocol::Message_stats));
+
+    if ((msg->offset & protocol::STATS_VERSION_MASK) >= protocol::STATS_VERSION_LATENCY) {
+      if (!_latency.append_to(response, handler->IO_buffer_size())) {
+        PWRN("Shard: latency histograms exceed the IO buffer; sending version 0 stats");
+        response = new (iob->base()) protocol::Message_stats(handler->auth_id(), _stats);
+        response->set_status(S_OK);
+      }
+      if (msg->offset & protocol::STATS_FLAG_RESET) _latency.reset();
+    }
+    iob->set_length(response->msg_len());
 
     if (debug_level() > 1) dump_stats();
 
     handler->post_send_buffer(iob, response, __func__);
+    return;
   }
 
   /* info requests */
@@ -1900,6 +2807,8 @@ void Shard::check_for_new_connections()
     if (debug_level() > 1 || true) PMAJOR("Shard: processing new connection (%p) total %d",
                                          static_cast<const void *>(handler), connections);
     connections++;
+    /* allow the client as many messages in flight as we will handle per tick */
+    handler->set_recv_depth(_batch_budget);
     _handlers.push_back(handler);
   }
 }
@@ -1914,12 +2823,27 @@ status_t Shard::process_configure(const protocol::Message_IO_request *msg)
     std::string index_str = command.substr(10);
 
     /* TODO: use shard configuration */
+    const char *index_lib = nullptr;
+    uuid_t      index_factory;
     if (index_str == "VolatileTree") {
+      index_lib     = "libcomponent-indexrbtree.so";
+      index_factory = rbtreeindex_factory;
+    }
+    else if (index_str == "VolatileBTree") {
+      index_lib     = "libcomponent-indexbtree.so";
+      index_factory = btreeindex_factory;
+    }
+    else if (index_str == "Time") {
+      /* time index is kept by the store itself */
+      return _i_kvstore->configure_pool(msg->pool_id(), command);
+    }
+
+    if (index_lib) {
       if (_index_map == nullptr) _index_map.reset(new index_map_t());
 
       /* create index component and put into shard index map */
-      IBase *comp = load_component("libcomponent-indexrbtree.so", rbtreeindex_factory);
-      if (!comp) throw General_exception("unable to load libcomponent-indexrbtree.so");
+      IBase *comp = load_component(index_lib, index_factory);
+      if (!comp) throw General_exception("unable to load %s", index_lib);
       auto factory = make_itf_ref(static_cast<IKVIndex_factory *>(comp->query_interface(IKVIndex_factory::iid())));
       assert(factory);
 
@@ -1954,6 +2878,9 @@ status_t Shard::process_configure(const protocol::Message_IO_request *msg)
       return E_BAD_PARAM;
     }
   }
+  else if (command == "RemoveIndex::Time") {
+    return _i_kvstore->configure_pool(msg->pool_id(), command);
+  }
   else if (command == "RemoveIndex::") {
     try {
       _index_map->erase(msg->pool_id());
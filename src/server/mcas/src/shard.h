@@ -24,12 +24,16 @@
 #include <api/kvindex_itf.h>
 #include <api/kvstore_itf.h>
 #include <common/cpu.h>
+#include <common/cycles.h>
 #include <common/exceptions.h>
+#include <common/fd_open.h>
 #include <common/logging.h>
 #include <common/spsc_bounded_queue.h>
 
+#include <chrono>
 #include <csignal> /* sig_atomic_t */
 #include <experimental/string_view>
+#include <deque>
 #include <list>
 #include <memory>
 #include <string>
@@ -44,10 +48,12 @@
 #include "config_file.h"
 #include "connection_handler.h"
 #include "fabric_transport.h"
+#include "latency_stats.h"
 #include "mcas_config.h"
 #include "pool_manager.h"
 #include "range.h"
 #include "security.h"
+#include "shard_workers.h"
 #include "task_key_find.h"
 #include "types.h"
 
@@ -74,6 +80,7 @@ using Shard_transport = Fabric_transport;
 class Shard : public Shard_transport, private common::log_source {
  private:
   static constexpr size_t TWO_STAGE_THRESHOLD = KiB(8); /* above this two stage protocol is used */
+  static constexpr size_t MAX_OFFLOADED_PER_CONNECTION = NUM_SHARD_BUFFERS / 4; /* each holds a request and a response buffer */
 
   static constexpr const char *const _cname = "Shard";
 
@@ -91,22 +98,31 @@ class Shard : public Shard_transport, private common::log_source {
     std::string                 to;
   };
 
+  using owned_mr_t = std::unique_ptr<memory_registered<Connection_base>>;
+
+  /* Registration of memory for direct IO: a registered pool region of the
+   * connection (owned is null) or a registration owned by the request.
+   */
+  struct registration_t {
+    owned_mr_t      owned;
+    memory_region_t mr;
+  };
+
   struct space_lock_info_t {
-    using transport_t = mcas::Connection_base;
-    memory_registered<transport_t> mr;
-    unsigned                       count;
+    owned_mr_t mr; /* null if covered by a registered pool region */
+    unsigned   count;
 
-    explicit space_lock_info_t(memory_registered<transport_t> &&mr_) noexcept : mr(std::move(mr_)), count(0) {}
+    explicit space_lock_info_t(owned_mr_t &&mr_) noexcept : mr(std::move(mr_)), count(0) {}
   };
 
   struct lock_info_t : public space_lock_info_t {
     component::IKVStore::pool_t pool;
     component::IKVStore::key_t  key;
     size_t                      value_size;
-    lock_info_t(component::IKVStore::pool_t      pool_,
-                component::IKVStore::key_t       key_,
-                std::size_t                      value_size_,
-                memory_registered<transport_t> &&mr_) noexcept
+    lock_info_t(component::IKVStore::pool_t pool_,
+                component::IKVStore::key_t  key_,
+                std::size_t                 value_size_,
+                owned_mr_t &&               mr_) noexcept
         : space_lock_info_t(std::move(mr_)),
           pool(pool_),
           key(key_),
@@ -155,11 +171,13 @@ class Shard : public Shard_transport, private common::log_source {
   inline void signal_exit()
   {
     _thread_exit = true;
+    wakeup();
   } /*< signal main loop to exit */
 
   inline void send_cluster_event(const std::string &sender, const std::string &type, const std::string &content)
   {
     _cluster_signal_queue.send_message(sender, type, content);
+    wakeup();
   }
 
  private:
@@ -173,20 +191,30 @@ class Shard : public Shard_transport, private common::log_source {
                     bool               triggered_profile);
 
   /* locked values are those from put_direct and get_direct */
-  void add_locked_value_shared(const pool_t                         pool_id,
-                               component::IKVStore::key_t           key,
-                               void *                               target,
-                               size_t                               target_len,
-                               memory_registered<Connection_base> &&mr);
+  void add_locked_value_shared(const pool_t               pool_id,
+                               component::IKVStore::key_t key,
+                               void *                     target,
+                               size_t                     target_len,
+                               owned_mr_t &&              mr);
   void release_locked_value_shared(const void *target);
-  void add_locked_value_exclusive(const pool_t                         pool_id,
-                                  component::IKVStore::key_t           key,
-                                  void *                               target,
-                                  size_t                               target_len,
-                                  memory_registered<Connection_base> &&mr);
+  void add_locked_value_exclusive(const pool_t               pool_id,
+                                  component::IKVStore::key_t key,
+                                  void *                     target,
+                                  size_t                     target_len,
+                                  owned_mr_t &&              mr);
   void release_locked_value_exclusive(const void *target);
 
-  void add_space_shared(const range<std::uint64_t> &range, memory_registered<Connection_base> &&mr);
+  void add_space_shared(const range<std::uint64_t> &range, owned_mr_t &&mr);
+
+  /* register the pool's regions with the connection (on open, create, and
+   * when a lookup misses because the pool has grown)
+   */
+  unsigned register_pool_regions(Connection_handler *handler, const pool_t pool_id);
+
+  /* registration for direct IO to memory in a pool: the connection's
+   * registration of the covering pool region if there is one, else new
+   */
+  registration_t register_memory(Connection_handler *handler, const pool_t pool_id, const void *target, size_t target_len);
   void release_space_shared(const range<std::uint64_t> &range);
 
   void add_pending_rename(const pool_t pool_id, const void *target, const std::string &from, const std::string &to);
@@ -215,15 +243,27 @@ class Shard : public Shard_transport, private common::log_source {
   void io_response_get(Connection_handler *handler, const protocol::Message_IO_request *msg, buffer_t *iob);
   void io_response_erase(Connection_handler *handler, const protocol::Message_IO_request *msg, buffer_t *iob);
   void io_response_configure(Connection_handler *handler, const protocol::Message_IO_request *msg, buffer_t *iob);
+  void io_response_multi_get(Connection_handler *handler, const protocol::Message_IO_request *msg, buffer_t *iob);
+  void io_response_multi_put(Connection_handler *handler, const protocol::Message_IO_request *msg, buffer_t *iob);
+  void io_response_multi_erase(Connection_handler *handler, const protocol::Message_IO_request *msg, buffer_t *iob);
+  void io_response_scan(Connection_handler *handler, const protocol::Message_IO_request *msg, buffer_t *iob);
   void io_response_locate(Connection_handler *handler, const protocol::Message_IO_request *msg, buffer_t *iob);
   void io_response_release(Connection_handler *handler, const protocol::Message_IO_request *msg, buffer_t *iob);
   void io_response_release_with_flush(Connection_handler *handler, const protocol::Message_IO_request *msg, buffer_t *iob);
 
+  /* execution of simple IO requests by the worker pool (worker_threads > 0) */
+  struct offload_job_t;
+  bool is_offloadable(const protocol::Message *msg);
+  void offload_io_request(Connection_handler *handler);
+  static void execute_offloaded(offload_job_t &job);
+  bool complete_offloaded(Connection_handler *handler, bool post);
+
   void process_info_request(Connection_handler *handler, const protocol::Message_INFO_request *msg, common::profiler &pr);
   void process_ado_request(Connection_handler *handler, const protocol::Message_ado_request *msg);
   void process_put_ado_request(Connection_handler *handler, const protocol::Message_put_ado_request *msg);
 
   void process_messages_from_ado();
+  void process_ado_callback(component::IADO_proxy *ado, Connection_handler *handler, const void *buffer);
   void close_all_ado();
 
   status_t process_configure(const protocol::Message_IO_request *msg);
@@ -232,6 +272,20 @@ class Shard : public Shard_transport, private common::log_source {
 
   void service_cluster_signals();
 
+  /* wake the shard thread, should it be blocked in wait_for_work */
+  void wakeup();
+
+  /* Block until a connection has a completion, a new connection or an ADO
+   * message arrives, wakeup is called or the timeout expires. Returns
+   * false, without blocking, if some connection may already have a
+   * completion. client_ready is set if a connection ended the wait, and
+   * listener_ready if a new connection may be waiting.
+   */
+  bool wait_for_work(std::chrono::milliseconds timeout, bool &client_ready, bool &listener_ready);
+
+  /* the size of send buffer which a response to msg needs */
+  static std::size_t io_response_len(const protocol::Message_IO_request *msg);
+
   static auto respond1(
     const Connection_handler *           handler_,
     buffer_t                           * iob_,
@@ -244,6 +298,15 @@ class Shard : public Shard_transport, private common::log_source {
     int                                  status,
     const char *                         func);
 
+  /* small GET, copied into the response without locking the value; nullptr
+   * if the value must be read under a lock instead
+   */
+  static auto get_optimistic(
+    component::IKVStore *                kvstore_,
+    const Connection_handler *           handler_,
+    buffer_t                           * iob_,
+    const protocol::Message_IO_request * msg_) -> protocol::Message_IO_response *;
+
   component::IKVIndex *lookup_index(const pool_t pool_id)
   {
     if (_index_map) {
@@ -283,7 +346,7 @@ class Shard : public Shard_transport, private common::log_source {
     , const std::vector<::iovec> &region_breaks
   ) -> sg_result;
 
-  inline bool ado_enabled() const { return (_i_ado_mgr && _ado_plugins.size() > 0); }
+  inline bool ado_enabled() const { return ((_i_ado_mgr || _ado_in_process) && _ado_plugins.size() > 0); }
 
   inline auto get_ado_interface(pool_t pool_id) { return _ado_pool_map.get_proxy(pool_id); }
 
@@ -295,6 +358,7 @@ class Shard : public Shard_transport, private common::log_source {
 
   /* per-shard statistics */
   component::IMCAS::Shard_stats _stats alignas(8);
+  Latency_stats                 _latency;
 
   void dump_stats()
   {
@@ -309,11 +373,50 @@ class Shard : public Shard_transport, private common::log_source {
     PINF("ERASE count        : %lu", _stats.op_erase_count);
     PINF("ADO count          : %lu (enabled=%s)", _stats.op_ado_count, ado_enabled() ? "yes" : "no");
     PINF("Failed count       : %lu", _stats.op_failed_request_count);
+    PINF("Busy ticks         : %lu", _stats.busy_tick_count);
+    PINF("Msgs per busy tick : %.2f (max %lu, budget %u)",
+         _stats.busy_tick_count ? double(_stats.tick_msg_count) / double(_stats.busy_tick_count) : 0.0,
+         _stats.tick_msg_max, _batch_budget);
+    PINF("Budget reached     : %lu", _stats.batch_budget_reached_count);
+    PINF("Offloaded count    : %lu (workers=%u)", _stats.op_offload_count, _workers ? _workers->size() : 0);
+    PINF("MR cache hits      : %lu (misses %lu)", _stats.mr_cache_hit_count, _stats.mr_cache_miss_count);
+    PINF("Group commit       : %s", _group_commit ? "yes" : "no");
+    PINF("Idle blocks        : %lu (%lu usec blocked)", _stats.idle_block_count, _stats.idle_block_usec);
+    PINF("Wake latency       : %.0f ns mean, %lu ns max",
+         _stats.wake_latency_count ? double(_stats.wake_latency_ns_total) / double(_stats.wake_latency_count) : 0.0,
+         _stats.wake_latency_ns_max);
     PINF("Session count      : %lu", session_count());
     PINF("------------------------------------------------");
   }
 
  private:
+  /* An OP_PUT, OP_ERASE or small OP_GET executed by a worker thread. The
+   * response is built in iob by the worker and posted, in request order,
+   * by the shard thread. Stats are accumulated in the job and folded into
+   * _stats by the shard thread.
+   */
+  struct offload_job_t : public Shard_worker_pool::Task {
+    component::IKVStore *                kvstore      = nullptr;
+    Connection_handler *                 handler      = nullptr;
+    buffer_t *                           msg_iob      = nullptr; /*< request buffer, freed on completion */
+    buffer_t *                           iob          = nullptr; /*< response buffer */
+    const protocol::Message_IO_request * msg          = nullptr;
+    protocol::Message_IO_response *      response     = nullptr;
+    bool                                 fallback     = false; /*< not handled, shard thread must execute it */
+    unsigned                             put_count    = 0;
+    unsigned                             get_count    = 0;
+    unsigned                             erase_count  = 0;
+    unsigned                             failed_count = 0;
+
+    void execute() noexcept override { execute_offloaded(*this); }
+  };
+
+  /* a connection's offloaded requests, executed and completed in order */
+  struct offload_queue_t {
+    Shard_worker_pool::Strand                   strand{};
+    std::deque<std::unique_ptr<offload_job_t>> jobs{};
+  };
+
   struct work_request_t {
     Connection_handler *             handler;
     component::IKVStore::pool_t      pool;
@@ -381,6 +484,12 @@ class Shard : public Shard_transport, private common::log_source {
   bool                                              _thread_exit;
   bool                                              _forced_exit;
   unsigned                                          _core;
+  const unsigned                                    _batch_budget; /*< max messages handled per connection per loop iteration */
+  const unsigned                                    _worker_threads; /*< configured size of worker pool */
+  bool                                              _group_commit; /*< one persistence fence per batch, before its responses */
+  const double                                      _tsc_mhz;
+  const cpu_time_t                                  _idle_spin_cycles; /*< idle polling before blocking; 0 for never block */
+  common::Fd_open                                   _wakeup;           /*< eventfd which ends a block in wait_for_work */
   size_t                                            _max_message_size;
   component::Itf_ref<component::IKVStore>           _i_kvstore;
   component::Itf_ref<component::IADO_manager_proxy> _i_ado_mgr;    /*< null indicate non-ADO mode */
@@ -397,9 +506,13 @@ class Shard : public Shard_transport, private common::log_source {
   const std::string                                 _ado_path;
   std::vector<std::string>                          _ado_plugins;
   std::map<std::string, std::string>                _ado_params;
+  const bool                                        _ado_in_process; /*< plugins run in the shard, not an ADO process */
   Shard_security                                    _security;
   Cluster_signal_queue                              _cluster_signal_queue;
   std::string                                       _backend;
+  std::unique_ptr<Shard_worker_pool>                _workers; /*< null unless worker_threads is set and the store allows */
+  std::unordered_map<const Connection_handler *, offload_queue_t> _offloaded;
+  std::vector<std::unique_ptr<offload_job_t>>       _free_jobs;
   std::future<void>                                 _thread;
 };
 
@@ -24,6 +24,7 @@
 #include <common/exceptions.h>
 #include <common/cycles.h>
 #include <nupm/mcas_mod.h>
+#include <nupm/memcpy_persist.h>
 #include <rapidjson/ostreamwrapper.h>
 #include <rapidjson/writer.h>
 #include <libpmem.h>
@@ -32,6 +33,7 @@
 #include <sstream>
 #include <fstream>
 
+#include "ado_inprocess.h"
 #include "config_file.h"
 #include "mcas_config.h"
 #include "resource_unavailable.h"
@@ -71,37 +73,57 @@ status_t Shard::conditional_bootstrap_ado_process(component::IKVStore*        kv
   if (proxy == nullptr) {
     if (!_ado_map.has_ado_for_pool(desc.name)) {
       /* need to launch new ADO process */
-      std::vector<std::string> args;
-      args.push_back("--plugins");
-
       std::string plugin_str;
       for (auto& plugin : _ado_plugins) {
-        args.push_back(plugin);
         plugin_str += plugin + ",";
       }
       plugin_str = plugin_str.substr(0, plugin_str.size() - 1);
 
+      std::vector<std::string> params;
       for (auto& ado_param : _ado_params) {
-        args.push_back("--param");
-        args.push_back("'{" + ado_param.first + ":" + ado_param.second + "}'");
+        params.push_back("'{" + ado_param.first + ":" + ado_param.second + "}'");
       }
 
       /* add parameter passing ipaddr */
       std::string net_addr = _net_addr;
-      args.push_back("--param");
-      args.push_back("'{net:" + net_addr + "," + std::to_string(_port) + "}'");
+      params.push_back("'{net:" + net_addr + "," + std::to_string(_port) + "}'");
 
-      PMAJOR("Shard: Launching with ADO path: (%s)", _ado_path.c_str());
       PMAJOR("Shard: ADO plugins: (%s)", plugin_str.c_str());
 
-      ado = _i_ado_mgr->create(handler->auth_id(), debug_level(), kvs, pool_id,
-                               desc.name,                // pool name
-                               desc.size,                // pool_size,
-                               desc.flags,               // const unsigned int pool_flags,
-                               desc.expected_obj_count,  // const uint64_t expected_obj_count,
-                               _ado_path, args, 0);
+      if (_ado_in_process) {
+        /* callbacks are dispatched on this thread, while the plugin waits */
+        ado = new ADO_inprocess_proxy(handler->auth_id(), debug_level(), kvs, pool_id, desc.name, desc.size,
+                                      desc.flags, desc.expected_obj_count, _ado_plugins, params,
+                                      [this](component::IADO_proxy* proxy, const void* buffer) {
+                                        auto i = _ado_pool_map.find(proxy->pool_id());
+                                        process_ado_callback(proxy,
+                                                             i == _ado_pool_map.end() ? nullptr : std::get<1>(i->second),
+                                                             buffer);
+                                      });
+        ado->add_ref();
+
+        CPLOG(2, "ADO plugins loaded in process OK.");
+      }
+      else {
+        std::vector<std::string> args;
+        args.push_back("--plugins");
+        args.insert(args.end(), _ado_plugins.begin(), _ado_plugins.end());
+        for (auto& param : params) {
+          args.push_back("--param");
+          args.push_back(param);
+        }
+
+        PMAJOR("Shard: Launching with ADO path: (%s)", _ado_path.c_str());
 
-      CPLOG(2, "ADO process launched OK.");
+        ado = _i_ado_mgr->create(handler->auth_id(), debug_level(), kvs, pool_id,
+                                 desc.name,                // pool name
+                                 desc.size,                // pool_size,
+                                 desc.flags,               // const unsigned int pool_flags,
+                                 desc.expected_obj_count,  // const uint64_t expected_obj_count,
+                                 _ado_path, args, 0);
+
+        CPLOG(2, "ADO process launched OK.");
+      }
 
       _ado_map.add_ado_for_pool(desc.name, ado);
     }
@@ -128,6 +150,22 @@ status_t Shard::conditional_bootstrap_ado_process(component::IKVStore*        kv
       return rc;
     }
 
+    if (_ado_in_process) {
+      /* the plugins already share the shard's mappings of the pool */
+      std::pair<std::string, std::vector<::iovec>> regions;
+      auto                 rc = _i_kvstore->get_pool_regions(pool_id, regions);
+
+      if (rc != S_OK) {
+        PWRN("cannot get pool regions; unable to register with ADO");
+        return rc;
+      }
+
+      for (auto& r : regions.second) {
+        ado->send_memory_map(0, round_up_page(r.iov_len), r.iov_base);
+      }
+      return S_OK;
+    }
+
     if (_backend == "mapstore" && !check_xpmem_kernel_module()) {
       PERR("mapstore with ADO requires XPMEM kernel module");
       throw Logic_exception("no XPMEM kernel module");
@@ -228,7 +266,7 @@ void Shard::process_put_ado_request(Connection_handler* handler, const protocol:
   return;
 #endif
 
-  if (!_i_ado_mgr) {
+  if (!ado_enabled()) {
     error_func("ADO!NOT_ENABLED(put)");
     return;
   }
@@ -288,7 +326,7 @@ void Shard::process_put_ado_request(Connection_handler* handler, const protocol:
       return;
     }
     detached_val_len = size_to_allocate;
-    memcpy(detached_val_ptr, msg->value(), msg->value_len());
+    nupm::memcpy_persist(detached_val_ptr, msg->value(), msg->value_len());
 
     CPLOG(2, "Shard_ado: allocated detached memory (%p,%lu)", detached_val_ptr, detached_val_len);
   }
@@ -362,7 +400,7 @@ void Shard::process_ado_request(Connection_handler* handler, const protocol::Mes
 
     if (!ado_enabled()) {
       std::ostringstream o;
-      o << "ADO!NOT_ENABLED mgr '" << (_i_ado_mgr ? "present" : "missing") << "' load count " << _ado_plugins.size();
+      o << "ADO!NOT_ENABLED mgr '" << (_i_ado_mgr ? "present" : _ado_in_process ? "in-process" : "missing") << "' load count " << _ado_plugins.size();
       error_func(E_INVAL, o.str().c_str());
       PLOG("%s server error ADO!NOT_ENABLED", __func__);
       return;
@@ -628,219 +666,180 @@ void Shard::process_messages_from_ado()
 
     } /* end of while ado->check_work_completions */
 
-    uint64_t             work_id = 0; /* maps to record of pool, key handle, lock type, request id etc. */
-    ADO_op               op      = ADO_op::UNDEFINED;
-    std::string          key, key_expression;
-    size_t               value_len      = 0;
-    size_t               align_or_flags = 0;
-    void*                addr           = nullptr;
-    offset_t             begin_pos      = 0;
-    int                  find_type      = 0;
-    uint32_t             max_comp       = 0;
-    uint64_t             options        = 0;
-    common::epoch_time_t t_begin = 0, t_end = 0;
-    component::IKVStore::pool_iterator_t iterator   = nullptr;
-    component::IKVStore::key_t           key_handle = nullptr;
-    Buffer_header*                       buffer;
+    Buffer_header* buffer;
 
     /* process callbacks from ADO */
     while (ado->recv_callback_buffer(buffer) == S_OK) {
-      /*-------------------------*/
-      /* handle TABLE OPERATIONS */
-      /*-------------------------*/
-      if (ado->check_table_ops(buffer, work_id, op, key, value_len, align_or_flags, addr)) {
-        switch (op) {
-        case ADO_op::CREATE: {
-          std::vector<uint64_t> val;
-
-          status_t s = _i_kvstore->get_attribute(ado->pool_id(), IKVStore::VALUE_LEN, val, &key);
-
-          if (s != IKVStore::E_KEY_NOT_FOUND) {
-            if (debug_level() > 3)
-              PWRN("Shard_ado: table op CREATE, key-value pair already "
-                   "exists");
-
-            if (align_or_flags & IKVStore::FLAGS_CREATE_ONLY) {
-              ado->send_table_op_response(E_ALREADY_EXISTS, nullptr, 0, nullptr);
-              break;
-            }
-          }
+      process_ado_callback(ado, handler, buffer);
 
-          goto open; /* stop compiler complaining about flow through*/
-        }
-        case ADO_op::OPEN:
-          open : {
-            CPLOG(2, "Shard_ado: received table op key create/open (%s, value_len=%lu)",
-                  key.c_str(), value_len);
+      /* release buffer */
+      ado->free_callback_buffer(buffer);
+    }
+  }
+}
 
-            IKVStore::key_t key_handle;
-            void*           value = nullptr;
-            const char*     key_ptr;
+/**
+ * Handle one callback request from an ADO: a table, index, vector,
+ * iterate, unlock or configure request, or an op event response. The
+ * response, if any, is sent back through the proxy.
+ *
+ */
+void Shard::process_ado_callback(component::IADO_proxy* ado, Connection_handler* handler, const void* buffer)
+{
+  using namespace component;
 
-            bool invoke_completion_unlock = !(align_or_flags & IADO_plugin::FLAGS_ADO_LIFETIME_UNLOCK);
+  uint64_t             work_id = 0; /* maps to record of pool, key handle, lock type, request id etc. */
+  ADO_op               op      = ADO_op::UNDEFINED;
+  std::string          key, key_expression;
+  size_t               value_len      = 0;
+  size_t               align_or_flags = 0;
+  void*                addr           = nullptr;
+  offset_t             begin_pos      = 0;
+  int                  find_type      = 0;
+  uint32_t             max_comp       = 0;
+  uint64_t             options        = 0;
+  common::epoch_time_t t_begin = 0, t_end = 0;
+  component::IKVStore::pool_iterator_t iterator   = nullptr;
+  component::IKVStore::key_t           key_handle = nullptr;
+
+  /*-------------------------*/
+  /* handle TABLE OPERATIONS */
+  /*-------------------------*/
+  if (ado->check_table_ops(buffer, work_id, op, key, value_len, align_or_flags, addr)) {
+    switch (op) {
+    case ADO_op::CREATE: {
+      std::vector<uint64_t> val;
+
+      status_t s = _i_kvstore->get_attribute(ado->pool_id(), IKVStore::VALUE_LEN, val, &key);
+
+      if (s != IKVStore::E_KEY_NOT_FOUND) {
+        if (debug_level() > 3)
+          PWRN("Shard_ado: table op CREATE, key-value pair already "
+               "exists");
+
+        if (align_or_flags & IKVStore::FLAGS_CREATE_ONLY) {
+          ado->send_table_op_response(E_ALREADY_EXISTS, nullptr, 0, nullptr);
+          break;
+        }
+      }
 
-            status_t rc = _i_kvstore->lock(ado->pool_id(), key, IKVStore::STORE_LOCK_WRITE, value, value_len,
-                                           key_handle, &key_ptr);
+      goto open; /* stop compiler complaining about flow through*/
+    }
+    case ADO_op::OPEN:
+      open : {
+        CPLOG(2, "Shard_ado: received table op key create/open (%s, value_len=%lu)",
+              key.c_str(), value_len);
 
-            if (rc < S_OK || key_handle == nullptr) { /* to fix, store should return error code */
-              CPLOG(2, "Shard_ado: lock on key (%s, value_len=%lu) failed rc=%d", key.c_str(), value_len, rc);
+        IKVStore::key_t key_handle;
+        void*           value = nullptr;
+        const char*     key_ptr;
 
-              ado->send_table_op_response(rc);
-            }
-            else {
-              CPLOG(2, "Shard_ado: locked KV pair (keyhandle=%p, value=%p,len=%lu) invoke_completion_unlock=%d",
-                    static_cast<void*>(key_handle), value, value_len, invoke_completion_unlock);
+        bool invoke_completion_unlock = !(align_or_flags & IADO_plugin::FLAGS_ADO_LIFETIME_UNLOCK);
 
-              add_index_key(ado->pool_id(), key);
+        status_t rc = _i_kvstore->lock(ado->pool_id(), key, IKVStore::STORE_LOCK_WRITE, value, value_len,
+                                       key_handle, &key_ptr);
 
-              /* auto-unlock means we add a deferred unlock that happens after
-                 the ado invocation (identified by work_id) has completed. */
-              if (align_or_flags & IADO_plugin::FLAGS_NO_IMPLICIT_UNLOCK) {
-                CPLOG(2, "Shard_ado: locked (%s) without implicit unlock", key.c_str());
-              }
-              else if (invoke_completion_unlock) { /* unlock on ADO invoke
-                                                      completion */
-                if (work_id == 0) {
-                  ado->send_table_op_response(E_INVAL);
-                }
-                else {
-                  try {
-                    ado->add_deferred_unlock(work_id, key_handle);
-                  }
-                  catch (const std::range_error&) {
-                    PWRN("Shard_ado: too many locks");
-                    ado->send_table_op_response(E_MAX_REACHED);
-                  }
-                }
-              }
-              else { /* unlock at ADO process shutdown */
-                ado->add_life_unlock(key_handle);
-              }
+        if (rc < S_OK || key_handle == nullptr) { /* to fix, store should return error code */
+          CPLOG(2, "Shard_ado: lock on key (%s, value_len=%lu) failed rc=%d", key.c_str(), value_len, rc);
 
-              assert(reinterpret_cast<uint64_t>(addr) <= 1);
-
-              ado->send_table_op_response(S_OK, static_cast<void*>(value), value_len, key_ptr, key_handle);
-            }
-          } break;
-        case ADO_op::ERASE: {
-          CPLOG(2, "Shard_ado: received table op erase");
-          ado->send_table_op_response(_i_kvstore->erase(ado->pool_id(), key));
-          break;
+          ado->send_table_op_response(rc);
         }
-        case ADO_op::VALUE_RESIZE: /* resize only allowed on current work
-                                      invocation target */
-          {
-            CPLOG(2, "Shard_ado: received table op resize value (work_id=%p)", reinterpret_cast<const void*>(work_id));
+        else {
+          CPLOG(2, "Shard_ado: locked KV pair (keyhandle=%p, value=%p,len=%lu) invoke_completion_unlock=%d",
+                static_cast<void*>(key_handle), value, value_len, invoke_completion_unlock);
 
-            /* for resize, we need unlock, resize, and then relock */
-            auto work_item = _outstanding_work.find(work_id);
+          add_index_key(ado->pool_id(), key);
 
-            if (work_item == _outstanding_work.end()) {
+          /* auto-unlock means we add a deferred unlock that happens after
+             the ado invocation (identified by work_id) has completed. */
+          if (align_or_flags & IADO_plugin::FLAGS_NO_IMPLICIT_UNLOCK) {
+            CPLOG(2, "Shard_ado: locked (%s) without implicit unlock", key.c_str());
+          }
+          else if (invoke_completion_unlock) { /* unlock on ADO invoke
+                                                  completion */
+            if (work_id == 0) {
               ado->send_table_op_response(E_INVAL);
-              break;
-            }
-
-            /* use the work id to get the key handle */
-            work_request_t* wr      = request_key_to_record(work_id);
-            const char*     key_ptr = nullptr;
-            status_t        rc;
-
-            if (!wr) throw Logic_exception("unable to get request from work_id");
-
-            if ((rc = _i_kvstore->unlock(ado->pool_id(), wr->key_handle)) != S_OK) {
-              ado->send_table_op_response(rc);
-              break;
             }
-
-            CPLOG(2, "Shard_ado: table op resize, unlocked");
-
-            /* perform resize */
-            void*  new_value      = nullptr;
-            size_t new_value_len  = 0;
-            auto   old_key_handle = wr->key_handle;
-            rc                    = _i_kvstore->resize_value(ado->pool_id(), key, value_len, align_or_flags);
-
-            if (_i_kvstore->lock(ado->pool_id(), key, IKVStore::STORE_LOCK_WRITE, new_value, new_value_len,
-                                 wr->key_handle /* update key handle in record */, &key_ptr) != S_OK)
-              throw Logic_exception("ADO OP_RESIZE request failed to relock");
-
-            /* update deferred locks */
-            if (ado->update_deferred_unlock(work_id, wr->key_handle) != S_OK) {
-              if (ado->remove_life_unlock(old_key_handle) == S_OK) ado->add_life_unlock(wr->key_handle);
+            else {
+              try {
+                ado->add_deferred_unlock(work_id, key_handle);
+              }
+              catch (const std::range_error&) {
+                PWRN("Shard_ado: too many locks");
+                ado->send_table_op_response(E_MAX_REACHED);
+              }
             }
-
-            ado->send_table_op_response(rc, new_value, new_value_len, key_ptr);
-            break;
           }
-        case ADO_op::ALLOCATE_POOL_MEMORY: {
+          else { /* unlock at ADO process shutdown */
+            ado->add_life_unlock(key_handle);
+          }
 
-          status_t rc;
-          assert(work_id == 0); /* work request is not needed */
+          assert(reinterpret_cast<uint64_t>(addr) <= 1);
 
-          CPLOG(2, "Shard_ado: calling allocate_pool_memory align_or_flags=%lu size=%lu",
-                align_or_flags, value_len);
+          ado->send_table_op_response(S_OK, static_cast<void*>(value), value_len, key_ptr, key_handle);
+        }
+      } break;
+    case ADO_op::ERASE: {
+      CPLOG(2, "Shard_ado: received table op erase");
+      ado->send_table_op_response(_i_kvstore->erase(ado->pool_id(), key));
+      break;
+    }
+    case ADO_op::VALUE_RESIZE: /* resize only allowed on current work
+                                  invocation target */
+      {
+        CPLOG(2, "Shard_ado: received table op resize value (work_id=%p)", reinterpret_cast<const void*>(work_id));
 
-          /* provide memory PM and DRAM summary */
-          if (debug_level() > 0)
-          {
-            uint64_t     expected_obj_count = 0;
-            size_t       pool_size          = 0;
-            unsigned int pool_flags         = 0;
-
-            assert(handler);
-            handler->pool_manager().get_pool_info(ado->pool_id(), expected_obj_count, pool_size, pool_flags);
-
-            std::vector<uint64_t> pu_attr;
-            if(_i_kvstore->get_attribute(ado->pool_id(),
-                                         IKVStore::Attribute::PERCENT_USED, pu_attr) == S_OK) {
-              PLOG("Shard_ado: port(%u) '#memory' pool (%s) memory %lu%% used (%luMiB/%luMiB)",
-                   _port,
-                   ado->pool_name().c_str(),
-                   pu_attr[0],
-                   REDUCE_MB(pu_attr[0] == 0 ? 0 : pu_attr[0] * pool_size / 100),
-                   REDUCE_MB(pool_size));
-            }
+        /* for resize, we need unlock, resize, and then relock */
+        auto work_item = _outstanding_work.find(work_id);
 
-            PLOG("Shard_ado: port(%u) '#memory' %s", _port, common::get_DRAM_usage().c_str());
-          }
+        if (work_item == _outstanding_work.end()) {
+          ado->send_table_op_response(E_INVAL);
+          break;
+        }
 
-          void* out_addr = nullptr;
-          rc             = _i_kvstore->allocate_pool_memory(ado->pool_id(), value_len, align_or_flags, out_addr);
+        /* use the work id to get the key handle */
+        work_request_t* wr      = request_key_to_record(work_id);
+        const char*     key_ptr = nullptr;
+        status_t        rc;
 
-          CPLOG(2, "Shard ado: allocated memory at %p from pool_id (%lx)", out_addr, ado->pool_id());
-          CPLOG(2, "Shard_ado: allocate_pool_memory align_or_flags=%lu rc=%d addr=%p",
-                align_or_flags, rc, out_addr);
+        if (!wr) throw Logic_exception("unable to get request from work_id");
 
-          ado->send_table_op_response(rc, out_addr);
+        if ((rc = _i_kvstore->unlock(ado->pool_id(), wr->key_handle)) != S_OK) {
+          ado->send_table_op_response(rc);
           break;
         }
-        case ADO_op::FREE_POOL_MEMORY: {
-          assert(work_id == 0); /* work request is not needed */
 
-          if (value_len == 0) {
-            ado->send_table_op_response(E_INVAL);
-            break;
-          }
+        CPLOG(2, "Shard_ado: table op resize, unlocked");
 
-          status_t rc = _i_kvstore->free_pool_memory(ado->pool_id(), addr, value_len);
-          CPLOG(2, "Shard_ado : allocate_pool_memory free rc=%d", rc);
+        /* perform resize */
+        void*  new_value      = nullptr;
+        size_t new_value_len  = 0;
+        auto   old_key_handle = wr->key_handle;
+        rc                    = _i_kvstore->resize_value(ado->pool_id(), key, value_len, align_or_flags);
 
-          if (rc != S_OK) PWRN("Shard_ado: Table operation OP_FREE failed");
+        if (_i_kvstore->lock(ado->pool_id(), key, IKVStore::STORE_LOCK_WRITE, new_value, new_value_len,
+                             wr->key_handle /* update key handle in record */, &key_ptr) != S_OK)
+          throw Logic_exception("ADO OP_RESIZE request failed to relock");
 
-          ado->send_table_op_response(rc);
-          break;
-        }
-        default:
-          throw Logic_exception("unknown table op code");
+        /* update deferred locks */
+        if (ado->update_deferred_unlock(work_id, wr->key_handle) != S_OK) {
+          if (ado->remove_life_unlock(old_key_handle) == S_OK) ado->add_life_unlock(wr->key_handle);
         }
-        // end of if(check_table_ops..
+
+        ado->send_table_op_response(rc, new_value, new_value_len, key_ptr);
+        break;
       }
-      /*--------------------------*/
-      /* handle POOL INFO request */
-      /*--------------------------*/
-      else if (ado->check_pool_info_op(buffer)) {
-        using namespace rapidjson;
+    case ADO_op::ALLOCATE_POOL_MEMORY: {
+
+      status_t rc;
+      assert(work_id == 0); /* work request is not needed */
 
+      CPLOG(2, "Shard_ado: calling allocate_pool_memory align_or_flags=%lu size=%lu",
+            align_or_flags, value_len);
+
+      /* provide memory PM and DRAM summary */
+      if (debug_level() > 0)
+      {
         uint64_t     expected_obj_count = 0;
         size_t       pool_size          = 0;
         unsigned int pool_flags         = 0;
@@ -848,220 +847,274 @@ void Shard::process_messages_from_ado()
         assert(handler);
         handler->pool_manager().get_pool_info(ado->pool_id(), expected_obj_count, pool_size, pool_flags);
 
-        std::vector<uint64_t> mt_attr;
-        if (_i_kvstore->get_attribute(ado->pool_id(), IKVStore::Attribute::MEMORY_TYPE, mt_attr) != S_OK)
-          throw Logic_exception("get_attributes failed on storage engine (Attribute::MEMORY_TYPE)");
-
         std::vector<uint64_t> pu_attr;
-        bool pu_valid = (_i_kvstore->get_attribute(ado->pool_id(), IKVStore::Attribute::PERCENT_USED, pu_attr) == S_OK);
-
-        try {
-          Document doc;
-          doc.SetObject();
+        if(_i_kvstore->get_attribute(ado->pool_id(),
+                                     IKVStore::Attribute::PERCENT_USED, pu_attr) == S_OK) {
+          PLOG("Shard_ado: port(%u) '#memory' pool (%s) memory %lu%% used (%luMiB/%luMiB)",
+               _port,
+               ado->pool_name().c_str(),
+               pu_attr[0],
+               REDUCE_MB(pu_attr[0] == 0 ? 0 : pu_attr[0] * pool_size / 100),
+               REDUCE_MB(pool_size));
+        }
 
-          Value pool_size_v(pool_size);
-          doc.AddMember("pool_size", pool_size_v, doc.GetAllocator());
-          Value memory_type(mt_attr[0]);
-          doc.AddMember("memory_type", memory_type, doc.GetAllocator());
+        PLOG("Shard_ado: port(%u) '#memory' %s", _port, common::get_DRAM_usage().c_str());
+      }
 
-          if(pu_valid) {
-            Value percent_used(pu_attr[0]);
-            doc.AddMember("percent_used", percent_used, doc.GetAllocator());
-          }
+      void* out_addr = nullptr;
+      rc             = _i_kvstore->allocate_pool_memory(ado->pool_id(), value_len, align_or_flags, out_addr);
 
-          Value expected_obj_count_v(expected_obj_count);
-          doc.AddMember("expected_obj_count", expected_obj_count_v, doc.GetAllocator());
-          Value pool_flags_v(pool_flags);
-          doc.AddMember("pool_flags", pool_flags_v, doc.GetAllocator());
-          std::vector<uint64_t> v64;
-          if (_i_kvstore->get_attribute(ado->pool_id(), IKVStore::Attribute::COUNT, v64) == S_OK) {
-            Value obj_count_v(v64[0]);
-            doc.AddMember("current_object_count", obj_count_v, doc.GetAllocator());
-          }
-          std::stringstream      ss;
-          OStreamWrapper         osw(ss);
-          Writer<OStreamWrapper> writer(osw);
-          doc.Accept(writer);
-          ado->send_pool_info_response(S_OK, ss.str());
-        }
-        catch (...) {
-          throw Logic_exception("pool info JSON creation failed");
-        }
-      }
-      else if (ado->check_op_event_response(buffer, op)) {
-        switch (op) {
-        case ADO_op::POOL_DELETE: {
-          /* close pool, then delete */
-          if ((_i_kvstore->close_pool(ado->pool_id()) != S_OK) || (_i_kvstore->delete_pool(ado->pool_name()) != S_OK))
-            throw Logic_exception("unable to delete pool after POOL DELETE op event");
+      CPLOG(2, "Shard ado: allocated memory at %p from pool_id (%lx)", out_addr, ado->pool_id());
+      CPLOG(2, "Shard_ado: allocate_pool_memory align_or_flags=%lu rc=%d addr=%p",
+            align_or_flags, rc, out_addr);
 
-          CPLOG(2, "POOL DELETE op event completion");
+      ado->send_table_op_response(rc, out_addr);
+      break;
+    }
+    case ADO_op::FREE_POOL_MEMORY: {
+      assert(work_id == 0); /* work request is not needed */
 
-          break;
-        }
-        case ADO_op::CLOSE: {
-          PWRN("ignoring CLOSE from ADO");
-          break;
-        }
-        default:
-          throw Logic_exception("unknown op event (%d)", op);
-        }
+      if (value_len == 0) {
+        ado->send_table_op_response(E_INVAL);
+        break;
       }
-      else if (ado->check_iterate(buffer, t_begin, t_end, iterator)) {
-        component::IKVStore::pool_reference_t ref;
-        if (!iterator) {
-          iterator = _i_kvstore->open_pool_iterator(ado->pool_id());
-        }
 
-        if (!iterator) { /* still no iterator, component doesn't support */
-          ado->send_iterate_response(E_NOT_IMPL, iterator, ref);
-        }
-        else {
-          status_t rc;
-          bool     time_match = false;
-          do {
-            rc = _i_kvstore->deref_pool_iterator(ado->pool_id(), iterator, t_begin, /* time constraints */
-                                                 t_end, ref, time_match, true);
-
-            if (rc == E_OUT_OF_BOUNDS) {
-              _i_kvstore->close_pool_iterator(ado->pool_id(), iterator);
-              break;
-            }
-          } while (!time_match && rc != E_INVAL); /* TODO: limit number of iterations */
-          if (rc == E_INVAL) PWRN("Shard_ado: deref_pool_iterator returned E_INVAL");
+      status_t rc = _i_kvstore->free_pool_memory(ado->pool_id(), addr, value_len);
+      CPLOG(2, "Shard_ado : allocate_pool_memory free rc=%d", rc);
 
-          CPLOG(2, "Shard_ado: iterator timestamp (%lu seconds)", ref.timestamp.seconds());
+      if (rc != S_OK) PWRN("Shard_ado: Table operation OP_FREE failed");
 
-          ado->send_iterate_response(rc, iterator, ref);
-        }
+      ado->send_table_op_response(rc);
+      break;
+    }
+    default:
+      throw Logic_exception("unknown table op code");
+    }
+    // end of if(check_table_ops..
+  }
+  /*--------------------------*/
+  /* handle POOL INFO request */
+  /*--------------------------*/
+  else if (ado->check_pool_info_op(buffer)) {
+    using namespace rapidjson;
+
+    uint64_t     expected_obj_count = 0;
+    size_t       pool_size          = 0;
+    unsigned int pool_flags         = 0;
+
+    assert(handler);
+    handler->pool_manager().get_pool_info(ado->pool_id(), expected_obj_count, pool_size, pool_flags);
+
+    std::vector<uint64_t> mt_attr;
+    if (_i_kvstore->get_attribute(ado->pool_id(), IKVStore::Attribute::MEMORY_TYPE, mt_attr) != S_OK)
+      throw Logic_exception("get_attributes failed on storage engine (Attribute::MEMORY_TYPE)");
+
+    std::vector<uint64_t> pu_attr;
+    bool pu_valid = (_i_kvstore->get_attribute(ado->pool_id(), IKVStore::Attribute::PERCENT_USED, pu_attr) == S_OK);
+
+    try {
+      Document doc;
+      doc.SetObject();
+
+      Value pool_size_v(pool_size);
+      doc.AddMember("pool_size", pool_size_v, doc.GetAllocator());
+      Value memory_type(mt_attr[0]);
+      doc.AddMember("memory_type", memory_type, doc.GetAllocator());
+
+      if(pu_valid) {
+        Value percent_used(pu_attr[0]);
+        doc.AddMember("percent_used", percent_used, doc.GetAllocator());
       }
-      else if (ado->check_vector_ops(buffer, t_begin, t_end)) {
-        /* WARNING: this could block the shard thread. we may
-           neeed to make it a "task" - but we can't do this
-           without a map iterator that can be restarted.
-        */
-        /* vector operation, collect all key-value pointers */
-        status_t                      rc;
-        size_t                        count  = 0;
-        void*                         buffer = nullptr;
-        IADO_plugin::Reference_vector v;
-
-        /* allocate memory from pool for the vector */
-        if (t_begin.is_defined() || t_end.is_defined()) {
-          /* we have to map first to get count */
-          rc = _i_kvstore->map(
-                               ado->pool_id(),
-                               [&count](const void*, const size_t, const void*, const size_t, const common::tsc_time_t) -> int {
-                                 count++;
-                                 return 0;
-                               },
-                               t_begin, t_end);
-          CPLOG(2, "map time constraints: count=%lu", count);
-        }
-        else {
-          count = _i_kvstore->count(ado->pool_id());
-        }
 
-        auto buffer_size = IADO_plugin::Reference_vector::size_required(count);
-        rc               = _i_kvstore->allocate_pool_memory(ado->pool_id(), buffer_size, 0, buffer);
-
-        if (rc != S_OK) {
-          ado->send_vector_response(rc, IADO_plugin::Reference_vector());
-        }
-        else {
-          /* populate vector */
-          IADO_plugin::kv_reference_t* ptr   = static_cast<IADO_plugin::kv_reference_t*>(buffer);
-          size_t                       check = 0;
-
-          if (t_begin.is_defined() && t_end.is_defined()) {
-            rc = _i_kvstore->map(ado->pool_id(),
-                                 [count, &check, &ptr](const void* key, const size_t key_len, const void* value,
-                                                       const size_t value_len) -> int {
-                                   assert(key);
-                                   assert(key_len);
-                                   assert(value);
-                                   assert(value_len);
-                                   if (check > count) return -1;
-                                   ptr->key       = const_cast<void*>(key);
-                                   ptr->key_len   = key_len;
-                                   ptr->value     = const_cast<void*>(value);
-                                   ptr->value_len = value_len;
-                                   ptr++;
-                                   check++;
-                                   return 0;
-                                 });
-          }
-          else {
-            rc = _i_kvstore->map(
-                                 ado->pool_id(),
-                                 [count, &check, &ptr](const void* key, const size_t key_len, const void* value, const size_t value_len,
-                                                       const common::tsc_time_t  // timestamp
-                                                       ) -> int {
-                                   assert(key);
-                                   assert(key_len);
-                                   assert(value);
-                                   assert(value_len);
-                                   if (check > count) return -1;
-                                   ptr->key       = const_cast<void*>(key);
-                                   ptr->key_len   = key_len;
-                                   ptr->value     = const_cast<void*>(value);
-                                   ptr->value_len = value_len;
-                                   ptr++;
-                                   check++;
-                                   return 0;
-                                 },
-                                 t_begin, t_end);
-          }
-
-          ado->send_vector_response(rc, IADO_plugin::Reference_vector(count, buffer, buffer_size));
-        }
+      Value expected_obj_count_v(expected_obj_count);
+      doc.AddMember("expected_obj_count", expected_obj_count_v, doc.GetAllocator());
+      Value pool_flags_v(pool_flags);
+      doc.AddMember("pool_flags", pool_flags_v, doc.GetAllocator());
+      std::vector<uint64_t> v64;
+      if (_i_kvstore->get_attribute(ado->pool_id(), IKVStore::Attribute::COUNT, v64) == S_OK) {
+        Value obj_count_v(v64[0]);
+        doc.AddMember("current_object_count", obj_count_v, doc.GetAllocator());
       }
-      else if (ado->check_index_ops(buffer, key_expression, begin_pos, find_type, max_comp)) {
-        status_t rc;
-        auto     i_kvindex = lookup_index(ado->pool_id());
+      std::stringstream      ss;
+      OStreamWrapper         osw(ss);
+      Writer<OStreamWrapper> writer(osw);
+      doc.Accept(writer);
+      ado->send_pool_info_response(S_OK, ss.str());
+    }
+    catch (...) {
+      throw Logic_exception("pool info JSON creation failed");
+    }
+  }
+  else if (ado->check_op_event_response(buffer, op)) {
+    switch (op) {
+    case ADO_op::POOL_DELETE: {
+      /* close pool, then delete */
+      if ((_i_kvstore->close_pool(ado->pool_id()) != S_OK) || (_i_kvstore->delete_pool(ado->pool_name()) != S_OK))
+        throw Logic_exception("unable to delete pool after POOL DELETE op event");
 
-        if (!i_kvindex) {
-          PWRN("ADO index operation: no index enabled");
-          ado->send_find_index_response(E_NO_INDEX, 0, "noindex");
-        }
-        else {
-          std::string matched_key;
-          offset_t    matched_pos = offset_t(-1);
+      CPLOG(2, "POOL DELETE op event completion");
 
-          rc = i_kvindex->find(key_expression, begin_pos, IKVIndex::convert_find_type(find_type), matched_pos,
-                               matched_key, MAX_INDEX_COMPARISONS);
+      break;
+    }
+    case ADO_op::CLOSE: {
+      PWRN("ignoring CLOSE from ADO");
+      break;
+    }
+    default:
+      throw Logic_exception("unknown op event (%d)", op);
+    }
+  }
+  else if (ado->check_iterate(buffer, t_begin, t_end, iterator)) {
+    component::IKVStore::pool_reference_t ref;
+    if (!iterator) {
+      iterator = _i_kvstore->open_pool_iterator(ado->pool_id());
+    }
 
-          ado->send_find_index_response(rc, matched_pos, matched_key);
+    if (!iterator) { /* still no iterator, component doesn't support */
+      ado->send_iterate_response(E_NOT_IMPL, iterator, ref);
+    }
+    else {
+      status_t rc;
+      bool     time_match = false;
+      do {
+        rc = _i_kvstore->deref_pool_iterator(ado->pool_id(), iterator, t_begin, /* time constraints */
+                                             t_end, ref, time_match, true);
+
+        if (rc == E_OUT_OF_BOUNDS) {
+          _i_kvstore->close_pool_iterator(ado->pool_id(), iterator);
+          break;
         }
-      }
-      else if (ado->check_unlock_request(buffer, work_id, key_handle)) {
+      } while (!time_match && rc != E_INVAL); /* TODO: limit number of iterations */
+      if (rc == E_INVAL) PWRN("Shard_ado: deref_pool_iterator returned E_INVAL");
 
-        CPLOG(2, "ADO callback: unlock request (work_id=%lx, handle=%p", work_id, static_cast<const void*>(key_handle));
+      CPLOG(2, "Shard_ado: iterator timestamp (%lu seconds)", ref.timestamp.seconds());
 
-        /* unlock should fail if implicit unlock exists, i.e.  it
-           should only be performed on locks taken via
-           FLAGS_NO_IMPLICIT_UNLOCK */
-        if (key_handle == nullptr || ado->check_for_implicit_unlock(work_id, key_handle)) {
-          ado->send_unlock_response(E_INVAL);
-        }
-        else {
-          ado->send_unlock_response(_i_kvstore->unlock(ado->pool_id(), key_handle));
-        }
-      }
-      else if (ado->check_configure_request(buffer, options)) {
-        /* ADO can change reference count on ADO process from shard */
-        if (options & IADO_plugin::CONFIG_SHARD_INC_REF) ado->add_ref();
-        if (options & IADO_plugin::CONFIG_SHARD_DEC_REF) ado->release_ref();
+      ado->send_iterate_response(rc, iterator, ref);
+    }
+  }
+  else if (ado->check_vector_ops(buffer, t_begin, t_end)) {
+    /* WARNING: this could block the shard thread. we may
+       neeed to make it a "task" - but we can't do this
+       without a map iterator that can be restarted.
+    */
+    /* vector operation, collect all key-value pointers */
+    status_t                      rc;
+    size_t                        count  = 0;
+    void*                         buffer = nullptr;
+    IADO_plugin::Reference_vector v;
+
+    /* allocate memory from pool for the vector */
+    if (!(t_begin.is_defined() && t_end.is_defined())) {
+      /* time constrained: we have to map first to get count (cheap if
+         the pool has a time index) */
+      rc = _i_kvstore->map(
+                           ado->pool_id(),
+                           [&count](const void*, const size_t, const void*, const size_t, const common::tsc_time_t) -> int {
+                             count++;
+                             return 0;
+                           },
+                           t_begin, t_end);
+      CPLOG(2, "map time constraints: count=%lu", count);
+    }
+    else {
+      count = _i_kvstore->count(ado->pool_id());
+    }
+
+    auto buffer_size = IADO_plugin::Reference_vector::size_required(count);
+    rc               = _i_kvstore->allocate_pool_memory(ado->pool_id(), buffer_size, 0, buffer);
 
-        ado->send_configure_response(S_OK);
+    if (rc != S_OK) {
+      ado->send_vector_response(rc, IADO_plugin::Reference_vector());
+    }
+    else {
+      /* populate vector */
+      IADO_plugin::kv_reference_t* ptr   = static_cast<IADO_plugin::kv_reference_t*>(buffer);
+      size_t                       check = 0;
+
+      if (t_begin.is_defined() && t_end.is_defined()) {
+        rc = _i_kvstore->map(ado->pool_id(),
+                             [count, &check, &ptr](const void* key, const size_t key_len, const void* value,
+                                                   const size_t value_len) -> int {
+                               assert(key);
+                               assert(key_len);
+                               assert(value);
+                               assert(value_len);
+                               if (check > count) return -1;
+                               ptr->key       = const_cast<void*>(key);
+                               ptr->key_len   = key_len;
+                               ptr->value     = const_cast<void*>(value);
+                               ptr->value_len = value_len;
+                               ptr++;
+                               check++;
+                               return 0;
+                             });
       }
       else {
-        throw Logic_exception("Shard_ado: bad op request from ADO plugin");
+        rc = _i_kvstore->map(
+                             ado->pool_id(),
+                             [count, &check, &ptr](const void* key, const size_t key_len, const void* value, const size_t value_len,
+                                                   const common::tsc_time_t  // timestamp
+                                                   ) -> int {
+                               assert(key);
+                               assert(key_len);
+                               assert(value);
+                               assert(value_len);
+                               if (check > count) return -1;
+                               ptr->key       = const_cast<void*>(key);
+                               ptr->key_len   = key_len;
+                               ptr->value     = const_cast<void*>(value);
+                               ptr->value_len = value_len;
+                               ptr++;
+                               check++;
+                               return 0;
+                             },
+                             t_begin, t_end);
       }
 
-      /* release buffer */
-      ado->free_callback_buffer(buffer);
+      ado->send_vector_response(rc, IADO_plugin::Reference_vector(count, buffer, buffer_size));
+    }
+  }
+  else if (ado->check_index_ops(buffer, key_expression, begin_pos, find_type, max_comp)) {
+    status_t rc;
+    auto     i_kvindex = lookup_index(ado->pool_id());
+
+    if (!i_kvindex) {
+      PWRN("ADO index operation: no index enabled");
+      ado->send_find_index_response(E_NO_INDEX, 0, "noindex");
     }
+    else {
+      std::string matched_key;
+      offset_t    matched_pos = offset_t(-1);
+
+      rc = i_kvindex->find(key_expression, begin_pos, IKVIndex::convert_find_type(find_type), matched_pos,
+                           matched_key, MAX_INDEX_COMPARISONS);
+
+      ado->send_find_index_response(rc, matched_pos, matched_key);
+    }
+  }
+  else if (ado->check_unlock_request(buffer, work_id, key_handle)) {
+
+    CPLOG(2, "ADO callback: unlock request (work_id=%lx, handle=%p", work_id, static_cast<const void*>(key_handle));
+
+    /* unlock should fail if implicit unlock exists, i.e.  it
+       should only be performed on locks taken via
+       FLAGS_NO_IMPLICIT_UNLOCK */
+    if (key_handle == nullptr || ado->check_for_implicit_unlock(work_id, key_handle)) {
+      ado->send_unlock_response(E_INVAL);
+    }
+    else {
+      ado->send_unlock_response(_i_kvstore->unlock(ado->pool_id(), key_handle));
+    }
+  }
+  else if (ado->check_configure_request(buffer, options)) {
+    /* ADO can change reference count on ADO process from shard */
+    if (options & IADO_plugin::CONFIG_SHARD_INC_REF) ado->add_ref();
+    if (options & IADO_plugin::CONFIG_SHARD_DEC_REF) ado->release_ref();
+
+    ado->send_configure_response(S_OK);
+  }
+  else {
+    throw Logic_exception("Shard_ado: bad op request from ADO plugin");
   }
 }
 
@@ -0,0 +1,278 @@
+/*
+  Copyright [2017-2020] [IBM Corporation]
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+  http://www.apache.org/licenses/LICENSE-2.0
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+#ifndef __MCAS_SHARD_WORKERS_H__
+#define __MCAS_SHARD_WORKERS_H__
+
+#ifdef __cplusplus
+
+#include <common/logging.h>
+#include <common/utils.h> /* cpu_relax */
+
+#include <pthread.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mcas
+{
+/**
+ * Pool of worker threads which execute tasks on behalf of a shard's
+ * network thread. Tasks are submitted to a Strand, normally one per
+ * connection, and a strand's tasks run one at a time, in submission
+ * order. Each worker owns a FIFO of the strands pinned to it, which it
+ * serves in turn; an idle worker steals a whole strand, which is pinned
+ * to the thief from then on. Tasks are submitted and reaped by a single
+ * thread, the shard thread.
+ */
+class Shard_worker_pool : private common::log_source {
+ public:
+  class Task {
+   public:
+    virtual ~Task() {}
+    virtual void execute() noexcept = 0;
+
+    /* set, with release semantics, once execute has returned */
+    bool complete() const { return _complete.load(std::memory_order_acquire); }
+
+   private:
+    friend class Shard_worker_pool;
+    std::atomic<bool> _complete{false};
+  };
+
+  /* An ordered sequence of tasks. It must outlive its tasks. */
+  class Strand {
+   public:
+    Strand() : _lock(), _tasks(), _home(0), _pinned(false), _scheduled(false) {}
+    Strand(const Strand &) = delete;
+    Strand &operator=(const Strand &) = delete;
+
+   private:
+    friend class Shard_worker_pool;
+    std::mutex        _lock;
+    std::deque<Task*> _tasks;
+    unsigned          _home;      /*< worker to which the strand is pinned */
+    bool              _pinned;
+    bool              _scheduled; /*< queued on, or run by, a worker */
+  };
+
+ private:
+  static constexpr unsigned IDLE_SPIN_COUNT = 2000;
+  static constexpr unsigned IDLE_WAIT_MS    = 1;
+
+  struct worker_t {
+    std::mutex          lock{};
+    std::deque<Strand*> strands{};
+    std::thread         thread{};
+  };
+
+ public:
+  Shard_worker_pool(unsigned debug_level, unsigned worker_count, const std::string &name)
+      : common::log_source(debug_level),
+        _workers(),
+        _next(0),
+        _queued(0),
+        _outstanding(0),
+        _sleepers(0),
+        _sleep_lock(),
+        _wakeup(),
+        _exit(false)
+  {
+    for (unsigned i = 0; i != worker_count; ++i) _workers.emplace_back(new worker_t);
+
+    for (unsigned i = 0; i != worker_count; ++i) {
+      _workers[i]->thread = std::thread(&Shard_worker_pool::worker_entry, this, i);
+      /* thread names are limited to 15 characters */
+      auto tname = (name + "-w" + std::to_string(i)).substr(0, 15);
+      pthread_setname_np(_workers[i]->thread.native_handle(), tname.c_str());
+    }
+    CPLOG(1, "Shard_worker_pool: %u workers started", worker_count);
+  }
+
+  Shard_worker_pool(const Shard_worker_pool &) = delete;
+  Shard_worker_pool &operator=(const Shard_worker_pool &) = delete;
+
+  ~Shard_worker_pool()
+  {
+    wait_idle();
+    {
+      std::lock_guard<std::mutex> g(_sleep_lock);
+      _exit = true;
+    }
+    _wakeup.notify_all();
+    for (auto &w : _workers) w->thread.join();
+  }
+
+  inline unsigned size() const { return unsigned(_workers.size()); }
+
+  /**
+   * Queue a task, to run after the tasks previously submitted to the same
+   * strand. The task is marked complete after execution; the caller
+   * retains ownership and must not release it before then.
+   *
+   * @param task Task to execute
+   * @param strand Strand of the task
+   */
+  void submit(Task *task, Strand &strand)
+  {
+    task->_complete.store(false, std::memory_order_relaxed);
+    _outstanding.fetch_add(1);
+
+    worker_t *w = nullptr;
+    {
+      std::lock_guard<std::mutex> g(strand._lock);
+      strand._tasks.push_back(task);
+      if (!strand._scheduled) {
+        if (!strand._pinned) {
+          /* strands are pinned round-robin when first used */
+          strand._home   = unsigned(_next);
+          strand._pinned = true;
+          if (++_next == _workers.size()) _next = 0;
+        }
+        strand._scheduled = true;
+        w = _workers[strand._home].get();
+      }
+    }
+
+    if (w) {
+      {
+        std::lock_guard<std::mutex> g(w->lock);
+        w->strands.push_back(&strand);
+        _queued.fetch_add(1);
+      }
+      if (_sleepers.load() != 0) {
+        std::lock_guard<std::mutex> g(_sleep_lock);
+        _wakeup.notify_one();
+      }
+    }
+  }
+
+  /**
+   * Spin until every submitted task has completed. Used before operations
+   * (configure, shutdown) which must not overlap with task execution.
+   */
+  void wait_idle() const
+  {
+    while (_outstanding.load() != 0) cpu_relax();
+  }
+
+ private:
+  Strand *pop_front(worker_t &w)
+  {
+    std::lock_guard<std::mutex> g(w.lock);
+    if (w.strands.empty()) return nullptr;
+    auto s = w.strands.front();
+    w.strands.pop_front();
+    _queued.fetch_sub(1);
+    return s;
+  }
+
+  Strand *pop_own(unsigned index) { return pop_front(*_workers[index]); }
+
+  /* a queued strand is not being run, so it may move to the thief */
+  Strand *steal(unsigned thief)
+  {
+    for (unsigned i = 1; i != _workers.size(); ++i) {
+      if (auto s = pop_front(*_workers[(thief + i) % _workers.size()])) {
+        std::lock_guard<std::mutex> g(s->_lock);
+        s->_home = thief;
+        return s;
+      }
+    }
+    return nullptr;
+  }
+
+  /* Run the oldest task of a strand, then queue the strand again if it has
+   * more. The task is marked complete only after the last use of the
+   * strand, which its owner may then release.
+   */
+  void run_one(Strand &s)
+  {
+    Task *t;
+    {
+      std::lock_guard<std::mutex> g(s._lock);
+      t = s._tasks.front();
+      s._tasks.pop_front();
+    }
+
+    t->execute();
+
+    worker_t *w = nullptr;
+    {
+      std::lock_guard<std::mutex> g(s._lock);
+      if (s._tasks.empty()) {
+        s._scheduled = false;
+      }
+      else {
+        w = _workers[s._home].get();
+      }
+    }
+    if (w) {
+      std::lock_guard<std::mutex> g(w->lock);
+      w->strands.push_back(&s);
+      _queued.fetch_add(1);
+    }
+
+    t->_complete.store(true, std::memory_order_release);
+    _outstanding.fetch_sub(1);
+  }
+
+  void worker_entry(unsigned index)
+  {
+    unsigned spins = 0;
+
+    while (!_exit) {
+      Strand *s = nullptr;
+      if (_queued.load() != 0) {
+        s = pop_own(index);
+        if (!s) s = steal(index);
+      }
+
+      if (s) {
+        run_one(*s);
+        spins = 0;
+      }
+      else if (++spins < IDLE_SPIN_COUNT) {
+        cpu_relax();
+      }
+      else {
+        std::unique_lock<std::mutex> lk(_sleep_lock);
+        _sleepers.fetch_add(1);
+        _wakeup.wait_for(lk, std::chrono::milliseconds(IDLE_WAIT_MS), [this] { return _exit || _queued.load() != 0; });
+        _sleepers.fetch_sub(1);
+        spins = 0;
+      }
+    }
+  }
+
+  std::vector<std::unique_ptr<worker_t>> _workers;
+  std::size_t                            _next;        /*< round-robin pinning index */
+  std::atomic<std::size_t>               _queued;      /*< strands queued on workers */
+  std::atomic<std::size_t>               _outstanding; /*< tasks submitted but not yet complete */
+  std::atomic<unsigned>                  _sleepers;
+  std::mutex                             _sleep_lock;
+  std::condition_variable                _wakeup;
+  std::atomic<bool>                      _exit;
+};
+
+}  // namespace mcas
+
+#endif
+
+#endif
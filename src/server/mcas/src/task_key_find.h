@@ -4,6 +4,7 @@
 #include <common/logging.h>
 #include <gsl/pointers>
 #include <unistd.h>
+#include <memory>
 #include <string>
 
 #include "task.h"
@@ -22,7 +23,7 @@ class Key_find_task : public Shard_task,
 
  public:
 #pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Weffc++"  // uninitialized _expr, _out_key, _type
+#pragma GCC diagnostic ignored "-Weffc++"  // uninitialized _expr, _out_key, _type, _matcher
   Key_find_task(const std::string& expression,
                 const offset_t offset,
                 Connection_handler* handler,
@@ -55,9 +56,16 @@ class Key_find_task : public Shard_task,
       _type = IKVIndex::FIND_TYPE_PREFIX;
       _expr = expression.substr(7);
     }
+    else if (expression.substr(0, 10) == "substring:") {
+      _type = IKVIndex::FIND_TYPE_SUBSTRING;
+      _expr = expression.substr(10);
+    }
     else
       throw Logic_exception("unhandled expression");
 
+    /* compiled once for all the steps of the search */
+    _matcher = IKVIndex::create_matcher(_type, _expr);
+
   }
 #pragma GCC diagnostic pop
 
@@ -70,7 +78,7 @@ class Key_find_task : public Shard_task,
 
     status_t hr;
     try {
-      hr = _index->find(_expr, _offset, _type, _offset, _out_key, MAX_COMPARES_PER_WORK);
+      hr = _index->find(*_matcher, _offset, _offset, _out_key, MAX_COMPARES_PER_WORK);
 
       if (hr == E_MAX_REACHED) {
         _offset++;
@@ -102,6 +110,7 @@ class Key_find_task : public Shard_task,
   std::string                             _expr;
   std::string                             _out_key;
   component::IKVIndex::find_t             _type;
+  std::unique_ptr<common::Key_matcher>    _matcher;
   offset_t                                _offset;
   component::Itf_ref<component::IKVIndex> _index;
 };
@@ -4,11 +4,15 @@ from configs import config_0
 from shard_protos import shard_proto_dax
 import stores
 import dax
+from os import environ
 
 class hstore_0(config_0):
 	def __init__(self, hstoretype, daxtype, addr, port=None):
-		store_ctor = getattr(stores, hstoretype.replace('-', '_')) # hstore or hstore-cc
+		store_ctor = getattr(stores, hstoretype.replace('-', '_')) # hstore, hstore-cc or hstore-mt
 		h = store_ctor()
+		# worker count of hstore-mt, as varied by mcas-hstore-mt-scaling-0.sh
+		if hstoretype == 'hstore-mt' and 'WORKER_THREADS' in environ:
+			h.merge({"worker_threads": int(environ['WORKER_THREADS'])})
 		if port is not None:
 			h.merge({"port": port})
 		dax_ctor = getattr(dax, daxtype) # devdax or fsdax
@@ -22,4 +26,4 @@ if len(argv) == 5:
 elif len(argv) == 4:
 	print(hstore_0(argv[1], argv[2], argv[3]).json())
 else:
-	print("Usage: %s: {hstore|hstore-cc} {devdax|fadax} address [port]" % argv[0])
+	print("Usage: %s: {hstore|hstore-cc|hstore-mt} {devdax|fadax} address [port]" % argv[0])
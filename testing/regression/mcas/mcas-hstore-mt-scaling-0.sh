@@ -0,0 +1,48 @@
+#!/bin/bash
+export LD_LIBRARY_PATH=$LD_LIBRARY_PATH:`pwd`/dist/lib
+
+DIR="$(cd "$( dirname "${BASH_SOURCE[0]}")" >/dev/null 2>&1 && pwd)"
+. "$DIR/functions.sh"
+
+# Benchmark, not a pass/fail test: put and get IOPS of a single pool
+# served by one shard thread (hstore-cc) and by 1, 2 and 4 shard worker
+# threads (hstore-mt). Worker counts may be overridden: WORKERS="2 8"
+
+DAXTYPE="${DAXTYPE:-$(choose_dax_type)}"
+WORKERS="${WORKERS:-1 2 4}"
+VALUE_LENGTH=8
+
+# parameters for MCAS server and client
+NODE_IP="$(node_ip)"
+DEBUG=${DEBUG:-0}
+
+ELEMENT_COUNT=$(scale_by_transport 2000000)
+STORE_SIZE=$((ELEMENT_COUNT*(8+VALUE_LENGTH)*128/10))
+
+RC=0
+for CONFIG in hstore-cc:0 $(for W in $WORKERS; do echo hstore-mt:$W; done); do
+  STORETYPE=${CONFIG%:*}
+  export WORKER_THREADS=${CONFIG#*:}
+  for TEST in put get; do
+    TESTID="$(basename --suffix .sh -- $0)-$STORETYPE-$WORKER_THREADS-$TEST-$DAXTYPE"
+    DESC="$STORETYPE-w$WORKER_THREADS-8-$VALUE_LENGTH-$TEST-$DAXTYPE"
+
+    DAX_RESET=1 ./dist/bin/mcas --config "$("./dist/testing/hstore-0.py" "$STORETYPE" "$DAXTYPE" "$NODE_IP")" --forced-exit --debug $DEBUG &> test$TESTID-server.log &
+    SERVER_PID=$!
+
+    sleep 3
+
+    CLIENT_LOG="test$TESTID-client.log"
+    ./dist/bin/kvstore-perf --cores "$(clamp_cpu 14)" --src_addr $NODE_IP --server $NODE_IP --test $TEST --component mcas --elements $ELEMENT_COUNT --size $STORE_SIZE --skip_json_reporting --key_length 8 --value_length $VALUE_LENGTH --debug_level $DEBUG &> $CLIENT_LOG &
+    CLIENT_PID=$!
+
+    # arm cleanup
+    trap "kill -9 $SERVER_PID $CLIENT_PID &> /dev/null" EXIT
+
+    wait $CLIENT_PID; CLIENT_RC=$?
+    wait $SERVER_PID; SERVER_RC=$?
+
+    pass_fail_by_code client $CLIENT_RC server $SERVER_RC && pass_by_iops $CLIENT_LOG $TESTID $DESC 0 || RC=1
+  done
+done
+exit $RC
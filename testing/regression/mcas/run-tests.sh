@@ -19,6 +19,8 @@ run_hstore() {
   sleep $DELAY
   $DIR/mcas-hstore-cc-basic-0.sh $1
   sleep $DELAY
+  $DIR/mcas-hstore-mt-basic-0.sh $1
+  sleep $DELAY
   $DIR/mcas-hstore-cc-get_direct-0.sh $1
   sleep $DELAY
   $DIR/mcas-hstore-cc-put_direct-0.sh $1
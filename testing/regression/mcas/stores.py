@@ -12,6 +12,11 @@ class hstore_cc(dm):
     def __init__(self):
         dm.__init__(self, {"default_backend": "hstore-cc"})
 
+class hstore_mt(dm):
+    """ thread-safe hstore backend, requests executed by shard worker threads """
+    def __init__(self, worker_threads=4):
+        dm.__init__(self, {"default_backend": "hstore-mt", "worker_threads": worker_threads})
+
 class mapstore(dm):
     """ mapstore backend (within a shard) """
     def __init__(self):
@@ -20,4 +25,5 @@ class mapstore(dm):
 if __name__ == '__main__':
     print("hstore", hstore().json())
     print("hstore_cc", hstore_cc().json())
+    print("hstore_mt", hstore_mt().json())
     print("mapstore", mapstore().json())